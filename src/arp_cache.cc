@@ -9,7 +9,8 @@ const size_t ARPCache::kMaxEntries = 32;
 
 
 ARPCache::ARPCache()
-    : Fwk::BaseNotifier<ARPCache, ARPCacheNotifiee>("ARPCache") { }
+    : Fwk::BaseNotifier<ARPCache, ARPCacheNotifiee>("ARPCache"),
+      misses_(0) { }
 
 
 ARPCache::Entry::Ptr
@@ -2,6 +2,7 @@
 #define ARP_CACHE_H_JWDQ7ZZK
 
 #include <ctime>
+#include <inttypes.h>
 #include <map>
 
 #include "fwk/locked_interface.h"
@@ -50,9 +51,20 @@ class ARPCache : public Fwk::LockedInterface,
     Type type() const { return type_; }
     void typeIs(Type type) { type_ = type; }
 
+    /* True if the entry was restored from a snapshot after a restart (see
+       Snapshot) and no ARP packet has confirmed the mapping since. */
+    bool stale() const { return stale_; }
+    void staleIs(bool status) { stale_ = status; }
+
+    /* True if a packet has been forwarded using the entry since it was last
+       refreshed (see ARPRefreshDaemon). */
+    bool used() const { return used_; }
+    void usedIs(bool status) { used_ = status; }
+
    protected:
     Entry(const IPv4Addr& ip, const EthernetAddr& eth)
-        : ip_(ip), eth_(eth), t_(time(NULL)), type_(kDynamic) { }
+        : ip_(ip), eth_(eth), t_(time(NULL)), type_(kDynamic),
+          stale_(false), used_(false) { }
 
    private:
     /* Data members */
@@ -60,6 +72,8 @@ class ARPCache : public Fwk::LockedInterface,
     EthernetAddr eth_;
     time_t t_;
     Type type_;
+    bool stale_;
+    bool used_;
 
     /* Disallowed operations */
     Entry(const Entry&);
@@ -78,6 +92,10 @@ class ARPCache : public Fwk::LockedInterface,
 
   size_t entries() const { return addr_map_.size(); }
 
+  /* Number of lookups by the data plane that found no entry. */
+  uint64_t misses() const { return misses_; }
+  void missesInc() { ++misses_; }
+
   Entry::Ptr entry(const IPv4Addr& ip) const;
   void entryIs(Entry::Ptr entry);
   void entryDel(const IPv4Addr& ip);
@@ -94,6 +112,7 @@ class ARPCache : public Fwk::LockedInterface,
  private:
   /* Data members */
   std::map<IPv4Addr,Entry::Ptr> addr_map_;
+  uint64_t misses_;
 
   /* Disallowed operations. */
   ARPCache(const ARPCache&);
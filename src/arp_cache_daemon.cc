@@ -1,6 +1,6 @@
 #include "arp_cache_daemon.h"
 
-#include <vector>
+#include <map>
 
 #include "fwk/log.h"
 #include "fwk/scoped_lock.h"
@@ -9,35 +9,86 @@
 #include "task.h"
 #include "time_types.h"
 
-static const Seconds kTimeoutAge = 30;
+using std::map;
 
-using std::vector;
 
+const time_t ARPCacheDaemon::kTimeoutAge;
 
-ARPCacheDaemon::ARPCacheDaemon(ARPCache::Ptr cache)
-    : PeriodicTask("ARPCacheDaemon"),
+
+ARPCacheDaemon::ARPCacheDaemon(ARPCache::Ptr cache, TimerWheel::Ptr wheel)
+    : Task("ARPCacheDaemon"),
       cache_(cache),
-      log_(Fwk::Log::LogNew("ARPCacheDaemon")) { }
+      wheel_(wheel),
+      cache_reactor_(ARPCacheReactor::New(this)),
+      log_(Fwk::Log::LogNew("ARPCacheDaemon")) {
+  Fwk::ScopedLock<ARPCache> lock(cache_);
+  cache_reactor_->notifierIs(cache_);
 
+  // Entries added before the daemon was created.
+  for (ARPCache::iterator it = cache_->begin(); it != cache_->end(); ++it)
+    timerIs(it->second);
+}
 
-void ARPCacheDaemon::run() {
-  vector<ARPCache::Entry::Ptr> remove;
 
-  // Find old entries to remove.
+ARPCacheDaemon::~ARPCacheDaemon() {
   Fwk::ScopedLock<ARPCache> lock(cache_);
-  for (ARPCache::iterator it = cache_->begin(); it != cache_->end(); ++it) {
-    ARPCache::Entry::Ptr entry = it->second;
+  cache_reactor_->notifierDel(cache_);
 
-    if (entry->type() == ARPCache::Entry::kDynamic &&
-        entry->age() >= kTimeoutAge.value()) {
-      remove.push_back(entry);
-    }
-  }
+  map<IPv4Addr,EntryTimer::Ptr>::iterator it;
+  for (it = timers_.begin(); it != timers_.end(); ++it)
+    wheel_->timerDel(it->second);
+}
+
+
+void ARPCacheDaemon::ARPCacheReactor::onEntry(ARPCache::Ptr cache,
+                                              ARPCache::Entry::Ptr entry) {
+  daemon_->timerIs(entry);
+}
+
+
+void ARPCacheDaemon::ARPCacheReactor::onEntryDel(ARPCache::Ptr cache,
+                                                 ARPCache::Entry::Ptr entry) {
+  daemon_->timerDel(entry);
+}
+
+
+void ARPCacheDaemon::timerIs(ARPCache::Entry::Ptr entry) {
+  if (entry->type() != ARPCache::Entry::kDynamic)
+    return;
+
+  EntryTimer::Ptr& timer = timers_[entry->ipAddr()];
+  if (timer == NULL || timer->entry() != entry)
+    timer = EntryTimer::New(this, entry);
+
+  time_t remaining = kTimeoutAge - entry->age();
+  if (remaining < 0)
+    remaining = 0;
+
+  wheel_->timerIs(timer, wheel_->time().value() + remaining * 1000);
+}
+
+
+void ARPCacheDaemon::timerDel(ARPCache::Entry::Ptr entry) {
+  map<IPv4Addr,EntryTimer::Ptr>::iterator it = timers_.find(entry->ipAddr());
+  if (it == timers_.end() || it->second->entry() != entry)
+    return;
+
+  wheel_->timerDel(it->second);
+  timers_.erase(it);
+}
+
+
+void ARPCacheDaemon::onEntryExpiry(ARPCache::Entry::Ptr entry) {
+  Fwk::ScopedLock<ARPCache> lock(cache_);
+
+  // The entry may have been replaced or removed since the timer fired.
+  if (cache_->entry(entry->ipAddr()) != entry)
+    return;
 
-  // Remove old entries.
-  vector<ARPCache::Entry::Ptr>::iterator it;
-  for (it = remove.begin(); it != remove.end(); ++it) {
-    DLOG << "removing entry for " << (*it)->ipAddr();
-    cache_->entryDel(*it);
+  if (entry->age() >= kTimeoutAge) {
+    DLOG << "removing entry for " << entry->ipAddr();
+    cache_->entryDel(entry);
+  } else {
+    timerIs(entry);
   }
 }
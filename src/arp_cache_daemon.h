@@ -1,27 +1,99 @@
 #ifndef ARP_CACHE_DAEMON_H_
 #define ARP_CACHE_DAEMON_H_
 
+#include <map>
+
 #include "fwk/log.h"
 #include "fwk/ptr.h"
 
 #include "arp_cache.h"
+#include "ipv4_addr.h"
 #include "task.h"
 
 
-class ARPCacheDaemon : public PeriodicTask {
+// Removes dynamic ARP cache entries once they are kTimeoutAge seconds old.
+// Each dynamic entry has its own timer on the timer wheel, armed when the
+// entry is added to the cache and cancelled when it is removed.
+class ARPCacheDaemon : public Task {
  public:
   typedef Fwk::Ptr<const ARPCacheDaemon> PtrConst;
   typedef Fwk::Ptr<ARPCacheDaemon> Ptr;
 
-  static Ptr New(ARPCache::Ptr cache) { return new ARPCacheDaemon(cache); }
+  static Ptr New(ARPCache::Ptr cache, TimerWheel::Ptr wheel) {
+    return new ARPCacheDaemon(cache, wheel);
+  }
+
+  // Age at which dynamic entries are removed, in seconds.
+  static const time_t kTimeoutAge = 30;
 
  protected:
-  ARPCacheDaemon(ARPCache::Ptr cache);
+  class ARPCacheReactor : public ARPCache::Notifiee {
+   public:
+    typedef Fwk::Ptr<const ARPCacheReactor> PtrConst;
+    typedef Fwk::Ptr<ARPCacheReactor> Ptr;
+
+    static Ptr New(ARPCacheDaemon* daemon) {
+      return new ARPCacheReactor(daemon);
+    }
+
+    virtual void onEntry(ARPCache::Ptr cache, ARPCache::Entry::Ptr entry);
+    virtual void onEntryDel(ARPCache::Ptr cache, ARPCache::Entry::Ptr entry);
+
+   protected:
+    ARPCacheReactor(ARPCacheDaemon* daemon) : daemon_(daemon) { }
+
+    ARPCacheDaemon* daemon_;
+  };
+
+  // Expiry timer of a single cache entry.
+  class EntryTimer : public Timer {
+   public:
+    typedef Fwk::Ptr<const EntryTimer> PtrConst;
+    typedef Fwk::Ptr<EntryTimer> Ptr;
+
+    static Ptr New(ARPCacheDaemon* daemon, ARPCache::Entry::Ptr entry) {
+      return new EntryTimer(daemon, entry);
+    }
+
+    ARPCache::Entry::Ptr entry() const { return entry_; }
 
-  void run();
+   protected:
+    EntryTimer(ARPCacheDaemon* daemon, ARPCache::Entry::Ptr entry)
+        : daemon_(daemon), entry_(entry) { }
+
+    void onExpiry() { daemon_->onEntryExpiry(entry_); }
+
+    ARPCacheDaemon* daemon_;
+    ARPCache::Entry::Ptr entry_;
+  };
+
+  ARPCacheDaemon(ARPCache::Ptr cache, TimerWheel::Ptr wheel);
+  ~ARPCacheDaemon();
+
+  // Arms the timer of ENTRY for the time ENTRY has left in the cache. Must
+  // be called with the cache locked.
+  void timerIs(ARPCache::Entry::Ptr entry);
+
+  // Cancels the timer of ENTRY. Must be called with the cache locked.
+  void timerDel(ARPCache::Entry::Ptr entry);
+
+  // Removes ENTRY if it has reached kTimeoutAge. Entries are refreshed
+  // without notification, so younger entries are given a new timer.
+  void onEntryExpiry(ARPCache::Entry::Ptr entry);
 
   ARPCache::Ptr cache_;
+  TimerWheel::Ptr wheel_;
+  ARPCacheReactor::Ptr cache_reactor_;
+
+  // Timers of dynamic entries, by IP address. Protected by the cache lock.
+  std::map<IPv4Addr,EntryTimer::Ptr> timers_;
+
   Fwk::Log::Ptr log_;
+
+ private:
+  // Operations disallowed.
+  ARPCacheDaemon(const ARPCacheDaemon&);
+  void operator=(const ARPCacheDaemon&);
 };
 
 
@@ -1,16 +1,30 @@
 #include "arp_queue.h"
 
+#include "fwk/notifier.h"
+
 /* ARPQueue::Entry */
 
 void
 ARPQueue::Entry::packetIs(EthernetPacket::Ptr packet) {
   PacketWrapper::Ptr wrapper = PacketWrapper::New(packet);
   packet_queue_.pushBack(wrapper);
+  bytes_ += packet->buffer()->size();
 }
 
 
 /* ARPQueue */
 
+const size_t ARPQueue::kMaxEntries;
+const size_t ARPQueue::kMaxEntryPackets;
+const size_t ARPQueue::kMaxEntryBytes;
+const size_t ARPQueue::kMaxPackets;
+const size_t ARPQueue::kMaxBytes;
+
+ARPQueue::ARPQueue()
+    : Fwk::BaseNotifier<ARPQueue, ARPQueueNotifiee>("ARPQueue"),
+      packets_(0), bytes_(0), enqueued_(0), overflows_(0), unresolved_(0) { }
+
+
 ARPQueue::Entry::Ptr
 ARPQueue::entry(const IPv4Addr& ip) const {
   Entry::Ptr entry = NULL;
@@ -23,9 +37,27 @@ ARPQueue::entry(const IPv4Addr& ip) const {
 
 void
 ARPQueue::entryIs(Entry::Ptr entry) {
-  if (entry) {
-    IPv4Addr key = entry->ipAddr();
-    addr_map_[key] = entry;
+  if (entry == NULL)
+    return;
+
+  IPv4Addr key = entry->ipAddr();
+  Entry::Ptr prev = this->entry(key);
+  if (prev == entry)
+    return;
+
+  addr_map_[key] = entry;
+  if (prev) {
+    packets_ -= prev->packets();
+    bytes_ -= prev->bytes();
+  }
+  packets_ += entry->packets();
+  bytes_ += entry->bytes();
+
+  /* Dispatch notifications. */
+  for (unsigned int i = 0; i < notifiees_.size(); ++i) {
+    if (prev)
+      notifiees_[i]->onEntryDel(this, prev);
+    notifiees_[i]->onEntry(this, entry);
   }
 }
 
@@ -40,5 +72,36 @@ ARPQueue::entryDel(Entry::Ptr entry) {
 
 void
 ARPQueue::entryDel(const IPv4Addr& ip) {
-  addr_map_.erase(ip);
+  iterator it = addr_map_.find(ip);
+  if (it == end())
+    return;
+
+  Entry::Ptr entry = it->second;
+  addr_map_.erase(it);
+  packets_ -= entry->packets();
+  bytes_ -= entry->bytes();
+
+  /* Dispatch notification. */
+  for (unsigned int i = 0; i < notifiees_.size(); ++i)
+    notifiees_[i]->onEntryDel(this, entry);
+}
+
+bool
+ARPQueue::packetNew(const IPv4Addr& ip, EthernetPacket::Ptr pkt) {
+  Entry::Ptr entry = this->entry(ip);
+  const size_t bytes = pkt->buffer()->size();
+  if (entry == NULL
+      || entry->packets() + 1 > kMaxEntryPackets
+      || entry->bytes() + bytes > kMaxEntryBytes
+      || packets_ + 1 > kMaxPackets
+      || bytes_ + bytes > kMaxBytes) {
+    ++overflows_;
+    return false;
+  }
+
+  entry->packetIs(pkt);
+  packets_ += 1;
+  bytes_ += bytes;
+  ++enqueued_;
+  return true;
 }
@@ -1,19 +1,36 @@
 #ifndef ARP_QUEUE_H_G44N5TIX
 #define ARP_QUEUE_H_G44N5TIX
 
+#include <inttypes.h>
 #include <map>
 
-#include "fwk/ptr_interface.h"
 #include "fwk/linked_list.h"
+#include "fwk/notifier.h"
+#include "fwk/ptr_interface.h"
 
 #include "ethernet_packet.h"
 #include "ip_packet.h"
 #include "interface.h"
 
-class ARPQueue : public Fwk::PtrInterface<ARPQueue> {
+class ARPQueueNotifiee;
+
+/* Packets waiting for the resolution of their next hop, by next hop. The
+   memory held by queued packets is bounded: packetNew() drops packets that
+   would exceed kMaxEntryPackets or kMaxEntryBytes for their next hop, or
+   kMaxPackets or kMaxBytes in total, and packets to new next hops while
+   kMaxEntries of them are already being resolved. Bytes are those of the
+   buffers holding the packets. */
+class ARPQueue : public Fwk::BaseNotifier<ARPQueue, ARPQueueNotifiee> {
  public:
   typedef Fwk::Ptr<const ARPQueue> PtrConst;
   typedef Fwk::Ptr<ARPQueue> Ptr;
+  typedef ARPQueueNotifiee Notifiee;
+
+  static const size_t kMaxEntries = 256;
+  static const size_t kMaxEntryPackets = 32;
+  static const size_t kMaxEntryBytes = 64 * 1024;
+  static const size_t kMaxPackets = 1024;
+  static const size_t kMaxBytes = 1024 * 1024;
 
   /* Wrapper class that allows Packet objects
    * to be inserted into Fwk::LinkedList */
@@ -60,13 +77,19 @@ class ARPQueue : public Fwk::PtrInterface<ARPQueue> {
     PacketWrapper::Ptr front() { return packet_queue_.front(); }
     PacketWrapper::PtrConst front() const { return packet_queue_.front(); }
 
-    void packetIs(EthernetPacket::Ptr packet);
+    /* Number of packets queued, and bytes they hold. */
+    size_t packets() const { return packet_queue_.size(); }
+    size_t bytes() const { return bytes_; }
 
    protected:
     Entry(const IPv4Addr& ip,
           Interface::PtrConst interface,
           EthernetPacket::PtrConst request)
-        : ip_(ip), interface_(interface), request_(request), retries_(0) { }
+        : ip_(ip), interface_(interface), request_(request), retries_(0),
+          bytes_(0) { }
+
+    /* Queues PACKET, without regard to limits. */
+    void packetIs(EthernetPacket::Ptr packet);
 
    private:
     /* Data members. */
@@ -75,10 +98,13 @@ class ARPQueue : public Fwk::PtrInterface<ARPQueue> {
     EthernetPacket::PtrConst request_;
     unsigned int retries_;
     Fwk::LinkedList<PacketWrapper> packet_queue_;
+    size_t bytes_;
 
     /* Operations disallowed. */
     Entry(const Entry&);
     void operator=(const Entry&);
+
+    friend class ARPQueue;
   };
 
   typedef std::map<IPv4Addr,Entry::Ptr>::iterator iterator;
@@ -93,20 +119,57 @@ class ARPQueue : public Fwk::PtrInterface<ARPQueue> {
   void entryDel(const IPv4Addr& ip);
   void entryDel(Entry::Ptr entry);
 
+  /* Number of next hops being resolved. */
+  size_t entries() const { return addr_map_.size(); }
+
+  /* Number of packets queued for all next hops, and bytes they hold. */
+  size_t packets() const { return packets_; }
+  size_t bytes() const { return bytes_; }
+
+  /* Queues PKT for next hop IP. Returns false, and drops the packet, if
+     there is no entry for IP or if queueing the packet would exceed the
+     limits of the entry or of the queue. */
+  bool packetNew(const IPv4Addr& ip, EthernetPacket::Ptr pkt);
+
+  /* Statistics. */
+
+  /* Packets queued. */
+  uint64_t enqueued() const { return enqueued_; }
+
+  /* Packets dropped by packetNew(). */
+  uint64_t overflows() const { return overflows_; }
+
+  /* Packets dropped because their next hop could not be resolved. */
+  uint64_t unresolved() const { return unresolved_; }
+  void unresolvedInc(size_t packets) { unresolved_ += packets; }
+
   iterator begin() { return addr_map_.begin(); }
   iterator end() { return addr_map_.end(); }
   const_iterator begin() const { return addr_map_.begin(); }
   const_iterator end() const { return addr_map_.end(); }
 
  protected:
-  ARPQueue() {}
+  ARPQueue();
 
   /* Data members. */
   std::map<IPv4Addr,Entry::Ptr> addr_map_;
+  size_t packets_;
+  size_t bytes_;
+  uint64_t enqueued_;
+  uint64_t overflows_;
+  uint64_t unresolved_;
 
   /* Disallowed operations. */
   ARPQueue(const ARPQueue&);
   void operator=(const ARPQueue&);
 };
 
+
+class ARPQueueNotifiee : public Fwk::BaseNotifiee<ARPQueue, ARPQueueNotifiee> {
+ public:
+  virtual void onEntry(ARPQueue::Ptr queue, ARPQueue::Entry::Ptr entry) { }
+  virtual void onEntryDel(ARPQueue::Ptr queue, ARPQueue::Entry::Ptr entry) { }
+};
+
+
 #endif
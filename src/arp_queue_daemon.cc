@@ -1,6 +1,6 @@
 #include "arp_queue_daemon.h"
 
-#include <vector>
+#include <map>
 
 #include "arp_queue.h"
 #include "control_plane.h"
@@ -10,56 +10,109 @@
 #include "task.h"
 #include "time_types.h"
 
-static const unsigned int kMaxRetries = 4;
+using std::map;
 
-using std::vector;
 
+const unsigned int ARPQueueDaemon::kMaxRetries;
+const int ARPQueueDaemon::kInitialRetryInterval;
+const int ARPQueueDaemon::kMaxRetryInterval;
 
-ARPQueueDaemon::ARPQueueDaemon(ControlPlane::Ptr cp)
-    : PeriodicTask("ARPQueueDaemon"),
+
+ARPQueueDaemon::ARPQueueDaemon(ControlPlane::Ptr cp, TimerWheel::Ptr wheel)
+    : Task("ARPQueueDaemon"),
       cp_(cp),
-      log_(Fwk::Log::LogNew("ARPQueueDaemon")) { }
+      wheel_(wheel),
+      queue_reactor_(ARPQueueReactor::New(this)),
+      log_(Fwk::Log::LogNew("ARPQueueDaemon")) {
+  ARPQueue::Ptr queue = cp_->arpQueue();
+  queue_reactor_->notifierIs(queue);
+
+  // Entries added before the daemon was created.
+  for (ARPQueue::iterator it = queue->begin(); it != queue->end(); ++it)
+    timerIs(it->second);
+}
+
+
+ARPQueueDaemon::~ARPQueueDaemon() {
+  queue_reactor_->notifierDel(cp_->arpQueue());
+
+  map<IPv4Addr,EntryTimer::Ptr>::iterator it;
+  for (it = timers_.begin(); it != timers_.end(); ++it)
+    wheel_->timerDel(it->second);
+}
+
+
+void ARPQueueDaemon::ARPQueueReactor::onEntry(ARPQueue::Ptr queue,
+                                              ARPQueue::Entry::Ptr entry) {
+  daemon_->timerIs(entry);
+}
+
+
+void ARPQueueDaemon::ARPQueueReactor::onEntryDel(ARPQueue::Ptr queue,
+                                                 ARPQueue::Entry::Ptr entry) {
+  daemon_->timerDel(entry);
+}
+
 
+void ARPQueueDaemon::timerIs(ARPQueue::Entry::Ptr entry) {
+  EntryTimer::Ptr& timer = timers_[entry->ipAddr()];
+  if (timer == NULL || timer->entry() != entry)
+    timer = EntryTimer::New(this, entry);
 
-void ARPQueueDaemon::run() {
+  int interval = kInitialRetryInterval;
+  for (unsigned int i = 0;
+       i < entry->retries() && interval < kMaxRetryInterval; ++i) {
+    interval *= 2;
+  }
+  if (interval > kMaxRetryInterval)
+    interval = kMaxRetryInterval;
+
+  wheel_->timerIs(timer, wheel_->time().value() + interval);
+}
+
+
+void ARPQueueDaemon::timerDel(ARPQueue::Entry::Ptr entry) {
+  map<IPv4Addr,EntryTimer::Ptr>::iterator it = timers_.find(entry->ipAddr());
+  if (it == timers_.end() || it->second->entry() != entry)
+    return;
+
+  wheel_->timerDel(it->second);
+  timers_.erase(it);
+}
+
+
+void ARPQueueDaemon::onEntryExpiry(ARPQueue::Entry::Ptr entry) {
   ARPQueue::Ptr queue = cp_->arpQueue();
   DataPlane::Ptr dp = cp_->dataPlane();
 
-  // Entries to be removed.
-  vector<ARPQueue::Entry::Ptr> remove;
-
-  for (ARPQueue::iterator it = queue->begin(); it != queue->end(); ++it) {
-    ARPQueue::Entry::Ptr entry = it->second;
-    if (entry->retries() >= kMaxRetries) {
-      remove.push_back(entry);
-      continue;
-    }
+  // The entry may have been flushed since the timer fired.
+  if (queue->entry(entry->ipAddr()) != entry)
+    return;
 
+  if (entry->retries() < kMaxRetries) {
     DLOG << "resending ARP request for " << entry->ipAddr();
     dp->outputPacketNew(entry->request(), entry->interface());
 
     entry->retriesInc();
+    timerIs(entry);
+    return;
   }
 
-  // Remove entries that have exceeded the maximum number of retries.
-  vector<ARPQueue::Entry::Ptr>::iterator it;
-  for (it = remove.begin(); it != remove.end(); ++it) {
-    DLOG << "Retry count for ARP queue for " << (*it)->ipAddr() << " exceeded";
-
-    // Send ICMP messages to all packets in queue.
-    ARPQueue::PacketWrapper::Ptr pkt_wrapper = (*it)->front();
-    EthernetPacket::Ptr eth_pkt;
-    while (pkt_wrapper != NULL) {
-      eth_pkt = pkt_wrapper->packet();
-      if (eth_pkt->type() != EthernetPacket::kIP)
-        continue;
-      IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(eth_pkt->payload());
-
-      cp_->sendICMPDestNetworkUnreach(ip_pkt);
-      pkt_wrapper = pkt_wrapper->next();
-    }
-
-    // Remove the ARP queue entry.
-    queue->entryDel(*it);
+  DLOG << "Retry count for ARP queue for " << entry->ipAddr() << " exceeded";
+
+  // Send ICMP messages to all packets in queue. They are subject to the rate
+  // limits of ICMP errors, so a long queue does not turn into a burst.
+  ARPQueue::PacketWrapper::Ptr pkt_wrapper = entry->front();
+  for (; pkt_wrapper != NULL; pkt_wrapper = pkt_wrapper->next()) {
+    EthernetPacket::Ptr eth_pkt = pkt_wrapper->packet();
+    if (eth_pkt->type() != EthernetPacket::kIP)
+      continue;
+    IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(eth_pkt->payload());
+
+    cp_->sendICMPDestHostUnreach(ip_pkt);
   }
+
+  // Remove the ARP queue entry.
+  queue->unresolvedInc(entry->packets());
+  queue->entryDel(entry);
 }
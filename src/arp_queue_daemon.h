@@ -1,28 +1,105 @@
 #ifndef ARP_QUEUE_DAEMON_H_
 #define ARP_QUEUE_DAEMON_H_
 
+#include <map>
+
 #include "fwk/log.h"
 #include "fwk/ptr.h"
 
 #include "arp_queue.h"
 #include "control_plane.h"
+#include "ipv4_addr.h"
 #include "task.h"
 
 
-class ARPQueueDaemon : public PeriodicTask {
+// Resends ARP requests for entries in the ARP queue, and gives up on an entry
+// after kMaxRetries retries. The first retry is sent kInitialRetryInterval
+// milliseconds after the request, and the interval doubles after every retry
+// up to kMaxRetryInterval, so that a lost request is repeated quickly without
+// flooding a host that is down. Each entry has its own retry timer on the
+// timer wheel, armed when the entry is added to the queue and cancelled when
+// it is removed.
+class ARPQueueDaemon : public Task {
  public:
   typedef Fwk::Ptr<const ARPQueueDaemon> PtrConst;
   typedef Fwk::Ptr<ARPQueueDaemon> Ptr;
 
-  static Ptr New(ControlPlane::Ptr cp) { return new ARPQueueDaemon(cp); }
+  static Ptr New(ControlPlane::Ptr cp, TimerWheel::Ptr wheel) {
+    return new ARPQueueDaemon(cp, wheel);
+  }
+
+  static const unsigned int kMaxRetries = 4;
+  static const int kInitialRetryInterval = 100;
+  static const int kMaxRetryInterval = 1000;
 
  protected:
-  ARPQueueDaemon(ControlPlane::Ptr cp);
+  class ARPQueueReactor : public ARPQueue::Notifiee {
+   public:
+    typedef Fwk::Ptr<const ARPQueueReactor> PtrConst;
+    typedef Fwk::Ptr<ARPQueueReactor> Ptr;
+
+    static Ptr New(ARPQueueDaemon* daemon) {
+      return new ARPQueueReactor(daemon);
+    }
+
+    virtual void onEntry(ARPQueue::Ptr queue, ARPQueue::Entry::Ptr entry);
+    virtual void onEntryDel(ARPQueue::Ptr queue, ARPQueue::Entry::Ptr entry);
+
+   protected:
+    ARPQueueReactor(ARPQueueDaemon* daemon) : daemon_(daemon) { }
+
+    ARPQueueDaemon* daemon_;
+  };
+
+  // Retry timer of a single queue entry.
+  class EntryTimer : public Timer {
+   public:
+    typedef Fwk::Ptr<const EntryTimer> PtrConst;
+    typedef Fwk::Ptr<EntryTimer> Ptr;
+
+    static Ptr New(ARPQueueDaemon* daemon, ARPQueue::Entry::Ptr entry) {
+      return new EntryTimer(daemon, entry);
+    }
+
+    ARPQueue::Entry::Ptr entry() const { return entry_; }
 
-  void run();
+   protected:
+    EntryTimer(ARPQueueDaemon* daemon, ARPQueue::Entry::Ptr entry)
+        : daemon_(daemon), entry_(entry) { }
+
+    void onExpiry() { daemon_->onEntryExpiry(entry_); }
+
+    ARPQueueDaemon* daemon_;
+    ARPQueue::Entry::Ptr entry_;
+  };
+
+  ARPQueueDaemon(ControlPlane::Ptr cp, TimerWheel::Ptr wheel);
+  ~ARPQueueDaemon();
+
+  // Arms the retry timer of ENTRY to fire after the retry interval that
+  // follows its retries so far.
+  void timerIs(ARPQueue::Entry::Ptr entry);
+
+  // Cancels the retry timer of ENTRY.
+  void timerDel(ARPQueue::Entry::Ptr entry);
+
+  // Resends the ARP request of ENTRY, or removes ENTRY from the queue if it
+  // has exceeded the maximum number of retries.
+  void onEntryExpiry(ARPQueue::Entry::Ptr entry);
 
   ControlPlane::Ptr cp_;
+  TimerWheel::Ptr wheel_;
+  ARPQueueReactor::Ptr queue_reactor_;
+
+  // Retry timers, by IP address.
+  std::map<IPv4Addr,EntryTimer::Ptr> timers_;
+
   Fwk::Log::Ptr log_;
+
+ private:
+  // Operations disallowed.
+  ARPQueueDaemon(const ARPQueueDaemon&);
+  void operator=(const ARPQueueDaemon&);
 };
 
 
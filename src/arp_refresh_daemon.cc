@@ -0,0 +1,139 @@
+#include "arp_refresh_daemon.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "fwk/log.h"
+#include "fwk/scoped_lock.h"
+
+#include "arp_cache.h"
+#include "control_plane.h"
+#include "interface.h"
+#include "routing_table.h"
+#include "task.h"
+#include "time_types.h"
+#include "tunnel.h"
+#include "tunnel_map.h"
+
+using std::make_pair;
+using std::map;
+using std::pair;
+using std::vector;
+
+
+const time_t ARPRefreshDaemon::kRefreshAge;
+
+
+ARPRefreshDaemon::ARPRefreshDaemon(ControlPlane::Ptr cp)
+    : Task("ARPRefreshDaemon"),
+      cp_(cp),
+      log_(Fwk::Log::LogNew("ARPRefreshDaemon")) { }
+
+
+void ARPRefreshDaemon::timeIs(const TimeEpoch& t) {
+  RoutingTable::Ptr rtable = cp_->routingTable();
+  ARPCache::Ptr cache = cp_->arpCache();
+
+  gateways_.clear();
+  {
+    Fwk::ScopedLock<RoutingTable> lock(rtable);
+    for (RoutingTable::iterator it = rtable->entriesBegin();
+         it != rtable->entriesEnd(); ++it) {
+      RoutingTable::Entry::Ptr entry = it->second;
+      for (size_t i = 0; i < entry->nextHops(); ++i)
+        gatewayNew(entry->nextHop(i));
+      gatewayNew(entry->backupNextHop());
+    }
+  }
+
+  // The data plane sends through tunnels without marking the entries of
+  // their next hops used, so those count as gateways too.
+  {
+    TunnelMap::Ptr tun_map = cp_->tunnelMap();
+    Fwk::ScopedLock<TunnelMap> lock(tun_map);
+    for (TunnelMap::const_iterator it = tun_map->begin();
+         it != tun_map->end(); ++it) {
+      Tunnel::Encap::PtrConst encap = it->second->encap();
+      if (encap)
+        gateways_[encap->nextHop()] = encap->interface();
+    }
+  }
+
+  // Requests are sent once the cache is unlocked; replies are processed by
+  // the control plane, which locks it again.
+  vector<IPv4Addr> unresolved;
+  vector<pair<IPv4Addr,EthernetAddr> > refreshes;
+  {
+    Fwk::ScopedLock<ARPCache> lock(cache);
+    map<IPv4Addr,Interface::PtrConst>::const_iterator gw;
+    for (gw = gateways_.begin(); gw != gateways_.end(); ++gw) {
+      if (cache->entry(gw->first) == NULL)
+        unresolved.push_back(gw->first);
+    }
+
+    for (ARPCache::iterator it = cache->begin(); it != cache->end(); ++it) {
+      ARPCache::Entry::Ptr entry = it->second;
+      if (entry->type() != ARPCache::Entry::kDynamic ||
+          entry->age() < kRefreshAge) {
+        continue;
+      }
+
+      if (entry->used() || gateways_.count(entry->ipAddr()) > 0) {
+        refreshes.push_back(make_pair(entry->ipAddr(),
+                                      entry->ethernetAddr()));
+        entry->usedIs(false);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < unresolved.size(); ++i) {
+    Interface::PtrConst iface = gateways_[unresolved[i]];
+    if (!iface->enabled())
+      continue;
+
+    DLOG << "resolving gateway " << unresolved[i];
+    cp_->arpRequestNew(unresolved[i], iface);
+  }
+
+  for (size_t i = 0; i < refreshes.size(); ++i) {
+    Interface::PtrConst iface = refreshInterface(refreshes[i].first);
+    if (iface == NULL || !iface->enabled())
+      continue;
+
+    DLOG << "refreshing entry for " << refreshes[i].first;
+    cp_->arpProbeNew(refreshes[i].first, refreshes[i].second, iface);
+  }
+}
+
+
+void
+ARPRefreshDaemon::gatewayNew(const RoutingTable::Entry::NextHop& next_hop) {
+  Interface::PtrConst iface = next_hop.interface();
+  if (next_hop.gateway() == 0u || iface == NULL ||
+      iface->type() != Interface::kHardware) {
+    return;
+  }
+
+  gateways_[next_hop.gateway()] = iface;
+}
+
+
+Interface::PtrConst
+ARPRefreshDaemon::refreshInterface(const IPv4Addr& ip) const {
+  map<IPv4Addr,Interface::PtrConst>::const_iterator gw = gateways_.find(ip);
+  if (gw != gateways_.end())
+    return gw->second;
+
+  RoutingTable::Ptr rtable = cp_->routingTable();
+  Fwk::ScopedLock<RoutingTable> lock(rtable);
+  RoutingTable::Entry::Ptr entry = rtable->lpm(ip);
+  if (entry == NULL || entry->gateway() != 0u)
+    return NULL;
+
+  Interface::PtrConst iface = entry->interface();
+  if (iface == NULL || iface->type() != Interface::kHardware)
+    return NULL;
+
+  return iface;
+}
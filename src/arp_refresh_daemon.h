@@ -0,0 +1,67 @@
+#ifndef ARP_REFRESH_DAEMON_H_
+#define ARP_REFRESH_DAEMON_H_
+
+#include <ctime>
+#include <map>
+
+#include "fwk/log.h"
+#include "fwk/ptr.h"
+
+#include "arp_cache.h"
+#include "arp_cache_daemon.h"
+#include "control_plane.h"
+#include "interface.h"
+#include "ipv4_addr.h"
+#include "routing_table.h"
+#include "task.h"
+
+
+// Keeps the next hops of the router resolved, so that packets to them do not
+// miss in the ARP cache. Every second, gateways of the routing table and next
+// hops of tunnels that are not in the cache are resolved ahead of any packet
+// to them, and dynamic entries of those and of hosts that packets have been
+// forwarded to are refreshed with a unicast ARP request once they are
+// kRefreshAge seconds old, before ARPCacheDaemon removes them. A refresh is
+// repeated every second until a reply resets the age of the entry.
+class ARPRefreshDaemon : public Task {
+ public:
+  typedef Fwk::Ptr<const ARPRefreshDaemon> PtrConst;
+  typedef Fwk::Ptr<ARPRefreshDaemon> Ptr;
+
+  static Ptr New(ControlPlane::Ptr cp) {
+    return new ARPRefreshDaemon(cp);
+  }
+
+  // Age at which entries in use are refreshed, in seconds: 80% of the time
+  // they are kept in the cache.
+  static const time_t kRefreshAge = ARPCacheDaemon::kTimeoutAge * 4 / 5;
+
+  void timeIs(const TimeEpoch& t);
+
+ protected:
+  ARPRefreshDaemon(ControlPlane::Ptr cp);
+
+  // Adds the gateway of NEXT_HOP, if it has one that is reached over
+  // Ethernet, to gateways_.
+  void gatewayNew(const RoutingTable::Entry::NextHop& next_hop);
+
+  // Outgoing interface of a refresh of IP: the interface of its gateway, or
+  // of the directly connected route to it. Returns NULL if there is none.
+  Interface::PtrConst refreshInterface(const IPv4Addr& ip) const;
+
+  ControlPlane::Ptr cp_;
+
+  // Gateways of the routing table and next hops of tunnels, and their
+  // outgoing interfaces, collected every second.
+  std::map<IPv4Addr,Interface::PtrConst> gateways_;
+
+  Fwk::Log::Ptr log_;
+
+ private:
+  // Operations disallowed.
+  ARPRefreshDaemon(const ARPRefreshDaemon&);
+  void operator=(const ARPRefreshDaemon&);
+};
+
+
+#endif
@@ -20,10 +20,12 @@
 
 #include "arp_cache.h"
 #include "control_plane.h"
+#include "data_plane.h"
 #include "interface.h"
 #include "interface_map.h"
 #include "nf2.h"
 #include "nf2util.h"
+#include "ospf_constants.h"
 #include "ospf_gateway.h"
 #include "ospf_interface_map.h"
 #include "ospf_router.h"
@@ -59,6 +61,8 @@ static int skip_next_prompt;
 
 static const char* const kDefaultIfaceName = "nf2c0";
 static const size_t kMaxHWRoutingTableEntries = 32;
+static const size_t kMaxHWIPFilterTableEntries = 32;
+static const unsigned int kHWPorts = 4;
 
 #ifdef _STANDALONE_CLI_
 /**
@@ -364,7 +368,7 @@ void cli_show_hw_intf() {
   }
 
   cli_send_str("\nHW IP filter table:\n");
-  for (unsigned int index = 0; index < InterfaceMap::kMaxInterfaces; ++index) {
+  for (unsigned int index = 0; index < kMaxHWIPFilterTableEntries; ++index) {
     // Set index.
     writeReg(&nf2, ROUTER_OP_LUT_DST_IP_FILTER_TABLE_RD_ADDR_REG, index);
 
@@ -429,9 +433,7 @@ void cli_show_hw_route() {
 
     // Decode interface number.
     unsigned int intf_num = 0;
-    for (intf_num = 0;
-         intf_num < InterfaceMap::kMaxInterfaces;
-         ++intf_num) {
+    for (intf_num = 0; intf_num < kHWPorts; ++intf_num) {
       if ((1 << (intf_num * 2)) == port_reg) {
         break;
       }
@@ -466,6 +468,10 @@ void cli_show_ip() {
     cli_show_ip_route();
     cli_send_str("\n");
     cli_show_ip_tunnel();
+    cli_send_str("\n");
+    cli_show_ip_punt();
+    cli_send_str("\n");
+    cli_show_ip_icmp();
 }
 
 void cli_show_ip_arp() {
@@ -497,8 +503,24 @@ void cli_show_ip_arp() {
                ip.c_str(), mac.c_str());
       ss << line_buf;
     }
+
+    // Packets forwarded before their next hop was resolved.
+    snprintf(line_buf, sizeof(line_buf), "\nCache misses: %llu\n",
+             (unsigned long long)cache->misses());
+    ss << line_buf;
   }
 
+  // Packets waiting for the resolution of their next hop.
+  ARPQueue::Ptr queue = sr->router->controlPlane()->arpQueue();
+  snprintf(line_buf, sizeof(line_buf),
+           "Pending resolution: %zu next hops, %zu packets (%zu bytes)\n"
+           "  Queued: %llu  Dropped: %llu over limits, %llu unresolved\n",
+           queue->entries(), queue->packets(), queue->bytes(),
+           (unsigned long long)queue->enqueued(),
+           (unsigned long long)queue->overflows(),
+           (unsigned long long)queue->unresolved());
+  ss << line_buf;
+
   // Send to client.
   cli_send_str(ss.str().c_str());
 }
@@ -512,12 +534,12 @@ void cli_show_ip_intf() {
   std::stringstream ss;
 
   // Line format.
-  const char* const format = "  %-6s %-16s %-16s %-19s %-6s\n";
+  const char* const format = "  %-6s %-16s %-16s %-19s %-6s %-5s\n";
 
   // Output header.
   cli_send_str("Interfaces:\n");
   snprintf(line_buf, sizeof(line_buf), format,
-           "Name", "IP address", "Mask", "MAC address", "Status");
+           "Name", "IP address", "Mask", "MAC address", "Status", "MTU");
   cli_send_str(line_buf);
 
   {
@@ -531,10 +553,12 @@ void cli_show_ip_intf() {
       const string& mask = iface->subnetMask();
       const string& mac = iface->mac();
       const bool enabled = iface->enabled();
+      char mtu[16];
+      snprintf(mtu, sizeof(mtu), "%zu", iface->mtu());
 
       snprintf(line_buf, sizeof(line_buf), format,
                name.c_str(), ip.c_str(), mask.c_str(), mac.c_str(),
-               (enabled ? "up" : "down"));
+               (enabled ? "up" : "down"), mtu);
       ss << line_buf;
     }
   }
@@ -574,10 +598,37 @@ void cli_show_ip_route() {
       const string& if_name = entry->interface()->name();
       const RoutingTable::Entry::Type type = entry->type();
 
+      // Routes restored after a restart are stale until OSPF confirms them.
+      const char* type_name = "dynamic";
+      if (type == RoutingTable::Entry::kStatic)
+        type_name = "static";
+      else if (entry->stale())
+        type_name = "stale";
+
       snprintf(line_buf, sizeof(line_buf), format,
                subnet.c_str(), gateway.c_str(), mask.c_str(), if_name.c_str(),
-               ((type == RoutingTable::Entry::kStatic) ? "static" : "dynamic"));
+               type_name);
       ss << line_buf;
+
+      // Additional equal-cost next hops, one per line.
+      for (size_t i = 1; i < entry->nextHops(); ++i) {
+        const RoutingTable::Entry::NextHop& next_hop = entry->nextHop(i);
+        const string& ecmp_gateway = next_hop.gateway();
+        snprintf(line_buf, sizeof(line_buf), format,
+                 "", ecmp_gateway.c_str(), "",
+                 next_hop.interface()->name().c_str(), "ecmp");
+        ss << line_buf;
+      }
+
+      // Loop-free alternate, if any.
+      const RoutingTable::Entry::NextHop& backup = entry->backupNextHop();
+      if (backup.interface()) {
+        const string& backup_gateway = backup.gateway();
+        snprintf(line_buf, sizeof(line_buf), format,
+                 "", backup_gateway.c_str(), "",
+                 backup.interface()->name().c_str(), "backup");
+        ss << line_buf;
+      }
     }
   }
 
@@ -594,11 +645,12 @@ void cli_show_ip_tunnel() {
   std::stringstream ss;
 
   // Line format.
-  const char* const format = "  %-16s %-9s\n";
+  const char* const format = "  %-16s %-10s %-9s %-9s\n";
 
   // Output header.
   cli_send_str("Tunnels:\n");
-  snprintf(line_buf, sizeof(line_buf), format, "Endpoint IP", "Interface");
+  snprintf(line_buf, sizeof(line_buf), format,
+           "Endpoint IP", "Key", "Interface", "MSS clamp");
   cli_send_str(line_buf);
 
   {
@@ -609,9 +661,55 @@ void cli_show_ip_tunnel() {
       Tunnel::Ptr tunnel = it->second;
       const string& remote = tunnel->remote();
       const string& if_name = tunnel->interface()->name();
+      char key[16] = "-";
+      if (tunnel->keyed())
+        snprintf(key, sizeof(key), "%u", tunnel->key());
 
       snprintf(line_buf, sizeof(line_buf), format,
-               remote.c_str(), if_name.c_str());
+               remote.c_str(), key, if_name.c_str(),
+               (tunnel->mssClamp() ? "on" : "off"));
+      ss << line_buf;
+    }
+  }
+
+  cli_send_str(ss.str().c_str());
+}
+
+void cli_show_ip_punt() {
+  struct sr_instance* sr = get_sr();
+  PuntQueue::Ptr punt_queue = sr->router->dataPlane()->puntQueue();
+
+  // Buffer for proper formatting.
+  char line_buf[256];
+  std::stringstream ss;
+
+  // Output header.
+  cli_send_str("Punt queues (in order of priority):\n");
+  snprintf(line_buf, sizeof(line_buf),
+           "  %-16s %6s %6s %6s %9s %10s %10s %10s %10s %10s\n",
+           "Class", "Rate", "Burst", "Weight", "Queued",
+           "Enqueued", "Dispatched", "Answered", "Policed", "Overflows");
+  cli_send_str(line_buf);
+
+  // The statistics are read with the queue locked, but sent without.
+  {
+    Fwk::ScopedLock<PuntQueue> lock(punt_queue);
+    for (int c = 0; c < PuntQueue::kClasses; ++c) {
+      PuntQueue::Class punt_class = (PuntQueue::Class)c;
+      snprintf(line_buf, sizeof(line_buf),
+               "  %-16s %6u %6u %6u %4zu/%-4zu %10llu %10llu %10llu %10llu "
+               "%10llu\n",
+               PuntQueue::className(punt_class),
+               punt_queue->rate(punt_class),
+               punt_queue->burst(punt_class),
+               punt_queue->weight(punt_class),
+               punt_queue->packets(punt_class),
+               punt_queue->capacity(punt_class),
+               (unsigned long long)punt_queue->enqueued(punt_class),
+               (unsigned long long)punt_queue->dispatched(punt_class),
+               (unsigned long long)punt_queue->answered(punt_class),
+               (unsigned long long)punt_queue->policed(punt_class),
+               (unsigned long long)punt_queue->overflows(punt_class));
       ss << line_buf;
     }
   }
@@ -619,6 +717,27 @@ void cli_show_ip_tunnel() {
   cli_send_str(ss.str().c_str());
 }
 
+void cli_show_ip_icmp() {
+  struct sr_instance* sr = get_sr();
+  ICMPRateLimiter::Ptr limiter = sr->router->controlPlane()->icmpRateLimiter();
+  Fwk::ScopedLock<ICMPRateLimiter> lock(limiter);
+
+  char line_buf[512];
+  snprintf(line_buf, sizeof(line_buf),
+           "ICMP error rate limits:\n"
+           "  Global: %u per second, burst %u\n"
+           "  Per /%u source prefix: %u per second, burst %u "
+           "(%zu prefixes tracked)\n"
+           "  Sent: %llu  Suppressed: %llu global, %llu per source\n",
+           limiter->rate(), limiter->burst(),
+           limiter->sourcePrefixLen(), limiter->sourceRate(),
+           limiter->sourceBurst(), limiter->sources(),
+           (unsigned long long)limiter->sent(),
+           (unsigned long long)limiter->globalSuppressed(),
+           (unsigned long long)limiter->sourceSuppressed());
+  cli_send_str(line_buf);
+}
+
 void cli_show_opt() {
     cli_show_opt_verbose();
 }
@@ -670,6 +789,40 @@ void cli_show_ospf_interface(OSPFInterface::PtrConst iface) {
            iface->interface()->name().c_str());
   cli_send_str(line_buf);
 
+  if (iface->areaID() == iface->linkedAreaID()) {
+    snprintf(line_buf, sizeof(line_buf), "  Area: %u\n",
+             (unsigned)iface->areaID());
+  } else {
+    snprintf(line_buf, sizeof(line_buf), "  Area: %u (moving to %u)\n",
+             (unsigned)iface->linkedAreaID(), (unsigned)iface->areaID());
+  }
+  cli_send_str(line_buf);
+
+  snprintf(line_buf, sizeof(line_buf), "  Cost: %u (%s)\n",
+           (unsigned)iface->cost(),
+           iface->configuredCost() ? "configured" : "from interface speed");
+  cli_send_str(line_buf);
+
+  if (iface->drPriority()) {
+    RouterID dr = iface->designatedRouter();
+    RouterID bdr = iface->backupDesignatedRouter();
+    string dr_str = (dr == OSPF::kInvalidRouterID) ? "none" : string(dr);
+    string bdr_str = (bdr == OSPF::kInvalidRouterID) ? "none" : string(bdr);
+    snprintf(line_buf, sizeof(line_buf),
+             "  Designated Router: %s  Backup: %s  (priority %u)\n",
+             dr_str.c_str(), bdr_str.c_str(),
+             (unsigned)iface->drPriority());
+    cli_send_str(line_buf);
+  }
+
+  if (iface->fastHelloInterval()) {
+    snprintf(line_buf, sizeof(line_buf),
+             "  Fast HELLO: every %u ms, multiplier %u\n",
+             (unsigned)iface->fastHelloInterval(),
+             (unsigned)iface->fastHelloMultiplier());
+    cli_send_str(line_buf);
+  }
+
   // Active OSPF neighbors.
   cli_send_str("  Active Neighbors:\n");
   snprintf(line_buf, sizeof(line_buf), header_format,
@@ -714,8 +867,55 @@ void cli_show_ospf_neighbors() {
 void cli_show_ospf_topo() {
   struct sr_instance* sr = get_sr();
   OSPFRouter::PtrConst ospf_router = sr->router->controlPlane()->ospfRouter();
-  OSPFTopology::PtrConst topology = ospf_router->topology();
-  cli_send_str(topology->str().c_str());
+
+  char line_buf[256];
+  snprintf(line_buf, sizeof(line_buf),
+           "LSU: %s updates\n"
+           "  Full: %llu  Delta: %llu  Resync requests: %llu\n"
+           "  Flooded packets sent: %llu\n"
+           "Area border router: %s\n\n",
+           ospf_router->lsuDeltasEnabled() ? "incremental" : "full",
+           (unsigned long long)ospf_router->lsuFullFloods(),
+           (unsigned long long)ospf_router->lsuDeltaFloods(),
+           (unsigned long long)ospf_router->lsrSent(),
+           (unsigned long long)ospf_router->floodPacketsSent(),
+           ospf_router->areaBorderRouter() ? "yes" : "no");
+  cli_send_str(line_buf);
+
+  // Each area has a topology and spanning tree computations of its own.
+  for (OSPFRouter::const_area_iter it = ospf_router->areasBegin();
+       it != ospf_router->areasEnd(); ++it) {
+    OSPFArea::PtrConst area = it->second;
+    OSPFTopology::PtrConst topology = area->topology();
+    OSPFSPFThrottle::PtrConst throttle = topology->spfThrottle();
+
+    snprintf(line_buf, sizeof(line_buf),
+             "Area %u%s: %u interfaces, %u summaries advertised, "
+             "%u ranges\n",
+             (unsigned)area->areaID(), area->backbone() ? " (backbone)" : "",
+             (unsigned)area->interfaces(),
+             (unsigned)area->summaries().size(),
+             (unsigned)area->ranges().size());
+    cli_send_str(line_buf);
+
+    snprintf(line_buf, sizeof(line_buf),
+             "SPF Throttle: initial %lld ms, hold %lld ms, max wait %lld ms\n"
+             "  Runs: %llu  Changes: %llu  Suppressed runs: %llu\n"
+             "  Time: total %llu us, last %llu us, max %llu us\n\n",
+             (long long)throttle->initialDelay().value(),
+             (long long)throttle->holdTime().value(),
+             (long long)throttle->maxWait().value(),
+             (unsigned long long)throttle->runs(),
+             (unsigned long long)throttle->changes(),
+             (unsigned long long)throttle->suppressedRuns(),
+             (unsigned long long)throttle->runTime(),
+             (unsigned long long)throttle->lastRunTime(),
+             (unsigned long long)throttle->maxRunTime());
+    cli_send_str(line_buf);
+
+    cli_send_str(topology->str().c_str());
+    cli_send_str("\n");
+  }
 }
 
 void cli_show_link_summary(OSPFLink::PtrConst link) {
@@ -832,6 +1032,53 @@ void cli_manip_ip_arp_purge_sta() {
     cli_send_strs( 5, "Removed ", str_count, " static", what, " from the ARP cache\n" );
 }
 
+void cli_manip_ip_icmp_limit( gross_rate_t* data ) {
+  ICMPRateLimiter::Ptr limiter =
+      get_sr()->router->controlPlane()->icmpRateLimiter();
+
+  Fwk::ScopedLock<ICMPRateLimiter> lock(limiter);
+  limiter->rateIs(data->rate);
+  limiter->burstIs(data->burst);
+
+  char line_buf[256];
+  if (data->rate == 0) {
+    snprintf(line_buf, sizeof(line_buf),
+             "ICMP error messages are no longer limited globally\n");
+  } else {
+    snprintf(line_buf, sizeof(line_buf),
+             "ICMP error messages are limited to %u per second, "
+             "in bursts of up to %u\n", data->rate, data->burst);
+  }
+  cli_send_str(line_buf);
+}
+
+void cli_manip_ip_icmp_source( gross_rate_t* data ) {
+  char line_buf[256];
+  if (data->prefix_len > 32) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Error: the prefix length must be between 0 and 32.\n");
+    cli_send_str(line_buf);
+    return;
+  }
+
+  ICMPRateLimiter::Ptr limiter =
+      get_sr()->router->controlPlane()->icmpRateLimiter();
+  Fwk::ScopedLock<ICMPRateLimiter> lock(limiter);
+  limiter->sourcePrefixLenIs(data->prefix_len);
+  limiter->sourceRateIs(data->rate, data->burst);
+
+  if (data->rate == 0) {
+    snprintf(line_buf, sizeof(line_buf),
+             "ICMP error messages are no longer limited per source\n");
+  } else {
+    snprintf(line_buf, sizeof(line_buf),
+             "ICMP error messages to each /%u are limited to %u per second, "
+             "in bursts of up to %u\n",
+             data->prefix_len, data->rate, data->burst);
+  }
+  cli_send_str(line_buf);
+}
+
 // TODO(ms): This should probably be implemented in cli_stubs.{cc,h}.
 void cli_manip_ip_intf_set( gross_intf_t* data ) {
     Interface::Ptr intf =
@@ -886,6 +1133,31 @@ void cli_manip_ip_intf_up( gross_intf_t* data ) {
     cli_manip_ip_intf_set_enabled( data->intf_name, 1 );
 }
 
+void cli_manip_ip_intf_mtu( gross_intf_t* data ) {
+  struct sr_instance* sr = get_sr();
+  Interface::Ptr intf = router_lookup_interface_via_name(sr, data->intf_name);
+  if (!intf) {
+    cli_send_strs(3, "Error: no interface with the name ",
+                  data->intf_name, " exists.\n");
+    return;
+  }
+
+  char line_buf[256];
+  if (data->value < Interface::kMinMTU || data->value > 0xffff) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Error: the MTU must be between %zu and %u bytes.\n",
+             Interface::kMinMTU, 0xffff);
+    cli_send_str(line_buf);
+    return;
+  }
+
+  intf->mtuIs(data->value);
+  snprintf(line_buf, sizeof(line_buf),
+           "The MTU of %s has been set to %u bytes\n",
+           data->intf_name, data->value);
+  cli_send_str(line_buf);
+}
+
 void cli_manip_ip_ospf_down() {
     if( router_is_ospf_enabled( SR ) ) {
         router_set_ospf_enabled( SR, 0 );
@@ -904,6 +1176,197 @@ void cli_manip_ip_ospf_up() {
         cli_send_str( "OSPF was already enabled\n" );
 }
 
+void cli_manip_ip_ospf_delta_down() {
+  struct sr_instance* sr = get_sr();
+  OSPFRouter::Ptr ospf_router = sr->router->controlPlane()->ospfRouter();
+  if (ospf_router->lsuDeltasEnabled()) {
+    ospf_router->lsuDeltasEnabledIs(false);
+    cli_send_str("Incremental link-state updates have been disabled\n");
+  } else {
+    cli_send_str("Incremental link-state updates were already disabled\n");
+  }
+}
+
+void cli_manip_ip_ospf_delta_up() {
+  struct sr_instance* sr = get_sr();
+  OSPFRouter::Ptr ospf_router = sr->router->controlPlane()->ospfRouter();
+  if (!ospf_router->lsuDeltasEnabled()) {
+    ospf_router->lsuDeltasEnabledIs(true);
+    cli_send_str("Incremental link-state updates have been enabled\n");
+  } else {
+    cli_send_str("Incremental link-state updates were already enabled\n");
+  }
+}
+
+void cli_manip_ip_ospf_fast( gross_intf_t* data ) {
+  struct sr_instance* sr = get_sr();
+  Interface::Ptr intf = router_lookup_interface_via_name(sr, data->intf_name);
+  if (!intf) {
+    cli_send_strs(3, "Error: no interface with the name ",
+                  data->intf_name, " exists.\n");
+    return;
+  }
+
+  OSPFRouter::Ptr ospf_router = sr->router->controlPlane()->ospfRouter();
+  OSPFInterface::Ptr iface = ospf_router->interfaceMap()->interface(intf->ip());
+  if (!iface) {
+    cli_send_strs(3, "Error: OSPF is not running on interface ",
+                  data->intf_name, ".\n");
+    return;
+  }
+
+  char line_buf[256];
+  if (data->value != 0 &&
+      (data->value < OSPF::kMinFastHelloInterval || data->value > 0xffff)) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Error: the fast HELLO interval must be 0 or between %u and "
+             "%u ms.\n", OSPF::kMinFastHelloInterval, 0xffff);
+    cli_send_str(line_buf);
+    return;
+  }
+
+  iface->fastHelloIntervalIs(data->value);
+  if (data->value == 0) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Fast HELLOs have been disabled on %s\n", data->intf_name);
+  } else {
+    snprintf(line_buf, sizeof(line_buf),
+             "Fast HELLOs will be sent every %u ms out of %s, starting with "
+             "the next HELLO\n", data->value, data->intf_name);
+  }
+  cli_send_str(line_buf);
+}
+
+void cli_manip_ip_ospf_cost( gross_intf_t* data ) {
+  struct sr_instance* sr = get_sr();
+  Interface::Ptr intf = router_lookup_interface_via_name(sr, data->intf_name);
+  if (!intf) {
+    cli_send_strs(3, "Error: no interface with the name ",
+                  data->intf_name, " exists.\n");
+    return;
+  }
+
+  OSPFRouter::Ptr ospf_router = sr->router->controlPlane()->ospfRouter();
+  OSPFInterface::Ptr iface = ospf_router->interfaceMap()->interface(intf->ip());
+  if (!iface) {
+    cli_send_strs(3, "Error: OSPF is not running on interface ",
+                  data->intf_name, ".\n");
+    return;
+  }
+
+  char line_buf[256];
+  if (data->value > 0xffff) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Error: the cost must be between 1 and %u, or 0 to derive it "
+             "from the interface speed.\n", 0xffff);
+    cli_send_str(line_buf);
+    return;
+  }
+
+  // Picked up by the processing thread with its next link-state check.
+  iface->configuredCostIs(data->value);
+  snprintf(line_buf, sizeof(line_buf),
+           "Links through %s now cost %u\n", data->intf_name,
+           (unsigned)iface->cost());
+  cli_send_str(line_buf);
+}
+
+void cli_manip_ip_ospf_dr( gross_intf_t* data ) {
+  struct sr_instance* sr = get_sr();
+  Interface::Ptr intf = router_lookup_interface_via_name(sr, data->intf_name);
+  if (!intf) {
+    cli_send_strs(3, "Error: no interface with the name ",
+                  data->intf_name, " exists.\n");
+    return;
+  }
+
+  if (intf->type() == Interface::kVirtual) {
+    cli_send_strs(3, "Error: there are no designated routers on tunnel ",
+                  data->intf_name, ".\n");
+    return;
+  }
+
+  OSPFRouter::Ptr ospf_router = sr->router->controlPlane()->ospfRouter();
+  OSPFInterface::Ptr iface = ospf_router->interfaceMap()->interface(intf->ip());
+  if (!iface) {
+    cli_send_strs(3, "Error: OSPF is not running on interface ",
+                  data->intf_name, ".\n");
+    return;
+  }
+
+  char line_buf[256];
+  if (data->value > 0xff) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Error: the priority must be between 1 and %u, or 0 to stop "
+             "taking part in elections.\n", 0xff);
+    cli_send_str(line_buf);
+    return;
+  }
+
+  // Announced to neighbors with the next HELLO; the election runs on the
+  // processing thread.
+  iface->drPriorityIs(data->value);
+  if (data->value == 0) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Designated-router elections have been disabled on %s\n",
+             data->intf_name);
+  } else {
+    snprintf(line_buf, sizeof(line_buf),
+             "Designated-router priority on %s is now %u, starting with the "
+             "next HELLO\n", data->intf_name, data->value);
+  }
+  cli_send_str(line_buf);
+}
+
+void cli_manip_ip_ospf_area( gross_intf_t* data ) {
+  struct sr_instance* sr = get_sr();
+  Interface::Ptr intf = router_lookup_interface_via_name(sr, data->intf_name);
+  if (!intf) {
+    cli_send_strs(3, "Error: no interface with the name ",
+                  data->intf_name, " exists.\n");
+    return;
+  }
+
+  OSPFRouter::Ptr ospf_router = sr->router->controlPlane()->ospfRouter();
+  OSPFInterface::Ptr iface = ospf_router->interfaceMap()->interface(intf->ip());
+  if (!iface) {
+    cli_send_strs(3, "Error: OSPF is not running on interface ",
+                  data->intf_name, ".\n");
+    return;
+  }
+
+  // The processing thread moves the interface with its next link-state
+  // check; neighbors on the interface have to form adjacencies again.
+  iface->areaIDIs(data->value);
+
+  char line_buf[256];
+  snprintf(line_buf, sizeof(line_buf),
+           "%s is now in area %u; its neighbors will be dropped\n",
+           data->intf_name, data->value);
+  cli_send_str(line_buf);
+}
+
+void cli_manip_ip_ospf_spf( gross_spf_t* data ) {
+  char line_buf[256];
+  if (data->max_wait < data->hold_time) {
+    snprintf(line_buf, sizeof(line_buf),
+             "Error: the maximum wait must be at least the hold time.\n");
+    cli_send_str(line_buf);
+    return;
+  }
+
+  // Computations that are already scheduled keep their deadlines.
+  OSPFRouter::Ptr ospf_router = get_sr()->router->controlPlane()->ospfRouter();
+  ospf_router->spfThrottleIs(data->initial_delay, data->hold_time,
+                             data->max_wait);
+
+  snprintf(line_buf, sizeof(line_buf),
+           "Shortest paths will be computed %u ms after a topology change, "
+           "then at least %u ms apart, backing off up to %u ms\n",
+           data->initial_delay, data->hold_time, data->max_wait);
+  cli_send_str(line_buf);
+}
+
 void cli_manip_ip_route_add( gross_route_t* data ) {
     Interface::Ptr intf =
         router_lookup_interface_via_name( SR, data->intf_name );
@@ -946,8 +1409,12 @@ void cli_manip_ip_tunnel_add(gross_tunnel_t* data) {
     return;
   }
 
-  if (tunnel_add(SR, data->name, data->mode, data->remote))
+  const int ret = tunnel_add(SR, data->name, data->mode, data->remote,
+                             data->keyed, data->key);
+  if (ret > 0)
     cli_send_str("The tunnel has been added\n");
+  else if (ret < 0)
+    cli_send_str("A tunnel already exists with that remote and key.\n");
   else
     cli_send_str("An interface or tunnel already exists with that name.\n");
 }
@@ -967,8 +1434,26 @@ void cli_manip_ip_tunnel_change(gross_tunnel_t* data) {
     return;
   }
 
-  if (tunnel_change(SR, data->name, data->mode, data->remote))
+  const int ret = tunnel_change(SR, data->name, data->mode, data->remote,
+                                data->keyed, data->key);
+  if (ret > 0)
     cli_send_str("The tunnel has been changed.\n");
+  else if (ret < 0)
+    cli_send_str("A tunnel already exists with that remote and key.\n");
+  else
+    cli_send_str("No tunnel exists with that name.\n");
+}
+
+void cli_manip_ip_tunnel_mss_up(gross_tunnel_t* data) {
+  if (tunnel_mss_clamp_set(SR, data->name, 1))
+    cli_send_str("TCP MSS clamping has been enabled on the tunnel.\n");
+  else
+    cli_send_str("No tunnel exists with that name.\n");
+}
+
+void cli_manip_ip_tunnel_mss_down(gross_tunnel_t* data) {
+  if (tunnel_mss_clamp_set(SR, data->name, 0))
+    cli_send_str("TCP MSS clamping has been disabled on the tunnel.\n");
   else
     cli_send_str("No tunnel exists with that name.\n");
 }
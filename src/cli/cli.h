@@ -38,6 +38,7 @@ typedef struct {
     const char* intf_name;
     uint32_t ip;
     uint32_t subnet_mask;
+    unsigned value;
 } gross_intf_t;
 
 typedef struct {
@@ -51,6 +52,8 @@ typedef struct {
     const char* name;
     const char* mode;
     uint32_t remote;
+    int keyed;
+    uint32_t key;
 } gross_tunnel_t;
 
 typedef struct {
@@ -66,6 +69,18 @@ typedef struct {
     int on;
 } gross_option_t;
 
+typedef struct {
+    unsigned initial_delay;
+    unsigned hold_time;
+    unsigned max_wait;
+} gross_spf_t;
+
+typedef struct {
+    unsigned prefix_len;
+    unsigned rate;
+    unsigned burst;
+} gross_rate_t;
+
 /** Initiliazes the CLI global variables. */
 void cli_init();
 
@@ -122,6 +137,8 @@ void cli_show_ip_arp();
 void cli_show_ip_intf();
 void cli_show_ip_route();
 void cli_show_ip_tunnel();
+void cli_show_ip_punt();
+void cli_show_ip_icmp();
 
 void cli_show_opt();
 void cli_show_opt_verbose();
@@ -152,12 +169,23 @@ void cli_manip_ip_arp_purge_all();
 void cli_manip_ip_arp_purge_sta();
 void cli_manip_ip_arp_purge_dyn();
 
+void cli_manip_ip_icmp_limit( gross_rate_t* data );
+void cli_manip_ip_icmp_source( gross_rate_t* data );
+
 void cli_manip_ip_intf_set( gross_intf_t* data );
 void cli_manip_ip_intf_down( gross_intf_t* data );
 void cli_manip_ip_intf_up( gross_intf_t* data );
+void cli_manip_ip_intf_mtu( gross_intf_t* data );
 
 void cli_manip_ip_ospf_down();
 void cli_manip_ip_ospf_up();
+void cli_manip_ip_ospf_delta_down();
+void cli_manip_ip_ospf_delta_up();
+void cli_manip_ip_ospf_fast( gross_intf_t* data );
+void cli_manip_ip_ospf_cost( gross_intf_t* data );
+void cli_manip_ip_ospf_dr( gross_intf_t* data );
+void cli_manip_ip_ospf_area( gross_intf_t* data );
+void cli_manip_ip_ospf_spf( gross_spf_t* data );
 
 void cli_manip_ip_route_add( gross_route_t* data );
 void cli_manip_ip_route_del( gross_route_t* data );
@@ -168,6 +196,8 @@ void cli_manip_ip_route_purge_sta();
 void cli_manip_ip_tunnel_add(gross_tunnel_t* data);
 void cli_manip_ip_tunnel_del(gross_tunnel_t* data);
 void cli_manip_ip_tunnel_change(gross_tunnel_t* data);
+void cli_manip_ip_tunnel_mss_up(gross_tunnel_t* data);
+void cli_manip_ip_tunnel_mss_down(gross_tunnel_t* data);
 
 /* Display the current date and time. */
 void cli_date();
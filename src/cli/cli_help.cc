@@ -76,13 +76,15 @@ show hw route: displays the HW routing table\n" );
 
           case HELP_SHOW_IP:
               return cli_send_multi_help( fd, "\
-show ip [arp, interface (intf), route (rt), tunnel (tun)]: display information about the\n\
-  router's IP state\n",
-4,
+show ip [arp, interface (intf), route (rt), tunnel (tun), punt, icmp]: display\n\
+  information about the router's IP state\n",
+6,
 HELP_SHOW_IP_ARP,
 HELP_SHOW_IP_INTF,
 HELP_SHOW_IP_ROUTE,
-HELP_SHOW_IP_TUNNEL );
+HELP_SHOW_IP_TUNNEL,
+HELP_SHOW_IP_PUNT,
+HELP_SHOW_IP_ICMP );
 
            case HELP_SHOW_IP_ARP:
                 return 0==writenstr( fd, "\
@@ -100,6 +102,17 @@ show ip route: displays the routing table sorted by longest prefixes first\n" );
                 return 0 == writenstr(fd, "\
 show ip tunnel: displays the configured IP tunnels\n");
 
+           case HELP_SHOW_IP_PUNT:
+                return 0 == writenstr(fd, "\
+show ip punt: displays the queues of packets punted to the control plane,\n\
+  with their rate limits and drop counters, and the packets of each class\n\
+  answered by the data plane\n");
+
+           case HELP_SHOW_IP_ICMP:
+                return 0 == writenstr(fd, "\
+show ip icmp: displays the rate limits of ICMP error messages and the number\n\
+  of messages sent and suppressed\n");
+
           case HELP_SHOW_OPT:
               return cli_send_multi_help( fd, "\
 show opt [verbose]: display information about options' current values\n",
@@ -157,9 +170,10 @@ show vns vhost: displays the VNS virtual host address\n" );
 
           case HELP_MANIP_IP:
             return cli_send_multi_help( fd, "\
-ip [arp | interface (intf) | ospf | route (rt)] <command>: update the router's state\n",
-5,
+ip [arp | icmp | interface (intf) | ospf | route (rt)] <command>: update the router's state\n",
+6,
 HELP_MANIP_IP_ARP,
+HELP_MANIP_IP_ICMP,
 HELP_MANIP_IP_INTF,
 HELP_MANIP_IP_OSPF,
 HELP_MANIP_IP_ROUTE,
@@ -199,11 +213,13 @@ ip arp purge static: removes all static entries from the ARP cache\n" );
 
            case HELP_MANIP_IP_INTF:
                return cli_send_multi_help( fd, "\
-ip interface <name> <down | up | <IP> <mask>>: modify the interface named <name>\n",
-3,
+ip interface <name> <down | up | mtu | <IP> <mask>>: modify the interface\n\
+  named <name>\n",
+4,
 HELP_MANIP_IP_INTF_SET,
 HELP_MANIP_IP_INTF_DOWN,
-HELP_MANIP_IP_INTF_UP );
+HELP_MANIP_IP_INTF_UP,
+HELP_MANIP_IP_INTF_MTU );
 
              case HELP_MANIP_IP_INTF_SET:
                  return 0==writenstr( fd, "\
@@ -218,12 +234,41 @@ ip interface <name> down: disable the specified interface\n" );
                  return 0==writenstr( fd, "\
 ip interface <name> up: enable the specified interface\n" );
 
-           case HELP_MANIP_IP_OSPF:
+             case HELP_MANIP_IP_INTF_MTU:
+                 return 0==writenstr( fd, "\
+ip interface <name> mtu <bytes>: set the largest IP packet sent out of the\n\
+  specified interface; larger packets are fragmented (minimum 68)\n" );
+
+           case HELP_MANIP_IP_ICMP:
                return cli_send_multi_help( fd, "\
-ip ospf <disable | enable>\n",
+ip icmp <limit | source>: limit the rate of ICMP error messages\n",
 2,
+HELP_MANIP_IP_ICMP_LIMIT,
+HELP_MANIP_IP_ICMP_SOURCE );
+
+             case HELP_MANIP_IP_ICMP_LIMIT:
+                 return 0==writenstr( fd, "\
+ip icmp limit <rate> <burst>: send at most <rate> ICMP error messages per\n\
+  second, in bursts of up to <burst> (a rate of 0 disables the limit)\n" );
+
+             case HELP_MANIP_IP_ICMP_SOURCE:
+                 return 0==writenstr( fd, "\
+ip icmp source <prefix length> <rate> <burst>: send at most <rate> ICMP error\n\
+  messages per second to each source prefix of <prefix length> bits, in\n\
+  bursts of up to <burst> (a rate of 0 disables the limit)\n" );
+
+           case HELP_MANIP_IP_OSPF:
+               return cli_send_multi_help( fd, "\
+ip ospf <disable | enable | delta | fast | cost | dr | area | spf>\n",
+8,
 HELP_MANIP_IP_OSPF_DOWN,
-HELP_MANIP_IP_OSPF_UP );
+HELP_MANIP_IP_OSPF_UP,
+HELP_MANIP_IP_OSPF_DELTA,
+HELP_MANIP_IP_OSPF_FAST,
+HELP_MANIP_IP_OSPF_COST,
+HELP_MANIP_IP_OSPF_DR,
+HELP_MANIP_IP_OSPF_AREA,
+HELP_MANIP_IP_OSPF_SPF );
 
              case HELP_MANIP_IP_OSPF_DOWN:
                  return 0==writenstr( fd, "\
@@ -233,6 +278,38 @@ ip ospf <disable|down>: disable the dynamic OSPF routing protocol\n" );
                  return 0==writenstr( fd, "\
 ip ospf <enable|up>: enable the dynamic OSPF routing protocol\n" );
 
+             case HELP_MANIP_IP_OSPF_DELTA:
+                 return 0==writenstr( fd, "\
+ip ospf delta <enable|disable>: send incremental link-state updates\n\
+  (only supported by routers running this implementation)\n" );
+
+             case HELP_MANIP_IP_OSPF_FAST:
+                 return 0==writenstr( fd, "\
+ip ospf fast <interface> <ms>: send fast HELLOs every <ms> milliseconds\n\
+  out of <interface> (0 disables; takes effect with the next HELLO)\n" );
+
+             case HELP_MANIP_IP_OSPF_COST:
+                 return 0==writenstr( fd, "\
+ip ospf cost <interface> <cost>: set the cost of links through <interface>\n\
+  in shortest-path computations (0 derives it from the interface speed)\n" );
+
+             case HELP_MANIP_IP_OSPF_DR:
+                 return 0==writenstr( fd, "\
+ip ospf dr <interface> <priority>: take part in designated-router elections\n\
+  on <interface>, which reduce flooding on shared segments (0 disables)\n" );
+
+             case HELP_MANIP_IP_OSPF_AREA:
+                 return 0==writenstr( fd, "\
+ip ospf area <interface> <area>: move <interface> into OSPF area <area>;\n\
+  routers in more than one area summarize prefixes between them (0 is the\n\
+  backbone)\n" );
+
+             case HELP_MANIP_IP_OSPF_SPF:
+                 return 0==writenstr( fd, "\
+ip ospf spf <initial> <hold> <max>: wait <initial> ms after a topology change\n\
+  before computing shortest paths, then space computations <hold> ms apart,\n\
+  doubling up to <max> ms while the topology keeps changing\n" );
+
            case HELP_MANIP_IP_ROUTE:
                return cli_send_multi_help( fd, "\
 ip route {add | del | purge} [<options>]: modify the routing table\n",
@@ -269,15 +346,17 @@ ip route purge <sta|static>: remove all static routes in the routing table\n" );
 
            case HELP_MANIP_IP_TUNNEL:
               return cli_send_multi_help(fd, "\
-ip tunnel {add | del | change} <name> [mode { gre }] [remote ADDR]: modify tunnels\n",
-3,
+ip tunnel {add | del | change | mss} <name> [mode { gre }] [remote ADDR] [key KEY]: modify tunnels\n",
+4,
 HELP_MANIP_IP_TUNNEL_ADD,
 HELP_MANIP_IP_TUNNEL_DEL,
-HELP_MANIP_IP_TUNNEL_CHANGE);
+HELP_MANIP_IP_TUNNEL_CHANGE,
+HELP_MANIP_IP_TUNNEL_MSS);
 
              case HELP_MANIP_IP_TUNNEL_ADD:
                return 0 == writenstr(fd, "\
-ip tunnel add <name> mode { gre } remote <addr>: add a tunnel to <addr>\n");
+ip tunnel add <name> mode { gre } remote <addr> [key <key>]: add a tunnel to <addr>;\n\
+  tunnels to the same <addr> are told apart by their GRE keys\n");
 
              case HELP_MANIP_IP_TUNNEL_DEL:
                return 0 == writenstr(fd, "\
@@ -285,7 +364,13 @@ ip tunnel del <name>: delete a tunnel\n");
 
              case HELP_MANIP_IP_TUNNEL_CHANGE:
                return 0 == writenstr(fd, "\
-ip tunnel change <name> mode { gre } remote <addr>: change attributes of an existing tunnel\n");
+ip tunnel change <name> mode { gre } remote <addr> [key <key>]: change attributes of an\n\
+  existing tunnel\n");
+
+             case HELP_MANIP_IP_TUNNEL_MSS:
+               return 0 == writenstr(fd, "\
+ip tunnel mss <name> <enable|disable>: lower the MSS option of TCP SYNs through\n\
+  the tunnel to fit its MTU\n");
 
         case HELP_ACTION:
             return cli_send_multi_help( fd, "",
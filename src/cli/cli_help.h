@@ -22,6 +22,8 @@ typedef enum cli_help_t {
        HELP_SHOW_IP_INTF,
        HELP_SHOW_IP_ROUTE,
        HELP_SHOW_IP_TUNNEL,
+       HELP_SHOW_IP_PUNT,
+       HELP_SHOW_IP_ICMP,
       HELP_SHOW_OPT,
        HELP_SHOW_OPT_VERBOSE,
       HELP_SHOW_OSPF,
@@ -41,13 +43,23 @@ typedef enum cli_help_t {
          HELP_MANIP_IP_ARP_PURGE_ALL,
          HELP_MANIP_IP_ARP_PURGE_DYN,
          HELP_MANIP_IP_ARP_PURGE_STA,
+       HELP_MANIP_IP_ICMP,
+         HELP_MANIP_IP_ICMP_LIMIT,
+         HELP_MANIP_IP_ICMP_SOURCE,
        HELP_MANIP_IP_INTF,
          HELP_MANIP_IP_INTF_SET,
          HELP_MANIP_IP_INTF_DOWN,
          HELP_MANIP_IP_INTF_UP,
+         HELP_MANIP_IP_INTF_MTU,
        HELP_MANIP_IP_OSPF,
          HELP_MANIP_IP_OSPF_DOWN,
          HELP_MANIP_IP_OSPF_UP,
+         HELP_MANIP_IP_OSPF_DELTA,
+         HELP_MANIP_IP_OSPF_FAST,
+         HELP_MANIP_IP_OSPF_COST,
+         HELP_MANIP_IP_OSPF_DR,
+         HELP_MANIP_IP_OSPF_AREA,
+         HELP_MANIP_IP_OSPF_SPF,
        HELP_MANIP_IP_ROUTE,
          HELP_MANIP_IP_ROUTE_ADD,
          HELP_MANIP_IP_ROUTE_DEL,
@@ -58,6 +70,7 @@ typedef enum cli_help_t {
          HELP_MANIP_IP_TUNNEL_ADD,
          HELP_MANIP_IP_TUNNEL_DEL,
          HELP_MANIP_IP_TUNNEL_CHANGE,
+         HELP_MANIP_IP_TUNNEL_MSS,
 
     HELP_ACTION,
       HELP_ACTION_DATE,
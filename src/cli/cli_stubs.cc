@@ -241,10 +241,24 @@ void rtable_purge(struct sr_instance* const sr, const int is_static) {
 }
 
 
+// Returns the tunnel to DEST with KEY if KEYED, or without a key.
+static Tunnel::Ptr
+tunnel_endpoint(TunnelMap::Ptr tun_map,
+                const uint32_t dest,
+                const int keyed,
+                const uint32_t key) {
+  if (keyed)
+    return tun_map->tunnelRemoteAddr(ntohl(dest), key);
+  return tun_map->tunnelRemoteAddr(ntohl(dest));
+}
+
+
 int tunnel_add(struct sr_instance* const sr,
                const char* const name,
                const char* const mode,
-               const uint32_t dest) {
+               const uint32_t dest,
+               const int keyed,
+               const uint32_t key) {
   InterfaceMap::Ptr if_map = sr->router->dataPlane()->interfaceMap();
   TunnelMap::Ptr tun_map = sr->router->controlPlane()->tunnelMap();
   Fwk::ScopedLock<InterfaceMap> if_map_lock(if_map);
@@ -255,6 +269,10 @@ int tunnel_add(struct sr_instance* const sr,
   if (if_map->interface(name))
     return 0;   // interface already exists with name
 
+  // Decapsulated packets are told apart by remote and key only.
+  if (tunnel_endpoint(tun_map, dest, keyed, key))
+    return -1;  // tunnel already exists with remote and key
+
   // Create a new virtual interface for the tunnel.
   Interface::Ptr iface = Interface::InterfaceNew(name);
   iface->typeIs(Interface::kVirtual);
@@ -264,6 +282,8 @@ int tunnel_add(struct sr_instance* const sr,
   Tunnel::Ptr tunnel = Tunnel::New(iface);
   tunnel->modeIs(Tunnel::kGRE);  // we only support GRE for now
   tunnel->remoteIs(ntohl(dest));
+  if (keyed)
+    tunnel->keyIs(key);
 
   // Add the tunnel and virtual interface to their respective maps.
   if_map->interfaceIs(iface);
@@ -294,7 +314,9 @@ int tunnel_del(struct sr_instance* const sr, const char* const name) {
 int tunnel_change(struct sr_instance* const sr,
                   const char* const name,
                   const char* const mode,
-                  const uint32_t dest) {
+                  const uint32_t dest,
+                  const int keyed,
+                  const uint32_t key) {
   InterfaceMap::Ptr if_map = sr->router->dataPlane()->interfaceMap();
   TunnelMap::Ptr tun_map = sr->router->controlPlane()->tunnelMap();
   Fwk::ScopedLock<InterfaceMap> if_map_lock(if_map);
@@ -306,17 +328,40 @@ int tunnel_change(struct sr_instance* const sr,
 
   Tunnel::Ptr tunnel = tun_map->tunnel(name);
 
-  // Remove tunnel from map first. The tunnel map keys on the remote address,
-  // so to ensure consistency, we clear all pointers to the tunnel in the map
-  // before updating the tunnel.
+  Tunnel::Ptr other = tunnel_endpoint(tun_map, dest, keyed, key);
+  if (other && other != tunnel)
+    return -1;  // tunnel already exists with remote and key
+
+  // Remove tunnel from map first. The tunnel map keys on the remote address
+  // and key, so to ensure consistency, we clear all pointers to the tunnel in
+  // the map before updating the tunnel.
   tun_map->tunnelDel(tunnel);
 
   // Update the attributes of the tunnel.
   tunnel->modeIs(Tunnel::kGRE);  // we only support GRE right now
   tunnel->remoteIs(ntohl(dest));
+  if (keyed)
+    tunnel->keyIs(key);
+  else
+    tunnel->keyDel();
 
   // Re-add tunnel to map.
   tun_map->tunnelIs(tunnel);
 
   return 1;
 }
+
+
+int tunnel_mss_clamp_set(struct sr_instance* const sr,
+                         const char* const name,
+                         const int enabled) {
+  TunnelMap::Ptr tun_map = sr->router->controlPlane()->tunnelMap();
+  Fwk::ScopedLock<TunnelMap> tun_map_lock(tun_map);
+
+  Tunnel::Ptr tunnel = tun_map->tunnel(name);
+  if (!tunnel)
+    return 0;  // no tunnel exists with that name
+
+  tunnel->mssClampIs(enabled);
+  return 1;
+}
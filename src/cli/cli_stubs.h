@@ -102,12 +102,16 @@ void rtable_purge(struct sr_instance* sr, int is_static);
 
 
 /**
- * Adds a new tunnel.
+ * Adds a new tunnel, with GRE key 'key' if 'keyed' is non-zero. Returns 1 on
+ * success, 0 if an interface or tunnel already exists with that name, and -1
+ * if another tunnel has the same remote and key.
  */
 int tunnel_add(struct sr_instance* sr,
                const char* name,
                const char* mode,
-               uint32_t dest);
+               uint32_t dest,
+               int keyed,
+               uint32_t key);
 
 /**
  * Deletes an existing tunnel.
@@ -115,11 +119,19 @@ int tunnel_add(struct sr_instance* sr,
 int tunnel_del(struct sr_instance* sr, const char* name);
 
 /**
- * Changes an existing tunnel.
+ * Changes an existing tunnel. Returns 1 on success, 0 if no tunnel exists
+ * with that name, and -1 if another tunnel has the same remote and key.
  */
 int tunnel_change(struct sr_instance* sr,
                   const char* name,
                   const char* mode,
-                  uint32_t dest);
+                  uint32_t dest,
+                  int keyed,
+                  uint32_t key);
+
+/**
+ * Enables or disables TCP MSS clamping on an existing tunnel.
+ */
+int tunnel_mss_clamp_set(struct sr_instance* sr, const char* name, int enabled);
 
 #endif /* CLI_STUBS_H */
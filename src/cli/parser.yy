@@ -40,6 +40,7 @@ char token_err[128];
 #define ERR_INTF  ERR("expected interface name")
 #define ERR_MODE  ERR("expected tunnel mode")
 #define ERR_REMOTE ERR("expected tunnel remote IP")
+#define ERR_KEY   ERR("expected tunnel key")
 #define ERR_NO_USAGE(desc) parse_error(desc); meh_force = 1; meh_has_usage = 0; meh_ignore = 0;
 #define ERR_IGNORE meh_ignore = 1;
 
@@ -55,19 +56,25 @@ gross_tunnel_t gtt;
 gross_ip_t gip;
 gross_ip_int_t giip;
 gross_option_t gopt;
+gross_rate_t grate;
+gross_spf_t gspf;
 #define SETC_FUNC0(func)      gobj.func_do0=func; gobj.func_do1=NULL; gobj.data=NULL
 #define SETC_FUNC1(func)      gobj.func_do0=NULL; gobj.func_do1=(void (*)(void*))func; gobj.data=NULL
 #define SETC_ARP_IP(func,xip)  SETC_FUNC1(func); gobj.data=&garp; garp.ip=xip
 #define SETC_ARP(func,ip,xmac) SETC_ARP_IP(func,ip); memcpy(garp.mac, xmac, 6);
 #define SETC_INTF(func,name)  SETC_FUNC1(func); gobj.data=&gintf; gintf.intf_name=name
 #define SETC_INTF_SET(func,name,xip,sm) SETC_INTF(func,name); gintf.ip=xip; gintf.subnet_mask=sm
+#define SETC_INTF_INT(func,name,n) SETC_INTF(func,name); gintf.value=n
 #define SETC_RT(func,xdest,xmask) SETC_FUNC1(func); gobj.data=&grt; grt.dest=xdest; grt.mask=xmask
 #define SETC_RT_ADD(func,dest,xgw,mask,intf) SETC_RT(func,dest,mask); grt.gw=xgw; grt.intf_name=intf
 #define SETC_TUN(func, xname) SETC_FUNC1(func); gobj.data=&gtt; gtt.name=xname
-#define SETC_TUN_ADDCH(func, xname, xmode, xip) SETC_TUN(func, xname); gtt.mode=xmode; gtt.remote=xip
+#define SETC_TUN_ADDCH(func, xname, xmode, xip) SETC_TUN(func, xname); gtt.mode=xmode; gtt.remote=xip; gtt.keyed=0; gtt.key=0
+#define SETC_TUN_ADDCH_KEY(func, xname, xmode, xip, xkey) SETC_TUN_ADDCH(func, xname, xmode, xip); gtt.keyed=1; gtt.key=xkey
 #define SETC_IP(func,xip) SETC_FUNC1(func); gobj.data=&gip; gip.ip=xip
 #define SETC_IP_INT(func,xip,xn) SETC_FUNC1(func); gobj.data=&giip; giip.ip=xip; giip.count=xn
 #define SETC_OPT(func) SETC_FUNC1(func); gobj.data=&gopt
+#define SETC_RATE(func,len,xrate,xburst) SETC_FUNC1(func); gobj.data=&grate; grate.prefix_len=len; grate.rate=xrate; grate.burst=xburst
+#define SETC_SPF(func,initial,hold,max) SETC_FUNC1(func); gobj.data=&gspf; gspf.initial_delay=initial; gspf.hold_time=hold; gspf.max_wait=max
 
 /** Clears out any previous command */
 static void clear_command();
@@ -94,9 +101,9 @@ static void run_command();
 %token  T_SHOW T_QUESTION T_NEWLINE T_ALL
 %token  T_VNS T_USER T_VHOST T_LHOST T_TOPOLOGY
 %token  T_IP T_ROUTE T_INTF T_ARP T_OSPF T_HW T_NEIGHBORS
-%token  T_TUNNEL T_MODE T_REMOTE
+%token  T_TUNNEL T_MODE T_REMOTE T_KEY T_PUNT T_ICMP T_LIMIT T_SOURCE T_MTU T_MSS
 %token  T_ADD T_DEL T_CHANGE T_UP T_DOWN T_PURGE T_STATIC T_DYNAMIC T_ABOUT
-%token  T_PING T_TRACE T_HELP T_EXIT T_SHUTDOWN T_FLOOD
+%token  T_PING T_TRACE T_HELP T_EXIT T_SHUTDOWN T_FLOOD T_DELTA T_FAST T_COST T_DR T_AREA T_SPF
 %token  T_SET T_UNSET T_OPTION T_VERBOSE T_DATE
 
 /* Terminals which evaluate to some attribute value */
@@ -151,6 +158,10 @@ ShowTypeIP : /* empty: show all */                { SETC_FUNC0(cli_show_ip); }
            | T_ROUTE TMIorQ                       { HELP(HELP_SHOW_IP_ROUTE); }
            | T_TUNNEL                             { SETC_FUNC0(cli_show_ip_tunnel); }
            | T_TUNNEL TMIorQ                      { HELP(HELP_SHOW_IP_TUNNEL); }
+           | T_PUNT                               { SETC_FUNC0(cli_show_ip_punt); }
+           | T_ICMP                               { SETC_FUNC0(cli_show_ip_icmp); }
+           | T_ICMP TMIorQ                        { HELP(HELP_SHOW_IP_ICMP); }
+           | T_PUNT TMIorQ                        { HELP(HELP_SHOW_IP_PUNT); }
            | WrongOrQ                             { HELP(HELP_SHOW_IP); }
            ;
 
@@ -186,6 +197,7 @@ ManipCommand : T_IP ManipTypeIP
              ;
 
 ManipTypeIP : T_ARP ManipTypeIPARP
+            | T_ICMP ManipTypeIPICMP
             | T_INTF ManipTypeIPInterface
             | T_OSPF ManipTypeIPOSPF
             | T_ROUTE ManipTypeIPRoute
@@ -226,13 +238,54 @@ ManipTypeIPInterface : HelpOrQ                        { HELP(HELP_MANIP_IP_INTF)
                      | TAV_STR T_UP TMIorQ            { HELP(HELP_MANIP_IP_INTF_UP); }
                      | TAV_STR T_DOWN                 { SETC_INTF(cli_manip_ip_intf_down,$1); }
                      | TAV_STR T_DOWN TMIorQ          { HELP(HELP_MANIP_IP_INTF_DOWN); }
+                     | TAV_STR T_MTU WrongOrQ         { HELP(HELP_MANIP_IP_INTF_MTU); }
+                     | TAV_STR T_MTU TAV_INT          { SETC_INTF_INT(cli_manip_ip_intf_mtu,$1,$3); }
+                     | TAV_STR T_MTU TAV_INT TMIorQ   { HELP(HELP_MANIP_IP_INTF_MTU); }
                      ;
 
+ManipTypeIPICMP : WrongOrQ                               { HELP(HELP_MANIP_IP_ICMP);        }
+                | T_LIMIT WrongOrQ                       { HELP(HELP_MANIP_IP_ICMP_LIMIT);  }
+                | T_LIMIT TAV_INT WrongOrQ               { HELP(HELP_MANIP_IP_ICMP_LIMIT);  }
+                | T_LIMIT TAV_INT TAV_INT                { SETC_RATE(cli_manip_ip_icmp_limit,0,$2,$3); }
+                | T_LIMIT TAV_INT TAV_INT TMIorQ         { HELP(HELP_MANIP_IP_ICMP_LIMIT);  }
+                | T_SOURCE WrongOrQ                      { HELP(HELP_MANIP_IP_ICMP_SOURCE); }
+                | T_SOURCE TAV_INT WrongOrQ              { HELP(HELP_MANIP_IP_ICMP_SOURCE); }
+                | T_SOURCE TAV_INT TAV_INT WrongOrQ      { HELP(HELP_MANIP_IP_ICMP_SOURCE); }
+                | T_SOURCE TAV_INT TAV_INT TAV_INT       { SETC_RATE(cli_manip_ip_icmp_source,$2,$3,$4); }
+                | T_SOURCE TAV_INT TAV_INT TAV_INT TMIorQ { HELP(HELP_MANIP_IP_ICMP_SOURCE); }
+                ;
+
 ManipTypeIPOSPF : WrongOrQ                        { HELP(HELP_MANIP_IP_OSPF);           }
                 | T_UP                            { SETC_FUNC0(cli_manip_ip_ospf_up);   }
                 | T_UP TMIorQ                     { HELP(HELP_MANIP_IP_OSPF_UP);        }
                 | T_DOWN                          { SETC_FUNC0(cli_manip_ip_ospf_down); }
                 | T_DOWN TMIorQ                   { HELP(HELP_MANIP_IP_OSPF_DOWN);      }
+                | T_DELTA WrongOrQ                { HELP(HELP_MANIP_IP_OSPF_DELTA);     }
+                | T_DELTA T_UP                    { SETC_FUNC0(cli_manip_ip_ospf_delta_up);   }
+                | T_DELTA T_UP TMIorQ             { HELP(HELP_MANIP_IP_OSPF_DELTA);     }
+                | T_DELTA T_DOWN                  { SETC_FUNC0(cli_manip_ip_ospf_delta_down); }
+                | T_DELTA T_DOWN TMIorQ           { HELP(HELP_MANIP_IP_OSPF_DELTA);     }
+                | T_FAST WrongOrQ                 { HELP(HELP_MANIP_IP_OSPF_FAST);      }
+                | T_FAST TAV_STR WrongOrQ         { HELP(HELP_MANIP_IP_OSPF_FAST);      }
+                | T_FAST TAV_STR TAV_INT          { SETC_INTF_INT(cli_manip_ip_ospf_fast,$2,$3); }
+                | T_FAST TAV_STR TAV_INT TMIorQ   { HELP(HELP_MANIP_IP_OSPF_FAST);      }
+                | T_COST WrongOrQ                 { HELP(HELP_MANIP_IP_OSPF_COST);      }
+                | T_COST TAV_STR WrongOrQ         { HELP(HELP_MANIP_IP_OSPF_COST);      }
+                | T_COST TAV_STR TAV_INT          { SETC_INTF_INT(cli_manip_ip_ospf_cost,$2,$3); }
+                | T_COST TAV_STR TAV_INT TMIorQ   { HELP(HELP_MANIP_IP_OSPF_COST);      }
+                | T_DR WrongOrQ                   { HELP(HELP_MANIP_IP_OSPF_DR);        }
+                | T_DR TAV_STR WrongOrQ           { HELP(HELP_MANIP_IP_OSPF_DR);        }
+                | T_DR TAV_STR TAV_INT            { SETC_INTF_INT(cli_manip_ip_ospf_dr,$2,$3); }
+                | T_DR TAV_STR TAV_INT TMIorQ     { HELP(HELP_MANIP_IP_OSPF_DR);        }
+                | T_AREA WrongOrQ                 { HELP(HELP_MANIP_IP_OSPF_AREA);      }
+                | T_AREA TAV_STR WrongOrQ         { HELP(HELP_MANIP_IP_OSPF_AREA);      }
+                | T_AREA TAV_STR TAV_INT          { SETC_INTF_INT(cli_manip_ip_ospf_area,$2,$3); }
+                | T_AREA TAV_STR TAV_INT TMIorQ   { HELP(HELP_MANIP_IP_OSPF_AREA);      }
+                | T_SPF WrongOrQ                  { HELP(HELP_MANIP_IP_OSPF_SPF);       }
+                | T_SPF TAV_INT WrongOrQ          { HELP(HELP_MANIP_IP_OSPF_SPF);       }
+                | T_SPF TAV_INT TAV_INT WrongOrQ  { HELP(HELP_MANIP_IP_OSPF_SPF);       }
+                | T_SPF TAV_INT TAV_INT TAV_INT   { SETC_SPF(cli_manip_ip_ospf_spf,$2,$3,$4); }
+                | T_SPF TAV_INT TAV_INT TAV_INT TMIorQ { HELP(HELP_MANIP_IP_OSPF_SPF);  }
                 ;
 
 ManipTypeIPRoute : WrongOrQ                       { HELP(HELP_MANIP_IP_ROUTE); }
@@ -264,6 +317,7 @@ ManipTypeIPTunnel : WrongOrQ                      { HELP(HELP_MANIP_IP_TUNNEL);
                   | T_ADD TunnelAddOrQ
                   | T_DEL TunnelDelOrQ
                   | T_CHANGE TunnelChangeOrQ
+                  | T_MSS TunnelMSSOrQ
                   ;
 
 TunnelAddOrQ : HelpOrQ                               { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
@@ -273,6 +327,9 @@ TunnelAddOrQ : HelpOrQ                               { HELP(HELP_MANIP_IP_TUNNEL
              | TAV_STR T_MODE TAV_STR {ERR_REMOTE} error { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
              | TAV_STR T_MODE TAV_STR T_REMOTE {ERR_IP} error { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
              | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP { SETC_TUN_ADDCH(cli_manip_ip_tunnel_add, $1, $3, $5); }
+             | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP T_KEY {ERR_KEY} error { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
+             | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP T_KEY TAV_INT { SETC_TUN_ADDCH_KEY(cli_manip_ip_tunnel_add, $1, $3, $5, $7); }
+             | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP T_KEY TAV_INT TMIorQ { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
              | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP TMIorQ { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
              ;
 
@@ -289,9 +346,21 @@ TunnelChangeOrQ : HelpOrQ                               { HELP(HELP_MANIP_IP_TUN
                 | TAV_STR T_MODE TAV_STR {ERR_REMOTE} error { HELP(HELP_MANIP_IP_TUNNEL_CHANGE); }
                 | TAV_STR T_MODE TAV_STR T_REMOTE {ERR_IP} error { HELP(HELP_MANIP_IP_TUNNEL_CHANGE); }
                 | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP { SETC_TUN_ADDCH(cli_manip_ip_tunnel_change, $1, $3, $5); }
+                | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP T_KEY {ERR_KEY} error { HELP(HELP_MANIP_IP_TUNNEL_CHANGE); }
+                | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP T_KEY TAV_INT { SETC_TUN_ADDCH_KEY(cli_manip_ip_tunnel_change, $1, $3, $5, $7); }
+                | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP T_KEY TAV_INT TMIorQ { HELP(HELP_MANIP_IP_TUNNEL_CHANGE); }
                 | TAV_STR T_MODE TAV_STR T_REMOTE TAV_IP TMIorQ { HELP(HELP_MANIP_IP_TUNNEL_CHANGE); }
                 ;
 
+TunnelMSSOrQ : HelpOrQ                             { HELP(HELP_MANIP_IP_TUNNEL_MSS); }
+             | {ERR_INTF} error                    { HELP(HELP_MANIP_IP_TUNNEL_MSS); }
+             | TAV_STR WrongOrQ                    { HELP(HELP_MANIP_IP_TUNNEL_MSS); }
+             | TAV_STR T_UP                        { SETC_TUN(cli_manip_ip_tunnel_mss_up, $1); }
+             | TAV_STR T_UP TMIorQ                 { HELP(HELP_MANIP_IP_TUNNEL_MSS); }
+             | TAV_STR T_DOWN                      { SETC_TUN(cli_manip_ip_tunnel_mss_down, $1); }
+             | TAV_STR T_DOWN TMIorQ               { HELP(HELP_MANIP_IP_TUNNEL_MSS); }
+             ;
+
 ActionCommand : T_PING ActionPing
               | T_TRACE ActionTrace
               | ActionDate
@@ -342,6 +411,8 @@ ActionHelp : HelpOrQ                              { HELP(HELP_ACTION_HELP); }
            | HelpOrQ T_SHOW T_IP T_INTF           { HELP(HELP_SHOW_IP_INTF); }
            | HelpOrQ T_SHOW T_IP T_ROUTE          { HELP(HELP_SHOW_IP_ROUTE); }
            | HelpOrQ T_SHOW T_IP T_TUNNEL         { HELP(HELP_SHOW_IP_TUNNEL); }
+           | HelpOrQ T_SHOW T_IP T_PUNT           { HELP(HELP_SHOW_IP_PUNT); }
+           | HelpOrQ T_SHOW T_IP T_ICMP           { HELP(HELP_SHOW_IP_ICMP); }
            | HelpOrQ T_SHOW T_OPTION              { HELP(HELP_SHOW_OPT); }
            | HelpOrQ T_SHOW T_OPTION T_VERBOSE    { HELP(HELP_SHOW_OPT_VERBOSE); }
            | HelpOrQ T_SHOW T_OSPF                { HELP(HELP_SHOW_OSPF); }
@@ -359,9 +430,20 @@ ActionHelp : HelpOrQ                              { HELP(HELP_ACTION_HELP); }
            | HelpOrQ T_IP T_ARP T_PURGE           { HELP(HELP_MANIP_IP_ARP_PURGE_ALL); }
            | HelpOrQ T_IP T_ARP T_PURGE T_DYNAMIC { HELP(HELP_MANIP_IP_ARP_PURGE_DYN); }
            | HelpOrQ T_IP T_ARP T_PURGE T_STATIC  { HELP(HELP_MANIP_IP_ARP_PURGE_STA); }
+           | HelpOrQ T_IP T_ICMP                  { HELP(HELP_MANIP_IP_ICMP); }
+           | HelpOrQ T_IP T_ICMP T_LIMIT          { HELP(HELP_MANIP_IP_ICMP_LIMIT); }
+           | HelpOrQ T_IP T_ICMP T_SOURCE         { HELP(HELP_MANIP_IP_ICMP_SOURCE); }
            | HelpOrQ T_IP T_INTF                  { HELP(HELP_MANIP_IP_INTF); }
            | HelpOrQ T_IP T_INTF T_DOWN           { HELP(HELP_MANIP_IP_INTF_DOWN); }
            | HelpOrQ T_IP T_INTF T_UP             { HELP(HELP_MANIP_IP_INTF_UP); }
+           | HelpOrQ T_IP T_INTF T_MTU            { HELP(HELP_MANIP_IP_INTF_MTU); }
+           | HelpOrQ T_IP T_OSPF                  { HELP(HELP_MANIP_IP_OSPF); }
+           | HelpOrQ T_IP T_OSPF T_DELTA          { HELP(HELP_MANIP_IP_OSPF_DELTA); }
+           | HelpOrQ T_IP T_OSPF T_FAST           { HELP(HELP_MANIP_IP_OSPF_FAST); }
+           | HelpOrQ T_IP T_OSPF T_COST           { HELP(HELP_MANIP_IP_OSPF_COST); }
+           | HelpOrQ T_IP T_OSPF T_DR             { HELP(HELP_MANIP_IP_OSPF_DR); }
+           | HelpOrQ T_IP T_OSPF T_AREA           { HELP(HELP_MANIP_IP_OSPF_AREA); }
+           | HelpOrQ T_IP T_OSPF T_SPF            { HELP(HELP_MANIP_IP_OSPF_SPF); }
            | HelpOrQ T_IP T_ROUTE                 { HELP(HELP_MANIP_IP_ROUTE); }
            | HelpOrQ T_IP T_ROUTE T_ADD           { HELP(HELP_MANIP_IP_ROUTE_ADD); }
            | HelpOrQ T_IP T_ROUTE T_DEL           { HELP(HELP_MANIP_IP_ROUTE_DEL); }
@@ -372,6 +454,7 @@ ActionHelp : HelpOrQ                              { HELP(HELP_ACTION_HELP); }
            | HelpOrQ T_IP T_TUNNEL T_ADD          { HELP(HELP_MANIP_IP_TUNNEL_ADD); }
            | HelpOrQ T_IP T_TUNNEL T_DEL          { HELP(HELP_MANIP_IP_TUNNEL_DEL); }
            | HelpOrQ T_IP T_TUNNEL T_CHANGE       { HELP(HELP_MANIP_IP_TUNNEL_CHANGE); }
+           | HelpOrQ T_IP T_TUNNEL T_MSS          { HELP(HELP_MANIP_IP_TUNNEL_MSS); }
            | HelpOrQ T_DATE                       { HELP(HELP_ACTION_DATE); }
            | HelpOrQ T_EXIT                       { HELP(HELP_ACTION_EXIT); }
            | HelpOrQ T_PING                       { HELP(HELP_ACTION_PING); }
@@ -88,8 +88,13 @@ STRING            ({BEG_STRING}\")
 "route"      { return T_ROUTE;     }
 "tun"        { return T_TUNNEL;    }
 "tunnel"     { return T_TUNNEL;    }
+"punt"       { return T_PUNT;      }
+"icmp"       { return T_ICMP;      }
+"limit"      { return T_LIMIT;     }
+"source"     { return T_SOURCE;    }
 "mode"       { return T_MODE;      }
 "remote"     { return T_REMOTE;    }
+"key"        { return T_KEY;       }
 "intf"       { return T_INTF;      }
 "interface"  { return T_INTF;      }
 "arp"        { return T_ARP;       }
@@ -122,6 +127,14 @@ STRING            ({BEG_STRING}\")
 "verbose"    { return T_VERBOSE;   }
 "v"          { return T_VERBOSE;   }
 "flood"      { return T_FLOOD;     }
+"delta"      { return T_DELTA;     }
+"fast"       { return T_FAST;      }
+"cost"       { return T_COST;      }
+"dr"         { return T_DR;        }
+"area"       { return T_AREA;      }
+"spf"        { return T_SPF;       }
+"mtu"        { return T_MTU;       }
+"mss"        { return T_MSS;       }
 "-f"         { return T_FLOOD;     }
 
  /* ***************** Actions ****************** */
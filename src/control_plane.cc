@@ -12,16 +12,22 @@
 #include "interface.h"
 #include "interface_map.h"
 #include "ip_packet.h"
+#include "ip_reassembler.h"
 #include "ospf_constants.h"
 #include "ospf_packet.h"
 #include "ospf_router.h"
 #include "packet_buffer.h"
+#include "time_types.h"
 #include "tunnel.h"
 #include "tunnel_map.h"
 
 using std::string;
 
 
+// IP and TCP headers without options; an MTU less these is an MSS.
+static const size_t kTCPIPHeaderSize = 40;
+
+
 // Input to TCP stack.
 void sr_transport_input(uint8_t* packet);
 
@@ -32,7 +38,16 @@ ControlPlane::ControlPlane(const std::string& name)
       functor_(this),
       arp_cache_(ARPCache::New()),
       arp_queue_(ARPQueue::New()),
-      tunnel_map_(TunnelMap::New()) { }
+      tunnel_map_(TunnelMap::New()),
+      icmp_limiter_(ICMPRateLimiter::New()),
+      ip_ids_(IPIDGenerator::New()),
+      ip_reassembler_(IPReassembler::New()),
+      tunnel_encap_generation_(0),
+      arp_cache_reactor_(ARPCacheReactor::New(this)),
+      iface_map_reactor_(InterfaceMapReactor::New(this)),
+      rtable_reactor_(RoutingTableReactor::New(this)) {
+  arp_cache_reactor_->notifierIs(arp_cache_);
+}
 
 
 void ControlPlane::packetNew(Packet::Ptr pkt,
@@ -98,8 +113,13 @@ void ControlPlane::outputPacketNew(IPPacket::Ptr pkt) {
     return;
   }
 
+  // Same next hop selection as in the data plane; see
+  // DataPlane::PacketFunctor::operator()(IPPacket*, ...).
+  const RoutingTable::Entry::NextHop& next_hop =
+      r_entry->flowNextHop(pkt->flowHash());
+
   // Outgoing interface.
-  Interface::PtrConst out_iface = r_entry->interface();
+  Interface::PtrConst out_iface = next_hop.interface();
   DLOG << "  outgoing interface: " << out_iface->name();
 
   if (out_iface->type() == Interface::kVirtual) {
@@ -108,15 +128,8 @@ void ControlPlane::outputPacketNew(IPPacket::Ptr pkt) {
     return;
   }
 
-  // Fragment large datagrams.
-  if (pkt->len() > EthernetPacket::kMTU) {
-    DLOG << "  len: " << pkt->len() << "; fragmenting";
-    fragmentAndSend(pkt);
-    return;
-  }
-
   // Next hop IP address.
-  IPv4Addr next_hop_ip = r_entry->gateway();
+  IPv4Addr next_hop_ip = next_hop.gateway();
   if (next_hop_ip == 0u)
     next_hop_ip = pkt->dst();
   DLOG << "  next hop: " << next_hop_ip;
@@ -127,6 +140,8 @@ void ControlPlane::outputPacketNew(IPPacket::Ptr pkt) {
     ARPCache::Ptr cache = dp_->controlPlane()->arpCache();
     Fwk::ScopedLock<ARPCache> lock(cache);
     arp_entry = cache->entry(next_hop_ip);
+    if (arp_entry)
+      arp_entry->usedIs(true);
   }
   if (!arp_entry) {
     DLOG << "ARP Cache miss for " << string(next_hop_ip);
@@ -156,7 +171,7 @@ void ControlPlane::outputPacketNew(IPPacket::Ptr pkt) {
 
   // Send packet.
   DLOG << "Forwarding IP packet to " << string(next_hop_ip);
-  dp_->outputPacketNew(eth_pkt, out_iface);
+  outputFrameNew(eth_pkt, out_iface);
 }
 
 
@@ -195,13 +210,6 @@ void ControlPlane::outputRawPacketNew(Fwk::Ptr<IPPacket> pkt,
     return;
   }
 
-  // Fragment large datagrams.
-  if (pkt->len() > EthernetPacket::kMTU) {
-    DLOG << "  len: " << pkt->len() << "; fragmenting";
-    fragmentAndSend(pkt);
-    return;
-  }
-
   // Next hop IP address.
   if (next_hop_ip == 0u)
     next_hop_ip = pkt->dst();
@@ -229,7 +237,7 @@ void ControlPlane::outputRawPacketNew(Fwk::Ptr<IPPacket> pkt,
 
   // Send packet.
   DLOG << "Forwarding IP packet to " << string(next_hop_ip);
-  dp_->outputPacketNew(eth_pkt, out_iface);
+  outputFrameNew(eth_pkt, out_iface);
 }
 
 
@@ -248,6 +256,8 @@ void ControlPlane::dataPlaneIs(DataPlane::Ptr dp) {
   }
 
   routing_table_ = RoutingTable::New(iface_map);
+  rtable_reactor_->notifierIs(routing_table_);
+  iface_map_reactor_->notifierIs(iface_map);
 
   /* Initializing OSPF router. */
   ospf_router_ = OSPFRouter::New(rid, OSPF::kDefaultAreaID,
@@ -299,8 +309,11 @@ void ControlPlane::PacketFunctor::operator()(ARPPacket* const pkt,
     cache_entry = cp_->arpCache()->entry(sender_ip);
   }
   if (cache_entry) {
+    if (cache_entry->ethernetAddr() != sender_eth)
+      cp_->tunnelEncapsInvalidate();
     cache_entry->ethernetAddrIs(sender_eth);
     cache_entry->ageIs(0);
+    cache_entry->staleIs(false);
     merge_flag = true;
   }
 
@@ -377,31 +390,9 @@ void ControlPlane::PacketFunctor::operator()(GREPacket* const pkt,
                                              const Interface::PtrConst iface) {
   DLOG << "GREPacket dispatch in ControlPlane";
 
-  if (!pkt->valid()) {
-    DLOG << "  packet is invalid; dropping";
-    return;
-  }
-
-  IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
-
-  ILOG << "GRE in " << ip_pkt->dst() << " <- " << ip_pkt->src()
-       << " on " << iface->name();
-
-  // Do we have a tunnel with this remote?
-  Tunnel::Ptr tunnel;
-  {
-    TunnelMap::Ptr tun_map = cp_->tunnelMap();
-    Fwk::ScopedLock<TunnelMap> tun_map_lock(tun_map);
-    tunnel = tun_map->tunnelRemoteAddr(ip_pkt->src());
-    if (!tunnel) {
-      DLOG << "  no GRE tunnel to " << ip_pkt->src() << ", ignoring";
-      return;
-    }
-  }
-
-  // Simulate the packet coming from the tunnel's virtual interface.
-  Packet::Ptr payload_pkt = pkt->payload();
-  cp_->dataPlane()->packetNew(payload_pkt, tunnel->interface());
+  // GRE packets reach the control plane only when they were fragmented on
+  // the way; once reassembled, they are decapsulated like the others.
+  cp_->dataPlane()->packetNew(pkt, iface);
 }
 
 
@@ -439,6 +430,22 @@ void ControlPlane::PacketFunctor::operator()(IPPacket* const pkt,
     return;
   }
 
+  // Fragments are held until their datagram is complete, which is then
+  // dispatched in their place.
+  if (pkt->fragment()) {
+    IPPacket::Ptr datagram;
+    {
+      IPReassembler::Ptr reassembler = cp_->ip_reassembler_;
+      Fwk::ScopedLock<IPReassembler> lock(reassembler);
+      datagram = reassembler->fragmentNew(pkt, monotonicTimeMs());
+    }
+    if (datagram) {
+      DLOG << "  reassembled datagram of " << datagram->len() << " bytes";
+      (*datagram)(this, iface);
+    }
+    return;
+  }
+
   // We don't handle UDP packets at all.
   if (pkt->protocol() == IPPacket::kUDP) {
     DLOG << "  protocol is UDP";
@@ -476,40 +483,74 @@ void ControlPlane::PacketFunctor::operator()(UnknownPacket* const pkt,
 }
 
 
+void
+ControlPlane::arpRequestNew(const IPv4Addr& ip,
+                            Interface::PtrConst out_iface) {
+  if (arp_queue_->entry(ip) || arp_queue_->entries() >= ARPQueue::kMaxEntries)
+    return;
+
+  EthernetPacket::Ptr req_eth_pkt =
+      arpRequest(ip, out_iface, EthernetAddr::kBroadcast);
+  dp_->outputPacketNew(req_eth_pkt, out_iface);
+
+  ARPQueue::Entry::Ptr entry =
+      ARPQueue::Entry::New(ip, out_iface, req_eth_pkt);
+  arp_queue_->entryIs(entry);
+}
+
+
+void
+ControlPlane::arpProbeNew(const IPv4Addr& ip, const EthernetAddr& eth,
+                          Interface::PtrConst out_iface) {
+  EthernetPacket::Ptr req_eth_pkt = arpRequest(ip, out_iface, eth);
+  dp_->outputPacketNew(req_eth_pkt, out_iface);
+}
+
+
+EthernetPacket::Ptr
+ControlPlane::arpRequest(const IPv4Addr& ip,
+                         Interface::PtrConst out_iface,
+                         const EthernetAddr& dst) {
+  size_t pkt_len = EthernetPacket::kHeaderSize + ARPPacket::kHeaderSize;
+
+  PacketBuffer::Ptr buffer = PacketBuffer::New(pkt_len);
+  EthernetPacket::Ptr req_eth_pkt =
+      EthernetPacket::New(buffer, buffer->size() - pkt_len);
+
+  req_eth_pkt->srcIs(out_iface->mac());
+  req_eth_pkt->dstIs(dst);
+  req_eth_pkt->typeIs(EthernetPacket::kARP);
+
+  ARPPacket::Ptr arp_pkt = Ptr::st_cast<ARPPacket>(req_eth_pkt->payload());
+  arp_pkt->operationIs(ARPPacket::kRequest);
+  arp_pkt->hwTypeIs(ARPPacket::kEthernet);
+  arp_pkt->pTypeIs(ARPPacket::kIP);
+  arp_pkt->senderHWAddrIs(out_iface->mac());
+  arp_pkt->senderPAddrIs(out_iface->ip());
+  arp_pkt->targetHWAddrIs(EthernetAddr::kZero);
+  arp_pkt->targetPAddrIs(ip);
+
+  DLOG << "Sending ARP request for " << string(ip) << " to " << dst;
+  DLOG << "  ARP sender HW addr: " << arp_pkt->senderHWAddr();
+  DLOG << "  ARP sender P addr:  " << arp_pkt->senderPAddr();
+  DLOG << "  ARP target HW addr: " << arp_pkt->targetHWAddr();
+  DLOG << "  ARP target P addr:  " << arp_pkt->targetPAddr();
+
+  return req_eth_pkt;
+}
+
+
 void
 ControlPlane::sendARPRequestAndEnqueuePacket(IPv4Addr next_hop_ip,
                                              Interface::PtrConst out_iface,
                                              IPPacket::Ptr pkt) {
   // Do we already have a packet queue for this next hop in the arp queue?
+  // New next hops are only resolved while there is room for them.
   ARPQueue::Entry::Ptr entry = arp_queue_->entry(next_hop_ip);
-  if (entry == NULL) {
-    // No entry in the ARP queue yet.
-    size_t pkt_len = EthernetPacket::kHeaderSize + ARPPacket::kHeaderSize;
-
-    PacketBuffer::Ptr buffer = PacketBuffer::New(pkt_len);
+  if (entry == NULL && arp_queue_->entries() < ARPQueue::kMaxEntries) {
+    // No entry in the ARP queue yet. Send new ARP request immediately.
     EthernetPacket::Ptr req_eth_pkt =
-        EthernetPacket::New(buffer, buffer->size() - pkt_len);
-
-    req_eth_pkt->srcIs(out_iface->mac());
-    req_eth_pkt->dstIs(EthernetAddr::kBroadcast);
-    req_eth_pkt->typeIs(EthernetPacket::kARP);
-
-    ARPPacket::Ptr arp_pkt = Ptr::st_cast<ARPPacket>(req_eth_pkt->payload());
-    arp_pkt->operationIs(ARPPacket::kRequest);
-    arp_pkt->hwTypeIs(ARPPacket::kEthernet);
-    arp_pkt->pTypeIs(ARPPacket::kIP);
-    arp_pkt->senderHWAddrIs(out_iface->mac());
-    arp_pkt->senderPAddrIs(out_iface->ip());
-    arp_pkt->targetHWAddrIs(EthernetAddr::kZero);
-    arp_pkt->targetPAddrIs(next_hop_ip);
-
-    // Send new ARP request immediately.
-    DLOG << "Sending ARP request for " << string(next_hop_ip);
-    DLOG << "  ARP sender HW addr: " << arp_pkt->senderHWAddr();
-    DLOG << "  ARP sender P addr:  " << arp_pkt->senderPAddr();
-    DLOG << "  ARP target HW addr: " << arp_pkt->targetHWAddr();
-    DLOG << "  ARP target P addr:  " << arp_pkt->targetPAddr();
-
+        arpRequest(next_hop_ip, out_iface, EthernetAddr::kBroadcast);
     dp_->outputPacketNew(req_eth_pkt, out_iface);
 
     // Create an entry in the ARP queue for the next hop.
@@ -526,7 +567,8 @@ ControlPlane::sendARPRequestAndEnqueuePacket(IPv4Addr next_hop_ip,
       EthernetPacket::New(pkt->buffer(),
                           pkt->bufferOffset() - EthernetPacket::kHeaderSize);
   eth_pkt->typeIs(EthernetPacket::kIP);
-  entry->packetIs(eth_pkt);
+  if (!arp_queue_->packetNew(next_hop_ip, eth_pkt))
+    DLOG << "  ARP queue full; dropping packet";
 }
 
 
@@ -538,8 +580,11 @@ ControlPlane::updateARPCacheMapping(IPv4Addr ip_addr, EthernetAddr eth_addr) {
     entry = ARPCache::Entry::New(ip_addr, eth_addr);
     arp_cache_->entryIs(entry);
   } else {
+    if (entry->ethernetAddr() != eth_addr)
+      tunnelEncapsInvalidate();
     entry->ethernetAddrIs(eth_addr);
     entry->ageIs(0);
+    entry->staleIs(false);
   }
 }
 
@@ -561,7 +606,7 @@ ControlPlane::sendEnqueued(IPv4Addr ip_addr, EthernetAddr eth_addr) {
       eth_pkt->dstIs(eth_addr);
 
       DLOG << "  forwarding queued packet to " << ip_addr;
-      dp_->outputPacketNew(eth_pkt, out_iface);
+      outputFrameNew(eth_pkt, out_iface);
 
       pkt_wrapper = pkt_wrapper->next();
     }
@@ -591,8 +636,32 @@ void ControlPlane::sendICMPEchoReply(IPPacket::Ptr ip_pkt) {
 }
 
 
+bool ControlPlane::icmpErrorAllowed(IPPacket::PtrConst orig_pkt) {
+  Fwk::ScopedLock<ICMPRateLimiter> lock(icmp_limiter_);
+  return icmp_limiter_->onError(orig_pkt->src(), monotonicTimeMs());
+}
+
+
 void ControlPlane::sendICMPTTLExceeded(IPPacket::Ptr orig_pkt) {
   DLOG << "sending ICMP TTL Exceeded message to " << orig_pkt->src();
+  sendICMPTimeExceeded(ICMPPacket::kTTLExceeded, orig_pkt);
+}
+
+
+void
+ControlPlane::sendICMPReassemblyTimeExceeded(IPPacket::Ptr first_fragment) {
+  DLOG << "sending ICMP Reassembly Time Exceeded message to "
+       << first_fragment->src();
+  sendICMPTimeExceeded(ICMPPacket::kReassemblyExceeded, first_fragment);
+}
+
+
+void ControlPlane::sendICMPTimeExceeded(const ICMPPacket::Code code,
+                                        IPPacket::Ptr orig_pkt) {
+  if (!icmpErrorAllowed(orig_pkt)) {
+    DLOG << "  suppressed by rate limit";
+    return;
+  }
 
   // Send at most IP header + 8 bytes of data.
   const size_t max_data_len = orig_pkt->headerLen() + 8;
@@ -628,7 +697,7 @@ void ControlPlane::sendICMPTTLExceeded(IPPacket::Ptr orig_pkt) {
   ip_pkt->packetLengthIs(pkt_len);
   ip_pkt->diffServicesAre(0);
   ip_pkt->protocolIs(IPPacket::kICMP);
-  ip_pkt->identificationIs(0);
+  ip_pkt->identificationIs(ip_ids_->next(orig_pkt->src()));
   ip_pkt->flagsAre(IPPacket::kIP_DF);
   ip_pkt->fragmentOffsetIs(0);
   ip_pkt->srcIs(out_iface->ip());
@@ -641,7 +710,7 @@ void ControlPlane::sendICMPTTLExceeded(IPPacket::Ptr orig_pkt) {
   ICMPPacket::Ptr icmp_pkt = Ptr::st_cast<ICMPPacket>(ip_pkt->payload());
   ICMPTimeExceededPacket::Ptr icmp_te_pkt =
       ICMPTimeExceededPacket::New(icmp_pkt);
-  icmp_te_pkt->codeIs(ICMPPacket::kTTLExceeded);
+  icmp_te_pkt->codeIs(code);
   icmp_te_pkt->originalPacketIs(orig_pkt);
 
   // Recompute checksums in reverse order.
@@ -655,31 +724,41 @@ void ControlPlane::sendICMPTTLExceeded(IPPacket::Ptr orig_pkt) {
 
 void ControlPlane::sendICMPDestNetworkUnreach(IPPacket::PtrConst orig_pkt) {
   DLOG << "sending ICMP Destination Network Unreachable to " << orig_pkt->src();
-  sendICMPDestUnreach(ICMPPacket::kNetworkUnreach, orig_pkt);
+  sendICMPDestUnreach(ICMPPacket::kNetworkUnreach, orig_pkt, 0);
 }
 
 
 void ControlPlane::sendICMPDestHostUnreach(IPPacket::PtrConst orig_pkt) {
   DLOG << "sending ICMP Destination Host Unreachable to " << orig_pkt->src();
-  sendICMPDestUnreach(ICMPPacket::kHostUnreach, orig_pkt);
+  sendICMPDestUnreach(ICMPPacket::kHostUnreach, orig_pkt, 0);
 }
 
 
 void ControlPlane::sendICMPDestProtoUnreach(IPPacket::PtrConst orig_pkt) {
   DLOG << "sending ICMP Destination Proto Unreachable to " << orig_pkt->src();
-  sendICMPDestUnreach(ICMPPacket::kProtoUnreach, orig_pkt);
+  sendICMPDestUnreach(ICMPPacket::kProtoUnreach, orig_pkt, 0);
 }
 
 
 void
-ControlPlane::sendICMPDestUnreachFragRequired(IPPacket::PtrConst orig_pkt) {
-  DLOG << "sending ICMP Fragmentation Required to " << orig_pkt->src();
-  sendICMPDestUnreach(ICMPPacket::kFragRequired, orig_pkt);
+ControlPlane::sendICMPDestUnreachFragRequired(IPPacket::PtrConst orig_pkt,
+                                              const uint16_t next_hop_mtu) {
+  DLOG << "sending ICMP Fragmentation Required to " << orig_pkt->src()
+       << " (next-hop MTU " << next_hop_mtu << ")";
+  sendICMPDestUnreach(ICMPPacket::kFragRequired, orig_pkt, next_hop_mtu);
 }
 
 
 void ControlPlane::sendICMPDestUnreach(const ICMPPacket::Code code,
-                                       IPPacket::PtrConst orig_pkt) {
+                                       IPPacket::PtrConst orig_pkt,
+                                       const uint16_t next_hop_mtu) {
+  // Errors over the rate limit are dropped before any work is done to build
+  // them.
+  if (!icmpErrorAllowed(orig_pkt)) {
+    DLOG << "  suppressed by rate limit";
+    return;
+  }
+
   // Send at most IP header + 8 bytes of data.
   const size_t max_data_len = orig_pkt->headerLen() + 8;
   const size_t data_len =
@@ -714,7 +793,7 @@ void ControlPlane::sendICMPDestUnreach(const ICMPPacket::Code code,
   ip_pkt->packetLengthIs(pkt_len);
   ip_pkt->diffServicesAre(0);
   ip_pkt->protocolIs(IPPacket::kICMP);
-  ip_pkt->identificationIs(0);
+  ip_pkt->identificationIs(ip_ids_->next(orig_pkt->src()));
   ip_pkt->flagsAre(IPPacket::kIP_DF);
   ip_pkt->fragmentOffsetIs(0);
   ip_pkt->srcIs(out_iface->ip());
@@ -727,6 +806,8 @@ void ControlPlane::sendICMPDestUnreach(const ICMPPacket::Code code,
       ICMPDestUnreachablePacket::New(icmp_pkt);
   icmp_du_pkt->codeIs(code);
   icmp_du_pkt->originalPacketIs(orig_pkt);
+  if (code == ICMPPacket::kFragRequired)
+    icmp_du_pkt->nextHopMTUIs(next_hop_mtu);
 
   // Recompute checksums in reverse order.
   icmp_du_pkt->checksumReset();
@@ -743,6 +824,9 @@ void ControlPlane::encapsulateAndOutputPacket(IPPacket::Ptr pkt,
 
   // Look up the associated tunnel.
   Tunnel::Ptr tunnel;
+  Tunnel::Encap::PtrConst encap;
+  bool keyed;
+  uint32_t key;
   {
     Fwk::ScopedLock<TunnelMap> tunnel_map_lock(tunnel_map_);
     tunnel = tunnel_map_->tunnel(out_iface->name());
@@ -750,6 +834,9 @@ void ControlPlane::encapsulateAndOutputPacket(IPPacket::Ptr pkt,
       ELOG << "output interface is virtual but no associated tunnel found";
       return;
     }
+    encap = tunnel->encap();
+    keyed = tunnel->keyed();
+    key = tunnel->key();
   }
 
   DLOG << "  tunnel remote: " << tunnel->remote();
@@ -772,16 +859,31 @@ void ControlPlane::encapsulateAndOutputPacket(IPPacket::Ptr pkt,
     return;
   }
 
-  // Add GRE header.
-  pkt->buffer()->minimumSizeIs(pkt->len() +
-                               GREPacket::kHeaderSizeWithoutChecksum);
+  const size_t mtu = tunnel->mtu(tunnel_r_entry->interface());
+
+  // Lower the MSS of TCP connections through the tunnel, so that their
+  // segments need neither fragmentation nor path MTU discovery.
+  if (tunnel->mssClamp() && pkt->tcpMSSClamp(mtu - kTCPIPHeaderSize))
+    DLOG << "  clamped TCP MSS to " << mtu - kTCPIPHeaderSize;
+
+  if (pkt->len() > mtu && (pkt->flags() & IPPacket::kIP_DF)) {
+    DLOG << "  len: " << pkt->len() << " exceeds tunnel MTU " << mtu;
+    sendICMPDestUnreachFragRequired(pkt, mtu);
+    return;
+  }
+
+  // Add GRE header, with the tunnel's key if it has one.
+  const size_t gre_header_len =
+      GREPacket::kHeaderSizeWithoutChecksum + (keyed ? sizeof(key) : 0);
+  pkt->buffer()->minimumSizeIs(pkt->len() + gre_header_len);
   GREPacket::Ptr gre_pkt =
       GREPacket::GREPacketNew(pkt->buffer(),
-                              pkt->bufferOffset() -
-                              GREPacket::kHeaderSizeWithoutChecksum);
+                              pkt->bufferOffset() - gre_header_len);
 
   // Hardware does not support checksums on GRE, so don't bother setting them.
   gre_pkt->checksumPresentIs(false);
+  gre_pkt->keyPresentIs(keyed);
+  gre_pkt->keyIs(key);
 
   // Set all other fields, regardless of checksum status. Setting fields that
   // are not present are nil-potent operations.
@@ -799,7 +901,7 @@ void ControlPlane::encapsulateAndOutputPacket(IPPacket::Ptr pkt,
   ip_pkt->packetLengthIs(ip_pkt->len());
   ip_pkt->diffServicesAre(0);
   ip_pkt->protocolIs(IPPacket::kGRE);
-  ip_pkt->identificationIs(0);
+  ip_pkt->identificationIs(ip_ids_->next(tunnel->remote()));
   ip_pkt->flagsAre(0);
   ip_pkt->fragmentOffsetIs(0);
   ip_pkt->srcIs(tunnel_r_entry->interface()->ip());
@@ -807,70 +909,140 @@ void ControlPlane::encapsulateAndOutputPacket(IPPacket::Ptr pkt,
   ip_pkt->ttlIs(IPPacket::kDefaultTTL);
   ip_pkt->checksumReset();
 
+  // Let the data plane encapsulate the next packets itself.
+  if (!encap || encap->generation() != tunnelEncapGeneration())
+    tunnelEncapUpdate(tunnel, ip_pkt, keyed, key);
+
   // Output new packet.
   outputPacketNew(ip_pkt);
 }
 
 
-void ControlPlane::fragmentAndSend(IPPacket::Ptr pkt) {
-  if (pkt->flags() & IPPacket::kIP_DF) {
-    WLOG << "Tried to fragment a packet with Don't Fragment bit set; ignoring";
+void ControlPlane::tunnelEncapUpdate(Tunnel::Ptr tunnel,
+                                     IPPacket::PtrConst outer_pkt,
+                                     const bool keyed,
+                                     const uint32_t key) {
+  // A change made while the headers are built makes them stale at once.
+  const uint32_t generation = tunnelEncapGeneration();
+
+  // Same next hop selection as in outputPacketNew().
+  RoutingTable::Entry::Ptr r_entry;
+  {
+    Fwk::ScopedLock<RoutingTable> lock(routing_table_);
+    r_entry = routing_table_->lpm(outer_pkt->dst());
+  }
+  if (!r_entry)
     return;
+
+  const RoutingTable::Entry::NextHop& next_hop =
+      r_entry->flowNextHop(outer_pkt->flowHash());
+  Interface::PtrConst out_iface = next_hop.interface();
+  if (out_iface->type() != Interface::kHardware)
+    return;  // tunnels over tunnels are not templated
+
+  IPv4Addr next_hop_ip = next_hop.gateway();
+  if (next_hop_ip == 0u)
+    next_hop_ip = outer_pkt->dst();
+
+  // Until the next hop is resolved, packets take the ARP queue.
+  ARPCache::Entry::Ptr arp_entry;
+  {
+    Fwk::ScopedLock<ARPCache> lock(arp_cache_);
+    arp_entry = arp_cache_->entry(next_hop_ip);
   }
+  if (!arp_entry)
+    return;
+
+  Tunnel::Encap::Ptr encap =
+      Tunnel::Encap::New(out_iface, next_hop_ip, arp_entry->ethernetAddr(),
+                         outer_pkt->src(), outer_pkt->dst(), keyed, key,
+                         generation);
 
-  // Must be a multiple of 8.
-  const size_t max_payload_size = 1480;
-  const uint16_t cksum = pkt->checksum();
-
-  size_t bytes_left = pkt->len() - IPPacket::kHeaderSize;
-  size_t fragment_offset = 0;  // in 8-byte blocks
-  while (bytes_left > 0) {
-    // Calculate size of this fragment's payload.
-    size_t fragment_payload_size;
-    bool last_fragment;
-    if (bytes_left > max_payload_size) {
-      fragment_payload_size = max_payload_size;
-      last_fragment = false;
-    } else {
-      fragment_payload_size = bytes_left;
-      last_fragment = true;
+  DLOG << "  built outer headers for tunnel " << tunnel->name()
+       << " via " << next_hop_ip << " (" << out_iface->name() << ")";
+
+  Fwk::ScopedLock<TunnelMap> lock(tunnel_map_);
+  if (tunnel->remote() == outer_pkt->dst() && tunnel->keyed() == keyed &&
+      tunnel->key() == key) {
+    tunnel->encapIs(encap);
+  }
+}
+
+
+void ControlPlane::outputFrameNew(EthernetPacket::Ptr eth_pkt,
+                                  Interface::PtrConst out_iface) {
+  if (eth_pkt->type() == EthernetPacket::kIP) {
+    IPPacket::Ptr pkt = Ptr::st_cast<IPPacket>(eth_pkt->payload());
+    if (pkt->len() > out_iface->mtu()) {
+      DLOG << "  len: " << pkt->len() << "; fragmenting";
+      fragmentAndSend(pkt, eth_pkt, out_iface);
+      return;
     }
+  }
 
-    // Total size of fragment.
-    const size_t fragment_size = IPPacket::kHeaderSize + fragment_payload_size;
+  dp_->outputPacketNew(eth_pkt, out_iface);
+}
+
+
+void ControlPlane::fragmentAndSend(IPPacket::Ptr pkt,
+                                   EthernetPacket::PtrConst eth_pkt,
+                                   Interface::PtrConst out_iface) {
+  if (pkt->flags() & IPPacket::kIP_DF) {
+    // Path MTU discovery: the source lowers its estimate of the path MTU.
+    sendICMPDestUnreachFragRequired(pkt, out_iface->mtu());
+    return;
+  }
+
+  dp_->fragmentedOutput(pkt, eth_pkt, out_iface);
+}
 
-    // Create a new buffer and IP packet for new fragment.
-    PacketBuffer::Ptr buffer = PacketBuffer::New(fragment_size);
-    IPPacket::Ptr fragment =
-        IPPacket::New(buffer, buffer->size() - fragment_size);
 
-    // Copy fields into fragment.
-    fragment->versionIs(4);
-    fragment->headerLengthIs(IPPacket::kHeaderSize / 4);  // words
-    fragment->packetLengthIs(fragment->len());
-    fragment->diffServicesAre(pkt->diffServices());
-    fragment->protocolIs(pkt->protocol());
-    fragment->srcIs(pkt->src());
-    fragment->dstIs(pkt->dst());
-    fragment->ttlIs(pkt->ttl());
+/* ControlPlane reactors */
 
-    // Set fragmentation fields.
-    fragment->identificationIs(cksum);  // use cksum as identifier
-    fragment->flagsAre(last_fragment ? 0 : IPPacket::kIP_MF);
-    fragment->fragmentOffsetIs(fragment_offset);
+void
+ControlPlane::ARPCacheReactor::onEntry(ARPCache::Ptr cache,
+                                       ARPCache::Entry::Ptr entry) {
+  cp_->tunnelEncapsInvalidate();
+}
 
-    // Copy portion of data.
-    memcpy(fragment->data() + IPPacket::kHeaderSize,
-           pkt->data() + IPPacket::kHeaderSize + (fragment_offset * 8),
-           fragment_payload_size);
 
-    // Update checksum.
-    fragment->checksumReset();
+void
+ControlPlane::ARPCacheReactor::onEntryDel(ARPCache::Ptr cache,
+                                          ARPCache::Entry::Ptr entry) {
+  cp_->tunnelEncapsInvalidate();
+}
 
-    // Send fragment.
-    outputPacketNew(fragment);
 
-    bytes_left -= fragment_payload_size;
-    fragment_offset += fragment_payload_size / 8;
-  }
+void
+ControlPlane::InterfaceMapReactor::onInterfaceIP(InterfaceMap::Ptr map,
+                                                 Interface::Ptr iface) {
+  cp_->tunnelEncapsInvalidate();
+}
+
+
+void
+ControlPlane::InterfaceMapReactor::onInterfaceMAC(InterfaceMap::Ptr map,
+                                                  Interface::Ptr iface) {
+  cp_->tunnelEncapsInvalidate();
+}
+
+
+void
+ControlPlane::InterfaceMapReactor::onInterfaceEnabled(InterfaceMap::Ptr map,
+                                                      Interface::Ptr iface) {
+  cp_->tunnelEncapsInvalidate();
+}
+
+
+void
+ControlPlane::RoutingTableReactor::onEntry(RoutingTable::Ptr rtable,
+                                           RoutingTable::Entry::Ptr entry) {
+  cp_->tunnelEncapsInvalidate();
+}
+
+
+void
+ControlPlane::RoutingTableReactor::onEntryDel(RoutingTable::Ptr rtable,
+                                              RoutingTable::Entry::Ptr entry) {
+  cp_->tunnelEncapsInvalidate();
 }
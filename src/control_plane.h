@@ -1,17 +1,22 @@
 #ifndef CONTROL_PLANE_H_
 #define CONTROL_PLANE_H_
 
+#include <inttypes.h>
 #include <string>
 
 #include "arp_cache.h"
 #include "arp_queue.h"
 #include "data_plane.h"
 #include "icmp_packet.h"
+#include "icmp_rate_limiter.h"
+#include "fwk/atomic.h"
 #include "fwk/log.h"
 #include "fwk/named_interface.h"
 #include "fwk/ptr.h"
 #include "interface.h"
 #include "interface_map.h"
+#include "ip_id_generator.h"
+#include "ip_reassembler.h"
 #include "packet.h"
 #include "routing_table.h"
 #include "tunnel.h"
@@ -56,6 +61,16 @@ class ControlPlane : public Fwk::NamedInterface {
   ARPCache::Ptr arpCache() const { return arp_cache_; }
   ARPQueue::Ptr arpQueue() const { return arp_queue_; }
 
+  // Resolves 'ip' on 'out_iface' ahead of any packet to it: broadcasts an ARP
+  // request and adds an entry without packets to the ARP queue, so that the
+  // request is retried. Does nothing if 'ip' is already being resolved.
+  void arpRequestNew(const IPv4Addr& ip, Interface::PtrConst out_iface);
+
+  // Sends a unicast ARP request for 'ip' to 'eth', the address it is cached
+  // with, so that the reply refreshes the cache entry before it expires.
+  void arpProbeNew(const IPv4Addr& ip, const EthernetAddr& eth,
+                   Interface::PtrConst out_iface);
+
   RoutingTable::Ptr routingTable() const { return routing_table_; }
 
   Fwk::Ptr<const OSPFRouter> ospfRouter() const;
@@ -64,10 +79,81 @@ class ControlPlane : public Fwk::NamedInterface {
   // Returns the associated TunnelMap.
   TunnelMap::Ptr tunnelMap() const { return tunnel_map_; }
 
+  // Returns the limiter of ICMP error messages sent by the router.
+  ICMPRateLimiter::Ptr icmpRateLimiter() const { return icmp_limiter_; }
+
+  // Returns the reassembler of fragmented datagrams sent to the router.
+  IPReassembler::Ptr ipReassembler() const { return ip_reassembler_; }
+
+  // Returns the generator of the identification of IP datagrams originated
+  // by the router.
+  IPIDGenerator::Ptr ipIDGenerator() const { return ip_ids_; }
+
+  // Returns the current generation of the outer headers of tunnels. It is
+  // advanced whenever a route, an ARP entry or an interface changes, which
+  // makes the headers built before it stale (see Tunnel::Encap).
+  uint32_t tunnelEncapGeneration() const {
+    return tunnel_encap_generation_.value();
+  }
+
  protected:
   ControlPlane(const std::string& name);
 
  private:
+  // Reactors that make the outer headers of tunnels stale when what they
+  // were built from changes.
+  class ARPCacheReactor : public ARPCache::Notifiee {
+   public:
+    typedef Fwk::Ptr<const ARPCacheReactor> PtrConst;
+    typedef Fwk::Ptr<ARPCacheReactor> Ptr;
+
+    static Ptr New(ControlPlane* cp) { return new ARPCacheReactor(cp); }
+
+    virtual void onEntry(ARPCache::Ptr cache, ARPCache::Entry::Ptr entry);
+    virtual void onEntryDel(ARPCache::Ptr cache, ARPCache::Entry::Ptr entry);
+
+   protected:
+    ARPCacheReactor(ControlPlane* cp) : cp_(cp) { }
+
+    ControlPlane* cp_;
+  };
+
+  class InterfaceMapReactor : public InterfaceMap::Notifiee {
+   public:
+    typedef Fwk::Ptr<const InterfaceMapReactor> PtrConst;
+    typedef Fwk::Ptr<InterfaceMapReactor> Ptr;
+
+    static Ptr New(ControlPlane* cp) { return new InterfaceMapReactor(cp); }
+
+    virtual void onInterfaceIP(InterfaceMap::Ptr map, Interface::Ptr iface);
+    virtual void onInterfaceMAC(InterfaceMap::Ptr map, Interface::Ptr iface);
+    virtual void onInterfaceEnabled(InterfaceMap::Ptr map,
+                                    Interface::Ptr iface);
+
+   protected:
+    InterfaceMapReactor(ControlPlane* cp) : cp_(cp) { }
+
+    ControlPlane* cp_;
+  };
+
+  class RoutingTableReactor : public RoutingTable::Notifiee {
+   public:
+    typedef Fwk::Ptr<const RoutingTableReactor> PtrConst;
+    typedef Fwk::Ptr<RoutingTableReactor> Ptr;
+
+    static Ptr New(ControlPlane* cp) { return new RoutingTableReactor(cp); }
+
+    virtual void onEntry(RoutingTable::Ptr rtable,
+                         RoutingTable::Entry::Ptr entry);
+    virtual void onEntryDel(RoutingTable::Ptr rtable,
+                            RoutingTable::Entry::Ptr entry);
+
+   protected:
+    RoutingTableReactor(ControlPlane* cp) : cp_(cp) { }
+
+    ControlPlane* cp_;
+  };
+
   class PacketFunctor : public Packet::Functor {
    public:
     PacketFunctor(ControlPlane* cp);
@@ -85,6 +171,11 @@ class ControlPlane : public Fwk::NamedInterface {
     Fwk::Log::Ptr log_;
   };
 
+  // Returns an ARP request for 'ip' from 'out_iface', sent to 'dst'.
+  Fwk::Ptr<EthernetPacket> arpRequest(const IPv4Addr& ip,
+                                      Interface::PtrConst out_iface,
+                                      const EthernetAddr& dst);
+
   void sendARPRequestAndEnqueuePacket(IPv4Addr next_hop_ip,
                                       Interface::PtrConst out_iface,
                                       IPPacket::Ptr pkt);
@@ -92,17 +183,48 @@ class ControlPlane : public Fwk::NamedInterface {
   void updateARPCacheMapping(IPv4Addr ip_addr, EthernetAddr eth_addr);
 
   void sendICMPEchoReply(IPPacket::Ptr echo_request);
+
+  // Returns false if an ICMP error in response to ORIG_PKT would exceed the
+  // rate limits and must not be sent.
+  bool icmpErrorAllowed(IPPacket::PtrConst orig_pkt);
+
   void sendICMPTTLExceeded(IPPacket::Ptr orig_pkt);
+  // Tells the source of FIRST_FRAGMENT that its datagram timed out before
+  // all of its fragments arrived.
+  void sendICMPReassemblyTimeExceeded(IPPacket::Ptr first_fragment);
+  void sendICMPTimeExceeded(ICMPPacket::Code code, IPPacket::Ptr orig_pkt);
   void sendICMPDestNetworkUnreach(IPPacket::PtrConst orig_pkt);
   void sendICMPDestHostUnreach(IPPacket::PtrConst orig_pkt);
   void sendICMPDestProtoUnreach(IPPacket::PtrConst orig_pkt);
-  void sendICMPDestUnreachFragRequired(IPPacket::PtrConst orig_pkt);
-  void sendICMPDestUnreach(ICMPPacket::Code code, IPPacket::PtrConst orig_pkt);
+  // Tells the source of ORIG_PKT, which may not be fragmented, that it
+  // exceeds the MTU of the next hop, NEXT_HOP_MTU (RFC 1191).
+  void sendICMPDestUnreachFragRequired(IPPacket::PtrConst orig_pkt,
+                                       uint16_t next_hop_mtu);
+  void sendICMPDestUnreach(ICMPPacket::Code code, IPPacket::PtrConst orig_pkt,
+                           uint16_t next_hop_mtu);
   void encapsulateAndOutputPacket(IPPacket::Ptr pkt,
                                   Interface::PtrConst out_iface);
 
-  // Fragments an IP packet and sends the fragments individually.
-  void fragmentAndSend(IPPacket::Ptr pkt);
+  // Builds the outer headers of TUNNEL for the data plane from OUTER_PKT,
+  // the encapsulation of a packet through it with the key the tunnel had
+  // (KEYED, KEY), if its next hop is resolved.
+  void tunnelEncapUpdate(Tunnel::Ptr tunnel, IPPacket::PtrConst outer_pkt,
+                         bool keyed, uint32_t key);
+
+  // Makes the outer headers of all tunnels stale.
+  void tunnelEncapsInvalidate() { ++tunnel_encap_generation_; }
+
+  // Sends ETH_PKT out of OUT_IFACE. IP datagrams larger than the MTU of
+  // OUT_IFACE are fragmented.
+  void outputFrameNew(Fwk::Ptr<EthernetPacket> eth_pkt,
+                      Interface::PtrConst out_iface);
+
+  // Sends IP datagram PKT, framed by ETH_PKT, out of OUT_IFACE in fragments
+  // that fit its MTU, unless PKT may not be fragmented; its source is then
+  // told the MTU instead. Fragments are built by the DataPlane.
+  void fragmentAndSend(IPPacket::Ptr pkt,
+                       Fwk::Ptr<EthernetPacket const> eth_pkt,
+                       Interface::PtrConst out_iface);
 
   Fwk::Log::Ptr log_;
   PacketFunctor functor_;
@@ -111,6 +233,13 @@ class ControlPlane : public Fwk::NamedInterface {
   RoutingTable::Ptr routing_table_;
   Fwk::Ptr<OSPFRouter> ospf_router_;
   TunnelMap::Ptr tunnel_map_;
+  ICMPRateLimiter::Ptr icmp_limiter_;
+  IPIDGenerator::Ptr ip_ids_;
+  IPReassembler::Ptr ip_reassembler_;
+  Fwk::AtomicUInt32 tunnel_encap_generation_;
+  ARPCacheReactor::Ptr arp_cache_reactor_;
+  InterfaceMapReactor::Ptr iface_map_reactor_;
+  RoutingTableReactor::Ptr rtable_reactor_;
   DataPlane::Ptr dp_;
 
   // Operations disallowed.
@@ -118,6 +247,7 @@ class ControlPlane : public Fwk::NamedInterface {
   void operator=(const ControlPlane&);
 
   friend class ARPQueueDaemon;
+  friend class IPReassemblyDaemon;
 };
 
 #endif
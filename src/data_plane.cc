@@ -1,5 +1,8 @@
 #include "data_plane.h"
 
+#include <sys/uio.h>
+
+#include <algorithm>
 #include <cstring>
 #include <string>
 
@@ -10,16 +13,24 @@
 #include "arp_packet.h"
 #include "control_plane.h"
 #include "ethernet_packet.h"
+#include "gre_packet.h"
 #include "icmp_packet.h"
 #include "interface.h"
 #include "ip_packet.h"
 #include "ospf_packet.h"
 #include "packet_buffer.h"
 #include "sr_integration.h"
+#include "tunnel.h"
+#include "tunnel_map.h"
 
+using std::min;
 using std::string;
 
 
+// IP and TCP headers without options; an MTU less these is an MSS.
+static const size_t kTCPIPHeaderSize = 40;
+
+
 DataPlane::DataPlane(const std::string& name,
                      struct sr_instance *sr,
                      ARPCache::Ptr arp_cache)
@@ -29,6 +40,7 @@ DataPlane::DataPlane(const std::string& name,
       routing_table_(NULL),
       arp_cache_(arp_cache),
       cp_(NULL),
+      punt_queue_(PuntQueue::New()),
       sr_(sr),
       functor_(this) { }
 
@@ -84,11 +96,73 @@ void DataPlane::outputPacketNew(EthernetPacket::PtrConst pkt,
 }
 
 
+void DataPlane::outputGatheredNew(const struct iovec* const iov,
+                                  const int iovcnt,
+                                  const Interface::PtrConst iface) {
+  DLOG << "outputGatheredNew() in DataPlane";
+  DLOG << "  iface: " << iface->name();
+  DLOG << "  segments: " << iovcnt;
+
+  if (!iface->enabled()) {
+    WLOG << "  output interface is disabled; ignoring";
+    return;
+  }
+
+  if (iface->type() != Interface::kHardware) {
+    ELOG << "  DataPlane output on non-hardware interface?";
+    return;
+  }
+
+  struct sr_instance* sr = instance();
+  sr_integ_low_level_outputv(sr, iov, iovcnt, iface->name().c_str());
+}
+
+
 InterfaceMap::Ptr DataPlane::interfaceMap() const {
   return iface_map_;
 }
 
 
+size_t DataPlane::puntedPacketsDispatch(const size_t max) {
+  size_t dispatched = 0;
+  while (dispatched < max) {
+    // The ControlPlane is not run with the queue locked.
+    PuntQueue::Entry entry;
+    {
+      Fwk::ScopedLock<PuntQueue> lock(punt_queue_);
+      entry = punt_queue_->next();
+    }
+    if (!entry.packet())
+      break;
+
+    if (entry.direction() == PuntQueue::kInput) {
+      cp_->packetNew(entry.packet(), entry.interface());
+    } else {
+      IPPacket::Ptr pkt = Ptr::st_cast<IPPacket>(entry.packet());
+      cp_->outputPacketNew(pkt);
+    }
+    ++dispatched;
+  }
+
+  return dispatched;
+}
+
+
+void DataPlane::punt(const PuntQueue::Class c,
+                     const Packet::Ptr pkt,
+                     const Interface::PtrConst iface,
+                     const PuntQueue::Direction direction) {
+  PuntQueue::Entry entry(pkt, iface, direction);
+  bool queued;
+  {
+    Fwk::ScopedLock<PuntQueue> lock(punt_queue_);
+    queued = punt_queue_->onPacket(c, entry, monotonicTimeMs());
+  }
+  if (!queued)
+    DLOG << "  punt queue dropped " << PuntQueue::className(c) << " packet";
+}
+
+
 DataPlane::PacketFunctor::PacketFunctor(DataPlane* const dp)
     : dp_(dp), log_(dp->log_) { }
 
@@ -99,7 +173,7 @@ void DataPlane::PacketFunctor::operator()(ARPPacket* const pkt,
 
   // Dispatch ARP packets to control plane.
   EthernetPacket::Ptr eth_pkt = (EthernetPacket*)(pkt->enclosingPacket().ptr());
-  dp_->controlPlane()->packetNew(eth_pkt, iface);
+  dp_->punt(PuntQueue::kARP, eth_pkt, iface, PuntQueue::kInput);
 }
 
 
@@ -166,6 +240,44 @@ void DataPlane::PacketFunctor::operator()(EthernetPacket* pkt,
 void DataPlane::PacketFunctor::operator()(GREPacket* const pkt,
                                           const Interface::PtrConst iface) {
   DLOG << "GREPacket dispatch in DataPlane";
+
+  if (!pkt->valid()) {
+    DLOG << "  packet is invalid; dropping";
+    return;
+  }
+
+  IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
+
+  DLOG << "GRE in " << ip_pkt->dst() << " <- " << ip_pkt->src()
+       << " on " << iface->name();
+
+  // Do we have a tunnel with this remote and key?
+  Tunnel::Ptr tunnel;
+  {
+    TunnelMap::Ptr tun_map = dp_->controlPlane()->tunnelMap();
+    Fwk::ScopedLock<TunnelMap> tun_map_lock(tun_map);
+    if (pkt->keyPresent())
+      tunnel = tun_map->tunnelRemoteAddr(ip_pkt->src(), pkt->key());
+    else
+      tunnel = tun_map->tunnelRemoteAddr(ip_pkt->src());
+    if (!tunnel) {
+      DLOG << "  no GRE tunnel to " << ip_pkt->src() << ", ignoring";
+      return;
+    }
+  }
+
+  // Simulate the packet coming from the tunnel's virtual interface.
+  Packet::Ptr payload_pkt = pkt->payload();
+
+  // SYNs leaving the tunnel advertise the MSS of the other end of the
+  // connection, which sends through the tunnel.
+  if (tunnel->mssClamp() && pkt->protocol() == EthernetPacket::kIP) {
+    IPPacket::Ptr inner_pkt = Ptr::st_cast<IPPacket>(payload_pkt);
+    const size_t mtu = tunnel->mtu(iface);
+    if (inner_pkt->tcpMSSClamp(mtu - kTCPIPHeaderSize))
+      DLOG << "  clamped TCP MSS to " << mtu - kTCPIPHeaderSize;
+  }
+  dp_->packetNew(payload_pkt, tunnel->interface());
 }
 
 
@@ -180,6 +292,56 @@ void DataPlane::PacketFunctor::operator()(ICMPPacket* const pkt,
 
   DLOG << "  type: " << pkt->type() << " (" << pkt->typeName() << ")";
   DLOG << "  code: " << (uint32_t)pkt->code();
+
+  IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
+  if (pkt->type() != ICMPPacket::kEchoRequest) {
+    dp_->punt(PuntQueue::kException, ip_pkt, iface, PuntQueue::kInput);
+    return;
+  }
+
+  // Requests that came out of a tunnel have no Ethernet frame to answer in;
+  // the ControlPlane routes their replies.
+  if (iface->type() == Interface::kVirtual) {
+    dp_->punt(PuntQueue::kEcho, ip_pkt, iface, PuntQueue::kInput);
+    return;
+  }
+
+  bool admitted;
+  {
+    Fwk::ScopedLock<PuntQueue> lock(dp_->punt_queue_);
+    admitted = dp_->punt_queue_->onAnswer(PuntQueue::kEcho,
+                                          monotonicTimeMs());
+  }
+  if (!admitted) {
+    DLOG << "  punt queue dropped echo packet";
+    return;
+  }
+
+  // The reply is the request turned around in place, and goes back to the
+  // neighbor the request came from, without a route or ARP lookup. Swapping
+  // the addresses leaves the IP checksum as it is; the ICMP checksum is
+  // updated for the change of type (RFC 1624).
+  const uint16_t old_word = (ICMPPacket::kEchoRequest << 8) | pkt->code();
+  const uint16_t new_word = (ICMPPacket::kEchoReply << 8) | pkt->code();
+  uint32_t sum = (uint16_t)~pkt->checksum();
+  sum += (uint16_t)~old_word;
+  sum += new_word;
+  while (sum > 0xFFFF)
+    sum = (sum >> 16) + (sum & 0xFFFF);
+  pkt->typeIs(ICMPPacket::kEchoReply);
+  pkt->checksumIs(~sum & 0xFFFF);
+
+  const IPv4Addr sender = ip_pkt->src();
+  ip_pkt->srcIs(ip_pkt->dst());
+  ip_pkt->dstIs(sender);
+
+  EthernetPacket::Ptr eth_pkt =
+      Ptr::st_cast<EthernetPacket>(ip_pkt->enclosingPacket());
+  eth_pkt->dstIs(eth_pkt->src());
+  eth_pkt->srcIs(iface->mac());
+
+  DLOG << "  answering echo request from " << sender;
+  dp_->outputPacketNew(eth_pkt, iface);
 }
 
 
@@ -211,9 +373,34 @@ void DataPlane::PacketFunctor::operator()(IPPacket* const pkt,
   }
 
   // IP packets destined for the router or to the OSPF broadcast address
-  // go to the control plane immediately.
+  // go to the control plane. GRE packets carry transit traffic, so they are
+  // decapsulated here; fragments of them are punted as exceptions, like
+  // other fragments, and reassembled by the control plane first. Pings of
+  // the router's addresses are answered here, unless they were fragmented.
   if (target_iface || dest_ip == OSPFHelloPacket::kBroadcastAddr) {
-    dp_->controlPlane()->packetNew(pkt, iface);
+    switch (pkt->protocol()) {
+      case IPPacket::kGRE:
+        if (pkt->fragment())
+          dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kInput);
+        else
+          (*pkt->payload())(this, iface);
+        break;
+      case IPPacket::kICMP:
+        if (pkt->fragment() || !target_iface)
+          dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kInput);
+        else
+          (*pkt->payload())(this, iface);
+        break;
+      case IPPacket::kOSPF:
+        dp_->punt(PuntQueue::kRoutingProtocol, pkt, iface, PuntQueue::kInput);
+        break;
+      case IPPacket::kTCP:
+        dp_->punt(PuntQueue::kLocal, pkt, iface, PuntQueue::kInput);
+        break;
+      default:
+        dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kInput);
+        break;
+    }
     return;
   }
 
@@ -223,7 +410,7 @@ void DataPlane::PacketFunctor::operator()(IPPacket* const pkt,
   DLOG << "  decremented TTL: " << (uint32_t)pkt->ttl();
   if (pkt->ttl() < 1) {
     // Send ICMP Time Exceeded Message to source.
-    dp_->controlPlane()->outputPacketNew(pkt);
+    dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kOutput);
     return;
   }
 
@@ -239,24 +426,37 @@ void DataPlane::PacketFunctor::operator()(IPPacket* const pkt,
   if (!r_entry) {
     DLOG << "No route to " << dest_ip;
     // Send to control plane for error processing.
-    dp_->controlPlane()->outputPacketNew(pkt);
+    dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kOutput);
     return;
   }
 
+  // Multipath routes spread flows over their next hops by hash, so that
+  // all packets of a flow take the same path and are not reordered.
+  const RoutingTable::Entry::NextHop& next_hop =
+      r_entry->flowNextHop(pkt->flowHash());
+
   // Outgoing interface.
-  Interface::PtrConst out_iface = r_entry->interface();
+  Interface::PtrConst out_iface = next_hop.interface();
 
   if (out_iface->type() == Interface::kVirtual) {
-    // Let ControlPlane deal with sending out virtual interfaces.
-    dp_->controlPlane()->outputPacketNew(pkt);
+    // Tunnels whose outer headers are built are encapsulated here; the
+    // ControlPlane deals with the others, and builds their headers.
+    if (!dp_->encapsulatedOutput(pkt, out_iface))
+      dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kOutput);
     return;
   }
 
   DLOG << "  LPM for " << dest_ip << ": " << r_entry->subnet()
        << " (" << out_iface->name() << ")";
 
+  if (pkt->len() > out_iface->mtu() && (pkt->flags() & IPPacket::kIP_DF)) {
+    // Datagram may not be fragmented; ControlPlane tells the source.
+    dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kOutput);
+    return;
+  }
+
   // Next hop IP address.
-  IPv4Addr next_hop_ip = r_entry->gateway();
+  IPv4Addr next_hop_ip = next_hop.gateway();
   if (next_hop_ip == 0u)
     next_hop_ip = pkt->dst();
 
@@ -266,10 +466,14 @@ void DataPlane::PacketFunctor::operator()(IPPacket* const pkt,
     ARPCache::Ptr cache = dp_->controlPlane()->arpCache();
     Fwk::ScopedLock<ARPCache>lock(cache);
     arp_entry = cache->entry(next_hop_ip);
+    if (arp_entry)
+      arp_entry->usedIs(true);
+    else
+      cache->missesInc();
   }
   if (!arp_entry) {
     // ARP cache miss. Send packet to control plane to be forwarded.
-    dp_->controlPlane()->outputPacketNew(pkt);
+    dp_->punt(PuntQueue::kException, pkt, iface, PuntQueue::kOutput);
     return;
   }
 
@@ -295,8 +499,132 @@ void DataPlane::PacketFunctor::operator()(IPPacket* const pkt,
          << " via " << out_iface->name();
   }
 
-  // Send packet.
-  dp_->outputPacketNew(eth_pkt, out_iface);
+  // Send packet, in fragments if it does not fit the outgoing interface.
+  if (pkt->len() > out_iface->mtu())
+    dp_->fragmentedOutput(pkt, eth_pkt, out_iface);
+  else
+    dp_->outputPacketNew(eth_pkt, out_iface);
+}
+
+
+bool DataPlane::encapsulatedOutput(IPPacket::Ptr pkt,
+                                   const Interface::PtrConst tun_iface) {
+  Tunnel::Ptr tunnel;
+  Tunnel::Encap::PtrConst encap;
+  {
+    TunnelMap::Ptr tun_map = cp_->tunnelMap();
+    Fwk::ScopedLock<TunnelMap> tun_map_lock(tun_map);
+    tunnel = tun_map->tunnel(tun_iface->name());
+    if (tunnel)
+      encap = tunnel->encap();
+  }
+  if (!encap || encap->generation() != cp_->tunnelEncapGeneration() ||
+      !encap->interface()->enabled()) {
+    return false;
+  }
+
+  // Lower the MSS of TCP connections through the tunnel, so that their
+  // segments need neither fragmentation nor path MTU discovery.
+  const size_t mtu = tunnel->mtu(encap->interface());
+  if (tunnel->mssClamp() && pkt->tcpMSSClamp(mtu - kTCPIPHeaderSize))
+    DLOG << "  clamped TCP MSS to " << mtu - kTCPIPHeaderSize;
+
+  // Packets that do not fit are fragmented or refused by the ControlPlane.
+  if (pkt->len() > mtu)
+    return false;
+
+  const uint16_t id = cp_->ipIDGenerator()->next(tunnel->remote());
+  EthernetPacket::Ptr eth_pkt = encap->encapsulated(pkt, id);
+
+  DLOG << "Encapsulated IP packet for " << tunnel->remote() << " via "
+       << encap->nextHop() << " (" << encap->interface()->name() << ")";
+
+  outputPacketNew(eth_pkt, encap->interface());
+  return true;
+}
+
+
+void DataPlane::fragmentedOutput(const IPPacket::Ptr pkt,
+                                 const EthernetPacket::PtrConst eth_pkt,
+                                 const Interface::PtrConst out_iface) {
+  const size_t header_len = pkt->headerLength() * 4;
+
+  // Fragment offsets are in 8-byte blocks, so all fragments but the last
+  // carry a multiple of 8 bytes.
+  if (out_iface->mtu() < header_len + 8) {
+    DLOG << "MTU of " << out_iface->name() << " too small to fragment";
+    return;
+  }
+
+  // Fragments keep the identification of the datagram. A datagram that is a
+  // fragment itself is split into fragments of the original datagram.
+  const size_t first_offset = pkt->fragmentOffset();
+  const bool more_fragments = (pkt->flags() & IPPacket::kIP_MF);
+
+  // Ethernet and IP headers of the first fragment, which carries all options
+  // of the datagram.
+  const size_t headers_len = EthernetPacket::kHeaderSize + header_len;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(headers_len);
+  uint8_t* const headers = buffer->data() + buffer->size() - headers_len;
+  memcpy(headers, eth_pkt->data(), headers_len);
+  IPPacket::Ptr fragment = IPPacket::New(buffer, buffer->size() - header_len);
+
+  // Headers of the fragments after it, which carry only the options with
+  // their copied flag set (RFC 791). Datagrams without options share the
+  // headers of the first fragment.
+  uint8_t options[IPPacket::kMaxHeaderSize - IPPacket::kHeaderSize];
+  const size_t options_len = pkt->copiedOptions(options);
+  IPPacket::Ptr later_fragment = fragment;
+  uint8_t* later_headers = headers;
+  size_t later_header_len = header_len;
+  if (header_len > IPPacket::kHeaderSize) {
+    later_header_len = IPPacket::kHeaderSize + options_len;
+    const size_t later_headers_len =
+        EthernetPacket::kHeaderSize + later_header_len;
+    PacketBuffer::Ptr later_buffer = PacketBuffer::New(later_headers_len);
+    later_headers =
+        later_buffer->data() + later_buffer->size() - later_headers_len;
+    memcpy(later_headers, headers,
+           EthernetPacket::kHeaderSize + IPPacket::kHeaderSize);
+    memcpy(later_headers + EthernetPacket::kHeaderSize + IPPacket::kHeaderSize,
+           options, options_len);
+    later_fragment = IPPacket::New(later_buffer,
+                                   later_buffer->size() - later_header_len);
+    later_fragment->headerLengthIs(later_header_len / 4);
+  }
+
+  struct iovec iov[2];
+  iov[0].iov_base = headers;
+  iov[0].iov_len = headers_len;
+
+  const uint8_t* const payload = pkt->data() + header_len;
+  const size_t payload_len = pkt->len() - header_len;
+  size_t fragment_header_len = header_len;
+  size_t offset = 0;
+  while (offset < payload_len) {
+    const size_t max_payload_len =
+        (out_iface->mtu() - fragment_header_len) / 8 * 8;
+    const size_t fragment_payload_len =
+        min(max_payload_len, payload_len - offset);
+    const bool last_fragment = (offset + fragment_payload_len == payload_len);
+
+    fragment->packetLengthIs(fragment_header_len + fragment_payload_len);
+    fragment->flagsAre((last_fragment && !more_fragments) ? 0
+                                                          : IPPacket::kIP_MF);
+    fragment->fragmentOffsetIs(first_offset + offset / 8);
+    fragment->checksumReset();
+
+    iov[1].iov_base = const_cast<uint8_t*>(payload + offset);
+    iov[1].iov_len = fragment_payload_len;
+    outputGatheredNew(iov, 2, out_iface);
+
+    offset += fragment_payload_len;
+
+    fragment = later_fragment;
+    fragment_header_len = later_header_len;
+    iov[0].iov_base = later_headers;
+    iov[0].iov_len = EthernetPacket::kHeaderSize + later_header_len;
+  }
 }
 
 
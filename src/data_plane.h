@@ -10,6 +10,7 @@
 #include "interface.h"
 #include "interface_map.h"
 #include "packet.h"
+#include "punt_queue.h"
 #include "routing_table.h"
 
 /* Forward declarations. */
@@ -20,6 +21,7 @@ class GREPacket;
 class ICMPPacket;
 class IPPacket;
 class UnknownPacket;
+struct iovec;
 struct sr_instance;
 
 
@@ -32,9 +34,30 @@ class DataPlane : public Fwk::NamedInterface {
   void packetNew(Packet::Ptr pkt, Interface::PtrConst iface);
 
   // Sends outgoing packets.
-  void outputPacketNew(Fwk::Ptr<EthernetPacket const> pkt,
+  virtual void outputPacketNew(Fwk::Ptr<EthernetPacket const> pkt,
                        Interface::PtrConst iface);
 
+  // Sends an outgoing packet gathered from the IOVCNT segments of IOV, so
+  // that its headers and payload need not be contiguous in memory.
+  virtual void outputGatheredNew(const struct iovec* iov, int iovcnt,
+                                 Interface::PtrConst iface);
+
+  // Encapsulates PKT, routed out of the virtual interface TUN_IFACE, with the
+  // outer headers built for its tunnel, and sends it. Returns false, leaving
+  // PKT to the ControlPlane, if the headers are missing or stale, or if PKT
+  // does not fit the tunnel.
+  bool encapsulatedOutput(Fwk::Ptr<IPPacket> pkt,
+                          Interface::PtrConst tun_iface);
+
+  // Sends IP datagram PKT, framed by ETH_PKT, out of OUT_IFACE in fragments
+  // that fit its MTU. Fragments are gathered from a header rewritten for each
+  // of them and the payload of PKT, which is not copied. Fragments after the
+  // first carry only the options of PKT that are copied into every fragment.
+  // PKT must not have its Don't Fragment flag set.
+  void fragmentedOutput(Fwk::Ptr<IPPacket> pkt,
+                        Fwk::Ptr<EthernetPacket const> eth_pkt,
+                        Interface::PtrConst out_iface);
+
   InterfaceMap::Ptr interfaceMap() const;
 
   // Returns the ControlPlane.
@@ -43,6 +66,13 @@ class DataPlane : public Fwk::NamedInterface {
   // Sets the ControlPlane.
   virtual void controlPlaneIs(ControlPlane* cp) { cp_ = cp; }
 
+  // Returns the queue of packets punted to the ControlPlane.
+  PuntQueue::Ptr puntQueue() const { return punt_queue_; }
+
+  // Hands up to MAX punted packets to the ControlPlane, in the order chosen
+  // by the PuntQueue. Returns the number of packets handed over.
+  size_t puntedPacketsDispatch(size_t max);
+
   // Sets the RoutingTable.
   virtual void routingTableIs(RoutingTable::Ptr rtable) {
     routing_table_ = rtable;
@@ -66,6 +96,7 @@ class DataPlane : public Fwk::NamedInterface {
   RoutingTable::Ptr routing_table_;
   ARPCache::Ptr arp_cache_;
   ControlPlane* cp_;
+  PuntQueue::Ptr punt_queue_;
   struct sr_instance* sr_;
 
  private:
@@ -85,6 +116,12 @@ class DataPlane : public Fwk::NamedInterface {
     Fwk::Log::Ptr log_;
   };
 
+  // Queues PKT, received on IFACE, for the ControlPlane.
+  void punt(PuntQueue::Class c,
+            Packet::Ptr pkt,
+            Interface::PtrConst iface,
+            PuntQueue::Direction direction);
+
   PacketFunctor functor_;
 };
 
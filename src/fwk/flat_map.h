@@ -0,0 +1,142 @@
+#ifndef FLAT_MAP_H_R8TK2WQN
+#define FLAT_MAP_H_R8TK2WQN
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "ptr_interface.h"
+
+/* Note:
+ * Drop-in replacement for Fwk::Map that keeps its elements in a vector
+ * sorted by key, rather than in a tree. Lookups are binary searches and
+ * iteration follows key order, as with Fwk::Map, but elements are stored
+ * contiguously without a heap allocation per element. Insertion and removal
+ * are linear in the size of the map; use it for small maps.
+ *
+ * Unlike Fwk::Map, insertion and removal invalidate all iterators.
+ *
+ * ValueT is specified without the ::Ptr suffix, as with Fwk::Map.
+ */
+
+namespace Fwk {
+
+template<typename KeyT,typename ValueT,typename Cmp=std::less<KeyT> >
+class FlatMap : public PtrInterface<FlatMap<KeyT,ValueT,Cmp> > {
+public:
+  typedef Fwk::Ptr<const FlatMap<KeyT,ValueT,Cmp> > PtrConst;
+  typedef Fwk::Ptr<FlatMap<KeyT,ValueT,Cmp> > Ptr;
+
+  typedef std::pair<KeyT,typename ValueT::Ptr> value_type;
+  typedef typename std::vector<value_type>::iterator iterator;
+  typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+  static Ptr New() { return new FlatMap(); }
+
+  FlatMap() {}
+
+  virtual ~FlatMap() {}
+
+  iterator begin() {
+    return elems_.begin();
+  }
+
+  iterator end() {
+    return elems_.end();
+  }
+
+  const_iterator begin() const {
+    return elems_.begin();
+  }
+
+  const_iterator end() const {
+    return elems_.end();
+  }
+
+  size_t size() const {
+    return elems_.size();
+  }
+
+  bool empty() const {
+    return elems_.empty();
+  }
+
+  iterator find(const KeyT& _key) {
+    iterator it = lower_bound(_key);
+    if (it != elems_.end() && !cmp_(_key, it->first))
+      return it;
+
+    return elems_.end();
+  }
+
+  typename ValueT::Ptr elem(const KeyT& _key) {
+    iterator it = find(_key);
+    if (it == elems_.end())
+      return NULL;
+
+    return it->second;
+  }
+
+  typename ValueT::PtrConst elem(const KeyT& _key) const {
+    FlatMap *self = const_cast<FlatMap*>(this);
+    return self->elem(_key);
+  }
+
+  void elemIs(const KeyT& _key, typename ValueT::Ptr _v) {
+    (*this)[_key] = _v;
+  }
+
+  void elemDel(iterator _it) {
+    elems_.erase(_it);
+  }
+
+  void elemDel(const KeyT& _key) {
+    iterator it = find(_key);
+    if (it != elems_.end())
+      elems_.erase(it);
+  }
+
+  void clear() {
+    elems_.clear();
+  }
+
+  typename ValueT::Ptr& operator[](const KeyT& key) {
+    iterator it = lower_bound(key);
+    if (it == elems_.end() || cmp_(key, it->first))
+      it = elems_.insert(it, value_type(key, NULL));
+
+    return it->second;
+  }
+
+private:
+  /* Orders an element against a key. */
+  class KeyCmp {
+  public:
+    explicit KeyCmp(const Cmp& _cmp) : cmp_(_cmp) {}
+
+    bool operator()(const value_type& _elem, const KeyT& _key) const {
+      return cmp_(_elem.first, _key);
+    }
+
+  private:
+    Cmp cmp_;
+  };
+
+  iterator lower_bound(const KeyT& _key) {
+    return std::lower_bound(elems_.begin(), elems_.end(), _key, KeyCmp(cmp_));
+  }
+
+  /* data members */
+  std::vector<value_type> elems_;
+  Cmp cmp_;
+
+  /* operations disallowed */
+  FlatMap(const FlatMap&);
+  void operator=(const FlatMap&);
+};
+
+} /* end of namespace Fwk */
+
+
+#endif
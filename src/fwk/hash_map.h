@@ -0,0 +1,246 @@
+#ifndef HASH_MAP_H_C4NV7JXE
+#define HASH_MAP_H_C4NV7JXE
+
+#include <inttypes.h>
+#include <utility>
+#include <vector>
+
+#include "ptr_interface.h"
+
+/* Note:
+ * Hash map with a Fwk::Map-like interface for large maps. Elements are kept
+ * densely in a vector, so that an element's position is a dense index in
+ * [0, size()) and iteration touches contiguous memory. An open-addressing
+ * table of 32-bit positions, probed linearly, maps keys to positions.
+ *
+ * Iteration order is insertion order until an element is removed; the
+ * last element then takes the place of the removed one. Insertion and
+ * removal therefore invalidate iterators.
+ *
+ * HashT is a function object that maps a key to a 32-bit value. The default,
+ * Fwk::Hash, uses the value() of Fwk::Ordinal keys. Hash values are mixed
+ * before use, so they do not need to be well distributed.
+ *
+ * ValueT is specified without the ::Ptr suffix, as with Fwk::Map.
+ */
+
+namespace Fwk {
+
+template<typename KeyT>
+struct Hash {
+  uint32_t operator()(const KeyT& _key) const {
+    return _key.value();
+  }
+};
+
+template<typename KeyT,typename ValueT,typename HashT=Hash<KeyT> >
+class HashMap : public PtrInterface<HashMap<KeyT,ValueT,HashT> > {
+public:
+  typedef Fwk::Ptr<const HashMap<KeyT,ValueT,HashT> > PtrConst;
+  typedef Fwk::Ptr<HashMap<KeyT,ValueT,HashT> > Ptr;
+
+  typedef std::pair<KeyT,typename ValueT::Ptr> value_type;
+  typedef typename std::vector<value_type>::iterator iterator;
+  typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+  static Ptr New() { return new HashMap(); }
+
+  HashMap() : mask_(0), shift_(32) {}
+
+  virtual ~HashMap() {}
+
+  iterator begin() {
+    return elems_.begin();
+  }
+
+  iterator end() {
+    return elems_.end();
+  }
+
+  const_iterator begin() const {
+    return elems_.begin();
+  }
+
+  const_iterator end() const {
+    return elems_.end();
+  }
+
+  size_t size() const {
+    return elems_.size();
+  }
+
+  bool empty() const {
+    return elems_.empty();
+  }
+
+  /* Dense index of the element with key _KEY, or kNotFound. */
+  uint32_t index(const KeyT& _key) const {
+    if (slots_.empty())
+      return kNotFound;
+
+    for (uint32_t slot = home(_key); ; slot = (slot + 1) & mask_) {
+      uint32_t pos = slots_[slot];
+      if (pos == kEmpty)
+        return kNotFound;
+
+      if (elems_[pos].first == _key)
+        return pos;
+    }
+  }
+
+  iterator find(const KeyT& _key) {
+    uint32_t pos = index(_key);
+    return (pos == kNotFound) ? elems_.end() : elems_.begin() + pos;
+  }
+
+  typename ValueT::Ptr elem(const KeyT& _key) {
+    uint32_t pos = index(_key);
+    if (pos == kNotFound)
+      return NULL;
+
+    return elems_[pos].second;
+  }
+
+  typename ValueT::PtrConst elem(const KeyT& _key) const {
+    HashMap *self = const_cast<HashMap*>(this);
+    return self->elem(_key);
+  }
+
+  void elemIs(const KeyT& _key, typename ValueT::Ptr _v) {
+    (*this)[_key] = _v;
+  }
+
+  void elemDel(iterator _it) {
+    elemDel(_it->first);
+  }
+
+  void elemDel(const KeyT& _key) {
+    if (slots_.empty())
+      return;
+
+    uint32_t slot = home(_key);
+    for (; slots_[slot] != kEmpty; slot = (slot + 1) & mask_) {
+      if (elems_[slots_[slot]].first == _key)
+        break;
+    }
+
+    uint32_t pos = slots_[slot];
+    if (pos == kEmpty)
+      return;
+
+    slot_del(slot);
+
+    /* The last element fills the hole, keeping elements dense. */
+    uint32_t last = elems_.size() - 1;
+    if (pos != last) {
+      slots_[slot_of(last)] = pos;
+      elems_[pos] = elems_[last];
+    }
+
+    elems_.pop_back();
+  }
+
+  void clear() {
+    elems_.clear();
+    slots_.clear();
+    mask_ = 0;
+    shift_ = 32;
+  }
+
+  typename ValueT::Ptr& operator[](const KeyT& key) {
+    uint32_t pos = index(key);
+    if (pos != kNotFound)
+      return elems_[pos].second;
+
+    /* Table is kept at most half full. */
+    if (2 * (elems_.size() + 1) > slots_.size())
+      rehash(slots_.empty() ? kMinSlots : 2 * slots_.size());
+
+    uint32_t slot = home(key);
+    while (slots_[slot] != kEmpty)
+      slot = (slot + 1) & mask_;
+
+    slots_[slot] = elems_.size();
+    elems_.push_back(value_type(key, NULL));
+    return elems_.back().second;
+  }
+
+  static const uint32_t kNotFound = 0xffffffff;
+
+private:
+  static const uint32_t kEmpty = 0xffffffff;
+  static const uint32_t kMinSlots = 16;
+
+  /* Fibonacci hashing: the top bits of the product depend on all bits of
+     the hash value, so keys that differ only in their low bits spread. */
+  uint32_t home(const KeyT& _key) const {
+    return (uint32_t)(hash_(_key) * 2654435769u) >> shift_;
+  }
+
+  /* Slot that holds the element at POS, which must be in the table. */
+  uint32_t slot_of(uint32_t pos) const {
+    uint32_t slot = home(elems_[pos].first);
+    while (slots_[slot] != pos)
+      slot = (slot + 1) & mask_;
+
+    return slot;
+  }
+
+  /* Empties SLOT, then shifts later entries of the same probe sequence
+     back so that lookups need no tombstones. */
+  void slot_del(uint32_t slot) {
+    uint32_t hole = slot;
+    for (uint32_t next = (hole + 1) & mask_; slots_[next] != kEmpty;
+         next = (next + 1) & mask_) {
+      uint32_t want = home(elems_[slots_[next]].first);
+
+      /* NEXT may move to HOLE only if its home is not in (HOLE, NEXT]. */
+      if (((next - want) & mask_) >= ((next - hole) & mask_)) {
+        slots_[hole] = slots_[next];
+        hole = next;
+      }
+    }
+
+    slots_[hole] = kEmpty;
+  }
+
+  void rehash(uint32_t slots) {
+    slots_.assign(slots, kEmpty);
+    mask_ = slots - 1;
+    for (shift_ = 32; slots > 1; slots >>= 1)
+      --shift_;
+
+    for (uint32_t pos = 0; pos < elems_.size(); ++pos) {
+      uint32_t slot = home(elems_[pos].first);
+      while (slots_[slot] != kEmpty)
+        slot = (slot + 1) & mask_;
+
+      slots_[slot] = pos;
+    }
+  }
+
+  /* data members */
+  std::vector<value_type> elems_;
+  std::vector<uint32_t> slots_;
+  uint32_t mask_;
+  uint32_t shift_;  /* 32 - log2(slots_.size()). */
+  HashT hash_;
+
+  /* operations disallowed */
+  HashMap(const HashMap&);
+  void operator=(const HashMap&);
+};
+
+template<typename KeyT,typename ValueT,typename HashT>
+const uint32_t HashMap<KeyT,ValueT,HashT>::kNotFound;
+
+template<typename KeyT,typename ValueT,typename HashT>
+const uint32_t HashMap<KeyT,ValueT,HashT>::kEmpty;
+
+template<typename KeyT,typename ValueT,typename HashT>
+const uint32_t HashMap<KeyT,ValueT,HashT>::kMinSlots;
+
+} /* end of namespace Fwk */
+
+
+#endif
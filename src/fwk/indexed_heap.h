@@ -0,0 +1,139 @@
+#ifndef INDEXED_HEAP_H_P3QW8XKD
+#define INDEXED_HEAP_H_P3QW8XKD
+
+#include <inttypes.h>
+#include <vector>
+
+namespace Fwk {
+
+/* Binary min-heap over a dense set of integer keys in [0, capacity).
+ * Every key carries a priority; a key's priority may be lowered (or raised)
+ * in O(log n) while it is in the heap because the position of each key in
+ * the heap array is tracked. Ties are broken on the key itself, so the
+ * order in which keys leave the heap is deterministic. */
+template <typename PriorityT>
+class IndexedHeap {
+ public:
+  static const uint32_t kNotInHeap = 0xffffffff;
+
+  explicit IndexedHeap(uint32_t capacity=0) { capacityIs(capacity); }
+
+  /* Accessors. */
+
+  bool empty() const { return heap_.empty(); }
+  size_t size() const { return heap_.size(); }
+  uint32_t capacity() const { return pos_.size(); }
+
+  bool contains(uint32_t key) const {
+    return key < pos_.size() && pos_[key] != kNotInHeap;
+  }
+
+  /* Key with the smallest priority. Heap must not be empty. */
+  uint32_t top() const { return heap_[0]; }
+  PriorityT topPriority() const { return prio_[heap_[0]]; }
+
+  PriorityT priority(uint32_t key) const { return prio_[key]; }
+
+  /* Mutators. */
+
+  /* Empties the heap and resizes the key space to [0, capacity). */
+  void capacityIs(uint32_t capacity) {
+    heap_.clear();
+    heap_.reserve(capacity);
+    pos_.assign(capacity, kNotInHeap);
+    prio_.resize(capacity);
+  }
+
+  /* Inserts KEY, or updates its priority if it is already in the heap. */
+  void priorityIs(uint32_t key, PriorityT priority) {
+    if (!contains(key)) {
+      prio_[key] = priority;
+      pos_[key] = heap_.size();
+      heap_.push_back(key);
+      sift_up(pos_[key]);
+      return;
+    }
+
+    PriorityT prev = prio_[key];
+    prio_[key] = priority;
+    if (priority < prev)
+      sift_up(pos_[key]);
+    else
+      sift_down(pos_[key]);
+  }
+
+  /* Removes the key with the smallest priority. */
+  void pop() {
+    if (heap_.empty())
+      return;
+
+    pos_[heap_[0]] = kNotInHeap;
+    uint32_t last = heap_.back();
+    heap_.pop_back();
+
+    if (!heap_.empty()) {
+      heap_[0] = last;
+      pos_[last] = 0;
+      sift_down(0);
+    }
+  }
+
+ private:
+  bool less(uint32_t a, uint32_t b) const {
+    if (prio_[a] < prio_[b])
+      return true;
+    if (prio_[b] < prio_[a])
+      return false;
+    return a < b;
+  }
+
+  void swap(uint32_t i, uint32_t j) {
+    uint32_t key = heap_[i];
+    heap_[i] = heap_[j];
+    heap_[j] = key;
+    pos_[heap_[i]] = i;
+    pos_[heap_[j]] = j;
+  }
+
+  void sift_up(uint32_t i) {
+    while (i > 0) {
+      uint32_t parent = (i - 1) / 2;
+      if (!less(heap_[i], heap_[parent]))
+        break;
+      swap(i, parent);
+      i = parent;
+    }
+  }
+
+  void sift_down(uint32_t i) {
+    const uint32_t n = heap_.size();
+    for (;;) {
+      uint32_t min = i;
+      uint32_t left = 2 * i + 1;
+      uint32_t right = left + 1;
+
+      if (left < n && less(heap_[left], heap_[min]))
+        min = left;
+      if (right < n && less(heap_[right], heap_[min]))
+        min = right;
+
+      if (min == i)
+        break;
+
+      swap(i, min);
+      i = min;
+    }
+  }
+
+  /* Data members. */
+  std::vector<uint32_t> heap_;   /* Keys in heap order. */
+  std::vector<uint32_t> pos_;    /* Position of each key in heap_. */
+  std::vector<PriorityT> prio_;  /* Priority of each key. */
+};
+
+template <typename PriorityT>
+const uint32_t IndexedHeap<PriorityT>::kNotInHeap;
+
+} /* end of namespace Fwk */
+
+#endif
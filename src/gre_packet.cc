@@ -1,6 +1,7 @@
 #include "gre_packet.h"
 
 #include <arpa/inet.h>
+#include <cstring>
 #include <inttypes.h>
 #include "arp_packet.h"
 #include "ethernet_packet.h"
@@ -14,6 +15,9 @@ static Fwk::Log::Ptr log_ = Fwk::Log::LogNew("GREPacket");
 const size_t GREPacket::kHeaderSize = sizeof(struct GREHeader);
 const size_t GREPacket::kHeaderSizeWithoutChecksum = 4;
 
+// K bit in the first 16 bits of the header (RFC2890).
+static const uint16_t kKeyBit = 0x2000;
+
 
 GREPacket::GREPacket(const PacketBuffer::Ptr buffer,
                      const unsigned int buffer_offset)
@@ -29,8 +33,7 @@ void GREPacket::operator()(Functor* const f, const Interface::PtrConst iface) {
 // Packet validation.
 bool GREPacket::valid() const {
   // Verify length.
-  const size_t header_len = checksumPresent() ? 8 : 4;
-  if (len() < header_len) {
+  if (len() < headerLen()) {
     DLOG << "length is too short: " << len();
     return false;
   }
@@ -73,6 +76,52 @@ void GREPacket::checksumPresentIs(const bool value) {
 }
 
 
+bool GREPacket::keyPresent() const {
+  uint16_t field = ntohs(gre_hdr_->c_resv0_ver);
+  return (field & kKeyBit) != 0;
+}
+
+
+void GREPacket::keyPresentIs(const bool value) {
+  uint16_t field = ntohs(gre_hdr_->c_resv0_ver);
+  if (value)
+    field |= kKeyBit;
+  else
+    field &= ~kKeyBit;
+  gre_hdr_->c_resv0_ver = htons(field);
+}
+
+
+uint32_t GREPacket::key() const {
+  if (!keyPresent())
+    return 0;
+
+  uint32_t key;
+  memcpy(&key, keyAddress(), sizeof(key));
+  return ntohl(key);
+}
+
+
+void GREPacket::keyIs(const uint32_t key) {
+  // No-op if key bit isn't set.
+  if (!keyPresent())
+    return;
+
+  const uint32_t nbo_key = htonl(key);
+  memcpy(keyAddress(), &nbo_key, sizeof(nbo_key));
+}
+
+
+uint8_t* GREPacket::keyAddress() const {
+  return (uint8_t*)gre_hdr_ + (checksumPresent() ? 8 : 4);
+}
+
+
+size_t GREPacket::headerLen() const {
+  return 4 + (checksumPresent() ? 4 : 0) + (keyPresent() ? 4 : 0);
+}
+
+
 uint16_t GREPacket::checksum() const {
   return (checksumPresent()) ? ntohs(gre_hdr_->cksum) : 0;
 }
@@ -138,10 +187,10 @@ uint16_t GREPacket::reserved0() const {
   // First 16 bits of the header:
   //  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5
   // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  // |C|       Reserved0       | Ver |
+  // |C| |K|    Reserved0      | Ver |
   // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
-  const int resv0_mask = (0x0FFF << 3);
+  const int resv0_mask = (0x0FFF << 3) & ~kKeyBit;
 
   return ((field & resv0_mask) >> 3);
 }
@@ -152,11 +201,11 @@ void GREPacket::reserved0Is(uint16_t value) {
   uint16_t field = ntohs(gre_hdr_->c_resv0_ver);
 
   // Clear Reserved0 field.
-  const int resv0_mask = (0x0FFF << 3);
+  const int resv0_mask = (0x0FFF << 3) & ~kKeyBit;
   field &= ~resv0_mask;
 
-  // We will use only the lower 12 bits of value.
-  value &= 0x0FFF;
+  // We will use only the lower 12 bits of value, less the K bit.
+  value &= (resv0_mask >> 3);
 
   // Set Reserved0 field to value.
   field |= (value << 3);
@@ -210,8 +259,7 @@ void GREPacket::reserved1Is(const uint16_t value) {
 
 
 Packet::Ptr GREPacket::payload() {
-  const uint16_t header_len = checksumPresent() ? 8 : 4;
-  const uint16_t payload_offset = bufferOffset() + header_len;
+  const uint16_t payload_offset = bufferOffset() + headerLen();
   Packet::Ptr pkt;
 
   switch (protocol()) {
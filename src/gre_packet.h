@@ -53,10 +53,30 @@ class GREPacket : public Packet {
   // the C bit is not enabled.
   uint16_t checksumReset();
 
-  // Returns the value in the Reserved0 field of the packet.
+  // Returns true if the K (key) bit is enabled. Per RFC2890, this bit
+  // determines the presence of the Key field, which follows the Checksum
+  // and Reserved1 fields if they are present.
+  bool keyPresent() const;
+
+  // Sets the K (key) bit. Like checksumPresentIs(), this does not move the
+  // fields that follow.
+  void keyPresentIs(bool value);
+
+  // Returns the key in the Key field or 0 if the key is not present.
+  uint32_t key() const;
+
+  // Sets the key. Does nothing if the K (key) bit is not enabled.
+  void keyIs(uint32_t key);
+
+  // Returns the length of the GRE header: 4 bytes, plus 4 for each of the
+  // Checksum/Reserved1 and Key fields that are present.
+  size_t headerLen() const;
+
+  // Returns the value in the Reserved0 field of the packet. The K bit, which
+  // RFC2890 carved out of Reserved0, is not included.
   uint16_t reserved0() const;
 
-  // Sets the Reserved0 field.
+  // Sets the Reserved0 field, leaving the K bit alone.
   void reserved0Is(uint16_t value);
 
   // Returns the version value.
@@ -94,6 +114,9 @@ class GREPacket : public Packet {
 
   uint16_t computeChecksum() const;
 
+  // Returns the address of the Key field.
+  uint8_t* keyAddress() const;
+
   struct GREHeader* gre_hdr_;
 };
 
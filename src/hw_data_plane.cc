@@ -38,6 +38,7 @@ using std::vector;
 struct sr_instance;
 static const char* const kDefaultIfaceName = "nf2c0";
 static const size_t kMaxHWRoutingTableEntries = 32;
+static const size_t kMaxHWIPFilterTableEntries = 32;
 
 
 HWDataPlane::HWDataPlane(struct sr_instance* sr,
@@ -127,7 +128,8 @@ HWDataPlane::InterfaceMapReactor::InterfaceMapReactor(HWDataPlane* dp)
 void HWDataPlane::InterfaceMapReactor::onInterface(InterfaceMap::Ptr map,
                                                    Interface::Ptr iface) {
   dp_->initializeInterface(iface);
-  dp_->writeHWIPFilterTable();
+  if (iface->ip() != IPv4Addr::kZero)
+    dp_->writeHWIPFilterTable();
 
   // Register to get notifications from the interface itself.
   dp_->interface_reactor_.notifierIs(iface);
@@ -136,7 +138,8 @@ void HWDataPlane::InterfaceMapReactor::onInterface(InterfaceMap::Ptr map,
 
 void HWDataPlane::InterfaceMapReactor::onInterfaceDel(InterfaceMap::Ptr map,
                                                       Interface::Ptr iface) {
-  dp_->writeHWIPFilterTable();
+  if (iface->ip() != IPv4Addr::kZero)
+    dp_->writeHWIPFilterTable();
 }
 
 
@@ -164,13 +167,17 @@ HWDataPlane::TunnelMapReactor::TunnelMapReactor(HWDataPlane* dp)
 
 void HWDataPlane::TunnelMapReactor::onTunnel(TunnelMap::Ptr tunnel_map,
                                              Tunnel::Ptr tunnel) {
-  dp_->writeHWRoutingTable();
+  // Routes through a tunnel carry its remote, so only those need rewriting.
+  // Tunnels are usually added before their routes.
+  if (dp_->routesThrough(tunnel->interface()))
+    dp_->writeHWRoutingTable();
 }
 
 
 void HWDataPlane::TunnelMapReactor::onTunnelDel(TunnelMap::Ptr rtable,
                                                 Tunnel::Ptr tunnel) {
-  dp_->writeHWRoutingTable();
+  if (dp_->routesThrough(tunnel->interface()))
+    dp_->writeHWRoutingTable();
 }
 
 
@@ -242,17 +249,25 @@ void HWDataPlane::writeHWIPFilterTable() {
 
   // InterfaceMap is not locked here because we are called by a
   // notification. We assume the InterfaceMap was already locked.
+  // Interfaces without an address, such as those of tunnels, receive
+  // nothing themselves and take no entry.
   InterfaceMap::iterator it;
   unsigned int index = 0;
   for (it = iface_map_->begin(); it != iface_map_->end(); ++it) {
     Interface::Ptr iface = it->second;
-    if (iface->enabled())
-      writeHWIPFilterTableEntry(&nf2, iface->ip(), index++);
+    if (!iface->enabled() || iface->ip() == IPv4Addr::kZero)
+      continue;
+
+    if (index >= kMaxHWIPFilterTableEntries) {
+      WLOG << "IP filter table is too large to fit entirely in hardware";
+      break;
+    }
+    writeHWIPFilterTableEntry(&nf2, iface->ip(), index++);
   }
 
   // Zero-out remaining entries.
   IPv4Addr zero_ip;
-  for (; index < InterfaceMap::kMaxInterfaces; ++index)
+  for (; index < kMaxHWIPFilterTableEntries; ++index)
     writeHWIPFilterTableEntry(&nf2, zero_ip, index);
 
   closeDescriptor(&nf2);
@@ -268,6 +283,20 @@ void HWDataPlane::writeHWIPFilterTableEntry(struct nf2device* nf2,
 }
 
 
+bool HWDataPlane::routesThrough(const Interface::PtrConst iface) const {
+  // The RoutingTable is not locked here because we are called by a
+  // notification, like writeHWRoutingTable().
+  for (RoutingTable::const_iterator it = routing_table_->entriesBegin();
+       it != routing_table_->entriesEnd(); ++it) {
+    RoutingTable::Entry::PtrConst entry = it->second;
+    if (entry->activeNextHop().interface() == iface)
+      return true;
+  }
+
+  return false;
+}
+
+
 namespace {
 
 // Comparison function for std::sort(). Sorts routing table entries, longest
@@ -311,12 +340,15 @@ void HWDataPlane::writeHWRoutingTable() {
     }
 
     RoutingTable::Entry::Ptr entry = *it;
-    Interface::PtrConst iface = entry->interface();
 
-    // Skips disabled interfaces, hardware or virtual.
-    if (!iface->enabled())
+    // Skips routes without an enabled interface, hardware or virtual. A
+    // route whose next hops are all down is written with its backup.
+    const RoutingTable::Entry::NextHop& next_hop = entry->activeNextHop();
+    if (!next_hop.enabled())
       continue;
 
+    Interface::PtrConst iface = next_hop.interface();
+
     // Parameters to set in hardware.
     IPv4Addr subnet = entry->subnet();
     IPv4Addr subnet_mask = entry->subnetMask();
@@ -337,6 +369,11 @@ void HWDataPlane::writeHWRoutingTable() {
         ELOG << "Virtual route but no associated tunnel";
         continue;
       }
+
+      // The hardware cannot add GRE keys; packets through tunnels with keys
+      // miss in hardware and are encapsulated in software.
+      if (tunnel->keyed())
+        continue;
       tunnel_remote = tunnel->remote();
 
       // Look up routing information for the tunnel endpoint.
@@ -347,7 +384,8 @@ void HWDataPlane::writeHWRoutingTable() {
         continue;
       }
 
-      Interface::PtrConst real_iface = tunnel_rentry->interface();
+      Interface::PtrConst real_iface =
+          tunnel_rentry->activeNextHop().interface();
 
       // Tunnel local is the IP address of the real interface to the tunnel
       // endpoint.
@@ -355,11 +393,11 @@ void HWDataPlane::writeHWRoutingTable() {
 
       // Next hop in hardware for virtual routes is the next hop on the
       // route to the tunnel endpoint.
-      gateway = tunnel_rentry->gateway();
+      gateway = tunnel_rentry->activeNextHop().gateway();
       encoded_port = (1 << (real_iface->index() * 2));
     } else {
 #endif
-      gateway = entry->gateway();
+      gateway = next_hop.gateway();
 
       // The port number is calculated in "one-hot-encoded format":
       //   iface num    port
@@ -127,6 +127,9 @@ class HWDataPlane : public DataPlane {
                                 unsigned int index);
   void initializeInterface(Fwk::Ptr<Interface> iface);
 
+  // Returns true if a route leaves through IFACE.
+  bool routesThrough(Fwk::Ptr<const Interface> iface) const;
+
  private:
   ARPCacheReactor arp_cache_reactor_;
   InterfaceReactor interface_reactor_;
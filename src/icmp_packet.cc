@@ -208,3 +208,14 @@ void ICMPDestUnreachablePacket::originalPacketIs(IPPacket::PtrConst pkt) {
   // Copy data.
   memcpy(ip_data, pkt->data(), len);
 }
+
+
+uint16_t ICMPDestUnreachablePacket::nextHopMTU() const {
+  // The upper half of the word following the checksum is unused.
+  return ntohl(icmp_hdr_->rest) & 0xffff;
+}
+
+
+void ICMPDestUnreachablePacket::nextHopMTUIs(const uint16_t mtu) {
+  icmp_hdr_->rest = htonl(mtu);
+}
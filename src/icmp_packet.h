@@ -31,7 +31,8 @@ class ICMPPacket : public Packet {
     kFragRequired = 4,
 
     // Time Exceeded codes.
-    kTTLExceeded = 0
+    kTTLExceeded = 0,
+    kReassemblyExceeded = 1
   };
 
   static Ptr ICMPPacketNew(PacketBuffer::Ptr buffer,
@@ -134,6 +135,13 @@ class ICMPDestUnreachablePacket : public ICMPPacket {
   // Sets the original packet that generated this message.
   void originalPacketIs(IPPacket::PtrConst pkt);
 
+  // Returns the MTU of the next hop; only set in kFragRequired messages
+  // (RFC 1191).
+  uint16_t nextHopMTU() const;
+
+  // Sets the MTU of the next hop.
+  void nextHopMTUIs(uint16_t mtu);
+
  protected:
   ICMPDestUnreachablePacket(PacketBuffer::Ptr buffer,
                             unsigned int buffer_offset);
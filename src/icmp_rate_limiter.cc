@@ -0,0 +1,100 @@
+#include "icmp_rate_limiter.h"
+
+const uint32_t ICMPRateLimiter::kDefaultRate;
+const uint32_t ICMPRateLimiter::kDefaultBurst;
+const uint32_t ICMPRateLimiter::kDefaultSourceRate;
+const uint32_t ICMPRateLimiter::kDefaultSourceBurst;
+const uint32_t ICMPRateLimiter::kDefaultSourcePrefixLen;
+const size_t ICMPRateLimiter::kMaxSources;
+
+
+ICMPRateLimiter::ICMPRateLimiter()
+    : global_(kDefaultRate, kDefaultBurst),
+      source_rate_(kDefaultSourceRate),
+      source_burst_(kDefaultSourceBurst),
+      source_prefix_len_(kDefaultSourcePrefixLen) {
+  statsDel();
+}
+
+void
+ICMPRateLimiter::sourceRateIs(uint32_t rate, uint32_t burst) {
+  source_rate_ = rate;
+  source_burst_ = burst;
+  sources_.clear();
+  age_list_.clear();
+}
+
+void
+ICMPRateLimiter::sourcePrefixLenIs(uint32_t len) {
+  source_prefix_len_ = (len > 32) ? 32 : len;
+  sources_.clear();
+  age_list_.clear();
+}
+
+bool
+ICMPRateLimiter::onError(const IPv4Addr& dest, const Milliseconds& now) {
+  // The source prefix is charged first: an error it suppresses does not
+  // take from the budget of other sources. An error the global limit
+  // suppresses is not charged to its source prefix either.
+  TokenBucket* source = source_bucket(dest, now);
+  if (source && !source->tokenTake(now)) {
+    ++source_suppressed_;
+    return false;
+  }
+
+  if (!global_.tokenTake(now)) {
+    if (source)
+      source->tokenReturn();
+    ++global_suppressed_;
+    return false;
+  }
+
+  ++sent_;
+  return true;
+}
+
+void
+ICMPRateLimiter::statsDel() {
+  sent_ = 0;
+  global_suppressed_ = 0;
+  source_suppressed_ = 0;
+}
+
+TokenBucket*
+ICMPRateLimiter::source_bucket(const IPv4Addr& dest,
+                               const Milliseconds& now) {
+  if (source_rate_ == 0)
+    return NULL;
+
+  const uint32_t mask =
+      (source_prefix_len_ == 0) ? 0 : ~0u << (32 - source_prefix_len_);
+  const uint32_t prefix = dest.value() & mask;
+
+  SourceMap::iterator it = sources_.find(prefix);
+  if (it != sources_.end()) {
+    age_list_.splice(age_list_.end(), age_list_, it->second.age);
+    return &it->second.bucket;
+  }
+
+  // Make room by forgetting the prefixes charged least recently, as long as
+  // they have not been limited recently; their buckets would be full again
+  // anyway. Each prefix is forgotten at most once, so this takes constant
+  // time per error on average, and a table of prefixes that are all being
+  // limited costs a single check.
+  while (!age_list_.empty()) {
+    SourceMap::iterator oldest = sources_.find(age_list_.front());
+    if (!oldest->second.bucket.full(now))
+      break;
+
+    sources_.erase(oldest);
+    age_list_.pop_front();
+  }
+
+  if (sources_.size() >= kMaxSources)
+    return NULL;
+
+  it = sources_.insert(
+      std::make_pair(prefix, Source(source_rate_, source_burst_))).first;
+  it->second.age = age_list_.insert(age_list_.end(), prefix);
+  return &it->second.bucket;
+}
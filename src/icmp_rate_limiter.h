@@ -0,0 +1,126 @@
+#ifndef ICMP_RATE_LIMITER_H_H4T9VKBE
+#define ICMP_RATE_LIMITER_H_H4T9VKBE
+
+#include <inttypes.h>
+#include <list>
+#include <map>
+
+#include "fwk/locked_interface.h"
+#include "fwk/ptr_interface.h"
+
+#include "ipv4_addr.h"
+#include "time_types.h"
+#include "token_bucket.h"
+
+
+/* Limits the rate at which the router generates ICMP error messages, as
+   RFC 1812 (section 4.3.2.8) asks of routers. Every error is charged to a
+   global token bucket and to a bucket of the source prefix it is sent to,
+   so that a single host or subnet sending packets that cannot be forwarded
+   does not use up the budget of everyone else. Errors that exceed either
+   bucket are suppressed before the router does any work to build them, and
+   only errors actually sent are charged.
+
+   Source prefixes have sourcePrefixLen() bits. At most kMaxSources of them
+   are tracked. To make room, the prefixes charged least recently are
+   forgotten while their buckets are full; if the oldest one is still being
+   limited, errors to further prefixes are only subject to the global
+   limit.
+
+   Thread safety: in a threaded environment, methods of this class must be
+   accessed with lockedIs(true) or by using the ScopedLock. */
+class ICMPRateLimiter : public Fwk::PtrInterface<ICMPRateLimiter>,
+                        public Fwk::LockedInterface {
+ public:
+  typedef Fwk::Ptr<const ICMPRateLimiter> PtrConst;
+  typedef Fwk::Ptr<ICMPRateLimiter> Ptr;
+
+  /* Defaults: rates in errors per second, and bursts in errors. */
+  static const uint32_t kDefaultRate = 100;
+  static const uint32_t kDefaultBurst = 50;
+  static const uint32_t kDefaultSourceRate = 10;
+  static const uint32_t kDefaultSourceBurst = 5;
+  static const uint32_t kDefaultSourcePrefixLen = 24;
+
+  static const size_t kMaxSources = 1024;
+
+  static Ptr New() { return new ICMPRateLimiter(); }
+
+  /* Accessors. */
+
+  uint32_t rate() const { return global_.rate(); }
+  uint32_t burst() const { return global_.burst(); }
+  uint32_t sourceRate() const { return source_rate_; }
+  uint32_t sourceBurst() const { return source_burst_; }
+  uint32_t sourcePrefixLen() const { return source_prefix_len_; }
+
+  /* Number of source prefixes being tracked. */
+  size_t sources() const { return sources_.size(); }
+
+  /* Statistics. */
+
+  /* Errors allowed. */
+  uint64_t sent() const { return sent_; }
+
+  /* Errors suppressed by the global limit and by the limit of their source
+     prefix. */
+  uint64_t globalSuppressed() const { return global_suppressed_; }
+  uint64_t sourceSuppressed() const { return source_suppressed_; }
+
+  /* Mutators. A rate of zero disables the corresponding limit. */
+
+  void rateIs(uint32_t rate) { global_.rateIs(rate); }
+  void burstIs(uint32_t burst) { global_.burstIs(burst); }
+
+  /* Sets the limit of each source prefix. Prefixes already tracked start
+     over with the new limit. */
+  void sourceRateIs(uint32_t rate, uint32_t burst);
+
+  /* Sets the length of source prefixes, between 0 and 32 bits. Prefixes
+     already tracked are forgotten. */
+  void sourcePrefixLenIs(uint32_t len);
+
+  /* Signals. */
+
+  /* An ICMP error is to be sent to DEST at time NOW. Returns false if it
+     must be suppressed. */
+  bool onError(const IPv4Addr& dest, const Milliseconds& now);
+
+  /* Clears the statistics. */
+  void statsDel();
+
+ protected:
+  ICMPRateLimiter();
+
+ private:
+  struct Source {
+    Source(uint32_t rate, uint32_t burst) : bucket(rate, burst) { }
+
+    /* Bucket of the prefix, and position in age_list_. */
+    TokenBucket bucket;
+    std::list<uint32_t>::iterator age;
+  };
+
+  typedef std::map<uint32_t, Source> SourceMap;
+
+  /* Returns the bucket of the source prefix of DEST, or NULL if the prefix
+     is not tracked and there is no room for it. */
+  TokenBucket* source_bucket(const IPv4Addr& dest, const Milliseconds& now);
+
+  /* Data members. */
+  TokenBucket global_;
+  uint32_t source_rate_;
+  uint32_t source_burst_;
+  uint32_t source_prefix_len_;
+  SourceMap sources_;
+  std::list<uint32_t> age_list_;  /* Prefixes, least recently charged first. */
+  uint64_t sent_;
+  uint64_t global_suppressed_;
+  uint64_t source_suppressed_;
+
+  /* Operations disallowed. */
+  ICMPRateLimiter(const ICMPRateLimiter&);
+  void operator=(const ICMPRateLimiter&);
+};
+
+#endif
@@ -4,13 +4,19 @@
 
 #include "fwk/notifier.h"
 
+#include "ethernet_packet.h"
+
 using std::string;
 
 
+const size_t Interface::kMinMTU;
+
+
 Interface::Interface(const string& name)
     : Fwk::BaseNotifier<Interface, InterfaceNotifiee>(name),
       enabled_(true),
       speed_(0),
+      mtu_(EthernetPacket::kMTU),
       type_(kHardware),
       socket_(-1) { }
 
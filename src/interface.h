@@ -60,6 +60,16 @@ class Interface
   // Sets the interface speed.
   void speedIs(uint32_t speed) { speed_ = speed; }
 
+  // Returns the largest IP packet, in bytes, that can be sent out the
+  // interface without fragmentation. Defaults to EthernetPacket::kMTU.
+  size_t mtu() const { return mtu_; }
+
+  // Sets the MTU. Values below kMinMTU are raised to it.
+  void mtuIs(size_t mtu) { mtu_ = (mtu < kMinMTU) ? kMinMTU : mtu; }
+
+  // Smallest MTU of an IPv4 link (RFC 791).
+  static const size_t kMinMTU = 68;
+
   // Returns whether or not the interface is enabled.
   bool enabled() const { return (enabled_.value() > 0); }
 
@@ -93,6 +103,7 @@ class Interface
   IPv4Addr ip_;
   IPv4Addr mask_;
   uint32_t speed_;
+  size_t mtu_;
   Type type_;
   int socket_;
   unsigned int index_;
@@ -10,8 +10,6 @@
 
 using std::string;
 
-const size_t InterfaceMap::kMaxInterfaces = 32;
-
 
 InterfaceMap::InterfaceMap()
     : Fwk::BaseNotifier<InterfaceMap, InterfaceMapNotifiee>("InterfaceMap"),
@@ -32,7 +30,8 @@ void InterfaceMap::interfaceIs(Interface::Ptr iface) {
   iface->indexIs(next_index_++);
 
   name_if_map_[iface->name()] = iface;
-  ip_if_map_[iface->ip()] = iface;
+  if (iface->ip() != IPv4Addr::kZero)
+    ip_if_map_[iface->ip()] = iface;
 
   // Dispatch notification.
   for (unsigned int i = 0; i < notifiees_.size(); ++i)
@@ -56,7 +55,9 @@ void InterfaceMap::interfaceDel(const Interface::Ptr iface) {
   iface_reactor_->notifierDel(iface);
 
   name_if_map_.erase(iface->name());
-  ip_if_map_.erase(iface->ip());
+  IPInterfaceMap::iterator ip_it = ip_if_map_.find(iface->ip());
+  if (ip_it != ip_if_map_.end() && ip_it->second == iface)
+    ip_if_map_.erase(ip_it);
 
   // Rearrange the indices.
   unsigned int new_next_index = 0;
@@ -26,9 +26,6 @@ class InterfaceMap
   typedef NameInterfaceMap::iterator iterator;
   typedef NameInterfaceMap::const_iterator const_iterator;
 
-  // Maximum number of interfaces in map.
-  static const size_t kMaxInterfaces;
-
   static Ptr InterfaceMapNew() {
     return new InterfaceMap();
   }
@@ -46,7 +43,8 @@ class InterfaceMap
   Interface::Ptr interface(const std::string& name);
 
   // Returns an interface with IP address 'addr'. Returns NULL if no interface
-  // exists with that address.
+  // exists with that address. Interfaces without an address, such as those
+  // of tunnels, are not found.
   Interface::Ptr interfaceAddr(const IPv4Addr& addr);
 
   // Returns the number of interfaces in the map.
@@ -0,0 +1,27 @@
+#include "ip_id_generator.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+const size_t IPIDGenerator::kBuckets;
+
+
+IPIDGenerator::IPIDGenerator() {
+  unsigned int seed = time(NULL) ^ getpid();
+  for (size_t i = 0; i < kBuckets; ++i)
+    ids_[i] = rand_r(&seed) & 0xffff;
+}
+
+uint16_t
+IPIDGenerator::next(const IPv4Addr& dest) {
+  // Multiplicative hashing; kBuckets is 2^11, so the top 11 bits of the
+  // product pick the counter.
+  Fwk::AtomicUInt32& id = ids_[(dest.value() * 2654435761u) >> 21];
+  uint32_t value;
+  do {
+    value = id.value();
+  } while (!id.cas(value, value + 1));
+
+  return value & 0xffff;
+}
@@ -0,0 +1,47 @@
+#ifndef IP_ID_GENERATOR_H_7DK2QWNM
+#define IP_ID_GENERATOR_H_7DK2QWNM
+
+#include <inttypes.h>
+
+#include "fwk/atomic.h"
+#include "fwk/ptr_interface.h"
+
+#include "ipv4_addr.h"
+
+
+/* Hands out the identification field of IP datagrams the router originates.
+   IDs only have to be unique among datagrams to the same destination that
+   may be in flight together, so every destination counts on its own.
+   Destinations are hashed onto kBuckets counters, which bounds memory; the
+   IDs of a destination repeat after 65536 datagrams to the destinations
+   that share its counter. Counters start at random values, so that IDs are
+   not reused right after a restart. IDs may be taken from several threads
+   at once; counters are advanced atomically.
+
+   Fragments of a datagram keep the identification of the datagram; this
+   class is only for datagrams the router builds. */
+class IPIDGenerator : public Fwk::PtrInterface<IPIDGenerator> {
+ public:
+  typedef Fwk::Ptr<const IPIDGenerator> PtrConst;
+  typedef Fwk::Ptr<IPIDGenerator> Ptr;
+
+  static const size_t kBuckets = 2048;
+
+  static Ptr New() { return new IPIDGenerator(); }
+
+  /* Returns the identification of the next datagram to DEST. */
+  uint16_t next(const IPv4Addr& dest);
+
+ protected:
+  IPIDGenerator();
+
+ private:
+  /* Data members. */
+  Fwk::AtomicUInt32 ids_[kBuckets];
+
+  /* Operations disallowed. */
+  IPIDGenerator(const IPIDGenerator&);
+  void operator=(const IPIDGenerator&);
+};
+
+#endif
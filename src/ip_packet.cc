@@ -3,6 +3,8 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
+#include <cstring>
+
 #include "fwk/log.h"
 
 #include "gre_packet.h"
@@ -33,6 +35,7 @@ struct ip_hdr {
 /* Static members. */
 const uint8_t IPPacket::kDefaultTTL;
 const size_t IPPacket::kHeaderSize = sizeof(struct ip_hdr);
+const size_t IPPacket::kMaxHeaderSize;
 const IPVersion IPPacket::kVersion;
 
 /* IPPacket */
@@ -84,7 +87,7 @@ IPPacket::valid() const {
     return false;
   }
 
-  if (headerLength() < 5) {  // in words, not bytes
+  if (headerLength() < 5 || len() < headerLength() * 4u) {  // in words
     DLOG << "Packet header length field is incorrect.";
     return false;
   }
@@ -189,6 +192,11 @@ IPPacket::fragmentOffsetIs(const IPFragmentOffset& off) {
   ip_hdr_->ip_fl_off = htons(shifted_flags | masked_offset);
 }
 
+bool
+IPPacket::fragment() const {
+  return (flags() & kIP_MF) || fragmentOffset() != 0;
+}
+
 uint8_t
 IPPacket::ttl() const {
   return ip_hdr_->ip_ttl;
@@ -239,8 +247,9 @@ IPPacket::checksumIs(uint16_t ck) {
 
 uint16_t
 IPPacket::checksumReset() {
+  // The checksum covers the options too.
   checksumIs(0);
-  checksumIs(compute_cksum(ip_hdr_, sizeof(struct ip_hdr)));
+  checksumIs(compute_cksum(ip_hdr_, headerLength() * 4));
   return checksum();
 }
 
@@ -254,7 +263,139 @@ IPPacket::checksumValid() const {
   return pkt_cksum == actual_cksum;
 }
 
+uint32_t
+IPPacket::flowHash() const {
+  uint32_t hash = ntohl(ip_hdr_->ip_src);
+  hash = hash * 0x9E3779B1 ^ ntohl(ip_hdr_->ip_dst);
+  hash = hash * 0x9E3779B1 ^ ip_hdr_->ip_p;
+
+  // Fragments other than the first carry no transport header, so ports are
+  // left out for every fragment of a datagram to keep it on one path.
+  size_t header_len = headerLength() * 4;
+  if ((protocol() == kTCP || protocol() == kUDP) && !fragment()
+      && len() >= header_len + 4) {
+    const uint8_t* ports = (const uint8_t*)offsetAddress(header_len);
+    uint32_t port_pair = ((uint32_t)ports[0] << 24) | (ports[1] << 16)
+                         | (ports[2] << 8) | ports[3];
+    hash = hash * 0x9E3779B1 ^ port_pair;
+  }
+
+  // Final avalanche, so that all bits of the result depend on all inputs.
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6B;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35;
+  hash ^= hash >> 16;
+
+  return hash;
+}
+
+bool
+IPPacket::tcpMSSClamp(const uint16_t mss) {
+  // Minimal TCP header, offsets of its fields and the MSS option kind.
+  static const size_t kTCPHeaderSize = 20;
+  static const size_t kTCPOffset = 12;
+  static const size_t kTCPFlags = 13;
+  static const size_t kTCPChecksum = 16;
+  static const uint8_t kTCP_SYN = 0x02;
+  static const uint8_t kOptionEnd = 0;
+  static const uint8_t kOptionNoop = 1;
+  static const uint8_t kOptionMSS = 2;
+
+  const size_t header_len = headerLength() * 4;
+  if (protocol() != kTCP || fragment() || len() < header_len + kTCPHeaderSize)
+    return false;
+
+  uint8_t* const tcp = (uint8_t*)offsetAddress(header_len);
+  const size_t tcp_header_len = (tcp[kTCPOffset] >> 4) * 4;
+  if (!(tcp[kTCPFlags] & kTCP_SYN) || tcp_header_len < kTCPHeaderSize ||
+      len() < header_len + tcp_header_len) {
+    return false;
+  }
+
+  size_t i = kTCPHeaderSize;
+  while (i + 1 < tcp_header_len && tcp[i] != kOptionEnd) {
+    if (tcp[i] == kOptionNoop) {
+      ++i;
+      continue;
+    }
+
+    const size_t option_len = tcp[i + 1];
+    if (option_len < 2 || i + option_len > tcp_header_len)
+      return false;
+
+    if (tcp[i] == kOptionMSS && option_len == 4) {
+      uint16_t old_word = (tcp[i + 2] << 8) | tcp[i + 3];
+      if (old_word <= mss)
+        return false;
+
+      uint16_t new_word = mss;
+      tcp[i + 2] = mss >> 8;
+      tcp[i + 3] = mss & 0xff;
+
+      // Incremental checksum update (RFC 1624). An option at an odd offset
+      // straddles two 16-bit words of the checksum; its bytes then count
+      // swapped.
+      if (i % 2) {
+        old_word = (old_word << 8) | (old_word >> 8);
+        new_word = (new_word << 8) | (new_word >> 8);
+      }
+      uint32_t sum = (uint16_t)~((tcp[kTCPChecksum] << 8) |
+                                 tcp[kTCPChecksum + 1]);
+      sum += (uint16_t)~old_word;
+      sum += new_word;
+      while (sum > 0xFFFF)
+        sum = (sum >> 16) + (sum & 0xFFFF);
+      sum = ~sum & 0xFFFF;
+      tcp[kTCPChecksum] = sum >> 8;
+      tcp[kTCPChecksum + 1] = sum & 0xff;
+      return true;
+    }
+
+    i += option_len;
+  }
+
+  return false;
+}
+
 // TODO(ms): Need tests for this.
+size_t
+IPPacket::copiedOptions(uint8_t* const options) const {
+  static const uint8_t kOptionEnd = 0;
+  static const uint8_t kOptionNoop = 1;
+  static const uint8_t kOptionCopied = 0x80;
+
+  const size_t header_len = headerLength() * 4;
+  const uint8_t* const header = (const uint8_t*)offsetAddress(0);
+  size_t len = 0;
+  size_t i = kHeaderSize;
+  while (i < header_len && header[i] != kOptionEnd) {
+    if (header[i] == kOptionNoop) {
+      ++i;
+      continue;
+    }
+
+    // A malformed option ends the options copied.
+    if (i + 1 >= header_len)
+      break;
+    const size_t option_len = header[i + 1];
+    if (option_len < 2 || i + option_len > header_len)
+      break;
+
+    if (header[i] & kOptionCopied) {
+      memcpy(options + len, header + i, option_len);
+      len += option_len;
+    }
+    i += option_len;
+  }
+
+  // Pad with End of Option List.
+  while (len % 4)
+    options[len++] = kOptionEnd;
+
+  return len;
+}
+
 Packet::Ptr
 IPPacket::payload() {
   uint16_t payload_offset = bufferOffset() + headerLen();
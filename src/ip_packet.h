@@ -44,6 +44,7 @@ class IPPacket : public Packet {
 
   static const uint8_t kDefaultTTL = 64;
   static const size_t kHeaderSize;
+  static const size_t kMaxHeaderSize = 60;
   static const IPVersion kVersion = 4;
 
   static Ptr NewDefault(PacketBuffer::Ptr buffer,
@@ -86,6 +87,10 @@ class IPPacket : public Packet {
   IPFragmentOffset fragmentOffset() const;
   void fragmentOffsetIs(const IPFragmentOffset& off);
 
+  // Returns true if the packet is a fragment of a larger datagram: it has
+  // more fragments to follow or does not start at offset 0.
+  bool fragment() const;
+
   IPv4Addr src() const;
   void srcIs(const IPv4Addr& src);
 
@@ -101,6 +106,20 @@ class IPPacket : public Packet {
   uint16_t checksumReset();
   bool checksumValid() const;
 
+  // Returns a hash of the packet's flow: source and destination addresses,
+  // protocol and, for unfragmented TCP and UDP packets, ports. Packets of
+  // the same flow hash to the same value.
+  uint32_t flowHash() const;
+
+  // Lowers the MSS option of an unfragmented TCP SYN to MSS if it is larger,
+  // updating the TCP checksum. Returns true if the option was changed.
+  bool tcpMSSClamp(uint16_t mss);
+
+  // Copies the options that are to be copied into every fragment of the
+  // packet (RFC 791) to OPTIONS, which must have room for all options of the
+  // header, and pads them to a multiple of 4 bytes. Returns their length.
+  size_t copiedOptions(uint8_t* options) const;
+
   // Returns the encapsulated packet.
   Packet::Ptr payload();
 
@@ -0,0 +1,247 @@
+#include "ip_reassembler.h"
+
+#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "packet_buffer.h"
+
+using std::list;
+using std::vector;
+
+const size_t IPReassembler::kDefaultMaxBytes;
+const int IPReassembler::kDefaultTimeout;
+const size_t IPReassembler::kMaxFragments;
+const size_t IPReassembler::kDatagramBytes;
+
+/* Largest IP datagram. */
+static const size_t kMaxDatagramLen = 65535;
+
+
+IPReassembler::Key::Key(IPPacket::PtrConst pkt)
+    : src(pkt->src()), dst(pkt->dst()), protocol(pkt->protocol()),
+      id(pkt->identification()) { }
+
+bool
+IPReassembler::Key::operator<(const Key& other) const {
+  if (src != other.src)
+    return src < other.src;
+  if (dst != other.dst)
+    return dst < other.dst;
+  if (protocol != other.protocol)
+    return protocol < other.protocol;
+  return id < other.id;
+}
+
+
+IPReassembler::IPReassembler()
+    : max_bytes_(kDefaultMaxBytes), timeout_(kDefaultTimeout), bytes_(0),
+      reassembled_(0), timeouts_(0), overlaps_(0), overflows_(0) { }
+
+void
+IPReassembler::maxBytesIs(const size_t bytes) {
+  max_bytes_ = bytes;
+
+  // Datagrams already held count against the new limit.
+  if (bytes_ > max_bytes_)
+    bytesReserve(0, NULL);
+}
+
+IPPacket::Ptr
+IPReassembler::fragmentNew(IPPacket::Ptr pkt, const Milliseconds& now) {
+  if (!pkt->fragment())
+    return pkt;
+
+  // Every fragment but the last carries a multiple of 8 bytes, and no
+  // fragment may end past the largest datagram.
+  const size_t header_len = pkt->headerLength() * 4;
+  const bool more = pkt->flags() & IPPacket::kIP_MF;
+  const size_t begin = payloadBegin(pkt);
+  const size_t end = payloadEnd(pkt);
+  if (pkt->packetLength() < header_len || pkt->len() < pkt->packetLength() ||
+      (more && (end == begin || (end - begin) % 8 != 0)) ||
+      header_len + end > kMaxDatagramLen) {
+    return NULL;
+  }
+
+  const Key key(pkt);
+  DatagramMap::iterator it = datagrams_.find(key);
+  if (it == datagrams_.end()) {
+    if (!bytesReserve(kDatagramBytes, NULL)) {
+      ++overflows_;
+      return NULL;
+    }
+    it = datagrams_.insert(std::make_pair(key, Datagram())).first;
+    bytes_ += kDatagramBytes;
+    it->second.created = now;
+    it->second.age = age_list_.insert(age_list_.end(), key);
+  }
+  Datagram& dgram = it->second;
+  if (dgram.dropped)
+    return NULL;
+
+  // The last fragment fixes the length of the datagram; fragments must not
+  // disagree with it.
+  const size_t highest =
+      dgram.fragments.empty() ? 0 : payloadEnd(dgram.fragments.back());
+  if ((!more && (end < highest || (dgram.len && end != dgram.len))) ||
+      (more && dgram.len && end > dgram.len)) {
+    ++overlaps_;
+    fragmentsDel(dgram);
+    return NULL;
+  }
+
+  if (dgram.fragments.size() >= kMaxFragments ||
+      !bytesReserve(pkt->buffer()->size(), &key)) {
+    ++overflows_;
+    datagramDel(it);
+    return NULL;
+  }
+
+  if (!fragmentIs(dgram, pkt)) {
+    ++overlaps_;
+    fragmentsDel(dgram);
+    return NULL;
+  }
+  if (!more)
+    dgram.len = end;
+
+  if (dgram.len == 0 || dgram.received < dgram.len)
+    return NULL;
+
+  IPPacket::Ptr datagram = reassembled(dgram);
+  datagramDel(it);
+  ++reassembled_;
+  return datagram;
+}
+
+void
+IPReassembler::expiredDel(const Milliseconds& now,
+                          vector<IPPacket::Ptr>* const first_fragments) {
+  // Datagrams are listed in the order their first fragments arrived.
+  while (!age_list_.empty()) {
+    DatagramMap::iterator it = datagrams_.find(age_list_.front());
+    const Datagram& dgram = it->second;
+    if (dgram.created.value() + timeout_.value() > now.value())
+      break;
+
+    if (!dgram.dropped) {
+      ++timeouts_;
+      if (!dgram.fragments.empty() &&
+          payloadBegin(dgram.fragments.front()) == 0) {
+        first_fragments->push_back(dgram.fragments.front());
+      }
+    }
+    datagramDel(it);
+  }
+}
+
+size_t
+IPReassembler::payloadBegin(IPPacket::PtrConst pkt) {
+  return pkt->fragmentOffset() * 8;
+}
+
+size_t
+IPReassembler::payloadEnd(IPPacket::PtrConst pkt) {
+  return payloadBegin(pkt) + pkt->packetLength() - pkt->headerLength() * 4;
+}
+
+bool
+IPReassembler::fragmentIs(Datagram& dgram, IPPacket::Ptr pkt) {
+  const size_t begin = payloadBegin(pkt);
+  const size_t end = payloadEnd(pkt);
+
+  // Find the first fragment that starts after PKT, from the end of the list.
+  list<IPPacket::Ptr>::iterator next = dgram.fragments.end();
+  while (next != dgram.fragments.begin()) {
+    list<IPPacket::Ptr>::iterator prev = next;
+    --prev;
+    if (payloadBegin(*prev) <= begin)
+      break;
+    next = prev;
+  }
+
+  if (next != dgram.fragments.begin()) {
+    list<IPPacket::Ptr>::iterator prev = next;
+    --prev;
+    if (payloadBegin(*prev) == begin && payloadEnd(*prev) == end)
+      return true;
+    if (payloadEnd(*prev) > begin)
+      return false;
+  }
+  if (next != dgram.fragments.end() && payloadBegin(*next) < end)
+    return false;
+
+  dgram.fragments.insert(next, pkt);
+  dgram.bytes += pkt->buffer()->size();
+  dgram.received += end - begin;
+  bytes_ += pkt->buffer()->size();
+  return true;
+}
+
+IPPacket::Ptr
+IPReassembler::reassembled(const Datagram& dgram) {
+  // The first fragment gives the header of the datagram.
+  IPPacket::Ptr first = dgram.fragments.front();
+  const size_t header_len = first->headerLength() * 4;
+  const size_t len = header_len + dgram.len;
+
+  PacketBuffer::Ptr buffer = PacketBuffer::New(len);
+  IPPacket::Ptr pkt = IPPacket::New(buffer, buffer->size() - len);
+  memcpy(pkt->data(), first->data(), header_len);
+
+  list<IPPacket::Ptr>::const_iterator it;
+  for (it = dgram.fragments.begin(); it != dgram.fragments.end(); ++it) {
+    const IPPacket::Ptr& fragment = *it;
+    const size_t begin = payloadBegin(fragment);
+    memcpy(pkt->data() + header_len + begin,
+           fragment->data() + fragment->headerLength() * 4,
+           payloadEnd(fragment) - begin);
+  }
+
+  pkt->packetLengthIs(len);
+  pkt->flagsAre(first->flags() & ~IPPacket::kIP_MF);
+  pkt->fragmentOffsetIs(0);
+  pkt->checksumReset();
+  return pkt;
+}
+
+void
+IPReassembler::datagramDel(DatagramMap::iterator it) {
+  bytes_ -= it->second.bytes + kDatagramBytes;
+  age_list_.erase(it->second.age);
+  datagrams_.erase(it);
+}
+
+void
+IPReassembler::fragmentsDel(Datagram& dgram) {
+  bytes_ -= dgram.bytes;
+  dgram.bytes = 0;
+  dgram.received = 0;
+  dgram.fragments.clear();
+  dgram.dropped = true;
+}
+
+bool
+IPReassembler::bytesReserve(const size_t bytes, const Key* const except) {
+  list<Key>::iterator age = age_list_.begin();
+  while (bytes_ + bytes > max_bytes_) {
+    if (age != age_list_.end() && except &&
+        !(*age < *except || *except < *age)) {
+      ++age;
+    }
+    if (age == age_list_.end())
+      return false;
+
+    // Datagrams dropped for overlaps hold no fragments, but are charged for
+    // their bookkeeping; forgetting them bounds their number.
+    DatagramMap::iterator it = datagrams_.find(*age);
+    ++age;
+    if (!it->second.dropped)
+      ++overflows_;
+    datagramDel(it);
+  }
+
+  return true;
+}
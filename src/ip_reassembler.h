@@ -0,0 +1,177 @@
+#ifndef IP_REASSEMBLER_H_R8PX2MDC
+#define IP_REASSEMBLER_H_R8PX2MDC
+
+#include <inttypes.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "fwk/locked_interface.h"
+#include "fwk/ptr_interface.h"
+
+#include "ip_packet.h"
+#include "ipv4_addr.h"
+#include "time_types.h"
+
+
+/* Reassembles IP datagrams addressed to the router from their fragments.
+   Fragments of a datagram share its source, destination, protocol and
+   identification. They are kept, sorted by offset, in the buffers they
+   arrived in until the datagram is complete; it is then delivered as one
+   contiguous packet, built from the header of the first fragment and the
+   payloads of all of them. Fragments usually arrive in order, so a fragment
+   is first checked against the end of the list.
+
+   Memory is bounded: fragments are charged the size of their buffers, and
+   every datagram kDatagramBytes for its bookkeeping. Once the total would
+   exceed maxBytes(), the oldest datagrams are dropped to make room. A
+   datagram is also dropped if it is not complete timeout() after its first
+   fragment arrived, or once it has kMaxFragments fragments.
+
+   A fragment that overlaps another one of its datagram, other than an exact
+   duplicate, drops the whole datagram (as RFC 5722 does for IPv6), since
+   overlaps are used to sneak data past filters that look at the first
+   fragment. Its later fragments are dropped until the datagram would have
+   timed out, unless it is forgotten earlier to make room; it is still
+   charged kDatagramBytes until then.
+
+   Thread safety: in a threaded environment, methods of this class must be
+   accessed with lockedIs(true) or by using the ScopedLock. */
+class IPReassembler : public Fwk::PtrInterface<IPReassembler>,
+                      public Fwk::LockedInterface {
+ public:
+  typedef Fwk::Ptr<const IPReassembler> PtrConst;
+  typedef Fwk::Ptr<IPReassembler> Ptr;
+
+  /* Defaults: bytes of buffers held, and milliseconds a datagram waits for
+     its fragments. */
+  static const size_t kDefaultMaxBytes = 4 * 1024 * 1024;
+  static const int kDefaultTimeout = 30 * 1000;
+
+  static const size_t kMaxFragments = 64;
+
+  /* Bytes charged for the bookkeeping of each datagram, roughly the size of
+     its entries in datagrams_ and age_list_. */
+  static const size_t kDatagramBytes = 256;
+
+  static Ptr New() { return new IPReassembler(); }
+
+  /* Accessors. */
+
+  size_t maxBytes() const { return max_bytes_; }
+  Milliseconds timeout() const { return timeout_; }
+
+  /* Datagrams being reassembled or remembered as dropped, and bytes
+     charged for them. */
+  size_t datagrams() const { return datagrams_.size(); }
+  size_t bytes() const { return bytes_; }
+
+  /* Statistics. */
+
+  /* Datagrams reassembled. */
+  uint64_t reassembled() const { return reassembled_; }
+
+  /* Datagrams dropped because they did not complete in time. */
+  uint64_t timeouts() const { return timeouts_; }
+
+  /* Datagrams dropped for overlapping fragments. */
+  uint64_t overlaps() const { return overlaps_; }
+
+  /* Datagrams dropped to stay within maxBytes() or kMaxFragments. Datagrams
+     that were dropped for overlaps are not counted again when they are
+     forgotten to make room. */
+  uint64_t overflows() const { return overflows_; }
+
+  /* Mutators. */
+
+  void maxBytesIs(size_t bytes);
+  void timeoutIs(const Milliseconds& timeout) { timeout_ = timeout; }
+
+  /* Adds fragment PKT, received at NOW. Returns its datagram if PKT
+     completes it, or NULL. Invalid fragments are dropped. */
+  IPPacket::Ptr fragmentNew(IPPacket::Ptr pkt, const Milliseconds& now);
+
+  /* Drops the datagrams that have timed out at NOW. The first fragments of
+     those that had received one are appended to FIRST_FRAGMENTS, so that
+     their sources can be told (RFC 792). */
+  void expiredDel(const Milliseconds& now,
+                  std::vector<IPPacket::Ptr>* first_fragments);
+
+ protected:
+  IPReassembler();
+
+ private:
+  /* Identifies the datagram of a fragment. */
+  struct Key {
+    Key(IPPacket::PtrConst pkt);
+
+    bool operator<(const Key& other) const;
+
+    IPv4Addr src;
+    IPv4Addr dst;
+    uint8_t protocol;
+    uint16_t id;
+  };
+
+  struct Datagram {
+    Datagram() : created(0), bytes(0), received(0), len(0), dropped(false) { }
+
+    /* Time the first fragment arrived, and position in age_list_. */
+    Milliseconds created;
+    std::list<Key>::iterator age;
+
+    /* Fragments, by offset, and bytes of their buffers. */
+    std::list<IPPacket::Ptr> fragments;
+    size_t bytes;
+
+    /* Bytes of payload received, and length of the payload once the last
+       fragment has arrived. */
+    size_t received;
+    size_t len;
+
+    /* Set when the datagram was dropped for overlapping fragments. */
+    bool dropped;
+  };
+
+  typedef std::map<Key,Datagram> DatagramMap;
+
+  /* Returns the start of PKT's payload in its datagram, and its end. */
+  static size_t payloadBegin(IPPacket::PtrConst pkt);
+  static size_t payloadEnd(IPPacket::PtrConst pkt);
+
+  /* Inserts PKT into the fragments of DGRAM. Returns false if PKT overlaps
+     one of them; exact duplicates are ignored. */
+  bool fragmentIs(Datagram& dgram, IPPacket::Ptr pkt);
+
+  /* Returns the complete datagram of the fragments in DGRAM. */
+  static IPPacket::Ptr reassembled(const Datagram& dgram);
+
+  /* Frees the fragments of the datagram at IT and forgets it. */
+  void datagramDel(DatagramMap::iterator it);
+
+  /* Frees the fragments of DGRAM, but remembers it so that its later
+     fragments are dropped. */
+  void fragmentsDel(Datagram& dgram);
+
+  /* Drops the oldest datagrams, including those already dropped for
+     overlaps, other than EXCEPT if not NULL, until BYTES more bytes fit
+     within max_bytes_. Returns false if they do not fit even so. */
+  bool bytesReserve(size_t bytes, const Key* except);
+
+  /* Data members. */
+  DatagramMap datagrams_;
+  std::list<Key> age_list_;
+  size_t max_bytes_;
+  Milliseconds timeout_;
+  size_t bytes_;
+  uint64_t reassembled_;
+  uint64_t timeouts_;
+  uint64_t overlaps_;
+  uint64_t overflows_;
+
+  /* Operations disallowed. */
+  IPReassembler(const IPReassembler&);
+  void operator=(const IPReassembler&);
+};
+
+#endif
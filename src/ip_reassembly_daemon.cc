@@ -0,0 +1,52 @@
+#include "ip_reassembly_daemon.h"
+
+#include <vector>
+
+#include "fwk/log.h"
+#include "fwk/scoped_lock.h"
+
+#include "control_plane.h"
+#include "ip_packet.h"
+#include "ip_reassembler.h"
+#include "task.h"
+#include "time_types.h"
+
+using std::vector;
+
+
+const int IPReassemblyDaemon::kInterval;
+
+
+IPReassemblyDaemon::IPReassemblyDaemon(ControlPlane::Ptr cp,
+                                       TimerWheel::Ptr wheel)
+    : Task("IPReassemblyDaemon"),
+      cp_(cp),
+      wheel_(wheel),
+      timer_(SweepTimer::New(this)),
+      log_(Fwk::Log::LogNew("IPReassemblyDaemon")) {
+  wheel_->timerIs(timer_, wheel_->time().value() + kInterval);
+}
+
+
+IPReassemblyDaemon::~IPReassemblyDaemon() {
+  wheel_->timerDel(timer_);
+}
+
+
+void IPReassemblyDaemon::onSweep() {
+  // Fragments are stamped with the monotonic clock as they arrive.
+  vector<IPPacket::Ptr> first_fragments;
+  {
+    IPReassembler::Ptr reassembler = cp_->ipReassembler();
+    Fwk::ScopedLock<IPReassembler> lock(reassembler);
+    reassembler->expiredDel(monotonicTimeMs(), &first_fragments);
+  }
+
+  for (size_t i = 0; i < first_fragments.size(); ++i) {
+    DLOG << "reassembly of datagram from " << first_fragments[i]->src()
+         << " timed out";
+    cp_->sendICMPReassemblyTimeExceeded(first_fragments[i]);
+  }
+
+  wheel_->timerIs(timer_, wheel_->time().value() + kInterval);
+}
@@ -0,0 +1,64 @@
+#ifndef IP_REASSEMBLY_DAEMON_H_
+#define IP_REASSEMBLY_DAEMON_H_
+
+#include "fwk/log.h"
+#include "fwk/ptr.h"
+
+#include "control_plane.h"
+#include "task.h"
+
+
+// Drops fragmented datagrams that the control plane's IPReassembler has
+// held for longer than its timeout, and sends ICMP Time Exceeded to the
+// sources of those whose first fragment had arrived (RFC 792, RFC 1122).
+// The reassembler is swept every kInterval milliseconds from a timer on the
+// timer wheel, so datagrams are dropped up to kInterval late.
+class IPReassemblyDaemon : public Task {
+ public:
+  typedef Fwk::Ptr<const IPReassemblyDaemon> PtrConst;
+  typedef Fwk::Ptr<IPReassemblyDaemon> Ptr;
+
+  static Ptr New(ControlPlane::Ptr cp, TimerWheel::Ptr wheel) {
+    return new IPReassemblyDaemon(cp, wheel);
+  }
+
+  static const int kInterval = 1000;
+
+ protected:
+  class SweepTimer : public Timer {
+   public:
+    typedef Fwk::Ptr<const SweepTimer> PtrConst;
+    typedef Fwk::Ptr<SweepTimer> Ptr;
+
+    static Ptr New(IPReassemblyDaemon* daemon) {
+      return new SweepTimer(daemon);
+    }
+
+   protected:
+    SweepTimer(IPReassemblyDaemon* daemon) : daemon_(daemon) { }
+
+    void onExpiry() { daemon_->onSweep(); }
+
+    IPReassemblyDaemon* daemon_;
+  };
+
+  IPReassemblyDaemon(ControlPlane::Ptr cp, TimerWheel::Ptr wheel);
+  ~IPReassemblyDaemon();
+
+  // Drops timed-out datagrams and re-arms the sweep timer.
+  void onSweep();
+
+  ControlPlane::Ptr cp_;
+  TimerWheel::Ptr wheel_;
+  SweepTimer::Ptr timer_;
+
+  Fwk::Log::Ptr log_;
+
+ private:
+  // Operations disallowed.
+  IPReassemblyDaemon(const IPReassemblyDaemon&);
+  void operator=(const IPReassemblyDaemon&);
+};
+
+
+#endif
@@ -31,6 +31,11 @@ class OSPFAdvertisementCollection
     bool operator==(const AdvKey&) const;
   };
 
+  /* Hash function for AdvKey, for use with Fwk::HashMap. */
+  struct AdvKeyHash {
+    uint32_t operator()(const AdvKey&) const;
+  };
+
   OSPFAdvertisementCollection() {}
   virtual ~OSPFAdvertisementCollection() {}
 
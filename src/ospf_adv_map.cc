@@ -126,3 +126,15 @@ OSPFAdvertisementMap::AdvKey::operator==(const AdvKey& other) const {
 
   return true;
 }
+
+/* OSPFAdvertisementCollection::AdvKeyHash. */
+
+uint32_t
+OSPFAdvertisementCollection::AdvKeyHash::operator()(const AdvKey& key) const {
+  /* Combined as in boost::hash_combine; the map mixes the result further. */
+  uint32_t hash = key.sender_.value();
+  hash ^= key.adv_nbr_.value() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  hash ^= key.subnet_.value() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  hash ^= key.mask_.value() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  return hash;
+}
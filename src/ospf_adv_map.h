@@ -1,7 +1,7 @@
 #ifndef OSPF_ADV_MAP_H_17AYHYOJ
 #define OSPF_ADV_MAP_H_17AYHYOJ
 
-#include "fwk/map.h"
+#include "fwk/hash_map.h"
 
 #include "ospf_adv_collection.h"
 
@@ -67,7 +67,7 @@ class OSPFAdvertisementMap : public OSPFAdvertisementCollection {
 
  private:
   /* Data members. */
-  Fwk::Map<AdvKey,OSPFAdvertisement> advs_;
+  Fwk::HashMap<AdvKey,OSPFAdvertisement,AdvKeyHash> advs_;
 
   /* Operations disallowed. */
   OSPFAdvertisementMap(const OSPFAdvertisementMap&);
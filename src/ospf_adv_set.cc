@@ -1,5 +1,7 @@
 #include "ospf_adv_set.h"
 
+#include <algorithm>
+
 OSPFAdvertisementSet::Ptr
 OSPFAdvertisementSet::New() {
   return new OSPFAdvertisementSet();
@@ -11,7 +13,14 @@ OSPFAdvertisementSet::contains(const RouterID& sender,
                                const IPv4Addr& subnet,
                                const IPv4Addr& mask) const {
   AdvKey key(sender, adv_nbr, subnet, mask);
-  return advs_.elem(key) != advs_.end();
+  sort();
+  return std::binary_search(advs_.begin(), advs_.end(), key);
+}
+
+size_t
+OSPFAdvertisementSet::advertisements() const {
+  sort();
+  return advs_.size();
 }
 
 void
@@ -20,7 +29,10 @@ OSPFAdvertisementSet::advertisementIs(const RouterID& sender,
                                       const IPv4Addr& subnet,
                                       const IPv4Addr& mask) {
   AdvKey key(sender, adv_nbr, subnet, mask);
-  advs_.elemIs(key);
+  if (sorted_ && !advs_.empty() && !(advs_.back() < key))
+    sorted_ = false;
+
+  advs_.push_back(key);
 }
 
 void
@@ -29,5 +41,22 @@ OSPFAdvertisementSet::advertisementDel(const RouterID& sender,
                                        const IPv4Addr& subnet,
                                        const IPv4Addr& mask) {
   AdvKey key(sender, adv_nbr, subnet, mask);
-  advs_.elemDel(key);
+  sort();
+
+  std::vector<AdvKey>::iterator it =
+    std::lower_bound(advs_.begin(), advs_.end(), key);
+  if (it != advs_.end() && *it == key)
+    advs_.erase(it);
+}
+
+/* OSPFAdvertisementSet private member functions. */
+
+void
+OSPFAdvertisementSet::sort() const {
+  if (sorted_)
+    return;
+
+  std::sort(advs_.begin(), advs_.end());
+  advs_.erase(std::unique(advs_.begin(), advs_.end()), advs_.end());
+  sorted_ = true;
 }
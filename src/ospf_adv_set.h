@@ -1,20 +1,23 @@
 #ifndef OSPF_ADV_SET_H_ISFXAIWQ
 #define OSPF_ADV_SET_H_ISFXAIWQ
 
-#include "fwk/set.h"
+#include <vector>
 
 #include "ipv4_addr.h"
 #include "ospf_adv_collection.h"
 #include "ospf_router_id.h"
 
 
+/* Set of advertisements confirmed by a single link-state update. Such sets
+   are filled once and then queried, so keys are appended to a vector that
+   is sorted and deduplicated on first use. */
 class OSPFAdvertisementSet : public OSPFAdvertisementCollection {
  public:
   typedef Fwk::Ptr<const OSPFAdvertisementSet> PtrConst;
   typedef Fwk::Ptr<OSPFAdvertisementSet> Ptr;
 
   static Ptr New();
-  OSPFAdvertisementSet() {}
+  OSPFAdvertisementSet() : sorted_(true) {}
 
   bool contains(const RouterID& sender,
                 const RouterID& adv_nbr,
@@ -31,12 +34,15 @@ class OSPFAdvertisementSet : public OSPFAdvertisementCollection {
                         const IPv4Addr& subnet,
                         const IPv4Addr& mask);
 
-  size_t advertisements() const { return advs_.size(); }
+  size_t advertisements() const;
 
  private:
+  /* Sorts advs_ and removes duplicates, unless already done. */
+  void sort() const;
 
   /* Data members. */
-  Fwk::Set<AdvKey> advs_;
+  mutable std::vector<AdvKey> advs_;
+  mutable bool sorted_;
 
   /* Operations disallowed. */
   OSPFAdvertisementSet(const OSPFAdvertisementSet&);
@@ -0,0 +1,56 @@
+#include "ospf_area.h"
+
+#include <algorithm>
+
+#include "ospf_constants.h"
+
+OSPFArea::OSPFArea(const AreaID& area_id, const RouterID& router_id)
+    : area_id_(area_id),
+      root_node_(OSPFNode::New(router_id)),
+      topology_(OSPFTopology::New(root_node_)),
+      advs_staged_(OSPFAdvertisementMap::New()),
+      interfaces_(0) {}
+
+bool
+OSPFArea::backbone() const {
+  return area_id_ == OSPF::kBackboneAreaID;
+}
+
+IPv4Subnet
+OSPFArea::summaryPrefix(const IPv4Subnet& prefix) const {
+  IPv4Subnet summary = prefix;
+
+  std::vector<IPv4Subnet>::const_iterator it;
+  for (it = ranges_.begin(); it != ranges_.end(); ++it) {
+    /* The range contains PREFIX if it is no longer than PREFIX and covers
+       its subnet number. */
+    IPv4Addr mask = it->second;
+    if ((prefix.second & mask) != mask || (prefix.first & mask) != it->first)
+      continue;
+
+    if ((summary.second & mask) == summary.second)
+      continue; /* SUMMARY is already at least as wide. */
+
+    summary = *it;
+  }
+
+  return summary;
+}
+
+void
+OSPFArea::rangeIs(const IPv4Subnet& range) {
+  IPv4Subnet key = std::make_pair(range.first & range.second, range.second);
+  std::vector<IPv4Subnet>::iterator it =
+    std::lower_bound(ranges_.begin(), ranges_.end(), key);
+  if (it == ranges_.end() || *it != key)
+    ranges_.insert(it, key);
+}
+
+void
+OSPFArea::rangeDel(const IPv4Subnet& range) {
+  IPv4Subnet key = std::make_pair(range.first & range.second, range.second);
+  std::vector<IPv4Subnet>::iterator it =
+    std::lower_bound(ranges_.begin(), ranges_.end(), key);
+  if (it != ranges_.end() && *it == key)
+    ranges_.erase(it);
+}
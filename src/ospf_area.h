@@ -0,0 +1,90 @@
+#ifndef OSPF_AREA_H_P2WQ7DKM
+#define OSPF_AREA_H_P2WQ7DKM
+
+#include <vector>
+
+#include "fwk/ptr_interface.h"
+
+#include "ipv4_subnet.h"
+#include "ospf_adv_map.h"
+#include "ospf_node.h"
+#include "ospf_topology.h"
+#include "ospf_types.h"
+
+
+/* State of a single area of an OSPF router. Each area has a topology of its
+   own, rooted at a node with the router's RouterID whose links are the
+   gateways of the router's interfaces in that area. Routers in an area
+   only see the routers of that area; prefixes of other areas are
+   advertised into it as summaries by area border routers. */
+class OSPFArea : public Fwk::PtrInterface<OSPFArea> {
+ public:
+  typedef Fwk::Ptr<const OSPFArea> PtrConst;
+  typedef Fwk::Ptr<OSPFArea> Ptr;
+
+  static Ptr New(const AreaID& area_id, const RouterID& router_id) {
+    return new OSPFArea(area_id, router_id);
+  }
+
+  /* Accessors. */
+
+  const AreaID& areaID() const { return area_id_; }
+  bool backbone() const;
+
+  OSPFNode::PtrConst rootNode() const { return root_node_; }
+  OSPFNode::Ptr rootNode() { return root_node_; }
+
+  OSPFTopology::PtrConst topology() const { return topology_; }
+  OSPFTopology::Ptr topology() { return topology_; }
+
+  /* Advertisements received in this area that are not yet confirmed by
+     the advertised neighbor. */
+  OSPFAdvertisementMap::PtrConst advertisementsStaged() const {
+    return advs_staged_;
+  }
+  OSPFAdvertisementMap::Ptr advertisementsStaged() { return advs_staged_; }
+
+  /* Number of the router's interfaces in this area. */
+  size_t interfaces() const { return interfaces_; }
+
+  /* Prefixes of other areas that the router advertises into this area, in
+     order. */
+  const std::vector<IPv4Subnet>& summaries() const { return summaries_; }
+
+  /* Address ranges that summarize the prefixes of this area in the other
+     areas of the router. */
+  const std::vector<IPv4Subnet>& ranges() const { return ranges_; }
+
+  /* Prefix advertised into other areas in place of PREFIX, a prefix of this
+     area: the widest range that contains PREFIX, or PREFIX itself. */
+  IPv4Subnet summaryPrefix(const IPv4Subnet& prefix) const;
+
+  /* Mutators. */
+
+  void interfacesIs(size_t count) { interfaces_ = count; }
+  void summariesIs(const std::vector<IPv4Subnet>& summaries) {
+    summaries_ = summaries;
+  }
+
+  /* Adds or removes an address range; ranges are kept in order. */
+  void rangeIs(const IPv4Subnet& range);
+  void rangeDel(const IPv4Subnet& range);
+
+ private:
+  OSPFArea(const AreaID& area_id, const RouterID& router_id);
+
+  /* Data members. */
+  const AreaID area_id_;
+  OSPFNode::Ptr root_node_;
+  OSPFTopology::Ptr topology_;
+  OSPFAdvertisementMap::Ptr advs_staged_;
+  size_t interfaces_;
+  std::vector<IPv4Subnet> summaries_;
+  std::vector<IPv4Subnet> ranges_;
+
+  /* Operations disallowed. */
+  OSPFArea(const OSPFArea&);
+  void operator=(const OSPFArea&);
+};
+
+#endif
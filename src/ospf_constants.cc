@@ -6,8 +6,18 @@ const uint8_t kDefaultLinkStateInterval = 10;
 const uint8_t kDefaultHelloInterval = 5;
 const uint8_t kDefaultLinkStateUpdateTimeout = 3 * kDefaultLinkStateInterval;
 const uint32_t kLinkStateWindow = 10;
+const uint8_t kDefaultLinkStateRefreshIntervals = 6;
 const AreaID kDefaultAreaID = 0;
+const AreaID kBackboneAreaID = 0;
 const RouterID kPassiveEndpointID = 0;
 const RouterID kInvalidRouterID = 0xffffffff;
+const uint16_t kMinFastHelloInterval = 20;
+const uint8_t kDefaultFastHelloMultiplier = 3;
+const uint16_t kDefaultLinkCost = 1;
+const uint16_t kDefaultTunnelCost = 10;
+const uint32_t kReferenceBandwidth = 1000;
+const uint32_t kDefaultSPFInitialDelay = 50;
+const uint32_t kDefaultSPFHoldTime = 200;
+const uint32_t kDefaultSPFMaxWait = 5000;
 
 } /* end of namespace OSPF */
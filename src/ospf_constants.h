@@ -12,10 +12,34 @@ extern const uint8_t kDefaultLinkStateInterval;
 extern const uint8_t kDefaultHelloInterval;
 extern const uint8_t kDefaultLinkStateUpdateTimeout;
 extern const uint32_t kLinkStateWindow;
+
+/* Number of link-state intervals between complete LSUs when incremental
+   LSUs are enabled. */
+extern const uint8_t kDefaultLinkStateRefreshIntervals;
 extern const AreaID kDefaultAreaID;
+
+/* Inter-area prefixes are summarized into and out of the backbone area. */
+extern const AreaID kBackboneAreaID;
 extern const RouterID kPassiveEndpointID;
 extern const RouterID kInvalidRouterID;
 
+/* Fast HELLO packets. Intervals are in milliseconds. */
+extern const uint16_t kMinFastHelloInterval;
+extern const uint8_t kDefaultFastHelloMultiplier;
+
+/* Link costs. Interfaces cost kReferenceBandwidth divided by their speed
+   in Mbps, unless configured otherwise; tunnels cost kDefaultTunnelCost.
+   Links of unknown cost, such as those advertised by routers that do not
+   advertise costs, cost kDefaultLinkCost. */
+extern const uint16_t kDefaultLinkCost;
+extern const uint16_t kDefaultTunnelCost;
+extern const uint32_t kReferenceBandwidth;
+
+/* SPF throttling, in milliseconds. */
+extern const uint32_t kDefaultSPFInitialDelay;
+extern const uint32_t kDefaultSPFHoldTime;
+extern const uint32_t kDefaultSPFMaxWait;
+
 } /* end of namespace OSPF */
 
 #endif
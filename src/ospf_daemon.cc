@@ -23,59 +23,317 @@ static Fwk::Log::Ptr log_ = Fwk::Log::LogNew("OSPFDaemon");
 
 
 OSPFDaemon::Ptr
-OSPFDaemon::New(ControlPlane::Ptr cp, DataPlane::Ptr dp) {
-  return new OSPFDaemon(cp, dp);
+OSPFDaemon::New(ControlPlane::Ptr cp, DataPlane::Ptr dp,
+                TimerWheel::Ptr wheel) {
+  return new OSPFDaemon(cp, dp, wheel);
 }
 
-OSPFDaemon::OSPFDaemon(ControlPlane::Ptr cp, DataPlane::Ptr dp)
-    : PeriodicTask("OSPFDaemon"),
+OSPFDaemon::OSPFDaemon(ControlPlane::Ptr cp, DataPlane::Ptr dp,
+                       TimerWheel::Ptr wheel)
+    : Task("OSPFDaemon"),
       control_plane_(cp),
       data_plane_(dp),
       ospf_router_(cp->ospfRouter()),
+      wheel_(wheel),
       router_reactor_(RouterReactor::New(this)),
-      latest_lsu_(0) {
+      lsu_timer_(DaemonTimer::New(this, &OSPFDaemon::on_lsu_timer)),
+      topology_timer_(DaemonTimer::New(this, &OSPFDaemon::on_topology_timer)) {
   ospf_router_->notifieeIs(router_reactor_);
+
+  /* Interfaces and neighbors that existed before the daemon. */
+  OSPFInterfaceMap::Ptr iface_map = ospf_router_->interfaceMap();
+  OSPFInterfaceMap::if_iter if_it = iface_map->ifacesBegin();
+  for (; if_it != iface_map->ifacesEnd(); ++if_it) {
+    OSPFInterface::Ptr iface = if_it->second;
+    hello_timer_is(iface);
+
+    OSPFInterface::gwa_iter gw_it = iface->activeGatewaysBegin();
+    for (; gw_it != iface->activeGatewaysEnd(); ++gw_it)
+      dead_timer_is(iface, gw_it->second);
+  }
+
+  /* The first flood and sweep happen after a full interval, as they did
+     when the daemon polled once per second. */
+  timer_is(lsu_timer_, OSPF::kDefaultLinkStateInterval);
+  timer_is(topology_timer_, OSPF::kDefaultLinkStateUpdateTimeout + 1);
+}
+
+OSPFDaemon::~OSPFDaemon() {
+  InterfaceTimerMap* iface_timers[] = { &hello_timers_, &fast_hello_timers_ };
+  for (size_t i = 0; i < sizeof(iface_timers) / sizeof(*iface_timers); ++i) {
+    InterfaceTimerMap::iterator it;
+    for (it = iface_timers[i]->begin(); it != iface_timers[i]->end(); ++it)
+      wheel_->timerDel(it->second);
+  }
+
+  GatewayTimerMap* gw_timers[] = { &dead_timers_, &fast_dead_timers_ };
+  for (size_t i = 0; i < sizeof(gw_timers) / sizeof(*gw_timers); ++i) {
+    GatewayTimerMap::iterator it;
+    for (it = gw_timers[i]->begin(); it != gw_timers[i]->end(); ++it)
+      wheel_->timerDel(it->second);
+  }
+
+  wheel_->timerDel(lsu_timer_);
+  wheel_->timerDel(topology_timer_);
 }
 
 void
-OSPFDaemon::run() {
-  /* Removing links to neighbors who haven't sent a HELLO packet in more
-     than three times their advertised HELLOINT. */
-  timeout_neighbor_links();
+OSPFDaemon::tickIs(const Milliseconds& t) {
+  /* Spanning tree computations are throttled by the topology of each
+     area, independently of the others. */
+  OSPFRouter::area_iter it;
+  for (it = ospf_router_->areasBegin(); it != ospf_router_->areasEnd(); ++it)
+    it->second->topology()->onTick(t);
+
+  /* Flood changes to the router's own links, such as new neighbors. */
+  ospf_router_->onLinkStateUpdate();
+}
 
-  /* Removing nodes for whom no LSU has been received */
-  timeout_topology_entries();
+/* OSPFDaemon::RouterReactor */
 
-  /* Signal topology about possible seconds every second. */
-  ospf_router_->topology()->onUpdate();
+void
+OSPFDaemon::RouterReactor::onLinkStateFlood(OSPFRouter::Ptr _r) {
+  /* Periodic floods are due one interval after the latest flood. */
+  daemon_->timer_is(daemon_->lsu_timer_, OSPF::kDefaultLinkStateInterval);
+}
 
-  /* Sending HELLO packets to all connected neighbors
-     every iface.HELLOINT seconds. */
-  broadcast_timed_hello();
+void
+OSPFDaemon::RouterReactor::onInterface(OSPFRouter::Ptr _r,
+                                       OSPFInterface::Ptr iface) {
+  daemon_->hello_timer_is(iface);
+}
 
-  /* Timed flood of link-state updates. */
-  flood_timed_lsu();
+void
+OSPFDaemon::RouterReactor::onInterfaceDel(OSPFRouter::Ptr _r,
+                                          OSPFInterface::Ptr iface) {
+  daemon_->hello_timer_del(iface);
+}
+
+void
+OSPFDaemon::RouterReactor::onNeighbor(OSPFRouter::Ptr _r,
+                                      OSPFInterface::Ptr iface,
+                                      OSPFGateway::Ptr gw) {
+  daemon_->dead_timer_is(iface, gw);
 }
 
 void
-OSPFDaemon::timeSinceLSUIs(Seconds delta) {
-  latest_lsu_ = ::time(NULL) - delta.value();
+OSPFDaemon::RouterReactor::onNeighborDel(OSPFRouter::Ptr _r,
+                                         OSPFInterface::Ptr iface,
+                                         OSPFGateway::Ptr gw) {
+  daemon_->dead_timer_del(gw);
+}
+
+void
+OSPFDaemon::RouterReactor::onFastHello(OSPFRouter::Ptr _r,
+                                       OSPFInterface::Ptr iface,
+                                       OSPFGateway::Ptr gw) {
+  daemon_->fast_dead_timer_is(iface, gw);
 }
 
 /* OSPFDaemon private helper functions. */
 
 void
-OSPFDaemon::timeout_topology_entries() {
-  OSPFTopology::Ptr topology = ospf_router_->topology();
-  OSPFTopology::const_iterator it;
-  for (it = topology->nodesBegin(); it != topology->nodesEnd(); ++it) {
-    OSPFNode::Ptr node = it->second;
-    timeout_node_topology_entries(node);
+OSPFDaemon::timer_is(Timer::Ptr timer, time_t seconds) {
+  wheel_->timerIs(timer, wheel_->time().value() + seconds * 1000);
+}
+
+void
+OSPFDaemon::hello_timer_is(OSPFInterface::Ptr iface) {
+  InterfaceTimer::Ptr& timer = hello_timers_[iface.ptr()];
+  if (timer == NULL)
+    timer = InterfaceTimer::New(this, &OSPFDaemon::on_hello_timer, iface);
+
+  time_t remaining =
+    iface->helloint() - iface->timeSinceOutgoingHello().value();
+  timer_is(timer, remaining > 0 ? remaining : 0);
+}
+
+void
+OSPFDaemon::hello_timer_del(OSPFInterface::Ptr iface) {
+  InterfaceTimerMap::iterator it = hello_timers_.find(iface.ptr());
+  if (it != hello_timers_.end()) {
+    wheel_->timerDel(it->second);
+    hello_timers_.erase(it);
+  }
+
+  it = fast_hello_timers_.find(iface.ptr());
+  if (it != fast_hello_timers_.end()) {
+    wheel_->timerDel(it->second);
+    fast_hello_timers_.erase(it);
+  }
+}
+
+void
+OSPFDaemon::on_hello_timer(OSPFInterface::Ptr iface) {
+  if (ospf_router_->enabled()
+      && iface->timeSinceOutgoingHello() >= iface->helloint()) {
+    DLOG << "Sending HELLO out of " << iface->interfaceName();
+    broadcast_hello_out_interface(iface);
+
+    /* Once elections are disabled, a last packet with a priority of zero
+       tells neighbors to stop counting on this router. */
+    if (iface->drPriority() != 0 || iface->drPriorityAnnounced() != 0)
+      broadcast_election_out_interface(iface);
+  }
+
+  /* While the router is disabled, the timer keeps checking once per
+     HELLOINT. */
+  time_t remaining =
+    iface->helloint() - iface->timeSinceOutgoingHello().value();
+  timer_is(hello_timers_[iface.ptr()],
+           remaining > 0 ? remaining : iface->helloint());
+
+  fast_hello_timer_is(iface);
+}
+
+void
+OSPFDaemon::fast_hello_timer_is(OSPFInterface::Ptr iface) {
+  if (iface->fastHelloInterval() == 0
+      || fast_hello_timers_.find(iface.ptr()) != fast_hello_timers_.end()) {
+    return;
+  }
+
+  ILOG << "Sending fast HELLOs every " << iface->fastHelloInterval()
+       << " ms out of " << iface->interfaceName();
+
+  InterfaceTimer::Ptr timer =
+    InterfaceTimer::New(this, &OSPFDaemon::on_fast_hello_timer, iface);
+  fast_hello_timers_[iface.ptr()] = timer;
+  wheel_->timerIs(timer, wheel_->time());
+}
+
+void
+OSPFDaemon::on_fast_hello_timer(OSPFInterface::Ptr iface) {
+  uint16_t interval = iface->fastHelloInterval();
+  if (ospf_router_->enabled())
+    broadcast_fast_hello_out_interface(iface, interval);
+
+  InterfaceTimerMap::iterator it = fast_hello_timers_.find(iface.ptr());
+  if (interval == 0) {
+    ILOG << "Stopped fast HELLOs out of " << iface->interfaceName();
+    fast_hello_timers_.erase(it);
+    return;
+  }
+
+  wheel_->timerIs(it->second, wheel_->time().value() + interval);
+}
+
+void
+OSPFDaemon::dead_timer_is(OSPFInterface::Ptr iface, OSPFGateway::Ptr gw) {
+  GatewayTimer::Ptr& timer = dead_timers_[gw.ptr()];
+  if (timer == NULL)
+    timer = GatewayTimer::New(this, &OSPFDaemon::on_dead_timer, iface, gw);
+
+  /* The neighbor is dead once more than 3 * HELLOINT seconds have passed. */
+  time_t remaining = 3 * iface->helloint() + 1 - gw->timeSinceHello();
+  timer_is(timer, remaining > 0 ? remaining : 0);
+}
+
+void
+OSPFDaemon::dead_timer_del(OSPFGateway::Ptr gw) {
+  GatewayTimerMap::iterator it = dead_timers_.find(gw.ptr());
+  if (it != dead_timers_.end()) {
+    wheel_->timerDel(it->second);
+    dead_timers_.erase(it);
+  }
+
+  it = fast_dead_timers_.find(gw.ptr());
+  if (it != fast_dead_timers_.end()) {
+    wheel_->timerDel(it->second);
+    fast_dead_timers_.erase(it);
+  }
+}
+
+void
+OSPFDaemon::fast_dead_timer_is(OSPFInterface::Ptr iface, OSPFGateway::Ptr gw) {
+  GatewayTimerMap::iterator it = fast_dead_timers_.find(gw.ptr());
+  if (gw->fastHelloDetectTime() == 0) {
+    if (it != fast_dead_timers_.end()) {
+      wheel_->timerDel(it->second);
+      fast_dead_timers_.erase(it);
+    }
+    return;
+  }
+
+  GatewayTimer::Ptr timer;
+  if (it != fast_dead_timers_.end()) {
+    timer = it->second;
+  } else {
+    timer =
+      GatewayTimer::New(this, &OSPFDaemon::on_fast_dead_timer, iface, gw);
+    fast_dead_timers_[gw.ptr()] = timer;
+  }
+
+  wheel_->timerIs(timer, wheel_->time().value() + gw->fastHelloDetectTime());
+}
+
+void
+OSPFDaemon::on_dead_timer(OSPFInterface::Ptr iface, OSPFGateway::Ptr gw) {
+  if (gw->timeSinceHello() <= 3 * iface->helloint()) {
+    /* A HELLO packet has been received since the timer was armed. */
+    dead_timer_is(iface, gw);
+    return;
+  }
+
+  /* No HELLO packet has been received from this neighbor in more than
+     three times its advertised HELLOINT. Remove from topology and trigger
+     LSU flood. */
+  ILOG << "Timeout: Active gateway with subnet " << gw->subnet() << " to nbr "
+       << gw->nodeRouterID();
+  neighbor_del(iface, gw);
+}
+
+void
+OSPFDaemon::on_fast_dead_timer(OSPFInterface::Ptr iface, OSPFGateway::Ptr gw) {
+  ILOG << "Fast HELLO timeout: Active gateway with subnet " << gw->subnet()
+       << " to nbr " << gw->nodeRouterID() << " after "
+       << gw->fastHelloDetectTime() << " ms";
+  neighbor_del(iface, gw);
+}
+
+void
+OSPFDaemon::neighbor_del(OSPFInterface::Ptr iface, OSPFGateway::Ptr gw) {
+  /* Cancels the neighbor's timers through onNeighborDel(). The link to the
+     neighbor is removed from the topology, which schedules a spanning tree
+     computation. */
+  iface->activeGatewayDel(gw->nodeRouterID());
+
+  /* Signal change to router's link state. */
+  ospf_router_->onLinkStateUpdate();
+}
+
+void
+OSPFDaemon::on_lsu_timer() {
+  ospf_router_->onLinkStateInterval();
+
+  /* Re-armed by onLinkStateFlood() if the router flooded; otherwise the
+     next check is one interval from now. */
+  timer_is(lsu_timer_, OSPF::kDefaultLinkStateInterval);
+}
+
+void
+OSPFDaemon::on_topology_timer() {
+  /* Links that are added later time out after the ones checked here. */
+  time_t next = OSPF::kDefaultLinkStateUpdateTimeout + 1;
+
+  OSPFRouter::area_iter ar_it;
+  for (ar_it = ospf_router_->areasBegin(); ar_it != ospf_router_->areasEnd();
+       ++ar_it) {
+    OSPFArea::Ptr area = ar_it->second;
+    OSPFTopology::Ptr topology = area->topology();
+    OSPFTopology::const_iterator it;
+    for (it = topology->nodesBegin(); it != topology->nodesEnd(); ++it) {
+      OSPFNode::Ptr node = it->second;
+      timeout_node_topology_entries(area->areaID(), node, next);
+    }
   }
+
+  timer_is(topology_timer_, next > 1 ? next : 1);
 }
 
 void
-OSPFDaemon::timeout_node_topology_entries(OSPFNode::Ptr node) {
+OSPFDaemon::timeout_node_topology_entries(const AreaID& area_id,
+                                          OSPFNode::Ptr node, time_t& next) {
   if (node->isPassiveEndpoint()) {
     ELOG << "timeout_node_topology_entries: Attempt to timeout links "
          << "associated with a non-OSPF endpoint";
@@ -91,36 +349,37 @@ OSPFDaemon::timeout_node_topology_entries(OSPFNode::Ptr node) {
     RouterID peer_id = link->node()->routerID();
 
     if (ospf_router_->routerID() == peer_id
-        && ospf_router_->interfaceMap()->activeGateway(nd_id) != NULL) {
+        && ospf_router_->interfaceMap()->activeGateway(nd_id, area_id)) {
       /* Do not remove link if NODE is directly connected to this router.
          HELLO protocol takes precedence. */
       continue;
     }
 
-    if (link->timeSinceLSU() > OSPF::kDefaultLinkStateUpdateTimeout) {
+    time_t remaining =
+      OSPF::kDefaultLinkStateUpdateTimeout + 1 - link->timeSinceLSU();
+    if (remaining <= 0) {
       ILOG << "Timeout: Active link between " << nd_id << " and "
            << peer_id;
       del_links.pushFront(link);
+    } else if (remaining < next) {
+      next = remaining;
     }
   }
 
   for (OSPFNode::const_lnp_iter it = node->passiveLinksBegin();
        it != node->passiveLinksEnd(); ++it) {
     OSPFLink::Ptr link = it->second;
-    if (link->timeSinceLSU() > OSPF::kDefaultLinkStateUpdateTimeout){
+    time_t remaining =
+      OSPF::kDefaultLinkStateUpdateTimeout + 1 - link->timeSinceLSU();
+    if (remaining <= 0) {
       ILOG << "Timeout: Passive link between " << nd_id << " and subnet "
            << link->subnet();
       del_links.pushFront(link);
+    } else if (remaining < next) {
+      next = remaining;
     }
   }
 
-  for (OSPFNode::const_lnp_iter it = node->passiveLinksBegin();
-       it != node->passiveLinksEnd(); ++it) {
-    OSPFLink::Ptr link = it->second;
-    if (link->timeSinceLSU() > OSPF::kDefaultLinkStateUpdateTimeout)
-      del_links.pushFront(link);
-  }
-
   Fwk::Deque<OSPFLink::Ptr>::const_iterator del_it;
   for (del_it = del_links.begin(); del_it != del_links.end(); ++del_it) {
     OSPFLink::Ptr link = *del_it;
@@ -132,78 +391,85 @@ OSPFDaemon::timeout_node_topology_entries(OSPFNode::Ptr node) {
 }
 
 void
-OSPFDaemon::timeout_neighbor_links() {
-  OSPFInterfaceMap::PtrConst ifaces = ospf_router_->interfaceMap();
-  OSPFInterfaceMap::const_if_iter if_it = ifaces->ifacesBegin();
-  for (; if_it != ifaces->ifacesEnd(); ++if_it) {
-    OSPFInterface::Ptr iface = if_it->second;
-    timeout_interface_neighbor_links(iface);
-  }
+OSPFDaemon::broadcast_hello_out_interface(OSPFInterface::Ptr iface) {
+  size_t ip_pkt_len = OSPFHelloPacket::kPacketSize + IPPacket::kHeaderSize;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(ip_pkt_len);
 
-  /* Signal possible change to router's link state. */
-  ospf_router_->onLinkStateUpdate();
-}
+  OSPFHelloPacket::Ptr ospf_pkt =
+    OSPFHelloPacket::NewDefault(buffer,
+                                ospf_router_->routerID(),
+                                iface->linkedAreaID(),
+                                iface->interfaceSubnetMask(),
+                                iface->helloint());
 
-void
-OSPFDaemon::timeout_interface_neighbor_links(OSPFInterface::Ptr iface) {
-  Fwk::Deque<OSPFGateway::Ptr> del_gw;
+  IPPacket::Ptr ip_pkt =
+    IPPacket::NewDefault(buffer, ip_pkt_len,
+                         IPPacket::kOSPF,
+                         iface->interfaceIP(),
+                         OSPFHelloPacket::kBroadcastAddr);
 
-  OSPFInterface::const_gwa_iter gw_it = iface->activeGatewaysBegin();
-  for (; gw_it != iface->activeGatewaysEnd(); ++gw_it) {
-    OSPFGateway::Ptr gw = gw_it->second;
-    if (gw->timeSinceHello() > 3 * iface->helloint()) {
-      /* No HELLO packet has been received from this neighbor in more than
-         three times its advertised HELLOINT. Remove from topology and
-         trigger LSU flood. */
-      del_gw.pushFront(gw);
-    }
-  }
+  /* IPPacket fields: */
+  ip_pkt->ttlIs(1);
+  ip_pkt->checksumReset();
 
-  Fwk::Deque<OSPFGateway::Ptr>::const_iterator del_it;
-  for (del_it = del_gw.begin(); del_it != del_gw.end(); ++del_it) {
-    OSPFGateway::Ptr gw = *del_it;
+  /* Setting enclosing packet. */
+  ospf_pkt->enclosingPacketIs(ip_pkt);
 
-    RouterID nbr_id = gw->nodeRouterID();
-    ILOG << "Timeout: Active gateway with subnet " << gw->subnet() << " to nbr "
-         << nbr_id;
+  /* Send broadcast Ethernet packet. */
+  control_plane_->outputRawPacketNew(ip_pkt,
+                                     iface->interface(),
+                                     IPv4Addr::kZero,
+                                     EthernetAddr::kBroadcast);
 
-    iface->activeGatewayDel(nbr_id);
-  }
+  /* Resetting time since last HELLO. */
+  iface->timeSinceOutgoingHelloIs(0);
 }
 
 void
-OSPFDaemon::broadcast_timed_hello() {
-  if (!ospf_router_->enabled())
-    return;
+OSPFDaemon::broadcast_fast_hello_out_interface(OSPFInterface::Ptr iface,
+                                               uint16_t interval) {
+  size_t ip_pkt_len = OSPFFastHelloPacket::kPacketSize + IPPacket::kHeaderSize;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(ip_pkt_len);
 
-  OSPFInterfaceMap::PtrConst iface_map = ospf_router_->interfaceMap();
-  OSPFInterfaceMap::const_if_iter if_it = iface_map->ifacesBegin();
+  OSPFFastHelloPacket::Ptr ospf_pkt =
+    OSPFFastHelloPacket::NewDefault(buffer,
+                                    ospf_router_->routerID(),
+                                    iface->linkedAreaID(),
+                                    interval,
+                                    iface->fastHelloMultiplier());
+  ospf_pkt->checksumReset();
 
-  bool hello_logged = false;
-  for (; if_it != iface_map->ifacesEnd(); ++if_it) {
-    OSPFInterface::Ptr iface = if_it->second;
-    if (iface->timeSinceOutgoingHello() >= iface->helloint()) {
-      if (!hello_logged) {
-        ILOG << "Sending HELLO";
-        hello_logged = true;
-      }
+  IPPacket::Ptr ip_pkt =
+    IPPacket::NewDefault(buffer, ip_pkt_len,
+                         IPPacket::kOSPF,
+                         iface->interfaceIP(),
+                         OSPFHelloPacket::kBroadcastAddr);
 
-      broadcast_hello_out_interface(iface);
-    }
-  }
+  /* IPPacket fields: */
+  ip_pkt->ttlIs(1);
+  ip_pkt->checksumReset();
+
+  /* Setting enclosing packet. */
+  ospf_pkt->enclosingPacketIs(ip_pkt);
+
+  /* Send broadcast Ethernet packet. */
+  control_plane_->outputRawPacketNew(ip_pkt,
+                                     iface->interface(),
+                                     IPv4Addr::kZero,
+                                     EthernetAddr::kBroadcast);
 }
 
 void
-OSPFDaemon::broadcast_hello_out_interface(OSPFInterface::Ptr iface) {
-  size_t ip_pkt_len = OSPFHelloPacket::kPacketSize + IPPacket::kHeaderSize;
+OSPFDaemon::broadcast_election_out_interface(OSPFInterface::Ptr iface) {
+  size_t ip_pkt_len = OSPFElectionPacket::kPacketSize + IPPacket::kHeaderSize;
   PacketBuffer::Ptr buffer = PacketBuffer::New(ip_pkt_len);
 
-  OSPFHelloPacket::Ptr ospf_pkt =
-    OSPFHelloPacket::NewDefault(buffer,
-                                ospf_router_->routerID(),
-                                ospf_router_->areaID(),
-                                iface->interfaceSubnetMask(),
-                                iface->helloint());
+  OSPFElectionPacket::Ptr ospf_pkt =
+    OSPFElectionPacket::NewDefault(buffer,
+                                   ospf_router_->routerID(),
+                                   iface->linkedAreaID(),
+                                   iface->drPriority());
+  ospf_pkt->checksumReset();
 
   IPPacket::Ptr ip_pkt =
     IPPacket::NewDefault(buffer, ip_pkt_len,
@@ -224,16 +490,5 @@ OSPFDaemon::broadcast_hello_out_interface(OSPFInterface::Ptr iface) {
                                      IPv4Addr::kZero,
                                      EthernetAddr::kBroadcast);
 
-  /* Resetting time since last HELLO. */
-  iface->timeSinceOutgoingHelloIs(0);
-}
-
-void
-OSPFDaemon::flood_timed_lsu() {
-  if (timeSinceLSU() >= OSPF::kDefaultLinkStateInterval) {
-    ospf_router_->onLinkStateInterval();
-
-    /* Resetting time since last LSU. */
-    timeSinceLSUIs(0);
-  }
+  iface->drPriorityAnnouncedIs(iface->drPriority());
 }
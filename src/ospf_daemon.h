@@ -2,30 +2,44 @@
 #define OSPF_DAEMON_H_
 
 #include <ctime>
+#include <map>
 
 #include "fwk/ptr.h"
 
+#include "ospf_gateway.h"
+#include "ospf_interface.h"
 #include "ospf_router.h"
 #include "ospf_types.h"
 #include "task.h"
 #include "time_types.h"
 
 /* Forward declarations. */
-class OSPFInterface;
 class OSPFNode;
 class ControlPlane;
 class DataPlane;
 
 
-class OSPFDaemon : public PeriodicTask {
+/* Drives the timed parts of the OSPF protocol from timers on the task
+   manager's timer wheel: HELLO, fast HELLO and election packets on each
+   interface, the dead intervals of each neighbor, the periodic LSU flood,
+   and the timeout of links in the topology that are no longer advertised. */
+class OSPFDaemon : public Task {
  public:
   typedef Fwk::Ptr<const OSPFDaemon> PtrConst;
   typedef Fwk::Ptr<OSPFDaemon> Ptr;
 
-  static Ptr New(Fwk::Ptr<ControlPlane> cp, Fwk::Ptr<DataPlane> dp);
+  static Ptr New(Fwk::Ptr<ControlPlane> cp, Fwk::Ptr<DataPlane> dp,
+                 TimerWheel::Ptr wheel);
+
+  /* Override. Recomputes the topology's spanning tree as soon as the SPF
+     throttle allows it, and floods pending changes to the router's link
+     state. */
+  void tickIs(const Milliseconds& t);
 
  protected:
-  OSPFDaemon(Fwk::Ptr<ControlPlane> cp, Fwk::Ptr<DataPlane> dp);
+  OSPFDaemon(Fwk::Ptr<ControlPlane> cp, Fwk::Ptr<DataPlane> dp,
+             TimerWheel::Ptr wheel);
+  ~OSPFDaemon();
 
   class RouterReactor : public OSPFRouter::Notifiee {
    public:
@@ -36,7 +50,15 @@ class OSPFDaemon : public PeriodicTask {
       return new RouterReactor(daemon);
     }
 
-    void onLinkStateFlood(OSPFRouter::Ptr _r) { daemon_->timeSinceLSUIs(0); }
+    void onLinkStateFlood(OSPFRouter::Ptr _r);
+    void onInterface(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface);
+    void onInterfaceDel(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface);
+    void onNeighbor(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface,
+                    OSPFGateway::Ptr gw);
+    void onNeighborDel(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface,
+                       OSPFGateway::Ptr gw);
+    void onFastHello(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface,
+                     OSPFGateway::Ptr gw);
 
    private:
     RouterReactor(OSPFDaemon* daemon) : daemon_(daemon) {}
@@ -49,52 +71,177 @@ class OSPFDaemon : public PeriodicTask {
     void operator=(const RouterReactor&);
   };
 
-  /* Override. */
-  void run();
+  /* Timer that calls a member function of the daemon. */
+  class DaemonTimer : public Timer {
+   public:
+    typedef Fwk::Ptr<const DaemonTimer> PtrConst;
+    typedef Fwk::Ptr<DaemonTimer> Ptr;
+
+    typedef void (OSPFDaemon::*Handler)();
+
+    static Ptr New(OSPFDaemon* daemon, Handler handler) {
+      return new DaemonTimer(daemon, handler);
+    }
+
+   private:
+    DaemonTimer(OSPFDaemon* daemon, Handler handler)
+        : daemon_(daemon), handler_(handler) {}
+
+    void onExpiry() { (daemon_->*handler_)(); }
+
+    /* Data members. */
+    OSPFDaemon* daemon_;
+    Handler handler_;
+  };
+
+  /* Timer that calls a member function of the daemon for an interface. */
+  class InterfaceTimer : public Timer {
+   public:
+    typedef Fwk::Ptr<const InterfaceTimer> PtrConst;
+    typedef Fwk::Ptr<InterfaceTimer> Ptr;
+
+    typedef void (OSPFDaemon::*Handler)(OSPFInterface::Ptr);
+
+    static Ptr New(OSPFDaemon* daemon, Handler handler,
+                   OSPFInterface::Ptr iface) {
+      return new InterfaceTimer(daemon, handler, iface);
+    }
+
+   private:
+    InterfaceTimer(OSPFDaemon* daemon, Handler handler,
+                   OSPFInterface::Ptr iface)
+        : daemon_(daemon), handler_(handler), iface_(iface) {}
+
+    void onExpiry() { (daemon_->*handler_)(iface_); }
+
+    /* Data members. */
+    OSPFDaemon* daemon_;
+    Handler handler_;
+    OSPFInterface::Ptr iface_;
+  };
+
+  /* Timer that calls a member function of the daemon for a neighbor. */
+  class GatewayTimer : public Timer {
+   public:
+    typedef Fwk::Ptr<const GatewayTimer> PtrConst;
+    typedef Fwk::Ptr<GatewayTimer> Ptr;
+
+    typedef void (OSPFDaemon::*Handler)(OSPFInterface::Ptr, OSPFGateway::Ptr);
 
-  /* --  Private attributes -- */
+    static Ptr New(OSPFDaemon* daemon, Handler handler,
+                   OSPFInterface::Ptr iface, OSPFGateway::Ptr gw) {
+      return new GatewayTimer(daemon, handler, iface, gw);
+    }
 
-  Seconds timeSinceLSU() const { return ::time(NULL) - latest_lsu_; }
-  void timeSinceLSUIs(Seconds delta);
+   private:
+    GatewayTimer(OSPFDaemon* daemon, Handler handler,
+                 OSPFInterface::Ptr iface, OSPFGateway::Ptr gw)
+        : daemon_(daemon), handler_(handler), iface_(iface), gw_(gw) {}
+
+    void onExpiry() { (daemon_->*handler_)(iface_, gw_); }
+
+    /* Data members. */
+    OSPFDaemon* daemon_;
+    Handler handler_;
+    OSPFInterface::Ptr iface_;
+    OSPFGateway::Ptr gw_;
+  };
 
   /* -- OSPFDaemon private helper functions. -- */
 
-  /* Removes topology entries that have not been confirmed by an LSU in
-     more than LSU_TIMEOUT seconds.*/
-  void timeout_topology_entries();
+  /* Arms TIMER to fire SECONDS from now. */
+  void timer_is(Timer::Ptr timer, time_t seconds);
+
+  /* Arms the HELLO timer of IFACE to fire when its next HELLO is due. */
+  void hello_timer_is(Fwk::Ptr<OSPFInterface> iface);
+
+  /* Cancels the HELLO timer of IFACE. */
+  void hello_timer_del(Fwk::Ptr<OSPFInterface> iface);
+
+  /* Sends a HELLO packet out of IFACE if one is due, and re-arms its
+     timer. Also starts fast HELLOs on IFACE if they have been enabled. */
+  void on_hello_timer(Fwk::Ptr<OSPFInterface> iface);
 
-  /* Helper function for timeout_topology_entries(). Accomplishes its task
-     for a single node. */
-  void timeout_node_topology_entries(Fwk::Ptr<OSPFNode> node);
+  /* Starts sending fast HELLO packets out of IFACE if they are enabled and
+     not already being sent. */
+  void fast_hello_timer_is(Fwk::Ptr<OSPFInterface> iface);
 
-  /* Removes links to neighbors who haven't sent a HELLO packet in more
-     than three times their advertised HELLOINT. */
-  void timeout_neighbor_links();
+  /* Sends a fast HELLO packet out of IFACE and re-arms its timer. Once fast
+     HELLOs are disabled, a last packet with an interval of zero tells
+     neighbors to stop expecting them. */
+  void on_fast_hello_timer(Fwk::Ptr<OSPFInterface> iface);
 
-  /* Helper function for timeout_neighbor_links(). Accomplishes its task
-     for a single interface. */
-  void timeout_interface_neighbor_links(Fwk::Ptr<OSPFInterface> iface);
+  /* Arms the dead-interval timer of the neighbor reached through GW to fire
+     once three times IFACE's HELLOINT have passed without a HELLO. */
+  void dead_timer_is(Fwk::Ptr<OSPFInterface> iface, Fwk::Ptr<OSPFGateway> gw);
 
-  /* For all neighbors N_i, sends a HELLO packet to N_i if the last HELLO sent
-     through the interface, J_i, that N_i is connected to, occurred more than
-     J_i.HELLOINT seconds ago. */
-  void broadcast_timed_hello();
+  /* Cancels the dead-interval timers of GW. */
+  void dead_timer_del(Fwk::Ptr<OSPFGateway> gw);
+
+  /* Re-arms the fast dead-interval timer of GW after a fast HELLO, or
+     cancels it if the neighbor stopped sending them. */
+  void fast_dead_timer_is(Fwk::Ptr<OSPFInterface> iface,
+                          Fwk::Ptr<OSPFGateway> gw);
+
+  /* Removes the link to a neighbor that hasn't sent a HELLO packet in more
+     than three times its advertised HELLOINT. HELLOs refresh the gateway
+     without notification, so the timer re-arms itself if one has been
+     received since it was armed. */
+  void on_dead_timer(Fwk::Ptr<OSPFInterface> iface, Fwk::Ptr<OSPFGateway> gw);
+
+  /* Removes the link to a neighbor that stopped sending fast HELLOs. */
+  void on_fast_dead_timer(Fwk::Ptr<OSPFInterface> iface,
+                          Fwk::Ptr<OSPFGateway> gw);
+
+  /* Removes the link to the neighbor reached through GW on IFACE and floods
+     the change. */
+  void neighbor_del(Fwk::Ptr<OSPFInterface> iface, Fwk::Ptr<OSPFGateway> gw);
+
+  /* Triggers LSU floods to all directly connected neighbors. */
+  void on_lsu_timer();
+
+  /* Removes topology entries that have not been confirmed by an LSU in
+     more than LSU_TIMEOUT seconds, then re-arms the topology timer for the
+     earliest time at which a remaining entry can time out. */
+  void on_topology_timer();
+
+  /* Helper function for on_topology_timer(). Accomplishes its task for a
+     single node in the topology of area AREA_ID, lowering NEXT to the
+     number of seconds until the earliest remaining link of NODE times
+     out. */
+  void timeout_node_topology_entries(const AreaID& area_id,
+                                     Fwk::Ptr<OSPFNode> node, time_t& next);
 
   /* Sends a HELLO packet to all neighbors connected to interface IFACE. */
   void broadcast_hello_out_interface(Fwk::Ptr<OSPFInterface> iface);
 
-  /* Triggers LSU floods to all directly connected neighbors. */
-  void flood_timed_lsu();
+  /* Sends a fast HELLO packet announcing INTERVAL to all neighbors connected
+     to interface IFACE. */
+  void broadcast_fast_hello_out_interface(Fwk::Ptr<OSPFInterface> iface,
+                                          uint16_t interval);
+
+  /* Announces the designated-router priority of this router on IFACE to
+     all neighbors connected to it. */
+  void broadcast_election_out_interface(Fwk::Ptr<OSPFInterface> iface);
+
+  typedef std::map<OSPFInterface*,InterfaceTimer::Ptr> InterfaceTimerMap;
+  typedef std::map<OSPFGateway*,GatewayTimer::Ptr> GatewayTimerMap;
 
   /* Data members. */
   Fwk::Ptr<ControlPlane> control_plane_;
   Fwk::Ptr<DataPlane> data_plane_;
   Fwk::Ptr<OSPFRouter> ospf_router_;
+  TimerWheel::Ptr wheel_;
 
   /* Reactor to Router notifications. */
   RouterReactor::Ptr router_reactor_;
 
-  time_t latest_lsu_;
+  InterfaceTimerMap hello_timers_;
+  InterfaceTimerMap fast_hello_timers_;
+  GatewayTimerMap dead_timers_;
+  GatewayTimerMap fast_dead_timers_;
+  DaemonTimer::Ptr lsu_timer_;
+  DaemonTimer::Ptr topology_timer_;
 
   /* Operations disallowed. */
   OSPFDaemon(const OSPFDaemon&);
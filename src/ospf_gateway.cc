@@ -24,14 +24,18 @@ OSPFGateway::OSPFGateway(Fwk::Ptr<OSPFNode> neighbor,
                          const IPv4Addr& subnet_mask)
     : OSPFLink::OSPFLink(neighbor, subnet, subnet_mask),
       gateway_(gateway),
-      last_hello_(time(NULL)) {}
+      last_hello_(time(NULL)),
+      fast_hello_detect_time_(0),
+      dr_priority_(0) {}
 
 OSPFGateway::OSPFGateway(const IPv4Addr& gateway,
                          const IPv4Addr& subnet,
                          const IPv4Addr& mask)
     : OSPFLink::OSPFLink(subnet, mask),
       gateway_(gateway),
-      last_hello_(time(NULL)) {}
+      last_hello_(time(NULL)),
+      fast_hello_detect_time_(0),
+      dr_priority_(0) {}
 
 const OSPFInterface*
 OSPFGateway::interface() const {
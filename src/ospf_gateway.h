@@ -2,6 +2,7 @@
 #define OSPF_GATEWAY_H_CTXOEZOH
 
 #include <ctime>
+#include <inttypes.h>
 
 #include "ipv4_addr.h"
 #include "ospf_link.h"
@@ -30,6 +31,17 @@ class OSPFGateway : public OSPFLink {
   time_t timeSinceHello() const { return time(NULL) - last_hello_; }
   void timeSinceHelloIs(time_t _t) { last_hello_ = time(NULL) - _t; }
 
+  /* Milliseconds without a fast HELLO packet after which the neighbor is
+     dead, as announced in its latest fast HELLO. Zero if the neighbor does
+     not send fast HELLOs. */
+  uint32_t fastHelloDetectTime() const { return fast_hello_detect_time_; }
+  void fastHelloDetectTimeIs(uint32_t ms) { fast_hello_detect_time_ = ms; }
+
+  /* Designated-router priority announced by the neighbor, or zero if it
+     does not take part in designated-router elections. */
+  uint8_t drPriority() const { return dr_priority_; }
+  void drPriorityIs(uint8_t priority) { dr_priority_ = priority; }
+
   const OSPFInterface* interface() const;
   OSPFInterface* interface();
   void interfaceIs(OSPFInterface* iface);
@@ -51,6 +63,8 @@ class OSPFGateway : public OSPFLink {
   /* Data members. */
   IPv4Addr gateway_;
   time_t last_hello_;
+  uint32_t fast_hello_detect_time_;
+  uint8_t dr_priority_;
   OSPFInterface* iface_;
 
   /* Operations disallowed. */
@@ -1,6 +1,9 @@
 #include "ospf_interface.h"
 
+#include <utility>
+
 #include "interface.h"
+#include "ospf_constants.h"
 
 OSPFInterface::Ptr
 OSPFInterface::New(Fwk::Ptr<const Interface> iface, uint16_t helloint) {
@@ -8,7 +11,16 @@ OSPFInterface::New(Fwk::Ptr<const Interface> iface, uint16_t helloint) {
 }
 
 OSPFInterface::OSPFInterface(Interface::PtrConst iface, uint16_t helloint)
-    : iface_(iface), helloint_(helloint), last_outgoing_hello_(0) {}
+    : iface_(iface), helloint_(helloint), last_outgoing_hello_(0),
+      fast_hello_interval_(0),
+      fast_hello_multiplier_(OSPF::kDefaultFastHelloMultiplier),
+      configured_cost_(0),
+      dr_priority_(0),
+      dr_priority_announced_(0),
+      designated_router_(OSPF::kInvalidRouterID),
+      backup_designated_router_(OSPF::kInvalidRouterID),
+      area_id_(OSPF::kDefaultAreaID),
+      linked_area_id_(OSPF::kDefaultAreaID) {}
 
 Interface::PtrConst
 OSPFInterface::interface() const {
@@ -35,6 +47,40 @@ OSPFInterface::interfaceName() const {
   return iface_->name();
 }
 
+uint16_t
+OSPFInterface::cost() const {
+  if (configured_cost_)
+    return configured_cost_;
+
+  /* The speed of a tunnel is that of the path to its remote endpoint, which
+     is unknown. */
+  if (iface_->type() == Interface::kVirtual)
+    return OSPF::kDefaultTunnelCost;
+
+  uint32_t speed = iface_->speed();
+  if (speed == 0)
+    return OSPF::kDefaultLinkCost;
+
+  uint32_t cost = OSPF::kReferenceBandwidth / speed;
+  if (cost < 1)
+    return 1;
+
+  return (cost > 0xffff) ? 0xffff : cost;
+}
+
+OSPFInterface::FloodMode
+OSPFInterface::floodMode(const RouterID& router_id, bool received_here) const {
+  if (designated_router_ == OSPF::kInvalidRouterID)
+    return kFloodNeighbors;
+
+  if (designated_router_ == router_id)
+    return kFloodSegment;
+
+  /* Packets received from the segment are forwarded on it by the
+     designated router. */
+  return received_here ? kFloodNone : kFloodDesignated;
+}
+
 Seconds
 OSPFInterface::timeSinceOutgoingHello() const {
   return time(NULL) - last_outgoing_hello_;
@@ -90,11 +136,55 @@ OSPFInterface::gatewayIs(OSPFGateway::Ptr gw_obj) {
 
   /* Adding this interface to gw_obj. */
   gw_obj->interfaceIs(this);
+  gw_obj->costIs(cost());
 
   if (notifiee_ && (gw_prev == NULL || *gw_obj != *gw_prev))
     notifiee_->onGateway(this, gw_obj);
 }
 
+bool
+OSPFInterface::designatedRouterElect(const RouterID& router_id) {
+  typedef std::pair<uint8_t,RouterID> Candidate;
+  Candidate dr(0, OSPF::kInvalidRouterID);
+  Candidate bdr(0, OSPF::kInvalidRouterID);
+
+  bool elect = dr_priority_ > 0 && iface_->type() != Interface::kVirtual &&
+               !active_gateways_.empty();
+  if (elect)
+    dr = Candidate(dr_priority_, router_id);
+
+  for (const_gwa_iter it = active_gateways_.begin();
+       elect && it != active_gateways_.end(); ++it) {
+    OSPFGateway::PtrConst gw_obj = it->second;
+    if (gw_obj->drPriority() == 0) {
+      elect = false;
+      break;
+    }
+
+    Candidate candidate(gw_obj->drPriority(), gw_obj->nodeRouterID());
+    if (dr < candidate) {
+      bdr = dr;
+      dr = candidate;
+    } else if (bdr < candidate) {
+      bdr = candidate;
+    }
+  }
+
+  if (!elect) {
+    dr.second = OSPF::kInvalidRouterID;
+    bdr.second = OSPF::kInvalidRouterID;
+  }
+
+  if (dr.second == designated_router_
+      && bdr.second == backup_designated_router_) {
+    return false;
+  }
+
+  designated_router_ = dr.second;
+  backup_designated_router_ = bdr.second;
+  return true;
+}
+
 void
 OSPFInterface::activeGatewayDel(const RouterID& router_id) {
   OSPFGateway::Ptr gw_obj = activeGateway(router_id);
@@ -31,6 +31,14 @@ class OSPFInterface : public Fwk::PtrInterface<OSPFInterface> {
   typedef Fwk::Map<IPv4Subnet,OSPFGateway>::iterator gwp_iter;
   typedef Fwk::Map<IPv4Subnet,OSPFGateway>::const_iterator const_gwp_iter;
 
+  /* Recipients of a flooded packet on this interface. */
+  enum FloodMode {
+    kFloodNeighbors,  /* A copy to every neighbor. */
+    kFloodDesignated, /* A copy to the designated and backup routers. */
+    kFloodSegment,    /* A single copy to all routers on the segment. */
+    kFloodNone
+  };
+
   /* Factory constructor. */
   static Ptr New(Fwk::Ptr<const Interface> iface, uint16_t helloint);
 
@@ -65,6 +73,49 @@ class OSPFInterface : public Fwk::PtrInterface<OSPFInterface> {
   uint16_t helloint() const { return helloint_; }
   Seconds timeSinceOutgoingHello() const;
 
+  /* Milliseconds between fast HELLO packets sent out of this interface, or
+     zero if fast HELLOs are disabled. Neighbors time out after
+     fastHelloMultiplier() intervals without one. */
+  uint16_t fastHelloInterval() const { return fast_hello_interval_; }
+  uint8_t fastHelloMultiplier() const { return fast_hello_multiplier_; }
+
+  /* Cost of the links to neighbors through this interface: the configured
+     cost if there is one, otherwise one derived from the interface's speed
+     (see OSPF::kReferenceBandwidth). */
+  uint16_t cost() const;
+
+  /* Configured cost, or zero if the cost is derived. */
+  uint16_t configuredCost() const { return configured_cost_; }
+
+  /* Priority of this router in designated-router elections on this
+     interface, or zero if it does not take part in them (the default).
+     drPriorityAnnounced() is the priority last announced to neighbors. */
+  uint8_t drPriority() const { return dr_priority_; }
+  uint8_t drPriorityAnnounced() const { return dr_priority_announced_; }
+
+  /* Area of this interface; the router's area unless configured
+     otherwise. linkedAreaID() is the area whose topology the gateways of
+     this interface are linked into, and in which HELLOs are sent; the
+     router moves the interface there on its next link-state update
+     signal. */
+  const AreaID& areaID() const { return area_id_; }
+  const AreaID& linkedAreaID() const { return linked_area_id_; }
+
+  /* Designated and backup designated routers elected on this interface,
+     or OSPF::kInvalidRouterID if there are none. */
+  const RouterID& designatedRouter() const { return designated_router_; }
+  const RouterID& backupDesignatedRouter() const {
+    return backup_designated_router_;
+  }
+
+  /* Recipients on this interface of a packet flooded by the router with
+     ROUTER_ID. RECEIVED_HERE is true if the router received the packet on
+     this interface. Without a designated router, every neighbor receives a
+     copy. Otherwise, the designated router sends a single copy to the whole
+     segment, and other routers only send copies to the designated and
+     backup routers, which in turn forward them. */
+  FloodMode floodMode(const RouterID& router_id, bool received_here) const;
+
   OSPFGateway::Ptr activeGateway(const RouterID& router_id);
   OSPFGateway::PtrConst activeGateway(const RouterID& router_id) const;
 
@@ -83,6 +134,31 @@ class OSPFInterface : public Fwk::PtrInterface<OSPFInterface> {
 
   void timeSinceOutgoingHelloIs(Seconds delta);
 
+  void fastHelloIntervalIs(uint16_t interval) {
+    fast_hello_interval_ = interval;
+  }
+  void fastHelloMultiplierIs(uint8_t multiplier) {
+    fast_hello_multiplier_ = multiplier;
+  }
+
+  void configuredCostIs(uint16_t cost) { configured_cost_ = cost; }
+
+  void drPriorityIs(uint8_t priority) { dr_priority_ = priority; }
+  void drPriorityAnnouncedIs(uint8_t priority) {
+    dr_priority_announced_ = priority;
+  }
+
+  void areaIDIs(const AreaID& area_id) { area_id_ = area_id; }
+  void linkedAreaIDIs(const AreaID& area_id) { linked_area_id_ = area_id; }
+
+  /* Elects the designated and backup designated routers among the router
+     with ROUTER_ID and its neighbors on this interface: the two with the
+     highest priority, ties broken by the highest RouterID. There is no
+     election on virtual interfaces, or if this router or any of its
+     neighbors on the interface does not take part in elections; flooding
+     then reaches every neighbor. Returns true if either router changed. */
+  bool designatedRouterElect(const RouterID& router_id);
+
   void gatewayIs(OSPFGateway::Ptr gateway);
   void activeGatewayDel(const RouterID& router_id);
   void passiveGatewayDel(const IPv4Addr& subnet, const IPv4Addr& mask);
@@ -111,6 +187,15 @@ class OSPFInterface : public Fwk::PtrInterface<OSPFInterface> {
   Fwk::Ptr<const Interface> iface_;
   uint16_t helloint_;
   time_t last_outgoing_hello_;
+  uint16_t fast_hello_interval_;
+  uint8_t fast_hello_multiplier_;
+  uint16_t configured_cost_;
+  uint8_t dr_priority_;
+  uint8_t dr_priority_announced_;
+  RouterID designated_router_;
+  RouterID backup_designated_router_;
+  AreaID area_id_;
+  AreaID linked_area_id_;
 
   /* Map of all neighbors directly attached to this router. */
   Fwk::Map<RouterID,OSPFGateway> active_gateways_;
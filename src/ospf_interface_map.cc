@@ -42,6 +42,28 @@ OSPFInterfaceMap::activeGateway(const RouterID& rid) {
   return gw_obj;
 }
 
+OSPFGateway::PtrConst
+OSPFInterfaceMap::activeGateway(const RouterID& rid,
+                                const AreaID& area_id) const {
+  OSPFInterfaceMap* self = const_cast<OSPFInterfaceMap*>(this);
+  return self->activeGateway(rid, area_id);
+}
+
+OSPFGateway::Ptr
+OSPFInterfaceMap::activeGateway(const RouterID& rid, const AreaID& area_id) {
+  for (const_if_iter if_it = ifacesBegin(); if_it != ifacesEnd(); ++if_it) {
+    OSPFInterface::Ptr iface = if_it->second;
+    if (iface->linkedAreaID() != area_id)
+      continue;
+
+    OSPFGateway::Ptr gw_obj = iface->activeGateway(rid);
+    if (gw_obj)
+      return gw_obj;
+  }
+
+  return NULL;
+}
+
 size_t
 OSPFInterfaceMap::gateways() const {
   size_t gateways = 0;
@@ -56,6 +56,11 @@ class OSPFInterfaceMap : public Fwk::PtrInterface<OSPFInterfaceMap> {
   OSPFGateway::PtrConst activeGateway(const RouterID& rid) const;
   OSPFGateway::Ptr activeGateway(const RouterID& rid);
 
+  /* Active gateway to RID through an interface linked into AREA_ID. */
+  OSPFGateway::PtrConst activeGateway(const RouterID& rid,
+                                      const AreaID& area_id) const;
+  OSPFGateway::Ptr activeGateway(const RouterID& rid, const AreaID& area_id);
+
   size_t interfaces() const { return ifaces_.size(); }
   size_t gateways() const;
   size_t activeGateways() const;
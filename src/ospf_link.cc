@@ -28,12 +28,16 @@ OSPFLink::OSPFLink(OSPFNode::Ptr neighbor,
     : node_(neighbor),
       subnet_(subnet & subnet_mask),
       subnet_mask_(subnet_mask),
+      cost_(OSPF::kDefaultLinkCost),
+      summary_(false),
       last_lsu_(time(NULL)) {}
 
 OSPFLink::OSPFLink(const IPv4Addr& subnet, const IPv4Addr& mask)
     : node_(OSPFNode::kPassiveEndpoint),
       subnet_(subnet & mask),
       subnet_mask_(mask),
+      cost_(OSPF::kDefaultLinkCost),
+      summary_(false),
       last_lsu_(time(NULL)) {}
 
 OSPFNode::PtrConst
@@ -61,14 +65,15 @@ OSPFLink::str() const {
   stringstream ss;
   
   char line_buf[256];
-  const char* const format = "      %-16s %-16s %-16s\n";
+  const char* const format = "      %-16s %-16s %-16s %u\n";
   const string& subnet_str = subnet();
   const string& mask_str = subnetMask();
 
   ss << nodeRouterID();
 
   snprintf(line_buf, sizeof(line_buf), format,
-           ss.str().c_str(), subnet_str.c_str(), mask_str.c_str());
+           ss.str().c_str(), subnet_str.c_str(), mask_str.c_str(),
+           (unsigned)cost());
 
   return line_buf;
 }
@@ -84,6 +89,12 @@ OSPFLink::operator==(const OSPFLink& other) const {
   if (this->subnetMask() != other.subnetMask())
     return false;
 
+  if (this->cost() != other.cost())
+    return false;
+
+  if (this->summary() != other.summary())
+    return false;
+
   return true;
 }
 
@@ -41,6 +41,18 @@ class OSPFLink : public Fwk::PtrInterface<OSPFLink> {
   const IPv4Addr& subnet() const { return subnet_; }
   const IPv4Addr& subnetMask() const { return subnet_mask_; }
 
+  /* Cost of reaching the neighbor over this link in shortest-path
+     computations; at least 1. Links cost OSPF::kDefaultLinkCost unless set
+     otherwise. */
+  uint16_t cost() const { return cost_; }
+  void costIs(uint16_t cost) { cost_ = (cost > 0) ? cost : 1; }
+
+  /* True if the link is an inter-area summary injected by an area border
+     router rather than a subnet attached to it; only links to passive
+     endpoints are summaries. */
+  bool summary() const { return summary_; }
+  void summaryIs(bool status) { summary_ = status; }
+
   time_t timeSinceLSU() const { return time(NULL) - last_lsu_; }
   void timeSinceLSUIs(time_t _t) { last_lsu_ = time(NULL) - _t; }
 
@@ -63,6 +75,8 @@ class OSPFLink : public Fwk::PtrInterface<OSPFLink> {
   Fwk::Ptr<OSPFNode> node_;
   IPv4Addr subnet_;
   IPv4Addr subnet_mask_;
+  uint16_t cost_;
+  bool summary_;
 
   /* Time this link was last confirmed by a link-state update. */
   time_t last_lsu_;
@@ -8,11 +8,14 @@ using std::stringstream;
 
 const OSPFNode::Ptr OSPFNode::kPassiveEndpoint =
   OSPFNode::New(OSPF::kPassiveEndpointID);
+const uint32_t OSPFNode::kMaxDistance;
 
 OSPFNode::OSPFNode(const RouterID& router_id)
     : router_id_(router_id),
       latest_seqno_(0),
-      distance_(0) {}
+      links_synced_(false),
+      distance_(0),
+      spf_index_(0) {}
 
 OSPFLink::Ptr
 OSPFNode::activeLink(const RouterID& id) {
@@ -70,9 +73,10 @@ OSPFNode::linkIs(OSPFLink::Ptr link) {
   if (link == NULL)
     return;
 
-  /* Relationship is bi-directional. */
+  /* Relationship is bi-directional, at the same cost. */
   OSPFLink::Ptr reverse_link =
     OSPFLink::New(this, link->subnet(), link->subnetMask());
+  reverse_link->costIs(link->cost());
 
   bool notify_cond_one = link->node()->oneWayLinkIs(reverse_link);
   bool notify_cond_two = oneWayLinkIs(link);
@@ -3,11 +3,12 @@
 
 #include <string>
 #include <ostream>
+#include <vector>
 using std::ostream;
 using std::string;
 
+#include "fwk/flat_map.h"
 #include "fwk/log.h"
-#include "fwk/map.h"
 #include "fwk/ptr_interface.h"
 
 #include "ipv4_addr.h"
@@ -22,15 +23,18 @@ class OSPFNode : public Fwk::PtrInterface<OSPFNode> {
   typedef Fwk::Ptr<OSPFNode> Ptr;
 
   /* Iterators for links to active OSPF nodes. */
-  typedef Fwk::Map<RouterID,OSPFLink>::iterator lna_iter;
-  typedef Fwk::Map<RouterID,OSPFLink>::const_iterator const_lna_iter;
+  typedef Fwk::FlatMap<RouterID,OSPFLink>::iterator lna_iter;
+  typedef Fwk::FlatMap<RouterID,OSPFLink>::const_iterator const_lna_iter;
 
   /* Iterators for links to passive endpoints. */
-  typedef Fwk::Map<IPv4Subnet,OSPFLink>::iterator lnp_iter;
-  typedef Fwk::Map<IPv4Subnet,OSPFLink>::const_iterator const_lnp_iter;
+  typedef Fwk::FlatMap<IPv4Subnet,OSPFLink>::iterator lnp_iter;
+  typedef Fwk::FlatMap<IPv4Subnet,OSPFLink>::const_iterator const_lnp_iter;
+
+  /* Iterators for equal-cost first hops. */
+  typedef std::vector<OSPFNode::Ptr>::const_iterator const_fh_iter;
 
   static const OSPFNode::Ptr kPassiveEndpoint;
-  static const uint16_t kMaxDistance = 0xffff;
+  static const uint32_t kMaxDistance = 0xffffffff;
 
   /* Factory constructor. */
   static Ptr New(const RouterID& router_id) {
@@ -76,8 +80,32 @@ class OSPFNode : public Fwk::PtrInterface<OSPFNode> {
   OSPFNode::Ptr upstreamNode() { return prev_; }
   OSPFNode::PtrConst upstreamNode() const { return prev_; }
 
+  /* Neighbor of the root node through which the shortest path from the root
+     node to this node leaves the root. NULL for the root node itself and for
+     unreachable nodes. */
+  OSPFNode::Ptr firstHop() { return first_hop_; }
+  OSPFNode::PtrConst firstHop() const { return first_hop_; }
+
+  /* Number of neighbors of the root node through which a shortest path to
+     this node leaves the root. More than one if there are several equal-cost
+     paths; firstHop() is always one of them. */
+  size_t firstHops() const { return first_hops_.size(); }
+
+  /* Neighbor of the root node, other than the first hop, whose shortest
+     path to this node does not lead back through the root (a loop-free
+     alternate). Traffic can be moved to it as soon as the first hop fails.
+     NULL if there is no such neighbor, or if there are several equal-cost
+     first hops. */
+  OSPFNode::Ptr backupHop() { return backup_hop_; }
+  OSPFNode::PtrConst backupHop() const { return backup_hop_; }
+
   uint16_t latestSeqno() const { return latest_seqno_; }
-  uint16_t distance() const { return distance_; }
+  /* Sum of the link costs on the shortest path from the root node. */
+  uint32_t distance() const { return distance_; }
+
+  /* True if this node's links reflect its update with latestSeqno(), so
+     that an incremental update based on it can be applied. */
+  bool linksSynced() const { return links_synced_; }
 
   Notifiee::PtrConst notifiee() const { return notifiee_; }
   Notifiee::Ptr notifiee() { return notifiee_; }
@@ -95,9 +123,18 @@ class OSPFNode : public Fwk::PtrInterface<OSPFNode> {
   void passiveLinkDel(const IPv4Addr& subnet, const IPv4Addr& mask);
 
   void upstreamNodeIs(OSPFNode::Ptr prev) { prev_ = prev; }
+  void firstHopIs(OSPFNode::Ptr first_hop) { first_hop_ = first_hop; }
+
+  /* Sets the equal-cost first hops; HOPS must be in RouterID order. */
+  void firstHopsIs(const std::vector<OSPFNode::Ptr>& hops) {
+    first_hops_ = hops;
+  }
+
+  void backupHopIs(OSPFNode::Ptr backup_hop) { backup_hop_ = backup_hop; }
 
   void latestSeqnoIs(uint16_t seqno) { latest_seqno_ = seqno; }
-  void distanceIs(uint16_t dist) { distance_ = dist; }
+  void linksSyncedIs(bool status) { links_synced_ = status; }
+  void distanceIs(uint32_t dist) { distance_ = dist; }
   void notifieeIs(Notifiee::Ptr _n) { notifiee_ = _n; }
 
   /* Iterators. */
@@ -112,10 +149,16 @@ class OSPFNode : public Fwk::PtrInterface<OSPFNode> {
   const_lnp_iter passiveLinksBegin() const { return passive_links_.begin(); }
   const_lnp_iter passiveLinksEnd() const { return passive_links_.end(); }
 
+  /* First hops in RouterID order. */
+  const_fh_iter firstHopsBegin() const { return first_hops_.begin(); }
+  const_fh_iter firstHopsEnd() const { return first_hops_.end(); }
+
  protected:
   explicit OSPFNode(const RouterID& router_id);
 
  private:
+  friend class OSPFTopology;
+
   /* Helper member functions. */
   bool oneWayLinkIs(OSPFLink::Ptr link);
   bool oneWayActiveLinkDel(const RouterID& id);
@@ -124,14 +167,27 @@ class OSPFNode : public Fwk::PtrInterface<OSPFNode> {
   /* Data members. */
   RouterID router_id_;
   uint16_t latest_seqno_;
-  uint16_t distance_;
+  bool links_synced_;
+  uint32_t distance_;
 
   /* Previous node in the shortest path from the root node to this node. */
   OSPFNode::Ptr prev_;
 
-  /* Map of all neighbors directly attached to this node. */
-  Fwk::Map<RouterID,OSPFLink> active_links_;
-  Fwk::Map<IPv4Subnet,OSPFLink> passive_links_;
+  /* First node after the root on that path, and on all other shortest
+     paths. */
+  OSPFNode::Ptr first_hop_;
+  std::vector<OSPFNode::Ptr> first_hops_;
+
+  /* Loop-free alternate to first_hop_. */
+  OSPFNode::Ptr backup_hop_;
+
+  /* Dense index assigned by OSPFTopology during SPF computation. */
+  uint32_t spf_index_;
+
+  /* Map of all neighbors directly attached to this node. Nodes have few
+     links each, so they are kept in sorted vectors rather than trees. */
+  Fwk::FlatMap<RouterID,OSPFLink> active_links_;
+  Fwk::FlatMap<IPv4Subnet,OSPFLink> passive_links_;
 
   /* Singleton notifiee. */
   Notifiee::Ptr notifiee_;
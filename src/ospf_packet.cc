@@ -1,10 +1,12 @@
 #include "ospf_packet.h"
 
+#include <cstring>
 #include <netinet/in.h>
 
 #include "fwk/log.h"
 
 #include "interface.h"
+#include "ospf_constants.h"
 #include "packet_buffer.h"
 
 /* Static global log instance */
@@ -39,6 +41,40 @@ struct ospf_lsu_hdr {
 
 } __attribute((packed));
 
+struct ospf_lsu_delta_hdr {
+  struct ospf_pkt ospf_pkt;
+  uint16_t seqno;           /* unique seqno associated with this LSU packet */
+  uint16_t ttl;             /* hop limited value */
+  uint32_t adv_count;       /* number of added LSU advertisements */
+  uint16_t base_seqno;      /* seqno of the LSU that this delta applies to */
+  uint16_t padding;         /* zero */
+  uint32_t withdrawn_count; /* number of withdrawn LSU advertisements */
+
+  /* adv_count added advertisements followed by
+     withdrawn_count withdrawn advertisements */
+
+} __attribute((packed));
+
+struct ospf_lsr_pkt {
+  struct ospf_pkt ospf_pkt;
+  uint16_t seqno;           /* seqno of this request at its sender */
+  uint16_t ttl;             /* hop limited value */
+  uint32_t target_id;       /* router ID whose full LSU is requested */
+} __attribute((packed));
+
+struct ospf_fast_hello_pkt {
+  struct ospf_pkt ospf_pkt;
+  uint16_t interval;        /* milliseconds between fast hello packets */
+  uint8_t multiplier;       /* packets that may be lost before timeout */
+  uint8_t padding;          /* zero */
+} __attribute((packed));
+
+struct ospf_election_pkt {
+  struct ospf_pkt ospf_pkt;
+  uint8_t priority;         /* designated-router priority; 0 if none */
+  uint8_t padding[3];       /* zero */
+} __attribute((packed));
+
 /* link state advertisement */
 struct ospf_lsu_adv {
   uint32_t subnet;          /* subnet number of advertised route */
@@ -46,12 +82,41 @@ struct ospf_lsu_adv {
   uint32_t router_id;       /* ID of neighboring router on advertised link */
 } __attribute((packed));
 
+/* link cost extension; follows the advertisements of an LSU */
+struct ospf_lsu_costs {
+  uint16_t type;            /* kCostsType */
+  uint16_t count;           /* number of costs; equal to adv_count */
+
+  /* one 16-bit cost per advertisement, in order,
+     padded with zeros to a multiple of 4 bytes */
+
+} __attribute((packed));
+
+/* inter-area summary extension; follows the link cost extension */
+struct ospf_lsu_summaries {
+  uint16_t type;            /* kSummariesType */
+  uint16_t count;           /* number of summaries, at the end of the list */
+} __attribute((packed));
+
 const uint8_t OSPFPacket::kVersion;
 
 const size_t OSPFHelloPacket::kPacketSize = sizeof(struct ospf_hello_pkt);
 
 const uint8_t OSPFLSUPacket::kDefaultTTL;
 const size_t OSPFLSUPacket::kHeaderSize = sizeof(struct ospf_lsu_hdr);
+const uint16_t OSPFLSUPacket::kCostsType;
+const uint16_t OSPFLSUPacket::kSummariesType;
+
+const size_t OSPFLSUDeltaPacket::kHeaderSize =
+  sizeof(struct ospf_lsu_delta_hdr);
+
+const size_t OSPFLSRPacket::kPacketSize = sizeof(struct ospf_lsr_pkt);
+
+const size_t OSPFFastHelloPacket::kPacketSize =
+  sizeof(struct ospf_fast_hello_pkt);
+
+const size_t OSPFElectionPacket::kPacketSize =
+  sizeof(struct ospf_election_pkt);
 
 const size_t OSPFLSUAdvPacket::kSize = sizeof(struct ospf_lsu_adv);
 
@@ -179,6 +244,18 @@ OSPFPacket::derivedInstance() {
     case kLSU:
       pkt = OSPFLSUPacket::New(buffer(), bufferOffset());
       break;
+    case kLSUDelta:
+      pkt = OSPFLSUDeltaPacket::New(buffer(), bufferOffset());
+      break;
+    case kLSR:
+      pkt = OSPFLSRPacket::New(buffer(), bufferOffset());
+      break;
+    case kFastHello:
+      pkt = OSPFFastHelloPacket::New(buffer(), bufferOffset());
+      break;
+    case kElection:
+      pkt = OSPFElectionPacket::New(buffer(), bufferOffset());
+      break;
     default:
       pkt = NULL;
   }
@@ -211,7 +288,9 @@ OSPFPacket::valid() const {
     return false;
   }
 
-  if (ospf_pkt_->type != kHello && ospf_pkt_->type != kLSU) {
+  if (ospf_pkt_->type != kHello && ospf_pkt_->type != kLSU &&
+      ospf_pkt_->type != kLSUDelta && ospf_pkt_->type != kLSR &&
+      ospf_pkt_->type != kFastHello && ospf_pkt_->type != kElection) {
     DLOG << "Invalid value in type field.";
     return false;
   }
@@ -328,8 +407,22 @@ OSPFLSUPacket::NewDefault(PacketBuffer::Ptr buffer,
                           const RouterID& router_id,
                           const AreaID& area_id,
                           uint32_t adv_count,
-                          uint16_t lsu_seqno) {
-  return new OSPFLSUPacket(buffer, router_id, area_id, adv_count, lsu_seqno);
+                          uint16_t lsu_seqno,
+                          bool costs,
+                          uint32_t summary_count) {
+  return new OSPFLSUPacket(buffer, router_id, area_id, adv_count, lsu_seqno,
+                           costs, summary_count);
+}
+
+size_t
+OSPFLSUPacket::costsSize(uint32_t adv_count) {
+  size_t size = sizeof(struct ospf_lsu_costs) + adv_count * sizeof(uint16_t);
+  return (size + 3) & ~(size_t)3;
+}
+
+size_t
+OSPFLSUPacket::summariesSize(uint32_t summary_count) {
+  return summary_count ? sizeof(struct ospf_lsu_summaries) : 0;
 }
 
 OSPFLSUPacket::OSPFLSUPacket(PacketBuffer::Ptr buffer,
@@ -341,14 +434,31 @@ OSPFLSUPacket::OSPFLSUPacket(PacketBuffer::Ptr buffer,
                              const RouterID& router_id,
                              const AreaID& area_id,
                              uint32_t adv_count,
-                             uint16_t lsu_seqno)
+                             uint16_t lsu_seqno,
+                             bool costs,
+                             uint32_t summary_count)
     : OSPFPacket(buffer, router_id, area_id, OSPFPacket::kLSU,
                  OSPFLSUPacket::kHeaderSize +
-                 adv_count * OSPFLSUAdvPacket::kSize),
+                 adv_count * OSPFLSUAdvPacket::kSize +
+                 (costs ? costsSize(adv_count) +
+                          summariesSize(summary_count) : 0)),
       ospf_lsu_hdr_((struct ospf_lsu_hdr*)offsetAddress(0)) {
   seqnoIs(lsu_seqno);
   ttlIs(OSPFLSUPacket::kDefaultTTL);
   advCountIs(adv_count);
+
+  if (costs) {
+    struct ospf_lsu_costs* costs_hdr = this->costs_hdr();
+    memset(costs_hdr, 0, costsSize(adv_count));
+    costs_hdr->type = htons(kCostsType);
+    costs_hdr->count = htons(adv_count);
+
+    if (summary_count) {
+      struct ospf_lsu_summaries* summaries_hdr = this->summaries_hdr();
+      summaries_hdr->type = htons(kSummariesType);
+      summaries_hdr->count = htons(summary_count);
+    }
+  }
 }
 
 uint16_t
@@ -400,13 +510,83 @@ OSPFLSUPacket::advertisement(uint32_t index) const {
   return self->advertisement(index);
 }
 
+bool
+OSPFLSUPacket::costsIncluded() const {
+  /* 64-bit arithmetic, since the count is taken from the wire. */
+  uint64_t offset = sizeof(struct ospf_lsu_hdr) +
+                    (uint64_t)advCount() * sizeof(struct ospf_lsu_adv);
+  if (len() < offset + sizeof(struct ospf_lsu_costs))
+    return false;
+
+  const struct ospf_lsu_costs* costs_hdr = this->costs_hdr();
+  if (ntohs(costs_hdr->type) != kCostsType ||
+      ntohs(costs_hdr->count) != advCount()) {
+    return false;
+  }
+
+  return len() >= offset + costsSize(advCount());
+}
+
+uint16_t
+OSPFLSUPacket::cost(uint32_t index) const {
+  if (!costsIncluded() || index >= advCount())
+    return OSPF::kDefaultLinkCost;
+
+  const uint16_t* costs = (const uint16_t*)(costs_hdr() + 1);
+  return ntohs(costs[index]);
+}
+
+void
+OSPFLSUPacket::costIs(uint32_t index, uint16_t cost) {
+  uint16_t* costs = (uint16_t*)(costs_hdr() + 1);
+  costs[index] = htons(cost);
+}
+
+uint32_t
+OSPFLSUPacket::summaryCount() const {
+  if (!costsIncluded())
+    return 0;
+
+  uint64_t offset = sizeof(struct ospf_lsu_hdr) +
+                    (uint64_t)advCount() * sizeof(struct ospf_lsu_adv) +
+                    costsSize(advCount());
+  if (len() < offset + sizeof(struct ospf_lsu_summaries))
+    return 0;
+
+  const struct ospf_lsu_summaries* summaries_hdr = this->summaries_hdr();
+  uint32_t count = ntohs(summaries_hdr->count);
+  if (ntohs(summaries_hdr->type) != kSummariesType || count > advCount())
+    return 0;
+
+  return count;
+}
+
+bool
+OSPFLSUPacket::summary(uint32_t index) const {
+  return index < advCount() && index >= advCount() - summaryCount();
+}
+
+struct ospf_lsu_costs*
+OSPFLSUPacket::costs_hdr() const {
+  return (struct ospf_lsu_costs*)
+    offsetAddress(kHeaderSize + advCount() * OSPFLSUAdvPacket::kSize);
+}
+
+struct ospf_lsu_summaries*
+OSPFLSUPacket::summaries_hdr() const {
+  return (struct ospf_lsu_summaries*)
+    offsetAddress(kHeaderSize + advCount() * OSPFLSUAdvPacket::kSize +
+                  costsSize(advCount()));
+}
+
 bool
 OSPFLSUPacket::valid() const {
   if (!OSPFPacket::valid())
     return false;
 
-  size_t required_mem = sizeof(struct ospf_lsu_hdr) +
-                        advCount() * sizeof(struct ospf_lsu_adv);
+  /* 64-bit arithmetic, since the count is taken from the wire. */
+  uint64_t required_mem = sizeof(struct ospf_lsu_hdr) +
+                          (uint64_t)advCount() * sizeof(struct ospf_lsu_adv);
   if (len() < required_mem) {
     DLOG << "Packet buffer too small to accommodate "
          << "stated number of LSU advertisements.";
@@ -422,6 +602,368 @@ OSPFLSUPacket::operator()(Functor* const f, const Interface::PtrConst iface) {
 }
 
 
+/* OSPFLSUDeltaPacket */
+
+OSPFLSUDeltaPacket::Ptr
+OSPFLSUDeltaPacket::NewDefault(PacketBuffer::Ptr buffer,
+                               const RouterID& router_id,
+                               const AreaID& area_id,
+                               uint32_t adv_count,
+                               uint32_t withdrawn_count,
+                               uint16_t lsu_seqno,
+                               uint16_t base_seqno) {
+  return new OSPFLSUDeltaPacket(buffer, router_id, area_id, adv_count,
+                                withdrawn_count, lsu_seqno, base_seqno);
+}
+
+OSPFLSUDeltaPacket::OSPFLSUDeltaPacket(PacketBuffer::Ptr buffer,
+                                       unsigned int buffer_offset)
+    : OSPFPacket(buffer, buffer_offset),
+      ospf_lsu_delta_hdr_((struct ospf_lsu_delta_hdr*)offsetAddress(0)) {}
+
+OSPFLSUDeltaPacket::OSPFLSUDeltaPacket(PacketBuffer::Ptr buffer,
+                                       const RouterID& router_id,
+                                       const AreaID& area_id,
+                                       uint32_t adv_count,
+                                       uint32_t withdrawn_count,
+                                       uint16_t lsu_seqno,
+                                       uint16_t base_seqno)
+    : OSPFPacket(buffer, router_id, area_id, OSPFPacket::kLSUDelta,
+                 OSPFLSUDeltaPacket::kHeaderSize +
+                 (adv_count + withdrawn_count) * OSPFLSUAdvPacket::kSize),
+      ospf_lsu_delta_hdr_((struct ospf_lsu_delta_hdr*)offsetAddress(0)) {
+  seqnoIs(lsu_seqno);
+  ttlIs(OSPFLSUPacket::kDefaultTTL);
+  advCountIs(adv_count);
+  baseSeqnoIs(base_seqno);
+  ospf_lsu_delta_hdr_->padding = 0;
+  withdrawnCountIs(withdrawn_count);
+}
+
+uint16_t
+OSPFLSUDeltaPacket::seqno() const {
+  return ntohs(ospf_lsu_delta_hdr_->seqno);
+}
+
+void
+OSPFLSUDeltaPacket::seqnoIs(uint16_t seqno) {
+  ospf_lsu_delta_hdr_->seqno = htons(seqno);
+}
+
+uint16_t
+OSPFLSUDeltaPacket::ttl() const {
+  return ntohs(ospf_lsu_delta_hdr_->ttl);
+}
+
+void
+OSPFLSUDeltaPacket::ttlIs(uint16_t ttl) {
+  ospf_lsu_delta_hdr_->ttl = htons(ttl);
+}
+
+void
+OSPFLSUDeltaPacket::ttlDec(uint16_t delta) {
+  ttlIs(ttl() - delta);
+}
+
+uint16_t
+OSPFLSUDeltaPacket::baseSeqno() const {
+  return ntohs(ospf_lsu_delta_hdr_->base_seqno);
+}
+
+void
+OSPFLSUDeltaPacket::baseSeqnoIs(uint16_t seqno) {
+  ospf_lsu_delta_hdr_->base_seqno = htons(seqno);
+}
+
+uint32_t
+OSPFLSUDeltaPacket::advCount() const {
+  return ntohl(ospf_lsu_delta_hdr_->adv_count);
+}
+
+void
+OSPFLSUDeltaPacket::advCountIs(uint32_t count) {
+  ospf_lsu_delta_hdr_->adv_count = htonl(count);
+}
+
+uint32_t
+OSPFLSUDeltaPacket::withdrawnCount() const {
+  return ntohl(ospf_lsu_delta_hdr_->withdrawn_count);
+}
+
+void
+OSPFLSUDeltaPacket::withdrawnCountIs(uint32_t count) {
+  ospf_lsu_delta_hdr_->withdrawn_count = htonl(count);
+}
+
+OSPFLSUAdvPacket::Ptr
+OSPFLSUDeltaPacket::advertisement(uint32_t index) {
+  unsigned int off = bufferOffset() +
+                     OSPFLSUDeltaPacket::kHeaderSize +
+                     index * OSPFLSUAdvPacket::kSize;
+  return OSPFLSUAdvPacket::New(buffer(), off);
+}
+
+OSPFLSUAdvPacket::PtrConst
+OSPFLSUDeltaPacket::advertisement(uint32_t index) const {
+  OSPFLSUDeltaPacket* self = const_cast<OSPFLSUDeltaPacket*>(this);
+  return self->advertisement(index);
+}
+
+OSPFLSUAdvPacket::Ptr
+OSPFLSUDeltaPacket::withdrawal(uint32_t index) {
+  return advertisement(advCount() + index);
+}
+
+OSPFLSUAdvPacket::PtrConst
+OSPFLSUDeltaPacket::withdrawal(uint32_t index) const {
+  OSPFLSUDeltaPacket* self = const_cast<OSPFLSUDeltaPacket*>(this);
+  return self->withdrawal(index);
+}
+
+bool
+OSPFLSUDeltaPacket::valid() const {
+  if (!OSPFPacket::valid())
+    return false;
+
+  if (len() < sizeof(struct ospf_lsu_delta_hdr)) {
+    DLOG << "Packet is smaller than an OSPF LSU delta header.";
+    return false;
+  }
+
+  /* 64-bit arithmetic, since both counts are taken from the wire. */
+  uint64_t required_mem = sizeof(struct ospf_lsu_delta_hdr) +
+                          ((uint64_t)advCount() + withdrawnCount()) *
+                          sizeof(struct ospf_lsu_adv);
+  if (len() < required_mem) {
+    DLOG << "Packet buffer too small to accommodate "
+         << "stated number of LSU advertisements.";
+    return false;
+  }
+
+  return true;
+}
+
+void
+OSPFLSUDeltaPacket::operator()(Functor* const f,
+                               const Interface::PtrConst iface) {
+  (*f)(this, iface);
+}
+
+
+/* OSPFLSRPacket */
+
+OSPFLSRPacket::Ptr
+OSPFLSRPacket::NewDefault(PacketBuffer::Ptr buffer,
+                          const RouterID& router_id,
+                          const AreaID& area_id,
+                          const RouterID& target_id,
+                          uint16_t lsr_seqno) {
+  return new OSPFLSRPacket(buffer, router_id, area_id, target_id, lsr_seqno);
+}
+
+OSPFLSRPacket::OSPFLSRPacket(PacketBuffer::Ptr buffer,
+                             unsigned int buffer_offset)
+    : OSPFPacket(buffer, buffer_offset),
+      ospf_lsr_pkt_((struct ospf_lsr_pkt*)offsetAddress(0)) {}
+
+OSPFLSRPacket::OSPFLSRPacket(PacketBuffer::Ptr buffer,
+                             const RouterID& router_id,
+                             const AreaID& area_id,
+                             const RouterID& target_id,
+                             uint16_t lsr_seqno)
+    : OSPFPacket(buffer, router_id, area_id, OSPFPacket::kLSR, kPacketSize),
+      ospf_lsr_pkt_((struct ospf_lsr_pkt*)offsetAddress(0)) {
+  seqnoIs(lsr_seqno);
+  ttlIs(OSPFLSUPacket::kDefaultTTL);
+  targetIDIs(target_id);
+}
+
+uint16_t
+OSPFLSRPacket::seqno() const {
+  return ntohs(ospf_lsr_pkt_->seqno);
+}
+
+void
+OSPFLSRPacket::seqnoIs(uint16_t seqno) {
+  ospf_lsr_pkt_->seqno = htons(seqno);
+}
+
+uint16_t
+OSPFLSRPacket::ttl() const {
+  return ntohs(ospf_lsr_pkt_->ttl);
+}
+
+void
+OSPFLSRPacket::ttlIs(uint16_t ttl) {
+  ospf_lsr_pkt_->ttl = htons(ttl);
+}
+
+void
+OSPFLSRPacket::ttlDec(uint16_t delta) {
+  ttlIs(ttl() - delta);
+}
+
+RouterID
+OSPFLSRPacket::targetID() const {
+  return ntohl(ospf_lsr_pkt_->target_id);
+}
+
+void
+OSPFLSRPacket::targetIDIs(const RouterID& id) {
+  ospf_lsr_pkt_->target_id = htonl(id.value());
+}
+
+bool
+OSPFLSRPacket::valid() const {
+  if (!OSPFPacket::valid())
+    return false;
+
+  if (len() < sizeof(struct ospf_lsr_pkt)) {
+    DLOG << "Packet is smaller than an OSPF LSR packet.";
+    return false;
+  }
+
+  return true;
+}
+
+void
+OSPFLSRPacket::operator()(Functor* const f, const Interface::PtrConst iface) {
+  (*f)(this, iface);
+}
+
+
+
+/* OSPFFastHelloPacket */
+
+OSPFFastHelloPacket::Ptr
+OSPFFastHelloPacket::NewDefault(PacketBuffer::Ptr buffer,
+                                const RouterID& router_id,
+                                const AreaID& area_id,
+                                uint16_t interval,
+                                uint8_t multiplier) {
+  return new OSPFFastHelloPacket(buffer, router_id, area_id,
+                                 interval, multiplier);
+}
+
+OSPFFastHelloPacket::OSPFFastHelloPacket(PacketBuffer::Ptr buffer,
+                                         unsigned int buffer_offset)
+    : OSPFPacket(buffer, buffer_offset),
+      ospf_fast_hello_pkt_((struct ospf_fast_hello_pkt*)offsetAddress(0)) {}
+
+OSPFFastHelloPacket::OSPFFastHelloPacket(PacketBuffer::Ptr buffer,
+                                         const RouterID& router_id,
+                                         const AreaID& area_id,
+                                         uint16_t interval,
+                                         uint8_t multiplier)
+    : OSPFPacket(buffer, router_id, area_id,
+                 OSPFPacket::kFastHello, kPacketSize),
+      ospf_fast_hello_pkt_((struct ospf_fast_hello_pkt*)offsetAddress(0)) {
+  intervalIs(interval);
+  multiplierIs(multiplier);
+  ospf_fast_hello_pkt_->padding = 0;
+}
+
+uint16_t
+OSPFFastHelloPacket::interval() const {
+  return ntohs(ospf_fast_hello_pkt_->interval);
+}
+
+void
+OSPFFastHelloPacket::intervalIs(uint16_t interval) {
+  ospf_fast_hello_pkt_->interval = htons(interval);
+}
+
+uint8_t
+OSPFFastHelloPacket::multiplier() const {
+  return ospf_fast_hello_pkt_->multiplier;
+}
+
+void
+OSPFFastHelloPacket::multiplierIs(uint8_t multiplier) {
+  ospf_fast_hello_pkt_->multiplier = multiplier;
+}
+
+bool
+OSPFFastHelloPacket::valid() const {
+  if (!OSPFPacket::valid())
+    return false;
+
+  if (len() < sizeof(struct ospf_fast_hello_pkt)) {
+    DLOG << "Packet is smaller than an OSPF fast HELLO packet.";
+    return false;
+  }
+
+  if (multiplier() == 0) {
+    DLOG << "Invalid value in fast HELLO multiplier field.";
+    return false;
+  }
+
+  return true;
+}
+
+void
+OSPFFastHelloPacket::operator()(Functor* const f,
+                                const Interface::PtrConst iface) {
+  (*f)(this, iface);
+}
+
+
+/* OSPFElectionPacket */
+
+OSPFElectionPacket::Ptr
+OSPFElectionPacket::NewDefault(PacketBuffer::Ptr buffer,
+                               const RouterID& router_id,
+                               const AreaID& area_id,
+                               uint8_t priority) {
+  return new OSPFElectionPacket(buffer, router_id, area_id, priority);
+}
+
+OSPFElectionPacket::OSPFElectionPacket(PacketBuffer::Ptr buffer,
+                                       unsigned int buffer_offset)
+    : OSPFPacket(buffer, buffer_offset),
+      ospf_election_pkt_((struct ospf_election_pkt*)offsetAddress(0)) {}
+
+OSPFElectionPacket::OSPFElectionPacket(PacketBuffer::Ptr buffer,
+                                       const RouterID& router_id,
+                                       const AreaID& area_id,
+                                       uint8_t priority)
+    : OSPFPacket(buffer, router_id, area_id,
+                 OSPFPacket::kElection, kPacketSize),
+      ospf_election_pkt_((struct ospf_election_pkt*)offsetAddress(0)) {
+  priorityIs(priority);
+  memset(ospf_election_pkt_->padding, 0, sizeof(ospf_election_pkt_->padding));
+}
+
+uint8_t
+OSPFElectionPacket::priority() const {
+  return ospf_election_pkt_->priority;
+}
+
+void
+OSPFElectionPacket::priorityIs(uint8_t priority) {
+  ospf_election_pkt_->priority = priority;
+}
+
+bool
+OSPFElectionPacket::valid() const {
+  if (!OSPFPacket::valid())
+    return false;
+
+  if (len() < sizeof(struct ospf_election_pkt)) {
+    DLOG << "Packet is smaller than an OSPF election packet.";
+    return false;
+  }
+
+  return true;
+}
+
+void
+OSPFElectionPacket::operator()(Functor* const f,
+                               const Interface::PtrConst iface) {
+  (*f)(this, iface);
+}
+
+
 /* OSPFLSUAdvPacket */
 
 OSPFLSUAdvPacket::OSPFLSUAdvPacket(PacketBuffer::Ptr buffer,
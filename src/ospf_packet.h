@@ -13,6 +13,12 @@ struct ospf_pkt;
 struct ospf_hello_pkt;
 struct ospf_lsu_hdr;
 struct ospf_lsu_adv;
+struct ospf_lsu_costs;
+struct ospf_lsu_summaries;
+struct ospf_lsu_delta_hdr;
+struct ospf_lsr_pkt;
+struct ospf_fast_hello_pkt;
+struct ospf_election_pkt;
 
 class OSPFPacket : public Packet {
  public:
@@ -22,8 +28,12 @@ class OSPFPacket : public Packet {
   static const uint8_t kVersion = 2;
 
   enum OSPFType {
-    kHello = 0x1,
-    kLSU   = 0x4
+    kHello     = 0x1,
+    kLSR       = 0x3, /* Extension: resynchronization request. */
+    kLSU       = 0x4,
+    kLSUDelta  = 0x6, /* Extension: incremental link-state update. */
+    kFastHello = 0x7, /* Extension: fast neighbor liveness detection. */
+    kElection  = 0x8  /* Extension: designated-router election. */
   };
 
   static Ptr New(PacketBuffer::Ptr buffer, unsigned int buffer_offset) {
@@ -153,11 +163,27 @@ class OSPFLSUPacket : public OSPFPacket {
   static const uint8_t kDefaultTTL = 255;
   static const size_t kHeaderSize;
 
+  /* Types of the link cost and inter-area summary extensions. */
+  static const uint16_t kCostsType = 0x1;
+  static const uint16_t kSummariesType = 0x2;
+
+  /* Creates an update with room for ADV_COUNT advertisements, followed by
+     their costs if COSTS is true. The last SUMMARY_COUNT advertisements
+     are inter-area summaries; they require COSTS. */
   static Ptr NewDefault(PacketBuffer::Ptr buffer,
                         const RouterID& router_id,
                         const AreaID& area_id,
                         uint32_t adv_count,
-                        uint16_t lsu_seqno);
+                        uint16_t lsu_seqno,
+                        bool costs,
+                        uint32_t summary_count);
+
+  /* Size of the link cost extension for ADV_COUNT advertisements. */
+  static size_t costsSize(uint32_t adv_count);
+
+  /* Size of the inter-area summary extension for SUMMARY_COUNT summaries;
+     zero if there are none. */
+  static size_t summariesSize(uint32_t summary_count);
 
   /* OSPFLSUPacket factory constructor. */
   static Ptr New(PacketBuffer::Ptr buffer, unsigned int buffer_offset) {
@@ -177,6 +203,27 @@ class OSPFLSUPacket : public OSPFPacket {
   Fwk::Ptr<OSPFLSUAdvPacket> advertisement(uint32_t index);
   Fwk::Ptr<const OSPFLSUAdvPacket> advertisement(uint32_t index) const;
 
+  /* Link cost extension: the cost of every advertised link, appended after
+     the advertisements. The extension is covered by the packet length but
+     not by advCount(), so routers that do not support it ignore it. This is
+     an extension to PWOSPF. */
+  bool costsIncluded() const;
+
+  /* Cost of the link of advertisement INDEX; OSPF::kDefaultLinkCost if the
+     update does not include costs. */
+  uint16_t cost(uint32_t index) const;
+  void costIs(uint32_t index, uint16_t cost);
+
+  /* Inter-area summary extension, which follows the link cost extension:
+     the number of advertisements, at the end of the list, that an area
+     border router injected to summarize prefixes of other areas. Routers
+     that do not support it see them as ordinary passive subnets. Zero if
+     the update does not include the extension. */
+  uint32_t summaryCount() const;
+
+  /* True if advertisement INDEX is an inter-area summary. */
+  bool summary(uint32_t index) const;
+
   /* Override. */
   virtual OSPFPacket::Ptr derivedInstance() { return this; }
 
@@ -194,7 +241,12 @@ class OSPFLSUPacket : public OSPFPacket {
                 const RouterID& router_id,
                 const AreaID& area_id,
                 uint32_t adv_count,
-                uint16_t lsu_seqno);
+                uint16_t lsu_seqno,
+                bool costs,
+                uint32_t summary_count);
+
+  struct ospf_lsu_costs* costs_hdr() const;
+  struct ospf_lsu_summaries* summaries_hdr() const;
 
   /* Data members. */
   struct ospf_lsu_hdr* ospf_lsu_hdr_;
@@ -205,6 +257,255 @@ class OSPFLSUPacket : public OSPFPacket {
 };
 
 
+/* Incremental link-state update. Lists the advertisements that were added
+   and withdrawn by the sender since the update with sequence number
+   baseSeqno(). This is an extension to PWOSPF; it is only sent when
+   explicitly enabled, since routers that do not support it drop it. */
+class OSPFLSUDeltaPacket : public OSPFPacket {
+ public:
+  typedef Fwk::Ptr<const OSPFLSUDeltaPacket> PtrConst;
+  typedef Fwk::Ptr<OSPFLSUDeltaPacket> Ptr;
+
+  static const size_t kHeaderSize;
+
+  static Ptr NewDefault(PacketBuffer::Ptr buffer,
+                        const RouterID& router_id,
+                        const AreaID& area_id,
+                        uint32_t adv_count,
+                        uint32_t withdrawn_count,
+                        uint16_t lsu_seqno,
+                        uint16_t base_seqno);
+
+  static Ptr New(PacketBuffer::Ptr buffer, unsigned int buffer_offset) {
+    return new OSPFLSUDeltaPacket(buffer, buffer_offset);
+  }
+
+  uint16_t seqno() const;
+  void seqnoIs(uint16_t seqno);
+
+  uint16_t ttl() const;
+  void ttlIs(uint16_t ttl);
+  void ttlDec(uint16_t delta);
+
+  /* Sequence number of the update that this delta applies to. */
+  uint16_t baseSeqno() const;
+  void baseSeqnoIs(uint16_t seqno);
+
+  /* Number of added advertisements. */
+  uint32_t advCount() const;
+  void advCountIs(uint32_t count);
+
+  /* Number of withdrawn advertisements. */
+  uint32_t withdrawnCount() const;
+  void withdrawnCountIs(uint32_t count);
+
+  /* Added advertisements. */
+  Fwk::Ptr<OSPFLSUAdvPacket> advertisement(uint32_t index);
+  Fwk::Ptr<const OSPFLSUAdvPacket> advertisement(uint32_t index) const;
+
+  /* Withdrawn advertisements; these follow the added ones. */
+  Fwk::Ptr<OSPFLSUAdvPacket> withdrawal(uint32_t index);
+  Fwk::Ptr<const OSPFLSUAdvPacket> withdrawal(uint32_t index) const;
+
+  /* Override. */
+  virtual OSPFPacket::Ptr derivedInstance() { return this; }
+
+  /* Packet validation. */
+  virtual bool valid() const;
+
+  /* Double-dispatch support. */
+  virtual void operator()(Functor* f, Fwk::Ptr<const Interface> iface);
+
+ private:
+  OSPFLSUDeltaPacket(PacketBuffer::Ptr buffer, unsigned int buffer_offset);
+
+  /* For default construction. */
+  OSPFLSUDeltaPacket(PacketBuffer::Ptr buffer,
+                     const RouterID& router_id,
+                     const AreaID& area_id,
+                     uint32_t adv_count,
+                     uint32_t withdrawn_count,
+                     uint16_t lsu_seqno,
+                     uint16_t base_seqno);
+
+  /* Data members. */
+  struct ospf_lsu_delta_hdr* ospf_lsu_delta_hdr_;
+
+  /* Operations disallowed. */
+  OSPFLSUDeltaPacket(const OSPFLSUDeltaPacket&);
+  void operator=(const OSPFLSUDeltaPacket&);
+};
+
+
+/* Request for a complete link-state update from the router targetID(),
+   sent when a gap is detected in its incremental updates. Flooded like a
+   link-state update; seqno() is that of the requesting router. This is an
+   extension to PWOSPF. */
+class OSPFLSRPacket : public OSPFPacket {
+ public:
+  typedef Fwk::Ptr<const OSPFLSRPacket> PtrConst;
+  typedef Fwk::Ptr<OSPFLSRPacket> Ptr;
+
+  static const size_t kPacketSize;
+
+  static Ptr NewDefault(PacketBuffer::Ptr buffer,
+                        const RouterID& router_id,
+                        const AreaID& area_id,
+                        const RouterID& target_id,
+                        uint16_t lsr_seqno);
+
+  static Ptr New(PacketBuffer::Ptr buffer, unsigned int buffer_offset) {
+    return new OSPFLSRPacket(buffer, buffer_offset);
+  }
+
+  uint16_t seqno() const;
+  void seqnoIs(uint16_t seqno);
+
+  uint16_t ttl() const;
+  void ttlIs(uint16_t ttl);
+  void ttlDec(uint16_t delta);
+
+  /* Router ID of the router whose complete update is requested. */
+  RouterID targetID() const;
+  void targetIDIs(const RouterID& id);
+
+  /* Override. */
+  virtual OSPFPacket::Ptr derivedInstance() { return this; }
+
+  /* Packet validation. */
+  virtual bool valid() const;
+
+  /* Double-dispatch support. */
+  virtual void operator()(Functor* f, Fwk::Ptr<const Interface> iface);
+
+ private:
+  OSPFLSRPacket(PacketBuffer::Ptr buffer, unsigned int buffer_offset);
+
+  /* For default construction. */
+  OSPFLSRPacket(PacketBuffer::Ptr buffer,
+                const RouterID& router_id,
+                const AreaID& area_id,
+                const RouterID& target_id,
+                uint16_t lsr_seqno);
+
+  /* Data members. */
+  struct ospf_lsr_pkt* ospf_lsr_pkt_;
+
+  /* Operations disallowed. */
+  OSPFLSRPacket(const OSPFLSRPacket&);
+  void operator=(const OSPFLSRPacket&);
+};
+
+
+/* Liveness packet sent to the neighbors on an interface every interval()
+   milliseconds, in addition to regular HELLO packets. Neighbors declare the
+   sender dead once interval() * multiplier() milliseconds pass without one.
+   An interval of zero announces that the sender stops sending them. This is
+   an extension to PWOSPF. */
+class OSPFFastHelloPacket : public OSPFPacket {
+ public:
+  typedef Fwk::Ptr<const OSPFFastHelloPacket> PtrConst;
+  typedef Fwk::Ptr<OSPFFastHelloPacket> Ptr;
+
+  static const size_t kPacketSize;
+
+  static Ptr NewDefault(PacketBuffer::Ptr buffer,
+                        const RouterID& router_id,
+                        const AreaID& area_id,
+                        uint16_t interval,
+                        uint8_t multiplier);
+
+  static Ptr New(PacketBuffer::Ptr buffer, unsigned int buffer_offset) {
+    return new OSPFFastHelloPacket(buffer, buffer_offset);
+  }
+
+  /* Milliseconds between fast HELLO packets from the sender. */
+  uint16_t interval() const;
+  void intervalIs(uint16_t interval);
+
+  /* Number of consecutive fast HELLO packets that may be lost. */
+  uint8_t multiplier() const;
+  void multiplierIs(uint8_t multiplier);
+
+  /* Override. */
+  virtual OSPFPacket::Ptr derivedInstance() { return this; }
+
+  /* Packet validation. */
+  virtual bool valid() const;
+
+  /* Double-dispatch support. */
+  virtual void operator()(Functor* f, Fwk::Ptr<const Interface> iface);
+
+ private:
+  OSPFFastHelloPacket(PacketBuffer::Ptr buffer, unsigned int buffer_offset);
+
+  /* For default construction. */
+  OSPFFastHelloPacket(PacketBuffer::Ptr buffer,
+                      const RouterID& router_id,
+                      const AreaID& area_id,
+                      uint16_t interval,
+                      uint8_t multiplier);
+
+  /* Data members. */
+  struct ospf_fast_hello_pkt* ospf_fast_hello_pkt_;
+
+  /* Operations disallowed. */
+  OSPFFastHelloPacket(const OSPFFastHelloPacket&);
+  void operator=(const OSPFFastHelloPacket&);
+};
+
+
+/* Designated-router priority of the sender on the interface it is sent out
+   of, sent to the neighbors on that interface along with every HELLO
+   packet. Routers with a nonzero priority take part in designated-router
+   elections; a priority of zero announces that the sender stopped taking
+   part. This is an extension to PWOSPF. */
+class OSPFElectionPacket : public OSPFPacket {
+ public:
+  typedef Fwk::Ptr<const OSPFElectionPacket> PtrConst;
+  typedef Fwk::Ptr<OSPFElectionPacket> Ptr;
+
+  static const size_t kPacketSize;
+
+  static Ptr NewDefault(PacketBuffer::Ptr buffer,
+                        const RouterID& router_id,
+                        const AreaID& area_id,
+                        uint8_t priority);
+
+  static Ptr New(PacketBuffer::Ptr buffer, unsigned int buffer_offset) {
+    return new OSPFElectionPacket(buffer, buffer_offset);
+  }
+
+  uint8_t priority() const;
+  void priorityIs(uint8_t priority);
+
+  /* Override. */
+  virtual OSPFPacket::Ptr derivedInstance() { return this; }
+
+  /* Packet validation. */
+  virtual bool valid() const;
+
+  /* Double-dispatch support. */
+  virtual void operator()(Functor* f, Fwk::Ptr<const Interface> iface);
+
+ private:
+  OSPFElectionPacket(PacketBuffer::Ptr buffer, unsigned int buffer_offset);
+
+  /* For default construction. */
+  OSPFElectionPacket(PacketBuffer::Ptr buffer,
+                     const RouterID& router_id,
+                     const AreaID& area_id,
+                     uint8_t priority);
+
+  /* Data members. */
+  struct ospf_election_pkt* ospf_election_pkt_;
+
+  /* Operations disallowed. */
+  OSPFElectionPacket(const OSPFElectionPacket&);
+  void operator=(const OSPFElectionPacket&);
+};
+
+
 class OSPFLSUAdvPacket : public Packet {
  public:
   typedef Fwk::Ptr<const OSPFLSUAdvPacket> PtrConst;
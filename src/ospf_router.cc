@@ -1,10 +1,14 @@
 #include "ospf_router.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "fwk/deque.h"
 #include "fwk/log.h"
 #include "fwk/scoped_lock.h"
 
 #include "control_plane.h"
+#include "ethernet_packet.h"
 #include "interface.h"
 #include "interface_map.h"
 #include "ip_packet.h"
@@ -32,19 +36,25 @@ OSPFRouter::OSPFRouter(const RouterID& router_id,
                        InterfaceMap::Ptr iface_map,
                        ControlPlane* cp)
     : area_id_(area_id),
-      router_node_(OSPFNode::New(router_id)),
+      router_id_(router_id),
       interfaces_(OSPFInterfaceMap::New(iface_map)),
-      topology_(OSPFTopology::New(router_node_)),
-      topology_reactor_(TopologyReactor::New(this)),
       im_reactor_(OSPFInterfaceMapReactor::New(this)),
       rtable_reactor_(RoutingTableReactor::New(this)),
-      lsu_seqno_(0),
-      lsu_dirty_(true),
+      lsu_deltas_enabled_(false),
+      lsr_seqno_(0),
+      spf_initial_delay_(OSPF::kDefaultSPFInitialDelay),
+      spf_hold_time_(OSPF::kDefaultSPFHoldTime),
+      spf_max_wait_(OSPF::kDefaultSPFMaxWait),
+      summaries_dirty_(false),
+      lsu_full_floods_(0),
+      lsu_delta_floods_(0),
+      lsr_sent_(0),
+      flood_packets_sent_(0),
       routing_table_(rtable),
       control_plane_(cp),
       functor_(this),
       enabled_(true) {
-  topology_->notifieeIs(topology_reactor_);
+  area_new(area_id_);
   interfaces_->notifieeIs(im_reactor_);
   rtable_reactor_->notifierIs(routing_table_);
 
@@ -76,12 +86,39 @@ OSPFRouter::interfaceMap() {
 
 OSPFTopology::PtrConst
 OSPFRouter::topology() const {
-  return topology_;
+  return area(area_id_)->topology();
 }
 
 OSPFTopology::Ptr
 OSPFRouter::topology() {
-  return topology_;
+  return area(area_id_)->topology();
+}
+
+OSPFArea::PtrConst
+OSPFRouter::area(const AreaID& area_id) const {
+  return areas_.elem(area_id);
+}
+
+OSPFArea::Ptr
+OSPFRouter::area(const AreaID& area_id) {
+  return areas_.elem(area_id);
+}
+
+bool
+OSPFRouter::areaBorderRouter() const {
+  size_t attached = 0;
+  for (const_area_iter it = areas_.begin(); it != areas_.end(); ++it) {
+    if (it->second->interfaces() > 0)
+      ++attached;
+  }
+
+  return attached > 1;
+}
+
+uint32_t
+OSPFRouter::lsuSeqno(const AreaID& area_id) const {
+  std::map<AreaID,LSUState>::const_iterator it = lsu_states_.find(area_id);
+  return (it != lsu_states_.end()) ? it->second.seqno : 0;
 }
 
 RoutingTable::PtrConst
@@ -94,6 +131,13 @@ OSPFRouter::routingTable() {
   return routing_table_;
 }
 
+void
+OSPFRouter::routerIDIs(const RouterID& id) {
+  router_id_ = id;
+  for (area_iter it = areas_.begin(); it != areas_.end(); ++it)
+    it->second->rootNode()->routerIDIs(id);
+}
+
 void
 OSPFRouter::enabledIs(bool status) {
   if (enabled_ == status)
@@ -106,26 +150,137 @@ OSPFRouter::enabledIs(bool status) {
     /* Clear all dynamic entries from the routing table. */
     Fwk::ScopedLock<RoutingTable> lock(routing_table_);
     routing_table_->clearDynamicEntries();
+    routes_.clear();
+    dest_routes_.clear();
   }
 
   enabled_ = status;
+  summaries_dirty_ = true;
+}
+
+void
+OSPFRouter::lsuDeltasEnabledIs(bool status) {
+  if (lsu_deltas_enabled_ == status)
+    return;
+
+  /* The first incremental update needs a complete one to be based on. */
+  lsu_deltas_enabled_ = status;
+  std::map<AreaID,LSUState>::iterator it;
+  for (it = lsu_states_.begin(); it != lsu_states_.end(); ++it)
+    it->second.full_pending = true;
+}
+
+void
+OSPFRouter::spfThrottleIs(const Milliseconds& initial_delay,
+                          const Milliseconds& hold_time,
+                          const Milliseconds& max_wait) {
+  spf_initial_delay_ = initial_delay;
+  spf_hold_time_ = hold_time;
+  spf_max_wait_ = (max_wait < hold_time) ? hold_time : max_wait;
+
+  /* Pending computations keep their deadlines; the new timers apply from
+     the next topology change on. */
+  for (area_iter it = areas_.begin(); it != areas_.end(); ++it)
+    spf_throttle_update(it->second);
+}
+
+void
+OSPFRouter::lsuSeqnoIs(const AreaID& area_id, uint32_t seqno) {
+  std::map<AreaID,LSUState>::iterator it = lsu_states_.find(area_id);
+  if (it == lsu_states_.end())
+    return;
+
+  /* Neighbors have no update to base an incremental one on. */
+  it->second.seqno = seqno;
+  it->second.full_pending = true;
+}
+
+void
+OSPFRouter::areaRangeIs(const AreaID& area_id, const IPv4Subnet& range) {
+  area_new(area_id)->rangeIs(range);
+  rtable_update();
+  summaries_dirty_ = true;
+}
+
+void
+OSPFRouter::areaRangeDel(const AreaID& area_id, const IPv4Subnet& range) {
+  OSPFArea::Ptr area = this->area(area_id);
+  if (area == NULL)
+    return;
+
+  area->rangeDel(range);
+  rtable_update();
+  summaries_dirty_ = true;
+}
+
+void
+OSPFRouter::onLinkStateInterval() {
+  for (area_iter it = areas_.begin(); it != areas_.end(); ++it) {
+    /* Incremental updates are periodically superseded by a complete one, so
+       that routers that missed an update eventually recover. */
+    LSUState& state = lsu_states_[it->first];
+    if (++state.intervals >= OSPF::kDefaultLinkStateRefreshIntervals)
+      state.full_pending = true;
+
+    flood_lsu(it->second);
+  }
+
+  if (notifiee_)
+    notifiee_->onLinkStateFlood(this);
 }
 
 void
 OSPFRouter::onLinkStateUpdate() {
-  if (lsu_dirty_) {
-    flood_lsu();
-    lsu_dirty_ = false;
+  interface_areas_update();
+  link_costs_update();
+  dr_elections_update();
+  summaries_update();
+
+  /* Areas whose link state did not change are left alone; periodic floods
+     stay due in them unless every area was flooded. */
+  bool flooded = true;
+  for (area_iter it = areas_.begin(); it != areas_.end(); ++it) {
+    LSUState& state = lsu_states_[it->first];
+    if (!state.dirty) {
+      flooded = false;
+      continue;
+    }
+
+    flood_lsu(it->second);
+    state.dirty = false;
   }
+
+  if (flooded && notifiee_)
+    notifiee_->onLinkStateFlood(this);
 }
 
+/* OSPFRouter::LSUState */
+
+OSPFRouter::LSUState::LSUState()
+    : seqno(0),
+      dirty(true),
+      full_pending(true),
+      intervals(0) {}
+
 /* OSPFRouter::PacketFunctor */
 
 OSPFRouter::PacketFunctor::PacketFunctor(OSPFRouter* ospf_router)
     : ospf_router_(ospf_router),
-      router_node_(ospf_router->router_node_.ptr()),
-      interfaces_(ospf_router->interfaces_.ptr()),
-      topology_(ospf_router->topology_.ptr()) {}
+      interfaces_(ospf_router->interfaces_.ptr()) {}
+
+OSPFArea::Ptr
+OSPFRouter::PacketFunctor::packet_area(OSPFPacket* pkt,
+                                       Interface::PtrConst iface) {
+  OSPFInterface::Ptr ifd = interfaces_->interface(iface->ip());
+  AreaID area_id = ifd ? ifd->linkedAreaID() : ospf_router_->areaID();
+  if (pkt->areaID() != area_id) {
+    DLOG << "Ignoring packet: Area ID doesn't match that of the receiving "
+         << "interface.";
+    return NULL;
+  }
+
+  return ospf_router_->area(area_id);
+}
 
 void
 OSPFRouter::PacketFunctor::operator()(OSPFPacket* pkt,
@@ -146,10 +301,8 @@ OSPFRouter::PacketFunctor::operator()(OSPFHelloPacket* pkt,
     return;
   }
 
-  if (ospf_router_->areaID() != pkt->areaID()) {
-    DLOG << "Ignoring packet: Area ID doesn't match that of this router.";
+  if (packet_area(pkt, iface) == NULL)
     return;
-  }
 
   IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
   IPv4Addr gateway = ip_pkt->src();
@@ -208,43 +361,193 @@ OSPFRouter::PacketFunctor::operator()(OSPFLSUPacket* pkt,
     return;
   }
 
+  OSPFArea::Ptr area = packet_area(pkt, iface);
+  if (area == NULL)
+    return;
+
   RouterID node_id = pkt->routerID();
-  if (node_id == ospf_router_->routerID()) {
-    /* Drop link-state updates that were originally sent by this router.
-     * This will happen if the packet traverses a cycle that leads back to
-     * this router. This can be expected to happen relatively often;
-     * therefore, no logging is performed. */
+  OSPFNode::Ptr node = ospf_router_->lsu_sender(area, node_id, pkt->seqno());
+  if (node == NULL)
+    return;
+
+  ILOG << "Received LSU (seqno=" << pkt->seqno() << ") from "
+       << node_id << " with adv_count " << pkt->advCount();
+
+  /* Updating seqno in topology database */
+  node->latestSeqnoIs(pkt->seqno());
+  ospf_router_->process_lsu_advertisements(area, node, pkt, iface);
+  node->linksSyncedIs(true);
+
+  if (pkt->ttl() > 1) {
+    pkt->ttlDec(1);
+    pkt->checksumReset();
+    ospf_router_->forward_lsu_flood(area, pkt, iface);
+  }
+}
+
+void
+OSPFRouter::PacketFunctor::operator()(OSPFLSUDeltaPacket* pkt,
+                                      Interface::PtrConst iface) {
+  DLOG << "OSPFLSUDeltaPacket dispatch in OSPFRouter.";
+
+  /* Packet validation. */
+  if (!pkt->valid()) {
+    DLOG << "Ignoring invalid OSPF LSU delta packet.";
     return;
   }
 
-  OSPFNode::Ptr node = topology_->node(node_id);
-  if (node) {
-    uint32_t lower_bound = node->latestSeqno() > OSPF::kLinkStateWindow ?
-                           node->latestSeqno() - OSPF::kLinkStateWindow : 0;
-    if (pkt->seqno() >= lower_bound && pkt->seqno() <= node->latestSeqno()) {
-      DLOG << "Ignoring old LSU (seqno=" << pkt->seqno() << ") from "
-           << node_id;
-      return;
-    }
+  OSPFArea::Ptr area = packet_area(pkt, iface);
+  if (area == NULL)
+    return;
+
+  RouterID node_id = pkt->routerID();
+  OSPFNode::Ptr node = ospf_router_->lsu_sender(area, node_id, pkt->seqno());
+  if (node == NULL)
+    return;
+
+  ILOG << "Received LSU delta (seqno=" << pkt->seqno() << ", base="
+       << pkt->baseSeqno() << ") from " << node_id << " with adv_count "
+       << pkt->advCount() << " and withdrawn_count " << pkt->withdrawnCount();
 
+  /* The delta can only be applied on top of the update it is based on. */
+  bool synced = node->linksSynced() &&
+                node->latestSeqno() == pkt->baseSeqno();
+
+  node->latestSeqnoIs(pkt->seqno());
+  if (synced) {
+    ospf_router_->process_lsu_delta(area, node, pkt, iface);
   } else {
-    /* Creating new node and inserting it into the topology database */
-    node = OSPFNode::New(node_id);
-    topology_->nodeIs(node);
+    ILOG << "  gap in updates from " << node_id << ": requesting full LSU";
+    node->linksSyncedIs(false);
+    ospf_router_->lsr_send(area, node_id);
   }
 
-  ILOG << "Received LSU (seqno=" << pkt->seqno() << ") from "
-       << node_id << " with adv_count " << pkt->advCount();
+  /* Other routers may be in sync; the delta is flooded regardless. */
+  if (pkt->ttl() > 1) {
+    pkt->ttlDec(1);
+    pkt->checksumReset();
+    ospf_router_->forward_lsu_flood(area, pkt, iface);
+  }
+}
 
-  /* Updating seqno in topology database */
-  node->latestSeqnoIs(pkt->seqno());
-  ospf_router_->process_lsu_advertisements(node, pkt, iface);
+void
+OSPFRouter::PacketFunctor::operator()(OSPFLSRPacket* pkt,
+                                      Interface::PtrConst iface) {
+  DLOG << "OSPFLSRPacket dispatch in OSPFRouter.";
+
+  /* Packet validation. */
+  if (!pkt->valid()) {
+    DLOG << "Ignoring invalid OSPF LSR packet.";
+    return;
+  }
+
+  OSPFArea::Ptr area = packet_area(pkt, iface);
+  if (area == NULL)
+    return;
+
+  RouterID node_id = pkt->routerID();
+  if (node_id == ospf_router_->routerID())
+    return;
+
+  if (!ospf_router_->lsr_new(node_id, pkt->seqno()))
+    return;
+
+  if (pkt->targetID() == ospf_router_->routerID()) {
+    /* Requests from several routers are answered by a single complete
+       update, sent on the next link-state update signal. */
+    ILOG << "Received request for full LSU from " << node_id;
+    ospf_router_->lsu_changed(area->areaID(), true);
+    return;
+  }
 
   if (pkt->ttl() > 1) {
     pkt->ttlDec(1);
     pkt->checksumReset();
-    ospf_router_->forward_lsu_flood(pkt);
+    ospf_router_->forward_lsu_flood(area, pkt, iface);
+  }
+}
+
+void
+OSPFRouter::PacketFunctor::operator()(OSPFFastHelloPacket* pkt,
+                                      Interface::PtrConst iface) {
+  /* Packet validation. */
+  if (!pkt->valid()) {
+    DLOG << "Ignoring invalid OSPF fast HELLO packet.";
+    return;
   }
+
+  if (packet_area(pkt, iface) == NULL)
+    return;
+
+  /* Fast HELLOs only keep adjacencies alive; they are formed by regular
+     HELLO packets. */
+  OSPFInterface::Ptr ifd = interfaces_->interface(iface->ip());
+  if (ifd == NULL)
+    return;
+
+  OSPFGateway::Ptr gw_obj = ifd->activeGateway(pkt->routerID());
+  if (gw_obj == NULL)
+    return;
+
+  IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
+  if (ip_pkt->src() != gw_obj->gateway())
+    return;
+
+  uint32_t detect_time = (uint32_t)pkt->interval() * pkt->multiplier();
+  if (detect_time != gw_obj->fastHelloDetectTime()) {
+    ILOG << "Neighbor " << pkt->routerID() << " fast HELLO detect time is "
+         << detect_time << " ms";
+  }
+  gw_obj->fastHelloDetectTimeIs(detect_time);
+
+  if (ospf_router_->notifiee_)
+    ospf_router_->notifiee_->onFastHello(ospf_router_, ifd, gw_obj);
+}
+
+void
+OSPFRouter::PacketFunctor::operator()(OSPFElectionPacket* pkt,
+                                      Interface::PtrConst iface) {
+  /* Packet validation. */
+  if (!pkt->valid()) {
+    DLOG << "Ignoring invalid OSPF election packet.";
+    return;
+  }
+
+  if (packet_area(pkt, iface) == NULL)
+    return;
+
+  /* Like fast HELLOs, election packets only apply to existing
+     adjacencies. The election itself runs with the next link-state
+     update signal. */
+  OSPFInterface::Ptr ifd = interfaces_->interface(iface->ip());
+  if (ifd == NULL)
+    return;
+
+  OSPFGateway::Ptr gw_obj = ifd->activeGateway(pkt->routerID());
+  if (gw_obj == NULL)
+    return;
+
+  IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
+  if (ip_pkt->src() != gw_obj->gateway())
+    return;
+
+  if (pkt->priority() != gw_obj->drPriority()) {
+    ILOG << "Neighbor " << pkt->routerID() << " designated-router priority "
+         << "is " << (uint32_t)pkt->priority();
+  }
+  gw_obj->drPriorityIs(pkt->priority());
+}
+
+/* OSPFRouter::TopologyReactor */
+
+void
+OSPFRouter::TopologyReactor::onDirtyCleared() {
+  router_->rtable_update(area_, area_->topology()->changedNodes());
+}
+
+void
+OSPFRouter::TopologyReactor::onBackupHops() {
+  router_->rtable_update(area_, area_->topology()->changedNodes());
 }
 
 /* OSPFRouter::OSPFInterfaceMapReactor */
@@ -259,12 +562,22 @@ OSPFRouter::OSPFInterfaceMapReactor::onInterface(OSPFInterfaceMap::Ptr _im,
   if (ospf_router_->routerID() == OSPF::kInvalidRouterID)
     ospf_router_->routerIDIs((RouterID)iface->interfaceIP().value());
 
+  /* New interfaces are in the router's area until configured otherwise. */
+  iface->areaIDIs(ospf_router_->areaID());
+  iface->linkedAreaIDIs(ospf_router_->areaID());
+  OSPFArea::Ptr area = ospf_router_->interface_area(iface);
+  area->interfacesIs(area->interfaces() + 1);
+  ospf_router_->summaries_dirty_ = true;
+
   /* Create passive gateway for added interface. */
   RoutingTable::Ptr rtable = ospf_router_->routingTable();
   RoutingTable::Entry::Ptr entry = rtable->entry(iface->interfaceSubnet(),
                                                  iface->interfaceSubnetMask());
   if (entry)
     ospf_router_->update_iface_from_rtable_entry_new(iface, entry);
+
+  if (ospf_router_->notifiee_)
+    ospf_router_->notifiee_->onInterface(ospf_router_, iface);
 }
 
 void
@@ -278,6 +591,14 @@ OSPFRouter::OSPFInterfaceMapReactor::onInterfaceDel(OSPFInterfaceMap::Ptr _im,
                                                  iface->interfaceSubnetMask());
   if (entry)
    ospf_router_->update_iface_from_rtable_entry_delete(iface, entry);
+
+  OSPFArea::Ptr area = ospf_router_->interface_area(iface);
+  if (area->interfaces() > 0)
+    area->interfacesIs(area->interfaces() - 1);
+  ospf_router_->summaries_dirty_ = true;
+
+  if (ospf_router_->notifiee_)
+    ospf_router_->notifiee_->onInterfaceDel(ospf_router_, iface);
 }
 
 void
@@ -294,16 +615,28 @@ OSPFRouter::OSPFInterfaceMapReactor::onGateway(OSPFInterfaceMap::Ptr _im,
          << iface->interfaceName();
   }
 
-  ospf_router_->topology_->nodeIs(gw_obj->node());
-  ospf_router_->router_node_->linkIs(gw_obj);
+  OSPFArea::Ptr area = ospf_router_->interface_area(iface);
+  area->topology()->nodeIs(gw_obj->node());
+  area->rootNode()->linkIs(gw_obj);
 
-  ospf_router_->lsu_dirty_ = true;
+  /* A new neighbor has not seen any of this router's previous updates, and
+     deltas carry no costs: receivers would install a new passive link at
+     the default cost. */
+  bool full = !gw_obj->nodeIsPassiveEndpoint() ||
+              gw_obj->cost() != OSPF::kDefaultLinkCost;
+  ospf_router_->lsu_changed(area->areaID(), full);
+  ospf_router_->summaries_dirty_ = true;
+
+  if (!gw_obj->nodeIsPassiveEndpoint() && ospf_router_->notifiee_)
+    ospf_router_->notifiee_->onNeighbor(ospf_router_, iface, gw_obj);
 }
 
 void
 OSPFRouter::OSPFInterfaceMapReactor::onGatewayDel(OSPFInterfaceMap::Ptr _im,
                                                   OSPFInterface::Ptr iface,
                                                   OSPFGateway::Ptr gw_obj) {
+  OSPFArea::Ptr area = ospf_router_->interface_area(iface);
+
   if (gw_obj->nodeIsPassiveEndpoint()) {
     IPv4Addr subnet = gw_obj->subnet();
     IPv4Addr mask = gw_obj->subnetMask();
@@ -311,7 +644,7 @@ OSPFRouter::OSPFInterfaceMapReactor::onGatewayDel(OSPFInterfaceMap::Ptr _im,
     ILOG << "Removed passive gateway with subnet " << subnet << " from "
          << iface->interfaceName();
 
-    ospf_router_->router_node_->passiveLinkDel(subnet, mask);
+    area->rootNode()->passiveLinkDel(subnet, mask);
 
   } else {
     RouterID nd_id = gw_obj->nodeRouterID();
@@ -319,15 +652,30 @@ OSPFRouter::OSPFInterfaceMapReactor::onGatewayDel(OSPFInterfaceMap::Ptr _im,
     ILOG << "Removed active gateway with subnet " << gw_obj->subnet()
          << " to nbr " << nd_id << " from " << iface->interfaceName();
 
-    if (_im->activeGateway(nd_id) == NULL) {
-      /* If there are no other gateways connecting this router to ND_ID,
-         delete link to node from topology. */
+    if (_im->activeGateway(nd_id, area->areaID()) == NULL) {
+      /* Traffic through the lost neighbor is moved to precomputed
+         alternates right away; the spanning tree is recomputed later. */
+      ospf_router_->rtable_repair(
+        RoutingTable::Entry::NextHop(gw_obj->gateway(),
+                                     iface->interface()));
+
+      /* If there are no other gateways connecting this router to ND_ID
+         in AREA, delete link to node from the area's topology. */
       ILOG << "Removed active link to " << nd_id;
-      ospf_router_->router_node_->activeLinkDel(nd_id);
+      area->rootNode()->activeLinkDel(nd_id);
+
+    } else {
+      /* The topology is unchanged, but routes through ND_ID may now have to
+         use a different gateway. */
+      ospf_router_->rtable_update();
     }
+
+    if (ospf_router_->notifiee_)
+      ospf_router_->notifiee_->onNeighborDel(ospf_router_, iface, gw_obj);
   }
 
-  ospf_router_->lsu_dirty_ = true;
+  ospf_router_->lsu_changed(area->areaID(), false);
+  ospf_router_->summaries_dirty_ = true;
 }
 
 /* OSPFRouter::RoutingTableReactor. */
@@ -353,201 +701,906 @@ OSPFRouter::RoutingTableReactor::onEntryDel(RoutingTable::Ptr rtable,
 /* OSPFRouter private member functions */
 
 void
-OSPFRouter::outputPacketNew(OSPFPacket::Ptr ospf_pkt) const {
+OSPFRouter::outputPacketNew(OSPFPacket::Ptr ospf_pkt) {
   if (enabled_) {
     IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(ospf_pkt->enclosingPacket());
     control_plane_->outputPacketNew(ip_pkt);
+    ++flood_packets_sent_;
   }
 }
 
 void
-OSPFRouter::rtable_update() {
-  if (!enabled_)
-    return;
+OSPFRouter::output_segment_packet(OSPFPacket::Ptr ospf_pkt,
+                                  OSPFInterface::Ptr iface) {
+  if (enabled_) {
+    /* Sent like HELLO packets. */
+    IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(ospf_pkt->enclosingPacket());
+    control_plane_->outputRawPacketNew(ip_pkt, iface->interface(),
+                                       IPv4Addr::kZero,
+                                       EthernetAddr::kBroadcast);
+    ++flood_packets_sent_;
+  }
+}
 
-  ILOG << "Routing table updated";
+OSPFArea::Ptr
+OSPFRouter::area_new(const AreaID& area_id) {
+  OSPFArea::Ptr area = areas_.elem(area_id);
+  if (area)
+    return area;
 
-  Fwk::ScopedLock<RoutingTable> lock(routing_table_);
+  ILOG << "Added area " << area_id;
 
-  /* Clear all dynamic entries in the routing table
-     before inserting the new ones. */
-  routing_table_->clearDynamicEntries();
+  area = OSPFArea::New(area_id, router_id_);
+  area->topology()->notifieeIs(TopologyReactor::New(this, area.ptr()));
+  spf_throttle_update(area);
+  areas_.elemIs(area_id, area);
+  lsu_states_[area_id] = LSUState();
 
-  OSPFNode::PtrConst next_hop, dest;
-  OSPFTopology::const_iterator it;
-  for (it = topology_->nodesBegin(); it != topology_->nodesEnd(); ++it) {
-    RouterID node_id = it->first;
+  return area;
+}
 
-    next_hop = topology_->nextHop(node_id);
-    if (next_hop == NULL)
-      continue;
+void
+OSPFRouter::spf_throttle_update(OSPFArea::Ptr area) {
+  OSPFSPFThrottle::Ptr throttle = area->topology()->spfThrottle();
+  throttle->initialDelayIs(spf_initial_delay_);
+  throttle->holdTimeIs(spf_hold_time_);
+  throttle->maxWaitIs(spf_max_wait_);
+}
 
-    dest = it->second;
-    rtable_add_dest(next_hop, dest);
-  }
+OSPFArea::Ptr
+OSPFRouter::interface_area(OSPFInterface::PtrConst iface) {
+  OSPFArea::Ptr area = areas_.elem(iface->linkedAreaID());
+  if (area == NULL)
+    area = areas_.elem(area_id_);
+
+  return area;
 }
 
-/* Function assumes that routing_table_ is already locked. */
 void
-OSPFRouter::rtable_add_dest(OSPFNode::PtrConst next_hop,
-                            OSPFNode::PtrConst dest) {
-  if (next_hop->isPassiveEndpoint() || dest->isPassiveEndpoint()) {
-    ELOG << "rtable_add_dest: either NEXT_HOP or DEST is a passive endpoint.";
-    return;
+OSPFRouter::interface_areas_update() {
+  for (OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
+       if_it != interfaces_->ifacesEnd(); ++if_it) {
+    OSPFInterface::Ptr iface = if_it->second;
+    if (iface->areaID() != iface->linkedAreaID())
+      interface_area_move(iface);
   }
+}
 
-  RouterID next_hop_id = next_hop->routerID();
-  RouterID dest_id = dest->routerID();
+void
+OSPFRouter::interface_area_move(OSPFInterface::Ptr iface) {
+  OSPFArea::Ptr prev = interface_area(iface);
+  OSPFArea::Ptr area = area_new(iface->areaID());
 
-  OSPFGateway::Ptr gw_obj = interfaces_->activeGateway(next_hop_id);
-  if (gw_obj == NULL) {
-    ELOG << "rtable_add_dest: NEXT_HOP is not connected to any interface.";
-    ELOG << "  next_hop_id: " << next_hop_id;
-    ELOG << "  dest_id:     " << dest_id;
-    return;
+  ILOG << "Moving " << iface->interfaceName() << " from area "
+       << prev->areaID() << " to area " << area->areaID();
+
+  /* Neighbors are removed while the interface is still linked into PREV;
+     see OSPFInterfaceMapReactor::onGatewayDel(). */
+  std::vector<RouterID> nbr_ids;
+  for (OSPFInterface::const_gwa_iter it = iface->activeGatewaysBegin();
+       it != iface->activeGatewaysEnd(); ++it) {
+    nbr_ids.push_back(it->first);
   }
 
-  /* Adding links to other OSFP nodes to the routing table. */
-  for (OSPFNode::const_lna_iter it = dest->activeLinksBegin();
-       it != dest->activeLinksEnd(); ++it) {
-    OSPFLink::Ptr link = it->second;
-    if (dest->upstreamNode() == link->node() && dest_id != next_hop_id) {
-      /* Don't add the subnet through which we are connected to DEST unless
-         the next hop to DEST is DEST itself. */
-      continue;
-    }
+  for (size_t i = 0; i < nbr_ids.size(); ++i)
+    iface->activeGatewayDel(nbr_ids[i]);
 
-    rtable_add_gateway(link->subnet(), link->subnetMask(),
-                       gw_obj->gateway(), gw_obj->interface());
+  /* Passive gateways move along with the interface. */
+  for (OSPFInterface::const_gwp_iter it = iface->passiveGatewaysBegin();
+       it != iface->passiveGatewaysEnd(); ++it) {
+    OSPFGateway::Ptr gw_obj = it->second;
+    prev->rootNode()->passiveLinkDel(gw_obj->subnet(), gw_obj->subnetMask());
   }
 
-  /* Adding links to passive endpoints to the routing table. */
-  for (OSPFNode::const_lnp_iter it = dest->passiveLinksBegin();
-       it != dest->passiveLinksEnd(); ++it) {
-    OSPFLink::Ptr link = it->second;
-    rtable_add_gateway(link->subnet(), link->subnetMask(),
-                       gw_obj->gateway(), gw_obj->interface());
+  if (prev->interfaces() > 0)
+    prev->interfacesIs(prev->interfaces() - 1);
+
+  iface->linkedAreaIDIs(area->areaID());
+  area->interfacesIs(area->interfaces() + 1);
+
+  for (OSPFInterface::const_gwp_iter it = iface->passiveGatewaysBegin();
+       it != iface->passiveGatewaysEnd(); ++it) {
+    OSPFGateway::Ptr gw_obj = it->second;
+    area->topology()->nodeIs(gw_obj->node());
+    area->rootNode()->linkIs(gw_obj);
   }
+
+  lsu_changed(prev->areaID(), true);
+  lsu_changed(area->areaID(), true);
+  summaries_dirty_ = true;
 }
 
 void
-OSPFRouter::rtable_add_gateway(const IPv4Addr& subnet,
-                               const IPv4Addr& mask,
-                               const IPv4Addr& gateway,
-                               OSPFInterface::PtrConst iface) {
-  /* Setting entry's subnet, subnet mask, outgoing interface, and gateway. */
-  RoutingTable::Entry::Ptr entry = RoutingTable::Entry::New();
-  entry->subnetIs(subnet, mask);
-  entry->gatewayIs(gateway);
-  entry->interfaceIs(iface->interface());
-
-  routing_table_->entryIs(entry);
+OSPFRouter::rtable_update() {
+  for (area_iter ar_it = areas_.begin(); ar_it != areas_.end(); ++ar_it) {
+    OSPFArea::Ptr area = ar_it->second;
+    OSPFTopology::Ptr topology = area->topology();
+
+    /* All nodes in the topology, plus all nodes that still have routes. */
+    std::vector<RouterID> dests;
+    OSPFTopology::const_iterator it;
+    for (it = topology->nodesBegin(); it != topology->nodesEnd(); ++it)
+      dests.push_back(it->first);
+
+    const DestRoutesMap& area_routes = dest_routes_[area->areaID()];
+    DestRoutesMap::const_iterator dr_it;
+    for (dr_it = area_routes.begin(); dr_it != area_routes.end(); ++dr_it)
+      dests.push_back(dr_it->first);
+
+    rtable_update(area, dests);
+  }
 }
 
 void
-OSPFRouter::process_lsu_advertisements(OSPFNode::Ptr sender,
-                                       OSPFLSUPacket::PtrConst pkt,
-                                       Interface::PtrConst iface) {
-  OSPFAdvertisementSet::Ptr adv_set = OSPFAdvertisementSet::New();
+OSPFRouter::rtable_update(OSPFArea::Ptr area,
+                          const std::vector<RouterID>& dests) {
+  if (!enabled_)
+    return;
 
-  /* Obtain tunnel object if IFACE is a virtual interface. */
-  Tunnel::PtrConst tunnel = NULL;
-  if (iface->type() == Interface::kVirtual) {
-    TunnelMap::Ptr tunnel_map = control_plane_->tunnelMap();
-    tunnel = tunnel_map->tunnel(iface->name());
-    if (tunnel == NULL) {
-      ELOG << "process_lsu_advertisements: tunnel map does not contain inbound "
-           << "virtual interface";
-    }
-  }
+  ILOG << "Routing table updated from area " << area->areaID();
 
-  /* Processing each LSU advertisement enclosed in the LSU packet. */
-  for (uint32_t adv_index = 0; adv_index < pkt->advCount(); ++adv_index) {
-    OSPFLSUAdvPacket::PtrConst adv_pkt = pkt->advertisement(adv_index);
+  Fwk::ScopedLock<RoutingTable> lock(routing_table_);
 
-    if (adv_pkt->routerID() == this->routerID()) {
-      /* SENDER is advertising this router as a direct neighbor. */
-      /* Hello protocol takes precedence. */
-      ILOG << "  ignore        " << adv_pkt->routerID() << " -- this router";
-      continue;
-    }
+  /* Subnets whose set of recorded routes has changed. */
+  std::set<IPv4Subnet> affected;
+  DestRoutesMap& area_routes = dest_routes_[area->areaID()];
 
-    if (tunnel &&
-        (tunnel->remote() & adv_pkt->subnetMask()) == adv_pkt->subnet()) {
-      ILOG << "  ignore        " << adv_pkt->subnet()
-           << " -- tunnel endpoint";
+  std::vector<RouterID>::const_iterator it;
+  for (it = dests.begin(); it != dests.end(); ++it) {
+    RouterID dest_id = *it;
+    if (dest_id == routerID())
       continue;
-    }
-
-    /* Add advertisement to set of confirmed links. */
-    adv_set->advertisementIs(sender->routerID(), adv_pkt->routerID(),
-                             adv_pkt->subnet(), adv_pkt->subnetMask());
 
-    OSPFAdvertisement::Ptr adv_obj;
-    if (adv_pkt->routerID() != OSPF::kPassiveEndpointID) {
-      /* Check if the advertised neighbor has also advertised connectivity to
-         SENDER. If it has, then there will exist a NeighborRelationship object
-         in the LINKS_STAGED multimap. */
-      adv_obj = advs_staged_.advertisement(adv_pkt->routerID(),
-                                           sender->routerID(),
-                                           adv_pkt->subnet(),
-                                           adv_pkt->subnetMask());
-      if (adv_obj) {
-        /* Staged advertisement exists.
-           Commit neighbor relationship to topology. */
-
-        OSPFNode::Ptr sender = adv_obj->sender();
-        sender->linkIs(adv_obj->link());
-
-        /* Unstage advertisement. */
-        advs_staged_.advertisementDel(adv_obj);
-
-        ILOG << "  adv-commit(a) " << sender->routerID();
-
-      } else {
-
-        /* The advertised neighbor is added to the network topology. The
-           neighbor relationship between NEIGHBOR and SENDER, however, is
-           staged for now. It is committed when NEIGHBOR confirms connectivity
-           to SENDER with an LSU of its own. */
-
-        OSPFNode::Ptr neighbor_nd = topology_->node(adv_pkt->routerID());
-        if (neighbor_nd == NULL) {
-          neighbor_nd = OSPFNode::New(adv_pkt->routerID());
-          topology_->nodeIs(neighbor_nd);
-        }
+    RouteSource source(area, dest_id, false);
+    RouteSource summary_source(area, dest_id, true);
 
-        OSPFLink::Ptr link = OSPFLink::New(neighbor_nd,
-                                           adv_pkt->subnet(),
-                                           adv_pkt->subnetMask());
-        adv_obj = OSPFAdvertisement::New(sender, link);
-        advs_staged_.advertisementIs(adv_obj);
+    DestRoutes routes;
+    bool reachable = rtable_dest_routes(area, dest_id, routes);
 
-        ILOG << "  adv-stage     " << link->nodeRouterID();
+    DestRoutesMap::iterator dr_it = area_routes.find(dest_id);
+    if (dr_it == area_routes.end()) {
+      if (reachable) {
+        rtable_add_routes(source, routes, routes.subnets, affected);
+        rtable_add_routes(summary_source, routes, routes.summaries, affected);
+        area_routes[dest_id] = routes;
       }
+      continue;
+    }
 
-    } else {
-      /* Advertisement corresponds to an endpoint that is not running OSPF.
-         Bypass two-phase commit logic. */
-
-      OSPFLink::Ptr link = OSPFLink::NewPassive(adv_pkt->subnet(),
-                                                adv_pkt->subnetMask());
-      sender->linkIs(link);
+    DestRoutes& prev = dr_it->second;
+    if (!reachable) {
+      rtable_del_routes(source, prev.subnets, affected);
+      rtable_del_routes(summary_source, prev.summaries, affected);
+      area_routes.erase(dr_it);
+      continue;
+    }
 
-      ILOG << "  adv-commit(p) " << adv_pkt->subnet();
+    bool hops_changed =
+      prev.next_hops != routes.next_hops || prev.backup != routes.backup;
+    if (!hops_changed && prev.subnets == routes.subnets &&
+        prev.summaries == routes.summaries) {
+      /* Nothing to do: DEST_ID contributes the same routes as before. */
+      continue;
     }
+
+    rtable_replace_routes(source, prev.subnets, routes, routes.subnets,
+                          hops_changed, affected);
+    rtable_replace_routes(summary_source, prev.summaries, routes,
+                          routes.summaries, hops_changed, affected);
+    prev = routes;
   }
 
-  remove_unconfirmed_links(sender, adv_set);
+  /* Prefixes advertised into other areas follow the routing table. */
+  if (!affected.empty())
+    summaries_dirty_ = true;
+
+  /* Only entries that actually changed trigger routing table notifications;
+     see RoutingTable::entryIs(). */
+  std::set<IPv4Subnet>::const_iterator sn_it;
+  for (sn_it = affected.begin(); sn_it != affected.end(); ++sn_it)
+    rtable_install(*sn_it);
 }
 
-void
-OSPFRouter::remove_unconfirmed_links(OSPFNode::Ptr sender,
-                                     OSPFAdvertisementSet::Ptr confirmed_advs) {
-  if (sender == router_node_ || sender->routerID() == this->routerID()) {
-    ELOG << "remove_unconfirmed_links: Attempt to remove unconfirmed links "
-         << "from the root node itself.";
-    return;
+bool
+OSPFRouter::rtable_dest_routes(OSPFArea::PtrConst area,
+                               const RouterID& dest_id,
+                               DestRoutes& routes) const {
+  OSPFTopology::PtrConst topology = area->topology();
+  OSPFNode::PtrConst dest = topology->node(dest_id);
+  OSPFNode::PtrConst next_hop = topology->nextHop(dest_id);
+  if (dest == NULL || next_hop == NULL)
+    return false;
+
+  if (next_hop->isPassiveEndpoint() || dest->isPassiveEndpoint()) {
+    ELOG << "rtable_dest_routes: either NEXT_HOP or DEST is a passive "
+         << "endpoint.";
+    return false;
+  }
+
+  RouterID next_hop_id = next_hop->routerID();
+
+  /* One next hop per equal-cost first hop, in RouterID order. */
+  routes.next_hops.clear();
+  for (OSPFNode::const_fh_iter it = dest->firstHopsBegin();
+       it != dest->firstHopsEnd(); ++it) {
+    RouterID first_hop_id = (*it)->routerID();
+    OSPFGateway::PtrConst gw_obj =
+      interfaces_->activeGateway(first_hop_id, area->areaID());
+    if (gw_obj == NULL) {
+      ELOG << "rtable_dest_routes: first hop is not connected to any "
+           << "interface.";
+      ELOG << "  first_hop_id: " << first_hop_id;
+      ELOG << "  dest_id:      " << dest_id;
+      continue;
+    }
+
+    routes.next_hops.push_back(
+      RoutingTable::Entry::NextHop(gw_obj->gateway(),
+                                   gw_obj->interface()->interface()));
+  }
+
+  if (routes.next_hops.empty())
+    return false;
+
+  routes.backup = RoutingTable::Entry::NextHop();
+  OSPFNode::PtrConst backup_hop = dest->backupHop();
+  if (backup_hop) {
+    OSPFGateway::PtrConst gw_obj =
+      interfaces_->activeGateway(backup_hop->routerID(), area->areaID());
+    if (gw_obj) {
+      routes.backup =
+        RoutingTable::Entry::NextHop(gw_obj->gateway(),
+                                     gw_obj->interface()->interface());
+    }
+  }
+
+  routes.subnets.clear();
+  routes.summaries.clear();
+
+  /* Links to other OSPF nodes. */
+  for (OSPFNode::const_lna_iter it = dest->activeLinksBegin();
+       it != dest->activeLinksEnd(); ++it) {
+    OSPFLink::PtrConst link = it->second;
+    if (dest->upstreamNode() == link->node() && dest_id != next_hop_id) {
+      /* Don't add the subnet through which we are connected to DEST unless
+         the next hop to DEST is DEST itself. */
+      continue;
+    }
+
+    routes.subnets.push_back(std::make_pair(link->subnet(),
+                                            link->subnetMask()));
+  }
+
+  /* Links to passive endpoints, and inter-area summaries. */
+  for (OSPFNode::const_lnp_iter it = dest->passiveLinksBegin();
+       it != dest->passiveLinksEnd(); ++it) {
+    OSPFLink::PtrConst link = it->second;
+    IPv4Subnet subnet = std::make_pair(link->subnet(), link->subnetMask());
+    if (!link->summary())
+      routes.subnets.push_back(subnet);
+    else if (!range_summarized(subnet))
+      routes.summaries.push_back(subnet);
+  }
+
+  std::sort(routes.subnets.begin(), routes.subnets.end());
+  routes.subnets.erase(std::unique(routes.subnets.begin(),
+                                   routes.subnets.end()),
+                       routes.subnets.end());
+
+  std::sort(routes.summaries.begin(), routes.summaries.end());
+  routes.summaries.erase(std::unique(routes.summaries.begin(),
+                                     routes.summaries.end()),
+                         routes.summaries.end());
+
+  return true;
+}
+
+bool
+OSPFRouter::range_summarized(const IPv4Subnet& subnet) const {
+  if (!areaBorderRouter())
+    return false;
+
+  for (const_area_iter it = areas_.begin(); it != areas_.end(); ++it) {
+    OSPFArea::PtrConst area = it->second;
+    if (area->interfaces() == 0)
+      continue;
+
+    const std::vector<IPv4Subnet>& ranges = area->ranges();
+    if (std::binary_search(ranges.begin(), ranges.end(),
+                           area->summaryPrefix(subnet))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void
+OSPFRouter::rtable_add_routes(const RouteSource& source,
+                              const DestRoutes& routes,
+                              const std::vector<IPv4Subnet>& subnets,
+                              std::set<IPv4Subnet>& affected) {
+  std::vector<IPv4Subnet>::const_iterator it;
+  for (it = subnets.begin(); it != subnets.end(); ++it) {
+    /* Setting entry's subnet, subnet mask, outgoing interface, and
+       gateway. */
+    RoutingTable::Entry::Ptr entry = RoutingTable::Entry::New();
+    entry->subnetIs(it->first, it->second);
+    entry->gatewayIs(routes.next_hops[0].gateway());
+    entry->interfaceIs(routes.next_hops[0].interface());
+    for (size_t i = 1; i < routes.next_hops.size(); ++i) {
+      entry->nextHopNew(routes.next_hops[i].gateway(),
+                        routes.next_hops[i].interface());
+    }
+    entry->backupNextHopIs(routes.backup.gateway(), routes.backup.interface());
+
+    IPv4Subnet key = std::make_pair(entry->subnet(), entry->subnetMask());
+    routes_[key][source] = entry;
+    affected.insert(key);
+  }
+}
+
+void
+OSPFRouter::rtable_del_routes(const RouteSource& source,
+                              const std::vector<IPv4Subnet>& subnets,
+                              std::set<IPv4Subnet>& affected) {
+  std::vector<IPv4Subnet>::const_iterator it;
+  for (it = subnets.begin(); it != subnets.end(); ++it) {
+    std::map<IPv4Subnet,RouteContributorMap>::iterator rt_it =
+      routes_.find(*it);
+    if (rt_it == routes_.end())
+      continue;
+
+    rt_it->second.erase(source);
+    if (rt_it->second.empty())
+      routes_.erase(rt_it);
+
+    affected.insert(*it);
+  }
+}
+
+void
+OSPFRouter::rtable_replace_routes(const RouteSource& source,
+                                  const std::vector<IPv4Subnet>& prev_subnets,
+                                  const DestRoutes& routes,
+                                  const std::vector<IPv4Subnet>& subnets,
+                                  bool hops_changed,
+                                  std::set<IPv4Subnet>& affected) {
+  if (hops_changed) {
+    /* Every route contributed by SOURCE moves to the new next hops. */
+    rtable_del_routes(source, prev_subnets, affected);
+    rtable_add_routes(source, routes, subnets, affected);
+    return;
+  }
+
+  if (prev_subnets == subnets)
+    return;
+
+  /* Same next hops; only the subnets that came or went are updated. */
+  std::vector<IPv4Subnet> removed;
+  std::set_difference(prev_subnets.begin(), prev_subnets.end(),
+                      subnets.begin(), subnets.end(),
+                      std::back_inserter(removed));
+
+  std::vector<IPv4Subnet> added;
+  std::set_difference(subnets.begin(), subnets.end(),
+                      prev_subnets.begin(), prev_subnets.end(),
+                      std::back_inserter(added));
+
+  rtable_del_routes(source, removed, affected);
+  rtable_add_routes(source, routes, added, affected);
+}
+
+/* Function assumes that routing_table_ is already locked. */
+void
+OSPFRouter::rtable_install(const IPv4Subnet& subnet) {
+  std::map<IPv4Subnet,RouteContributorMap>::const_iterator it =
+    routes_.find(subnet);
+  if (it != routes_.end()) {
+    routing_table_->entryIs(it->second.rbegin()->second);
+    return;
+  }
+
+  /* No node contributes a route to SUBNET anymore. */
+  RoutingTable::Entry::Ptr entry =
+    routing_table_->entry(subnet.first, subnet.second);
+  if (entry && entry->type() == RoutingTable::Entry::kDynamic)
+    routing_table_->entryDel(entry);
+}
+
+void
+OSPFRouter::rtable_repair(const RoutingTable::Entry::NextHop& failed) {
+  if (!enabled_)
+    return;
+
+  Fwk::ScopedLock<RoutingTable> lock(routing_table_);
+
+  std::set<IPv4Subnet> affected;
+  std::map<AreaID,DestRoutesMap>::iterator ar_it;
+  for (ar_it = dest_routes_.begin(); ar_it != dest_routes_.end(); ++ar_it) {
+    OSPFArea::PtrConst area = areas_.elem(ar_it->first);
+    DestRoutesMap::iterator it;
+    for (it = ar_it->second.begin(); it != ar_it->second.end(); ++it) {
+      DestRoutes routes = it->second;
+      std::vector<RoutingTable::Entry::NextHop>& next_hops = routes.next_hops;
+      next_hops.erase(std::remove(next_hops.begin(), next_hops.end(), failed),
+                      next_hops.end());
+      if (routes.backup == failed)
+        routes.backup = RoutingTable::Entry::NextHop();
+
+      if (next_hops.empty()) {
+        if (routes.backup.interface() == NULL)
+          continue;
+
+        next_hops.push_back(routes.backup);
+        routes.backup = RoutingTable::Entry::NextHop();
+      }
+
+      if (next_hops == it->second.next_hops &&
+          routes.backup == it->second.backup) {
+        continue;
+      }
+
+      RouteSource source(area, it->first, false);
+      rtable_replace_routes(source, it->second.subnets, routes,
+                            routes.subnets, true, affected);
+
+      RouteSource summary_source(area, it->first, true);
+      rtable_replace_routes(summary_source, it->second.summaries, routes,
+                            routes.summaries, true, affected);
+      it->second = routes;
+    }
+  }
+
+  if (!affected.empty())
+    ILOG << "Local repair of " << affected.size() << " routes";
+
+  std::set<IPv4Subnet>::const_iterator sn_it;
+  for (sn_it = affected.begin(); sn_it != affected.end(); ++sn_it)
+    rtable_install(*sn_it);
+}
+
+/* OSPFRouter::RouteSource */
+
+OSPFRouter::RouteSource::RouteSource(OSPFArea::PtrConst area,
+                                     const RouterID& dest_id,
+                                     bool summary)
+    : type(kIntraArea), router_id(dest_id), area_id(area->areaID()) {
+  if (summary)
+    type = area->backbone() ? kBackboneSummary : kSummary;
+}
+
+bool
+OSPFRouter::RouteSource::operator<(const RouteSource& other) const {
+  if (type != other.type)
+    return type < other.type;
+
+  if (router_id != other.router_id)
+    return router_id < other.router_id;
+
+  return area_id < other.area_id;
+}
+
+void
+OSPFRouter::process_lsu_advertisements(OSPFArea::Ptr area,
+                                       OSPFNode::Ptr sender,
+                                       OSPFLSUPacket::PtrConst pkt,
+                                       Interface::PtrConst iface) {
+  OSPFAdvertisementSet::Ptr adv_set = OSPFAdvertisementSet::New();
+  Tunnel::PtrConst tunnel = inbound_tunnel(iface);
+
+  /* Processing each LSU advertisement enclosed in the LSU packet. */
+  for (uint32_t adv_index = 0; adv_index < pkt->advCount(); ++adv_index) {
+    OSPFLSUAdvPacket::PtrConst adv_pkt = pkt->advertisement(adv_index);
+    if (!process_lsu_advertisement(area, sender, adv_pkt, tunnel,
+                                   pkt->cost(adv_index),
+                                   pkt->summary(adv_index))) {
+      continue;
+    }
+
+    /* Add advertisement to set of confirmed links. */
+    adv_set->advertisementIs(sender->routerID(), adv_pkt->routerID(),
+                             adv_pkt->subnet(), adv_pkt->subnetMask());
+  }
+
+  remove_unconfirmed_links(area, sender, adv_set);
+}
+
+void
+OSPFRouter::process_lsu_delta(OSPFArea::Ptr area,
+                              OSPFNode::Ptr sender,
+                              OSPFLSUDeltaPacket::PtrConst pkt,
+                              Interface::PtrConst iface) {
+  Tunnel::PtrConst tunnel = inbound_tunnel(iface);
+
+  for (uint32_t index = 0; index < pkt->withdrawnCount(); ++index)
+    process_lsu_withdrawal(area, sender, pkt->withdrawal(index));
+
+  /* Deltas carry no costs or summary flags. Links to new neighbors, passive
+     links that do not cost OSPF::kDefaultLinkCost and changed summaries are
+     only added in complete updates, which do; other links keep their cost
+     and flag. */
+  for (uint32_t index = 0; index < pkt->advCount(); ++index) {
+    OSPFLSUAdvPacket::PtrConst adv_pkt = pkt->advertisement(index);
+    OSPFLink::PtrConst link = sender->activeLink(adv_pkt->routerID());
+    if (adv_pkt->routerID() == OSPF::kPassiveEndpointID)
+      link = sender->passiveLink(adv_pkt->subnet(), adv_pkt->subnetMask());
+
+    uint16_t cost = link ? link->cost() : OSPF::kDefaultLinkCost;
+    bool summary = link ? link->summary() : false;
+    process_lsu_advertisement(area, sender, adv_pkt, tunnel, cost, summary);
+  }
+
+  /* Links that were not withdrawn are implicitly confirmed; they must not
+     time out just because they are no longer listed. */
+  for (OSPFNode::lna_iter it = sender->activeLinksBegin();
+       it != sender->activeLinksEnd(); ++it) {
+    it->second->timeSinceLSUIs(0);
+  }
+
+  for (OSPFNode::lnp_iter it = sender->passiveLinksBegin();
+       it != sender->passiveLinksEnd(); ++it) {
+    it->second->timeSinceLSUIs(0);
+  }
+}
+
+bool
+OSPFRouter::process_lsu_advertisement(OSPFArea::Ptr area,
+                                      OSPFNode::Ptr sender,
+                                      OSPFLSUAdvPacket::PtrConst adv_pkt,
+                                      Tunnel::PtrConst tunnel,
+                                      uint16_t cost,
+                                      bool summary) {
+  if (adv_pkt->routerID() == this->routerID()) {
+    /* SENDER is advertising this router as a direct neighbor. */
+    /* Hello protocol takes precedence. */
+    ILOG << "  ignore        " << adv_pkt->routerID() << " -- this router";
+    return false;
+  }
+
+  if (tunnel &&
+      (tunnel->remote() & adv_pkt->subnetMask()) == adv_pkt->subnet()) {
+    ILOG << "  ignore        " << adv_pkt->subnet()
+         << " -- tunnel endpoint";
+    return false;
+  }
+
+  OSPFAdvertisementMap::Ptr advs_staged = area->advertisementsStaged();
+  OSPFAdvertisement::Ptr adv_obj;
+  if (adv_pkt->routerID() != OSPF::kPassiveEndpointID) {
+    /* Check if the advertised neighbor has also advertised connectivity to
+       SENDER. If it has, then there will exist a NeighborRelationship object
+       in the LINKS_STAGED multimap. */
+    adv_obj = advs_staged->advertisement(adv_pkt->routerID(),
+                                         sender->routerID(),
+                                         adv_pkt->subnet(),
+                                         adv_pkt->subnetMask());
+    if (adv_obj) {
+      /* Staged advertisement exists.
+         Commit neighbor relationship to topology. Links have the same cost
+         in both directions; if the endpoints disagree, the higher cost
+         wins. */
+
+      OSPFNode::Ptr sender = adv_obj->sender();
+      OSPFLink::Ptr link = adv_obj->link();
+      link->costIs(std::max(link->cost(), cost));
+      sender->linkIs(link);
+
+      /* Unstage advertisement. */
+      advs_staged->advertisementDel(adv_obj);
+
+      ILOG << "  adv-commit(a) " << sender->routerID();
+
+    } else {
+
+      /* The advertised neighbor is added to the network topology. The
+         neighbor relationship between NEIGHBOR and SENDER, however, is
+         staged for now. It is committed when NEIGHBOR confirms connectivity
+         to SENDER with an LSU of its own. */
+
+      OSPFTopology::Ptr topology = area->topology();
+      OSPFNode::Ptr neighbor_nd = topology->node(adv_pkt->routerID());
+      if (neighbor_nd == NULL) {
+        neighbor_nd = OSPFNode::New(adv_pkt->routerID());
+        topology->nodeIs(neighbor_nd);
+      }
+
+      OSPFLink::Ptr link = OSPFLink::New(neighbor_nd,
+                                         adv_pkt->subnet(),
+                                         adv_pkt->subnetMask());
+      link->costIs(cost);
+      adv_obj = OSPFAdvertisement::New(sender, link);
+      advs_staged->advertisementIs(adv_obj);
+
+      ILOG << "  adv-stage     " << link->nodeRouterID();
+    }
+
+  } else {
+    /* Advertisement corresponds to an endpoint that is not running OSPF.
+       Bypass two-phase commit logic. */
+
+    OSPFLink::Ptr link = OSPFLink::NewPassive(adv_pkt->subnet(),
+                                              adv_pkt->subnetMask());
+    link->summaryIs(summary);
+    sender->linkIs(link);
+
+    ILOG << "  adv-commit(" << (summary ? "s" : "p") << ") "
+         << adv_pkt->subnet();
+  }
+
+  return true;
+}
+
+void
+OSPFRouter::process_lsu_withdrawal(OSPFArea::Ptr area,
+                                   OSPFNode::Ptr sender,
+                                   OSPFLSUAdvPacket::PtrConst adv_pkt) {
+  RouterID nbr_id = adv_pkt->routerID();
+  IPv4Addr subnet = adv_pkt->subnet();
+  IPv4Addr mask = adv_pkt->subnetMask();
+
+  if (nbr_id == this->routerID()) {
+    /* Hello protocol takes precedence. */
+    ILOG << "  ignore        " << nbr_id << " -- this router";
+    return;
+  }
+
+  if (nbr_id == OSPF::kPassiveEndpointID) {
+    sender->passiveLinkDel(subnet, mask);
+    ILOG << "  adv-withdraw(p) " << subnet;
+    return;
+  }
+
+  /* Only one link to each neighbor is kept; it is removed only if it is the
+     one that was withdrawn. */
+  OSPFLink::Ptr link = sender->activeLink(nbr_id);
+  if (link && link->subnet() == subnet && link->subnetMask() == mask)
+    sender->activeLinkDel(nbr_id);
+
+  area->advertisementsStaged()->advertisementDel(sender->routerID(), nbr_id,
+                                                 subnet, mask);
+
+  ILOG << "  adv-withdraw(a) " << nbr_id;
+}
+
+void
+OSPFRouter::link_costs_update() {
+  for (OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
+       if_it != interfaces_->ifacesEnd(); ++if_it) {
+    OSPFInterface::Ptr iface = if_it->second;
+    uint16_t cost = iface->cost();
+
+    for (OSPFInterface::const_gwa_iter gw_it = iface->activeGatewaysBegin();
+         gw_it != iface->activeGatewaysEnd(); ++gw_it) {
+      OSPFGateway::Ptr gw_obj = gw_it->second;
+      if (gw_obj->cost() == cost)
+        continue;
+
+      ILOG << "Cost of link to " << gw_obj->nodeRouterID() << " on "
+           << iface->interfaceName() << " is now " << cost;
+
+      /* The gateway is the root node's link to the neighbor; linking again
+         replaces the neighbor's link back to the root node, which signals
+         the change to the topology. */
+      gw_obj->costIs(cost);
+      interface_area(iface)->rootNode()->linkIs(gw_obj);
+
+      /* Deltas do not carry costs. */
+      lsu_changed(iface->linkedAreaID(), true);
+    }
+  }
+}
+
+void
+OSPFRouter::dr_elections_update() {
+  for (OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
+       if_it != interfaces_->ifacesEnd(); ++if_it) {
+    OSPFInterface::Ptr iface = if_it->second;
+    if (!iface->designatedRouterElect(routerID()))
+      continue;
+
+    if (iface->designatedRouter() == OSPF::kInvalidRouterID) {
+      ILOG << "No designated router on " << iface->interfaceName()
+           << "; flooding to every neighbor";
+    } else {
+      ILOG << "Designated router on " << iface->interfaceName() << " is "
+           << iface->designatedRouter() << ", backup is "
+           << iface->backupDesignatedRouter();
+    }
+  }
+}
+
+void
+OSPFRouter::summaries_update() {
+  if (!summaries_dirty_)
+    return;
+
+  summaries_dirty_ = false;
+  bool abr = areaBorderRouter();
+
+  /* Prefixes within each area, as seen from this router: those routed
+     within the area and those of the router's own interfaces in it. */
+  std::map<AreaID,std::set<IPv4Subnet> > prefixes;
+  std::map<AreaID,DestRoutesMap>::const_iterator ar_it;
+  for (ar_it = dest_routes_.begin(); ar_it != dest_routes_.end(); ++ar_it) {
+    std::set<IPv4Subnet>& area_prefixes = prefixes[ar_it->first];
+    DestRoutesMap::const_iterator it;
+    for (it = ar_it->second.begin(); it != ar_it->second.end(); ++it)
+      area_prefixes.insert(it->second.subnets.begin(),
+                           it->second.subnets.end());
+  }
+
+  for (OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
+       if_it != interfaces_->ifacesEnd(); ++if_it) {
+    OSPFInterface::PtrConst iface = if_it->second;
+    std::set<IPv4Subnet>& area_prefixes = prefixes[iface->linkedAreaID()];
+    area_prefixes.insert(std::make_pair(iface->interfaceSubnet(),
+                                        iface->interfaceSubnetMask()));
+
+    for (OSPFInterface::const_gwp_iter gw_it = iface->passiveGatewaysBegin();
+         gw_it != iface->passiveGatewaysEnd(); ++gw_it) {
+      OSPFGateway::PtrConst gw_obj = gw_it->second;
+      area_prefixes.insert(std::make_pair(gw_obj->subnet(),
+                                          gw_obj->subnetMask()));
+    }
+  }
+
+  /* Summaries learned in the backbone from other area border routers. */
+  std::set<IPv4Subnet> backbone_summaries;
+  ar_it = dest_routes_.find(OSPF::kBackboneAreaID);
+  if (ar_it != dest_routes_.end()) {
+    DestRoutesMap::const_iterator it;
+    for (it = ar_it->second.begin(); it != ar_it->second.end(); ++it)
+      backbone_summaries.insert(it->second.summaries.begin(),
+                                it->second.summaries.end());
+  }
+
+  for (area_iter it = areas_.begin(); it != areas_.end(); ++it) {
+    OSPFArea::Ptr area = it->second;
+    std::set<IPv4Subnet> candidates;
+    if (abr && area->interfaces() > 0) {
+      /* Prefixes of every other area, summarized by its ranges. */
+      for (const_area_iter other_it = areas_.begin();
+           other_it != areas_.end(); ++other_it) {
+        OSPFArea::PtrConst other = other_it->second;
+        if (other_it->first == it->first || other->interfaces() == 0)
+          continue;
+
+        const std::set<IPv4Subnet>& other_prefixes = prefixes[other_it->first];
+        std::set<IPv4Subnet>::const_iterator pf_it;
+        for (pf_it = other_prefixes.begin(); pf_it != other_prefixes.end();
+             ++pf_it) {
+          candidates.insert(other->summaryPrefix(*pf_it));
+        }
+      }
+
+      /* Summaries are only passed on out of the backbone. */
+      if (!area->backbone())
+        candidates.insert(backbone_summaries.begin(), backbone_summaries.end());
+    }
+
+    /* Prefixes within the area are never advertised into it. */
+    const std::set<IPv4Subnet>& own_prefixes = prefixes[it->first];
+    const std::vector<IPv4Subnet>& ranges = area->ranges();
+    std::vector<IPv4Subnet> summaries;
+    std::set<IPv4Subnet>::const_iterator cd_it;
+    for (cd_it = candidates.begin(); cd_it != candidates.end(); ++cd_it) {
+      if (own_prefixes.count(*cd_it) ||
+          std::binary_search(ranges.begin(), ranges.end(),
+                             area->summaryPrefix(*cd_it))) {
+        continue;
+      }
+
+      summaries.push_back(*cd_it);
+    }
+
+    if (summaries == area->summaries())
+      continue;
+
+    ILOG << "Advertising " << summaries.size() << " summaries into area "
+         << area->areaID();
+
+    /* Incremental updates do not flag summaries. */
+    area->summariesIs(summaries);
+    lsu_changed(area->areaID(), true);
+  }
+}
+
+Tunnel::PtrConst
+OSPFRouter::inbound_tunnel(Interface::PtrConst iface) const {
+  if (iface->type() != Interface::kVirtual)
+    return NULL;
+
+  TunnelMap::Ptr tunnel_map = control_plane_->tunnelMap();
+  Tunnel::PtrConst tunnel = tunnel_map->tunnel(iface->name());
+  if (tunnel == NULL) {
+    ELOG << "process_lsu_advertisements: tunnel map does not contain inbound "
+         << "virtual interface";
+  }
+
+  return tunnel;
+}
+
+OSPFNode::Ptr
+OSPFRouter::lsu_sender(OSPFArea::Ptr area, const RouterID& node_id,
+                       uint16_t seqno) {
+  if (node_id == routerID()) {
+    /* Drop link-state updates that were originally sent by this router.
+     * This will happen if the packet traverses a cycle that leads back to
+     * this router. This can be expected to happen relatively often;
+     * therefore, no logging is performed. */
+    return NULL;
+  }
+
+  OSPFTopology::Ptr topology = area->topology();
+  OSPFNode::Ptr node = topology->node(node_id);
+  if (node) {
+    uint32_t lower_bound = node->latestSeqno() > OSPF::kLinkStateWindow ?
+                           node->latestSeqno() - OSPF::kLinkStateWindow : 0;
+    if (seqno >= lower_bound && seqno <= node->latestSeqno()) {
+      DLOG << "Ignoring old LSU (seqno=" << seqno << ") from " << node_id;
+      return NULL;
+    }
+
+  } else {
+    /* Creating new node and inserting it into the topology database */
+    node = OSPFNode::New(node_id);
+    topology->nodeIs(node);
+  }
+
+  return node;
+}
+
+bool
+OSPFRouter::lsr_new(const RouterID& node_id, uint16_t seqno) {
+  std::map<RouterID,uint16_t>::iterator it = lsr_seqnos_.find(node_id);
+  if (it != lsr_seqnos_.end()) {
+    uint16_t latest = it->second;
+    uint32_t lower_bound = latest > OSPF::kLinkStateWindow ?
+                           latest - OSPF::kLinkStateWindow : 0;
+    if (seqno >= lower_bound && seqno <= latest)
+      return false;
+  }
+
+  lsr_seqnos_[node_id] = seqno;
+  return true;
+}
+
+void
+OSPFRouter::lsr_send(OSPFArea::PtrConst area, const RouterID& target_id) {
+  if (interfaces_->activeGateways() == 0)
+    return;
+
+  size_t ip_pkt_len = IPPacket::kHeaderSize + OSPFLSRPacket::kPacketSize;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(ip_pkt_len);
+
+  OSPFLSRPacket::Ptr ospf_pkt =
+    OSPFLSRPacket::NewDefault(buffer, routerID(), area->areaID(), target_id,
+                              ++lsr_seqno_);
+  ospf_pkt->checksumReset();
+
+  IPPacket::Ptr ip_pkt =
+    IPPacket::NewDefault(buffer, ip_pkt_len, IPPacket::kOSPF,
+                         IPv4Addr::kZero, IPv4Addr::kZero);
+  ip_pkt->ttlIs(1);
+
+  OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
+  for (; if_it != interfaces_->ifacesEnd(); ++if_it) {
+    OSPFInterface::Ptr iface = if_it->second;
+    if (iface->linkedAreaID() == area->areaID())
+      flood_out_interface(iface, ip_pkt);
+  }
+
+  ++lsr_sent_;
+}
+
+void
+OSPFRouter::remove_unconfirmed_links(OSPFArea::Ptr area, OSPFNode::Ptr sender,
+                                     OSPFAdvertisementSet::Ptr confirmed_advs) {
+  if (sender == area->rootNode() || sender->routerID() == this->routerID()) {
+    ELOG << "remove_unconfirmed_links: Attempt to remove unconfirmed links "
+         << "from the root node itself.";
+    return;
   }
 
   Fwk::Deque<OSPFLink::Ptr> del_links;
@@ -578,91 +1631,316 @@ OSPFRouter::remove_unconfirmed_links(OSPFNode::Ptr sender,
     sender->activeLinkDel(link->nodeRouterID());
 
     /* Unstaging advertisement if staged. */
-    advs_staged_.advertisementDel(sender->routerID(),
-                                  link->nodeRouterID(),
-                                  link->subnet(),
-                                  link->subnetMask());
+    area->advertisementsStaged()->advertisementDel(sender->routerID(),
+                                                   link->nodeRouterID(),
+                                                   link->subnet(),
+                                                   link->subnetMask());
   }
 }
 
 void
-OSPFRouter::flood_lsu() {
-  size_t active_gateways = interfaces_->activeGateways();
-
-  if (active_gateways > 0)
-    ILOG << "Sending LSU (seqno=" << lsu_seqno_ << ")";
-
+OSPFRouter::flood_lsu(OSPFArea::Ptr area) {
+  std::vector<OSPFInterface::Ptr> ifaces;
+  size_t active_gateways = 0;
   OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
   for (; if_it != interfaces_->ifacesEnd(); ++if_it) {
     OSPFInterface::Ptr iface = if_it->second;
-    flood_lsu_out_interface(iface);
+    if (iface->linkedAreaID() != area->areaID())
+      continue;
+
+    ifaces.push_back(iface);
+    active_gateways += iface->activeGateways();
   }
 
+  /* Every neighbor in the area receives the same update; it is built only
+     once. */
+  IPPacket::PtrConst lsu = NULL;
   if (active_gateways > 0)
-    ++lsu_seqno_;
+    lsu = lsu_next(area);
 
-  if (notifiee_)
-    notifiee_->onLinkStateFlood(this);
+  for (size_t i = 0; i < ifaces.size(); ++i)
+    flood_out_interface(ifaces[i], lsu);
+
+  if (active_gateways > 0)
+    ++lsu_states_[area->areaID()].seqno;
 }
 
 void
-OSPFRouter::flood_lsu_out_interface(Fwk::Ptr<OSPFInterface> iface) {
-  OSPFInterface::const_gwa_iter it;
-  for (it = iface->activeGatewaysBegin();
-       it != iface->activeGatewaysEnd(); ++it) {
-    OSPFGateway::Ptr gw_obj = it->second;
-    OSPFLSUPacket::Ptr ospf_pkt = build_lsu_to_gateway(iface, gw_obj);
-    outputPacketNew(ospf_pkt);
+OSPFRouter::flood_out_interface(Fwk::Ptr<OSPFInterface> iface,
+                                IPPacket::PtrConst pkt) {
+  OSPFInterface::FloodMode mode = iface->floodMode(routerID(), false);
+  if (mode == OSPFInterface::kFloodSegment) {
+    if (iface->activeGateways() > 0) {
+      OSPFPacket::Ptr ospf_pkt =
+        packet_copy(pkt, iface, OSPFHelloPacket::kBroadcastAddr);
+      output_segment_packet(ospf_pkt, iface);
+    }
+    return;
+  }
+
+  std::vector<OSPFGateway::Ptr> gateways;
+  flood_gateways(iface, mode, gateways);
+  for (size_t i = 0; i < gateways.size(); ++i) {
+    OSPFPacket::Ptr ospf_pkt = packet_to_gateway(pkt, iface, gateways[i]);
+    if (ospf_pkt)
+      outputPacketNew(ospf_pkt);
   }
 }
 
-OSPFLSUPacket::Ptr
-OSPFRouter::build_lsu_to_gateway(OSPFInterface::Ptr iface,
-                                 OSPFGateway::Ptr gw_obj) const {
-  if (gw_obj->nodeIsPassiveEndpoint()) {
-    ELOG << "send_new_lsu_to_neighbor: Attempt to build link-state update to "
-            "a passive endpoint.";
-    return NULL;
+bool
+OSPFRouter::LSUAdvertisement::operator<(const LSUAdvertisement& other) const {
+  if (router_id != other.router_id)
+    return router_id < other.router_id;
+
+  if (subnet != other.subnet)
+    return subnet < other.subnet;
+
+  return mask < other.mask;
+}
+
+void
+OSPFRouter::lsu_changed(const AreaID& area_id, bool full) {
+  LSUState& state = lsu_states_[area_id];
+  state.dirty = true;
+  if (full)
+    state.full_pending = true;
+}
+
+IPPacket::PtrConst
+OSPFRouter::lsu_next(OSPFArea::PtrConst area) {
+  LSUState& state = lsu_states_[area->areaID()];
+  if (!lsu_deltas_enabled_) {
+    ILOG << "Sending LSU (seqno=" << state.seqno << ") in area "
+         << area->areaID();
+    ++lsu_full_floods_;
+    return lsu_new(area);
   }
 
-  if (gw_obj->nodeRouterID() == OSPF::kInvalidRouterID) {
-    ELOG << "send_new_lsu_to_neighbor: Attempt to build a link-state update to "
-         << "a node with an invalid router ID.";
-    return NULL;
+  std::vector<LSUAdvertisement> advs;
+  lsu_advertisements(area, advs);
+
+  IPPacket::PtrConst lsu;
+  if (state.full_pending) {
+    ILOG << "Sending LSU (seqno=" << state.seqno << ") in area "
+         << area->areaID();
+
+    lsu = lsu_new(area);
+    state.full_pending = false;
+    state.intervals = 0;
+    ++lsu_full_floods_;
+
+  } else {
+    /* Both lists are sorted; only the differences are sent. */
+    std::vector<LSUAdvertisement> added;
+    std::set_difference(advs.begin(), advs.end(),
+                        state.advs.begin(), state.advs.end(),
+                        std::back_inserter(added));
+
+    std::vector<LSUAdvertisement> withdrawn;
+    std::set_difference(state.advs.begin(), state.advs.end(),
+                        advs.begin(), advs.end(),
+                        std::back_inserter(withdrawn));
+
+    ILOG << "Sending LSU delta (seqno=" << state.seqno << ", added "
+         << added.size() << ", withdrawn " << withdrawn.size()
+         << ") in area " << area->areaID();
+
+    lsu = lsu_delta_new(area, added, withdrawn);
+    ++lsu_delta_floods_;
   }
 
-  size_t adv_count = interfaces_->gateways();
+  /* The next delta is computed against what was sent now. */
+  state.advs.swap(advs);
+
+  return lsu;
+}
+
+IPPacket::PtrConst
+OSPFRouter::lsu_new(OSPFArea::PtrConst area) {
+  const uint32_t seqno = lsu_states_[area->areaID()].seqno;
+
+  size_t adv_count = 0;
+  std::vector<OSPFInterface::Ptr> ifaces;
+  for (OSPFInterfaceMap::const_if_iter it = interfaces_->ifacesBegin();
+       it != interfaces_->ifacesEnd(); ++it) {
+    OSPFInterface::Ptr iface = it->second;
+    if (iface->linkedAreaID() != area->areaID())
+      continue;
+
+    ifaces.push_back(iface);
+    adv_count += iface->gateways();
+  }
+
+  /* Summaries are listed last; see OSPFLSUPacket::summary(). */
+  const std::vector<IPv4Subnet>& summaries = area->summaries();
+  adv_count += summaries.size();
 
   size_t ospf_pkt_len = OSPFLSUPacket::kHeaderSize +
-                        adv_count * OSPFLSUAdvPacket::kSize;
+                        adv_count * OSPFLSUAdvPacket::kSize +
+                        OSPFLSUPacket::costsSize(adv_count) +
+                        OSPFLSUPacket::summariesSize(summaries.size());
   size_t ip_pkt_len = IPPacket::kHeaderSize + ospf_pkt_len;
-  size_t eth_pkt_len = EthernetPacket::kHeaderSize + ip_pkt_len;
 
-  PacketBuffer::Ptr buffer = PacketBuffer::New(eth_pkt_len);
+  PacketBuffer::Ptr buffer = PacketBuffer::New(ip_pkt_len);
 
   /* OSPFPacket. */
   OSPFLSUPacket::Ptr ospf_pkt =
-    OSPFLSUPacket::NewDefault(buffer, routerID(), areaID(),
-                              adv_count, lsu_seqno_);
+    OSPFLSUPacket::NewDefault(buffer, routerID(), area->areaID(),
+                              adv_count, seqno, true,
+                              summaries.size());
 
   /* Setting packet's LSU advertisements. */
   uint32_t ix = 0;
-  for (OSPFInterfaceMap::const_if_iter it = interfaces_->ifacesBegin();
-       it != interfaces_->ifacesEnd(); ++it) {
-    OSPFInterface::Ptr iface = it->second;
-    set_lsu_adv_from_interface(ospf_pkt, iface, ix);
+  for (size_t i = 0; i < ifaces.size(); ++i)
+    set_lsu_adv_from_interface(ospf_pkt, ifaces[i], ix);
+
+  for (size_t i = 0; i < summaries.size(); ++i, ++ix) {
+    OSPFLSUAdvPacket::Ptr adv = ospf_pkt->advertisement(ix);
+    adv->routerIDIs(OSPF::kPassiveEndpointID);
+    adv->subnetIs(summaries[i].first);
+    adv->subnetMaskIs(summaries[i].second);
+    ospf_pkt->costIs(ix, OSPF::kDefaultLinkCost);
   }
 
+  /* The OSPF checksum does not cover the IP header, so it stays valid in
+     every copy. */
   ospf_pkt->checksumReset();
 
-  /* IPPacket. */
+  /* IPPacket; addresses and IP checksum are set per neighbor. */
   IPPacket::Ptr ip_pkt =
     IPPacket::NewDefault(buffer, ip_pkt_len, IPPacket::kOSPF,
-                         iface->interfaceIP(), gw_obj->gateway());
+                         IPv4Addr::kZero, IPv4Addr::kZero);
   ip_pkt->ttlIs(1);
+
+  return ip_pkt;
+}
+
+IPPacket::PtrConst
+OSPFRouter::lsu_delta_new(OSPFArea::PtrConst area,
+                          const std::vector<LSUAdvertisement>& added,
+                          const std::vector<LSUAdvertisement>& withdrawn) {
+  uint32_t seqno = lsu_states_[area->areaID()].seqno;
+  size_t ospf_pkt_len = OSPFLSUDeltaPacket::kHeaderSize +
+                        (added.size() + withdrawn.size()) *
+                        OSPFLSUAdvPacket::kSize;
+  size_t ip_pkt_len = IPPacket::kHeaderSize + ospf_pkt_len;
+
+  PacketBuffer::Ptr buffer = PacketBuffer::New(ip_pkt_len);
+
+  /* OSPFPacket; based on the previous update. */
+  OSPFLSUDeltaPacket::Ptr ospf_pkt =
+    OSPFLSUDeltaPacket::NewDefault(buffer, routerID(), area->areaID(),
+                                   added.size(), withdrawn.size(),
+                                   seqno, seqno - 1);
+
+  for (uint32_t ix = 0; ix < added.size(); ++ix) {
+    OSPFLSUAdvPacket::Ptr adv = ospf_pkt->advertisement(ix);
+    adv->routerIDIs(added[ix].router_id);
+    adv->subnetIs(added[ix].subnet);
+    adv->subnetMaskIs(added[ix].mask);
+  }
+
+  for (uint32_t ix = 0; ix < withdrawn.size(); ++ix) {
+    OSPFLSUAdvPacket::Ptr adv = ospf_pkt->withdrawal(ix);
+    adv->routerIDIs(withdrawn[ix].router_id);
+    adv->subnetIs(withdrawn[ix].subnet);
+    adv->subnetMaskIs(withdrawn[ix].mask);
+  }
+
+  ospf_pkt->checksumReset();
+
+  /* IPPacket; addresses and IP checksum are set per neighbor. */
+  IPPacket::Ptr ip_pkt =
+    IPPacket::NewDefault(buffer, ip_pkt_len, IPPacket::kOSPF,
+                         IPv4Addr::kZero, IPv4Addr::kZero);
+  ip_pkt->ttlIs(1);
+
+  return ip_pkt;
+}
+
+void
+OSPFRouter::lsu_advertisements(OSPFArea::PtrConst area,
+                               std::vector<LSUAdvertisement>& advs) const {
+  advs.clear();
+
+  for (OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
+       if_it != interfaces_->ifacesEnd(); ++if_it) {
+    OSPFInterface::PtrConst iface = if_it->second;
+    if (iface->linkedAreaID() != area->areaID())
+      continue;
+
+    LSUAdvertisement adv;
+    for (OSPFInterface::const_gwp_iter gw_it = iface->passiveGatewaysBegin();
+         gw_it != iface->passiveGatewaysEnd(); ++gw_it) {
+      OSPFGateway::PtrConst gw = gw_it->second;
+      adv.router_id = gw->nodeRouterID();
+      adv.subnet = gw->subnet();
+      adv.mask = gw->subnetMask();
+      advs.push_back(adv);
+    }
+
+    for (OSPFInterface::const_gwa_iter gw_it = iface->activeGatewaysBegin();
+         gw_it != iface->activeGatewaysEnd(); ++gw_it) {
+      OSPFGateway::PtrConst gw = gw_it->second;
+      adv.router_id = gw->nodeRouterID();
+      adv.subnet = gw->subnet();
+      adv.mask = gw->subnetMask();
+      advs.push_back(adv);
+    }
+  }
+
+  const std::vector<IPv4Subnet>& summaries = area->summaries();
+  for (size_t i = 0; i < summaries.size(); ++i) {
+    LSUAdvertisement adv;
+    adv.router_id = OSPF::kPassiveEndpointID;
+    adv.subnet = summaries[i].first;
+    adv.mask = summaries[i].second;
+    advs.push_back(adv);
+  }
+
+  std::sort(advs.begin(), advs.end());
+}
+
+OSPFPacket::Ptr
+OSPFRouter::packet_to_gateway(IPPacket::PtrConst pkt,
+                              OSPFInterface::Ptr iface,
+                              OSPFGateway::Ptr gw_obj) const {
+  if (gw_obj->nodeIsPassiveEndpoint()) {
+    ELOG << "packet_to_gateway: Attempt to build OSPF packet to "
+            "a passive endpoint.";
+    return NULL;
+  }
+
+  if (gw_obj->nodeRouterID() == OSPF::kInvalidRouterID) {
+    ELOG << "packet_to_gateway: Attempt to build an OSPF packet to "
+         << "a node with an invalid router ID.";
+    return NULL;
+  }
+
+  return packet_copy(pkt, iface, gw_obj->gateway());
+}
+
+OSPFPacket::Ptr
+OSPFRouter::packet_copy(IPPacket::PtrConst pkt,
+                        OSPFInterface::Ptr iface,
+                        const IPv4Addr& dst) const {
+  /* Room is left for the Ethernet header, so that it can be prepended
+     without growing the buffer. */
+  size_t ip_pkt_len = pkt->len();
+  size_t eth_pkt_len = EthernetPacket::kHeaderSize + ip_pkt_len;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(eth_pkt_len);
+  size_t ip_offset = buffer->size() - ip_pkt_len;
+  memcpy(buffer->data() + ip_offset, pkt->data(), ip_pkt_len);
+
+  /* IPPacket. */
+  IPPacket::Ptr ip_pkt = IPPacket::New(buffer, ip_offset);
+  ip_pkt->srcIs(iface->interfaceIP());
+  ip_pkt->dstIs(dst);
   ip_pkt->checksumReset();
 
-  /* Setting enclosing packet. */
+  /* OSPFPacket. */
+  OSPFPacket::Ptr ospf_pkt =
+    OSPFPacket::New(buffer, ip_offset + IPPacket::kHeaderSize);
   ospf_pkt->enclosingPacketIs(ip_pkt);
 
   return ospf_pkt;
@@ -679,6 +1957,7 @@ OSPFRouter::set_lsu_adv_from_interface(OSPFLSUPacket::Ptr pkt,
     adv->routerIDIs(gw->nodeRouterID());
     adv->subnetIs(gw->subnet());
     adv->subnetMaskIs(gw->subnetMask());
+    pkt->costIs(starting_ix, gw->cost());
   }
 
   for (OSPFInterface::const_gwa_iter gw_it = iface->activeGatewaysBegin();
@@ -688,19 +1967,40 @@ OSPFRouter::set_lsu_adv_from_interface(OSPFLSUPacket::Ptr pkt,
     adv->routerIDIs(gw->nodeRouterID());
     adv->subnetIs(gw->subnet());
     adv->subnetMaskIs(gw->subnetMask());
+    pkt->costIs(starting_ix, gw->cost());
   }
 }
 
 void
-OSPFRouter::forward_lsu_flood(OSPFLSUPacket::Ptr pkt) const {
+OSPFRouter::forward_lsu_flood(OSPFArea::PtrConst area, OSPFPacket::Ptr pkt,
+                              Interface::PtrConst in_iface) {
   RouterID sender_id = pkt->routerID();
+  IPPacket::Ptr ip_pkt = Ptr::st_cast<IPPacket>(pkt->enclosingPacket());
 
   OSPFInterfaceMap::const_if_iter if_it = interfaces_->ifacesBegin();
   for (; if_it != interfaces_->ifacesEnd(); ++if_it) {
-    OSPFInterface::PtrConst iface = if_it->second;
-    OSPFInterface::const_gwa_iter gw_it = iface->activeGatewaysBegin();
-    for (; gw_it != iface->activeGatewaysEnd(); ++gw_it) {
-      OSPFGateway::Ptr gw_obj = gw_it->second;
+    OSPFInterface::Ptr iface = if_it->second;
+    if (iface->linkedAreaID() != area->areaID())
+      continue;
+
+    bool received_here = (iface->interface() == in_iface);
+    OSPFInterface::FloodMode mode = iface->floodMode(routerID(), received_here);
+
+    if (mode == OSPFInterface::kFloodSegment) {
+      /* The original sender ignores its own packet. */
+      if (iface->activeGateways() > 0) {
+        ip_pkt->dstIs(OSPFHelloPacket::kBroadcastAddr);
+        ip_pkt->ttlIs(1);
+        ip_pkt->checksumReset();
+        output_segment_packet(pkt, iface);
+      }
+      continue;
+    }
+
+    std::vector<OSPFGateway::Ptr> gateways;
+    flood_gateways(iface, mode, gateways);
+    for (size_t i = 0; i < gateways.size(); ++i) {
+      OSPFGateway::Ptr gw_obj = gateways[i];
       if (gw_obj->nodeRouterID() == sender_id) {
         /* Do not forward link-state update flood to its original sender. */
         continue;
@@ -711,9 +2011,30 @@ OSPFRouter::forward_lsu_flood(OSPFLSUPacket::Ptr pkt) const {
   }
 }
 
+void
+OSPFRouter::flood_gateways(OSPFInterface::Ptr iface,
+                           OSPFInterface::FloodMode mode,
+                           std::vector<OSPFGateway::Ptr>& gateways) {
+  if (mode == OSPFInterface::kFloodNeighbors) {
+    OSPFInterface::const_gwa_iter gw_it = iface->activeGatewaysBegin();
+    for (; gw_it != iface->activeGatewaysEnd(); ++gw_it)
+      gateways.push_back(gw_it->second);
+
+  } else if (mode == OSPFInterface::kFloodDesignated) {
+    OSPFGateway::Ptr dr = iface->activeGateway(iface->designatedRouter());
+    if (dr)
+      gateways.push_back(dr);
+
+    OSPFGateway::Ptr bdr =
+      iface->activeGateway(iface->backupDesignatedRouter());
+    if (bdr)
+      gateways.push_back(bdr);
+  }
+}
+
 void
 OSPFRouter::forward_packet_to_gateway(OSPFPacket::Ptr pkt,
-                                      OSPFGateway::Ptr gw_obj) const {
+                                      OSPFGateway::Ptr gw_obj) {
   if (gw_obj->nodeIsPassiveEndpoint()) {
     ELOG << "forward_packet_to_gateway: Attempt to forward OSPF packet to "
          << "passive endpoint.";
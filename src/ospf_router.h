@@ -1,10 +1,14 @@
 #ifndef OSPF_ROUTER_H_LFORNADU
 #define OSPF_ROUTER_H_LFORNADU
 
+#include <map>
+#include <set>
+#include <vector>
+
 #include "fwk/map.h"
 #include "fwk/ptr_interface.h"
 
-#include "ospf_adv_map.h"
+#include "ospf_area.h"
 #include "ospf_interface_map.h"
 #include "ospf_topology.h"
 #include "ospf_types.h"
@@ -17,10 +21,14 @@ class Interface;
 class InterfaceMap;
 class OSPFAdvertisementSet;
 class OSPFInterface;
+class OSPFLSUAdvPacket;
+class OSPFLSUDeltaPacket;
 class OSPFLSUPacket;
+class OSPFLSRPacket;
 class OSPFLink;
 class OSPFPacket;
 class OSPFNode;
+class Tunnel;
 
 
 class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
@@ -28,6 +36,10 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
   typedef Fwk::Ptr<const OSPFRouter> PtrConst;
   typedef Fwk::Ptr<OSPFRouter> Ptr;
 
+  /* Area iterators. */
+  typedef Fwk::Map<AreaID,OSPFArea>::iterator area_iter;
+  typedef Fwk::Map<AreaID,OSPFArea>::const_iterator const_area_iter;
+
   static Ptr New(const RouterID& router_id,
                  const AreaID& area_id,
                  Fwk::Ptr<RoutingTable> rtable,
@@ -44,6 +56,23 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
     /* Notifications supported. */
     virtual void onLinkStateFlood(OSPFRouter::Ptr _r) = 0;
 
+    /* An interface was added to or removed from the router's interface
+       map. */
+    virtual void onInterface(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface) {}
+    virtual void onInterfaceDel(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface) {}
+
+    /* An active gateway to a neighboring OSPF router was added to or removed
+       from IFACE. Passive gateways are not signalled. */
+    virtual void onNeighbor(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface,
+                            OSPFGateway::Ptr gw) {}
+    virtual void onNeighborDel(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface,
+                               OSPFGateway::Ptr gw) {}
+
+    /* A fast HELLO packet was received from the neighbor reached through
+       GW. GW's fastHelloDetectTime() has been updated. */
+    virtual void onFastHello(OSPFRouter::Ptr _r, OSPFInterface::Ptr iface,
+                             OSPFGateway::Ptr gw) {}
+
    protected:
     Notifiee() {}
     virtual ~Notifiee() {}
@@ -58,15 +87,32 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
 
   /* Accessors. */
 
-  const RouterID& routerID() const { return router_node_->routerID(); }
+  const RouterID& routerID() const { return router_id_; }
+
+  /* Area of interfaces that are not configured otherwise; see
+     OSPFInterface::areaID(). */
   const AreaID& areaID() const { return area_id_; }
 
   Fwk::Ptr<const OSPFInterfaceMap> interfaceMap() const;
   Fwk::Ptr<OSPFInterfaceMap> interfaceMap();
 
+  /* Topology of areaID(). */
   Fwk::Ptr<const OSPFTopology> topology() const;
   Fwk::Ptr<OSPFTopology> topology();
 
+  /* Areas that the router's interfaces are or have been linked into;
+     areaID() is always one of them. NULL if there is no such area. */
+  OSPFArea::PtrConst area(const AreaID& area_id) const;
+  OSPFArea::Ptr area(const AreaID& area_id);
+  size_t areas() const { return areas_.size(); }
+
+  /* True if the router has interfaces in more than one area. Area border
+     routers advertise the prefixes of each of their areas into the others,
+     through the backbone: prefixes of non-backbone areas are advertised
+     into the backbone, and those of the backbone, including summaries
+     learned there, into non-backbone areas. */
+  bool areaBorderRouter() const;
+
   Fwk::Ptr<const RoutingTable> routingTable() const;
   Fwk::Ptr<RoutingTable> routingTable();
 
@@ -75,18 +121,76 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
 
   bool enabled() const { return enabled_; }
 
+  /* True if link-state updates are sent incrementally: only advertisements
+     that changed since the previous update are listed, and a complete
+     update is sent every OSPF::kDefaultLinkStateRefreshIntervals intervals,
+     whenever a new neighbor appears, and whenever another router requests
+     one. Disabled by default, since routers that only implement PWOSPF
+     ignore incremental updates. */
+  bool lsuDeltasEnabled() const { return lsu_deltas_enabled_; }
+
+  /* Timers of the shortest-path computations of every area; see
+     OSPFSPFThrottle. Areas added later start with them too. */
+  const Milliseconds& spfInitialDelay() const { return spf_initial_delay_; }
+  const Milliseconds& spfHoldTime() const { return spf_hold_time_; }
+  const Milliseconds& spfMaxWait() const { return spf_max_wait_; }
+
+  /* Statistics. */
+
+  /* Number of complete and of incremental link-state updates sent. */
+  uint64_t lsuFullFloods() const { return lsu_full_floods_; }
+  uint64_t lsuDeltaFloods() const { return lsu_delta_floods_; }
+
+  /* Number of requests for a complete update sent to other routers after
+     a gap was detected in their incremental updates. */
+  uint64_t lsrSent() const { return lsr_sent_; }
+
+  /* Number of flooded packets sent, originated or forwarded: link-state
+     updates and requests. A copy sent to a whole segment counts once. */
+  uint64_t floodPacketsSent() const { return flood_packets_sent_; }
+
+  /* Sequence number of the last link-state update flooded into AREA_ID. */
+  uint32_t lsuSeqno(const AreaID& area_id) const;
+
   /* Mutators. */
 
-  void routerIDIs(const RouterID& id) { router_node_->routerIDIs(id); }
+  void routerIDIs(const RouterID& id);
   void notifieeIs(Notifiee::Ptr _n) { notifiee_ = _n; }
   void enabledIs(bool status);
+  void lsuDeltasEnabledIs(bool status);
+  void spfThrottleIs(const Milliseconds& initial_delay,
+                     const Milliseconds& hold_time,
+                     const Milliseconds& max_wait);
+
+  /* Resumes the link-state updates of AREA_ID at SEQNO after a restart.
+     Neighbors ignore updates whose sequence number is not newer than the
+     latest they have seen from the router, so starting over from zero
+     would delay the router's updates until its numbers caught up. Has no
+     effect if the router has no such area. */
+  void lsuSeqnoIs(const AreaID& area_id, uint32_t seqno);
+
+  /* Adds or removes an address range of area AREA_ID; see
+     OSPFArea::ranges(). The area is created if necessary. Routes are
+     updated right away and summaries on the next link-state update
+     signal, so these must be called from the thread that processes
+     packets. */
+  void areaRangeIs(const AreaID& area_id, const IPv4Subnet& range);
+  void areaRangeDel(const AreaID& area_id, const IPv4Subnet& range);
+
+  /* Iterators. */
+
+  area_iter areasBegin() { return areas_.begin(); }
+  area_iter areasEnd() { return areas_.end(); }
+  const_area_iter areasBegin() const { return areas_.begin(); }
+  const_area_iter areasEnd() const { return areas_.end(); }
 
   /* Signals. */
 
   /* Signal to indicate that the LSU interval has elapsed. */
-  void onLinkStateInterval() { flood_lsu(); }
+  void onLinkStateInterval();
 
-  /* Signal: connectivity to direct neighbors may have changed*/
+  /* Signal: connectivity to direct neighbors may have changed. Updates are
+     only flooded into the areas whose link state changed. */
   void onLinkStateUpdate();
 
  protected:
@@ -105,31 +209,39 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
     void operator()(OSPFPacket*, Fwk::Ptr<const Interface>);
     void operator()(OSPFHelloPacket*, Fwk::Ptr<const Interface>);
     void operator()(OSPFLSUPacket*, Fwk::Ptr<const Interface>);
+    void operator()(OSPFLSUDeltaPacket*, Fwk::Ptr<const Interface>);
+    void operator()(OSPFLSRPacket*, Fwk::Ptr<const Interface>);
+    void operator()(OSPFFastHelloPacket*, Fwk::Ptr<const Interface>);
+    void operator()(OSPFElectionPacket*, Fwk::Ptr<const Interface>);
 
    private:
+    /* Area of the interface that received a packet, or NULL if the packet
+       belongs to another area. */
+    OSPFArea::Ptr packet_area(OSPFPacket* pkt, Fwk::Ptr<const Interface>);
+
     OSPFRouter* ospf_router_;
-    OSPFNode* router_node_;
     OSPFInterfaceMap* interfaces_;
-    OSPFTopology* topology_;
   };
 
-  /* Reactor to Topology notifications. */
+  /* Reactor to the Topology notifications of an area. */
   class TopologyReactor : public OSPFTopology::Notifiee {
    public:
     typedef Fwk::Ptr<const TopologyReactor> PtrConst;
     typedef Fwk::Ptr<TopologyReactor> Ptr;
 
-    static Ptr New(OSPFRouter* _r) {
-      return new TopologyReactor(_r);
+    static Ptr New(OSPFRouter* _r, OSPFArea* _a) {
+      return new TopologyReactor(_r, _a);
     }
 
-    void onDirtyCleared() { router_->rtable_update(); }
+    void onDirtyCleared();
+    void onBackupHops();
 
    private:
-    TopologyReactor(OSPFRouter* _r) : router_(_r) {}
+    TopologyReactor(OSPFRouter* _r, OSPFArea* _a) : router_(_r), area_(_a) {}
 
     /* Data members. */
     OSPFRouter* router_;
+    OSPFArea* area_; /* Weak ptr; the area owns the topology. */
 
     /* Operations disallowed. */
     TopologyReactor(const TopologyReactor&);
@@ -190,64 +302,282 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
 
   /* -- OSPFRouter private member functions. -- */
 
-  void outputPacketNew(Fwk::Ptr<OSPFPacket> ospf_pkt) const;
+  void outputPacketNew(Fwk::Ptr<OSPFPacket> ospf_pkt);
+
+  /* Sends OSPF_PKT to all routers on the segment of IFACE. */
+  void output_segment_packet(Fwk::Ptr<OSPFPacket> ospf_pkt,
+                             Fwk::Ptr<OSPFInterface> iface);
+
+  /* Returns the area with AREA_ID, creating it if necessary. */
+  OSPFArea::Ptr area_new(const AreaID& area_id);
+
+  /* Applies the router's shortest-path computation timers to AREA. */
+  void spf_throttle_update(OSPFArea::Ptr area);
 
-  /* Uses the optimal spanning tree computed by OSPFTopology to update all
-     entries in the routing table. */
+  /* Returns the area that the gateways of IFACE are linked into. */
+  OSPFArea::Ptr interface_area(Fwk::Ptr<const OSPFInterface> iface);
+
+  /* Moves the interfaces whose area has been configured since they were
+     linked into their new area. */
+  void interface_areas_update();
+
+  /* Moves IFACE into its configured area. Its neighbors are dropped, since
+     they belong to the previous area; adjacencies form again in the new
+     area with the next HELLOs. */
+  void interface_area_move(Fwk::Ptr<OSPFInterface> iface);
+
+  /* Uses the optimal spanning trees computed by the topologies of all areas
+     to update all entries in the routing table. */
   void rtable_update();
 
-  /* Adds the subnets connected to DEST to the routing table via NEXT_HOP.
-     Assumes that routing_table_ is already locked. */
-  void rtable_add_dest(OSPFNode::PtrConst next_hop, OSPFNode::PtrConst dest);
+  /* Updates only the routes to the subnets connected to the nodes in DESTS,
+     as seen in AREA. Nodes in DESTS that are no longer in the area's
+     topology have their routes withdrawn. Each destination is visited once,
+     and only the routes whose next hops or subnet changed are touched in the
+     routing table. */
+  void rtable_update(OSPFArea::Ptr area, const std::vector<RouterID>& dests);
+
+  /* Routes contributed by a single destination node: the subnets connected
+     to it and the inter-area summaries it advertises, all of which are
+     reached through the same group of equal-cost next hops, and the
+     loop-free alternate to that group, if any. */
+  struct DestRoutes {
+    std::vector<RoutingTable::Entry::NextHop> next_hops;
+    RoutingTable::Entry::NextHop backup;
+    std::vector<IPv4Subnet> subnets;   /* Sorted, without duplicates. */
+    std::vector<IPv4Subnet> summaries; /* Likewise. */
+  };
 
-  /* Adds an entry for the given gateway to the routing table.
+  /* Node that contributed a route, in order of preference: routes within an
+     area are preferred to inter-area summaries, and summaries learned in the
+     backbone to other summaries. Ties go to the highest RouterID. */
+  struct RouteSource {
+    enum Type { kSummary, kBackboneSummary, kIntraArea };
+
+    Type type;
+    RouterID router_id;
+    AreaID area_id;
+
+    RouteSource(OSPFArea::PtrConst area, const RouterID& dest_id,
+                bool summary);
+    bool operator<(const RouteSource& other) const;
+  };
+
+  /* Computes the routes currently contributed by DEST_ID in AREA into
+     ROUTES. Returns false if DEST_ID is unreachable. */
+  bool rtable_dest_routes(OSPFArea::PtrConst area, const RouterID& dest_id,
+                          DestRoutes& routes) const;
+
+  /* True if SUBNET is within an address range of one of this router's
+     areas. Summaries within such ranges are not routed: this router
+     originates them, and routes to the prefixes they summarize are
+     already known within the area. */
+  bool range_summarized(const IPv4Subnet& subnet) const;
+
+  /* Records routes to SUBNETS through the next hops in ROUTES, contributed
+     by SOURCE, and adds SUBNETS to AFFECTED. */
+  void rtable_add_routes(const RouteSource& source, const DestRoutes& routes,
+                         const std::vector<IPv4Subnet>& subnets,
+                         std::set<IPv4Subnet>& affected);
+
+  /* Forgets the routes to SUBNETS contributed by SOURCE and adds SUBNETS
+     to AFFECTED. */
+  void rtable_del_routes(const RouteSource& source,
+                         const std::vector<IPv4Subnet>& subnets,
+                         std::set<IPv4Subnet>& affected);
+
+  /* Replaces the routes to PREV_SUBNETS contributed by SOURCE with routes
+     to SUBNETS through the next hops in ROUTES. Unless HOPS_CHANGED, only
+     the subnets that came or went are touched. */
+  void rtable_replace_routes(const RouteSource& source,
+                             const std::vector<IPv4Subnet>& prev_subnets,
+                             const DestRoutes& routes,
+                             const std::vector<IPv4Subnet>& subnets,
+                             bool hops_changed,
+                             std::set<IPv4Subnet>& affected);
+
+  /* Installs the preferred recorded route to SUBNET into the routing table,
+     or removes the dynamic route to SUBNET if none is left.
      Assumes that routing_table_ is already locked. */
-  void rtable_add_gateway(const IPv4Addr& subnet,
-                          const IPv4Addr& mask,
-                          const IPv4Addr& gateway,
-                          OSPFInterface::PtrConst iface);
+  void rtable_install(const IPv4Subnet& subnet);
+
+  /* Local repair after the loss of the neighbor reached through FAILED:
+     routes through FAILED immediately move to the remaining members of
+     their next-hop group or, failing that, to their backup next hop. Routes
+     without either are left for the next spanning tree computation. */
+  void rtable_repair(const RoutingTable::Entry::NextHop& failed);
 
   /* Processes the LSU advertisements enclosed in PKT, an OSPFLSUPacket
-     received from SENDER. This function establishes a bi-directional link in
-     the router's network topology to each advertised neighbor, N_i, only if N_i
-     has also advertised connectivity to SENDER. In the case that N_i has not
-     previously advertised connectivity to SENDER, this function stages a
-     NeighborRelationship object to the LINKS_STAGED multimap to be committed
-     whenever said advertisement is received.
-
-     This function assumes that SENDER is already in the router's network
-     topology.
+     received from SENDER in AREA. This function establishes a bi-directional
+     link in the area's topology to each advertised neighbor, N_i, only if
+     N_i has also advertised connectivity to SENDER. In the case that N_i has
+     not previously advertised connectivity to SENDER, this function stages
+     an advertisement in the area's staged advertisements, to be committed
+     whenever said confirmation is received.
+
+     This function assumes that SENDER is already in the area's topology.
   */
-  void process_lsu_advertisements(Fwk::Ptr<OSPFNode> sender,
+  void process_lsu_advertisements(OSPFArea::Ptr area,
+                                  Fwk::Ptr<OSPFNode> sender,
                                   Fwk::Ptr<const OSPFLSUPacket> pkt,
                                   Interface::PtrConst iface);
 
+  /* Processes the advertisements added and withdrawn in PKT, an incremental
+     link-state update received from SENDER in AREA. Assumes that SENDER's
+     links reflect the update that PKT is based on. */
+  void process_lsu_delta(OSPFArea::Ptr area,
+                         Fwk::Ptr<OSPFNode> sender,
+                         Fwk::Ptr<const OSPFLSUDeltaPacket> pkt,
+                         Interface::PtrConst iface);
+
+  /* Processes a single advertisement ADV_PKT received from SENDER in AREA,
+     as described for process_lsu_advertisements(). TUNNEL is the tunnel
+     through which the advertisement arrived, if any; COST is the cost that
+     SENDER advertised for the link, and SUMMARY is true if the
+     advertisement is an inter-area summary. Returns false if the
+     advertisement is ignored. */
+  bool process_lsu_advertisement(OSPFArea::Ptr area,
+                                 Fwk::Ptr<OSPFNode> sender,
+                                 Fwk::Ptr<const OSPFLSUAdvPacket> adv_pkt,
+                                 Fwk::Ptr<const Tunnel> tunnel,
+                                 uint16_t cost,
+                                 bool summary);
+
+  /* Removes the link from SENDER described by the withdrawn advertisement
+     ADV_PKT, along with any staged advertisement for it in AREA. */
+  void process_lsu_withdrawal(OSPFArea::Ptr area,
+                              Fwk::Ptr<OSPFNode> sender,
+                              Fwk::Ptr<const OSPFLSUAdvPacket> adv_pkt);
+
+  /* Brings the costs of the links to direct neighbors up to date with the
+     costs of their interfaces, which may have been configured or changed
+     speed since the links were added. */
+  void link_costs_update();
+
+  /* Re-elects the designated routers of all interfaces, whose neighbors or
+     priorities may have changed. */
+  void dr_elections_update();
+
+  /* Recomputes the summaries advertised into each area if routes or areas
+     have changed since they were last computed; see areaBorderRouter().
+     Prefixes are summarized by the ranges of the area they belong to, and
+     prefixes that are within an area are not advertised into it. */
+  void summaries_update();
+
+  /* Returns the tunnel whose virtual interface is IFACE, or NULL if IFACE
+     is not a virtual interface. */
+  Fwk::Ptr<const Tunnel> inbound_tunnel(Interface::PtrConst iface) const;
+
+  /* Returns the node of NODE_ID in the topology of AREA, creating it if
+     necessary, unless the link-state update with SEQNO from NODE_ID should
+     be ignored because it was sent by this router or is not newer than the
+     latest update received from NODE_ID. In that case, NULL is returned. */
+  Fwk::Ptr<OSPFNode> lsu_sender(OSPFArea::Ptr area, const RouterID& node_id,
+                                uint16_t seqno);
+
+  /* Returns false if the resynchronization request with SEQNO from
+     NODE_ID has already been seen. */
+  bool lsr_new(const RouterID& node_id, uint16_t seqno);
+
+  /* Floods a request for a complete link-state update from TARGET_ID into
+     AREA. */
+  void lsr_send(OSPFArea::PtrConst area, const RouterID& target_id);
+
   /* Removes active links connected to SENDER if they are not confirmed in
      the given OSPF LSU packet. */
-  void remove_unconfirmed_links(OSPFNode::Ptr sender,
+  void remove_unconfirmed_links(OSPFArea::Ptr area, OSPFNode::Ptr sender,
                                 Fwk::Ptr<OSPFAdvertisementSet> confirmed_advs);
 
   /* Forwards OSPF PKT to the node in the topology with DEST_ID. */
   void forward_packet_to_gateway(Fwk::Ptr<OSPFPacket> pkt,
-                                 Fwk::Ptr<OSPFGateway> gw_obj) const;
-
-  /* Sends the given LSU packet to all neighbors except the packet's original
-     sender. */
-  void forward_lsu_flood(Fwk::Ptr<OSPFLSUPacket> pkt) const;
+                                 Fwk::Ptr<OSPFGateway> gw_obj);
+
+  /* Sends the given flooded packet (a link-state update or request),
+     received on IN_IFACE, to all neighbors in AREA except the packet's
+     original sender. On interfaces with a designated router, see
+     OSPFInterface::floodMode(). */
+  void forward_lsu_flood(OSPFArea::PtrConst area, Fwk::Ptr<OSPFPacket> pkt,
+                         Interface::PtrConst in_iface);
+
+  /* Stores in GATEWAYS the neighbors on IFACE that receive their own copy
+     of a packet flooded in MODE. */
+  static void flood_gateways(Fwk::Ptr<OSPFInterface> iface,
+                             OSPFInterface::FloodMode mode,
+                             std::vector<Fwk::Ptr<OSPFGateway> >& gateways);
+
+  /* Sends a new LSU update to all neighbors in AREA. */
+  void flood_lsu(OSPFArea::Ptr area);
+
+  /* Sends a copy of PKT, an IP packet enclosing an OSPF packet, to all
+     neighbors directly connected to IFACE, or to the designated routers
+     and the segment as described in OSPFInterface::floodMode(). */
+  void flood_out_interface(Fwk::Ptr<OSPFInterface> iface,
+                           Fwk::Ptr<const IPPacket> pkt);
+
+  /* Link-state advertisement of a single gateway or summary, as sent in
+     LSUs. */
+  struct LSUAdvertisement {
+    RouterID router_id;
+    IPv4Addr subnet;
+    IPv4Addr mask;
+
+    bool operator<(const LSUAdvertisement& other) const;
+  };
 
-  /* Sends a new LSU update to all connected neighbors. */
-  void flood_lsu();
+  /* Link-state updates flooded into a single area. */
+  struct LSUState {
+    uint32_t seqno;
+    bool dirty;         /* Links have changed since the last flood. */
+    bool full_pending;  /* Next update must be complete. */
+    uint32_t intervals; /* Link-state intervals since complete update. */
 
-  /* Sends a new LSU update to all neighbors directly connected to IFACE. */
-  void flood_lsu_out_interface(Fwk::Ptr<OSPFInterface> iface);
+    std::vector<LSUAdvertisement> advs; /* Sent in the last update. */
 
-  /* Constructs a full link-state update packet destined to neighbor with id
-     NBR_ID connected at interface IFACE. */
-  Fwk::Ptr<OSPFLSUPacket> build_lsu_to_gateway(Fwk::Ptr<OSPFInterface>,
-                                               Fwk::Ptr<OSPFGateway>) const;
+    LSUState();
+  };
 
-  /* Sets link state advertisements in the provided OSPF packet from the
-     given interface starting with the advertisement with index STARTING_IX. */
+  /* Marks the link-state update of AREA_ID as changed. If FULL, the next
+     update must be complete, as incremental updates do not carry costs or
+     summaries. */
+  void lsu_changed(const AreaID& area_id, bool full);
+
+  /* Returns the link-state update to flood into AREA next: either a
+     complete update or, if enabled, an incremental one. */
+  Fwk::Ptr<const IPPacket> lsu_next(OSPFArea::PtrConst area);
+
+  /* Builds the complete link-state update of AREA for its current sequence
+     number. The returned IP packet has no source or destination address; it
+     is only ever copied by packet_to_gateway(). */
+  Fwk::Ptr<const IPPacket> lsu_new(OSPFArea::PtrConst area);
+
+  /* Builds an incremental link-state update of AREA for its current
+     sequence number listing ADDED and WITHDRAWN advertisements. Like
+     lsu_new(). */
+  Fwk::Ptr<const IPPacket>
+  lsu_delta_new(OSPFArea::PtrConst area,
+                const std::vector<LSUAdvertisement>& added,
+                const std::vector<LSUAdvertisement>& withdrawn);
+
+  /* Stores the advertisements of all gateways in AREA and of its summaries
+     in ADVS, in order. */
+  void lsu_advertisements(OSPFArea::PtrConst area,
+                          std::vector<LSUAdvertisement>& advs) const;
+
+  /* Constructs a copy of PKT, an IP packet enclosing an OSPF packet, destined
+     to the neighbor behind GW_OBJ, connected at interface IFACE. Only the IP
+     header of the copy is rewritten. */
+  Fwk::Ptr<OSPFPacket> packet_to_gateway(Fwk::Ptr<const IPPacket> pkt,
+                                         Fwk::Ptr<OSPFInterface> iface,
+                                         Fwk::Ptr<OSPFGateway> gw_obj) const;
+
+  /* Like packet_to_gateway(), but the copy is destined to DST. */
+  Fwk::Ptr<OSPFPacket> packet_copy(Fwk::Ptr<const IPPacket> pkt,
+                                   Fwk::Ptr<OSPFInterface> iface,
+                                   const IPv4Addr& dst) const;
+
+  /* Sets link state advertisements and their costs in the provided OSPF
+     packet from the given interface starting with the advertisement with
+     index STARTING_IX. */
   static void set_lsu_adv_from_interface(Fwk::Ptr<OSPFLSUPacket>,
                                          Fwk::Ptr<OSPFInterface>,
                                          uint32_t& starting_ix);
@@ -263,15 +593,33 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
   /* -- OSPFRouter data members. -- */
 
   const AreaID area_id_;
-  Fwk::Ptr<OSPFNode> router_node_;
+  RouterID router_id_;
   Fwk::Ptr<OSPFInterfaceMap> interfaces_;
-  Fwk::Ptr<OSPFTopology> topology_;
-  TopologyReactor::Ptr topology_reactor_; /* Reactor: Topology notifications */
+  Fwk::Map<AreaID,OSPFArea> areas_;
   OSPFInterfaceMapReactor::Ptr im_reactor_;
   RoutingTableReactor::Ptr rtable_reactor_;
 
-  uint32_t lsu_seqno_;
-  bool lsu_dirty_; /* Links to neighbors have changed since last LSU flood */
+  /* Link-state updates of each area. */
+  std::map<AreaID,LSUState> lsu_states_;
+
+  /* Incremental link-state updates. */
+  bool lsu_deltas_enabled_;
+  uint16_t lsr_seqno_;
+  std::map<RouterID,uint16_t> lsr_seqnos_; /* Latest request seen per node. */
+
+  /* Shortest-path computation timers of all areas. */
+  Milliseconds spf_initial_delay_;
+  Milliseconds spf_hold_time_;
+  Milliseconds spf_max_wait_;
+
+  /* Routes or areas have changed since summaries were last computed. */
+  bool summaries_dirty_;
+
+  /* Statistics. */
+  uint64_t lsu_full_floods_;
+  uint64_t lsu_delta_floods_;
+  uint64_t lsr_sent_;
+  uint64_t flood_packets_sent_;
 
   /* Singleton notifiee. */
   Notifiee::Ptr notifiee_;
@@ -284,11 +632,16 @@ class OSPFRouter : public Fwk::PtrInterface<OSPFRouter> {
      several data members above through the this ptr of OSPFRouter. */
   PacketFunctor functor_;
 
-  /* Keeps track of neighbor relationships that have not yet been commited to
-     the topology. This is necessary to avoid corrupting the topology in
-     response to contradicting link-state advertisements. Refer to the PWOSPF
-     specification for more details. */
-  OSPFAdvertisementMap advs_staged_;
+  /* Dynamic routes recorded for each subnet, keyed by the node that
+     contributed them. Several nodes may be connected to the same subnet;
+     the preferred route, as ordered by RouteSource, is the one installed in
+     the routing table. */
+  typedef std::map<RouteSource,RoutingTable::Entry::Ptr> RouteContributorMap;
+  std::map<IPv4Subnet,RouteContributorMap> routes_;
+
+  /* Routes currently contributed by each node of each area. */
+  typedef std::map<RouterID,DestRoutes> DestRoutesMap;
+  std::map<AreaID,DestRoutesMap> dest_routes_;
 
   bool enabled_;
 
@@ -0,0 +1,92 @@
+#include "ospf_spf_throttle.h"
+
+
+OSPFSPFThrottle::OSPFSPFThrottle(const Milliseconds& initial_delay,
+                                 const Milliseconds& hold_time,
+                                 const Milliseconds& max_wait)
+    : initial_delay_(initial_delay),
+      hold_time_(hold_time),
+      max_wait_(max_wait),
+      pending_(false),
+      backoff_reset_(false),
+      deadline_(0),
+      backoff_(hold_time),
+      last_run_(0),
+      has_run_(false),
+      changes_(0),
+      runs_(0),
+      suppressed_runs_(0),
+      run_time_(0),
+      last_run_time_(0),
+      max_run_time_(0) {
+  maxWaitIs(max_wait);
+}
+
+bool
+OSPFSPFThrottle::runDue(const Milliseconds& now) const {
+  return pending_ && now >= deadline_;
+}
+
+void
+OSPFSPFThrottle::holdTimeIs(const Milliseconds& hold) {
+  hold_time_ = hold;
+  if (max_wait_ < hold_time_)
+    max_wait_ = hold_time_;
+}
+
+void
+OSPFSPFThrottle::maxWaitIs(const Milliseconds& wait) {
+  max_wait_ = wait;
+  if (max_wait_ < hold_time_)
+    max_wait_ = hold_time_;
+
+  if (backoff_ > max_wait_)
+    backoff_ = max_wait_;
+}
+
+void
+OSPFSPFThrottle::onChange(const Milliseconds& now) {
+  ++changes_;
+
+  if (pending_) {
+    /* Change is picked up by the computation that is already scheduled. */
+    ++suppressed_runs_;
+    return;
+  }
+
+  pending_ = true;
+
+  int64_t quiet = now.value() - last_run_.value();
+  if (!has_run_ || quiet >= 2 * max_wait_.value()) {
+    /* Quiet period: run soon, and start backing off from holdTime(). */
+    backoff_reset_ = true;
+    backoff_ = hold_time_;
+    deadline_ = now.value() + initial_delay_.value();
+    return;
+  }
+
+  int64_t earliest = last_run_.value() + backoff_.value();
+  int64_t deadline = now.value() + initial_delay_.value();
+  deadline_ = (deadline > earliest) ? deadline : earliest;
+}
+
+void
+OSPFSPFThrottle::onRun(const Milliseconds& start, uint64_t duration) {
+  ++runs_;
+  run_time_ += duration;
+  last_run_time_ = duration;
+  if (duration > max_run_time_)
+    max_run_time_ = duration;
+
+  /* The hold time doubles after every computation, except the one that
+     ends a quiet period. */
+  if (!backoff_reset_) {
+    int64_t backoff = 2 * backoff_.value();
+    backoff_ = (backoff < max_wait_.value()) ? backoff : max_wait_.value();
+  }
+
+  pending_ = false;
+  backoff_reset_ = false;
+  last_run_ = start;
+  has_run_ = true;
+}
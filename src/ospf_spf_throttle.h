@@ -0,0 +1,108 @@
+#ifndef OSPF_SPF_THROTTLE_H_K2M7QZ4D
+#define OSPF_SPF_THROTTLE_H_K2M7QZ4D
+
+#include <inttypes.h>
+
+#include "fwk/ptr_interface.h"
+
+#include "time_types.h"
+
+
+/* Decides when shortest-path computations may run, and keeps statistics on
+   them. Topology changes that arrive while a computation is already pending
+   are batched into it.
+
+   The first computation after a quiet period waits initialDelay(). After
+   that, consecutive computations are spaced at least holdTime() apart, and
+   the spacing doubles after every computation up to maxWait(). The spacing
+   is reset once no computation has run for twice maxWait(). */
+class OSPFSPFThrottle : public Fwk::PtrInterface<OSPFSPFThrottle> {
+ public:
+  typedef Fwk::Ptr<const OSPFSPFThrottle> PtrConst;
+  typedef Fwk::Ptr<OSPFSPFThrottle> Ptr;
+
+  static Ptr New(const Milliseconds& initial_delay,
+                 const Milliseconds& hold_time,
+                 const Milliseconds& max_wait) {
+    return new OSPFSPFThrottle(initial_delay, hold_time, max_wait);
+  }
+
+  /* Accessors. */
+
+  const Milliseconds& initialDelay() const { return initial_delay_; }
+  const Milliseconds& holdTime() const { return hold_time_; }
+  const Milliseconds& maxWait() const { return max_wait_; }
+
+  /* True if a computation has been requested but has not yet run. */
+  bool pending() const { return pending_; }
+
+  /* Time at which the pending computation may run. */
+  const Milliseconds& deadline() const { return deadline_; }
+
+  /* True if a computation is pending and may run at time NOW. */
+  bool runDue(const Milliseconds& now) const;
+
+  /* Statistics. */
+
+  /* Number of topology changes reported through onChange(). */
+  uint64_t changes() const { return changes_; }
+
+  /* Number of computations that have run. */
+  uint64_t runs() const { return runs_; }
+
+  /* Number of changes that were folded into an already pending computation
+     instead of triggering one of their own. */
+  uint64_t suppressedRuns() const { return suppressed_runs_; }
+
+  /* Time spent in computations, in microseconds. */
+  uint64_t runTime() const { return run_time_; }
+  uint64_t lastRunTime() const { return last_run_time_; }
+  uint64_t maxRunTime() const { return max_run_time_; }
+
+  /* Mutators. */
+
+  void initialDelayIs(const Milliseconds& delay) { initial_delay_ = delay; }
+  void holdTimeIs(const Milliseconds& hold);
+  void maxWaitIs(const Milliseconds& wait);
+
+  /* Signals. */
+
+  /* A topology change was observed at time NOW. */
+  void onChange(const Milliseconds& now);
+
+  /* A computation started at time START and took DURATION microseconds. */
+  void onRun(const Milliseconds& start, uint64_t duration);
+
+ protected:
+  OSPFSPFThrottle(const Milliseconds& initial_delay,
+                  const Milliseconds& hold_time,
+                  const Milliseconds& max_wait);
+
+ private:
+  /* Configuration. */
+  Milliseconds initial_delay_;
+  Milliseconds hold_time_;
+  Milliseconds max_wait_;
+
+  /* State. */
+  bool pending_;
+  bool backoff_reset_;     /* Pending computation follows a quiet period. */
+  Milliseconds deadline_;
+  Milliseconds backoff_;   /* Minimum spacing after the last computation. */
+  Milliseconds last_run_;
+  bool has_run_;
+
+  /* Statistics. */
+  uint64_t changes_;
+  uint64_t runs_;
+  uint64_t suppressed_runs_;
+  uint64_t run_time_;
+  uint64_t last_run_time_;
+  uint64_t max_run_time_;
+
+  /* Operations disallowed. */
+  OSPFSPFThrottle(const OSPFSPFThrottle&);
+  void operator=(const OSPFSPFThrottle&);
+};
+
+#endif
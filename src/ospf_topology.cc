@@ -1,5 +1,7 @@
 #include "ospf_topology.h"
 
+#include <algorithm>
+#include <ctime>
 #include <sstream>
 using std::stringstream;
 
@@ -11,11 +13,26 @@ using std::stringstream;
 /* Static global log instance */
 static Fwk::Log::Ptr log_ = Fwk::Log::LogNew("OSPFTopology");
 
+const uint32_t OSPFTopology::kInvalidIndex;
+
+/* Current time on the monotonic clock, in microseconds. */
+static uint64_t
+monotonic_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 
 OSPFTopology::OSPFTopology(OSPFNode::Ptr root_node)
     : root_node_(root_node),
       node_reactor_(NodeReactor::New(this)),
-      dirty_(false) {
+      spf_throttle_(OSPFSPFThrottle::New(OSPF::kDefaultSPFInitialDelay,
+                                         OSPF::kDefaultSPFHoldTime,
+                                         OSPF::kDefaultSPFMaxWait)),
+      dirty_(false),
+      spf_adj_valid_(false),
+      spf_full_(true) {
   root_node_->notifieeIs(node_reactor_);
 }
 
@@ -45,22 +62,12 @@ OSPFTopology::node(const RouterID& router_id) const {
 
 OSPFNode::Ptr
 OSPFTopology::nextHop(const RouterID& router_id) {
-  OSPFNode::Ptr next_hop = NULL;
-
+  /* First hops are recorded during the spanning tree computation. */
   OSPFNode::Ptr nd = node(router_id);
-  for (;;) {
-    if (nd == NULL)
-      break;
+  if (nd == NULL)
+    return NULL;
 
-    if (nd->upstreamNode() == root_node_) {
-      next_hop = nd;
-      break;
-    }
-
-    nd = nd->upstreamNode();
-  }
-
-  return next_hop;
+  return nd->firstHop();
 }
 
 OSPFNode::PtrConst
@@ -94,6 +101,11 @@ OSPFTopology::nodeIs(OSPFNode::Ptr node) {
   if (node_prev != node) {
     nodes_[nd_id] = node;
 
+    if (node_prev == NULL)
+      spf_nodes_added_.push_back(node);
+    else
+      spf_full_ = true;
+
     /* Subscribing from notifications. */
     node->notifieeIs(node_reactor_);
 
@@ -115,6 +127,10 @@ OSPFTopology::nodeDel(const RouterID& router_id) {
   if (node) {
     nodes_.elemDel(router_id);
 
+    /* Dense SPF indices are invalidated by node removal. */
+    spf_full_ = true;
+    spf_nodes_deleted_.push_back(router_id);
+
     /* Unsubscribing from notifications. */
     node->notifieeIs(NULL);
 
@@ -145,8 +161,46 @@ OSPFTopology::nodeDel(const RouterID& router_id) {
 
 void
 OSPFTopology::onUpdate() {
-  if (dirty())
+  if (!dirty())
+    return;
+
+  changed_nodes_.clear();
+
+  Milliseconds start = monotonicTimeMs();
+  uint64_t start_us = monotonic_us();
+
+  if (spf_full_)
     compute_optimal_spanning_tree();
+  else
+    compute_incremental_spanning_tree();
+
+  spf_throttle_->onRun(start, monotonic_us() - start_us);
+
+  /* Link changes are still needed to update the neighbors' trees. */
+  const bool full = spf_full_;
+  LinkChanges links_added;
+  LinkChanges links_deleted;
+  links_added.swap(spf_links_added_);
+  links_deleted.swap(spf_links_deleted_);
+
+  spf_full_ = false;
+  spf_nodes_added_.clear();
+  spf_nodes_relinked_.clear();
+  spf_nodes_deleted_.clear();
+
+  /* Resetting topology dirty bit. */
+  dirtyIs(false);
+
+  /* Backup hops only matter once the next failure occurs, so routes are
+     updated first. */
+  if (spf_backup_hops_compute(full, links_added, links_deleted) && notifiee_)
+    notifiee_->onBackupHops();
+}
+
+void
+OSPFTopology::onTick(const Milliseconds& now) {
+  if (dirty() && spf_throttle_->runDue(now))
+    onUpdate();
 }
 
 string
@@ -165,66 +219,855 @@ OSPFTopology::str() const {
   return ss.str();
 }
 
-/* Implementation of Dijkstra's algorithm. */
+/* Implementation of Dijkstra's algorithm over a dense snapshot of the
+   topology. Nodes are numbered 0..V-1, active links and their costs are
+   flattened into adjacency arrays, and the frontier is kept in an indexed
+   binary heap, so the computation runs in O((V + E) log V). Keys in the heap
+   are ordered by (distance, index), so that ties are broken
+   deterministically. */
 void
 OSPFTopology::compute_optimal_spanning_tree() {
   ILOG << "Computing optimal spanning tree";
 
-  /* Set of all nodes: shallow copy of nodes_. */
-  Fwk::Map<RouterID,OSPFNode> node_set(nodes_);
-  node_set[root_node_->routerID()] = root_node_;
+  spf_index_nodes();
+  spf_build_adjacency();
+  spf_adj_valid_ = true;
 
-  /* Initializing distance to all nodes to kMaxDistance. */
-  for (iterator it = node_set.begin(); it != node_set.end(); ++it) {
-    OSPFNode::Ptr node = it->second;
-    node->distanceIs(OSPFNode::kMaxDistance);
-    node->upstreamNodeIs(NULL);
+  const uint32_t node_count = spf_nodes_.size();
+  spf_dist_.assign(node_count, OSPFNode::kMaxDistance);
+  spf_prev_.assign(node_count, kInvalidIndex);
+  spf_first_hop_.assign(node_count, kInvalidIndex);
+  spf_heap_.capacityIs(node_count);
+
+  /* Initializing distance to self to 0; root node has index 0. */
+  spf_dist_[0] = 0;
+  spf_heap_.priorityIs(0, 0);
+
+  /* Nodes in the order in which their distance became final. */
+  std::vector<uint32_t> order;
+  order.reserve(node_count);
+
+  while (!spf_heap_.empty()) {
+    uint32_t cur = spf_heap_.top();
+    spf_heap_.pop();
+    order.push_back(cur);
+
+    /* Every node that reaches the heap has a finite distance, so nodes that
+       are inaccessible from root_node_ are never visited. */
+    for (uint32_t e = spf_adj_offset_[cur]; e < spf_adj_offset_[cur + 1]; ++e) {
+      uint32_t neighbor = spf_adj_[e];
+      uint32_t alt_dist = spf_dist_[cur] + spf_adj_cost_[e];
+      if (alt_dist < spf_dist_[neighbor]) {
+        spf_dist_[neighbor] = alt_dist;
+        spf_prev_[neighbor] = cur;
+        spf_first_hop_[neighbor] = spf_first_hop(cur, neighbor);
+        spf_heap_.priorityIs(neighbor, alt_dist);
+      }
+    }
   }
 
-  /* Initializing distance to self to 0 */
-  root_node_->distanceIs(0);
+  /* Equal-cost first hops. Every node is visited after all of its parents
+     in the shortest-path DAG, which have strictly smaller distances; the
+     root node, which has none, is order[0]. */
+  spf_first_hops_.resize(node_count);
+  for (uint32_t i = 0; i < node_count; ++i)
+    spf_first_hops_[i].clear();
 
-  while (node_set.size() > 0) {
-    OSPFNode::Ptr cur_nd = min_dist_node(node_set);
-    if (cur_nd->distance() == OSPFNode::kMaxDistance) {
-      /* All remaining nodes are inaccessible from root_node_. */
-      break;
+  for (size_t i = 1; i < order.size(); ++i) {
+    uint32_t x = order[i];
+    std::vector<uint32_t>& hops = spf_first_hops_[x];
+    for (uint32_t e = spf_adj_offset_[x]; e < spf_adj_offset_[x + 1]; ++e) {
+      uint32_t y = spf_adj_[e];
+      if (spf_dist_[y] + spf_adj_cost_[e] == spf_dist_[x])
+        spf_first_hops_add(y, x, hops);
     }
 
-    node_set.elemDel(cur_nd->routerID());
+    spf_first_hops_normalize(hops);
+  }
 
-    for (OSPFNode::lna_iter it = cur_nd->activeLinksBegin();
-         it != cur_nd->activeLinksEnd(); ++it) {
-      OSPFLink::Ptr link = it->second;
-      OSPFNode::Ptr neighbor = link->node();
-      neighbor = node_set.elem(neighbor->routerID());
-      if (neighbor) {
-        /* Neighboring node, NEIGHBOR, has not been visited yet.
-         * Namely, it still exists in node_set. We can continue. */
-        uint16_t alt_dist = cur_nd->distance() + 1;
-        if (alt_dist < neighbor->distance()) {
-          neighbor->distanceIs(alt_dist);
-          neighbor->upstreamNodeIs(cur_nd);
+  /* Writing results back into the nodes. Every node is reported as changed,
+     along with the nodes that were removed since the last computation. */
+  for (uint32_t i = 0; i < node_count; ++i) {
+    spf_write_back(i);
+    changed_nodes_.push_back(spf_nodes_[i]->routerID());
+  }
+
+  changed_nodes_.insert(changed_nodes_.end(), spf_nodes_deleted_.begin(),
+                        spf_nodes_deleted_.end());
+
+  spf_touched_.assign(node_count, false);
+}
+
+/* Incremental variant of the computation above. Starting from the tree of
+   the last computation, only the nodes affected by link changes are
+   revisited:
+
+     - The subtree hanging off a deleted tree link, or off a tree link whose
+       cost went up, is detached; each of its nodes is reseeded from its
+       best neighbor outside the subtree.
+     - An added link seeds its endpoints if it shortens the path to either.
+
+   Dijkstra's algorithm is then run from the seeded nodes only, and it
+   stops expanding wherever distances no longer improve. */
+void
+OSPFTopology::compute_incremental_spanning_tree() {
+  DLOG << "Incrementally updating optimal spanning tree";
+
+  /* Newly inserted nodes start out unreachable. */
+  for (size_t i = 0; i < spf_nodes_added_.size(); ++i) {
+    OSPFNode* node = spf_nodes_added_[i].ptr();
+    if (spf_index(node) != kInvalidIndex)
+      continue;
+
+    node->spf_index_ = spf_nodes_.size();
+    spf_nodes_.push_back(node);
+    spf_dist_.push_back(OSPFNode::kMaxDistance);
+    spf_prev_.push_back(kInvalidIndex);
+    spf_first_hop_.push_back(kInvalidIndex);
+    spf_first_hops_.push_back(std::vector<uint32_t>());
+    spf_touched_.push_back(false);
+  }
+
+  const uint32_t node_count = spf_nodes_.size();
+  if (spf_heap_.capacity() != node_count)
+    spf_heap_.capacityIs(node_count);
+
+  if (!spf_nodes_added_.empty() || !spf_links_added_.empty()
+      || !spf_links_deleted_.empty())
+    spf_adj_valid_ = false;
+
+  /* The set of prefixes advertised by the endpoints of every changed link
+     has changed, regardless of what happens to the tree. */
+  for (size_t i = 0; i < spf_nodes_relinked_.size(); ++i)
+    spf_touch(spf_index(spf_nodes_relinked_[i].ptr()));
+
+  /* Detaching subtrees below deleted tree links. */
+  std::vector<uint32_t> roots;
+  for (size_t i = 0; i < spf_links_deleted_.size(); ++i) {
+    uint32_t a = spf_index(spf_links_deleted_[i].first.ptr());
+    uint32_t b = spf_index(spf_links_deleted_[i].second.ptr());
+    spf_touch(a);
+    spf_touch(b);
+
+    if (a == kInvalidIndex || b == kInvalidIndex)
+      continue;
+
+    if (spf_prev_[b] == a)
+      roots.push_back(b);
+    else if (spf_prev_[a] == b)
+      roots.push_back(a);
+  }
+
+  /* A link is also reported as added when its cost changes. */
+  for (size_t i = 0; i < spf_links_added_.size(); ++i) {
+    uint32_t a = spf_index(spf_links_added_[i].first.ptr());
+    uint32_t b = spf_index(spf_links_added_[i].second.ptr());
+    if (a == kInvalidIndex || b == kInvalidIndex)
+      continue;
+
+    OSPFLink* link = spf_nodes_[a]->activeLink(spf_nodes_[b]->routerID()).ptr();
+    if (link == NULL)
+      continue;
+
+    if (spf_prev_[b] == a && spf_dist_[b] < spf_dist_[a] + link->cost())
+      roots.push_back(b);
+    else if (spf_prev_[a] == b && spf_dist_[a] < spf_dist_[b] + link->cost())
+      roots.push_back(a);
+  }
+
+  std::vector<uint32_t> detached;
+  spf_collect_subtrees(spf_prev_, roots, detached);
+  for (size_t i = 0; i < detached.size(); ++i) {
+    uint32_t x = detached[i];
+    spf_dist_[x] = OSPFNode::kMaxDistance;
+    spf_prev_[x] = kInvalidIndex;
+    spf_first_hop_[x] = kInvalidIndex;
+    spf_touch(x);
+  }
+
+  /* Reseeding detached nodes from neighbors that are still attached. Among
+     equally distant neighbors, the one with the lowest index is preferred,
+     as in a full computation. */
+  for (size_t i = 0; i < detached.size(); ++i) {
+    uint32_t x = detached[i];
+    OSPFNode* node = spf_nodes_[x];
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      uint32_t y = spf_index(it->second->node().ptr());
+      if (y == kInvalidIndex || spf_dist_[y] == OSPFNode::kMaxDistance)
+        continue;
+
+      uint32_t alt_dist = spf_dist_[y] + it->second->cost();
+      if (alt_dist < spf_dist_[x]
+          || (alt_dist == spf_dist_[x] && y < spf_prev_[x])) {
+        spf_dist_[x] = alt_dist;
+        spf_prev_[x] = y;
+        spf_first_hop_[x] = spf_first_hop(y, x);
+      }
+    }
+
+    if (spf_prev_[x] != kInvalidIndex)
+      spf_heap_.priorityIs(x, spf_dist_[x]);
+  }
+
+  /* Seeding endpoints of added links. */
+  for (size_t i = 0; i < spf_links_added_.size(); ++i) {
+    uint32_t a = spf_index(spf_links_added_[i].first.ptr());
+    uint32_t b = spf_index(spf_links_added_[i].second.ptr());
+    spf_touch(a);
+    spf_touch(b);
+
+    if (a == kInvalidIndex || b == kInvalidIndex)
+      continue;
+
+    /* The link may have been deleted again since it was added. */
+    OSPFLink* link = spf_nodes_[a]->activeLink(spf_nodes_[b]->routerID()).ptr();
+    if (link == NULL)
+      continue;
+
+    spf_relax(a, b, link->cost());
+    spf_relax(b, a, link->cost());
+  }
+
+  /* Propagating improvements from the seeded nodes. */
+  while (!spf_heap_.empty()) {
+    uint32_t cur = spf_heap_.top();
+    spf_heap_.pop();
+
+    OSPFNode* node = spf_nodes_[cur];
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      uint32_t neighbor = spf_index(it->second->node().ptr());
+      if (neighbor != kInvalidIndex)
+        spf_relax(cur, neighbor, it->second->cost());
+    }
+  }
+
+  spf_update_first_hops();
+
+  /* Writing results back into the affected nodes only. */
+  for (size_t i = 0; i < spf_touched_list_.size(); ++i) {
+    uint32_t x = spf_touched_list_[i];
+    spf_write_back(x);
+    changed_nodes_.push_back(spf_nodes_[x]->routerID());
+    spf_touched_[x] = false;
+  }
+
+  spf_touched_list_.clear();
+}
+
+/* Assigns a dense index to every node in the topology. The raw pointers in
+   spf_nodes_ are valid for as long as the nodes remain in nodes_. */
+void
+OSPFTopology::spf_index_nodes() {
+  spf_nodes_.clear();
+  spf_nodes_.reserve(nodes_.size() + 1);
+
+  root_node_->spf_index_ = 0;
+  spf_nodes_.push_back(root_node_.ptr());
+
+  for (iterator it = nodes_.begin(); it != nodes_.end(); ++it) {
+    OSPFNode* node = it->second.ptr();
+    node->spf_index_ = spf_nodes_.size();
+    spf_nodes_.push_back(node);
+  }
+}
+
+/* Flattens the active links of every indexed node into spf_adj_, and their
+   costs into spf_adj_cost_. Links to
+   nodes that are not part of the topology are skipped; such a node either
+   carries an index that is out of range or one that maps to a different
+   node in spf_nodes_. */
+void
+OSPFTopology::spf_build_adjacency() {
+  const uint32_t node_count = spf_nodes_.size();
+  spf_adj_offset_.resize(node_count + 1);
+  spf_adj_.clear();
+  spf_adj_cost_.clear();
+
+  for (uint32_t i = 0; i < node_count; ++i) {
+    OSPFNode* node = spf_nodes_[i];
+    spf_adj_offset_[i] = spf_adj_.size();
+
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      OSPFNode* neighbor = it->second->node().ptr();
+      uint32_t index = neighbor->spf_index_;
+      if (index < node_count && spf_nodes_[index] == neighbor) {
+        spf_adj_.push_back(index);
+        spf_adj_cost_.push_back(it->second->cost());
+      }
+    }
+  }
+
+  spf_adj_offset_[node_count] = spf_adj_.size();
+}
+
+/* Returns the dense index of NODE, or kInvalidIndex if NODE is not part of
+   the topology. */
+uint32_t
+OSPFTopology::spf_index(OSPFNode* node) const {
+  if (node == NULL)
+    return kInvalidIndex;
+
+  uint32_t index = node->spf_index_;
+  if (index < spf_nodes_.size() && spf_nodes_[index] == node)
+    return index;
+
+  return kInvalidIndex;
+}
+
+/* Appends the members of the subtrees rooted at ROOTS to MEMBERS. PREV
+   holds the parent of every node in the tree. */
+void
+OSPFTopology::spf_collect_subtrees(const std::vector<uint32_t>& prev,
+                                   const std::vector<uint32_t>& roots,
+                                   std::vector<uint32_t>& members) {
+  if (roots.empty())
+    return;
+
+  /* Children lists in compressed sparse row form, derived from PREV. */
+  const uint32_t node_count = prev.size();
+  std::vector<uint32_t> offset(node_count + 1, 0);
+  for (uint32_t i = 0; i < node_count; ++i) {
+    if (prev[i] != kInvalidIndex)
+      ++offset[prev[i] + 1];
+  }
+
+  for (uint32_t i = 0; i < node_count; ++i)
+    offset[i + 1] += offset[i];
+
+  std::vector<uint32_t> children(offset[node_count]);
+  std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+  for (uint32_t i = 0; i < node_count; ++i) {
+    if (prev[i] != kInvalidIndex)
+      children[fill[prev[i]]++] = i;
+  }
+
+  /* Roots may be nested inside each other's subtrees. */
+  std::vector<bool> visited(node_count, false);
+  std::vector<uint32_t> stack;
+  for (size_t i = 0; i < roots.size(); ++i) {
+    if (visited[roots[i]])
+      continue;
+
+    visited[roots[i]] = true;
+    stack.push_back(roots[i]);
+    while (!stack.empty()) {
+      uint32_t x = stack.back();
+      stack.pop_back();
+      members.push_back(x);
+
+      for (uint32_t c = offset[x]; c < offset[x + 1]; ++c) {
+        if (!visited[children[c]]) {
+          visited[children[c]] = true;
+          stack.push_back(children[c]);
         }
       }
     }
   }
+}
 
-  /* Resetting topology dirty bit. */
-  dirtyIs(false);
+/* Shortens the path to TO through FROM, over a link of cost COST, if
+   possible. */
+void
+OSPFTopology::spf_relax(uint32_t from, uint32_t to, uint32_t cost) {
+  if (spf_dist_[from] == OSPFNode::kMaxDistance)
+    return;
+
+  uint32_t alt_dist = spf_dist_[from] + cost;
+  if (alt_dist < spf_dist_[to]) {
+    spf_dist_[to] = alt_dist;
+    spf_prev_[to] = from;
+    spf_first_hop_[to] = spf_first_hop(from, to);
+    spf_heap_.priorityIs(to, alt_dist);
+    spf_touch(to);
+  }
 }
 
-// TODO(ali): make use of a heap instead.
-OSPFNode::Ptr
-OSPFTopology::min_dist_node(const Fwk::Map<RouterID,OSPFNode>& map) {
-  OSPFNode::Ptr min_nd = NULL;
-  for (const_iterator it = map.begin(); it != map.end(); ++it) {
-    OSPFNode::Ptr cur_nd = it->second;
-    if (min_nd == NULL || cur_nd->distance() < min_nd->distance())
-      min_nd = cur_nd;
+/* First hop of TO when it is reached through FROM. A node's first hop only
+   changes along with its distance, so first hops propagate down the tree
+   together with distances and need no separate pass. */
+uint32_t
+OSPFTopology::spf_first_hop(uint32_t from, uint32_t to) const {
+  /* Root node has index 0. */
+  return (from == 0) ? to : spf_first_hop_[from];
+}
+
+/* Computes into HOPS the equal-cost first hops of node X from those of its
+   parents in the shortest-path DAG, i.e. of all neighbors whose distance
+   from the root plus the cost of their link to X is X's distance. */
+void
+OSPFTopology::spf_first_hops_compute(uint32_t x,
+                                     std::vector<uint32_t>& hops) const {
+  hops.clear();
+  if (x == 0 || spf_dist_[x] == OSPFNode::kMaxDistance)
+    return;
+
+  OSPFNode* node = spf_nodes_[x];
+  for (OSPFNode::lna_iter it = node->activeLinksBegin();
+       it != node->activeLinksEnd(); ++it) {
+    uint32_t y = spf_index(it->second->node().ptr());
+    if (y != kInvalidIndex && spf_dist_[y] != OSPFNode::kMaxDistance
+        && spf_dist_[y] + it->second->cost() == spf_dist_[x])
+      spf_first_hops_add(y, x, hops);
+  }
+
+  spf_first_hops_normalize(hops);
+}
+
+/* Adds the first hops of node X that it inherits from its parent Y. */
+void
+OSPFTopology::spf_first_hops_add(uint32_t y, uint32_t x,
+                                 std::vector<uint32_t>& hops) const {
+  if (y == 0)
+    hops.push_back(x);
+  else
+    hops.insert(hops.end(), spf_first_hops_[y].begin(),
+                spf_first_hops_[y].end());
+}
+
+/* Sorts HOPS and removes duplicates. */
+void
+OSPFTopology::spf_first_hops_normalize(std::vector<uint32_t>& hops) {
+  if (hops.size() < 2)
+    return;
+
+  std::sort(hops.begin(), hops.end());
+  hops.erase(std::unique(hops.begin(), hops.end()), hops.end());
+}
+
+/* Brings equal-cost first hops up to date after an incremental computation.
+   They can change at touched nodes and at their neighbors, which may have
+   gained or lost a parent; from there, changes spread to children in the
+   shortest-path DAG. Nodes are processed in order of distance so that the
+   first hops of all parents are final when a node is visited. */
+void
+OSPFTopology::spf_update_first_hops() {
+  const std::vector<uint32_t> seeds(spf_touched_list_);
+  for (size_t i = 0; i < seeds.size(); ++i) {
+    uint32_t x = seeds[i];
+    spf_first_hops_seed(x);
+
+    OSPFNode* node = spf_nodes_[x];
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      uint32_t y = spf_index(it->second->node().ptr());
+      if (y != kInvalidIndex)
+        spf_first_hops_seed(y);
+    }
   }
 
-  return min_nd;
+  std::vector<uint32_t> hops;
+  while (!spf_heap_.empty()) {
+    uint32_t x = spf_heap_.top();
+    spf_heap_.pop();
+
+    spf_first_hops_compute(x, hops);
+    if (hops == spf_first_hops_[x])
+      continue;
+
+    spf_first_hops_[x].swap(hops);
+    spf_touch(x);
+
+    OSPFNode* node = spf_nodes_[x];
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      uint32_t z = spf_index(it->second->node().ptr());
+      if (z != kInvalidIndex
+          && spf_dist_[z] == spf_dist_[x] + it->second->cost())
+        spf_heap_.priorityIs(z, spf_dist_[z]);
+    }
+  }
+}
+
+/* Schedules node X for spf_update_first_hops(). Unreachable nodes have no
+   first hops and are settled immediately. */
+void
+OSPFTopology::spf_first_hops_seed(uint32_t x) {
+  if (spf_dist_[x] != OSPFNode::kMaxDistance) {
+    spf_heap_.priorityIs(x, spf_dist_[x]);
+  } else if (!spf_first_hops_[x].empty()) {
+    spf_first_hops_[x].clear();
+    spf_touch(x);
+  }
+}
+
+/* Loop-free alternates (RFC 5286). A shortest-path tree is kept for every
+   neighbor N of the root node S. N is a loop-free alternate for node D if
+
+     dist(N, D) < dist(N, S) + dist(S, D),
+
+   i.e. if N's shortest path to D does not lead back through S, so that S
+   can hand traffic for D to N as soon as its first hop P fails. Alternates
+   that also satisfy
+
+     dist(N, D) < dist(N, P) + dist(P, D)
+
+   protect against the failure of P itself, not only of the link to it, and
+   are preferred; ties are broken by the distance to D through N, then by
+   RouterID. Nodes with several equal-cost first hops are protected by the
+   other members of their group and get no alternate.
+
+   After a full computation, the neighbors' trees are rebuilt over the
+   adjacency arrays. Otherwise they are updated with the link changes of
+   LINKS_ADDED and LINKS_DELETED, in the same way as the root's tree, and
+   only nodes whose distance from the root or from a neighbor changed are
+   reevaluated. All nodes are reevaluated when the set of neighbors or the
+   distances between the root and its neighbors change, since the
+   conditions above involve them for every D.
+
+   Nodes whose backup hop changes are added to changed_nodes_. Returns true
+   if there are any. */
+bool
+OSPFTopology::spf_backup_hops_compute(bool full,
+                                      const LinkChanges& links_added,
+                                      const LinkChanges& links_deleted) {
+  const uint32_t node_count = spf_nodes_.size();
+  const size_t tree_changes = changed_nodes_.size();
+
+  std::vector<uint32_t> nbrs;
+  OSPFNode* root = spf_nodes_[0];
+  for (OSPFNode::lna_iter it = root->activeLinksBegin();
+       it != root->activeLinksEnd(); ++it) {
+    uint32_t n = spf_index(it->second->node().ptr());
+    if (n != kInvalidIndex && spf_dist_[n] != OSPFNode::kMaxDistance)
+      nbrs.push_back(n);
+  }
+
+  bool all = full || nbrs.size() != spf_nbr_trees_.size();
+  for (size_t i = 0; !all && i < nbrs.size(); ++i)
+    all = spf_nbr_trees_[i].source != nbrs[i];
+
+  /* Distances between the root and its neighbors, as of the last run. */
+  std::vector<uint32_t> nbr_dist;
+  if (!all) {
+    for (size_t i = 0; i < spf_nbr_trees_.size(); ++i) {
+      const NeighborTree& tree = spf_nbr_trees_[i];
+      nbr_dist.push_back(tree.dist[0]);
+      for (size_t j = 0; j < nbrs.size(); ++j)
+        nbr_dist.push_back(tree.dist[nbrs[j]]);
+    }
+  }
+
+  spf_lfa_touched_.resize(node_count, false);
+
+  std::vector<NeighborTree> trees(nbrs.size());
+  for (size_t i = 0; i < nbrs.size(); ++i) {
+    NeighborTree& tree = trees[i];
+    tree.source = nbrs[i];
+
+    /* Trees of nodes that were already neighbors are kept. */
+    size_t j = 0;
+    while (j < spf_nbr_trees_.size() && spf_nbr_trees_[j].source != nbrs[i])
+      ++j;
+
+    if (!full && j < spf_nbr_trees_.size()) {
+      tree.dist.swap(spf_nbr_trees_[j].dist);
+      tree.prev.swap(spf_nbr_trees_[j].prev);
+      spf_nbr_tree_update(tree, links_added, links_deleted);
+    } else {
+      spf_nbr_tree_build(tree);
+    }
+  }
+
+  spf_nbr_trees_.swap(trees);
+
+  for (size_t i = 0, k = 0; !all && i < spf_nbr_trees_.size(); ++i) {
+    const NeighborTree& tree = spf_nbr_trees_[i];
+    all = nbr_dist[k++] != tree.dist[0];
+    for (size_t j = 0; !all && j < nbrs.size(); ++j)
+      all = nbr_dist[k++] != tree.dist[nbrs[j]];
+  }
+
+  /* Distances from the root to its neighbors changed if they were touched
+     by the spanning tree computation. */
+  for (size_t i = tree_changes; !all && i < changed_nodes_.size(); ++i) {
+    uint32_t x = spf_index(node(changed_nodes_[i]).ptr());
+    spf_lfa_touch(x);
+    all = x == 0 || std::find(nbrs.begin(), nbrs.end(), x) != nbrs.end();
+  }
+
+  std::vector<uint32_t>& nodes = spf_lfa_touched_list_;
+  if (all) {
+    spf_lfa_touched_.assign(node_count, false);
+    nodes.clear();
+    for (uint32_t x = 1; x < node_count; ++x)
+      nodes.push_back(x);
+  }
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    uint32_t x = nodes[i];
+    spf_lfa_touched_[x] = false;
+    if (x == 0)
+      continue; /* Root node. */
+
+    uint32_t backup = spf_backup_hop(x);
+    OSPFNode* node = spf_nodes_[x];
+    OSPFNode* backup_hop =
+      (backup == kInvalidIndex) ? NULL : spf_nodes_[backup];
+    if (node->backupHop().ptr() != backup_hop) {
+      node->backupHopIs(backup_hop);
+      changed_nodes_.push_back(node->routerID());
+    }
+  }
+
+  nodes.clear();
+
+  if (changed_nodes_.size() == tree_changes)
+    return false;
+
+  /* Nodes may have changed in the tree as well. */
+  std::sort(changed_nodes_.begin(), changed_nodes_.end());
+  changed_nodes_.erase(std::unique(changed_nodes_.begin(),
+                                   changed_nodes_.end()),
+                       changed_nodes_.end());
+  return true;
+}
+
+/* Dijkstra's algorithm from the source of TREE over the adjacency arrays,
+   which are rebuilt first if links have changed since the last full
+   computation. Unreachable nodes are at kMaxDistance. */
+void
+OSPFTopology::spf_nbr_tree_build(NeighborTree& tree) {
+  if (!spf_adj_valid_) {
+    spf_build_adjacency();
+    spf_adj_valid_ = true;
+  }
+
+  std::vector<uint32_t>& dist = tree.dist;
+  std::vector<uint32_t>& prev = tree.prev;
+  dist.assign(spf_nodes_.size(), OSPFNode::kMaxDistance);
+  prev.assign(spf_nodes_.size(), kInvalidIndex);
+
+  dist[tree.source] = 0;
+  spf_heap_.priorityIs(tree.source, 0);
+  while (!spf_heap_.empty()) {
+    uint32_t cur = spf_heap_.top();
+    spf_heap_.pop();
+
+    for (uint32_t e = spf_adj_offset_[cur]; e < spf_adj_offset_[cur + 1]; ++e) {
+      uint32_t y = spf_adj_[e];
+      uint32_t alt_dist = dist[cur] + spf_adj_cost_[e];
+      if (alt_dist < dist[y]) {
+        dist[y] = alt_dist;
+        prev[y] = cur;
+        spf_heap_.priorityIs(y, alt_dist);
+      }
+    }
+  }
+}
+
+/* Brings TREE up to date with the link changes of LINKS_ADDED and
+   LINKS_DELETED, as compute_incremental_spanning_tree() does for the tree
+   of the root node. Nodes whose distance may have changed are passed to
+   spf_lfa_touch(). */
+void
+OSPFTopology::spf_nbr_tree_update(NeighborTree& tree,
+                                  const LinkChanges& links_added,
+                                  const LinkChanges& links_deleted) {
+  std::vector<uint32_t>& dist = tree.dist;
+  std::vector<uint32_t>& prev = tree.prev;
+
+  /* Newly inserted nodes start out unreachable. */
+  dist.resize(spf_nodes_.size(), OSPFNode::kMaxDistance);
+  prev.resize(spf_nodes_.size(), kInvalidIndex);
+
+  /* Detaching subtrees below deleted tree links and below tree links whose
+     cost went up. */
+  std::vector<uint32_t> roots;
+  for (size_t i = 0; i < links_deleted.size(); ++i) {
+    uint32_t a = spf_index(links_deleted[i].first.ptr());
+    uint32_t b = spf_index(links_deleted[i].second.ptr());
+    if (a == kInvalidIndex || b == kInvalidIndex)
+      continue;
+
+    if (prev[b] == a)
+      roots.push_back(b);
+    else if (prev[a] == b)
+      roots.push_back(a);
+  }
+
+  for (size_t i = 0; i < links_added.size(); ++i) {
+    uint32_t a = spf_index(links_added[i].first.ptr());
+    uint32_t b = spf_index(links_added[i].second.ptr());
+    if (a == kInvalidIndex || b == kInvalidIndex)
+      continue;
+
+    OSPFLink* link = spf_nodes_[a]->activeLink(spf_nodes_[b]->routerID()).ptr();
+    if (link == NULL)
+      continue;
+
+    if (prev[b] == a && dist[b] < dist[a] + link->cost())
+      roots.push_back(b);
+    else if (prev[a] == b && dist[a] < dist[b] + link->cost())
+      roots.push_back(a);
+  }
+
+  std::vector<uint32_t> detached;
+  spf_collect_subtrees(prev, roots, detached);
+  for (size_t i = 0; i < detached.size(); ++i) {
+    uint32_t x = detached[i];
+    dist[x] = OSPFNode::kMaxDistance;
+    prev[x] = kInvalidIndex;
+    spf_lfa_touch(x);
+  }
+
+  /* Reseeding detached nodes from neighbors that are still attached. */
+  for (size_t i = 0; i < detached.size(); ++i) {
+    uint32_t x = detached[i];
+    OSPFNode* node = spf_nodes_[x];
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      uint32_t y = spf_index(it->second->node().ptr());
+      if (y == kInvalidIndex || dist[y] == OSPFNode::kMaxDistance)
+        continue;
+
+      uint32_t alt_dist = dist[y] + it->second->cost();
+      if (alt_dist < dist[x]) {
+        dist[x] = alt_dist;
+        prev[x] = y;
+      }
+    }
+
+    if (prev[x] != kInvalidIndex)
+      spf_heap_.priorityIs(x, dist[x]);
+  }
+
+  /* Seeding endpoints of added links. */
+  for (size_t i = 0; i < links_added.size(); ++i) {
+    uint32_t a = spf_index(links_added[i].first.ptr());
+    uint32_t b = spf_index(links_added[i].second.ptr());
+    if (a == kInvalidIndex || b == kInvalidIndex)
+      continue;
+
+    OSPFLink* link = spf_nodes_[a]->activeLink(spf_nodes_[b]->routerID()).ptr();
+    if (link == NULL)
+      continue;
+
+    spf_nbr_tree_relax(tree, a, b, link->cost());
+    spf_nbr_tree_relax(tree, b, a, link->cost());
+  }
+
+  /* Propagating improvements from the seeded nodes. */
+  while (!spf_heap_.empty()) {
+    uint32_t cur = spf_heap_.top();
+    spf_heap_.pop();
+
+    OSPFNode* node = spf_nodes_[cur];
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      uint32_t y = spf_index(it->second->node().ptr());
+      if (y != kInvalidIndex)
+        spf_nbr_tree_relax(tree, cur, y, it->second->cost());
+    }
+  }
+}
+
+/* spf_relax() for the tree of a neighbor of the root node. */
+void
+OSPFTopology::spf_nbr_tree_relax(NeighborTree& tree, uint32_t from,
+                                 uint32_t to, uint32_t cost) {
+  if (tree.dist[from] == OSPFNode::kMaxDistance)
+    return;
+
+  uint32_t alt_dist = tree.dist[from] + cost;
+  if (alt_dist < tree.dist[to]) {
+    tree.dist[to] = alt_dist;
+    tree.prev[to] = from;
+    spf_heap_.priorityIs(to, alt_dist);
+    spf_lfa_touch(to);
+  }
+}
+
+/* Index of the best loop-free alternate for node X, or kInvalidIndex if
+   there is none. */
+uint32_t
+OSPFTopology::spf_backup_hop(uint32_t x) const {
+  if (spf_dist_[x] == OSPFNode::kMaxDistance
+      || spf_first_hops_[x].size() != 1)
+    return kInvalidIndex;
+
+  uint32_t p = spf_first_hops_[x][0];
+  const std::vector<uint32_t>* p_dist = NULL;
+  for (size_t i = 0; i < spf_nbr_trees_.size(); ++i) {
+    if (spf_nbr_trees_[i].source == p)
+      p_dist = &spf_nbr_trees_[i].dist;
+  }
+
+  uint32_t backup = kInvalidIndex;
+  bool best_protects = false;
+  uint32_t best_dist = 0;
+  for (size_t i = 0; i < spf_nbr_trees_.size(); ++i) {
+    uint32_t n = spf_nbr_trees_[i].source;
+    const std::vector<uint32_t>& n_dist = spf_nbr_trees_[i].dist;
+    if (n == p || n_dist[x] >= n_dist[0] + spf_dist_[x])
+      continue;
+
+    bool protects = x != p && p_dist != NULL
+                    && n_dist[x] < n_dist[p] + (*p_dist)[x];
+    uint32_t dist = spf_dist_[n] + n_dist[x];
+    if (backup == kInvalidIndex
+        || (protects && !best_protects)
+        || (protects == best_protects
+            && (dist < best_dist
+                || (dist == best_dist
+                    && spf_nodes_[n]->routerID()
+                       < spf_nodes_[backup]->routerID())))) {
+      backup = n;
+      best_protects = protects;
+      best_dist = dist;
+    }
+  }
+
+  return backup;
+}
+
+void
+OSPFTopology::spf_lfa_touch(uint32_t index) {
+  if (index == kInvalidIndex || spf_lfa_touched_[index])
+    return;
+
+  spf_lfa_touched_[index] = true;
+  spf_lfa_touched_list_.push_back(index);
+}
+
+static bool
+router_id_less(const OSPFNode::Ptr& a, const OSPFNode::Ptr& b) {
+  return a->routerID() < b->routerID();
+}
+
+/* Copies the results of the computation for node X into the node. */
+void
+OSPFTopology::spf_write_back(uint32_t x) {
+  OSPFNode* node = spf_nodes_[x];
+  node->distanceIs(spf_dist_[x]);
+
+  uint32_t prev = spf_prev_[x];
+  node->upstreamNodeIs(prev == kInvalidIndex ? NULL : spf_nodes_[prev]);
+
+  uint32_t first_hop = spf_first_hop_[x];
+  node->firstHopIs(first_hop == kInvalidIndex ? NULL : spf_nodes_[first_hop]);
+
+  std::vector<OSPFNode::Ptr>& hops = spf_hops_;
+  const std::vector<uint32_t>& indices = spf_first_hops_[x];
+  hops.clear();
+  for (size_t i = 0; i < indices.size(); ++i)
+    hops.push_back(spf_nodes_[indices[i]]);
+
+  if (hops.size() > 1)
+    std::sort(hops.begin(), hops.end(), router_id_less);
+
+  node->firstHopsIs(hops);
+}
+
+void
+OSPFTopology::spf_touch(uint32_t index) {
+  if (index == kInvalidIndex || spf_touched_[index])
+    return;
+
+  spf_touched_[index] = true;
+  spf_touched_list_.push_back(index);
 }
 
 void
@@ -233,6 +1076,11 @@ OSPFTopology::dirtyIs(bool status) {
   bool notify = (dirty_ && !status) ? true : false;
   dirty_ = status;
 
+  /* Every change is reported to the throttle, which schedules (or batches)
+     the computation that accounts for it. */
+  if (status)
+    spf_throttle_->onChange(monotonicTimeMs());
+
   /* Signal notifiee. */
   if (notifiee_ && notify)
     notifiee_->onDirtyCleared();
@@ -240,15 +1088,36 @@ OSPFTopology::dirtyIs(bool status) {
 
 /* OSPFTopology::NodeReactor */
 
+void
+OSPFTopology::link_change_new(OSPFNode::Ptr node, OSPFNode::Ptr neighbor,
+                              bool added) {
+  if (neighbor == NULL) {
+    /* Link is unknown; the tree has to be recomputed from scratch. */
+    spf_full_ = true;
+
+  } else if (neighbor->isPassiveEndpoint()) {
+    spf_nodes_relinked_.push_back(node);
+
+  } else if (added) {
+    spf_links_added_.push_back(std::make_pair(node, neighbor));
+
+  } else {
+    spf_links_deleted_.push_back(std::make_pair(node, neighbor));
+  }
+
+  dirtyIs(true);
+}
+
 void
 OSPFTopology::NodeReactor::onLink(OSPFNode::Ptr node, OSPFLink::Ptr link) {
   topology_->nodeIs(link->node());
-  topology_->dirtyIs(true);
+  topology_->link_change_new(node, link->node(), true);
 }
 
 void
 OSPFTopology::NodeReactor::onLinkDel(OSPFNode::Ptr node, OSPFLink::Ptr link) {
-  topology_->dirtyIs(true);
+  OSPFNode::Ptr neighbor = link ? link->node() : NULL;
+  topology_->link_change_new(node, neighbor, false);
 }
 
 ostream&
@@ -3,15 +3,19 @@
 
 #include <ostream>
 #include <string>
+#include <vector>
 using std::string;
 using std::ostream;
 
+#include "fwk/hash_map.h"
+#include "fwk/indexed_heap.h"
 #include "fwk/log.h"
-#include "fwk/map.h"
 #include "fwk/ptr_interface.h"
 
 #include "ospf_node.h"
+#include "ospf_spf_throttle.h"
 #include "ospf_types.h"
+#include "time_types.h"
 
 
 class OSPFTopology : public Fwk::PtrInterface<OSPFTopology> {
@@ -19,8 +23,8 @@ class OSPFTopology : public Fwk::PtrInterface<OSPFTopology> {
   typedef Fwk::Ptr<const OSPFTopology> PtrConst;
   typedef Fwk::Ptr<OSPFTopology> Ptr;
 
-  typedef Fwk::Map<RouterID,OSPFNode>::iterator iterator;
-  typedef Fwk::Map<RouterID,OSPFNode>::const_iterator const_iterator;
+  typedef Fwk::HashMap<RouterID,OSPFNode>::iterator iterator;
+  typedef Fwk::HashMap<RouterID,OSPFNode>::const_iterator const_iterator;
 
   static Ptr New(OSPFNode::Ptr root_node) {
     return new OSPFTopology(root_node);
@@ -38,6 +42,10 @@ class OSPFTopology : public Fwk::PtrInterface<OSPFTopology> {
        transitions from TRUE to FALSE. */
     virtual void onDirtyCleared() {}
 
+    /* Signaled after onDirtyCleared() if the backup hops of some nodes
+       have changed; changedNodes() then includes those nodes. */
+    virtual void onBackupHops() {}
+
    protected:
     Notifiee() {}
     virtual ~Notifiee() {}
@@ -56,14 +64,28 @@ class OSPFTopology : public Fwk::PtrInterface<OSPFTopology> {
   OSPFNode::Ptr node(const RouterID& router_id);
   OSPFNode::PtrConst node(const RouterID& router_id) const;
 
+  /* Neighbor of the root node through which ROUTER_ID is reached, as of
+     the last spanning tree computation. Constant time. */
   OSPFNode::Ptr nextHop(const RouterID& router_id);
   OSPFNode::PtrConst nextHop(const RouterID& router_id) const;
 
   Notifiee::PtrConst notifiee() const { return notifiee_; }
   Notifiee::Ptr notifiee() { return notifiee_; }
 
+  /* Scheduling policy and statistics of spanning tree computations. */
+  OSPFSPFThrottle::PtrConst spfThrottle() const { return spf_throttle_; }
+  OSPFSPFThrottle::Ptr spfThrottle() { return spf_throttle_; }
+
   size_t nodes() const { return nodes_.size() + 1; } /* +1 for root node. */
 
+  /* RouterIDs of the nodes whose upstream node, distance, equal-cost first
+     hops, backup hop, or set of links changed in the last spanning tree
+     computation, including nodes that were removed from the topology.
+     Backup hops are computed last; nodes whose backup hop changed are added
+     after onDirtyCleared() has been signaled. Valid until the next call to
+     onUpdate(). */
+  const std::vector<RouterID>& changedNodes() const { return changed_nodes_; }
+
   /* String representation. */
   string str() const;
 
@@ -77,16 +99,26 @@ class OSPFTopology : public Fwk::PtrInterface<OSPFTopology> {
 
   /* Iterators. */
 
-  /* Iterators do not include root node. */
+  /* Iterators do not include root node. Nodes are visited in no particular
+     order; adding or removing nodes invalidates iterators. */
   iterator nodesBegin() { return nodes_.begin(); }
   iterator nodesEnd() { return nodes_.end(); }
   const_iterator nodesBegin() const { return nodes_.begin(); }
   const_iterator nodesEnd() const { return nodes_.end(); }
 
   /* Signals. */
-  /* onUpdate signal: Recomputes shortest-path spanning tree if dirty.*/
+  /* onUpdate signal: Recomputes shortest-path spanning tree if dirty. Only
+     the part of the tree affected by link changes since the last update is
+     recomputed, unless nodes have been removed from the topology. Backup
+     hops are then recomputed for the nodes whose distance from the root or
+     from any of its neighbors changed. */
   void onUpdate();
 
+  /* onTick signal: Recomputes the spanning tree if it is dirty and the SPF
+     throttle allows a computation at time NOW. Changes that arrive in
+     bursts are thereby batched into a single computation. */
+  void onTick(const Milliseconds& now);
+
  private:
   explicit OSPFTopology(OSPFNode::Ptr root_node);
 
@@ -114,27 +146,125 @@ class OSPFTopology : public Fwk::PtrInterface<OSPFTopology> {
     void operator=(const NodeReactor&);
   };
 
+  /* Links that changed, as pairs of their endpoints. */
+  typedef std::vector<std::pair<OSPFNode::Ptr,OSPFNode::Ptr> > LinkChanges;
+
+  /* Shortest-path tree rooted at a neighbor of the root node, for loop-free
+     alternates. */
+  struct NeighborTree {
+    uint32_t source;
+    std::vector<uint32_t> dist;
+    std::vector<uint32_t> prev;
+  };
+
   /* Private member functions. */
 
   bool dirty() const { return dirty_; }
   void dirtyIs(bool status);
 
-  void compute_optimal_spanning_tree();
+  /* Records a change to a link of NODE that leads to NEIGHBOR. */
+  void link_change_new(OSPFNode::Ptr node, OSPFNode::Ptr neighbor, bool added);
 
-  static OSPFNode::Ptr min_dist_node(const Fwk::Map<RouterID,OSPFNode>& map);
+  void compute_optimal_spanning_tree();
+  void compute_incremental_spanning_tree();
+
+  /* Helpers for compute_optimal_spanning_tree(). */
+  void spf_index_nodes();
+  void spf_build_adjacency();
+
+  /* Helpers for compute_incremental_spanning_tree(). */
+  uint32_t spf_index(OSPFNode* node) const;
+  void spf_collect_subtrees(const std::vector<uint32_t>& prev,
+                            const std::vector<uint32_t>& roots,
+                            std::vector<uint32_t>& members);
+  void spf_relax(uint32_t from, uint32_t to, uint32_t cost);
+  uint32_t spf_first_hop(uint32_t from, uint32_t to) const;
+  void spf_update_first_hops();
+  void spf_first_hops_seed(uint32_t x);
+
+  /* Helpers for both computations. */
+  void spf_first_hops_compute(uint32_t x, std::vector<uint32_t>& hops) const;
+  void spf_first_hops_add(uint32_t y, uint32_t x,
+                          std::vector<uint32_t>& hops) const;
+  static void spf_first_hops_normalize(std::vector<uint32_t>& hops);
+  void spf_write_back(uint32_t x);
+  void spf_touch(uint32_t index);
+
+  /* Helpers for loop-free alternates. */
+  bool spf_backup_hops_compute(bool full, const LinkChanges& links_added,
+                               const LinkChanges& links_deleted);
+  void spf_nbr_tree_build(NeighborTree& tree);
+  void spf_nbr_tree_update(NeighborTree& tree,
+                           const LinkChanges& links_added,
+                           const LinkChanges& links_deleted);
+  void spf_nbr_tree_relax(NeighborTree& tree, uint32_t from, uint32_t to,
+                          uint32_t cost);
+  uint32_t spf_backup_hop(uint32_t x) const;
+  void spf_lfa_touch(uint32_t index);
+
+  static const uint32_t kInvalidIndex = 0xffffffff;
 
   /* Data members. */
 
-  Fwk::Map<RouterID,OSPFNode> nodes_;
+  /* Nodes are stored contiguously and located through a hash index. */
+  Fwk::HashMap<RouterID,OSPFNode> nodes_;
   OSPFNode::Ptr root_node_;
   NodeReactor::Ptr node_reactor_;
 
   /* Singleton notifiee. */
   Notifiee::Ptr notifiee_;
 
+  OSPFSPFThrottle::Ptr spf_throttle_;
+
   /* Dirty bit. */
   bool dirty_;
 
+  /* SPF scratch state; kept across runs to avoid reallocation. Nodes are
+     densely indexed with the root node at index 0, followed by nodes_ in
+     storage order. Adjacency is stored in compressed sparse row form:
+     the neighbors of node i are spf_adj_[spf_adj_offset_[i]] through
+     spf_adj_[spf_adj_offset_[i+1] - 1], and spf_adj_cost_ holds the cost
+     of the link to each of them. spf_first_hop_ holds the index of
+     the root's neighbor on the shortest path to each node, and
+     spf_first_hops_ the sorted indices of the root's neighbors on all
+     equal-cost shortest paths. The adjacency arrays are only rebuilt by a
+     full computation; spf_adj_valid_ is false once links have changed
+     since. */
+  std::vector<OSPFNode*> spf_nodes_;
+  std::vector<uint32_t> spf_adj_offset_;
+  std::vector<uint32_t> spf_adj_;
+  std::vector<uint32_t> spf_adj_cost_;
+  bool spf_adj_valid_;
+  std::vector<uint32_t> spf_dist_;
+  std::vector<uint32_t> spf_prev_;
+  std::vector<uint32_t> spf_first_hop_;
+  std::vector<std::vector<uint32_t> > spf_first_hops_;
+  std::vector<OSPFNode::Ptr> spf_hops_; /* Used by spf_write_back(). */
+  Fwk::IndexedHeap<uint32_t> spf_heap_;
+
+  /* Loop-free alternate state: a shortest-path tree rooted at each
+     reachable neighbor of the root node, in the order of the root's links,
+     updated along with the root's own tree. Nodes whose distance from some
+     neighbor changed are listed in spf_lfa_touched_list_. */
+  std::vector<NeighborTree> spf_nbr_trees_;
+  std::vector<bool> spf_lfa_touched_;
+  std::vector<uint32_t> spf_lfa_touched_list_;
+
+  /* Changes accumulated since the last spanning tree computation. A full
+     computation is required whenever the set of nodes shrinks, since the
+     dense indices above are then no longer valid. */
+  bool spf_full_;
+  std::vector<OSPFNode::Ptr> spf_nodes_added_;
+  LinkChanges spf_links_added_;
+  LinkChanges spf_links_deleted_;
+  std::vector<OSPFNode::Ptr> spf_nodes_relinked_; /* Passive link changes. */
+  std::vector<RouterID> spf_nodes_deleted_;
+
+  /* Result of the last spanning tree computation. */
+  std::vector<bool> spf_touched_;
+  std::vector<uint32_t> spf_touched_list_;
+  std::vector<RouterID> changed_nodes_;
+
   /* Operations disallowed. */
   OSPFTopology(const OSPFTopology&);
   void operator=(const OSPFTopology&);
@@ -17,7 +17,11 @@ class IPPacket;
 class OSPFPacket;
 class OSPFHelloPacket;
 class OSPFLSUAdvPacket;
+class OSPFLSUDeltaPacket;
 class OSPFLSUPacket;
+class OSPFLSRPacket;
+class OSPFFastHelloPacket;
+class OSPFElectionPacket;
 class UnknownPacket;
 
 
@@ -37,6 +41,12 @@ class Packet : public Fwk::PtrInterface<Packet> {
     virtual void operator()(OSPFHelloPacket*, Fwk::Ptr<const Interface>) { }
     virtual void operator()(OSPFLSUAdvPacket*, Fwk::Ptr<const Interface>) {}
     virtual void operator()(OSPFLSUPacket*, Fwk::Ptr<const Interface>) { }
+    virtual void operator()(OSPFLSUDeltaPacket*, Fwk::Ptr<const Interface>) {}
+    virtual void operator()(OSPFLSRPacket*, Fwk::Ptr<const Interface>) { }
+    virtual void operator()(OSPFFastHelloPacket*,
+                            Fwk::Ptr<const Interface>) { }
+    virtual void operator()(OSPFElectionPacket*,
+                            Fwk::Ptr<const Interface>) { }
     virtual void operator()(UnknownPacket*, Fwk::Ptr<const Interface>) { }
 
     virtual ~Functor() { }
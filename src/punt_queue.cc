@@ -0,0 +1,132 @@
+#include "punt_queue.h"
+
+
+/* Default settings of each class: rate (packets per second), burst,
+   weight and queue capacity. Routing protocol packets get the largest share
+   of the control plane; exception traffic, which anyone can generate by
+   sending packets with a low TTL or to unresolved hosts, the smallest. Echo
+   Requests are mostly answered by the data plane, so their rate can be high
+   while their share of the control plane stays small. */
+static const struct {
+  uint32_t rate;
+  uint32_t burst;
+  uint32_t weight;
+  size_t capacity;
+} kDefaults[PuntQueue::kClasses] = {
+  { 1000, 200, 8, 256 },  // kRoutingProtocol
+  {  500, 100, 4, 128 },  // kARP
+  { 1000, 200, 2, 128 },  // kLocal
+  { 1000, 200, 1,  64 },  // kEcho
+  {  100,  20, 1,  64 },  // kException
+};
+
+
+PuntQueue::PuntQueue() : current_(0), served_(0) {
+  for (size_t c = 0; c < kClasses; ++c) {
+    ClassState& state = class_[c];
+    state.bucket = TokenBucket(kDefaults[c].rate, kDefaults[c].burst);
+    state.weight = kDefaults[c].weight;
+    state.capacity = kDefaults[c].capacity;
+  }
+
+  statsDel();
+}
+
+const char*
+PuntQueue::className(Class c) {
+  switch (c) {
+    case kRoutingProtocol:
+      return "routing-protocol";
+    case kARP:
+      return "arp";
+    case kLocal:
+      return "local";
+    case kEcho:
+      return "echo";
+    case kException:
+      return "exception";
+    default:
+      return "unknown";
+  }
+}
+
+size_t
+PuntQueue::packets() const {
+  size_t packets = 0;
+  for (size_t c = 0; c < kClasses; ++c)
+    packets += class_[c].queue.size();
+
+  return packets;
+}
+
+PuntQueue::Entry
+PuntQueue::next() {
+  if (packets() == 0)
+    return Entry();
+
+  // Each class gives up to its weight before the next one is served; empty
+  // classes give up their turn. Since some class has packets, this loop
+  // ends within one round.
+  for (;;) {
+    ClassState& state = class_[current_];
+    if (!state.queue.empty() && served_ < state.weight) {
+      Entry entry = state.queue.front();
+      state.queue.pop_front();
+      ++served_;
+      ++state.dispatched;
+      return entry;
+    }
+
+    current_ = (current_ + 1) % kClasses;
+    served_ = 0;
+  }
+}
+
+void
+PuntQueue::weightIs(Class c, uint32_t weight) {
+  class_[c].weight = (weight == 0) ? 1 : weight;
+}
+
+bool
+PuntQueue::onPacket(Class c, const Entry& entry, const Milliseconds& now) {
+  ClassState& state = class_[c];
+
+  if (!state.bucket.tokenTake(now)) {
+    ++state.policed;
+    return false;
+  }
+
+  if (state.queue.size() >= state.capacity) {
+    ++state.overflows;
+    return false;
+  }
+
+  state.queue.push_back(entry);
+  ++state.enqueued;
+  return true;
+}
+
+bool
+PuntQueue::onAnswer(Class c, const Milliseconds& now) {
+  ClassState& state = class_[c];
+
+  if (!state.bucket.tokenTake(now)) {
+    ++state.policed;
+    return false;
+  }
+
+  ++state.answered;
+  return true;
+}
+
+void
+PuntQueue::statsDel() {
+  for (size_t c = 0; c < kClasses; ++c) {
+    ClassState& state = class_[c];
+    state.enqueued = 0;
+    state.dispatched = 0;
+    state.answered = 0;
+    state.policed = 0;
+    state.overflows = 0;
+  }
+}
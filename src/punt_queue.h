@@ -0,0 +1,179 @@
+#ifndef PUNT_QUEUE_H_W3N8CJ5E
+#define PUNT_QUEUE_H_W3N8CJ5E
+
+#include <deque>
+#include <inttypes.h>
+
+#include "fwk/locked_interface.h"
+#include "fwk/ptr_interface.h"
+
+#include "interface.h"
+#include "packet.h"
+#include "time_types.h"
+#include "token_bucket.h"
+
+
+/* Packets that the data plane hands to the control plane, held until the
+   control plane gets to them. Punted packets are sorted into classes, each
+   with a queue of its own, so that a flood of one kind of traffic cannot
+   starve the others: routing protocol packets are kept apart from ARP, from
+   traffic to the router's own services, from pings of its addresses, and
+   from exception traffic such as packets whose TTL expired or whose next
+   hop is not resolved, and fragments addressed to the router, which it has
+   to reassemble. GRE packets to the router are decapsulated by the data
+   plane and never punted, but GRE fragments are exceptions and are policed
+   like the others, and so are packets routed to a tunnel whose outer
+   headers the data plane cannot build.
+
+   Each class is policed by a token bucket that admits rate() packets per
+   second on average and bursts of up to burst() packets; packets beyond
+   that, or beyond the capacity() of the class's queue, are dropped and
+   counted. Queued packets are handed out by next() in weighted round-robin
+   order: in every round, each class gives up to weight() packets, and
+   classes of higher priority go first.
+
+   Some packets of a class are answered by the data plane itself rather than
+   punted; they are policed by the bucket of their class all the same, and
+   counted by answered() instead of enqueued().
+
+   Thread safety: in a threaded environment, methods of this class must be
+   accessed with lockedIs(true) or by using the ScopedLock. */
+class PuntQueue : public Fwk::PtrInterface<PuntQueue>,
+                  public Fwk::LockedInterface {
+ public:
+  typedef Fwk::Ptr<const PuntQueue> PtrConst;
+  typedef Fwk::Ptr<PuntQueue> Ptr;
+
+  /* Classes of punted packets, in order of priority. */
+  enum Class {
+    kRoutingProtocol = 0,  // OSPF.
+    kARP,
+    kLocal,                // TCP to the router.
+    kEcho,                 // ICMP Echo Requests to the router.
+    kException,            // Everything else the control plane handles.
+    kClasses
+  };
+
+  /* How the control plane is to process a packet: as a packet it received,
+     or as one it has to send out on behalf of the data plane. */
+  enum Direction {
+    kInput,
+    kOutput
+  };
+
+  /* A punted packet. */
+  class Entry {
+   public:
+    Entry() : direction_(kInput) { }
+    Entry(Packet::Ptr pkt, Interface::PtrConst iface, Direction direction)
+        : pkt_(pkt), iface_(iface), direction_(direction) { }
+
+    Packet::Ptr packet() const { return pkt_; }
+    Interface::PtrConst interface() const { return iface_; }
+    Direction direction() const { return direction_; }
+
+   private:
+    Packet::Ptr pkt_;
+    Interface::PtrConst iface_;
+    Direction direction_;
+  };
+
+  static Ptr New() { return new PuntQueue(); }
+
+  static const char* className(Class c);
+
+  /* Accessors. */
+
+  /* Number of packets queued in class C, and in all classes. */
+  size_t packets(Class c) const { return class_[c].queue.size(); }
+  size_t packets() const;
+
+  /* Policer and scheduler settings of class C. */
+  uint32_t rate(Class c) const { return class_[c].bucket.rate(); }
+  uint32_t burst(Class c) const { return class_[c].bucket.burst(); }
+  uint32_t weight(Class c) const { return class_[c].weight; }
+  size_t capacity(Class c) const { return class_[c].capacity; }
+
+  /* Statistics of class C. */
+
+  /* Packets queued. */
+  uint64_t enqueued(Class c) const { return class_[c].enqueued; }
+
+  /* Packets handed out by next(). */
+  uint64_t dispatched(Class c) const { return class_[c].dispatched; }
+
+  /* Packets answered by the data plane without being queued. */
+  uint64_t answered(Class c) const { return class_[c].answered; }
+
+  /* Packets dropped because they exceeded the rate of the class. */
+  uint64_t policed(Class c) const { return class_[c].policed; }
+
+  /* Packets dropped because the queue of the class was full. */
+  uint64_t overflows(Class c) const { return class_[c].overflows; }
+
+  /* Removes and returns the next packet to process. Returns an entry without
+     a packet if no packets are queued. */
+  Entry next();
+
+  /* Mutators. */
+
+  /* Sets the rate of class C, in packets per second; zero disables
+     policing. */
+  void rateIs(Class c, uint32_t rate) { class_[c].bucket.rateIs(rate); }
+  void burstIs(Class c, uint32_t burst) { class_[c].bucket.burstIs(burst); }
+
+  /* Sets the weight of class C; a weight of zero is taken as one. */
+  void weightIs(Class c, uint32_t weight);
+
+  /* Sets the capacity of the queue of class C. Packets already queued
+     beyond it are kept. */
+  void capacityIs(Class c, size_t capacity) { class_[c].capacity = capacity; }
+
+  /* Signals. */
+
+  /* ENTRY, a packet of class C, was punted at time NOW. Returns false if
+     the packet was dropped. */
+  bool onPacket(Class c, const Entry& entry, const Milliseconds& now);
+
+  /* A packet of class C was answered by the data plane at time NOW. Returns
+     false if the packet exceeds the rate of the class, in which case it is
+     to be dropped. */
+  bool onAnswer(Class c, const Milliseconds& now);
+
+  /* Clears the statistics of all classes. */
+  void statsDel();
+
+ protected:
+  PuntQueue();
+
+ private:
+  struct ClassState {
+    std::deque<Entry> queue;
+
+    TokenBucket bucket;
+    uint32_t weight;
+    size_t capacity;
+
+    uint64_t enqueued;
+    uint64_t dispatched;
+    uint64_t answered;
+    uint64_t policed;
+    uint64_t overflows;
+
+    ClassState() : bucket(0, 0) { }
+  };
+
+  /* Data members. */
+  ClassState class_[kClasses];
+
+  /* Class being served in the current round, and the number of packets it
+     has given so far. */
+  size_t current_;
+  uint32_t served_;
+
+  /* Operations disallowed. */
+  PuntQueue(const PuntQueue&);
+  void operator=(const PuntQueue&);
+};
+
+#endif
@@ -42,7 +42,9 @@ RoutingTable::lpm(const IPv4Addr& dest_ip) {
     Entry::Ptr entry = it->second;
 
     // Routes on disabled interfaces are ignored; packets can't go out them.
-    if (!entry->interface()->enabled())
+    // Multipath routes remain usable while any of their next hops is, and
+    // protected routes while their backup is.
+    if (!entry->usable())
       continue;
 
     if (entry->subnet() == (dest_ip & entry->subnetMask())) {
@@ -149,12 +151,31 @@ RoutingTable::clearDynamicEntries() {
   }
 }
 
+void
+RoutingTable::clearStaleEntries() {
+  Fwk::Deque<IPv4Subnet> del_entries;
+
+  const_iterator it = rtable_.begin();
+  for (; it != rtable_.end(); ++it) {
+    if (it->second->stale())
+      del_entries.pushBack(it->first);
+  }
+
+  Fwk::Deque<IPv4Subnet>::const_iterator del_it;
+  for (del_it = del_entries.begin(); del_it != del_entries.end(); ++del_it) {
+    IPv4Subnet key = *del_it;
+    entryDel(key.first, key.second);
+  }
+}
+
 
 // RoutingTable::Entry
 
 RoutingTable::Entry::Entry(Type type)
-    : subnet_((uint32_t)0), subnet_mask_((uint32_t)0), gateway_((uint32_t)0),
-      interface_(NULL), type_(type) {}
+    : subnet_((uint32_t)0), subnet_mask_((uint32_t)0), type_(type),
+      stale_(false) {
+  next_hops_.push_back(NextHop(IPv4Addr::kZero, NULL));
+}
 
 void
 RoutingTable::Entry::subnetIs(const IPv4Addr& dest_ip,
@@ -165,26 +186,90 @@ RoutingTable::Entry::subnetIs(const IPv4Addr& dest_ip,
 
 Interface::PtrConst
 RoutingTable::Entry::interface() const {
-  return interface_;
+  return next_hops_[0].interface();
+}
+
+size_t
+RoutingTable::Entry::enabledNextHops() const {
+  size_t enabled = 0;
+  for (size_t i = 0; i < next_hops_.size(); ++i) {
+    if (next_hops_[i].enabled())
+      ++enabled;
+  }
+
+  return enabled;
+}
+
+bool
+RoutingTable::Entry::usable() const {
+  return enabledNextHops() > 0 || backup_.enabled();
+}
+
+const RoutingTable::Entry::NextHop&
+RoutingTable::Entry::flowNextHop(uint32_t flow_hash) const {
+  if (next_hops_.size() == 1)
+    return activeNextHop();
+
+  // Flows are spread over the enabled next hops only, so that a disabled
+  // interface does not blackhole the flows that hash to it.
+  size_t enabled = enabledNextHops();
+  if (enabled == 0)
+    return backup_.enabled() ? backup_ : next_hops_[0];
+
+  size_t pick = flow_hash % enabled;
+  for (size_t i = 0; i < next_hops_.size(); ++i) {
+    if (next_hops_[i].enabled() && pick-- == 0)
+      return next_hops_[i];
+  }
+
+  return next_hops_[0];
+}
+
+const RoutingTable::Entry::NextHop&
+RoutingTable::Entry::activeNextHop() const {
+  for (size_t i = 0; i < next_hops_.size(); ++i) {
+    if (next_hops_[i].enabled())
+      return next_hops_[i];
+  }
+
+  // Local repair: the backup needs no recomputation of the route.
+  return backup_.enabled() ? backup_ : next_hops_[0];
+}
+
+void
+RoutingTable::Entry::gatewayIs(const IPv4Addr& gateway) {
+  next_hops_[0] = NextHop(gateway, next_hops_[0].interface());
 }
 
 void
 RoutingTable::Entry::interfaceIs(Interface::PtrConst iface) {
-  interface_ = iface;
+  next_hops_[0] = NextHop(next_hops_[0].gateway(), iface);
+}
+
+void
+RoutingTable::Entry::nextHopNew(const IPv4Addr& gateway,
+                                Interface::PtrConst iface) {
+  next_hops_.push_back(NextHop(gateway, iface));
+}
+
+void
+RoutingTable::Entry::backupNextHopIs(const IPv4Addr& gateway,
+                                     Interface::PtrConst iface) {
+  backup_ = NextHop(gateway, iface);
 }
 
 bool
 RoutingTable::Entry::operator==(const Entry& other) const {
-  if (this->interface() != other.interface()) /* Interface ptr equivalence */
-    return false;
-
   if (this->subnet() != other.subnet())
     return false;
 
   if (this->subnetMask() != other.subnetMask())
     return false;
 
-  if (this->gateway() != other.gateway())
+  if (this->next_hops_ != other.next_hops_)
+    return false;
+
+  if (this->backup_ != other.backup_)
     return false;
 
   if (this->type() != other.type())
@@ -199,6 +284,32 @@ RoutingTable::Entry::operator!=(const Entry& other) const {
 }
 
 
+// RoutingTable::Entry::NextHop
+
+RoutingTable::Entry::NextHop::NextHop()
+    : gateway_(IPv4Addr::kZero), interface_(NULL) {}
+
+RoutingTable::Entry::NextHop::NextHop(const IPv4Addr& gateway,
+                                      Interface::PtrConst iface)
+    : gateway_(gateway), interface_(iface) {}
+
+bool
+RoutingTable::Entry::NextHop::enabled() const {
+  return interface_ && interface_->enabled();
+}
+
+bool
+RoutingTable::Entry::NextHop::operator==(const NextHop& other) const {
+  /* Interface ptr equivalence */
+  return interface_ == other.interface_ && gateway_ == other.gateway_;
+}
+
+bool
+RoutingTable::Entry::NextHop::operator!=(const NextHop& other) const {
+  return !(other == *this);
+}
+
+
 // RoutingTable::InterfaceMapReactor
 
 void
@@ -1,6 +1,8 @@
 #ifndef ROUTING_TABLE_H_HE9H7VS9
 #define ROUTING_TABLE_H_HE9H7VS9
 
+#include <vector>
+
 #include "fwk/locked_interface.h"
 #include "fwk/notifier.h"
 #include "fwk/map.h"
@@ -35,6 +37,26 @@ class RoutingTable
       kStatic
     };
 
+    /* Member of the next-hop group of an entry. */
+    class NextHop {
+     public:
+      NextHop();
+      NextHop(const IPv4Addr& gateway, Fwk::Ptr<const Interface> iface);
+
+      IPv4Addr gateway() const { return gateway_; }
+      Fwk::Ptr<const Interface> interface() const { return interface_; }
+
+      /* True if the outgoing interface is enabled. */
+      bool enabled() const;
+
+      bool operator==(const NextHop&) const;
+      bool operator!=(const NextHop&) const;
+
+     private:
+      IPv4Addr gateway_;
+      Fwk::Ptr<const Interface> interface_;
+    };
+
     static Ptr New(Type type=kDynamic) {
       return new Entry(type);
     }
@@ -50,14 +72,58 @@ class RoutingTable
 
     IPv4Addr subnet() const { return subnet_; }
     IPv4Addr subnetMask() const { return subnet_mask_; }
-    IPv4Addr gateway() const { return gateway_; }
-    Fwk::Ptr<const Interface> interface() const;
     Type type() const { return type_; }
 
+    /* Every entry has at least one next hop. gateway() and interface()
+       refer to the first one, the primary next hop; equal-cost multipath
+       entries carry additional next hops, added with nextHopNew(). */
+    IPv4Addr gateway() const { return next_hops_[0].gateway(); }
+    Fwk::Ptr<const Interface> interface() const;
+
+    size_t nextHops() const { return next_hops_.size(); }
+    const NextHop& nextHop(size_t index) const { return next_hops_[index]; }
+
+    /* Number of next hops whose interface is enabled. */
+    size_t enabledNextHops() const;
+
+    /* Loop-free alternate next hop, computed along with the route. It takes
+       over as soon as no interface of the next-hop group is enabled, without
+       waiting for the route to be recomputed. The backup's interface is NULL
+       if the entry has none. */
+    const NextHop& backupNextHop() const { return backup_; }
+
+    /* True if packets can leave through a next hop or the backup. */
+    bool usable() const;
+
+    /* Next hop for the flow identified by FLOW_HASH (see
+       IPPacket::flowHash()). Packets of the same flow always take the same
+       next hop, as long as the set of enabled next hops does not change.
+       Falls back to the backup next hop if no interface of the group is
+       enabled, and to the primary next hop if the backup is not either. */
+    const NextHop& flowNextHop(uint32_t flow_hash) const;
+
+    /* Next hop used when flows are not told apart, as in the hardware
+       table: the first enabled next hop of the group, with the same
+       fallbacks as flowNextHop(). */
+    const NextHop& activeNextHop() const;
+
+    /* True if the entry was restored from a snapshot after a restart (see
+       Snapshot) and has not been confirmed by a routing protocol since.
+       Stale entries forward packets like any other until they are replaced
+       by a fresh entry for the same subnet or removed. */
+    bool stale() const { return stale_; }
+    void staleIs(bool status) { stale_ = status; }
+
     void subnetIs(const IPv4Addr& dest, const IPv4Addr& subnet_mask);
-    void gatewayIs(const IPv4Addr& gateway) { gateway_ = gateway; }
+    void gatewayIs(const IPv4Addr& gateway);
     void interfaceIs(Fwk::Ptr<const Interface> iface);
 
+    /* Adds a next hop to the group. */
+    void nextHopNew(const IPv4Addr& gateway, Fwk::Ptr<const Interface> iface);
+
+    void backupNextHopIs(const IPv4Addr& gateway,
+                         Fwk::Ptr<const Interface> iface);
+
     /* Comparison operators. */
     bool operator==(const Entry&) const;
     bool operator!=(const Entry&) const;
@@ -68,9 +134,10 @@ class RoutingTable
    private:
     IPv4Addr subnet_;
     IPv4Addr subnet_mask_;
-    IPv4Addr gateway_;
-    Fwk::Ptr<const Interface> interface_;
+    std::vector<NextHop> next_hops_;
+    NextHop backup_;
     Type type_;
+    bool stale_;
 
     /* Operations disallowed */
     Entry(const Entry&);
@@ -105,6 +172,9 @@ class RoutingTable
      Entry::kDynamic in the routing table. */
   void clearDynamicEntries();
 
+  /* Calls entryDel on all stale entries in the routing table. */
+  void clearStaleEntries();
+
   /* Iterators. */
   iterator entriesBegin() { return rtable_.begin(); }
   iterator entriesEnd() { return rtable_.end(); }
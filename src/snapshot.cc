@@ -0,0 +1,649 @@
+#include "snapshot.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "fwk/scoped_lock.h"
+
+#include "interface.h"
+#include "ospf_area.h"
+#include "ospf_constants.h"
+#include "ospf_link.h"
+#include "ospf_node.h"
+#include "ospf_topology.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+
+const uint32_t Snapshot::kMagic = 0x53504e53;  /* "SPNS" */
+const uint16_t Snapshot::kVersion = 1;
+const time_t Snapshot::kMaxAge = 300;
+
+
+/* File format, version 1:
+
+     header       magic (32), version (16), reserved (16), time written
+                  (32), RouterID (32), and the number of interfaces,
+                  routes, ARP entries and areas (32 each)
+     interface    name length (16), name
+     route        subnet (32), mask (32), next hops (16), backup (16: 0 or
+                  1), then a next hop record for each next hop and the
+                  backup
+     next hop     gateway (32), interface index (32)
+     ARP entry    IP address (32), MAC address (48), reserved (16)
+     area         AreaID (32), LSU sequence number (32), links (32), then
+                  a link record for each link
+     link         RouterID (32), neighbor RouterID (32; OSPF::
+                  kPassiveEndpointID for passive links), subnet (32), mask
+                  (32), cost (16), flags (16)
+
+   Each active link is recorded once, by the endpoint with the lower
+   RouterID; links of this router come from its own HELLO protocol and are
+   not recorded. */
+
+namespace {
+
+const size_t kHeaderSize = 32;
+
+/* Link flags. */
+const uint16_t kLinkSummary = 0x1;
+
+void
+put16(string& buf, uint16_t value) {
+  value = htons(value);
+  buf.append((const char*)&value, sizeof(value));
+}
+
+void
+put32(string& buf, uint32_t value) {
+  value = htonl(value);
+  buf.append((const char*)&value, sizeof(value));
+}
+
+/* Bounds-checked sequential reads from a snapshot file. */
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t len)
+      : data_(data), len_(len), offset_(0) {}
+
+  bool get16(uint16_t& value) {
+    if (len_ - offset_ < sizeof(value))
+      return false;
+    memcpy(&value, data_ + offset_, sizeof(value));
+    value = ntohs(value);
+    offset_ += sizeof(value);
+    return true;
+  }
+
+  bool get32(uint32_t& value) {
+    if (len_ - offset_ < sizeof(value))
+      return false;
+    memcpy(&value, data_ + offset_, sizeof(value));
+    value = ntohl(value);
+    offset_ += sizeof(value);
+    return true;
+  }
+
+  /* Points DATA to the next LEN bytes. */
+  bool get(const uint8_t*& data, size_t len) {
+    if (len_ - offset_ < len)
+      return false;
+    data = data_ + offset_;
+    offset_ += len;
+    return true;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t len_;
+  size_t offset_;
+};
+
+struct NextHopRecord {
+  IPv4Addr gateway;
+  uint32_t iface;
+};
+
+struct RouteRecord {
+  IPv4Addr subnet;
+  IPv4Addr mask;
+  vector<NextHopRecord> next_hops;
+  vector<NextHopRecord> backup; /* Empty or one next hop. */
+};
+
+struct ARPRecord {
+  IPv4Addr ip;
+  EthernetAddr eth;
+};
+
+struct LinkRecord {
+  RouterID node_id;
+  RouterID neighbor_id;
+  IPv4Addr subnet;
+  IPv4Addr mask;
+  uint16_t cost;
+  uint16_t flags;
+};
+
+struct AreaRecord {
+  AreaID area_id;
+  uint32_t seqno;
+  vector<LinkRecord> links;
+};
+
+void
+next_hop_put(string& buf, const RoutingTable::Entry::NextHop& next_hop,
+             vector<string>& ifaces, map<string,uint32_t>& iface_index) {
+  const string& name = next_hop.interface()->name();
+  map<string,uint32_t>::iterator it = iface_index.find(name);
+  if (it == iface_index.end()) {
+    it = iface_index.insert(std::make_pair(name, ifaces.size())).first;
+    ifaces.push_back(name);
+  }
+
+  put32(buf, next_hop.gateway().value());
+  put32(buf, it->second);
+}
+
+bool
+next_hops_get(Reader& reader, size_t count, size_t iface_count,
+              vector<NextHopRecord>& next_hops) {
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t gateway;
+    NextHopRecord next_hop;
+    if (!reader.get32(gateway) || !reader.get32(next_hop.iface) ||
+        next_hop.iface >= iface_count) {
+      return false;
+    }
+
+    next_hop.gateway = gateway;
+    next_hops.push_back(next_hop);
+  }
+
+  return true;
+}
+
+/* Node ROUTER_ID of TOPOLOGY; it is added if necessary. */
+OSPFNode::Ptr
+topology_node(OSPFTopology::Ptr topology, const RouterID& router_id) {
+  OSPFNode::Ptr node = topology->node(router_id);
+  if (node == NULL) {
+    node = OSPFNode::New(router_id);
+    topology->nodeIs(node);
+  }
+
+  return node;
+}
+
+}  // namespace
+
+
+struct Snapshot::Contents {
+  time_t written;
+  RouterID router_id;
+  vector<string> ifaces;
+  vector<RouteRecord> routes;
+  vector<ARPRecord> arp_entries;
+  vector<AreaRecord> areas;
+
+  /* Reads the snapshot in READER. Returns false if it is truncated or
+     otherwise malformed. */
+  bool parse(Reader& reader);
+};
+
+
+Snapshot::Snapshot(const string& path,
+                   RoutingTable::Ptr rtable,
+                   ARPCache::Ptr arp_cache,
+                   OSPFRouter::Ptr ospf_router,
+                   InterfaceMap::Ptr iface_map)
+    : path_(path),
+      rtable_(rtable),
+      arp_cache_(arp_cache),
+      ospf_router_(ospf_router),
+      iface_map_(iface_map),
+      routes_restored_(0),
+      arp_entries_restored_(0),
+      links_restored_(0),
+      log_(Fwk::Log::LogNew("Snapshot")) {}
+
+bool
+Snapshot::write() {
+  vector<string> ifaces;
+  string routes_buf;
+  string arp_buf;
+  string areas_buf;
+  size_t routes = routes_append(routes_buf, ifaces);
+  size_t arp_entries = arp_entries_append(arp_buf);
+  size_t areas = areas_append(areas_buf);
+
+  string buf;
+  put32(buf, kMagic);
+  put16(buf, kVersion);
+  put16(buf, 0);
+  put32(buf, time(NULL));
+  put32(buf, ospf_router_->routerID().value());
+  put32(buf, ifaces.size());
+  put32(buf, routes);
+  put32(buf, arp_entries);
+  put32(buf, areas);
+
+  for (size_t i = 0; i < ifaces.size(); ++i) {
+    put16(buf, ifaces[i].size());
+    buf.append(ifaces[i]);
+  }
+
+  buf.append(routes_buf);
+  buf.append(arp_buf);
+  buf.append(areas_buf);
+
+  /* The previous snapshot is only replaced once the new one is complete. */
+  string tmp_path = path_ + ".tmp";
+  FILE* file = fopen(tmp_path.c_str(), "wb");
+  if (file == NULL) {
+    WLOG << "Cannot write snapshot " << tmp_path << ": " << strerror(errno);
+    return false;
+  }
+
+  bool status = fwrite(buf.data(), 1, buf.size(), file) == buf.size() &&
+                fflush(file) == 0 && fsync(fileno(file)) == 0;
+  status = (fclose(file) == 0) && status;
+  if (!status || rename(tmp_path.c_str(), path_.c_str()) < 0) {
+    WLOG << "Cannot write snapshot " << path_ << ": " << strerror(errno);
+    unlink(tmp_path.c_str());
+    return false;
+  }
+
+  DLOG << "Wrote snapshot " << path_ << " (" << routes << " routes, "
+       << arp_entries << " ARP entries, " << areas << " areas)";
+  return true;
+}
+
+bool
+Snapshot::load() {
+  routes_restored_ = 0;
+  arp_entries_restored_ = 0;
+  links_restored_ = 0;
+
+  int fd = open(path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno != ENOENT)
+      WLOG << "Cannot open snapshot " << path_ << ": " << strerror(errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < kHeaderSize) {
+    WLOG << "Ignoring snapshot " << path_ << ": no header";
+    close(fd);
+    return false;
+  }
+
+  size_t len = st.st_size;
+  void* data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    WLOG << "Cannot map snapshot " << path_ << ": " << strerror(errno);
+    return false;
+  }
+
+  /* The snapshot is parsed completely before anything is restored. */
+  Reader reader((const uint8_t*)data, len);
+  Contents contents;
+  bool valid = contents.parse(reader);
+  munmap(data, len);
+
+  if (!valid) {
+    WLOG << "Ignoring snapshot " << path_ << ": unknown format or truncated";
+    return false;
+  }
+
+  if (contents.router_id != ospf_router_->routerID()) {
+    WLOG << "Ignoring snapshot " << path_ << ": written by router "
+         << contents.router_id;
+    return false;
+  }
+
+  time_t age = time(NULL) - contents.written;
+  if (age > kMaxAge) {
+    ILOG << "Ignoring snapshot " << path_ << ": written " << age
+         << " seconds ago";
+    return false;
+  }
+
+  routes_restore(contents);
+  arp_entries_restore(contents);
+  areas_restore(contents);
+
+  ILOG << "Restored snapshot " << path_ << " (" << routes_restored_
+       << " routes, " << arp_entries_restored_ << " ARP entries, "
+       << links_restored_ << " links)";
+  return true;
+}
+
+/* Snapshot private member functions. */
+
+size_t
+Snapshot::routes_append(string& buf, vector<string>& ifaces) {
+  map<string,uint32_t> iface_index;
+  size_t count = 0;
+
+  Fwk::ScopedLock<RoutingTable> lock(rtable_);
+  RoutingTable::const_iterator it;
+  for (it = rtable_->entriesBegin(); it != rtable_->entriesEnd(); ++it) {
+    RoutingTable::Entry::PtrConst entry = it->second;
+
+    /* Static routes are read from the rtable file on startup. */
+    if (entry->type() != RoutingTable::Entry::kDynamic ||
+        entry->interface() == NULL) {
+      continue;
+    }
+
+    const RoutingTable::Entry::NextHop& backup = entry->backupNextHop();
+    put32(buf, entry->subnet().value());
+    put32(buf, entry->subnetMask().value());
+    put16(buf, entry->nextHops());
+    put16(buf, backup.interface() ? 1 : 0);
+
+    for (size_t i = 0; i < entry->nextHops(); ++i)
+      next_hop_put(buf, entry->nextHop(i), ifaces, iface_index);
+    if (backup.interface())
+      next_hop_put(buf, backup, ifaces, iface_index);
+
+    ++count;
+  }
+
+  return count;
+}
+
+size_t
+Snapshot::arp_entries_append(string& buf) {
+  size_t count = 0;
+
+  Fwk::ScopedLock<ARPCache> lock(arp_cache_);
+  for (ARPCache::const_iterator it = arp_cache_->begin();
+       it != arp_cache_->end(); ++it) {
+    ARPCache::Entry::PtrConst entry = it->second;
+    if (entry->type() != ARPCache::Entry::kDynamic)
+      continue;
+
+    put32(buf, entry->ipAddr().value());
+    buf.append((const char*)entry->ethernetAddr().data(),
+               EthernetAddr::kAddrLen);
+    put16(buf, 0);
+    ++count;
+  }
+
+  return count;
+}
+
+size_t
+Snapshot::areas_append(string& buf) {
+  const RouterID& router_id = ospf_router_->routerID();
+  size_t count = 0;
+
+  OSPFRouter::const_area_iter ar_it;
+  for (ar_it = ospf_router_->areasBegin(); ar_it != ospf_router_->areasEnd();
+       ++ar_it) {
+    OSPFArea::PtrConst area = ar_it->second;
+    OSPFTopology::PtrConst topology = area->topology();
+
+    string links_buf;
+    size_t links = 0;
+    OSPFTopology::const_iterator it;
+    for (it = topology->nodesBegin(); it != topology->nodesEnd(); ++it) {
+      OSPFNode::PtrConst node = it->second;
+      if (node->routerID() == router_id)
+        continue;
+
+      for (OSPFNode::const_lna_iter ln_it = node->activeLinksBegin();
+           ln_it != node->activeLinksEnd(); ++ln_it) {
+        OSPFLink::PtrConst link = ln_it->second;
+        RouterID neighbor_id = link->nodeRouterID();
+        if (neighbor_id == router_id || neighbor_id < node->routerID())
+          continue;
+
+        put32(links_buf, node->routerID().value());
+        put32(links_buf, neighbor_id.value());
+        put32(links_buf, link->subnet().value());
+        put32(links_buf, link->subnetMask().value());
+        put16(links_buf, link->cost());
+        put16(links_buf, link->summary() ? kLinkSummary : 0);
+        ++links;
+      }
+
+      for (OSPFNode::const_lnp_iter ln_it = node->passiveLinksBegin();
+           ln_it != node->passiveLinksEnd(); ++ln_it) {
+        OSPFLink::PtrConst link = ln_it->second;
+        put32(links_buf, node->routerID().value());
+        put32(links_buf, OSPF::kPassiveEndpointID.value());
+        put32(links_buf, link->subnet().value());
+        put32(links_buf, link->subnetMask().value());
+        put16(links_buf, link->cost());
+        put16(links_buf, link->summary() ? kLinkSummary : 0);
+        ++links;
+      }
+    }
+
+    put32(buf, area->areaID());
+    put32(buf, ospf_router_->lsuSeqno(area->areaID()));
+    put32(buf, links);
+    buf.append(links_buf);
+    ++count;
+  }
+
+  return count;
+}
+
+void
+Snapshot::routes_restore(const Contents& contents) {
+  /* Interfaces are looked up by name; indices of interfaces that no longer
+     exist map to NULL. */
+  vector<Interface::Ptr> ifaces;
+  {
+    Fwk::ScopedLock<InterfaceMap> lock(iface_map_);
+    for (size_t i = 0; i < contents.ifaces.size(); ++i)
+      ifaces.push_back(iface_map_->interface(contents.ifaces[i]));
+  }
+
+  Fwk::ScopedLock<RoutingTable> lock(rtable_);
+  vector<RouteRecord>::const_iterator it;
+  for (it = contents.routes.begin(); it != contents.routes.end(); ++it) {
+    const RouteRecord& route = *it;
+    Interface::Ptr iface = ifaces[route.next_hops[0].iface];
+
+    /* Routes that are already known are fresher than the snapshot. */
+    if (iface == NULL || rtable_->entry(route.subnet, route.mask))
+      continue;
+
+    RoutingTable::Entry::Ptr entry = RoutingTable::Entry::New();
+    entry->subnetIs(route.subnet, route.mask);
+    entry->gatewayIs(route.next_hops[0].gateway);
+    entry->interfaceIs(iface);
+    for (size_t i = 1; i < route.next_hops.size(); ++i) {
+      iface = ifaces[route.next_hops[i].iface];
+      if (iface)
+        entry->nextHopNew(route.next_hops[i].gateway, iface);
+    }
+
+    if (!route.backup.empty() && ifaces[route.backup[0].iface]) {
+      entry->backupNextHopIs(route.backup[0].gateway,
+                             ifaces[route.backup[0].iface]);
+    }
+
+    entry->staleIs(true);
+    rtable_->entryIs(entry);
+    ++routes_restored_;
+  }
+}
+
+void
+Snapshot::arp_entries_restore(const Contents& contents) {
+  Fwk::ScopedLock<ARPCache> lock(arp_cache_);
+  vector<ARPRecord>::const_iterator it;
+  for (it = contents.arp_entries.begin(); it != contents.arp_entries.end();
+       ++it) {
+    if (arp_cache_->entry(it->ip))
+      continue;
+
+    ARPCache::Entry::Ptr entry = ARPCache::Entry::New(it->ip, it->eth);
+    entry->typeIs(ARPCache::Entry::kDynamic);
+    entry->staleIs(true);
+    arp_cache_->entryIs(entry);
+    ++arp_entries_restored_;
+  }
+}
+
+void
+Snapshot::areas_restore(const Contents& contents) {
+  const RouterID& router_id = ospf_router_->routerID();
+
+  vector<AreaRecord>::const_iterator it;
+  for (it = contents.areas.begin(); it != contents.areas.end(); ++it) {
+    OSPFArea::Ptr area = ospf_router_->area(it->area_id);
+    if (area == NULL)
+      continue;
+
+    if (it->seqno > ospf_router_->lsuSeqno(it->area_id))
+      ospf_router_->lsuSeqnoIs(it->area_id, it->seqno);
+
+    /* Links are committed right away: both of their endpoints advertised
+       them before the restart. */
+    OSPFTopology::Ptr topology = area->topology();
+    vector<LinkRecord>::const_iterator ln_it;
+    for (ln_it = it->links.begin(); ln_it != it->links.end(); ++ln_it) {
+      const LinkRecord& record = *ln_it;
+      if (record.node_id == router_id || record.neighbor_id == router_id)
+        continue;
+
+      OSPFLink::Ptr link;
+      if (record.neighbor_id == OSPF::kPassiveEndpointID) {
+        link = OSPFLink::NewPassive(record.subnet, record.mask);
+      } else {
+        OSPFNode::Ptr neighbor = topology_node(topology, record.neighbor_id);
+        link = OSPFLink::New(neighbor, record.subnet, record.mask);
+      }
+      link->costIs(record.cost);
+      link->summaryIs(record.flags & kLinkSummary);
+
+      topology_node(topology, record.node_id)->linkIs(link);
+      ++links_restored_;
+    }
+  }
+}
+
+/* Snapshot::Contents. */
+
+bool
+Snapshot::Contents::parse(Reader& reader) {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t written_time;
+  uint32_t rid;
+  uint32_t iface_count;
+  uint32_t route_count;
+  uint32_t arp_count;
+  uint32_t area_count;
+  if (!reader.get32(magic) || magic != kMagic ||
+      !reader.get16(version) || version != kVersion ||
+      !reader.get16(reserved) || !reader.get32(written_time) ||
+      !reader.get32(rid) || !reader.get32(iface_count) ||
+      !reader.get32(route_count) || !reader.get32(arp_count) ||
+      !reader.get32(area_count)) {
+    return false;
+  }
+
+  written = written_time;
+  router_id = rid;
+
+  for (uint32_t i = 0; i < iface_count; ++i) {
+    uint16_t name_len;
+    const uint8_t* name;
+    if (!reader.get16(name_len) || !reader.get(name, name_len))
+      return false;
+
+    ifaces.push_back(string((const char*)name, name_len));
+  }
+
+  for (uint32_t i = 0; i < route_count; ++i) {
+    uint32_t subnet;
+    uint32_t mask;
+    uint16_t next_hops;
+    uint16_t backup;
+    if (!reader.get32(subnet) || !reader.get32(mask) ||
+        !reader.get16(next_hops) || next_hops == 0 ||
+        !reader.get16(backup) || backup > 1) {
+      return false;
+    }
+
+    RouteRecord route;
+    route.subnet = subnet;
+    route.mask = mask;
+    if (!next_hops_get(reader, next_hops, ifaces.size(), route.next_hops) ||
+        !next_hops_get(reader, backup, ifaces.size(), route.backup)) {
+      return false;
+    }
+
+    routes.push_back(route);
+  }
+
+  for (uint32_t i = 0; i < arp_count; ++i) {
+    uint32_t ip;
+    const uint8_t* eth;
+    if (!reader.get32(ip) || !reader.get(eth, EthernetAddr::kAddrLen) ||
+        !reader.get16(reserved)) {
+      return false;
+    }
+
+    ARPRecord entry;
+    entry.ip = ip;
+    entry.eth = EthernetAddr(eth);
+    arp_entries.push_back(entry);
+  }
+
+  for (uint32_t i = 0; i < area_count; ++i) {
+    uint32_t area_id;
+    uint32_t link_count;
+    AreaRecord area;
+    if (!reader.get32(area_id) || !reader.get32(area.seqno) ||
+        !reader.get32(link_count)) {
+      return false;
+    }
+
+    area.area_id = area_id;
+    for (uint32_t j = 0; j < link_count; ++j) {
+      uint32_t node_id;
+      uint32_t neighbor_id;
+      uint32_t subnet;
+      uint32_t mask;
+      LinkRecord link;
+      if (!reader.get32(node_id) || !reader.get32(neighbor_id) ||
+          !reader.get32(subnet) || !reader.get32(mask) ||
+          !reader.get16(link.cost) || !reader.get16(link.flags)) {
+        return false;
+      }
+
+      link.node_id = node_id;
+      link.neighbor_id = neighbor_id;
+      link.subnet = subnet;
+      link.mask = mask;
+      area.links.push_back(link);
+    }
+
+    areas.push_back(area);
+  }
+
+  return true;
+}
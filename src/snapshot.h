@@ -0,0 +1,116 @@
+#ifndef SNAPSHOT_H_R8TK2QWM
+#define SNAPSHOT_H_R8TK2QWM
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "fwk/log.h"
+#include "fwk/ptr_interface.h"
+
+#include "arp_cache.h"
+#include "interface_map.h"
+#include "ospf_router.h"
+#include "routing_table.h"
+
+
+/* Checkpoint of the router's forwarding state, used to resume forwarding
+   right away after a restart instead of waiting for OSPF and ARP to
+   converge again. A snapshot holds the dynamic entries of the routing
+   table and of the ARP cache, the link-state database of every area and
+   the sequence numbers of the router's own link-state updates.
+
+   Restored routes and ARP entries are marked stale (see
+   RoutingTable::Entry::stale()) and forward packets until fresh protocol
+   state replaces them: routes computed by OSPF replace stale routes to the
+   same subnets, and ARP packets confirm stale mappings. Routes that are
+   still stale after a grace period are removed by SnapshotDaemon; stale
+   ARP entries time out like any other. Restored links are not confirmed
+   either, and time out unless their routers flood them again.
+
+   The file starts with a header that carries kMagic and kVersion; files
+   of another format are ignored. All fields are in network byte order.
+   Snapshots are written to a temporary file that then replaces the
+   previous snapshot, so that a crash while writing leaves the previous
+   one intact, and are read through a read-only memory mapping. */
+class Snapshot : public Fwk::PtrInterface<Snapshot> {
+ public:
+  typedef Fwk::Ptr<const Snapshot> PtrConst;
+  typedef Fwk::Ptr<Snapshot> Ptr;
+
+  static const uint32_t kMagic;
+  static const uint16_t kVersion;
+
+  /* Snapshots written longer ago than this, in seconds, are not restored:
+     the network has likely changed too much for them to be of use. */
+  static const time_t kMaxAge;
+
+  static Ptr New(const std::string& path,
+                 RoutingTable::Ptr rtable,
+                 ARPCache::Ptr arp_cache,
+                 OSPFRouter::Ptr ospf_router,
+                 InterfaceMap::Ptr iface_map) {
+    return new Snapshot(path, rtable, arp_cache, ospf_router, iface_map);
+  }
+
+  /* Accessors. */
+
+  const std::string& path() const { return path_; }
+
+  /* Number of routes, ARP entries and links restored by the last call to
+     load(). */
+  size_t routesRestored() const { return routes_restored_; }
+  size_t arpEntriesRestored() const { return arp_entries_restored_; }
+  size_t linksRestored() const { return links_restored_; }
+
+  /* Writes the current state to path(). Returns false if the snapshot
+     could not be written; the previous one is then left in place. Must be
+     called from the thread that processes packets. */
+  bool write();
+
+  /* Restores the state in path(). Returns false if there is no usable
+     snapshot, in which case nothing is restored. Routes to interfaces that
+     no longer exist, and links of areas that the router does not have, are
+     skipped. Must be called from the thread that processes packets, or
+     before it is started. */
+  bool load();
+
+ protected:
+  Snapshot(const std::string& path,
+           RoutingTable::Ptr rtable,
+           ARPCache::Ptr arp_cache,
+           OSPFRouter::Ptr ospf_router,
+           InterfaceMap::Ptr iface_map);
+
+ private:
+  /* Contents of a snapshot file, as read by load(). */
+  struct Contents;
+
+  /* Append the records of a section to BUF and return their number. Next
+     hops refer to their interface by index into IFACES. */
+  size_t routes_append(std::string& buf, std::vector<std::string>& ifaces);
+  size_t arp_entries_append(std::string& buf);
+  size_t areas_append(std::string& buf);
+
+  /* Restore the state in CONTENTS. */
+  void routes_restore(const Contents& contents);
+  void arp_entries_restore(const Contents& contents);
+  void areas_restore(const Contents& contents);
+
+  /* Data members. */
+  const std::string path_;
+  RoutingTable::Ptr rtable_;
+  ARPCache::Ptr arp_cache_;
+  OSPFRouter::Ptr ospf_router_;
+  InterfaceMap::Ptr iface_map_;
+  size_t routes_restored_;
+  size_t arp_entries_restored_;
+  size_t links_restored_;
+  Fwk::Log::Ptr log_;
+
+  /* Operations disallowed. */
+  Snapshot(const Snapshot&);
+  void operator=(const Snapshot&);
+};
+
+#endif
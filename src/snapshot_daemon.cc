@@ -0,0 +1,45 @@
+#include "snapshot_daemon.h"
+
+#include <ctime>
+
+#include "fwk/log.h"
+#include "fwk/scoped_lock.h"
+
+#include "routing_table.h"
+#include "snapshot.h"
+#include "task.h"
+#include "time_types.h"
+
+
+const time_t SnapshotDaemon::kInterval;
+const time_t SnapshotDaemon::kGracePeriod;
+
+
+SnapshotDaemon::SnapshotDaemon(Snapshot::Ptr snapshot,
+                               RoutingTable::Ptr rtable)
+    : Task("SnapshotDaemon"),
+      snapshot_(snapshot),
+      rtable_(rtable),
+      last_write_(time(NULL)),
+      grace_end_(0),
+      log_(Fwk::Log::LogNew("SnapshotDaemon")) {
+  if (snapshot_->routesRestored() > 0)
+    grace_end_ = last_write_ + kGracePeriod;
+}
+
+
+void SnapshotDaemon::timeIs(const TimeEpoch& t) {
+  if (grace_end_ != 0 && t.value() >= grace_end_) {
+    Fwk::ScopedLock<RoutingTable> lock(rtable_);
+    size_t entries = rtable_->entries();
+    rtable_->clearStaleEntries();
+    ILOG << "Grace period over; removed "
+         << entries - rtable_->entries() << " stale routes";
+    grace_end_ = 0;
+  }
+
+  if (t.value() - last_write_ >= kInterval) {
+    snapshot_->write();
+    last_write_ = t.value();
+  }
+}
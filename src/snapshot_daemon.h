@@ -0,0 +1,55 @@
+#ifndef SNAPSHOT_DAEMON_H_
+#define SNAPSHOT_DAEMON_H_
+
+#include <ctime>
+
+#include "fwk/log.h"
+#include "fwk/ptr.h"
+
+#include "routing_table.h"
+#include "snapshot.h"
+#include "task.h"
+
+
+// Writes a snapshot of the router's state every kInterval seconds. Routes
+// restored from a snapshot before the daemon was created are removed if
+// they are still stale kGracePeriod seconds later, by which time OSPF has
+// had time to confirm or replace them.
+class SnapshotDaemon : public Task {
+ public:
+  typedef Fwk::Ptr<const SnapshotDaemon> PtrConst;
+  typedef Fwk::Ptr<SnapshotDaemon> Ptr;
+
+  static Ptr New(Snapshot::Ptr snapshot, RoutingTable::Ptr rtable) {
+    return new SnapshotDaemon(snapshot, rtable);
+  }
+
+  // Interval between snapshots, in seconds.
+  static const time_t kInterval = 30;
+
+  // Time given to OSPF to confirm restored routes, in seconds: two
+  // link-state update timeouts.
+  static const time_t kGracePeriod = 60;
+
+  void timeIs(const TimeEpoch& t);
+
+ protected:
+  SnapshotDaemon(Snapshot::Ptr snapshot, RoutingTable::Ptr rtable);
+
+  Snapshot::Ptr snapshot_;
+  RoutingTable::Ptr rtable_;
+  time_t last_write_;
+
+  // Time at which stale routes are removed; 0 if there are none.
+  time_t grace_end_;
+
+  Fwk::Log::Ptr log_;
+
+ private:
+  // Operations disallowed.
+  SnapshotDaemon(const SnapshotDaemon&);
+  void operator=(const SnapshotDaemon&);
+};
+
+
+#endif
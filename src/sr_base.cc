@@ -134,6 +134,7 @@ int sr_init_low_level_subsystem(int argc, char **argv)
     const char *host = "vrhost";
     const char *user = 0;
     const char *rtable = "rtable";
+    const char *snapshot_file = "";
     const char *itable = CPU_HW_FILENAME;
     const char  *server = "171.67.71.19";
     uint16_t cli_port = 2300;
@@ -161,7 +162,7 @@ int sr_init_low_level_subsystem(int argc, char **argv)
     sr = (struct sr_instance*) malloc(sizeof(struct sr_instance));
     memset(sr, 0x0, sizeof(struct sr_instance));
 
-    while ((c = getopt(argc, argv, "hdna:s:v:p:c:t:r:l:i:u:")) != EOF)
+    while ((c = getopt(argc, argv, "hdna:s:v:p:c:t:r:l:i:u:w:")) != EOF)
     {
         switch (c)
         {
@@ -207,6 +208,9 @@ int sr_init_low_level_subsystem(int argc, char **argv)
             case 'i':
                 itable = optarg;
                 break;
+            case 'w':
+                snapshot_file = optarg;
+                break;
             case 'n':
                 Debug("\nOSPF disabled!\n\n");
                 ospf = 0;
@@ -240,6 +244,7 @@ int sr_init_low_level_subsystem(int argc, char **argv)
     strncpy(sr->auth_key_fn,auth_key_file,64);
 
     strncpy(sr->rtable, rtable, SR_NAMELEN);
+    strncpy(sr->snapshot_file, snapshot_file, SR_NAMELEN);
 #ifdef _CPUMODE_
     sr->topo_id = 0;
     strncpy(sr->vhost,  "cpu",    SR_NAMELEN);
@@ -465,4 +470,5 @@ static void usage(char* argv0)
            " [-p port] [-c cli_port] \n", argv0);
     printf("           [-t topo id] [-r rtable_file] [-l log_file] "
            "[-i interface_file]\n");
+    printf("           [-w snapshot_file]\n");
 } /* -- usage -- */
@@ -61,6 +61,7 @@
 class EthernetPacket;
 class Interface;
 class Router;
+class Snapshot;
 
 
 /* ----------------------------------------------------------------------------
@@ -94,6 +95,7 @@ struct sr_instance
 
     Fwk::Ptr<Router> router;
     Fwk::Ptr<PacketQueue> input_queue;
+    Fwk::Ptr<Snapshot> snapshot; /* NULL unless snapshots are enabled */
     bool quit;
     bool processing_thread_running;
 
@@ -105,6 +107,7 @@ struct sr_instance
     char template_name[30]; /* template name if any */
     char auth_key_fn[SR_NAMELEN]; /* auth key filename */
     char rtable[SR_NAMELEN]; /* filename for routing table          */
+    char snapshot_file[SR_NAMELEN]; /* filename for state snapshot; optional */
     char server[SR_NAMELEN];
     unsigned short topo_id; /* topology id */
     struct sockaddr_in sr_addr; /* address to server */
@@ -251,6 +251,38 @@ int sr_cpu_output(struct sr_instance* const sr /* borrowed */,
 }
 
 
+/*-----------------------------------------------------------------------------
+ * Method: sr_cpu_outputv(..)
+ * Scope: Global
+ *
+ * Writes the packet gathered from the iovcnt segments of iov.
+ * Returns the length of the packet on success, -1 on failure.
+ *---------------------------------------------------------------------------*/
+
+int sr_cpu_outputv(struct sr_instance* const sr /* borrowed */,
+                   const struct iovec* const iov /* borrowed */,
+                   const int iovcnt,
+                   const char* const iface_name /* borrowed */)
+{
+  /* REQUIRES */
+  assert(sr);
+  assert(iov);
+  assert(iface_name);
+
+  Router::Ptr router = sr->router;
+  InterfaceMap::Ptr if_map = router->dataPlane()->interfaceMap();
+  Interface::Ptr iface = if_map->interface(iface_name);
+  if (!iface)
+    return -1;
+
+  int fd = iface->socketDescriptor();
+  if (fd < 0)
+    return -1;
+
+  return writev(fd, iov, iovcnt);
+}
+
+
 /*-----------------------------------------------------------------------------
  * Method: copy_next_field(..)
  * Scope: Local
@@ -14,6 +14,8 @@
 #ifndef SR_CPU_EXTENSIONS_H
 #define SR_CPU_EXTENSIONS_H
 
+#include <sys/uio.h>
+
 #include "sr_base_internal.h"
 
 static const uint16_t CPU_CONTROL_READ  = 0x8804;
@@ -27,5 +29,9 @@ int sr_cpu_output(struct sr_instance* sr /* borrowed */,
                        uint8_t* buf /* borrowed */ ,
                        unsigned int len,
                        const char* iface /* borrowed */);
+int sr_cpu_outputv(struct sr_instance* sr /* borrowed */,
+                   const struct iovec* iov /* borrowed */,
+                   int iovcnt,
+                   const char* iface /* borrowed */);
 
 #endif  /* --  SR_CPU_EXTENSIONS_H -- */
@@ -33,6 +33,7 @@
 #include "arp_cache.h"
 #include "arp_cache_daemon.h"
 #include "arp_queue_daemon.h"
+#include "arp_refresh_daemon.h"
 #include "control_plane.h"
 #include "data_plane.h"
 #include "ethernet_packet.h"
@@ -40,6 +41,7 @@
 #include "interface.h"
 #include "interface_map.h"
 #include "ip_packet.h"
+#include "ip_reassembly_daemon.h"
 #include "lwtcp/lwip/sys.h"
 #include "ospf_daemon.h"
 #include "ospf_router.h"
@@ -49,14 +51,21 @@
 #include "sr_cpu_extension_nf2.h"
 #include "sr_vns.h"
 #include "sr_base_internal.h"
+#include "snapshot.h"
+#include "snapshot_daemon.h"
 #include "sw_data_plane.h"
 #include "task.h"
+#include "time_types.h"
 
 using std::pair;
 using std::string;
 
 static Fwk::Log::Ptr log_;
 
+/* Maximum number of input packets processed before the packets they punted
+   are handed to the control plane. */
+static const size_t kInputBatch = 32;
+
 static void processing_thread(void* _sr);
 static void read_rtable(struct sr_instance* sr);
 
@@ -108,6 +117,7 @@ static void processing_thread(void* _sr) {
   struct timespec last_time;
   struct timespec next_time;
   clock_gettime(CLOCK_REALTIME, &last_time);
+  Milliseconds last_tick = monotonicTimeMs();
 
   pair<EthernetPacket::Ptr, Interface::PtrConst> p;
   while (!sr->quit) {
@@ -120,9 +130,21 @@ static void processing_thread(void* _sr) {
       last_time = next_time;
     }
 
+    // Sub-second clock for tasks that need finer resolution.
+    Milliseconds now = monotonicTimeMs();
+    if (now.value() - last_tick.value() >= TaskManager::kTickInterval) {
+      router->taskManager()->tickIs(now);
+      last_tick = now;
+    }
+
     try {
-      // Bound the waiting time for a packet in the input queue.
-      next_time.tv_sec += 1;
+      // Bound the waiting time for a packet in the input queue by the tick
+      // interval of the task manager.
+      next_time.tv_nsec += TaskManager::kTickInterval * 1000000L;
+      if (next_time.tv_nsec >= 1000000000L) {
+        next_time.tv_sec += 1;
+        next_time.tv_nsec -= 1000000000L;
+      }
       p = sr->input_queue->timedPopFront(next_time);
 
       EthernetPacket::Ptr eth_pkt = p.first;
@@ -131,9 +153,26 @@ static void processing_thread(void* _sr) {
 
       // TODO(ms): bypass dataplane here on _CPUMODE_?
       router->dataPlane()->packetNew(eth_pkt, iface);
+
+      // Packets that are already waiting are processed as a batch, so that
+      // the packets they punt to the control plane are handed to it in the
+      // order of their priority rather than in the order of their arrival.
+      for (size_t i = 1; i < kInputBatch && !sr->input_queue->empty(); ++i) {
+        p = sr->input_queue->popFront();
+        router->dataPlane()->packetNew(p.first, p.second);
+      }
     } catch (Fwk::TimeoutException& e) {
       // Timeout while waiting for a packet in the input queue. Ignore it.
     }
+
+    DataPlane::Ptr dp = router->dataPlane();
+    size_t punted;
+    {
+      PuntQueue::Ptr punt_queue = dp->puntQueue();
+      Fwk::ScopedLock<PuntQueue> lock(punt_queue);
+      punted = punt_queue->packets();
+    }
+    dp->puntedPacketsDispatch(punted);
   }
 
   sr->processing_thread_running = false;
@@ -158,24 +197,52 @@ void sr_integ_hw_setup(struct sr_instance* sr)
   // Read in rtable file, if any.
   read_rtable(sr);
 
+  // Restore the state saved before the last shutdown, if any. Restored
+  // routes and ARP entries are stale until OSPF and ARP confirm them.
+  if (sr->snapshot_file[0] != '\0') {
+    ControlPlane::Ptr cp = router->controlPlane();
+    sr->snapshot = Snapshot::New(sr->snapshot_file, cp->routingTable(),
+                                 cp->arpCache(), cp->ospfRouter(),
+                                 router->dataPlane()->interfaceMap());
+    sr->snapshot->load();
+  }
+
+  // The daemons keep their timers on the task manager's timer wheel.
+  TimerWheel::Ptr wheel = router->taskManager()->timerWheel();
+
   // Create ARP cache daemon and add it to the task manager.
   ARPCacheDaemon::Ptr arp_cache_daemon =
-      ARPCacheDaemon::New(router->controlPlane()->arpCache());
-  arp_cache_daemon->periodIs(1);  // check for stale entries every second
+      ARPCacheDaemon::New(router->controlPlane()->arpCache(), wheel);
   router->taskManager()->taskIs(arp_cache_daemon);
 
   // Create ARP queue daemon and add it to the task manager.
   ARPQueueDaemon::Ptr arp_queue_daemon =
-      ARPQueueDaemon::New(router->controlPlane());
-  arp_queue_daemon->periodIs(1);
+      ARPQueueDaemon::New(router->controlPlane(), wheel);
   router->taskManager()->taskIs(arp_queue_daemon);
 
+  // Create ARP refresh daemon and add it to the task manager.
+  ARPRefreshDaemon::Ptr arp_refresh_daemon =
+      ARPRefreshDaemon::New(router->controlPlane());
+  router->taskManager()->taskIs(arp_refresh_daemon);
+
+  // Create IP reassembly daemon and add it to the task manager.
+  IPReassemblyDaemon::Ptr ip_reassembly_daemon =
+      IPReassemblyDaemon::New(router->controlPlane(), wheel);
+  router->taskManager()->taskIs(ip_reassembly_daemon);
+
   // Create OSPF daemon and add it to the task manager.
   OSPFDaemon::Ptr ospf_daemon =
-    OSPFDaemon::New(router->controlPlane(), router->dataPlane());
-  ospf_daemon->periodIs(1);
+    OSPFDaemon::New(router->controlPlane(), router->dataPlane(), wheel);
   router->taskManager()->taskIs(ospf_daemon);
 
+  // Create snapshot daemon, if enabled, and add it to the task manager.
+  if (sr->snapshot) {
+    RoutingTable::Ptr rtable = router->controlPlane()->routingTable();
+    SnapshotDaemon::Ptr snapshot_daemon =
+        SnapshotDaemon::New(sr->snapshot, rtable);
+    router->taskManager()->taskIs(snapshot_daemon);
+  }
+
   // Start processing thread.
   sr->quit = false;
   sys_thread_new(processing_thread, sr);
@@ -326,6 +393,27 @@ int sr_integ_low_level_output(struct sr_instance* sr /* borrowed */,
 #endif /* _CPUMODE_ */
 }
 
+/*-----------------------------------------------------------------------------
+ * Method: sr_integ_low_level_outputv(..)
+ * Scope: global
+ *
+ * Like sr_integ_low_level_output(..), but the packet is gathered from the
+ * iovcnt segments of iov, so that it need not be contiguous in memory.
+ *
+ *---------------------------------------------------------------------------*/
+
+int sr_integ_low_level_outputv(struct sr_instance* sr /* borrowed */,
+                               const struct iovec* iov /* borrowed */,
+                               int iovcnt,
+                               const char* iface /* borrowed */)
+{
+#ifdef _CPUMODE_
+    return sr_cpu_outputv(sr, iov /*lent*/, iovcnt, iface);
+#else
+    return sr_vns_send_packetv(sr, iov /*lent*/, iovcnt, iface);
+#endif /* _CPUMODE_ */
+}
+
 /*-----------------------------------------------------------------------------
  * Method: sr_integ_destroy(..)
  * Scope: global
@@ -345,6 +433,12 @@ void sr_integ_destroy(struct sr_instance* sr)
   sr->input_queue->clear();
   sr->input_queue = NULL;
 
+  // Save state for the next start.
+  if (sr->snapshot) {
+    sr->snapshot->write();
+    sr->snapshot = NULL;
+  }
+
   // Destroy router.
   sr->router = NULL;
 }
@@ -22,6 +22,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 #include "fwk/log.h"
 #include "sha1.h"
@@ -573,4 +574,83 @@ int sr_vns_send_packet(struct sr_instance* sr /* borrowed */,
     return 0;
 } /* -- sr_send_packet -- */
 
+/*-----------------------------------------------------------------------------
+ * Method: sr_send_packetv(..)
+ * Scope: Global
+ *
+ * Like sr_send_packet(..), but the packet is gathered from the iovcnt
+ * segments of iov. The VNS header is written in front of them with a single
+ * writev, so the packet is not copied unless it is logged.
+ *
+ *---------------------------------------------------------------------------*/
+
+int sr_vns_send_packetv(struct sr_instance* sr /* borrowed */,
+                        const struct iovec* iov /* borrowed */,
+                        int iovcnt,
+                        const char* iface /* borrowed */)
+{
+    c_packet_header sr_hdr;
+    struct iovec* vec;
+    unsigned int len = 0;
+    unsigned int total_len;
+    int i;
+
+    /* REQUIRES */
+    assert(sr);
+    assert(iov);
+    assert(iface);
+
+    for ( i = 0; i < iovcnt; ++i )
+    { len += iov[i].iov_len; }
+    total_len = len + sizeof(c_packet_header);
+
+    if ( len < 14 /* sizeof ethernet header */ )
+    {
+        fprintf(stderr , "** Error: packet is wayy to short \n");
+        return -1;
+    }
+
+    sr_hdr.mLen  = htonl(total_len);
+    sr_hdr.mType = htonl(VNSPACKET);
+    strncpy(sr_hdr.mInterfaceName,iface,16);
+
+    vec = (struct iovec*)malloc((iovcnt + 1) * sizeof(struct iovec));
+    assert(vec);
+    vec[0].iov_base = &sr_hdr;
+    vec[0].iov_len = sizeof(c_packet_header);
+    memcpy(vec + 1, iov, iovcnt * sizeof(struct iovec));
+
+    /* -- log packet -- */
+    if ( sr->logfile )
+    {
+        uint8_t* buf = (uint8_t*)malloc(len);
+        unsigned int off = 0;
+        assert(buf);
+        for ( i = 0; i < iovcnt; ++i )
+        {
+            memcpy(buf + off, iov[i].iov_base, iov[i].iov_len);
+            off += iov[i].iov_len;
+        }
+        sr_log_packet(sr,buf,len);
+        free(buf);
+    }
+
+    if ( pthread_mutex_lock(&(sr->send_lock)) )
+    { assert (0); }
+    if( writev(sr->sockfd, vec, iovcnt + 1) < (signed int)total_len )
+    {
+        fprintf(stderr, "Error writing packet\n");
+        free(vec);
+        if ( pthread_mutex_unlock(&(sr->send_lock)) )
+        { assert (0); }
+        return -1;
+    }
+    if ( pthread_mutex_unlock(&(sr->send_lock)) )
+    { assert (0); }
+
+    free(vec);
+
+    return 0;
+} /* -- sr_send_packetv -- */
+
 #endif /* _CPUMODE_ */
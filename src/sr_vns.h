@@ -28,6 +28,7 @@
 #endif /* _SOLARIS_ */
 
 struct sr_instance;  /* forward declare */
+struct iovec;
 
 void sr_vns_init_log(struct sr_instance* sr, char* logfile);
 
@@ -46,6 +47,12 @@ int  sr_vns_connect_to_server(struct sr_instance*, unsigned short, const char*);
  */
 int  sr_vns_send_packet(struct sr_instance* ,uint8_t* , unsigned int , const char*);
 
+/**
+ * Like sr_vns_send_packet, with the packet gathered from an iovec array.
+ */
+int  sr_vns_send_packetv(struct sr_instance* ,const struct iovec* , int ,
+                         const char*);
+
 #endif /* _CPUMODE */
 
 #endif  /* -- SR_VNS_H -- */
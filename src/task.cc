@@ -2,6 +2,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "fwk/exception.h"
 #include "fwk/named_interface.h"
@@ -9,6 +10,15 @@
 
 using std::map;
 using std::string;
+using std::vector;
+
+
+const int TaskManager::kTickInterval;
+const int TimerWheel::kLevels;
+const int TimerWheel::kSlotBits;
+const int TimerWheel::kSlots;
+const uint32_t TimerWheel::kSlotMask;
+const int8_t Timer::kUnfiled;
 
 
 Task::Task(const string& name) : Fwk::NamedInterface(name) {
@@ -34,6 +44,202 @@ void PeriodicTask::timeIs(const TimeEpoch& t) {
 }
 
 
+Timer::Timer()
+  : prev_(NULL), next_(NULL), level_(kUnfiled), slot_(0), expiry_(0),
+    firing_(false) {
+
+}
+
+
+TimerWheel::TimerWheel(const Milliseconds& now)
+  : timers_(0), now_(now.value()) {
+  for (int level = 0; level < kLevels; ++level)
+    level_timers_[level] = 0;
+}
+
+
+TimerWheel::~TimerWheel() {
+  // Release the references held on armed timers.
+  for (int level = 0; level < kLevels; ++level) {
+    for (int slot = 0; slot < kSlots; ++slot) {
+      while (slots_[level][slot].head != NULL) {
+        Timer* timer = slots_[level][slot].head;
+        unfile(timer);
+        timer->deleteRef();
+      }
+    }
+  }
+}
+
+
+void TimerWheel::timerIs(Timer::Ptr timer, const Milliseconds& expiry) {
+  lockedIs(true);
+
+  if (timer->armed())
+    unfile(timer.ptr());
+  else
+    timer->newRef();
+
+  timer->firing_ = false;
+  timer->expiry_ = expiry.value();
+  file(timer.ptr());
+
+  lockedIs(false);
+}
+
+
+void TimerWheel::timerDel(Timer::Ptr timer) {
+  lockedIs(true);
+
+  timer->firing_ = false;
+  if (timer->armed()) {
+    unfile(timer.ptr());
+    timer->deleteRef();
+  }
+
+  lockedIs(false);
+}
+
+
+void TimerWheel::timeIs(const Milliseconds& t) {
+  vector<Timer::Ptr> expired;
+
+  lockedIs(true);
+  while (now_ < t.value()) {
+    if (timers_ == 0) {
+      now_ = t.value();
+      break;
+    }
+
+    // Skip ahead to the next time at which a timer can fire or move down:
+    // the end of the current slot of the finest level that has timers.
+    int level = 0;
+    while (level_timers_[level] == 0)
+      ++level;
+
+    if (level > 0) {
+      int64_t skip_to = now_ | (((int64_t)1 << (level * kSlotBits)) - 1);
+      if (skip_to >= t.value()) {
+        now_ = t.value();
+        break;
+      }
+
+      now_ = skip_to;
+    }
+
+    ++now_;
+    uint32_t index = now_ & kSlotMask;
+    if (index == 0)
+      cascade(1);
+
+    expire(slots_[0][index], expired);
+  }
+  lockedIs(false);
+
+  // Timers fire without the lock held. A timer that was cancelled or
+  // re-armed after it was taken off the wheel does not fire.
+  for (size_t i = 0; i < expired.size(); ++i) {
+    Timer::Ptr timer = expired[i];
+
+    lockedIs(true);
+    bool fire = timer->firing_;
+    timer->firing_ = false;
+    lockedIs(false);
+
+    if (fire)
+      timer->onExpiry();
+  }
+}
+
+
+// Files TIMER in the finest level whose range covers its expiry. The slot
+// of the current time on level 0 has already been expired, so a timer that
+// is due is filed in the next one.
+void TimerWheel::file(Timer* timer) {
+  int64_t when = timer->expiry_;
+  if (when <= now_)
+    when = now_ + 1;
+
+  int64_t max = now_ + ((int64_t)1 << (kLevels * kSlotBits)) - 1;
+  if (when > max)
+    when = max;
+
+  int level = 0;
+  while (when - now_ >= ((int64_t)1 << ((level + 1) * kSlotBits)))
+    ++level;
+
+  uint32_t index = (when >> (level * kSlotBits)) & kSlotMask;
+  Slot& slot = slots_[level][index];
+
+  timer->level_ = level;
+  timer->slot_ = index;
+  timer->prev_ = slot.tail;
+  timer->next_ = NULL;
+  if (slot.tail != NULL)
+    slot.tail->next_ = timer;
+  else
+    slot.head = timer;
+  slot.tail = timer;
+
+  ++level_timers_[level];
+  ++timers_;
+}
+
+
+void TimerWheel::unfile(Timer* timer) {
+  Slot& slot = slots_[timer->level_][timer->slot_];
+  if (timer->prev_ != NULL)
+    timer->prev_->next_ = timer->next_;
+  else
+    slot.head = timer->next_;
+
+  if (timer->next_ != NULL)
+    timer->next_->prev_ = timer->prev_;
+  else
+    slot.tail = timer->prev_;
+
+  --level_timers_[timer->level_];
+  --timers_;
+
+  timer->prev_ = NULL;
+  timer->next_ = NULL;
+  timer->level_ = Timer::kUnfiled;
+}
+
+
+// Called when the current slot of LEVEL comes around. Its timers are now
+// less than one slot of LEVEL away and are refiled in finer levels. Coarser
+// levels come around when LEVEL wraps.
+void TimerWheel::cascade(int level) {
+  if (level >= kLevels)
+    return;
+
+  uint32_t index = (now_ >> (level * kSlotBits)) & kSlotMask;
+  Slot& slot = slots_[level][index];
+  while (slot.head != NULL) {
+    Timer* timer = slot.head;
+    unfile(timer);
+    file(timer);
+  }
+
+  if (index == 0)
+    cascade(level + 1);
+}
+
+
+// Takes the timers in SLOT off the wheel and appends them to EXPIRED. The
+// wheel's references are handed over to EXPIRED.
+void TimerWheel::expire(Slot& slot, vector<Timer::Ptr>& expired) {
+  while (slot.head != NULL) {
+    Timer* timer = slot.head;
+    unfile(timer);
+    timer->firing_ = true;
+    expired.push_back(timer);
+    timer->deleteRef();
+  }
+}
+
+
 Task::Ptr TaskManager::task(const std::string& name) const {
   TaskMap::const_iterator it = task_map_.find(name);
   return (it != task_map_.end()) ? it->second : NULL;
@@ -59,3 +265,11 @@ void TaskManager::timeIs(const TimeEpoch& t) {
   for (TaskMap::iterator it = task_map_.begin(); it != task_map_.end(); ++it)
     it->second->timeIs(t);
 }
+
+
+void TaskManager::tickIs(const Milliseconds& t) {
+  timer_wheel_->timeIs(t);
+
+  for (TaskMap::iterator it = task_map_.begin(); it != task_map_.end(); ++it)
+    it->second->tickIs(t);
+}
@@ -1,9 +1,12 @@
 #ifndef TASK_H_
 #define TASK_H_
 
+#include <inttypes.h>
 #include <map>
 #include <string>
+#include <vector>
 
+#include "fwk/locked_interface.h"
 #include "fwk/named_interface.h"
 #include "fwk/ptr.h"
 #include "fwk/ptr_interface.h"
@@ -15,7 +18,14 @@ class Task : public Fwk::NamedInterface {
   typedef Fwk::Ptr<const Task> PtrConst;
   typedef Fwk::Ptr<Task> Ptr;
 
-  virtual void timeIs(const TimeEpoch& t) = 0;
+  // Called at most once per second with the current wall-clock time. The
+  // default does nothing.
+  virtual void timeIs(const TimeEpoch& t) { }
+
+  // Called on every tick of the task manager's sub-second clock, with the
+  // current monotonic time. Tasks that need sub-second resolution override
+  // this; the default does nothing.
+  virtual void tickIs(const Milliseconds& t) { }
 
  protected:
   Task(const std::string& name);
@@ -52,6 +62,125 @@ class PeriodicTask : public Task {
 };
 
 
+// A Timer is armed on a TimerWheel and fires once the wheel's clock reaches
+// its expiry time. Derived classes define onExpiry(). A timer fires at most
+// once per arming; periodic timers re-arm themselves from onExpiry(). The
+// wheel keeps a reference to every armed timer.
+class Timer : public Fwk::PtrInterface<Timer> {
+ public:
+  typedef Fwk::Ptr<const Timer> PtrConst;
+  typedef Fwk::Ptr<Timer> Ptr;
+
+  // True if the timer is armed and has not fired yet.
+  bool armed() const { return level_ != kUnfiled; }
+
+  // Time at which the timer fires, if armed.
+  Milliseconds expiry() const { return expiry_; }
+
+ protected:
+  Timer();
+  virtual ~Timer() { }
+
+  // Called without any lock held, once the timer's expiry time has passed.
+  virtual void onExpiry() = 0;
+
+ private:
+  friend class TimerWheel;
+
+  static const int8_t kUnfiled = -1;
+
+  // Position on the wheel.
+  Timer* prev_;
+  Timer* next_;
+  int8_t level_;
+  uint8_t slot_;
+
+  int64_t expiry_;
+
+  // Set when the timer has been taken off the wheel to fire; cleared if it
+  // is cancelled or re-armed before onExpiry() is called.
+  bool firing_;
+
+  // Operations disallowed.
+  Timer(const Timer&);
+  void operator=(const Timer&);
+};
+
+
+// Hierarchical timing wheel with millisecond resolution. kLevels wheels of
+// kSlots slots each cover 2^32 ms (about 49 days) ahead of the current
+// time; each level's slots are kSlots times coarser than the previous
+// level's. A timer is filed in the finest level whose range covers its
+// expiry, and moves down a level whenever the slot it is in comes around.
+// Timers further out are parked at the end of the top level until they come
+// within range.
+//
+// Arming and cancelling a timer take constant time. Advancing the clock
+// costs a constant per elapsed millisecond and per timer that fires or
+// moves down a level; spans of time in which no timer can fire are skipped.
+//
+// Thread safety: all methods may be called concurrently. onExpiry() is
+// called after the wheel's lock is released, so that timers may be armed
+// and cancelled from it.
+class TimerWheel : public Fwk::PtrInterface<TimerWheel>,
+                   public Fwk::LockedInterface {
+ public:
+  typedef Fwk::Ptr<const TimerWheel> PtrConst;
+  typedef Fwk::Ptr<TimerWheel> Ptr;
+
+  static Ptr New(const Milliseconds& now) { return new TimerWheel(now); }
+
+  // Current time on the wheel's clock.
+  Milliseconds time() const { return now_; }
+
+  // Number of armed timers.
+  size_t timers() const { return timers_; }
+
+  // Arms TIMER to fire at EXPIRY, re-arming it if it is already armed.
+  // Timers whose expiry is not in the future fire on the next advance.
+  void timerIs(Timer::Ptr timer, const Milliseconds& expiry);
+
+  // Cancels TIMER if it is armed.
+  void timerDel(Timer::Ptr timer);
+
+  // Advances the clock to T and fires every timer whose expiry is at or
+  // before T, in order of expiry. Times earlier than time() are ignored.
+  void timeIs(const Milliseconds& t);
+
+  static const int kLevels = 4;
+  static const int kSlotBits = 8;
+  static const int kSlots = 1 << kSlotBits;
+
+ protected:
+  explicit TimerWheel(const Milliseconds& now);
+  virtual ~TimerWheel();
+
+ private:
+  struct Slot {
+    Slot() : head(NULL), tail(NULL) { }
+
+    Timer* head;
+    Timer* tail;
+  };
+
+  void file(Timer* timer);
+  void unfile(Timer* timer);
+  void cascade(int level);
+  void expire(Slot& slot, std::vector<Timer::Ptr>& expired);
+
+  static const uint32_t kSlotMask = kSlots - 1;
+
+  Slot slots_[kLevels][kSlots];
+  size_t level_timers_[kLevels];
+  size_t timers_;
+  int64_t now_;
+
+  // Operations disallowed.
+  TimerWheel(const TimerWheel&);
+  void operator=(const TimerWheel&);
+};
+
+
 class TaskManager : public Fwk::PtrInterface<TaskManager> {
  public:
   typedef Fwk::Ptr<const TaskManager> PtrConst;
@@ -75,12 +204,24 @@ class TaskManager : public Fwk::PtrInterface<TaskManager> {
   // Updates time on all tasks in the task set.
   void timeIs(const TimeEpoch& t);
 
+  // Advances the timer wheel to T, then signals a tick of the sub-second
+  // clock to all tasks in the task set. Ticks are expected roughly every
+  // kTickInterval milliseconds.
+  void tickIs(const Milliseconds& t);
+
+  // Timers on this wheel fire from tickIs(). The wheel's clock is the
+  // monotonic clock of monotonicTimeMs().
+  TimerWheel::Ptr timerWheel() const { return timer_wheel_; }
+
+  static const int kTickInterval = 10;
+
  protected:
   typedef std::map<std::string, Task::Ptr> TaskMap;
 
-  TaskManager() { }
+  TaskManager() : timer_wheel_(TimerWheel::New(monotonicTimeMs())) { }
 
   TaskMap task_map_;
+  TimerWheel::Ptr timer_wheel_;
 };
 
 #endif
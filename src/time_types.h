@@ -15,6 +15,23 @@ class Seconds : public Fwk::Ordinal<Seconds, int32_t> {
 };
 
 
+// Millisecond-resolution time. Used both for durations and for points on
+// the monotonic clock returned by monotonicTimeMs().
+class Milliseconds : public Fwk::Ordinal<Milliseconds, int64_t> {
+ public:
+  Milliseconds(const int64_t ms) : Fwk::Ordinal<Milliseconds, int64_t>(ms) { }
+};
+
+
+// Current time on a monotonic clock that is unaffected by changes to the
+// system time.
+inline Milliseconds monotonicTimeMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return Milliseconds((int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+
 class TimeDelta : public Fwk::Ordinal<TimeDelta, time_t> {
  public:
   TimeDelta(const time_t d) : Fwk::Ordinal<TimeDelta, time_t>(d) { }
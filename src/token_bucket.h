@@ -0,0 +1,86 @@
+#ifndef TOKEN_BUCKET_H_F6Q2LXRN
+#define TOKEN_BUCKET_H_F6Q2LXRN
+
+#include <inttypes.h>
+
+#include "time_types.h"
+
+
+/* Token-bucket rate limiter. The bucket holds up to burst() tokens and is
+   replenished at rate() tokens per second; each admitted event takes one.
+   Time is passed in by the caller, so that the bucket can be driven by any
+   clock. Tokens are counted in thousandths, which lets the bucket refill
+   at rate() thousandths of a token per millisecond. A rate of zero
+   disables the limit. */
+class TokenBucket {
+ public:
+  TokenBucket(uint32_t rate, uint32_t burst)
+      : rate_(rate), burst_(burst), tokens_((uint64_t)burst * 1000),
+        last_fill_(0) { }
+
+  /* Accessors. */
+
+  uint32_t rate() const { return rate_; }
+  uint32_t burst() const { return burst_; }
+
+  /* True if the bucket would be full at time NOW, that is, if it has not
+     limited anything recently. */
+  bool full(const Milliseconds& now) const {
+    return rate_ == 0 || tokens(now) == (uint64_t)burst_ * 1000;
+  }
+
+  /* Mutators. */
+
+  void rateIs(uint32_t rate) { rate_ = rate; }
+  void burstIs(uint32_t burst) {
+    burst_ = burst;
+    if (tokens_ > (uint64_t)burst * 1000)
+      tokens_ = (uint64_t)burst * 1000;
+  }
+
+  /* Takes a token at time NOW. Returns false if the bucket is empty, in
+     which case the event exceeds the rate. */
+  bool tokenTake(const Milliseconds& now) {
+    if (rate_ == 0)
+      return true;
+
+    tokens_ = tokens(now);
+    if (now > last_fill_)
+      last_fill_ = now;
+
+    if (tokens_ < 1000)
+      return false;
+
+    tokens_ -= 1000;
+    return true;
+  }
+
+  /* Gives back a token taken for an event that was not admitted after
+     all. */
+  void tokenReturn() {
+    const uint64_t full = (uint64_t)burst_ * 1000;
+    tokens_ = (tokens_ + 1000 < full) ? tokens_ + 1000 : full;
+  }
+
+ private:
+  /* Tokens in the bucket at time NOW, in thousandths. */
+  uint64_t tokens(const Milliseconds& now) const {
+    const uint64_t full = (uint64_t)burst_ * 1000;
+    if (now <= last_fill_ || rate_ == 0)
+      return tokens_;
+
+    const uint64_t elapsed = now.value() - last_fill_.value();
+    if (elapsed >= full / rate_ + 1 || tokens_ + elapsed * rate_ > full)
+      return full;
+
+    return tokens_ + elapsed * rate_;
+  }
+
+  /* Data members. */
+  uint32_t rate_;
+  uint32_t burst_;
+  uint64_t tokens_;
+  Milliseconds last_fill_;
+};
+
+#endif
@@ -1,15 +1,124 @@
 #include "tunnel.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "fwk/named_interface.h"
+
+#include "ethernet_packet.h"
+#include "gre_packet.h"
 #include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
 
+using std::min;
 using std::string;
 
 
+// GRE key field.
+static const size_t kKeySize = 4;
+
+const size_t Tunnel::Encap::kMaxHeaderSize =
+    EthernetPacket::kHeaderSize + IPPacket::kHeaderSize +
+    GREPacket::kHeaderSizeWithoutChecksum + kKeySize;
+
+
 Tunnel::Tunnel(Interface::PtrConst iface)
     : Fwk::NamedInterface(iface->name()),
       iface_(iface),
       remote_("0.0.0.0"),
-      mode_(kGRE) { }
+      keyed_(false),
+      key_(0),
+      mode_(kGRE),
+      mss_clamp_(false) { }
+
+
+size_t Tunnel::mtu(Interface::PtrConst phys_iface) const {
+  const size_t overhead = IPPacket::kHeaderSize +
+                          GREPacket::kHeaderSizeWithoutChecksum +
+                          (keyed_ ? kKeySize : 0);
+  return min(iface_->mtu(), phys_iface->mtu() - overhead);
+}
+
+
+Tunnel::Encap::Encap(Interface::PtrConst iface,
+                     const IPv4Addr& next_hop,
+                     const EthernetAddr& next_hop_mac,
+                     const IPv4Addr& src,
+                     const IPv4Addr& remote,
+                     const bool keyed,
+                     const uint32_t key,
+                     const uint32_t generation)
+    : iface_(iface),
+      next_hop_(next_hop),
+      generation_(generation),
+      header_size_(kMaxHeaderSize - (keyed ? 0 : kKeySize)),
+      ip_sum_(0) {
+  PacketBuffer::Ptr buffer = PacketBuffer::New(header_size_);
+  const size_t offset = buffer->size() - header_size_;
+
+  headers_ = EthernetPacket::New(buffer, offset);
+  headers_->srcIs(iface->mac());
+  headers_->dstIs(next_hop_mac);
+  headers_->typeIs(EthernetPacket::kIP);
+
+  IPPacket::Ptr ip_pkt =
+      IPPacket::New(buffer, offset + EthernetPacket::kHeaderSize);
+  ip_pkt->versionIs(4);
+  ip_pkt->headerLengthIs(IPPacket::kHeaderSize / 4);  // words, not bytes!
+  ip_pkt->packetLengthIs(0);
+  ip_pkt->diffServicesAre(0);
+  ip_pkt->protocolIs(IPPacket::kGRE);
+  ip_pkt->identificationIs(0);
+  ip_pkt->flagsAre(0);
+  ip_pkt->fragmentOffsetIs(0);
+  ip_pkt->srcIs(src);
+  ip_pkt->dstIs(remote);
+  ip_pkt->ttlIs(IPPacket::kDefaultTTL);
+  ip_pkt->checksumIs(0);
+
+  // Hardware does not support checksums on GRE, so don't bother setting them.
+  GREPacket::Ptr gre_pkt =
+      GREPacket::GREPacketNew(buffer, offset + EthernetPacket::kHeaderSize +
+                                      IPPacket::kHeaderSize);
+  gre_pkt->checksumPresentIs(false);
+  gre_pkt->keyPresentIs(keyed);
+  gre_pkt->keyIs(key);
+  gre_pkt->reserved0Is(0);
+  gre_pkt->versionIs(0);
+  gre_pkt->protocolIs(EthernetPacket::kIP);
+
+  const uint8_t* const ip_hdr = ip_pkt->data();
+  for (size_t i = 0; i < IPPacket::kHeaderSize; i += 2)
+    ip_sum_ += ip_hdr[i] << 8 | ip_hdr[i + 1];
+}
+
+
+EthernetPacket::Ptr
+Tunnel::Encap::encapsulated(IPPacket::Ptr pkt, const uint16_t id) const {
+  const size_t len = header_size_ - EthernetPacket::kHeaderSize + pkt->len();
+
+  PacketBuffer::Ptr buffer = pkt->buffer();
+  buffer->minimumSizeIs(pkt->len() + header_size_);
+  const size_t offset = pkt->bufferOffset() - header_size_;
+  uint8_t* const frame = buffer->data() + offset;
+  memcpy(frame, headers_->data(), header_size_);
+
+  // The length and identification are added to the sum of the rest of the
+  // IP header for its checksum.
+  uint8_t* const ip_hdr = frame + EthernetPacket::kHeaderSize;
+  uint32_t sum = ip_sum_ + len + id;
+  while (sum > 0xFFFF)
+    sum = (sum >> 16) + (sum & 0xFFFF);
+  const uint16_t cksum = ~sum;
+
+  ip_hdr[2] = len >> 8;
+  ip_hdr[3] = len & 0xFF;
+  ip_hdr[4] = id >> 8;
+  ip_hdr[5] = id & 0xFF;
+  ip_hdr[10] = cksum >> 8;
+  ip_hdr[11] = cksum & 0xFF;
+
+  return EthernetPacket::New(buffer, offset);
+}
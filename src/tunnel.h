@@ -1,10 +1,15 @@
 #ifndef TUNNEL_H_
 #define TUNNEL_H_
 
+#include <inttypes.h>
+
 #include "fwk/named_interface.h"
 #include "fwk/ptr.h"
+#include "fwk/ptr_interface.h"
 
+#include "ethernet_packet.h"
 #include "interface.h"
+#include "ip_packet.h"
 #include "ipv4_addr.h"
 
 
@@ -17,6 +22,72 @@ class Tunnel : public Fwk::NamedInterface {
     kGRE
   };
 
+  // Outer headers of the packets sent through a tunnel: the Ethernet header to
+  // the next hop towards the remote endpoint, the IP header to the remote
+  // endpoint, and the GRE header with the tunnel's key, if it has one. They are
+  // built by the ControlPlane from the route and ARP entry of the remote
+  // endpoint, so that encapsulation only copies them in front of a packet and
+  // fills in the IP length, identification and checksum. An Encap does not
+  // change once built; it is replaced when routes or ARP entries change (see
+  // ControlPlane::tunnelEncapGeneration()).
+  class Encap : public Fwk::PtrInterface<Encap> {
+   public:
+    typedef Fwk::Ptr<const Encap> PtrConst;
+    typedef Fwk::Ptr<Encap> Ptr;
+
+    // Length of the outer headers of a tunnel with a key; the headers of
+    // one without are 4 bytes shorter.
+    static const size_t kMaxHeaderSize;
+
+    // Headers of packets from SRC to REMOTE, sent out of IFACE to
+    // NEXT_HOP, which is at NEXT_HOP_MAC. The GRE header carries KEY if
+    // KEYED is true.
+    static Ptr New(Interface::PtrConst iface, const IPv4Addr& next_hop,
+                   const EthernetAddr& next_hop_mac, const IPv4Addr& src,
+                   const IPv4Addr& remote, bool keyed, uint32_t key,
+                   uint32_t generation) {
+      return new Encap(iface, next_hop, next_hop_mac, src, remote, keyed, key,
+                       generation);
+    }
+
+    // Returns the physical interface the tunnel is carried over.
+    Interface::PtrConst interface() const { return iface_; }
+
+    // Returns the next hop towards the remote endpoint.
+    IPv4Addr nextHop() const { return next_hop_; }
+
+    // Returns the ControlPlane's tunnel encapsulation generation at the time
+    // the headers were built.
+    uint32_t generation() const { return generation_; }
+
+    // Returns the length of the outer headers.
+    size_t headerSize() const { return header_size_; }
+
+    // Adds the outer headers in front of PKT, with ID as the identification
+    // of the outer IP header, and returns the Ethernet frame.
+    EthernetPacket::Ptr encapsulated(IPPacket::Ptr pkt, uint16_t id) const;
+
+   protected:
+    Encap(Interface::PtrConst iface, const IPv4Addr& next_hop,
+          const EthernetAddr& next_hop_mac, const IPv4Addr& src,
+          const IPv4Addr& remote, bool keyed, uint32_t key,
+          uint32_t generation);
+
+    Interface::PtrConst iface_;
+    IPv4Addr next_hop_;
+    uint32_t generation_;
+    size_t header_size_;
+
+    // The headers, with the IP length, identification and checksum set to
+    // zero, and the one's complement sum of the IP header.
+    EthernetPacket::Ptr headers_;
+    uint32_t ip_sum_;
+
+   private:
+    Encap(const Encap&);
+    void operator=(const Encap&);
+  };
+
   static Ptr New(Interface::PtrConst iface) {
     return new Tunnel(iface);
   }
@@ -27,8 +98,22 @@ class Tunnel : public Fwk::NamedInterface {
   // Returns the remote endpoint for this tunnel.
   IPv4Addr remote() const { return remote_; }
 
-  // Sets the remote endpoint for this tunnel.
-  void remoteIs(IPv4Addr remote) { remote_ = remote; }
+  // Sets the remote endpoint for this tunnel. The outer headers are rebuilt
+  // for the new endpoint.
+  void remoteIs(IPv4Addr remote) { remote_ = remote; encap_ = NULL; }
+
+  // Returns whether packets through this tunnel carry a GRE key (RFC 2890).
+  // Tunnels to the same remote endpoint are told apart by their keys.
+  bool keyed() const { return keyed_; }
+
+  // Returns the key of this tunnel, or 0 if it has none.
+  uint32_t key() const { return key_; }
+
+  // Sets the key of this tunnel. The outer headers are rebuilt.
+  void keyIs(uint32_t key) { keyed_ = true; key_ = key; encap_ = NULL; }
+
+  // Removes the key of this tunnel. The outer headers are rebuilt.
+  void keyDel() { keyed_ = false; key_ = 0; encap_ = NULL; }
 
   // Returns the mode of this tunnel.
   Mode mode() const { return mode_; }
@@ -36,12 +121,36 @@ class Tunnel : public Fwk::NamedInterface {
   // Sets the mode of this tunnel.
   void modeIs(Mode mode) { mode_ = mode; }
 
+  // Returns whether the MSS option of TCP SYNs entering or leaving the
+  // tunnel is lowered to fit its MTU.
+  bool mssClamp() const { return mss_clamp_; }
+
+  // Sets whether TCP MSS options are clamped.
+  void mssClampIs(bool clamp) { mss_clamp_ = clamp; }
+
+  // Returns the MTU of this tunnel when it is carried over PHYS_IFACE: the MTU
+  // of PHYS_IFACE less the outer IP and GRE headers (with the key, if any),
+  // unless the tunnel's own interface has a lower one.
+  size_t mtu(Interface::PtrConst phys_iface) const;
+
+  // Returns the outer headers of packets sent through this tunnel, or NULL
+  // if they have not been built. Like the tunnel's other attributes, they
+  // are read and set with the TunnelMap locked.
+  Encap::PtrConst encap() const { return encap_; }
+
+  // Sets the outer headers.
+  void encapIs(Encap::PtrConst encap) { encap_ = encap; }
+
  protected:
   Tunnel(Interface::PtrConst iface);
 
   Interface::PtrConst iface_;
   IPv4Addr remote_;
+  bool keyed_;
+  uint32_t key_;
   Mode mode_;
+  bool mss_clamp_;
+  Encap::PtrConst encap_;
 
  private:
   Tunnel(const Tunnel&);
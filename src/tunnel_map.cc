@@ -11,6 +11,25 @@
 using std::string;
 
 
+TunnelMap::Endpoint::Endpoint(const IPv4Addr& _remote,
+                              const bool _keyed,
+                              const uint32_t _key)
+    : remote(_remote), keyed(_keyed), key(_key) { }
+
+
+bool TunnelMap::Endpoint::operator==(const Endpoint& other) const {
+  return remote == other.remote && keyed == other.keyed && key == other.key;
+}
+
+
+uint32_t TunnelMap::EndpointHash::operator()(const Endpoint& endpoint) const {
+  // Combined as in boost::hash_combine; the map mixes the result further.
+  uint32_t hash = endpoint.remote.value();
+  hash ^= endpoint.key + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  return hash ^ endpoint.keyed;
+}
+
+
 void TunnelMap::tunnelIs(const Tunnel::Ptr tunnel) {
   if (!tunnel)
     throw Fwk::ResourceException("TunnelMap::tunnelIs",
@@ -19,7 +38,10 @@ void TunnelMap::tunnelIs(const Tunnel::Ptr tunnel) {
     return;
 
   name_t_map_[tunnel->name()] = tunnel;
-  ip_t_map_[tunnel->remote()] = tunnel;
+
+  const Endpoint endpoint(tunnel->remote(), tunnel->keyed(), tunnel->key());
+  if (!endpoint_t_map_.elem(endpoint))
+    endpoint_t_map_.elemIs(endpoint, tunnel);
 
   // Dispatch notification.
   for (unsigned int i = 0; i < notifiees_.size(); ++i)
@@ -41,7 +63,11 @@ void TunnelMap::tunnelDel(Tunnel::Ptr tunnel) {
     return;
 
   name_t_map_.erase(tunnel->name());
-  ip_t_map_.erase(tunnel->remote());
+
+  // Another tunnel may have the same endpoint (see tunnelIs()).
+  const Endpoint endpoint(tunnel->remote(), tunnel->keyed(), tunnel->key());
+  if (endpoint_t_map_.elem(endpoint) == tunnel)
+    endpoint_t_map_.elemDel(endpoint);
 
   // Dispatch notification.
   for (unsigned int i = 0; i < notifiees_.size(); ++i)
@@ -56,6 +82,11 @@ Tunnel::Ptr TunnelMap::tunnel(const string& name) {
 
 
 Tunnel::Ptr TunnelMap::tunnelRemoteAddr(const IPv4Addr& addr) {
-  IPTunnelMap::iterator it = ip_t_map_.find(addr);
-  return (it != ip_t_map_.end()) ? it->second : NULL;
+  return endpoint_t_map_.elem(Endpoint(addr, false, 0));
+}
+
+
+Tunnel::Ptr TunnelMap::tunnelRemoteAddr(const IPv4Addr& addr,
+                                        const uint32_t key) {
+  return endpoint_t_map_.elem(Endpoint(addr, true, key));
 }
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "ipv4_addr.h"
+#include "fwk/hash_map.h"
 #include "fwk/locked_interface.h"
 #include "fwk/notifier.h"
 #include "fwk/ptr.h"
@@ -21,7 +22,6 @@ class TunnelMap : public Fwk::BaseNotifier<TunnelMap, TunnelMapNotifiee>,
   typedef Fwk::Ptr<TunnelMap> Ptr;
   typedef TunnelMapNotifiee Notifiee;
   typedef std::map<std::string, Tunnel::Ptr> NameTunnelMap;
-  typedef std::map<IPv4Addr, Tunnel::Ptr> IPTunnelMap;
   typedef NameTunnelMap::iterator iterator;
   typedef NameTunnelMap::const_iterator const_iterator;
 
@@ -29,8 +29,11 @@ class TunnelMap : public Fwk::BaseNotifier<TunnelMap, TunnelMapNotifiee>,
     return new TunnelMap();
   }
 
-  // Adds a new tunnel to the map. If a tunnel with the same name already
-  // exists, it is replaced with 'iface'.
+  // Adds a new tunnel to the map. Does nothing if a tunnel with the same
+  // name already exists. If another tunnel has the same remote address and
+  // key, the new tunnel is not found by tunnelRemoteAddr(). Tunnels are
+  // indexed by their remote address and key, so a tunnel must be deleted
+  // from the map while they are changed.
   void tunnelIs(Tunnel::Ptr tunnel);
 
   // Delete a tunnel.
@@ -41,10 +44,14 @@ class TunnelMap : public Fwk::BaseNotifier<TunnelMap, TunnelMapNotifiee>,
   // name.
   Tunnel::Ptr tunnel(const std::string& name);
 
-  // Returns a tunnel with remote IP address 'addr'. Returns NULL if no tunnel
-  // exists with that remote address.
+  // Returns the tunnel without a key with remote IP address 'addr'. Returns
+  // NULL if no such tunnel exists.
   Tunnel::Ptr tunnelRemoteAddr(const IPv4Addr& addr);
 
+  // Returns the tunnel with remote IP address 'addr' and key 'key'. Returns
+  // NULL if no such tunnel exists.
+  Tunnel::Ptr tunnelRemoteAddr(const IPv4Addr& addr, uint32_t key);
+
   // Returns the number of tunnels in the map.
   size_t tunnels() const { return name_t_map_.size(); }
 
@@ -57,8 +64,28 @@ class TunnelMap : public Fwk::BaseNotifier<TunnelMap, TunnelMapNotifiee>,
   TunnelMap() { }
 
  private:
+  // Remote endpoint and key of a tunnel.
+  struct Endpoint {
+    Endpoint(const IPv4Addr& remote, bool keyed, uint32_t key);
+
+    bool operator==(const Endpoint& other) const;
+
+    IPv4Addr remote;
+    bool keyed;
+    uint32_t key;
+  };
+
+  // Hash function for Endpoint, for use with Fwk::HashMap.
+  struct EndpointHash {
+    uint32_t operator()(const Endpoint& endpoint) const;
+  };
+
+  typedef Fwk::HashMap<Endpoint, Tunnel, EndpointHash> EndpointTunnelMap;
+
+  // Decapsulation looks tunnels up by endpoint for every packet; a hash
+  // table keeps this constant-time with thousands of tunnels.
   NameTunnelMap name_t_map_;
-  IPTunnelMap ip_t_map_;
+  EndpointTunnelMap endpoint_t_map_;
 
   TunnelMap(const TunnelMap&);
   void operator=(const TunnelMap&);
@@ -1,7 +1,9 @@
 #include "gtest/gtest.h"
 
 #include "arp_cache.h"
+#include "arp_cache_daemon.h"
 #include "fwk/ptr.h"
+#include "task.h"
 
 
 // Test reactor class that counts the number of entries in the cache.
@@ -128,3 +130,41 @@ TEST_F(ARPCacheTest, reactor) {
     EXPECT_EQ(arp_cache_->entries(), reactor->entries());
   }
 }
+
+
+TEST_F(ARPCacheTest, daemon) {
+  TimerWheel::Ptr wheel = TimerWheel::New(0);
+  ARPCacheDaemon::Ptr daemon = ARPCacheDaemon::New(arp_cache_, wheel);
+
+  ARPCache::Entry::Ptr entry = ARPCache::Entry::New(ip_addr_, eth_addr_);
+  arp_cache_->entryIs(entry);
+  EXPECT_EQ((size_t)1, wheel->timers());
+
+  // Static entries do not expire.
+  ARPCache::Entry::Ptr static_entry = ARPCache::Entry::New(1, eth_addr_);
+  static_entry->typeIs(ARPCache::Entry::kStatic);
+  arp_cache_->entryIs(static_entry);
+  EXPECT_EQ((size_t)1, wheel->timers());
+
+  // The entry's timer fires once the entry would be kTimeoutAge old. A
+  // refreshed entry is kept, and its timer is re-armed.
+  wheel->timeIs(ARPCacheDaemon::kTimeoutAge * 1000 - 1);
+  EXPECT_EQ(entry, arp_cache_->entry(ip_addr_));
+  entry->ageIs(1);
+  wheel->timeIs(ARPCacheDaemon::kTimeoutAge * 1000);
+  EXPECT_EQ(entry, arp_cache_->entry(ip_addr_));
+  EXPECT_EQ((size_t)1, wheel->timers());
+
+  // An entry that has reached kTimeoutAge is removed.
+  entry->ageIs(ARPCacheDaemon::kTimeoutAge);
+  wheel->timeIs(ARPCacheDaemon::kTimeoutAge * 2000);
+  EXPECT_TRUE(arp_cache_->entry(ip_addr_) == NULL);
+  EXPECT_EQ(static_entry, arp_cache_->entry(1));
+  EXPECT_EQ((size_t)0, wheel->timers());
+
+  // Removing an entry cancels its timer.
+  arp_cache_->entryIs(ARPCache::Entry::New(ip_addr_, eth_addr_));
+  EXPECT_EQ((size_t)1, wheel->timers());
+  arp_cache_->entryDel(ip_addr_);
+  EXPECT_EQ((size_t)0, wheel->timers());
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include "arp_queue.h"
+#include "ethernet_packet.h"
+#include "interface.h"
+#include "ipv4_addr.h"
+#include "packet_buffer.h"
+
+class ARPQueueTest : public ::testing::Test {
+ protected:
+  ARPQueueTest() : queue_(ARPQueue::New()) {}
+
+  /* Adds an entry for next hop IP. */
+  ARPQueue::Entry::Ptr entryNew(const IPv4Addr& ip) {
+    ARPQueue::Entry::Ptr entry = ARPQueue::Entry::New(ip, NULL, NULL);
+    queue_->entryIs(entry);
+    return entry;
+  }
+
+  /* Returns a packet in a buffer of LEN bytes; LEN must be a power of two
+     of at least 512, or the buffer is rounded up to one. */
+  EthernetPacket::Ptr packet(size_t len) {
+    PacketBuffer::Ptr buffer = PacketBuffer::New(len);
+    return EthernetPacket::New(buffer, 0);
+  }
+
+  ARPQueue::Ptr queue_;
+};
+
+TEST_F(ARPQueueTest, accounting) {
+  // Packets are only queued for next hops being resolved.
+  EXPECT_FALSE(queue_->packetNew(0x0a000001, packet(512)));
+  EXPECT_EQ((uint64_t)1, queue_->overflows());
+
+  ARPQueue::Entry::Ptr entry1 = entryNew(0x0a000001);
+  entryNew(0x0a000002);
+  EXPECT_TRUE(queue_->packetNew(0x0a000001, packet(512)));
+  EXPECT_TRUE(queue_->packetNew(0x0a000001, packet(1024)));
+  EXPECT_TRUE(queue_->packetNew(0x0a000002, packet(2048)));
+  EXPECT_EQ((size_t)2, queue_->entries());
+  EXPECT_EQ((size_t)2, entry1->packets());
+  EXPECT_EQ((size_t)1536, entry1->bytes());
+  EXPECT_EQ((size_t)3, queue_->packets());
+  EXPECT_EQ((size_t)3584, queue_->bytes());
+  EXPECT_EQ((uint64_t)3, queue_->enqueued());
+
+  // Flushing an entry releases its packets.
+  queue_->entryDel(entry1);
+  EXPECT_EQ((size_t)1, queue_->packets());
+  EXPECT_EQ((size_t)2048, queue_->bytes());
+
+  // So does replacing it.
+  entryNew(0x0a000002);
+  EXPECT_EQ((size_t)0, queue_->packets());
+  EXPECT_EQ((size_t)0, queue_->bytes());
+}
+
+TEST_F(ARPQueueTest, entryLimits) {
+  entryNew(0x0a000001);
+  entryNew(0x0a000002);
+
+  // Packet limit of a next hop.
+  for (size_t i = 0; i < ARPQueue::kMaxEntryPackets; ++i)
+    EXPECT_TRUE(queue_->packetNew(0x0a000001, packet(512)));
+  EXPECT_FALSE(queue_->packetNew(0x0a000001, packet(512)));
+  EXPECT_EQ((uint64_t)1, queue_->overflows());
+  EXPECT_EQ(ARPQueue::kMaxEntryPackets, queue_->entry(0x0a000001)->packets());
+
+  // Byte limit of a next hop; other next hops are not affected.
+  const size_t len = ARPQueue::kMaxEntryBytes / 4;
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(queue_->packetNew(0x0a000002, packet(len)));
+  EXPECT_FALSE(queue_->packetNew(0x0a000002, packet(512)));
+  EXPECT_EQ((uint64_t)2, queue_->overflows());
+}
+
+TEST_F(ARPQueueTest, queueLimits) {
+  // Packet limit of the queue.
+  const size_t entries = ARPQueue::kMaxPackets / ARPQueue::kMaxEntryPackets;
+  for (size_t i = 0; i < entries; ++i) {
+    entryNew(0x0a000000 + i);
+    for (size_t j = 0; j < ARPQueue::kMaxEntryPackets; ++j)
+      ASSERT_TRUE(queue_->packetNew(0x0a000000 + i, packet(512)));
+  }
+  entryNew(0x0b000001);
+  EXPECT_FALSE(queue_->packetNew(0x0b000001, packet(512)));
+  EXPECT_EQ(ARPQueue::kMaxPackets, queue_->packets());
+
+  // Byte limit of the queue.
+  for (size_t i = 0; i < entries; ++i)
+    queue_->entryDel(0x0a000000 + i);
+  const size_t len = ARPQueue::kMaxEntryBytes / 2;
+  size_t queued = 0;
+  for (size_t i = 0; i < ARPQueue::kMaxBytes / len; ++i) {
+    entryNew(0x0c000000 + i);
+    queued += queue_->packetNew(0x0c000000 + i, packet(len)) ? 1 : 0;
+  }
+  EXPECT_EQ(ARPQueue::kMaxBytes / len, queued);
+  entryNew(0x0d000001);
+  EXPECT_FALSE(queue_->packetNew(0x0d000001, packet(len)));
+  EXPECT_EQ(ARPQueue::kMaxBytes, queue_->bytes());
+}
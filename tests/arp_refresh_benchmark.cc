@@ -0,0 +1,274 @@
+/* ARP cache misses on the forwarding path, with next hops resolved on
+   demand and with ARPRefreshDaemon. The router forwards traffic from one
+   interface to kGateways gateways, each with a route of its own, and to
+   kHosts hosts on a directly connected subnet. Half of the gateways and
+   hosts are busy and receive packets on every step; the others only in one
+   second out of five. Neighbors answer ARP requests on the next step.
+   Hosts are not resolved before packets are sent to them, so each one
+   misses once in either mode.
+
+   Time is simulated in steps of kStepMs: the timer wheel of the ARP
+   daemons is advanced every step, and the entries of the ARP cache age by
+   a second every kStepsPerSecond steps. For each mode, the share of packets
+   that missed in the ARP cache is reported for busy and idle next hops,
+   along with the ARP requests the router sent.
+
+   Usage: arp_refresh_benchmark [seconds]  (default: 600) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "fwk/log.h"
+
+#include "arp_cache.h"
+#include "arp_cache_daemon.h"
+#include "arp_packet.h"
+#include "arp_queue_daemon.h"
+#include "arp_refresh_daemon.h"
+#include "control_plane.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "routing_table.h"
+#include "task.h"
+
+static const int kDefaultSeconds = 600;
+static const int kGateways = 12;
+static const int kHosts = 12;
+static const int kStepMs = 100;
+static const int kStepsPerSecond = 1000 / kStepMs;
+static const int kIdleSeconds = 5;
+
+/* Hardware address of neighbor IP. */
+static EthernetAddr
+neighbor_mac(const IPv4Addr& ip) {
+  uint8_t addr[EthernetAddr::kAddrLen] = { 0x02, 0x00, 0x00, 0x00, 0x00 };
+  addr[4] = (ip.value() >> 8) & 0xff;
+  addr[5] = ip.value() & 0xff;
+  return EthernetAddr(addr);
+}
+
+/* Data plane whose output stays in the benchmark: neighbors answer the ARP
+   requests sent out of it on the next step, and forwarded packets are
+   counted. */
+class LoopbackDataPlane : public DataPlane {
+ public:
+  typedef Fwk::Ptr<LoopbackDataPlane> Ptr;
+
+  static Ptr New(ARPCache::Ptr cache) { return new LoopbackDataPlane(cache); }
+
+  unsigned long broadcasts() const { return broadcasts_; }
+  unsigned long unicasts() const { return unicasts_; }
+  unsigned long forwarded() const { return forwarded_; }
+
+  void outputPacketNew(EthernetPacket::PtrConst pkt,
+                       Interface::PtrConst iface) {
+    if (pkt->type() != EthernetPacket::kARP) {
+      ++forwarded_;
+      return;
+    }
+
+    EthernetPacket* eth_pkt = const_cast<EthernetPacket*>(pkt.ptr());
+    ARPPacket::Ptr arp_pkt = Ptr::st_cast<ARPPacket>(eth_pkt->payload());
+    if (pkt->dst() == EthernetAddr::kBroadcast)
+      ++broadcasts_;
+    else
+      ++unicasts_;
+
+    replies_.push_back(reply(arp_pkt->targetPAddr(), iface));
+    reply_ifaces_.push_back(iface);
+  }
+
+  /* Hands the replies to requests sent so far to the control plane. */
+  void repliesDeliver() {
+    std::deque<EthernetPacket::Ptr> replies;
+    std::deque<Interface::PtrConst> ifaces;
+    replies.swap(replies_);
+    ifaces.swap(reply_ifaces_);
+    for (size_t i = 0; i < replies.size(); ++i)
+      cp_->packetNew(replies[i], ifaces[i]);
+  }
+
+ protected:
+  LoopbackDataPlane(ARPCache::Ptr cache)
+      : DataPlane("LoopbackDataPlane", NULL, cache),
+        broadcasts_(0), unicasts_(0), forwarded_(0) { }
+
+  /* ARP reply of neighbor IP to the router on IFACE. */
+  static EthernetPacket::Ptr
+  reply(const IPv4Addr& ip, Interface::PtrConst iface) {
+    size_t len = EthernetPacket::kHeaderSize + ARPPacket::kPacketLen;
+    PacketBuffer::Ptr buffer = PacketBuffer::New(len);
+    EthernetPacket::Ptr eth_pkt =
+        EthernetPacket::New(buffer, buffer->size() - len);
+    eth_pkt->srcIs(neighbor_mac(ip));
+    eth_pkt->dstIs(iface->mac());
+    eth_pkt->typeIs(EthernetPacket::kARP);
+
+    ARPPacket::Ptr arp_pkt = Ptr::st_cast<ARPPacket>(eth_pkt->payload());
+    arp_pkt->operationIs(ARPPacket::kReply);
+    arp_pkt->hwTypeIs(ARPPacket::kEthernet);
+    arp_pkt->pTypeIs(ARPPacket::kIP);
+    arp_pkt->senderHWAddrIs(neighbor_mac(ip));
+    arp_pkt->senderPAddrIs(ip);
+    arp_pkt->targetHWAddrIs(iface->mac());
+    arp_pkt->targetPAddrIs(iface->ip());
+    return eth_pkt;
+  }
+
+ private:
+  std::deque<EthernetPacket::Ptr> replies_;
+  std::deque<Interface::PtrConst> reply_ifaces_;
+  unsigned long broadcasts_;
+  unsigned long unicasts_;
+  unsigned long forwarded_;
+};
+
+static Interface::Ptr
+interface_new(const std::string& name, const IPv4Addr& ip) {
+  Interface::Ptr iface = Interface::InterfaceNew(name);
+  iface->ipIs(ip);
+  iface->subnetMaskIs("255.255.255.0");
+  iface->macIs(neighbor_mac(ip));
+  return iface;
+}
+
+/* UDP datagram to DST, received on IFACE. */
+static EthernetPacket::Ptr
+datagram(const IPv4Addr& dst, Interface::PtrConst iface) {
+  const size_t len = EthernetPacket::kHeaderSize + 28;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(len);
+  EthernetPacket::Ptr eth_pkt =
+      EthernetPacket::New(buffer, buffer->size() - len);
+  eth_pkt->srcIs(neighbor_mac(iface->ip().value() + 1));
+  eth_pkt->dstIs(iface->mac());
+  eth_pkt->typeIs(EthernetPacket::kIP);
+
+  IPPacket::Ptr ip_pkt =
+      IPPacket::Ptr::st_cast<IPPacket>(eth_pkt->payload());
+  ip_pkt->versionIs(4);
+  ip_pkt->headerLengthIs(5);
+  ip_pkt->packetLengthIs(28);
+  ip_pkt->identificationIs(0);
+  ip_pkt->flagsAre(0);
+  ip_pkt->fragmentOffsetIs(0);
+  ip_pkt->ttlIs(64);
+  ip_pkt->protocolIs(IPPacket::kUDP);
+  ip_pkt->srcIs(iface->ip().value() + 1);
+  ip_pkt->dstIs(dst);
+  ip_pkt->checksumReset();
+  return eth_pkt;
+}
+
+/* Packets sent to busy and idle next hops, and how many of them missed in
+   the ARP cache. */
+struct Result {
+  Result() : busy(0), busy_misses(0), idle(0), idle_misses(0) { }
+
+  unsigned long busy;
+  unsigned long busy_misses;
+  unsigned long idle;
+  unsigned long idle_misses;
+};
+
+static void
+benchmark(int seconds, bool refresh) {
+  ControlPlane::Ptr cp = ControlPlane::ControlPlaneNew();
+  LoopbackDataPlane::Ptr dp = LoopbackDataPlane::New(cp->arpCache());
+  Interface::Ptr in_iface = interface_new("eth0", "172.16.0.1");
+  Interface::Ptr out_iface = interface_new("eth1", "192.168.0.1");
+  dp->interfaceMap()->interfaceIs(in_iface);
+  dp->interfaceMap()->interfaceIs(out_iface);
+  cp->dataPlaneIs(dp);
+  dp->controlPlaneIs(cp.ptr());
+  dp->routingTableIs(cp->routingTable());
+
+  // Misses are punted to the control plane; the policer runs on real time,
+  // which would drop most of them since simulated time runs much faster.
+  dp->puntQueue()->rateIs(PuntQueue::kException, 0);
+
+  // Destinations behind each gateway, then the hosts.
+  std::vector<IPv4Addr> dsts;
+  for (int i = 0; i < kGateways; ++i) {
+    IPv4Addr gateway = IPv4Addr("192.168.0.10").value() + i;
+    RoutingTable::Entry::Ptr entry =
+        RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+    entry->subnetIs(IPv4Addr("10.0.0.0").value() + (i << 16), "255.255.0.0");
+    entry->gatewayIs(gateway);
+    entry->interfaceIs(out_iface);
+    cp->routingTable()->entryIs(entry);
+
+    dsts.push_back(entry->subnet().value() + 1);
+  }
+  for (int i = 0; i < kHosts; ++i) {
+    IPv4Addr host = IPv4Addr("192.168.0.100").value() + i;
+    dsts.push_back(host);
+  }
+
+  TimerWheel::Ptr wheel = TimerWheel::New(0);
+  ARPCacheDaemon::Ptr cache_daemon =
+      ARPCacheDaemon::New(cp->arpCache(), wheel);
+  ARPQueueDaemon::Ptr queue_daemon = ARPQueueDaemon::New(cp, wheel);
+  ARPRefreshDaemon::Ptr refresh_daemon = ARPRefreshDaemon::New(cp);
+  if (refresh)
+    refresh_daemon->timeIs(0);
+
+  Result result;
+  ARPCache::Ptr cache = cp->arpCache();
+  for (int step = 1; step <= seconds * kStepsPerSecond; ++step) {
+    const int second = step / kStepsPerSecond;
+    if (step % kStepsPerSecond == 0) {
+      for (ARPCache::iterator it = cache->begin(); it != cache->end(); ++it)
+        it->second->ageIs(it->second->age() + 1);
+    }
+
+    wheel->timeIs(step * kStepMs);
+    dp->repliesDeliver();
+    if (refresh && step % kStepsPerSecond == 0)
+      refresh_daemon->timeIs(second);
+
+    for (size_t i = 0; i < dsts.size(); ++i) {
+      // Every other next hop is busy; the others are idle for four seconds
+      // out of five, at different times.
+      const bool busy = (i % 2 == 0);
+      if (!busy && (second + i) % kIdleSeconds != 0)
+        continue;
+
+      const uint64_t misses = cache->misses();
+      dp->packetNew(datagram(dsts[i], in_iface), in_iface);
+      if (busy) {
+        ++result.busy;
+        result.busy_misses += cache->misses() - misses;
+      } else {
+        ++result.idle;
+        result.idle_misses += cache->misses() - misses;
+      }
+    }
+    dp->puntedPacketsDispatch(dsts.size());
+  }
+
+  printf("%-10s  busy: %7.3f%% missed  idle: %7.3f%% missed  "
+         "requests: %5lu broadcast, %5lu unicast\n",
+         refresh ? "refresh" : "on demand",
+         100.0 * result.busy_misses / result.busy,
+         100.0 * result.idle_misses / result.idle,
+         dp->broadcasts(), dp->unicasts());
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int seconds = (argc > 1) ? atoi(argv[1]) : kDefaultSeconds;
+
+  printf("%d next hops for %d seconds\n", kGateways + kHosts, seconds);
+  benchmark(seconds, false);
+  benchmark(seconds, true);
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef BENCHMARK_UTIL_H_R7CW2N5J
+#define BENCHMARK_UTIL_H_R7CW2N5J
+
+#include <sys/time.h>
+#include <sys/uio.h>
+
+#include "arp_cache.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "interface.h"
+
+
+/* Wall-clock time in seconds. */
+static inline double
+now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Data plane that counts the frames sent out of it instead of writing them
+   to a device. */
+class CountingDataPlane : public DataPlane {
+ public:
+  typedef Fwk::Ptr<CountingDataPlane> Ptr;
+
+  static Ptr New(ARPCache::Ptr cache) { return new CountingDataPlane(cache); }
+
+  unsigned long frames() const { return frames_; }
+  unsigned long bytes() const { return bytes_; }
+
+  void outputPacketNew(EthernetPacket::PtrConst pkt,
+                       Interface::PtrConst iface) {
+    ++frames_;
+    bytes_ += pkt->len();
+  }
+
+  void outputGatheredNew(const struct iovec* iov, int iovcnt,
+                         Interface::PtrConst iface) {
+    ++frames_;
+    for (int i = 0; i < iovcnt; ++i)
+      bytes_ += iov[i].iov_len;
+  }
+
+ protected:
+  CountingDataPlane(ARPCache::Ptr cache)
+      : DataPlane("CountingDataPlane", NULL, cache), frames_(0), bytes_(0) { }
+
+ private:
+  unsigned long frames_;
+  unsigned long bytes_;
+};
+
+#endif
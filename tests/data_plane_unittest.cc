@@ -0,0 +1,164 @@
+#include "gtest/gtest.h"
+
+#include <sys/uio.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "arp_cache.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+
+using std::string;
+using std::vector;
+
+/* Data plane that keeps the frames sent out of it. */
+class CapturingDataPlane : public DataPlane {
+ public:
+  typedef Fwk::Ptr<CapturingDataPlane> Ptr;
+
+  static Ptr New() { return new CapturingDataPlane(); }
+
+  const vector<string>& frames() const { return frames_; }
+
+  void outputPacketNew(EthernetPacket::PtrConst pkt,
+                       Interface::PtrConst iface) {
+    frames_.push_back(string((const char*)pkt->data(), pkt->len()));
+  }
+
+  void outputGatheredNew(const struct iovec* iov, int iovcnt,
+                         Interface::PtrConst iface) {
+    string frame;
+    for (int i = 0; i < iovcnt; ++i)
+      frame.append((const char*)iov[i].iov_base, iov[i].iov_len);
+    frames_.push_back(frame);
+  }
+
+ protected:
+  CapturingDataPlane()
+      : DataPlane("CapturingDataPlane", NULL, ARPCache::New()) { }
+
+ private:
+  vector<string> frames_;
+};
+
+class DataPlaneTest : public ::testing::Test {
+ protected:
+  DataPlaneTest()
+      : dp_(CapturingDataPlane::New()),
+        iface_(Interface::InterfaceNew("eth0")) {
+    iface_->mtuIs(1500);
+  }
+
+  /* Ethernet frame carrying a UDP datagram with LEN bytes of payload and
+     header options OPTIONS, OPTIONS_LEN bytes long; byte i of the payload is
+     i % 251. */
+  static EthernetPacket::Ptr frame(const uint8_t* options, size_t options_len,
+                                   size_t len) {
+    const size_t header_len = IPPacket::kHeaderSize + options_len;
+    const size_t frame_len = EthernetPacket::kHeaderSize + header_len + len;
+    PacketBuffer::Ptr buffer = PacketBuffer::New(frame_len);
+    EthernetPacket::Ptr eth_pkt =
+        EthernetPacket::New(buffer, buffer->size() - frame_len);
+    eth_pkt->srcIs("02:00:00:00:00:01");
+    eth_pkt->dstIs("02:00:00:00:00:02");
+    eth_pkt->typeIs(EthernetPacket::kIP);
+
+    IPPacket::Ptr pkt =
+        IPPacket::New(buffer, buffer->size() - header_len - len);
+    pkt->versionIs(4);
+    pkt->headerLengthIs(header_len / 4);
+    pkt->packetLengthIs(header_len + len);
+    pkt->diffServicesAre(0);
+    pkt->identificationIs(1234);
+    pkt->flagsAre(0);
+    pkt->fragmentOffsetIs(0);
+    pkt->ttlIs(64);
+    pkt->protocolIs(IPPacket::kUDP);
+    pkt->srcIs("10.0.0.1");
+    pkt->dstIs("10.0.0.2");
+    memcpy(pkt->data() + IPPacket::kHeaderSize, options, options_len);
+    for (size_t i = 0; i < len; ++i)
+      pkt->data()[header_len + i] = i % 251;
+    pkt->checksumReset();
+    return eth_pkt;
+  }
+
+  /* IP packet of captured frame I. */
+  IPPacket::Ptr fragment(size_t i) {
+    const string& frame = dp_->frames().at(i);
+    PacketBuffer::Ptr buffer =
+        PacketBuffer::New((const uint8_t*)frame.data(), frame.size());
+    return IPPacket::New(buffer, buffer->size() - frame.size()
+                                 + EthernetPacket::kHeaderSize);
+  }
+
+  CapturingDataPlane::Ptr dp_;
+  Interface::Ptr iface_;
+};
+
+TEST_F(DataPlaneTest, fragment) {
+  EthernetPacket::Ptr eth_pkt = frame(NULL, 0, 3000);
+  IPPacket::Ptr pkt = IPPacket::Ptr::st_cast<IPPacket>(eth_pkt->payload());
+  dp_->fragmentedOutput(pkt, eth_pkt, iface_);
+
+  ASSERT_EQ((size_t)3, dp_->frames().size());
+  const size_t lens[] = { 1480, 1480, 40 };
+  size_t offset = 0;
+  for (size_t i = 0; i < 3; ++i) {
+    IPPacket::Ptr frag = fragment(i);
+    EXPECT_TRUE(frag->valid());
+    EXPECT_EQ(5, frag->headerLength());
+    EXPECT_EQ(IPPacket::kHeaderSize + lens[i], frag->packetLength());
+    EXPECT_EQ(offset / 8, frag->fragmentOffset());
+    EXPECT_EQ(i < 2 ? IPPacket::kIP_MF : 0, frag->flags());
+    offset += lens[i];
+  }
+}
+
+TEST_F(DataPlaneTest, fragment_options) {
+  // Loose Source Route (copied), Record Route (not copied), No Operation
+  // and End of Option List.
+  const uint8_t options[] = { 0x83, 7, 4, 192, 168, 0, 1,
+                              0x07, 7, 4, 0, 0, 0, 0,
+                              0x01, 0x00 };
+  EthernetPacket::Ptr eth_pkt = frame(options, sizeof(options), 3000);
+  IPPacket::Ptr pkt = IPPacket::Ptr::st_cast<IPPacket>(eth_pkt->payload());
+  ASSERT_TRUE(pkt->valid());
+  dp_->fragmentedOutput(pkt, eth_pkt, iface_);
+
+  // The first fragment carries all options; the others only Loose Source
+  // Route, padded to 8 bytes.
+  ASSERT_EQ((size_t)3, dp_->frames().size());
+  const size_t header_lens[] = { 36, 28, 28 };
+  const size_t lens[] = { 1464, 1472, 64 };
+  size_t offset = 0;
+  for (size_t i = 0; i < 3; ++i) {
+    IPPacket::Ptr frag = fragment(i);
+    EXPECT_TRUE(frag->valid());
+    EXPECT_EQ(header_lens[i] / 4, (size_t)frag->headerLength());
+    EXPECT_EQ(header_lens[i] + lens[i], frag->packetLength());
+    EXPECT_EQ(offset / 8, frag->fragmentOffset());
+    EXPECT_EQ(i < 2 ? IPPacket::kIP_MF : 0, frag->flags());
+    EXPECT_EQ(1234, frag->identification());
+
+    const uint8_t* const header_options =
+        frag->data() + IPPacket::kHeaderSize;
+    if (i == 0) {
+      EXPECT_EQ(0, memcmp(options, header_options, sizeof(options)));
+    } else {
+      EXPECT_EQ(0, memcmp(options, header_options, 7));
+      EXPECT_EQ(0, header_options[7]);
+    }
+
+    // The payload follows the options, at its offset in the datagram.
+    for (size_t j = 0; j < lens[i]; ++j)
+      ASSERT_EQ((offset + j) % 251, frag->data()[header_lens[i] + j]);
+    offset += lens[i];
+  }
+  EXPECT_EQ((size_t)3000, offset);
+}
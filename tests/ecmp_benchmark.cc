@@ -0,0 +1,100 @@
+/* Benchmark of equal-cost multipath next hop selection. Random UDP flows
+   are hashed onto next-hop groups of increasing size, as in the forwarding
+   path; for every group, the share of flows carried by the least and most
+   loaded next hop is reported along with the cost of a selection.
+
+   Usage: ecmp_benchmark [flows]  (default: 100000) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "fwk/log.h"
+
+#include "benchmark_util.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "routing_table.h"
+
+static const int kDefaultFlows = 100000;
+static const size_t kGroupSizes[] = { 1, 2, 4, 8 };
+static const int kPacketsPerFlow = 4;
+
+/* UDP datagram with random addresses and ports. */
+static IPPacket::Ptr
+random_flow() {
+  uint8_t packet_buffer[28] = { 0x45, 0x00, 0x00, 0x1c,
+                                0x00, 0x00, 0x00, 0x00,
+                                0x40, 0x11, 0x00, 0x00 };
+  for (size_t i = 12; i < 24; ++i)
+    packet_buffer[i] = rand() & 0xff;
+
+  PacketBuffer::Ptr buf =
+    PacketBuffer::New(packet_buffer, sizeof(packet_buffer));
+  return IPPacket::New(buf, buf->size() - sizeof(packet_buffer));
+}
+
+static void
+benchmark(const std::vector<IPPacket::Ptr>& flows, size_t group_size) {
+  std::vector<Interface::Ptr> ifaces;
+  RoutingTable::Entry::Ptr entry = RoutingTable::Entry::New();
+  entry->subnetIs("0.0.0.0", "0.0.0.0");
+  for (size_t i = 0; i < group_size; ++i) {
+    std::stringstream name;
+    name << "eth" << i;
+    ifaces.push_back(Interface::InterfaceNew(name.str()));
+
+    IPv4Addr gateway = IPv4Addr("10.0.0.1").value() + i;
+    if (i == 0) {
+      entry->gatewayIs(gateway);
+      entry->interfaceIs(ifaces[i]);
+    } else {
+      entry->nextHopNew(gateway, ifaces[i]);
+    }
+  }
+
+  std::vector<int> load(group_size, 0);
+  double start = now();
+  for (int p = 0; p < kPacketsPerFlow; ++p) {
+    for (size_t i = 0; i < flows.size(); ++i) {
+      const RoutingTable::Entry::NextHop& next_hop =
+        entry->flowNextHop(flows[i]->flowHash());
+      if (p == 0)
+        ++load[next_hop.gateway().value() - entry->gateway().value()];
+    }
+  }
+  double elapsed = now() - start;
+
+  int min = load[0];
+  int max = load[0];
+  for (size_t i = 1; i < group_size; ++i) {
+    min = (load[i] < min) ? load[i] : min;
+    max = (load[i] > max) ? load[i] : max;
+  }
+
+  double fair = 100.0 / group_size;
+  printf("%2zu next hops  fair share: %6.2f%%  min: %6.2f%%  max: %6.2f%%  "
+         "selection: %6.1f ns\n", group_size, fair,
+         100.0 * min / flows.size(), 100.0 * max / flows.size(),
+         elapsed * 1e9 / (flows.size() * kPacketsPerFlow));
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int flow_count = (argc > 1) ? atoi(argv[1]) : kDefaultFlows;
+
+  srand(flow_count);
+  std::vector<IPPacket::Ptr> flows;
+  for (int i = 0; i < flow_count; ++i)
+    flows.push_back(random_flow());
+
+  for (size_t i = 0; i < sizeof(kGroupSizes) / sizeof(size_t); ++i)
+    benchmark(flows, kGroupSizes[i]);
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+/* Fragmentation of jumbo datagrams. UDP datagrams of kDatagramLen bytes are
+   forwarded out of an interface with an MTU of kMTU bytes, first as they
+   were fragmented before: every fragment copied into a buffer of its own
+   and sent through ControlPlane::outputPacketNew, which looks up its route
+   and next hop again. Then by the control plane, which sends the fragments
+   straight from the datagram, with only their headers rewritten. Last, as
+   transit datagrams arriving at the data plane, which fragments them the
+   same way without handing them to the control plane. The data plane
+   counts the fragments instead of writing them to a device.
+
+   Usage: fragmentation_benchmark [datagrams]  (default: 200000) */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "fwk/log.h"
+
+#include "arp_cache.h"
+#include "benchmark_util.h"
+#include "control_plane.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "routing_table.h"
+
+static const int kDefaultDatagrams = 200000;
+static const size_t kDatagramLen = 9000;
+static const size_t kMTU = 1500;
+
+enum Mode {
+  kCopy,
+  kControlPlane,
+  kDataPlane
+};
+
+/* UDP datagram of kDatagramLen bytes to DST. */
+static IPPacket::Ptr
+datagram(const IPv4Addr& dst) {
+  PacketBuffer::Ptr buffer =
+      PacketBuffer::New(kDatagramLen + EthernetPacket::kHeaderSize);
+  IPPacket::Ptr pkt =
+      IPPacket::New(buffer, buffer->size() - kDatagramLen);
+  memset(pkt->data(), 0xab, kDatagramLen);
+  pkt->versionIs(4);
+  pkt->headerLengthIs(IPPacket::kHeaderSize / 4);
+  pkt->packetLengthIs(kDatagramLen);
+  pkt->diffServicesAre(0);
+  pkt->identificationIs(1234);
+  pkt->flagsAre(0);
+  pkt->fragmentOffsetIs(0);
+  pkt->ttlIs(64);
+  pkt->protocolIs(IPPacket::kUDP);
+  pkt->srcIs("172.16.0.2");
+  pkt->dstIs(dst);
+  pkt->checksumReset();
+  return pkt;
+}
+
+/* Fragments PKT as ControlPlane did before: each fragment is copied into a
+   new buffer and output on its own. */
+static void
+fragment_and_copy(ControlPlane::Ptr cp, IPPacket::Ptr pkt) {
+  const size_t max_payload_size = (kMTU - IPPacket::kHeaderSize) / 8 * 8;
+  size_t bytes_left = pkt->len() - IPPacket::kHeaderSize;
+  size_t fragment_offset = 0;
+  while (bytes_left > 0) {
+    const size_t fragment_payload_size = std::min(bytes_left,
+                                                  max_payload_size);
+    const bool last_fragment = (fragment_payload_size == bytes_left);
+    const size_t fragment_size = IPPacket::kHeaderSize + fragment_payload_size;
+
+    PacketBuffer::Ptr buffer = PacketBuffer::New(fragment_size);
+    IPPacket::Ptr fragment =
+        IPPacket::New(buffer, buffer->size() - fragment_size);
+    fragment->versionIs(4);
+    fragment->headerLengthIs(IPPacket::kHeaderSize / 4);
+    fragment->packetLengthIs(fragment->len());
+    fragment->diffServicesAre(pkt->diffServices());
+    fragment->protocolIs(pkt->protocol());
+    fragment->srcIs(pkt->src());
+    fragment->dstIs(pkt->dst());
+    fragment->ttlIs(pkt->ttl());
+    fragment->identificationIs(pkt->identification());
+    fragment->flagsAre(last_fragment ? 0 : IPPacket::kIP_MF);
+    fragment->fragmentOffsetIs(fragment_offset);
+    memcpy(fragment->data() + IPPacket::kHeaderSize,
+           pkt->data() + IPPacket::kHeaderSize + (fragment_offset * 8),
+           fragment_payload_size);
+    fragment->checksumReset();
+
+    cp->outputPacketNew(fragment);
+
+    bytes_left -= fragment_payload_size;
+    fragment_offset += fragment_payload_size / 8;
+  }
+}
+
+static void
+benchmark(int datagrams, Mode mode) {
+  ControlPlane::Ptr cp = ControlPlane::ControlPlaneNew();
+  CountingDataPlane::Ptr dp = CountingDataPlane::New(cp->arpCache());
+  Interface::Ptr iface = Interface::InterfaceNew("eth0");
+  iface->ipIs("192.168.0.1");
+  iface->subnetMaskIs("255.255.255.0");
+  iface->macIs("02:00:00:00:00:01");
+  dp->interfaceMap()->interfaceIs(iface);
+  cp->dataPlaneIs(dp);
+  dp->controlPlaneIs(cp.ptr());
+  dp->routingTableIs(cp->routingTable());
+
+  // Before, fragments were no larger than the Ethernet MTU; the datagram
+  // leaves the control plane whole and is fragmented here.
+  iface->mtuIs(mode == kCopy ? kDatagramLen : kMTU);
+
+  RoutingTable::Entry::Ptr entry =
+      RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  entry->subnetIs("10.0.0.0", "255.0.0.0");
+  entry->gatewayIs("192.168.0.2");
+  entry->interfaceIs(iface);
+  cp->routingTable()->entryIs(entry);
+
+  ARPCache::Entry::Ptr arp_entry =
+      ARPCache::Entry::New("192.168.0.2", "02:00:00:00:00:02");
+  arp_entry->typeIs(ARPCache::Entry::kStatic);
+  cp->arpCache()->entryIs(arp_entry);
+
+  IPPacket::Ptr pkt = datagram("10.0.0.1");
+  const double start = now();
+  for (int i = 0; i < datagrams; ++i) {
+    if (mode == kCopy) {
+      fragment_and_copy(cp, pkt);
+    } else if (mode == kControlPlane) {
+      cp->outputPacketNew(pkt);
+    } else {
+      // Forwarding decrements the TTL in place.
+      pkt->ttlIs(64);
+      pkt->checksumReset();
+      dp->packetNew(pkt, iface);
+    }
+  }
+  const double elapsed = now() - start;
+
+  static const char* const kModeNames[] = {
+    "copy", "zero copy", "data plane"
+  };
+  printf("%-10s  %8.0f datagrams/s  %7.3f Gbit/s  %.1f frames/datagram\n",
+         kModeNames[mode],
+         datagrams / elapsed,
+         8.0 * kDatagramLen * datagrams / elapsed / 1e9,
+         (double)dp->frames() / datagrams);
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int datagrams = (argc > 1) ? atoi(argv[1]) : kDefaultDatagrams;
+
+  printf("%d datagrams of %zu bytes, MTU %zu\n",
+         datagrams, kDatagramLen, kMTU);
+  benchmark(datagrams, kCopy);
+  benchmark(datagrams, kControlPlane);
+  benchmark(datagrams, kDataPlane);
+
+  return 0;
+}
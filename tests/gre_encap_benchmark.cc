@@ -0,0 +1,134 @@
+/* GRE encapsulation of packets routed to a tunnel. UDP datagrams of
+   kPacketLen bytes are sent through a tunnel whose remote endpoint is
+   reached through a gateway, both as every packet routed to a tunnel was
+   before: handed to ControlPlane::outputPacketNew, which looks up the
+   tunnel, the route to its remote endpoint, then the route and ARP entry
+   of the encapsulated packet, and builds its outer headers field by field;
+   and by the data plane, which copies the outer headers built for the
+   tunnel and fills in their length, identification and checksum. The data
+   plane counts the frames instead of writing them to a device.
+
+   Usage: gre_encap_benchmark [packets]  (default: 2000000) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fwk/log.h"
+#include "fwk/scoped_lock.h"
+
+#include "arp_cache.h"
+#include "benchmark_util.h"
+#include "control_plane.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "routing_table.h"
+#include "tunnel.h"
+#include "tunnel_map.h"
+
+static const int kDefaultPackets = 2000000;
+static const size_t kPacketLen = 512;
+
+/* UDP datagram of kPacketLen bytes to DST, with room in front of it for
+   the outer headers. */
+static IPPacket::Ptr
+datagram(const IPv4Addr& dst) {
+  PacketBuffer::Ptr buffer =
+      PacketBuffer::New(kPacketLen + Tunnel::Encap::kMaxHeaderSize);
+  IPPacket::Ptr pkt = IPPacket::New(buffer, buffer->size() - kPacketLen);
+  memset(pkt->data(), 0xab, kPacketLen);
+  pkt->versionIs(4);
+  pkt->headerLengthIs(IPPacket::kHeaderSize / 4);
+  pkt->packetLengthIs(kPacketLen);
+  pkt->diffServicesAre(0);
+  pkt->identificationIs(1234);
+  pkt->flagsAre(0);
+  pkt->fragmentOffsetIs(0);
+  pkt->ttlIs(64);
+  pkt->protocolIs(IPPacket::kUDP);
+  pkt->srcIs("172.16.0.2");
+  pkt->dstIs(dst);
+  pkt->checksumReset();
+  return pkt;
+}
+
+static void
+benchmark(int packets, bool templated) {
+  ControlPlane::Ptr cp = ControlPlane::ControlPlaneNew();
+  CountingDataPlane::Ptr dp = CountingDataPlane::New(cp->arpCache());
+  Interface::Ptr iface = Interface::InterfaceNew("eth0");
+  iface->ipIs("192.168.0.1");
+  iface->subnetMaskIs("255.255.255.0");
+  iface->macIs("02:00:00:00:00:01");
+  dp->interfaceMap()->interfaceIs(iface);
+  cp->dataPlaneIs(dp);
+  dp->controlPlaneIs(cp.ptr());
+  dp->routingTableIs(cp->routingTable());
+
+  Interface::Ptr tun_iface = Interface::InterfaceNew("tun0");
+  tun_iface->typeIs(Interface::kVirtual);
+  tun_iface->enabledIs(true);
+  Tunnel::Ptr tunnel = Tunnel::New(tun_iface);
+  tunnel->remoteIs("10.0.0.1");
+  dp->interfaceMap()->interfaceIs(tun_iface);
+  cp->tunnelMap()->tunnelIs(tunnel);
+
+  // The remote endpoint is behind a gateway; the destinations of the
+  // packets are behind the tunnel.
+  RoutingTable::Entry::Ptr entry =
+      RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  entry->subnetIs("10.0.0.0", "255.0.0.0");
+  entry->gatewayIs("192.168.0.2");
+  entry->interfaceIs(iface);
+  cp->routingTable()->entryIs(entry);
+
+  entry = RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  entry->subnetIs("172.20.0.0", "255.255.0.0");
+  entry->interfaceIs(tun_iface);
+  cp->routingTable()->entryIs(entry);
+
+  ARPCache::Entry::Ptr arp_entry =
+      ARPCache::Entry::New("192.168.0.2", "02:00:00:00:00:02");
+  arp_entry->typeIs(ARPCache::Entry::kStatic);
+  cp->arpCache()->entryIs(arp_entry);
+
+  // The first packet through the tunnel builds its outer headers.
+  IPPacket::Ptr pkt = datagram("172.20.0.1");
+  cp->outputPacketNew(pkt);
+
+  unsigned long slow = 0;
+  const double start = now();
+  for (int i = 0; i < packets; ++i) {
+    if (!templated) {
+      cp->outputPacketNew(pkt);
+    } else if (!dp->encapsulatedOutput(pkt, tun_iface)) {
+      cp->outputPacketNew(pkt);
+      ++slow;
+    }
+  }
+  const double elapsed = now() - start;
+
+  printf("%-13s  %9.0f packets/s  %6.1f ns/packet  %lu frames  "
+         "%lu through the control plane\n",
+         templated ? "template" : "control plane",
+         packets / elapsed, elapsed / packets * 1e9,
+         dp->frames() - 1, templated ? slow : packets);
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int packets = (argc > 1) ? atoi(argv[1]) : kDefaultPackets;
+
+  printf("%d packets of %zu bytes through a GRE tunnel\n",
+         packets, kPacketLen);
+  benchmark(packets, false);
+  benchmark(packets, true);
+
+  return 0;
+}
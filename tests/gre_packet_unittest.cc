@@ -137,13 +137,14 @@ TEST_F(GREPacketTest, reserved0) {
   // Query the reserved0 bits.
   EXPECT_EQ(0, pkt_->reserved0());
 
-  // Set the reserved0 bits.
-  pkt_->reserved0Is(0x0FFF);  // 12 bits
-  EXPECT_EQ(0x0FFF, pkt_->reserved0());
+  // Set the reserved0 bits: 12 bits, less the K bit.
+  pkt_->reserved0Is(0x0FFF);
+  EXPECT_EQ(0x0BFF, pkt_->reserved0());
+  EXPECT_FALSE(pkt_->keyPresent());
 
   // Try to set more than 12 bits.
   pkt_->reserved0Is(0xFFFF);
-  EXPECT_EQ(0x0FFF, pkt_->reserved0());
+  EXPECT_EQ(0x0BFF, pkt_->reserved0());
 
   // Reset. Only the reserved0 field should have changed.
   pkt_->reserved0Is(0);
@@ -215,6 +216,50 @@ TEST_F(GREPacketTest, reserved1) {
 }
 
 
+TEST_F(GREPacketTest, key) {
+  uint8_t gre_packet[] = { 0xA0,                    // C and K bits
+                           0x00,                    // Version = 0
+                           0x08, 0x00,              // Ptype = IP
+                           0x00, 0x00,              // Checksum
+                           0x00, 0x00,              // Reserved1
+                           0x12, 0x34, 0x56, 0x78,  // Key
+                           0x45 };                  // Start of IP packet
+  PacketBuffer::Ptr buf = PacketBuffer::New(gre_packet, sizeof(gre_packet));
+  GREPacket::Ptr pkt =
+      GREPacket::GREPacketNew(buf, buf->size() - sizeof(gre_packet));
+  pkt->checksumReset();
+
+  EXPECT_TRUE(pkt->keyPresent());
+  EXPECT_EQ((uint32_t)0x12345678, pkt->key());
+  EXPECT_EQ((size_t)12, pkt->headerLen());
+  EXPECT_EQ(0, pkt->reserved0());
+  EXPECT_TRUE(pkt->valid());
+
+  // The payload follows the key.
+  EXPECT_EQ(0x45, pkt->payload()->data()[0]);
+
+  // Without the checksum, the key immediately follows the protocol type.
+  pkt->checksumPresentIs(false);
+  EXPECT_EQ((size_t)8, pkt->headerLen());
+  pkt->keyIs(0xDEADBEEF);
+  EXPECT_EQ((uint32_t)0xDEADBEEF, pkt->key());
+  EXPECT_EQ(0xDE, pkt->data()[4]);
+
+  // The key is 0 and cannot be set if it is not present.
+  pkt->keyPresentIs(false);
+  EXPECT_EQ((uint32_t)0, pkt->key());
+  EXPECT_EQ((size_t)4, pkt->headerLen());
+  pkt->keyIs(1);
+  pkt->keyPresentIs(true);
+  EXPECT_EQ((uint32_t)0xDEADBEEF, pkt->key());
+
+  // The key does not fit in a 4-byte packet.
+  PacketBuffer::Ptr short_buf = PacketBuffer::New(gre_packet, 4);
+  EXPECT_FALSE(GREPacket::GREPacketNew(short_buf, short_buf->size() - 4)
+               ->valid());
+}
+
+
 TEST_F(GREPacketTest, payload) {
   // Extract the excapsulated packet.
   Packet::Ptr payload = pkt_->payload();
@@ -0,0 +1,120 @@
+#include <cstdlib>
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include "fwk/flat_map.h"
+#include "fwk/hash_map.h"
+#include "fwk/ptr_interface.h"
+
+#include "ospf_router_id.h"
+
+
+namespace {
+
+class Value : public Fwk::PtrInterface<Value> {
+ public:
+  typedef Fwk::Ptr<const Value> PtrConst;
+  typedef Fwk::Ptr<Value> Ptr;
+
+  static Ptr New(int v) { return new Value(v); }
+
+  int value() const { return value_; }
+
+ private:
+  explicit Value(int v) : value_(v) {}
+
+  int value_;
+};
+
+}  // namespace
+
+
+TEST(HashMapTest, basic) {
+  Fwk::HashMap<RouterID,Value> map;
+  EXPECT_TRUE(map.elem(1) == NULL);
+  map.elemDel(1);
+
+  map[1] = Value::New(10);
+  map.elemIs(2, Value::New(20));
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(10, map.elem(1)->value());
+  EXPECT_EQ(20, map.elem(2)->value());
+  EXPECT_EQ(0u, map.index(1));
+  EXPECT_EQ(1u, map.index(2));
+
+  /* The last element takes the place of a removed one. */
+  map.elemDel(1);
+  EXPECT_EQ(1u, map.size());
+  EXPECT_TRUE(map.elem(1) == NULL);
+  EXPECT_EQ(0u, map.index(2));
+  EXPECT_EQ(RouterID(2), map.begin()->first);
+  EXPECT_EQ(map.kNotFound, map.index(1));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.elem(2) == NULL);
+}
+
+
+/* Random insertions and removals, checked against std::map. Keys are drawn
+   from a small range so that probe sequences collide and removals have to
+   shift entries back. */
+TEST(HashMapTest, random) {
+  Fwk::HashMap<RouterID,Value> map;
+  std::map<uint32_t,int> reference;
+
+  srand(1);
+  for (int i = 0; i < 20000; ++i) {
+    uint32_t key = rand() % 512;
+    if (rand() % 3 == 0) {
+      map.elemDel(key);
+      reference.erase(key);
+    } else {
+      map[key] = Value::New(i);
+      reference[key] = i;
+    }
+
+    ASSERT_EQ(reference.size(), map.size());
+  }
+
+  for (uint32_t key = 0; key < 512; ++key) {
+    Value::Ptr value = map.elem(key);
+    if (reference.count(key)) {
+      ASSERT_TRUE(value != NULL);
+      EXPECT_EQ(reference[key], value->value());
+    } else {
+      EXPECT_TRUE(value == NULL);
+    }
+  }
+
+  /* Every element is reached exactly once by iteration. */
+  size_t count = 0;
+  for (Fwk::HashMap<RouterID,Value>::iterator it = map.begin();
+       it != map.end(); ++it, ++count) {
+    EXPECT_EQ(count, map.index(it->first));
+  }
+  EXPECT_EQ(reference.size(), count);
+}
+
+
+TEST(FlatMapTest, ordered) {
+  Fwk::FlatMap<RouterID,Value> map;
+  uint32_t keys[] = { 5, 1, 4, 2, 3 };
+  for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i)
+    map[keys[i]] = Value::New(keys[i] * 10);
+
+  map.elemDel(4);
+  map.elemDel(6);
+  ASSERT_EQ(4u, map.size());
+  EXPECT_TRUE(map.elem(4) == NULL);
+  EXPECT_EQ(30, map.elem(3)->value());
+
+  /* Elements are visited in key order, as with Fwk::Map. */
+  uint32_t expected[] = { 1, 2, 3, 5 };
+  size_t i = 0;
+  for (Fwk::FlatMap<RouterID,Value>::const_iterator it = map.begin();
+       it != map.end(); ++it, ++i) {
+    EXPECT_EQ(RouterID(expected[i]), it->first);
+  }
+}
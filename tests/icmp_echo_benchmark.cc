@@ -0,0 +1,139 @@
+/* Answers to pings of the router's addresses. Echo Requests of kPacketLen
+   bytes from a neighbor are handed to the data plane and answered both as
+   every request was before: punted to the ControlPlane, which turns the
+   request around, recomputes its checksums and sends it through
+   outputPacketNew, with its route, ARP and fragmentation checks; and by the
+   data plane, which turns the request around in place, updates the ICMP
+   checksum and sends the reply back to the neighbor it came from. Requests
+   that arrive on a tunnel still take the first way, so that is how the
+   first run receives them. The data plane counts the frames instead of
+   writing them to a device.
+
+   Usage: icmp_echo_benchmark [packets]  (default: 2000000) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fwk/log.h"
+
+#include "arp_cache.h"
+#include "benchmark_util.h"
+#include "control_plane.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "icmp_packet.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "punt_queue.h"
+#include "routing_table.h"
+
+static const int kDefaultPackets = 2000000;
+static const size_t kPacketLen = 84;
+
+/* Ethernet frame carrying an Echo Request of kPacketLen bytes from
+   192.168.0.2 to 192.168.0.1. */
+static EthernetPacket::Ptr
+request() {
+  const size_t len = EthernetPacket::kHeaderSize + kPacketLen;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(len);
+  EthernetPacket::Ptr eth_pkt =
+      EthernetPacket::New(buffer, buffer->size() - len);
+  eth_pkt->dstIs("02:00:00:00:00:01");
+  eth_pkt->srcIs("02:00:00:00:00:02");
+  eth_pkt->typeIs(EthernetPacket::kIP);
+
+  IPPacket::Ptr pkt = IPPacket::Ptr::st_cast<IPPacket>(eth_pkt->payload());
+  memset(pkt->data(), 0xab, kPacketLen);
+  pkt->versionIs(4);
+  pkt->headerLengthIs(IPPacket::kHeaderSize / 4);
+  pkt->packetLengthIs(kPacketLen);
+  pkt->diffServicesAre(0);
+  pkt->identificationIs(1234);
+  pkt->flagsAre(0);
+  pkt->fragmentOffsetIs(0);
+  pkt->ttlIs(64);
+  pkt->protocolIs(IPPacket::kICMP);
+  pkt->srcIs("192.168.0.2");
+  pkt->dstIs("192.168.0.1");
+  pkt->checksumReset();
+
+  ICMPPacket::Ptr icmp_pkt =
+      ICMPPacket::Ptr::st_cast<ICMPPacket>(pkt->payload());
+  icmp_pkt->typeIs(ICMPPacket::kEchoRequest);
+  icmp_pkt->codeIs((ICMPPacket::Code)0);
+  icmp_pkt->checksumReset();
+  return eth_pkt;
+}
+
+static void
+benchmark(int packets, bool fast_path) {
+  ControlPlane::Ptr cp = ControlPlane::ControlPlaneNew();
+  CountingDataPlane::Ptr dp = CountingDataPlane::New(cp->arpCache());
+  Interface::Ptr iface = Interface::InterfaceNew("eth0");
+  iface->ipIs("192.168.0.1");
+  iface->subnetMaskIs("255.255.255.0");
+  iface->macIs("02:00:00:00:00:01");
+  dp->interfaceMap()->interfaceIs(iface);
+  cp->dataPlaneIs(dp);
+  dp->controlPlaneIs(cp.ptr());
+  dp->routingTableIs(cp->routingTable());
+
+  Interface::Ptr tun_iface = Interface::InterfaceNew("tun0");
+  tun_iface->typeIs(Interface::kVirtual);
+  tun_iface->enabledIs(true);
+  dp->interfaceMap()->interfaceIs(tun_iface);
+
+  // The policer runs on real time; it is not what is measured here.
+  dp->puntQueue()->rateIs(PuntQueue::kEcho, 0);
+
+  RoutingTable::Entry::Ptr entry =
+      RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  entry->subnetIs("192.168.0.0", "255.255.255.0");
+  entry->interfaceIs(iface);
+  cp->routingTable()->entryIs(entry);
+
+  ARPCache::Entry::Ptr arp_entry =
+      ARPCache::Entry::New("192.168.0.2", "02:00:00:00:00:02");
+  arp_entry->typeIs(ARPCache::Entry::kStatic);
+  cp->arpCache()->entryIs(arp_entry);
+
+  // Requests are answered in place, so each one is copied from a template.
+  EthernetPacket::Ptr tmpl = request();
+  const size_t len = tmpl->len();
+
+  const double start = now();
+  for (int i = 0; i < packets; ++i) {
+    PacketBuffer::Ptr buffer = PacketBuffer::New(len);
+    EthernetPacket::Ptr eth_pkt =
+        EthernetPacket::New(buffer, buffer->size() - len);
+    memcpy(eth_pkt->data(), tmpl->data(), len);
+    if (fast_path) {
+      dp->packetNew(eth_pkt->payload(), iface);
+    } else {
+      dp->packetNew(eth_pkt->payload(), tun_iface);
+      dp->puntedPacketsDispatch(1);
+    }
+  }
+  const double elapsed = now() - start;
+
+  printf("%-13s  %9.0f packets/s  %6.1f ns/packet  %lu replies\n",
+         fast_path ? "data plane" : "control plane",
+         packets / elapsed, elapsed / packets * 1e9, dp->frames());
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int packets = (argc > 1) ? atoi(argv[1]) : kDefaultPackets;
+
+  printf("%d Echo Requests of %zu bytes to the router\n",
+         packets, kPacketLen);
+  benchmark(packets, false);
+  benchmark(packets, true);
+
+  return 0;
+}
@@ -92,5 +92,20 @@ TEST_F(ICMPPacketTest, checksum) {
 }
 
 
+TEST_F(ICMPPacketTest, nextHopMTU) {
+  ICMPDestUnreachablePacket::Ptr du_pkt = ICMPDestUnreachablePacket::New(pkt_);
+  du_pkt->codeIs(ICMPPacket::kFragRequired);
+  EXPECT_EQ((uint16_t)0, du_pkt->nextHopMTU());
+
+  // The MTU is in the lower half of the second word, in NBO (RFC 1191).
+  du_pkt->nextHopMTUIs(1476);
+  EXPECT_EQ((uint16_t)1476, du_pkt->nextHopMTU());
+  const uint8_t* const rest = du_pkt->data() + 4;
+  EXPECT_EQ((uint8_t)0x00, rest[0]);
+  EXPECT_EQ((uint8_t)0x00, rest[1]);
+  EXPECT_EQ((uint8_t)0x05, rest[2]);
+  EXPECT_EQ((uint8_t)0xC4, rest[3]);
+}
+
+
 // TODO(ms): Need tests for subtype ICMP packets.
-// TODO(ms): Need tests for "rest of header"
@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+
+#include "icmp_rate_limiter.h"
+#include "ipv4_addr.h"
+#include "time_types.h"
+
+class ICMPRateLimiterTest : public ::testing::Test {
+ protected:
+  ICMPRateLimiterTest() : limiter_(ICMPRateLimiter::New()) {
+    limiter_->rateIs(100);
+    limiter_->burstIs(20);
+    limiter_->sourcePrefixLenIs(24);
+    limiter_->sourceRateIs(10, 5);
+  }
+
+  /* Number of errors to DEST allowed out of COUNT at time NOW. */
+  int allowed(const IPv4Addr& dest, int count, const Milliseconds& now) {
+    int allowed = 0;
+    for (int i = 0; i < count; ++i) {
+      if (limiter_->onError(dest, now))
+        ++allowed;
+    }
+    return allowed;
+  }
+
+  ICMPRateLimiter::Ptr limiter_;
+};
+
+TEST_F(ICMPRateLimiterTest, source) {
+  // A source prefix gets its burst, then 10 errors per second.
+  EXPECT_EQ(5, allowed(0x0a000001, 10, 1000));
+  EXPECT_EQ(0, allowed(0x0a000002, 10, 1050));
+  EXPECT_EQ(1, allowed(0x0a0000ff, 10, 1100));
+  EXPECT_EQ((uint64_t)6, limiter_->sent());
+  EXPECT_EQ((uint64_t)24, limiter_->sourceSuppressed());
+  EXPECT_EQ((uint64_t)0, limiter_->globalSuppressed());
+
+  // Other prefixes have budgets of their own.
+  EXPECT_EQ(5, allowed(0x0a000101, 10, 1100));
+  EXPECT_EQ((size_t)2, limiter_->sources());
+
+  limiter_->statsDel();
+  EXPECT_EQ((uint64_t)0, limiter_->sent());
+  EXPECT_EQ((uint64_t)0, limiter_->sourceSuppressed());
+}
+
+TEST_F(ICMPRateLimiterTest, global) {
+  // Errors to many prefixes are bounded by the global limit.
+  int sent = 0;
+  for (uint32_t i = 0; i < 30; ++i)
+    sent += allowed(0x0a000001 + (i << 8), 1, 1000);
+  EXPECT_EQ(20, sent);
+  EXPECT_EQ((uint64_t)10, limiter_->globalSuppressed());
+
+  // 100 errors per second: one every 10 ms.
+  EXPECT_EQ(1, allowed(0x0b000001, 5, 1010));
+
+  // Without a global limit, only the source limits apply.
+  limiter_->rateIs(0);
+  EXPECT_EQ(5, allowed(0x0c000001, 10, 1010));
+}
+
+TEST_F(ICMPRateLimiterTest, globalNotCharged) {
+  // Errors the global limit suppresses are not charged to their source.
+  for (uint32_t i = 0; i < 20; ++i)
+    allowed(0x0a000001 + (i << 8), 1, 1000);
+  EXPECT_EQ(0, allowed(0x0b000001, 10, 1000));
+  EXPECT_EQ((uint64_t)10, limiter_->globalSuppressed());
+  EXPECT_EQ((uint64_t)0, limiter_->sourceSuppressed());
+
+  // The prefix still has its full burst once the global bucket refills.
+  EXPECT_EQ(5, allowed(0x0b000001, 10, 1100));
+}
+
+TEST_F(ICMPRateLimiterTest, prefixLen) {
+  // With /16 prefixes, hosts of neighboring /24s share a budget.
+  limiter_->sourcePrefixLenIs(16);
+  EXPECT_EQ(3, allowed(0x0a000001, 3, 1000));
+  EXPECT_EQ(2, allowed(0x0a00ff01, 3, 1000));
+
+  // A source rate of zero disables the source limit.
+  limiter_->sourceRateIs(0, 0);
+  EXPECT_EQ(10, allowed(0x0a000001, 10, 1000));
+  EXPECT_EQ((size_t)0, limiter_->sources());
+}
+
+TEST_F(ICMPRateLimiterTest, sourceTableFull) {
+  limiter_->rateIs(0);
+
+  // Fill the table with prefixes that are being limited.
+  for (uint32_t i = 0; i < ICMPRateLimiter::kMaxSources; ++i)
+    allowed(i << 8, 5, 1000);
+  EXPECT_EQ(ICMPRateLimiter::kMaxSources, limiter_->sources());
+
+  // Further prefixes are not tracked while none can be forgotten.
+  EXPECT_EQ(10, allowed(0xc0a80001, 10, 1000));
+  EXPECT_EQ(ICMPRateLimiter::kMaxSources, limiter_->sources());
+
+  // Once the buckets are full again, prefixes are replaced.
+  EXPECT_EQ(5, allowed(0xc0a80001, 10, 2000));
+  EXPECT_EQ((size_t)1, limiter_->sources());
+}
+
+TEST_F(ICMPRateLimiterTest, sourceAge) {
+  limiter_->rateIs(0);
+
+  for (uint32_t i = 0; i < ICMPRateLimiter::kMaxSources; ++i)
+    allowed(i << 8, 5, 1000);
+
+  // The first prefix is charged again, so it is no longer the oldest.
+  EXPECT_EQ(5, allowed(0x00000001, 10, 1600));
+
+  // Prefixes charged before it are forgotten once full; it is kept while
+  // its bucket refills.
+  EXPECT_EQ(5, allowed(0xc0a80001, 10, 1600));
+  EXPECT_EQ((size_t)2, limiter_->sources());
+  EXPECT_EQ(0, allowed(0x00000001, 1, 1600));
+}
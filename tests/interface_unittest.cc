@@ -71,3 +71,15 @@ TEST_F(InterfaceTest, Enabled) {
   iface_->enabledIs(enabled);
   EXPECT_EQ(enabled, iface_->enabled());
 }
+
+
+TEST_F(InterfaceTest, MTU) {
+  EXPECT_EQ(EthernetPacket::kMTU, iface_->mtu());
+
+  iface_->mtuIs(9000);
+  EXPECT_EQ((size_t)9000, iface_->mtu());
+
+  // MTUs below the IPv4 minimum are raised to it.
+  iface_->mtuIs(20);
+  EXPECT_EQ(Interface::kMinMTU, iface_->mtu());
+}
@@ -0,0 +1,35 @@
+#include "gtest/gtest.h"
+
+#include <inttypes.h>
+
+#include "ip_id_generator.h"
+#include "ipv4_addr.h"
+
+class IPIDGeneratorTest : public ::testing::Test {
+ protected:
+  IPIDGeneratorTest() : ids_(IPIDGenerator::New()) { }
+
+  IPIDGenerator::Ptr ids_;
+};
+
+TEST_F(IPIDGeneratorTest, consecutive) {
+  // Datagrams to a destination get consecutive IDs, wrapping around at 2^16.
+  const IPv4Addr dest("10.0.0.1");
+  uint16_t id = ids_->next(dest);
+  for (int i = 0; i < 70000; ++i) {
+    const uint16_t next = ids_->next(dest);
+    EXPECT_EQ((uint16_t)(id + 1), next);
+    id = next;
+  }
+}
+
+TEST_F(IPIDGeneratorTest, destinations) {
+  // Datagrams to other destinations do not advance the IDs of a destination
+  // that does not share their counter.
+  const IPv4Addr dest("10.0.0.1");
+  const IPv4Addr other("10.0.0.2");
+  const uint16_t id = ids_->next(dest);
+  for (int i = 0; i < 100; ++i)
+    ids_->next(other);
+  EXPECT_EQ((uint16_t)(id + 1), ids_->next(dest));
+}
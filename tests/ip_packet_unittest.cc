@@ -163,6 +163,138 @@ TEST_F(IPPacketTest, ip_src_dst) {
   EXPECT_EQ(*(uint32_t *)&ip_hdr_[16], ip_two.nbo());
 }
 
+/* UDP datagram from 10.0.0.1:SRC_PORT to 10.0.0.2:53. */
+static IPPacket::Ptr
+udp_packet(uint16_t src_port) {
+  uint8_t packet_buffer[] = { 0x45, 0x00, 0x00, 0x1c,
+                              0x00, 0x00, 0x00, 0x00,
+                              0x40, 0x11, 0x00, 0x00,
+                              0x0a, 0x00, 0x00, 0x01,
+                              0x0a, 0x00, 0x00, 0x02,
+                              (uint8_t)(src_port >> 8),
+                              (uint8_t)(src_port & 0xff), 0x00, 0x35,
+                              0x00, 0x08, 0x00, 0x00 };
+
+  PacketBuffer::Ptr buf =
+    PacketBuffer::New(packet_buffer, sizeof(packet_buffer));
+  return IPPacket::New(buf, buf->size() - sizeof(packet_buffer));
+}
+
+TEST_F(IPPacketTest, flow_hash) {
+  IPPacket::Ptr pkt = udp_packet(1234);
+  uint32_t hash = pkt->flowHash();
+  EXPECT_EQ(hash, udp_packet(1234)->flowHash());
+
+  /* Fields that change hop by hop are not part of the flow. */
+  pkt->ttlDec(1);
+  pkt->checksumReset();
+  EXPECT_EQ(hash, pkt->flowHash());
+
+  /* Ports, addresses and protocol are. */
+  EXPECT_NE(hash, udp_packet(1235)->flowHash());
+
+  IPPacket::Ptr other = udp_packet(1234);
+  other->dstIs("10.0.0.3");
+  EXPECT_NE(hash, other->flowHash());
+
+  other = udp_packet(1234);
+  other->protocolIs(IPPacket::kTCP);
+  EXPECT_NE(hash, other->flowHash());
+
+  /* Ports are ignored for fragments, since only the first one has them. */
+  IPPacket::Ptr frag_a = udp_packet(1234);
+  IPPacket::Ptr frag_b = udp_packet(1235);
+  frag_a->flagsAre(IPPacket::kIP_MF);
+  frag_b->fragmentOffsetIs(0x10);
+  EXPECT_EQ(frag_a->flowHash(), frag_b->flowHash());
+}
+
+/* TCP SYN from 10.0.0.1 to 10.0.0.2 with an MSS option of 1460, after a
+   no-op if MSS_ODD, so that the option starts at an odd offset. */
+static IPPacket::Ptr
+tcp_syn(bool mss_odd) {
+  uint8_t packet_buffer[] = { 0x45, 0x00, 0x00, 0x30,
+                              0x00, 0x00, 0x40, 0x00,
+                              0x40, 0x06, 0x00, 0x00,
+                              0x0a, 0x00, 0x00, 0x01,
+                              0x0a, 0x00, 0x00, 0x02,
+                              0x04, 0xd2, 0x00, 0x50, /* ports */
+                              0x00, 0x00, 0x00, 0x01, /* sequence number */
+                              0x00, 0x00, 0x00, 0x00, /* ack number */
+                              0x70, 0x02, 0xff, 0xff, /* offset, SYN, window */
+                              0x00, 0x00, 0x00, 0x00, /* checksum, urgent */
+                              0x02, 0x04, 0x05, 0xb4, /* MSS 1460 */
+                              0x01, 0x01, 0x04, 0x02  /* NOP, NOP, SACK ok */ };
+  if (mss_odd) {
+    const uint8_t options[] = { 0x01, 0x02, 0x04, 0x05,
+                                0xb4, 0x01, 0x04, 0x02 };
+    memcpy(packet_buffer + 40, options, sizeof(options));
+  }
+
+  PacketBuffer::Ptr buf =
+    PacketBuffer::New(packet_buffer, sizeof(packet_buffer));
+  IPPacket::Ptr pkt = IPPacket::New(buf, buf->size() - sizeof(packet_buffer));
+  pkt->checksumReset();
+  return pkt;
+}
+
+/* TCP checksum of the segment in PKT, including the pseudo header; 0 if the
+   checksum of the segment is valid. */
+static uint16_t
+tcp_checksum(IPPacket::Ptr pkt) {
+  const size_t tcp_len = pkt->len() - 20;
+  uint8_t buf[12 + 28];
+  memcpy(buf, pkt->data() + 12, 8);  /* addresses */
+  buf[8] = 0;
+  buf[9] = IPPacket::kTCP;
+  buf[10] = tcp_len >> 8;
+  buf[11] = tcp_len & 0xff;
+  memcpy(buf + 12, pkt->data() + 20, tcp_len);
+  return IPPacket::compute_cksum(buf, 12 + tcp_len);
+}
+
+/* Sets the TCP checksum of PKT. */
+static void
+tcp_checksum_reset(IPPacket::Ptr pkt) {
+  pkt->data()[36] = 0;
+  pkt->data()[37] = 0;
+  const uint16_t cksum = tcp_checksum(pkt);
+  pkt->data()[36] = cksum >> 8;
+  pkt->data()[37] = cksum & 0xff;
+}
+
+TEST_F(IPPacketTest, tcp_mss_clamp) {
+  for (int odd = 0; odd < 2; ++odd) {
+    IPPacket::Ptr pkt = tcp_syn(odd);
+    tcp_checksum_reset(pkt);
+    EXPECT_EQ(0, tcp_checksum(pkt));
+    const uint8_t* const mss = pkt->data() + 42 + odd;
+
+    /* MSS options at or below the limit are left alone. */
+    EXPECT_FALSE(pkt->tcpMSSClamp(1460));
+    EXPECT_EQ(0x05b4, (mss[0] << 8) | mss[1]);
+
+    /* Larger ones are lowered, and the checksum still adds up. */
+    EXPECT_TRUE(pkt->tcpMSSClamp(1436));
+    EXPECT_EQ(0x059c, (mss[0] << 8) | mss[1]);
+    EXPECT_EQ(0, tcp_checksum(pkt));
+  }
+
+  /* Only SYNs are clamped. */
+  IPPacket::Ptr pkt = tcp_syn(false);
+  pkt->data()[33] = 0x10;  /* ACK */
+  EXPECT_FALSE(pkt->tcpMSSClamp(1436));
+
+  /* So are only TCP segments that are not fragments. */
+  pkt = tcp_syn(false);
+  pkt->flagsAre(IPPacket::kIP_MF);
+  EXPECT_FALSE(pkt->tcpMSSClamp(1436));
+
+  pkt = tcp_syn(false);
+  pkt->protocolIs(IPPacket::kUDP);
+  EXPECT_FALSE(pkt->tcpMSSClamp(1436));
+}
+
 
 /* IPv4Addr */
 
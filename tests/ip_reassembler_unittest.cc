@@ -0,0 +1,183 @@
+#include "gtest/gtest.h"
+
+#include <inttypes.h>
+#include <vector>
+
+#include "ip_packet.h"
+#include "ip_reassembler.h"
+#include "ipv4_addr.h"
+#include "packet_buffer.h"
+#include "time_types.h"
+
+using std::vector;
+
+class IPReassemblerTest : public ::testing::Test {
+ protected:
+  IPReassemblerTest() : reassembler_(IPReassembler::New()) { }
+
+  /* Fragment of datagram ID from 10.0.0.1 with LEN bytes of payload at
+     offset BEGIN; byte i of the datagram's payload is i % 251. */
+  static IPPacket::Ptr fragment(uint16_t id, size_t begin, size_t len,
+                                bool more) {
+    const size_t pkt_len = IPPacket::kHeaderSize + len;
+    PacketBuffer::Ptr buffer = PacketBuffer::New(pkt_len);
+    IPPacket::Ptr pkt = IPPacket::New(buffer, buffer->size() - pkt_len);
+    pkt->versionIs(4);
+    pkt->headerLengthIs(IPPacket::kHeaderSize / 4);
+    pkt->packetLengthIs(pkt_len);
+    pkt->diffServicesAre(0);
+    pkt->identificationIs(id);
+    pkt->flagsAre(more ? IPPacket::kIP_MF : 0);
+    pkt->fragmentOffsetIs(begin / 8);
+    pkt->ttlIs(64);
+    pkt->protocolIs(IPPacket::kUDP);
+    pkt->srcIs("10.0.0.1");
+    pkt->dstIs("10.0.0.2");
+    pkt->checksumReset();
+    for (size_t i = 0; i < len; ++i)
+      pkt->data()[IPPacket::kHeaderSize + i] = (begin + i) % 251;
+    return pkt;
+  }
+
+  /* Checks that PKT is the whole datagram of LEN bytes of payload. */
+  static void expectDatagram(IPPacket::Ptr pkt, uint16_t id, size_t len) {
+    ASSERT_TRUE(pkt);
+    EXPECT_FALSE(pkt->fragment());
+    EXPECT_TRUE(pkt->valid());
+    EXPECT_EQ(id, pkt->identification());
+    EXPECT_EQ(IPPacket::kHeaderSize + len, pkt->packetLength());
+    EXPECT_EQ(IPPacket::kHeaderSize + len, pkt->len());
+    for (size_t i = 0; i < len; ++i)
+      ASSERT_EQ(i % 251, pkt->data()[IPPacket::kHeaderSize + i]);
+  }
+
+  IPPacket::Ptr fragmentNew(IPPacket::Ptr pkt) {
+    return reassembler_->fragmentNew(pkt, Milliseconds(0));
+  }
+
+  IPReassembler::Ptr reassembler_;
+};
+
+TEST_F(IPReassemblerTest, in_order) {
+  // Packets that are not fragments pass through.
+  IPPacket::Ptr whole = fragment(1, 0, 100, false);
+  EXPECT_EQ(whole, fragmentNew(whole));
+
+  EXPECT_FALSE(fragmentNew(fragment(2, 0, 1480, true)));
+  EXPECT_FALSE(fragmentNew(fragment(2, 1480, 1480, true)));
+  EXPECT_EQ((size_t)1, reassembler_->datagrams());
+  EXPECT_LT((size_t)0, reassembler_->bytes());
+  expectDatagram(fragmentNew(fragment(2, 2960, 40, false)), 2, 3000);
+
+  EXPECT_EQ((size_t)0, reassembler_->datagrams());
+  EXPECT_EQ((size_t)0, reassembler_->bytes());
+  EXPECT_EQ((uint64_t)1, reassembler_->reassembled());
+}
+
+TEST_F(IPReassemblerTest, out_of_order) {
+  // Last fragment first, duplicates, and two datagrams interleaved.
+  EXPECT_FALSE(fragmentNew(fragment(1, 2960, 40, false)));
+  EXPECT_FALSE(fragmentNew(fragment(2, 1000, 1000, false)));
+  EXPECT_FALSE(fragmentNew(fragment(1, 0, 1480, true)));
+  EXPECT_FALSE(fragmentNew(fragment(1, 0, 1480, true)));
+  expectDatagram(fragmentNew(fragment(2, 0, 1000, true)), 2, 2000);
+  expectDatagram(fragmentNew(fragment(1, 1480, 1480, true)), 1, 3000);
+  EXPECT_EQ((uint64_t)2, reassembler_->reassembled());
+  EXPECT_EQ((uint64_t)0, reassembler_->overlaps());
+}
+
+TEST_F(IPReassemblerTest, overlap) {
+  // An overlapping fragment drops the datagram, along with the fragments
+  // that come after it.
+  EXPECT_FALSE(fragmentNew(fragment(1, 0, 1480, true)));
+  EXPECT_FALSE(fragmentNew(fragment(1, 1472, 16, true)));
+  EXPECT_EQ((uint64_t)1, reassembler_->overlaps());
+  EXPECT_EQ(IPReassembler::kDatagramBytes, reassembler_->bytes());
+  EXPECT_FALSE(fragmentNew(fragment(1, 1480, 1480, true)));
+  EXPECT_FALSE(fragmentNew(fragment(1, 2960, 40, false)));
+  EXPECT_EQ((uint64_t)0, reassembler_->reassembled());
+
+  // So does a last fragment that disagrees with the length of the datagram.
+  EXPECT_FALSE(fragmentNew(fragment(2, 1480, 40, false)));
+  EXPECT_FALSE(fragmentNew(fragment(2, 1480, 80, false)));
+  EXPECT_EQ((uint64_t)2, reassembler_->overlaps());
+
+  // Fragments other than the last must carry a multiple of 8 bytes.
+  EXPECT_FALSE(fragmentNew(fragment(3, 0, 100, true)));
+  EXPECT_EQ((size_t)2, reassembler_->datagrams());
+}
+
+TEST_F(IPReassemblerTest, memory) {
+  // Fragments are charged their buffers: 2048 bytes for full-sized ones, and
+  // 512 for the last ones here. Datagrams are charged kDatagramBytes each.
+  // The oldest datagrams make room for new ones.
+  const size_t dgram = IPReassembler::kDatagramBytes;
+  reassembler_->maxBytesIs(3 * 2048 + 512 + 3 * dgram);
+  EXPECT_FALSE(fragmentNew(fragment(1, 0, 1480, true)));
+  EXPECT_FALSE(fragmentNew(fragment(2, 0, 1480, true)));
+  EXPECT_FALSE(fragmentNew(fragment(2, 1480, 1480, true)));
+  EXPECT_EQ(3 * 2048 + 2 * dgram, reassembler_->bytes());
+  EXPECT_FALSE(fragmentNew(fragment(3, 0, 1480, true)));
+  EXPECT_EQ((uint64_t)1, reassembler_->overflows());
+  EXPECT_EQ((size_t)2, reassembler_->datagrams());
+  expectDatagram(fragmentNew(fragment(2, 2960, 40, false)), 2, 3000);
+
+  // The first fragment of datagram 1 is gone.
+  EXPECT_FALSE(fragmentNew(fragment(1, 1480, 40, false)));
+  EXPECT_EQ(2048 + 512 + 2 * dgram, reassembler_->bytes());
+
+  // Lowering the limit drops datagrams over it, oldest first.
+  reassembler_->maxBytesIs(512 + dgram);
+  EXPECT_EQ(512 + dgram, reassembler_->bytes());
+  EXPECT_EQ((size_t)1, reassembler_->datagrams());
+  EXPECT_EQ((uint64_t)2, reassembler_->overflows());
+}
+
+TEST_F(IPReassemblerTest, dropped_memory) {
+  // Datagrams dropped for overlaps are charged for their bookkeeping, and
+  // the oldest of them are forgotten to make room. Room is left for the
+  // 512 bytes of the fragment that drops a datagram.
+  const size_t dgram = IPReassembler::kDatagramBytes;
+  reassembler_->maxBytesIs(512 + 4 * dgram);
+  for (uint16_t id = 1; id <= 16; ++id) {
+    EXPECT_FALSE(fragmentNew(fragment(id, 1480, 40, false)));
+    EXPECT_FALSE(fragmentNew(fragment(id, 1480, 80, false)));
+  }
+  EXPECT_EQ((uint64_t)16, reassembler_->overlaps());
+  EXPECT_EQ((uint64_t)0, reassembler_->overflows());
+  EXPECT_EQ((size_t)4, reassembler_->datagrams());
+  EXPECT_EQ(4 * dgram, reassembler_->bytes());
+
+  // They give way to datagrams being reassembled.
+  reassembler_->maxBytesIs(2048 + 4 * dgram);
+  EXPECT_FALSE(fragmentNew(fragment(100, 0, 1480, true)));
+  EXPECT_EQ((size_t)4, reassembler_->datagrams());
+  expectDatagram(fragmentNew(fragment(100, 1480, 40, false)), 100, 1520);
+  EXPECT_EQ((uint64_t)0, reassembler_->overflows());
+
+  // Later fragments of a forgotten datagram start it anew.
+  EXPECT_FALSE(fragmentNew(fragment(1, 0, 1480, true)));
+  EXPECT_EQ((uint64_t)16, reassembler_->overlaps());
+}
+
+TEST_F(IPReassemblerTest, timeout) {
+  reassembler_->timeoutIs(1000);
+  EXPECT_FALSE(reassembler_->fragmentNew(fragment(1, 0, 1480, true), 0));
+  EXPECT_FALSE(reassembler_->fragmentNew(fragment(2, 1480, 40, false), 500));
+
+  vector<IPPacket::Ptr> first_fragments;
+  reassembler_->expiredDel(999, &first_fragments);
+  EXPECT_EQ((size_t)2, reassembler_->datagrams());
+
+  // Only datagrams that received their first fragment are reported.
+  reassembler_->expiredDel(1000, &first_fragments);
+  EXPECT_EQ((size_t)1, reassembler_->datagrams());
+  ASSERT_EQ((size_t)1, first_fragments.size());
+  EXPECT_EQ((uint16_t)1, first_fragments[0]->identification());
+
+  reassembler_->expiredDel(1500, &first_fragments);
+  EXPECT_EQ((size_t)0, reassembler_->datagrams());
+  EXPECT_EQ((size_t)1, first_fragments.size());
+  EXPECT_EQ((uint64_t)2, reassembler_->timeouts());
+  EXPECT_EQ((size_t)0, reassembler_->bytes());
+}
@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include "ospf_area.h"
+#include "ospf_constants.h"
+
+
+namespace {
+
+IPv4Subnet
+subnet(uint32_t addr, uint32_t mask) {
+  return std::make_pair(IPv4Addr(addr), IPv4Addr(mask));
+}
+
+}  // namespace
+
+
+TEST(OSPFAreaTest, topology) {
+  OSPFArea::Ptr area = OSPFArea::New(1, 0x01020304);
+  EXPECT_EQ(AreaID(1), area->areaID());
+  EXPECT_FALSE(area->backbone());
+  EXPECT_EQ(RouterID(0x01020304), area->rootNode()->routerID());
+  EXPECT_EQ(area->rootNode(), area->topology()->rootNode());
+  EXPECT_EQ((size_t)0, area->interfaces());
+
+  EXPECT_TRUE(OSPFArea::New(OSPF::kBackboneAreaID, 0x01020304)->backbone());
+}
+
+
+TEST(OSPFAreaTest, ranges) {
+  OSPFArea::Ptr area = OSPFArea::New(1, 0x01020304);
+
+  // Without ranges, prefixes are advertised as they are.
+  IPv4Subnet prefix = subnet(0x0a010200, 0xffffff00);
+  EXPECT_EQ(prefix, area->summaryPrefix(prefix));
+
+  // Ranges are stored by their subnet number, once.
+  area->rangeIs(subnet(0x0a010203, 0xffff0000));
+  area->rangeIs(subnet(0x0a010000, 0xffff0000));
+  area->rangeIs(subnet(0x0a000000, 0xff000000));
+  ASSERT_EQ((size_t)2, area->ranges().size());
+  EXPECT_EQ(subnet(0x0a000000, 0xff000000), area->ranges()[0]);
+
+  // The widest range that contains the prefix summarizes it.
+  EXPECT_EQ(subnet(0x0a000000, 0xff000000), area->summaryPrefix(prefix));
+  area->rangeDel(subnet(0x0a000000, 0xff000000));
+  EXPECT_EQ(subnet(0x0a010000, 0xffff0000), area->summaryPrefix(prefix));
+
+  // Prefixes outside the ranges, or wider than them, are left alone.
+  IPv4Subnet other = subnet(0x0a020000, 0xffffff00);
+  EXPECT_EQ(other, area->summaryPrefix(other));
+  IPv4Subnet wide = subnet(0x0a000000, 0xfffe0000);
+  EXPECT_EQ(wide, area->summaryPrefix(wide));
+}
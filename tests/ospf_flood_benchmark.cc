@@ -0,0 +1,199 @@
+/* Flooding traffic on a shared segment, with and without a designated
+   router. The emulated network is a single multi-access segment (a LAN)
+   of N routers, each adjacent to all others. Every router floods one
+   link-state update, which the others forward the way OSPFRouter does:
+   according to OSPFInterface::floodMode(), never back to the update's
+   original sender, and only on first receipt.
+
+   Packets are the copies sent; a copy sent to the whole segment counts
+   once. Receptions are the copies that routers have to process, duplicates
+   included.
+
+   Usage: ospf_flood_benchmark [routers]  (default: up to 64) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+#include "fwk/log.h"
+
+#include "interface.h"
+#include "ospf_constants.h"
+#include "ospf_gateway.h"
+#include "ospf_interface.h"
+#include "ospf_node.h"
+
+static const uint32_t kDefaultMaxRouters = 64;
+
+/* Router I of the segment has RouterID I + 1 and address 10.0.0.(I + 1). */
+struct Router {
+  RouterID id;
+  OSPFInterface::Ptr iface;
+  std::vector<bool> seen; /* Updates received, by original sender. */
+};
+
+/* A copy of the update originated by router ORIGIN, on its way to TO. */
+struct Delivery {
+  uint32_t to;
+  uint32_t origin;
+};
+
+struct FloodCount {
+  size_t packets;
+  size_t receptions;
+};
+
+static std::vector<Router>
+segment_new(uint32_t routers, uint8_t priority) {
+  std::vector<Router> segment(routers);
+  for (uint32_t i = 0; i < routers; ++i) {
+    std::stringstream name;
+    name << "eth" << i;
+    Interface::Ptr iface = Interface::InterfaceNew(name.str());
+    iface->ipIs(0x0a000001 + i);
+    iface->subnetMaskIs(0xffffff00);
+
+    segment[i].id = i + 1;
+    segment[i].iface =
+      OSPFInterface::New(iface, OSPF::kDefaultHelloInterval);
+    segment[i].iface->drPriorityIs(priority);
+    segment[i].seen.assign(routers, false);
+  }
+
+  /* Priorities are those that election packets would have announced. */
+  for (uint32_t i = 0; i < routers; ++i) {
+    for (uint32_t j = 0; j < routers; ++j) {
+      if (i == j)
+        continue;
+
+      OSPFGateway::Ptr gw_obj =
+        OSPFGateway::New(OSPFNode::New(segment[j].id), 0x0a000001 + j,
+                         0x0a000000, 0xffffff00);
+      gw_obj->drPriorityIs(priority);
+      segment[i].iface->gatewayIs(gw_obj);
+    }
+  }
+
+  for (uint32_t i = 0; i < routers; ++i)
+    segment[i].iface->designatedRouterElect(segment[i].id);
+
+  return segment;
+}
+
+/* Sends the update of router ORIGIN from router FROM, as OSPFRouter's
+   flood_out_interface() and forward_lsu_flood() do. */
+static void
+flood_out(std::vector<Router>& segment, uint32_t from, uint32_t origin,
+          std::deque<Delivery>& queue, FloodCount& count) {
+  OSPFInterface::Ptr iface = segment[from].iface;
+  OSPFInterface::FloodMode mode =
+    iface->floodMode(segment[from].id, from != origin);
+
+  std::vector<RouterID> targets;
+  switch (mode) {
+    case OSPFInterface::kFloodSegment:
+      ++count.packets;
+      for (uint32_t i = 0; i < segment.size(); ++i) {
+        if (i != from) {
+          Delivery delivery = { i, origin };
+          queue.push_back(delivery);
+        }
+      }
+      return;
+
+    case OSPFInterface::kFloodNeighbors:
+      for (OSPFInterface::const_gwa_iter it = iface->activeGatewaysBegin();
+           it != iface->activeGatewaysEnd(); ++it) {
+        targets.push_back(it->first);
+      }
+      break;
+
+    case OSPFInterface::kFloodDesignated:
+      targets.push_back(iface->designatedRouter());
+      targets.push_back(iface->backupDesignatedRouter());
+      break;
+
+    case OSPFInterface::kFloodNone:
+      break;
+  }
+
+  for (size_t i = 0; i < targets.size(); ++i) {
+    uint32_t to = targets[i].value() - 1;
+    if (targets[i] == OSPF::kInvalidRouterID || to == origin)
+      continue;
+
+    ++count.packets;
+    Delivery delivery = { to, origin };
+    queue.push_back(delivery);
+  }
+}
+
+static FloodCount
+flood(uint32_t routers, uint8_t priority) {
+  std::vector<Router> segment = segment_new(routers, priority);
+  FloodCount count = { 0, 0 };
+
+  std::deque<Delivery> queue;
+  for (uint32_t origin = 0; origin < routers; ++origin) {
+    flood_out(segment, origin, origin, queue, count);
+
+    while (!queue.empty()) {
+      Delivery delivery = queue.front();
+      queue.pop_front();
+      ++count.receptions;
+
+      Router& router = segment[delivery.to];
+      if (delivery.to == delivery.origin || router.seen[delivery.origin])
+        continue;
+
+      router.seen[delivery.origin] = true;
+      flood_out(segment, delivery.to, delivery.origin, queue, count);
+    }
+  }
+
+  /* Every router must have received every update. */
+  for (uint32_t i = 0; i < routers; ++i) {
+    for (uint32_t origin = 0; origin < routers; ++origin) {
+      if (i != origin && !segment[i].seen[origin]) {
+        fprintf(stderr, "router %u missed the update of router %u\n",
+                i + 1, origin + 1);
+        exit(1);
+      }
+    }
+  }
+
+  return count;
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  uint32_t min_routers = 2;
+  uint32_t max_routers = kDefaultMaxRouters;
+  if (argc > 1)
+    min_routers = max_routers = atoi(argv[1]);
+
+  if (min_routers < 2) {
+    fprintf(stderr, "at least 2 routers are required\n");
+    return 1;
+  }
+
+  printf("one link-state update flooded by every router on a segment\n");
+  printf("%8s  %26s  %26s\n", "", "every neighbor", "designated router");
+  printf("%8s  %12s %13s  %12s %13s\n", "routers",
+         "packets", "receptions", "packets", "receptions");
+
+  for (uint32_t routers = min_routers; routers <= max_routers; routers *= 2) {
+    FloodCount before = flood(routers, 0);
+    FloodCount after = flood(routers, 1);
+    printf("%8u  %12zu %13zu  %12zu %13zu\n", routers,
+           before.packets, before.receptions,
+           after.packets, after.receptions);
+  }
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+
+#include "interface.h"
+#include "ospf_constants.h"
+#include "ospf_gateway.h"
+#include "ospf_interface.h"
+#include "ospf_node.h"
+
+
+class OSPFInterfaceTest : public ::testing::Test {
+ protected:
+  OSPFInterfaceTest() : router_id_(5) {
+    iface_ = Interface::InterfaceNew("eth0");
+    iface_->ipIs("10.0.0.5");
+    iface_->subnetMaskIs("255.255.255.0");
+    ospf_iface_ = OSPFInterface::New(iface_, OSPF::kDefaultHelloInterval);
+  }
+
+  /* Adds the neighbor with ROUTER_ID and designated-router PRIORITY. */
+  OSPFGateway::Ptr neighborIs(uint32_t router_id, uint8_t priority) {
+    OSPFGateway::Ptr gw_obj =
+      OSPFGateway::New(OSPFNode::New(router_id), 0x0a000000 + router_id,
+                       0x0a000000, 0xffffff00);
+    gw_obj->drPriorityIs(priority);
+    ospf_iface_->gatewayIs(gw_obj);
+    return gw_obj;
+  }
+
+  RouterID router_id_;
+  Interface::Ptr iface_;
+  OSPFInterface::Ptr ospf_iface_;
+};
+
+
+TEST_F(OSPFInterfaceTest, noElection) {
+  /* Elections are disabled by default. */
+  neighborIs(3, 1);
+  EXPECT_FALSE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(OSPF::kInvalidRouterID, ospf_iface_->designatedRouter());
+  EXPECT_EQ(OSPFInterface::kFloodNeighbors,
+            ospf_iface_->floodMode(router_id_, true));
+}
+
+
+TEST_F(OSPFInterfaceTest, election) {
+  neighborIs(3, 1);
+  neighborIs(7, 1);
+  neighborIs(2, 10);
+  ospf_iface_->drPriorityIs(1);
+
+  /* Highest priority first, then highest RouterID. */
+  EXPECT_TRUE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(RouterID(2), ospf_iface_->designatedRouter());
+  EXPECT_EQ(RouterID(7), ospf_iface_->backupDesignatedRouter());
+  EXPECT_FALSE(ospf_iface_->designatedRouterElect(router_id_));
+
+  /* Other routers only send to the designated routers, which forward
+     packets received from the segment. */
+  EXPECT_EQ(OSPFInterface::kFloodDesignated,
+            ospf_iface_->floodMode(router_id_, false));
+  EXPECT_EQ(OSPFInterface::kFloodNone,
+            ospf_iface_->floodMode(router_id_, true));
+
+  /* The designated router sends a single copy to the segment. */
+  ospf_iface_->drPriorityIs(20);
+  EXPECT_TRUE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(router_id_, ospf_iface_->designatedRouter());
+  EXPECT_EQ(RouterID(2), ospf_iface_->backupDesignatedRouter());
+  EXPECT_EQ(OSPFInterface::kFloodSegment,
+            ospf_iface_->floodMode(router_id_, true));
+
+  /* Losing the designated router promotes the backup. */
+  ospf_iface_->drPriorityIs(1);
+  ospf_iface_->activeGatewayDel(2);
+  EXPECT_TRUE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(RouterID(7), ospf_iface_->designatedRouter());
+  EXPECT_EQ(router_id_, ospf_iface_->backupDesignatedRouter());
+}
+
+
+TEST_F(OSPFInterfaceTest, mixedSegment) {
+  neighborIs(3, 1);
+  OSPFGateway::Ptr legacy = neighborIs(7, 0);
+  ospf_iface_->drPriorityIs(1);
+
+  /* A neighbor that does not take part in elections expects updates from
+     every router on the segment. */
+  EXPECT_FALSE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(OSPF::kInvalidRouterID, ospf_iface_->designatedRouter());
+  EXPECT_EQ(OSPFInterface::kFloodNeighbors,
+            ospf_iface_->floodMode(router_id_, false));
+
+  legacy->drPriorityIs(1);
+  EXPECT_TRUE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(RouterID(7), ospf_iface_->designatedRouter());
+}
+
+
+TEST_F(OSPFInterfaceTest, virtualInterface) {
+  iface_->typeIs(Interface::kVirtual);
+  neighborIs(3, 1);
+  ospf_iface_->drPriorityIs(1);
+  EXPECT_FALSE(ospf_iface_->designatedRouterElect(router_id_));
+  EXPECT_EQ(OSPF::kInvalidRouterID, ospf_iface_->designatedRouter());
+}
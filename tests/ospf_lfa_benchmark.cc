@@ -0,0 +1,197 @@
+/* Traffic-loss window after a link failure, with and without loop-free
+   alternates. The emulated network is a ring of routers with chords at
+   distance 7. This router (the root) is dual-homed: it attaches to
+   kRootNeighbors / 2 points spread around the ring, each time through two
+   interfaces to adjacent routers. Every router has one /24 subnet, routed
+   through its first hop and, if one exists, its loop-free alternate.
+
+   The interface to the root's first neighbor then goes down:
+
+     - Reconvergence: destinations behind the failed interface stay
+       unreachable until the SPF throttle allows a computation, the
+       spanning tree is recomputed, and their routes are rewritten.
+     - Local repair: the forwarding path moves protected destinations to
+       their backup next hop on the next lookup.
+
+   Usage: ospf_lfa_benchmark [routers]  (default: 1000) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "fwk/log.h"
+
+#include "benchmark_util.h"
+#include "interface.h"
+#include "interface_map.h"
+#include "ospf_constants.h"
+#include "ospf_link.h"
+#include "ospf_node.h"
+#include "ospf_topology.h"
+#include "routing_table.h"
+
+static const int kDefaultRouters = 1000;
+static const int kRootNeighbors = 4;
+static const int kLookupRounds = 100;
+
+/* Subnet of router I. */
+static IPv4Addr
+router_subnet(uint32_t i) {
+  return 0x0a000000 + (i << 8);
+}
+
+/* Routing table entry to the subnet of NODE as of the last spanning tree
+   computation; IFACES is indexed by the RouterID of the root's neighbors. */
+static RoutingTable::Entry::Ptr
+router_entry(OSPFNode::Ptr node, const std::vector<Interface::Ptr>& ifaces) {
+  RoutingTable::Entry::Ptr entry = RoutingTable::Entry::New();
+  entry->subnetIs(router_subnet(node->routerID().value()), 0xffffff00);
+
+  OSPFNode::Ptr first_hop = node->firstHop();
+  entry->gatewayIs(first_hop->routerID().value());
+  entry->interfaceIs(ifaces[first_hop->routerID().value()]);
+
+  OSPFNode::Ptr backup = node->backupHop();
+  if (backup)
+    entry->backupNextHopIs(backup->routerID().value(),
+                           ifaces[backup->routerID().value()]);
+
+  return entry;
+}
+
+/* Number of SUBNETS that have no usable route. */
+static size_t
+unreachable(RoutingTable::Ptr rtable, const std::vector<IPv4Addr>& subnets) {
+  size_t count = 0;
+  for (size_t i = 0; i < subnets.size(); ++i) {
+    if (rtable->lpm(subnets[i].value() + 1) == NULL)
+      ++count;
+  }
+
+  return count;
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  uint32_t routers = (argc > 1) ? atoi(argv[1]) : kDefaultRouters;
+  if (routers < 4 * kRootNeighbors) {
+    fprintf(stderr, "at least %d routers are required\n", 4 * kRootNeighbors);
+    return 1;
+  }
+
+  /* Routers 1..ROUTERS; the root has the next RouterID. */
+  std::vector<OSPFNode::Ptr> nodes(routers + 1);
+  OSPFNode::Ptr root = OSPFNode::New(routers + 1);
+  OSPFTopology::Ptr topology = OSPFTopology::New(root);
+  for (uint32_t i = 1; i <= routers; ++i) {
+    nodes[i] = OSPFNode::New(i);
+    topology->nodeIs(nodes[i]);
+  }
+
+  for (uint32_t i = 1; i <= routers; ++i) {
+    OSPFNode::Ptr next = nodes[i % routers + 1];
+    OSPFNode::Ptr chord = nodes[(i + 6) % routers + 1];
+    nodes[i]->linkIs(OSPFLink::New(next, (uint32_t)0, (uint32_t)0));
+    nodes[i]->linkIs(OSPFLink::New(chord, (uint32_t)0, (uint32_t)0));
+  }
+
+  std::vector<Interface::Ptr> ifaces(routers + 1);
+  std::vector<uint32_t> neighbors;
+  for (int n = 0; n < kRootNeighbors; ++n) {
+    uint32_t i = 1 + (n / 2) * (routers / (kRootNeighbors / 2)) + n % 2;
+    std::stringstream name;
+    name << "eth" << n;
+    ifaces[i] = Interface::InterfaceNew(name.str());
+    root->linkIs(OSPFLink::New(nodes[i], (uint32_t)0, (uint32_t)0));
+    neighbors.push_back(i);
+  }
+
+  double start = now();
+  topology->onUpdate();
+  double spf_initial = now() - start;
+
+  RoutingTable::Ptr rtable = RoutingTable::New(InterfaceMap::InterfaceMapNew());
+  std::vector<IPv4Addr> subnets;
+  size_t protected_routes = 0;
+  for (uint32_t i = 1; i <= routers; ++i) {
+    RoutingTable::Entry::Ptr entry = router_entry(nodes[i], ifaces);
+    rtable->entryIs(entry);
+    subnets.push_back(entry->subnet());
+    if (entry->backupNextHop().interface())
+      ++protected_routes;
+  }
+
+  printf("%u routers, %d neighbors, %zu of %u routes protected "
+         "(spf: %.3f ms)\n", routers, kRootNeighbors, protected_routes,
+         routers, spf_initial * 1e3);
+
+  /* Destinations routed through the failing interface. */
+  Interface::Ptr failed = ifaces[neighbors[0]];
+  std::vector<IPv4Addr> affected;
+  size_t affected_protected = 0;
+  for (RoutingTable::iterator it = rtable->entriesBegin();
+       it != rtable->entriesEnd(); ++it) {
+    RoutingTable::Entry::Ptr entry = it->second;
+    if (entry->interface() != failed)
+      continue;
+
+    affected.push_back(entry->subnet());
+    if (entry->backupNextHop().interface())
+      ++affected_protected;
+  }
+
+  /* Local repair: the interface goes down, and lookups move to the backup
+     on their own. */
+  failed->enabledIs(false);
+  start = now();
+  size_t lost_repair = 0;
+  for (int round = 0; round < kLookupRounds; ++round)
+    lost_repair = unreachable(rtable, affected);
+  double lookup = (now() - start) / kLookupRounds /
+                  (affected.empty() ? 1 : affected.size());
+
+  /* Reconvergence: the spanning tree is recomputed without the failed
+     link, and the routes to changed nodes are rewritten. Routes are cleared
+     of their backups first, as without loop-free alternates. */
+  for (RoutingTable::iterator it = rtable->entriesBegin();
+       it != rtable->entriesEnd(); ++it) {
+    it->second->backupNextHopIs(IPv4Addr::kZero, NULL);
+  }
+  size_t lost_reconverge = unreachable(rtable, affected);
+
+  root->activeLinkDel(neighbors[0]);
+  start = now();
+  topology->onUpdate();
+  double spf = now() - start;
+
+  start = now();
+  const std::vector<RouterID>& changed = topology->changedNodes();
+  for (size_t i = 0; i < changed.size(); ++i) {
+    OSPFNode::Ptr node = topology->node(changed[i]);
+    if (node && node != root && node->firstHop())
+      rtable->entryIs(router_entry(node, ifaces));
+  }
+  double rtable_time = now() - start;
+
+  size_t lost_after = unreachable(rtable, affected);
+  double reconverge_ms =
+    OSPF::kDefaultSPFInitialDelay + (spf + rtable_time) * 1e3;
+
+  printf("affected routes: %zu (%zu protected)\n", affected.size(),
+         affected_protected);
+  printf("%-13s lost routes: %5zu  window: %9.3f ms "
+         "(throttle %u ms + spf %.3f ms + routes %.3f ms)\n",
+         "reconvergence", lost_reconverge, reconverge_ms,
+         OSPF::kDefaultSPFInitialDelay, spf * 1e3, rtable_time * 1e3);
+  printf("%-13s lost routes: %5zu  window: %9.6f ms (one lookup) for "
+         "protected routes, %.3f ms for the rest\n",
+         "local repair", lost_repair, lookup * 1e3,
+         lost_repair ? reconverge_ms : 0.0);
+  printf("unreachable after reconvergence: %zu\n", lost_after);
+
+  return 0;
+}
@@ -0,0 +1,224 @@
+/* Load test of the link-state database. Link-state updates from a synthetic
+   network are ingested the way OSPFRouter ingests them: advertisements of
+   links to other OSPF routers are staged until the neighbor confirms them,
+   passive subnets are committed directly, and links that a sender no longer
+   lists are removed. Every sender lists kAdvsPerRouter advertisements.
+
+   The database is first populated from scratch, then refreshed with the
+   same updates, as happens periodically in steady state. CPU time and
+   memory are reported for both phases, along with a full shortest-path
+   computation over the resulting topology.
+
+   Usage: ospf_lsdb_benchmark [advertisements]  (default: 100000) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#include "fwk/log.h"
+
+#include "ospf_adv_map.h"
+#include "ospf_adv_set.h"
+#include "ospf_constants.h"
+#include "ospf_link.h"
+#include "ospf_node.h"
+#include "ospf_topology.h"
+
+static const int kDefaultAdvertisements = 100000;
+static const int kAdvsPerRouter = 10;
+static const int kActiveLinksPerRouter = 4;
+
+/* User plus system CPU time of this process, in seconds. */
+static double
+cpu_time() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+/* Resident set size of this process, in kilobytes. */
+static long
+resident_kb() {
+  long pages = 0;
+  long resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    fclose(statm);
+  }
+
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static long
+peak_resident_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/* One advertisement of a link-state update. */
+struct Adv {
+  RouterID nbr;
+  IPv4Addr subnet;
+  IPv4Addr mask;
+};
+
+/* Router I (1-based) is linked to its neighbors on a ring at distances 1 and
+   7 in both directions; the link between routers A < B uses subnet
+   10.x.y.0/30 derived from A and the distance. The remaining advertisements
+   are passive /24 subnets. */
+static std::vector<Adv>
+router_advs(uint32_t i, uint32_t routers) {
+  static const uint32_t kStrides[] = { 1, 7 };
+  std::vector<Adv> advs;
+
+  for (size_t s = 0; s < sizeof(kStrides) / sizeof(uint32_t); ++s) {
+    uint32_t stride = kStrides[s] % routers;
+    uint32_t up = (i - 1 + stride) % routers + 1;
+    uint32_t down = (i - 1 + routers - stride) % routers + 1;
+
+    Adv adv;
+    adv.mask = 0xfffffffc;
+
+    adv.nbr = up;
+    adv.subnet = 0x0a000000 + (((i << 1) | s) << 2);
+    advs.push_back(adv);
+
+    adv.nbr = down;
+    adv.subnet = 0x0a000000 + (((down << 1) | s) << 2);
+    advs.push_back(adv);
+  }
+
+  for (int p = kActiveLinksPerRouter; p < kAdvsPerRouter; ++p) {
+    Adv adv;
+    adv.nbr = OSPF::kPassiveEndpointID;
+    adv.subnet = 0x80000000 + ((i * kAdvsPerRouter + p) << 8);
+    adv.mask = 0xffffff00;
+    advs.push_back(adv);
+  }
+
+  return advs;
+}
+
+/* Mirrors OSPFRouter::process_lsu_advertisements(). */
+static void
+ingest(OSPFTopology::Ptr topology, OSPFAdvertisementMap::Ptr staged,
+       const RouterID& sender_id, const std::vector<Adv>& advs) {
+  OSPFNode::Ptr sender = topology->node(sender_id);
+  if (sender == NULL) {
+    sender = OSPFNode::New(sender_id);
+    topology->nodeIs(sender);
+  }
+
+  OSPFAdvertisementSet::Ptr confirmed = OSPFAdvertisementSet::New();
+  for (size_t i = 0; i < advs.size(); ++i) {
+    const Adv& adv = advs[i];
+
+    if (adv.nbr == OSPF::kPassiveEndpointID) {
+      sender->linkIs(OSPFLink::NewPassive(adv.subnet, adv.mask));
+
+    } else {
+      OSPFAdvertisement::Ptr adv_obj =
+        staged->advertisement(adv.nbr, sender_id, adv.subnet, adv.mask);
+      if (adv_obj) {
+        adv_obj->sender()->linkIs(adv_obj->link());
+        staged->advertisementDel(adv_obj);
+
+      } else {
+        OSPFNode::Ptr neighbor = topology->node(adv.nbr);
+        if (neighbor == NULL) {
+          neighbor = OSPFNode::New(adv.nbr);
+          topology->nodeIs(neighbor);
+        }
+
+        OSPFLink::Ptr link = OSPFLink::New(neighbor, adv.subnet, adv.mask);
+        staged->advertisementIs(OSPFAdvertisement::New(sender, link));
+      }
+    }
+
+    confirmed->advertisementIs(sender_id, adv.nbr, adv.subnet, adv.mask);
+  }
+
+  /* Mirrors OSPFRouter::remove_unconfirmed_links(). */
+  std::vector<RouterID> unconfirmed;
+  for (OSPFNode::const_lna_iter it = sender->activeLinksBegin();
+       it != sender->activeLinksEnd(); ++it) {
+    OSPFLink::PtrConst link = it->second;
+    if (!confirmed->contains(sender_id, link->nodeRouterID(),
+                             link->subnet(), link->subnetMask())) {
+      unconfirmed.push_back(link->nodeRouterID());
+    }
+  }
+
+  for (size_t i = 0; i < unconfirmed.size(); ++i)
+    sender->activeLinkDel(unconfirmed[i]);
+}
+
+static void
+report(const char* phase, double cpu, long rss_kb, int advs) {
+  printf("%-9s cpu: %8.3f s  (%7.0f ns/adv)  rss: %8ld kB\n",
+         phase, cpu, cpu * 1e9 / advs, rss_kb);
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int adv_count = (argc > 1) ? atoi(argv[1]) : kDefaultAdvertisements;
+  uint32_t routers = adv_count / kAdvsPerRouter;
+  if (routers < 16) {
+    fprintf(stderr, "at least %d advertisements are required\n",
+            16 * kAdvsPerRouter);
+    return 1;
+  }
+
+  /* Updates are generated up front so that only ingestion is measured. */
+  std::vector<std::vector<Adv> > updates(routers + 1);
+  for (uint32_t i = 1; i <= routers; ++i)
+    updates[i] = router_advs(i, routers);
+
+  OSPFNode::Ptr root = OSPFNode::New(routers + 1);
+  OSPFTopology::Ptr topology = OSPFTopology::New(root);
+  OSPFAdvertisementMap::Ptr staged = OSPFAdvertisementMap::New();
+
+  printf("%u routers, %d advertisements\n", routers,
+         routers * kAdvsPerRouter);
+
+  long base_rss = resident_kb();
+  double start = cpu_time();
+  for (uint32_t i = 1; i <= routers; ++i)
+    ingest(topology, staged, i, updates[i]);
+  report("populate", cpu_time() - start, resident_kb() - base_rss,
+         routers * kAdvsPerRouter);
+
+  start = cpu_time();
+  for (uint32_t i = 1; i <= routers; ++i)
+    ingest(topology, staged, i, updates[i]);
+  report("refresh", cpu_time() - start, resident_kb() - base_rss,
+         routers * kAdvsPerRouter);
+
+  /* The root attaches to the first router; everything is then reachable. */
+  root->linkIs(OSPFLink::New(topology->node(1), 0xc0a80000, 0xfffffffc));
+  start = cpu_time();
+  topology->onUpdate();
+  printf("%-9s cpu: %8.3f s\n", "spf", cpu_time() - start);
+
+  size_t links = 0;
+  for (OSPFTopology::const_iterator it = topology->nodesBegin();
+       it != topology->nodesEnd(); ++it) {
+    links += it->second->links();
+  }
+
+  printf("nodes: %zu  links: %zu  staged: %zu  "
+         "farthest: %u hops  peak rss: %ld kB\n",
+         topology->nodes(), links, staged->advertisements(),
+         topology->node(routers / 2 + 1)->distance(), peak_resident_kb());
+
+  return 0;
+}
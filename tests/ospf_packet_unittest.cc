@@ -0,0 +1,257 @@
+#include "gtest/gtest.h"
+
+#include <inttypes.h>
+
+#include "interface.h"
+#include "ospf_constants.h"
+#include "ospf_packet.h"
+#include "packet_buffer.h"
+
+
+namespace {
+
+// Records the most specific packet type that was dispatched.
+class TypeFunctor : public Packet::Functor {
+ public:
+  TypeFunctor() : type_(0) {}
+
+  void operator()(OSPFLSUPacket*, Fwk::Ptr<const Interface>) {
+    type_ = OSPFPacket::kLSU;
+  }
+
+  void operator()(OSPFLSUDeltaPacket*, Fwk::Ptr<const Interface>) {
+    type_ = OSPFPacket::kLSUDelta;
+  }
+
+  void operator()(OSPFLSRPacket*, Fwk::Ptr<const Interface>) {
+    type_ = OSPFPacket::kLSR;
+  }
+
+  void operator()(OSPFFastHelloPacket*, Fwk::Ptr<const Interface>) {
+    type_ = OSPFPacket::kFastHello;
+  }
+
+  void operator()(OSPFElectionPacket*, Fwk::Ptr<const Interface>) {
+    type_ = OSPFPacket::kElection;
+  }
+
+  int type() const { return type_; }
+
+ private:
+  int type_;
+};
+
+}  // namespace
+
+
+class OSPFLSUDeltaPacketTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    size_t len = OSPFLSUDeltaPacket::kHeaderSize +
+                 3 * OSPFLSUAdvPacket::kSize;
+    buf_ = PacketBuffer::New(len);
+    pkt_ = OSPFLSUDeltaPacket::NewDefault(buf_, 0x01020304, 0, 2, 1, 7, 6);
+
+    // Two added advertisements, followed by one withdrawn advertisement.
+    for (uint32_t i = 0; i < 2; ++i) {
+      OSPFLSUAdvPacket::Ptr adv = pkt_->advertisement(i);
+      adv->routerIDIs(0x0a000001 + i);
+      adv->subnetIs(0x0a000000 + (i << 8));
+      adv->subnetMaskIs(0xffffff00);
+    }
+
+    OSPFLSUAdvPacket::Ptr adv = pkt_->withdrawal(0);
+    adv->routerIDIs(0);
+    adv->subnetIs(0xc0a80000);
+    adv->subnetMaskIs(0xffff0000);
+
+    pkt_->checksumReset();
+  }
+
+  PacketBuffer::Ptr buf_;
+  OSPFLSUDeltaPacket::Ptr pkt_;
+};
+
+
+TEST_F(OSPFLSUDeltaPacketTest, fields) {
+  EXPECT_EQ(OSPFPacket::kLSUDelta, pkt_->type());
+  EXPECT_EQ(RouterID(0x01020304), pkt_->routerID());
+  EXPECT_EQ(7, pkt_->seqno());
+  EXPECT_EQ(6, pkt_->baseSeqno());
+  EXPECT_EQ(OSPFLSUPacket::kDefaultTTL, pkt_->ttl());
+  EXPECT_EQ(2u, pkt_->advCount());
+  EXPECT_EQ(1u, pkt_->withdrawnCount());
+
+  EXPECT_EQ(RouterID(0x0a000002), pkt_->advertisement(1)->routerID());
+  EXPECT_EQ(IPv4Addr(0x0a000100), pkt_->advertisement(1)->subnet());
+  EXPECT_EQ(RouterID(0), pkt_->withdrawal(0)->routerID());
+  EXPECT_EQ(IPv4Addr(0xc0a80000), pkt_->withdrawal(0)->subnet());
+  EXPECT_EQ(IPv4Addr(0xffff0000), pkt_->withdrawal(0)->subnetMask());
+
+  pkt_->ttlDec(1);
+  EXPECT_EQ(OSPFLSUPacket::kDefaultTTL - 1, pkt_->ttl());
+}
+
+
+TEST_F(OSPFLSUDeltaPacketTest, valid) {
+  EXPECT_TRUE(pkt_->valid());
+
+  // Withdrawn advertisements must fit in the packet.
+  pkt_->withdrawnCountIs(2);
+  pkt_->checksumReset();
+  EXPECT_FALSE(pkt_->valid());
+
+  // Counts close to 2^32 must not overflow the length check.
+  pkt_->advCountIs(0xffffffff);
+  pkt_->withdrawnCountIs(1);
+  pkt_->checksumReset();
+  EXPECT_FALSE(pkt_->valid());
+}
+
+
+TEST_F(OSPFLSUDeltaPacketTest, derivedInstance) {
+  OSPFPacket::Ptr pkt = OSPFPacket::New(buf_, pkt_->bufferOffset());
+  OSPFPacket::Ptr derived = pkt->derivedInstance();
+  ASSERT_TRUE(derived);
+  EXPECT_TRUE(derived->valid());
+
+  TypeFunctor functor;
+  (*derived)(&functor, NULL);
+  EXPECT_EQ(OSPFPacket::kLSUDelta, functor.type());
+}
+
+
+TEST(OSPFLSUPacketTest, costs) {
+  size_t len = OSPFLSUPacket::kHeaderSize + 3 * OSPFLSUAdvPacket::kSize +
+               OSPFLSUPacket::costsSize(3);
+  PacketBuffer::Ptr buf = PacketBuffer::New(len);
+  OSPFLSUPacket::Ptr pkt =
+    OSPFLSUPacket::NewDefault(buf, 0x01020304, 0, 3, 5, true, 0);
+  for (uint32_t i = 0; i < 3; ++i)
+    pkt->costIs(i, 10 * (i + 1));
+  pkt->checksumReset();
+
+  EXPECT_TRUE(pkt->valid());
+  EXPECT_TRUE(pkt->costsIncluded());
+  EXPECT_EQ(3u, pkt->advCount());
+  EXPECT_EQ(10, pkt->cost(0));
+  EXPECT_EQ(30, pkt->cost(2));
+
+  // Updates without the extension use the default cost.
+  size_t plain_len = OSPFLSUPacket::kHeaderSize + 2 * OSPFLSUAdvPacket::kSize;
+  PacketBuffer::Ptr plain_buf = PacketBuffer::New(plain_len);
+  OSPFLSUPacket::Ptr plain =
+    OSPFLSUPacket::NewDefault(plain_buf, 0x01020304, 0, 2, 5, false, 0);
+  plain->checksumReset();
+
+  EXPECT_TRUE(plain->valid());
+  EXPECT_FALSE(plain->costsIncluded());
+  EXPECT_EQ(OSPF::kDefaultLinkCost, plain->cost(1));
+}
+
+
+TEST(OSPFLSUPacketTest, summaries) {
+  size_t len = OSPFLSUPacket::kHeaderSize + 4 * OSPFLSUAdvPacket::kSize +
+               OSPFLSUPacket::costsSize(4) + OSPFLSUPacket::summariesSize(2);
+  PacketBuffer::Ptr buf = PacketBuffer::New(len);
+  OSPFLSUPacket::Ptr pkt =
+    OSPFLSUPacket::NewDefault(buf, 0x01020304, 0, 4, 5, true, 2);
+  pkt->checksumReset();
+
+  EXPECT_TRUE(pkt->valid());
+  EXPECT_TRUE(pkt->costsIncluded());
+  EXPECT_EQ(2u, pkt->summaryCount());
+  EXPECT_FALSE(pkt->summary(1));
+  EXPECT_TRUE(pkt->summary(2));
+  EXPECT_TRUE(pkt->summary(3));
+  EXPECT_FALSE(pkt->summary(4));
+
+  // Updates without summaries carry no extension.
+  EXPECT_EQ((size_t)0, OSPFLSUPacket::summariesSize(0));
+  size_t plain_len = OSPFLSUPacket::kHeaderSize + 2 * OSPFLSUAdvPacket::kSize +
+                     OSPFLSUPacket::costsSize(2);
+  PacketBuffer::Ptr plain_buf = PacketBuffer::New(plain_len);
+  OSPFLSUPacket::Ptr plain =
+    OSPFLSUPacket::NewDefault(plain_buf, 0x01020304, 0, 2, 5, true, 0);
+  EXPECT_EQ(0u, plain->summaryCount());
+  EXPECT_FALSE(plain->summary(1));
+}
+
+
+TEST(OSPFLSRPacketTest, fields) {
+  PacketBuffer::Ptr buf = PacketBuffer::New(OSPFLSRPacket::kPacketSize);
+  OSPFLSRPacket::Ptr pkt =
+    OSPFLSRPacket::NewDefault(buf, 0x01020304, 0, 0x05060708, 3);
+  pkt->checksumReset();
+
+  EXPECT_EQ(OSPFPacket::kLSR, pkt->type());
+  EXPECT_EQ(RouterID(0x01020304), pkt->routerID());
+  EXPECT_EQ(RouterID(0x05060708), pkt->targetID());
+  EXPECT_EQ(3, pkt->seqno());
+  EXPECT_EQ(OSPFLSUPacket::kDefaultTTL, pkt->ttl());
+  EXPECT_TRUE(pkt->valid());
+
+  OSPFPacket::Ptr derived =
+    OSPFPacket::New(buf, pkt->bufferOffset())->derivedInstance();
+  TypeFunctor functor;
+  (*derived)(&functor, NULL);
+  EXPECT_EQ(OSPFPacket::kLSR, functor.type());
+
+  // Corrupting the packet invalidates its checksum.
+  pkt->targetIDIs(0x05060709);
+  EXPECT_FALSE(pkt->valid());
+}
+
+
+TEST(OSPFFastHelloPacketTest, fields) {
+  PacketBuffer::Ptr buf = PacketBuffer::New(OSPFFastHelloPacket::kPacketSize);
+  OSPFFastHelloPacket::Ptr pkt =
+    OSPFFastHelloPacket::NewDefault(buf, 0x01020304, 0, 50, 3);
+  pkt->checksumReset();
+
+  EXPECT_EQ(OSPFPacket::kFastHello, pkt->type());
+  EXPECT_EQ(RouterID(0x01020304), pkt->routerID());
+  EXPECT_EQ(50, pkt->interval());
+  EXPECT_EQ(3, pkt->multiplier());
+  EXPECT_TRUE(pkt->valid());
+
+  OSPFPacket::Ptr derived =
+    OSPFPacket::New(buf, pkt->bufferOffset())->derivedInstance();
+  ASSERT_TRUE(derived);
+  EXPECT_TRUE(derived->valid());
+
+  TypeFunctor functor;
+  (*derived)(&functor, NULL);
+  EXPECT_EQ(OSPFPacket::kFastHello, functor.type());
+
+  // A zero multiplier would time neighbors out immediately.
+  pkt->multiplierIs(0);
+  pkt->checksumReset();
+  EXPECT_FALSE(pkt->valid());
+}
+
+
+TEST(OSPFElectionPacketTest, fields) {
+  PacketBuffer::Ptr buf = PacketBuffer::New(OSPFElectionPacket::kPacketSize);
+  OSPFElectionPacket::Ptr pkt =
+    OSPFElectionPacket::NewDefault(buf, 0x01020304, 0, 7);
+  pkt->checksumReset();
+
+  EXPECT_EQ(OSPFPacket::kElection, pkt->type());
+  EXPECT_EQ(RouterID(0x01020304), pkt->routerID());
+  EXPECT_EQ(7, pkt->priority());
+  EXPECT_TRUE(pkt->valid());
+
+  OSPFPacket::Ptr derived =
+    OSPFPacket::New(buf, pkt->bufferOffset())->derivedInstance();
+  ASSERT_TRUE(derived);
+  EXPECT_TRUE(derived->valid());
+
+  TypeFunctor functor;
+  (*derived)(&functor, NULL);
+  EXPECT_EQ(OSPFPacket::kElection, functor.type());
+
+  // Corrupting the packet invalidates its checksum.
+  pkt->priorityIs(0);
+  EXPECT_FALSE(pkt->valid());
+}
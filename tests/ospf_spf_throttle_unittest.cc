@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "ospf_spf_throttle.h"
+#include "time_types.h"
+
+class OSPFSPFThrottleTest : public ::testing::Test {
+ protected:
+  OSPFSPFThrottleTest()
+      : throttle_(OSPFSPFThrottle::New(50, 200, 1000)) {}
+
+  /* Runs the pending computation at its deadline. */
+  Milliseconds run_at_deadline() {
+    Milliseconds deadline = throttle_->deadline();
+    EXPECT_FALSE(throttle_->runDue(deadline.value() - 1));
+    EXPECT_TRUE(throttle_->runDue(deadline));
+    throttle_->onRun(deadline, 10);
+    return deadline;
+  }
+
+  OSPFSPFThrottle::Ptr throttle_;
+};
+
+TEST_F(OSPFSPFThrottleTest, initial_delay) {
+  EXPECT_FALSE(throttle_->pending());
+  EXPECT_FALSE(throttle_->runDue(0));
+
+  throttle_->onChange(1000);
+  EXPECT_TRUE(throttle_->pending());
+  EXPECT_EQ(throttle_->deadline(), 1050);
+  EXPECT_EQ(run_at_deadline(), 1050);
+
+  EXPECT_FALSE(throttle_->pending());
+  EXPECT_EQ(throttle_->runs(), (uint64_t)1);
+}
+
+TEST_F(OSPFSPFThrottleTest, batching) {
+  throttle_->onChange(1000);
+  for (int i = 1; i <= 20; ++i)
+    throttle_->onChange(1000 + i);
+
+  run_at_deadline();
+  EXPECT_EQ(throttle_->changes(), (uint64_t)21);
+  EXPECT_EQ(throttle_->suppressedRuns(), (uint64_t)20);
+  EXPECT_EQ(throttle_->runs(), (uint64_t)1);
+}
+
+TEST_F(OSPFSPFThrottleTest, exponential_backoff) {
+  throttle_->onChange(1000);
+  Milliseconds last = run_at_deadline();
+
+  /* Hold time doubles after every run, up to the maximum wait. */
+  int64_t expected_holds[] = { 200, 400, 800, 1000, 1000 };
+  for (size_t i = 0; i < sizeof(expected_holds) / sizeof(int64_t); ++i) {
+    throttle_->onChange(last.value() + 1);
+    EXPECT_EQ(throttle_->deadline().value() - last.value(), expected_holds[i]);
+    last = run_at_deadline();
+  }
+
+  /* A quiet period of twice the maximum wait resets the backoff. */
+  Milliseconds quiet = last.value() + 2 * 1000;
+  throttle_->onChange(quiet);
+  EXPECT_EQ(throttle_->deadline(), quiet.value() + 50);
+  last = run_at_deadline();
+
+  throttle_->onChange(last.value() + 1);
+  EXPECT_EQ(throttle_->deadline().value() - last.value(), 200);
+}
+
+TEST_F(OSPFSPFThrottleTest, statistics) {
+  throttle_->onChange(0);
+  throttle_->onRun(50, 30);
+  throttle_->onChange(100);
+  throttle_->onRun(250, 10);
+
+  EXPECT_EQ(throttle_->runs(), (uint64_t)2);
+  EXPECT_EQ(throttle_->runTime(), (uint64_t)40);
+  EXPECT_EQ(throttle_->lastRunTime(), (uint64_t)10);
+  EXPECT_EQ(throttle_->maxRunTime(), (uint64_t)30);
+}
+
+TEST_F(OSPFSPFThrottleTest, configuration) {
+  throttle_->maxWaitIs(100);
+  EXPECT_EQ(throttle_->maxWait(), throttle_->holdTime());
+
+  throttle_->holdTimeIs(500);
+  EXPECT_EQ(throttle_->maxWait(), 500);
+}
@@ -0,0 +1,190 @@
+/* Benchmark of the shortest-path computation in OSPFTopology over synthetic
+   topologies of increasing size. For comparison, the linear-scan Dijkstra
+   that OSPFTopology used before the indexed heap is reproduced below and
+   timed over the same topologies, as is the incremental update that follows
+   a single link flap. The share of each update spent on loop-free
+   alternates, i.e. outside of the spanning tree computation that the SPF
+   throttle accounts for, is reported as LFA.
+
+   Usage: ospf_topology_benchmark [routers ...]  (default: 1000 10000) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "fwk/log.h"
+#include "fwk/map.h"
+
+#include "benchmark_util.h"
+#include "ospf_link.h"
+#include "ospf_node.h"
+#include "ospf_topology.h"
+
+static const int kDefaultSizes[] = { 1000, 10000 };
+static const int kNeighborsPerRouter = 4;
+static const int kRuns = 5;
+
+typedef Fwk::Map<RouterID,OSPFNode> NodeMap;
+
+/* Linear-scan Dijkstra, as originally implemented in
+   OSPFTopology::compute_optimal_spanning_tree(). */
+static void
+reference_spf(OSPFTopology::Ptr topology) {
+  NodeMap node_set;
+  for (OSPFTopology::iterator it = topology->nodesBegin();
+       it != topology->nodesEnd(); ++it) {
+    node_set[it->first] = it->second;
+  }
+
+  OSPFNode::Ptr root = topology->rootNode();
+  node_set[root->routerID()] = root;
+
+  for (NodeMap::iterator it = node_set.begin();
+       it != node_set.end(); ++it) {
+    it->second->distanceIs(OSPFNode::kMaxDistance);
+    it->second->upstreamNodeIs(NULL);
+  }
+  root->distanceIs(0);
+
+  while (node_set.size() > 0) {
+    OSPFNode::Ptr cur_nd = NULL;
+    for (NodeMap::iterator it = node_set.begin();
+         it != node_set.end(); ++it) {
+      if (cur_nd == NULL || it->second->distance() < cur_nd->distance())
+        cur_nd = it->second;
+    }
+
+    if (cur_nd->distance() == OSPFNode::kMaxDistance)
+      break;
+
+    node_set.elemDel(cur_nd->routerID());
+
+    for (OSPFNode::lna_iter it = cur_nd->activeLinksBegin();
+         it != cur_nd->activeLinksEnd(); ++it) {
+      OSPFNode::Ptr neighbor = node_set.elem(it->second->node()->routerID());
+      if (neighbor) {
+        uint32_t alt_dist = cur_nd->distance() + it->second->cost();
+        if (alt_dist < neighbor->distance()) {
+          neighbor->distanceIs(alt_dist);
+          neighbor->upstreamNodeIs(cur_nd);
+        }
+      }
+    }
+  }
+}
+
+/* Links A and B. Links are added from the root's side when the root is one
+   of the endpoints, since the topology refuses to insert its own root. */
+static void
+connect(OSPFNode::Ptr a, OSPFNode::Ptr b, OSPFNode::Ptr root) {
+  if (b == root) {
+    b = a;
+    a = root;
+  }
+
+  a->linkIs(OSPFLink::New(b, (uint32_t)0, (uint32_t)0));
+}
+
+/* Builds a connected topology of ROUTERS routers (including the root): a
+   ring, plus random chords so that each router has roughly
+   kNeighborsPerRouter neighbors. */
+static OSPFTopology::Ptr
+build_topology(int routers, std::vector<OSPFNode::Ptr>& nodes) {
+  nodes.clear();
+  for (int i = 0; i < routers; ++i)
+    nodes.push_back(OSPFNode::New(i + 1));
+
+  OSPFTopology::Ptr topology = OSPFTopology::New(nodes[0]);
+  for (int i = 1; i < routers; ++i)
+    topology->nodeIs(nodes[i]);
+
+  srand(routers);
+  for (int i = 0; i < routers; ++i) {
+    connect(nodes[i], nodes[(i + 1) % routers], nodes[0]);
+
+    for (int j = 2; j < kNeighborsPerRouter; j += 2)
+      connect(nodes[i], nodes[rand() % routers], nodes[0]);
+  }
+
+  return topology;
+}
+
+/* Forces the next onUpdate() to recompute the whole spanning tree. Removing
+   a node from the topology invalidates incremental state, so an isolated
+   SPARE node is removed and inserted again. */
+static void
+mark_dirty(OSPFTopology::Ptr topology, OSPFNode::Ptr spare) {
+  topology->nodeDel(spare);
+  topology->nodeIs(spare);
+}
+
+static void
+benchmark(int routers) {
+  std::vector<OSPFNode::Ptr> nodes;
+  OSPFTopology::Ptr topology = build_topology(routers, nodes);
+  OSPFNode::Ptr spare = OSPFNode::New(routers + 1);
+
+  double start = now();
+  for (int i = 0; i < kRuns; ++i)
+    reference_spf(topology);
+  double reference_ms = (now() - start) * 1000 / kRuns;
+
+  std::vector<uint16_t> expected;
+  for (int i = 0; i < routers; ++i)
+    expected.push_back(nodes[i]->distance());
+
+  OSPFSPFThrottle::Ptr throttle = topology->spfThrottle();
+  uint64_t spf_us = throttle->runTime();
+  start = now();
+  for (int i = 0; i < kRuns; ++i) {
+    mark_dirty(topology, spare);
+    topology->onUpdate();
+  }
+  double heap_ms = (now() - start) * 1000 / kRuns;
+  double heap_lfa_ms =
+    heap_ms - (throttle->runTime() - spf_us) / 1000.0 / kRuns;
+
+  /* Flapping the link between a random router and its upstream node; each
+     flap takes two incremental updates. */
+  spf_us = throttle->runTime();
+  start = now();
+  for (int i = 0; i < kRuns; ++i) {
+    OSPFNode::Ptr node = nodes[1 + rand() % (routers - 1)];
+    OSPFNode::Ptr upstream = node->upstreamNode();
+    OSPFLink::Ptr link = upstream->activeLink(node->routerID());
+    upstream->activeLinkDel(node->routerID());
+    topology->onUpdate();
+    upstream->linkIs(OSPFLink::New(node, link->subnet(), link->subnetMask()));
+    topology->onUpdate();
+  }
+  double flap_ms = (now() - start) * 1000 / (2 * kRuns);
+  double flap_lfa_ms =
+    flap_ms - (throttle->runTime() - spf_us) / 1000.0 / (2 * kRuns);
+
+  int mismatches = 0;
+  for (int i = 0; i < routers; ++i) {
+    if (nodes[i]->distance() != expected[i])
+      ++mismatches;
+  }
+
+  printf("%6d routers  linear-scan: %10.2f ms  indexed-heap: %8.2f ms "
+         "(LFA %6.2f ms)  incremental: %6.3f ms (LFA %6.3f ms)%s\n",
+         routers, reference_ms, heap_ms, heap_lfa_ms, flap_ms, flap_lfa_ms,
+         mismatches ? "  (RESULTS DIFFER)" : "");
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i)
+      benchmark(atoi(argv[i]));
+  } else {
+    for (size_t i = 0; i < sizeof(kDefaultSizes) / sizeof(int); ++i)
+      benchmark(kDefaultSizes[i]);
+  }
+
+  return 0;
+}
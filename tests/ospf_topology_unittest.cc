@@ -1,6 +1,11 @@
 #include "gtest/gtest.h"
 
+#include <cstdlib>
+#include <deque>
+#include <map>
 #include <ostream>
+#include <set>
+#include <vector>
 
 #include "ospf_link.h"
 #include "ospf_node.h"
@@ -181,3 +186,443 @@ TEST_F(OSPFTopologyTest, link_delete_reverse) {
   EXPECT_EQ(nodes_[0]->links(), (size_t)0);
   EXPECT_EQ(nodes_[1]->links(), (size_t)0);
 }
+
+TEST_F(OSPFTopologyTest, unreachable) {
+  topology_->nodeIs(nodes_[0]);
+  topology_->nodeIs(nodes_[1]);
+  root_node_->linkIs(links_[0]);
+  topology_->onUpdate();
+
+  EXPECT_EQ(nodes_[0]->distance(), 1u);
+  EXPECT_EQ(nodes_[1]->distance(), OSPFNode::kMaxDistance);
+  EXPECT_TRUE(nodes_[1]->upstreamNode() == NULL);
+  EXPECT_TRUE(topology_->nextHop(ids_[1]) == NULL);
+
+  /* Previously computed paths are cleared once a node becomes unreachable. */
+  root_node_->activeLinkDel(ids_[0]);
+  topology_->onUpdate();
+  EXPECT_EQ(nodes_[0]->distance(), OSPFNode::kMaxDistance);
+  EXPECT_TRUE(nodes_[0]->upstreamNode() == NULL);
+}
+
+TEST_F(OSPFTopologyTest, ring) {
+  /* Topology: R - 0 - 1 - ... - 9 - R */
+  for (int i = 0; i < kNodes; ++i)
+    topology_->nodeIs(nodes_[i]);
+
+  root_node_->linkIs(links_[0]);
+  root_node_->linkIs(links_[kNodes - 1]);
+  for (int i = 0; i < kNodes - 1; ++i)
+    nodes_[i]->linkIs(links_[i + 1]);
+
+  topology_->onUpdate();
+
+  EXPECT_EQ(root_node_->distance(), 0u);
+  for (int i = 0; i < kNodes; ++i) {
+    uint32_t clockwise = i + 1;
+    uint32_t counter_clockwise = kNodes - i;
+    if (clockwise < counter_clockwise) {
+      EXPECT_EQ(nodes_[i]->distance(), clockwise);
+      EXPECT_EQ(topology_->nextHop(ids_[i]), nodes_[0]);
+    } else {
+      EXPECT_EQ(nodes_[i]->distance(), counter_clockwise);
+      EXPECT_EQ(topology_->nextHop(ids_[i]), nodes_[kNodes - 1]);
+    }
+  }
+}
+
+TEST_F(OSPFTopologyTest, changed_nodes) {
+  setup_six_node_topology();
+
+  /* Passive link on a leaf only affects the leaf itself. */
+  nodes_[4]->linkIs(OSPFLink::NewPassive(0x0a000000, 0xffffff00));
+  topology_->onUpdate();
+  ASSERT_EQ(topology_->changedNodes().size(), (size_t)1);
+  EXPECT_EQ(topology_->changedNodes()[0], ids_[4]);
+
+  /* Deleting a tree link detaches and reattaches the subtree below it. */
+  root_node_->activeLinkDel(ids_[1]);
+  topology_->onUpdate();
+
+  std::set<RouterID> changed(topology_->changedNodes().begin(),
+                             topology_->changedNodes().end());
+  EXPECT_EQ(changed.count(root_node_id_), (size_t)1);
+  EXPECT_EQ(changed.count(ids_[1]), (size_t)1);
+  EXPECT_EQ(changed.count(ids_[3]), (size_t)1);
+  EXPECT_EQ(changed.count(ids_[4]), (size_t)1);
+
+  /* 0 and 2 keep their place in the tree, but lose 1 as their loop-free
+     alternate. */
+  EXPECT_EQ(changed.count(ids_[0]), (size_t)1);
+  EXPECT_EQ(changed.count(ids_[2]), (size_t)1);
+  EXPECT_EQ(nodes_[0]->distance(), 1u);
+  EXPECT_EQ(nodes_[2]->distance(), 1u);
+  EXPECT_TRUE(nodes_[0]->backupHop() == NULL);
+
+  EXPECT_EQ(nodes_[1]->upstreamNode(), nodes_[0]);
+  EXPECT_EQ(nodes_[3]->upstreamNode(), nodes_[1]);
+  EXPECT_EQ(nodes_[1]->distance(), 2u);
+  EXPECT_EQ(nodes_[3]->distance(), 3u);
+
+  /* Removing a node requires a full recomputation; the removed node is
+     reported as changed. */
+  topology_->nodeDel(ids_[3]);
+  topology_->onUpdate();
+  changed = std::set<RouterID>(topology_->changedNodes().begin(),
+                               topology_->changedNodes().end());
+  EXPECT_EQ(changed.count(ids_[3]), (size_t)1);
+}
+
+TEST_F(OSPFTopologyTest, equal_cost_paths) {
+  /* Topology:
+              0
+             / \
+            R   2 -- 3
+             \ /
+              1
+  */
+  root_node_->linkIs(links_[0]);
+  root_node_->linkIs(links_[1]);
+  nodes_[0]->linkIs(links_[2]);
+  nodes_[1]->linkIs(links_[2]);
+  nodes_[2]->linkIs(links_[3]);
+  topology_->onUpdate();
+
+  for (int i = 2; i <= 3; ++i) {
+    ASSERT_EQ(nodes_[i]->firstHops(), (size_t)2);
+    EXPECT_EQ(*nodes_[i]->firstHopsBegin(), nodes_[0]);
+    EXPECT_EQ(*(nodes_[i]->firstHopsBegin() + 1), nodes_[1]);
+  }
+  EXPECT_EQ(nodes_[0]->firstHops(), (size_t)1);
+  EXPECT_EQ(root_node_->firstHops(), (size_t)0);
+
+  /* Losing one of the paths leaves a single first hop; neither distances
+     nor upstream nodes change for 3, but its first hops do. */
+  root_node_->activeLinkDel(ids_[1]);
+  topology_->onUpdate();
+
+  std::set<RouterID> changed(topology_->changedNodes().begin(),
+                             topology_->changedNodes().end());
+  EXPECT_EQ(changed.count(ids_[3]), (size_t)1);
+  for (int i = 2; i <= 3; ++i) {
+    ASSERT_EQ(nodes_[i]->firstHops(), (size_t)1);
+    EXPECT_EQ(*nodes_[i]->firstHopsBegin(), nodes_[0]);
+  }
+
+  /* Restoring it brings the second path back. */
+  root_node_->linkIs(links_[1]);
+  topology_->onUpdate();
+  EXPECT_EQ(nodes_[2]->firstHops(), (size_t)2);
+  EXPECT_EQ(nodes_[3]->firstHops(), (size_t)2);
+}
+
+/* Link from NODE with cost COST. */
+static OSPFLink::Ptr
+cost_link(OSPFNode::Ptr node, uint16_t cost) {
+  OSPFLink::Ptr link = OSPFLink::New(node, (uint32_t)0, (uint32_t)0);
+  link->costIs(cost);
+  return link;
+}
+
+TEST_F(OSPFTopologyTest, link_costs) {
+  /* Topology, with link costs:
+            10
+          R -- 0
+        1 |    | 1
+          1 -- 2
+            1
+  */
+  root_node_->linkIs(cost_link(nodes_[0], 10));
+  root_node_->linkIs(cost_link(nodes_[1], 1));
+  nodes_[1]->linkIs(cost_link(nodes_[2], 1));
+  nodes_[2]->linkIs(cost_link(nodes_[0], 1));
+  topology_->onUpdate();
+
+  /* Costs apply in both directions. */
+  EXPECT_EQ(nodes_[0]->activeLink(root_node_id_)->cost(), 10);
+
+  /* The cheaper path around the square wins over the direct link. */
+  EXPECT_EQ(nodes_[0]->distance(), 3u);
+  EXPECT_EQ(nodes_[0]->upstreamNode(), nodes_[2]);
+  EXPECT_EQ(topology_->nextHop(ids_[0]), nodes_[1]);
+
+  /* Raising the cost of a tree link moves the nodes beyond it. */
+  nodes_[1]->linkIs(cost_link(nodes_[2], 20));
+  topology_->onUpdate();
+  EXPECT_EQ(nodes_[0]->distance(), 10u);
+  EXPECT_EQ(nodes_[0]->upstreamNode(), root_node_);
+  EXPECT_EQ(nodes_[2]->distance(), 11u);
+  EXPECT_EQ(nodes_[2]->upstreamNode(), nodes_[0]);
+  EXPECT_EQ(topology_->nextHop(ids_[2]), nodes_[0]);
+
+  /* Lowering it again restores the original tree. */
+  nodes_[2]->linkIs(cost_link(nodes_[1], 1));
+  topology_->onUpdate();
+  EXPECT_EQ(nodes_[2]->distance(), 2u);
+  EXPECT_EQ(nodes_[2]->upstreamNode(), nodes_[1]);
+  EXPECT_EQ(nodes_[0]->distance(), 3u);
+  EXPECT_EQ(topology_->nextHop(ids_[0]), nodes_[1]);
+}
+
+TEST_F(OSPFTopologyTest, loop_free_alternates) {
+  /* Topology:
+            0 -- 2
+           / \    \
+          R - 1    3
+           \      /
+            4 ----
+  */
+  root_node_->linkIs(links_[0]);
+  root_node_->linkIs(links_[1]);
+  root_node_->linkIs(links_[4]);
+  nodes_[0]->linkIs(links_[1]);
+  nodes_[0]->linkIs(links_[2]);
+  nodes_[2]->linkIs(links_[3]);
+  nodes_[3]->linkIs(links_[4]);
+  topology_->onUpdate();
+
+  /* 1 reaches 0 directly, so it protects the link to 0. */
+  EXPECT_EQ(topology_->nextHop(ids_[0]), nodes_[0]);
+  EXPECT_EQ(nodes_[0]->backupHop(), nodes_[1]);
+
+  /* Both 1 and 4 protect the link to 2's first hop 0, but only 4 avoids
+     node 0 itself. */
+  EXPECT_EQ(topology_->nextHop(ids_[2]), nodes_[0]);
+  EXPECT_EQ(nodes_[2]->backupHop(), nodes_[4]);
+
+  /* 0 protects 3 against the failure of its first hop 4. */
+  EXPECT_EQ(topology_->nextHop(ids_[3]), nodes_[4]);
+  EXPECT_EQ(nodes_[3]->backupHop(), nodes_[0]);
+
+  /* Without the path through 4, 1 is the only alternate left for 2. The
+     change is reported even though 2's shortest path is unchanged. */
+  nodes_[3]->activeLinkDel(ids_[4]);
+  topology_->onUpdate();
+
+  std::set<RouterID> changed(topology_->changedNodes().begin(),
+                             topology_->changedNodes().end());
+  EXPECT_EQ(changed.count(ids_[2]), (size_t)1);
+  EXPECT_EQ(nodes_[2]->backupHop(), nodes_[1]);
+  EXPECT_TRUE(nodes_[4]->backupHop() == NULL);
+}
+
+/* Shortest distances from ROOT over active links, weighted by their costs;
+   links are relaxed until no distance improves. */
+static std::map<RouterID,uint32_t>
+reference_distances(OSPFNode::Ptr root, OSPFTopology::Ptr topology) {
+  std::map<RouterID,uint32_t> dist;
+  std::deque<OSPFNode::Ptr> queue;
+  dist[root->routerID()] = 0;
+  queue.push_back(root);
+
+  while (!queue.empty()) {
+    OSPFNode::Ptr node = queue.front();
+    queue.pop_front();
+    for (OSPFNode::lna_iter it = node->activeLinksBegin();
+         it != node->activeLinksEnd(); ++it) {
+      OSPFNode::Ptr neighbor = it->second->node();
+      if (topology->node(neighbor->routerID()) == NULL)
+        continue;
+
+      uint32_t alt_dist = dist[node->routerID()] + it->second->cost();
+      std::map<RouterID,uint32_t>::iterator d_it =
+        dist.find(neighbor->routerID());
+      if (d_it == dist.end() || alt_dist < d_it->second) {
+        dist[neighbor->routerID()] = alt_dist;
+        queue.push_back(neighbor);
+      }
+    }
+  }
+
+  return dist;
+}
+
+/* Equal-cost first hops derived from the distances in DIST: the first hops
+   of a node are the union of those of its neighbors whose distance plus the
+   cost of their link to the node is the node's distance, or the node itself
+   if it is such a neighbor of the root. */
+static std::map<RouterID,std::set<RouterID> >
+reference_first_hops(OSPFNode::Ptr root, OSPFTopology::Ptr topology,
+                     const std::map<RouterID,uint32_t>& dist) {
+  std::multimap<uint32_t,RouterID> by_dist;
+  std::map<RouterID,uint32_t>::const_iterator it;
+  for (it = dist.begin(); it != dist.end(); ++it)
+    by_dist.insert(std::make_pair(it->second, it->first));
+
+  std::map<RouterID,std::set<RouterID> > hops;
+  std::multimap<uint32_t,RouterID>::const_iterator d_it;
+  for (d_it = by_dist.begin(); d_it != by_dist.end(); ++d_it) {
+    OSPFNode::Ptr node = topology->node(d_it->second);
+    for (OSPFNode::lna_iter l_it = node->activeLinksBegin();
+         l_it != node->activeLinksEnd(); ++l_it) {
+      RouterID parent = l_it->second->node()->routerID();
+      it = dist.find(parent);
+      if (it == dist.end()
+          || it->second + l_it->second->cost() != d_it->first)
+        continue;
+
+      if (parent == root->routerID())
+        hops[node->routerID()].insert(node->routerID());
+      else
+        hops[node->routerID()].insert(hops[parent].begin(),
+                                      hops[parent].end());
+    }
+  }
+
+  return hops;
+}
+
+/* Link from NODE with a random cost between 1 and 4. */
+static OSPFLink::Ptr
+random_cost_link(OSPFNode::Ptr node) {
+  OSPFLink::Ptr link = OSPFLink::New(node, (uint32_t)0, (uint32_t)0);
+  link->costIs(1 + rand() % 4);
+  return link;
+}
+
+TEST_F(OSPFTopologyTest, incremental_matches_reference) {
+  static const int kRouters = 64;
+  static const int kRounds = 200;
+
+  std::vector<OSPFNode::Ptr> nodes;
+  for (int i = 0; i < kRouters; ++i) {
+    nodes.push_back(OSPFNode::New(100 + i));
+    topology_->nodeIs(nodes[i]);
+  }
+
+  srand(kRouters);
+  for (int i = 0; i < kRouters; ++i) {
+    OSPFNode::Ptr other = (i == 0) ? root_node_ : nodes[rand() % i];
+    nodes[i]->linkIs(random_cost_link(other));
+  }
+  topology_->onUpdate();
+
+  for (int round = 0; round < kRounds; ++round) {
+    /* A batch of random link additions, removals and cost changes per
+       update. */
+    for (int change = 0; change < 1 + round % 3; ++change) {
+      OSPFNode::Ptr a = nodes[rand() % kRouters];
+      OSPFNode::Ptr b = (rand() % 8 == 0) ? root_node_
+                                          : nodes[rand() % kRouters];
+      if (a->activeLink(b->routerID()) && rand() % 2 == 0)
+        a->activeLinkDel(b->routerID());
+      else
+        a->linkIs(random_cost_link(b));
+    }
+
+    topology_->onUpdate();
+
+    std::map<RouterID,uint32_t> expected =
+      reference_distances(root_node_, topology_);
+    std::map<RouterID,std::set<RouterID> > expected_hops =
+      reference_first_hops(root_node_, topology_, expected);
+
+    /* Distances from every neighbor of the root, for loop-free alternates. */
+    std::map<RouterID,std::map<RouterID,uint32_t> > nbr_dist;
+    for (OSPFNode::lna_iter it = root_node_->activeLinksBegin();
+         it != root_node_->activeLinksEnd(); ++it) {
+      OSPFNode::Ptr nbr = it->second->node();
+      nbr_dist[nbr->routerID()] = reference_distances(nbr, topology_);
+    }
+    for (int i = 0; i < kRouters; ++i) {
+      OSPFNode::Ptr node = nodes[i];
+      std::map<RouterID,uint32_t>::iterator it =
+        expected.find(node->routerID());
+      if (it == expected.end()) {
+        EXPECT_EQ(node->distance(), OSPFNode::kMaxDistance);
+        EXPECT_TRUE(node->upstreamNode() == NULL);
+        EXPECT_TRUE(topology_->nextHop(node->routerID()) == NULL);
+        EXPECT_EQ(node->firstHops(), (size_t)0);
+        continue;
+      }
+
+      ASSERT_EQ(node->distance(), it->second) << "round " << round;
+      OSPFNode::Ptr upstream = node->upstreamNode();
+      ASSERT_TRUE(upstream != NULL);
+      OSPFLink::Ptr link = node->activeLink(upstream->routerID());
+      ASSERT_TRUE(link != NULL);
+      EXPECT_EQ(upstream->distance() + link->cost(), node->distance());
+
+      /* Recorded first hop must match the one found by walking up the tree. */
+      OSPFNode::Ptr first_hop = node;
+      for (int d = 0; d < kRouters && first_hop->upstreamNode() != root_node_;
+           ++d) {
+        first_hop = first_hop->upstreamNode();
+      }
+      EXPECT_EQ(topology_->nextHop(node->routerID()), first_hop);
+
+      std::set<RouterID> hops;
+      for (OSPFNode::const_fh_iter h_it = node->firstHopsBegin();
+           h_it != node->firstHopsEnd(); ++h_it) {
+        hops.insert((*h_it)->routerID());
+      }
+      EXPECT_EQ(hops, expected_hops[node->routerID()]) << "round " << round;
+      EXPECT_EQ(hops.count(first_hop->routerID()), (size_t)1);
+
+      /* The backup hop is the best loop-free alternate: one that protects
+         against the failure of the first hop if possible, then the closest
+         one, then the one with the lowest RouterID. */
+      const RouterID x = node->routerID();
+      const RouterID p = first_hop->routerID();
+      std::map<RouterID,uint32_t>& p_dist = nbr_dist[p];
+      bool has_alternate = false;
+      bool best_protects = false;
+      uint64_t best_dist = 0;
+      RouterID best = 0;
+      std::map<RouterID,std::map<RouterID,uint32_t> >::iterator n_it;
+      for (n_it = nbr_dist.begin(); n_it != nbr_dist.end(); ++n_it) {
+        std::map<RouterID,uint32_t>& dist = n_it->second;
+        if (n_it->first == p || !dist.count(x)
+            || dist[x] >= (uint64_t)dist[root_node_id_] + node->distance())
+          continue;
+
+        bool protects = x != p && p_dist.count(x)
+                        && dist[x] < (uint64_t)dist[p] + p_dist[x];
+        uint64_t d = (uint64_t)topology_->node(n_it->first)->distance()
+                     + dist[x];
+        if (!has_alternate || (protects && !best_protects)
+            || (protects == best_protects && d < best_dist)) {
+          has_alternate = true;
+          best_protects = protects;
+          best_dist = d;
+          best = n_it->first;
+        }
+      }
+
+      OSPFNode::Ptr backup = node->backupHop();
+      if (hops.size() > 1) {
+        EXPECT_TRUE(backup == NULL);
+      } else if (!has_alternate) {
+        EXPECT_TRUE(backup == NULL) << "round " << round;
+      } else {
+        ASSERT_TRUE(backup != NULL) << "round " << round;
+        EXPECT_EQ(backup->routerID(), best) << "round " << round;
+      }
+    }
+  }
+}
+
+TEST_F(OSPFTopologyTest, throttled_update) {
+  OSPFSPFThrottle::Ptr throttle = topology_->spfThrottle();
+
+  topology_->nodeIs(nodes_[0]);
+  root_node_->linkIs(links_[0]);
+  nodes_[0]->linkIs(links_[1]);
+  ASSERT_TRUE(throttle->pending());
+
+  /* Nothing is computed before the throttle's deadline. */
+  Milliseconds deadline = throttle->deadline();
+  topology_->onTick(deadline.value() - 1);
+  EXPECT_EQ(throttle->runs(), (uint64_t)0);
+  EXPECT_TRUE(nodes_[0]->upstreamNode() == NULL);
+
+  /* All changes are accounted for by a single computation. */
+  topology_->onTick(deadline);
+  EXPECT_EQ(throttle->runs(), (uint64_t)1);
+  EXPECT_GT(throttle->suppressedRuns(), (uint64_t)0);
+  EXPECT_EQ(nodes_[0]->upstreamNode(), root_node_);
+  EXPECT_EQ(nodes_[1]->upstreamNode(), nodes_[0]);
+
+  topology_->onTick(deadline.value() + 1000);
+  EXPECT_EQ(throttle->runs(), (uint64_t)1);
+}
@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <string>
+
+#include "ethernet_packet.h"
+#include "packet_buffer.h"
+#include "punt_queue.h"
+#include "time_types.h"
+
+class PuntQueueTest : public ::testing::Test {
+ protected:
+  PuntQueueTest() : queue_(PuntQueue::New()) {}
+
+  /* Punts a new packet of class C at time NOW. */
+  bool punt(PuntQueue::Class c, const Milliseconds& now) {
+    PacketBuffer::Ptr buffer = PacketBuffer::New(EthernetPacket::kHeaderSize);
+    Packet::Ptr pkt = EthernetPacket::New(buffer, 0);
+    last_ = pkt;
+    return queue_->onPacket(c, PuntQueue::Entry(pkt, NULL, PuntQueue::kInput),
+                            now);
+  }
+
+  /* Returns the class of each packet in the queue, in the order in which
+     next() hands them out. */
+  std::string drain() {
+    std::string order;
+    for (;;) {
+      PuntQueue::Entry entry = queue_->next();
+      if (!entry.packet())
+        break;
+      order += classes_[entry.packet().ptr()];
+    }
+    return order;
+  }
+
+  /* Punts COUNT packets of class C, tagged with TAG. */
+  void fill(PuntQueue::Class c, int count, char tag) {
+    for (int i = 0; i < count; ++i) {
+      ASSERT_TRUE(punt(c, 1000));
+      classes_[last_.ptr()] = tag;
+    }
+  }
+
+  PuntQueue::Ptr queue_;
+  Packet::Ptr last_;
+  std::map<Packet*, char> classes_;
+};
+
+TEST_F(PuntQueueTest, policing) {
+  queue_->rateIs(PuntQueue::kException, 100);
+  queue_->burstIs(PuntQueue::kException, 10);
+
+  // A burst is admitted up to its limit.
+  for (int i = 0; i < 10; ++i)
+    EXPECT_TRUE(punt(PuntQueue::kException, 1000));
+  EXPECT_FALSE(punt(PuntQueue::kException, 1000));
+  EXPECT_EQ((uint64_t)10, queue_->enqueued(PuntQueue::kException));
+  EXPECT_EQ((uint64_t)1, queue_->policed(PuntQueue::kException));
+
+  // 100 packets per second: one every 10 ms.
+  EXPECT_FALSE(punt(PuntQueue::kException, 1005));
+  EXPECT_TRUE(punt(PuntQueue::kException, 1010));
+  EXPECT_FALSE(punt(PuntQueue::kException, 1010));
+  EXPECT_EQ((uint64_t)3, queue_->policed(PuntQueue::kException));
+
+  // Other classes are not affected.
+  EXPECT_TRUE(punt(PuntQueue::kRoutingProtocol, 1010));
+  EXPECT_EQ((uint64_t)0, queue_->policed(PuntQueue::kRoutingProtocol));
+
+  // The bucket does not fill beyond the burst size.
+  queue_->capacityIs(PuntQueue::kException, 100);
+  for (int i = 0; i < 10; ++i)
+    EXPECT_TRUE(punt(PuntQueue::kException, 100000));
+  EXPECT_FALSE(punt(PuntQueue::kException, 100000));
+
+  // A rate of zero disables policing.
+  queue_->rateIs(PuntQueue::kException, 0);
+  for (int i = 0; i < 50; ++i)
+    EXPECT_TRUE(punt(PuntQueue::kException, 100000));
+}
+
+TEST_F(PuntQueueTest, overflow) {
+  queue_->capacityIs(PuntQueue::kARP, 3);
+  for (int i = 0; i < 3; ++i)
+    EXPECT_TRUE(punt(PuntQueue::kARP, 1000));
+  EXPECT_FALSE(punt(PuntQueue::kARP, 1000));
+  EXPECT_EQ((uint64_t)1, queue_->overflows(PuntQueue::kARP));
+  EXPECT_EQ((uint64_t)0, queue_->policed(PuntQueue::kARP));
+  EXPECT_EQ((size_t)3, queue_->packets(PuntQueue::kARP));
+
+  // Room is made by handing packets out.
+  EXPECT_TRUE(queue_->next().packet());
+  EXPECT_EQ((uint64_t)1, queue_->dispatched(PuntQueue::kARP));
+  EXPECT_TRUE(punt(PuntQueue::kARP, 1000));
+
+  queue_->statsDel();
+  EXPECT_EQ((uint64_t)0, queue_->overflows(PuntQueue::kARP));
+  EXPECT_EQ((size_t)3, queue_->packets());
+}
+
+TEST_F(PuntQueueTest, answer) {
+  queue_->rateIs(PuntQueue::kEcho, 100);
+  queue_->burstIs(PuntQueue::kEcho, 10);
+
+  // Packets answered by the data plane share the bucket of their class with
+  // the punted ones, but are not queued.
+  for (int i = 0; i < 5; ++i)
+    EXPECT_TRUE(queue_->onAnswer(PuntQueue::kEcho, 1000));
+  for (int i = 0; i < 5; ++i)
+    EXPECT_TRUE(punt(PuntQueue::kEcho, 1000));
+  EXPECT_FALSE(queue_->onAnswer(PuntQueue::kEcho, 1000));
+  EXPECT_FALSE(punt(PuntQueue::kEcho, 1000));
+  EXPECT_EQ((uint64_t)5, queue_->answered(PuntQueue::kEcho));
+  EXPECT_EQ((uint64_t)5, queue_->enqueued(PuntQueue::kEcho));
+  EXPECT_EQ((uint64_t)2, queue_->policed(PuntQueue::kEcho));
+  EXPECT_EQ((size_t)5, queue_->packets());
+
+  EXPECT_TRUE(queue_->onAnswer(PuntQueue::kEcho, 1010));
+  EXPECT_EQ((uint64_t)6, queue_->answered(PuntQueue::kEcho));
+
+  queue_->statsDel();
+  EXPECT_EQ((uint64_t)0, queue_->answered(PuntQueue::kEcho));
+}
+
+TEST_F(PuntQueueTest, scheduling) {
+  queue_->weightIs(PuntQueue::kRoutingProtocol, 3);
+  queue_->weightIs(PuntQueue::kARP, 2);
+  queue_->weightIs(PuntQueue::kLocal, 1);
+  queue_->weightIs(PuntQueue::kException, 1);
+
+  // Packets are punted with exception traffic first, but are handed out by
+  // priority and weight.
+  fill(PuntQueue::kException, 4, 'e');
+  fill(PuntQueue::kLocal, 2, 'l');
+  fill(PuntQueue::kARP, 3, 'a');
+  fill(PuntQueue::kRoutingProtocol, 5, 'r');
+  EXPECT_EQ((size_t)14, queue_->packets());
+  EXPECT_EQ("rrraalerraleee", drain());
+}
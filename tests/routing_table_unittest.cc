@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 
+#include <map>
 #include <ostream>
 #include <string>
 
@@ -209,3 +210,88 @@ TEST_F(RoutingTableTest, updateRoute) {
   EXPECT_EQ(eth0_->subnet(), entry->subnet());
   EXPECT_EQ(eth0_dup->gateway(), entry->gateway());
 }
+
+
+TEST_F(RoutingTableTest, multipath) {
+  // Default route over eth0, eth1 and eth2.
+  eth0_->nextHopNew("172.24.74.18", if_eth1_);
+  eth0_->nextHopNew("172.24.74.19", if_eth2_);
+  routing_table_->entryIs(eth0_);
+  EXPECT_EQ((size_t)3, eth0_->nextHops());
+  EXPECT_EQ(if_eth0_.ptr(), eth0_->interface().ptr());
+
+  // Flows are spread over all next hops; each flow sticks to one of them.
+  std::map<string,int> flows;
+  for (uint32_t hash = 0; hash < 300; ++hash) {
+    const RoutingTable::Entry::NextHop& next_hop = eth0_->flowNextHop(hash);
+    EXPECT_EQ(next_hop, eth0_->flowNextHop(hash));
+    ++flows[next_hop.interface()->name()];
+  }
+  EXPECT_EQ(100, flows["eth0"]);
+  EXPECT_EQ(100, flows["eth1"]);
+  EXPECT_EQ(100, flows["eth2"]);
+
+  // Flows avoid next hops on disabled interfaces.
+  if_eth1_->enabledIs(false);
+  EXPECT_EQ((size_t)2, eth0_->enabledNextHops());
+  for (uint32_t hash = 0; hash < 300; ++hash)
+    EXPECT_NE(if_eth1_.ptr(), eth0_->flowNextHop(hash).interface().ptr());
+
+  // The route remains usable while any of its interfaces is enabled, even
+  // if the primary one is not.
+  if_eth0_->enabledIs(false);
+  EXPECT_EQ(eth0_, routing_table_->lpm("202.18.49.17"));
+  EXPECT_EQ(if_eth2_.ptr(), eth0_->flowNextHop(0).interface().ptr());
+
+  if_eth2_->enabledIs(false);
+  EXPECT_EQ(NULL, routing_table_->lpm("202.18.49.17").ptr());
+}
+
+
+TEST_F(RoutingTableTest, multipathEquality) {
+  RoutingTable::Entry::Ptr a =
+    RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  a->subnetIs(eth0_->subnet(), eth0_->subnetMask());
+  a->gatewayIs(eth0_->gateway());
+  a->interfaceIs(eth0_->interface());
+  EXPECT_TRUE(*a == *eth0_);
+
+  // Entries differ if their next-hop groups differ.
+  a->nextHopNew("172.24.74.18", if_eth1_);
+  EXPECT_TRUE(*a != *eth0_);
+
+  eth0_->nextHopNew("172.24.74.18", if_eth1_);
+  EXPECT_TRUE(*a == *eth0_);
+}
+
+
+TEST_F(RoutingTableTest, backup) {
+  eth3_->backupNextHopIs("10.99.0.2", if_eth4_);
+  routing_table_->entryIs(eth3_);
+  EXPECT_EQ(if_eth4_.ptr(), eth3_->backupNextHop().interface().ptr());
+
+  // The backup is not used while the primary next hop is enabled.
+  EXPECT_EQ(if_eth3_.ptr(), eth3_->activeNextHop().interface().ptr());
+  EXPECT_EQ(if_eth3_.ptr(), eth3_->flowNextHop(7).interface().ptr());
+
+  // It takes over as soon as the primary interface goes down.
+  if_eth3_->enabledIs(false);
+  EXPECT_EQ(eth3_, routing_table_->lpm("10.99.15.15"));
+  EXPECT_EQ(IPv4Addr("10.99.0.2"), eth3_->activeNextHop().gateway());
+  EXPECT_EQ(if_eth4_.ptr(), eth3_->flowNextHop(7).interface().ptr());
+
+  if_eth4_->enabledIs(false);
+  EXPECT_FALSE(eth3_->usable());
+  EXPECT_EQ(NULL, routing_table_->lpm("10.99.15.15").ptr());
+
+  // Entries differ if their backups differ.
+  RoutingTable::Entry::Ptr a =
+    RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  a->subnetIs(eth3_->subnet(), eth3_->subnetMask());
+  a->gatewayIs(eth3_->gateway());
+  a->interfaceIs(eth3_->interface());
+  EXPECT_TRUE(*a != *eth3_);
+
+  a->backupNextHopIs("10.99.0.2", if_eth4_);
+  EXPECT_TRUE(*a == *eth3_);
+}
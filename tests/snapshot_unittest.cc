@@ -0,0 +1,219 @@
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#include "arp_cache.h"
+#include "interface.h"
+#include "interface_map.h"
+#include "ospf_area.h"
+#include "ospf_constants.h"
+#include "ospf_link.h"
+#include "ospf_node.h"
+#include "ospf_router.h"
+#include "ospf_topology.h"
+#include "routing_table.h"
+#include "snapshot.h"
+
+using std::string;
+
+
+namespace {
+
+const RouterID kRouterID = 0x0a000001;
+
+// Forwarding state of a router with interfaces eth0 and eth1.
+struct RouterState {
+  RouterState() {
+    iface_map = InterfaceMap::InterfaceMapNew();
+    const char* names[] = { "eth0", "eth1" };
+    for (uint32_t i = 0; i < 2; ++i) {
+      Interface::Ptr iface = Interface::InterfaceNew(names[i]);
+      iface->ipIs(0x0a000001 + (i << 8));
+      iface->subnetMaskIs(0xffffff00);
+      iface_map->interfaceIs(iface);
+    }
+
+    rtable = RoutingTable::New(iface_map);
+    arp_cache = ARPCache::New();
+    ospf_router = OSPFRouter::New(kRouterID, OSPF::kDefaultAreaID, rtable,
+                                  iface_map, NULL);
+  }
+
+  Snapshot::Ptr snapshot(const string& path) {
+    return Snapshot::New(path, rtable, arp_cache, ospf_router, iface_map);
+  }
+
+  InterfaceMap::Ptr iface_map;
+  RoutingTable::Ptr rtable;
+  ARPCache::Ptr arp_cache;
+  OSPFRouter::Ptr ospf_router;
+};
+
+}  // namespace
+
+
+class SnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    char path[] = "/tmp/snapshot_unittest.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    path_ = path;
+
+    // A dynamic route with two next hops and a backup, and a static route.
+    Interface::Ptr eth0 = state_.iface_map->interface("eth0");
+    Interface::Ptr eth1 = state_.iface_map->interface("eth1");
+    RoutingTable::Entry::Ptr entry = RoutingTable::Entry::New();
+    entry->subnetIs(0xc0a80000, 0xffff0000);
+    entry->gatewayIs(0x0a000002);
+    entry->interfaceIs(eth0);
+    entry->nextHopNew(0x0a000102, eth1);
+    entry->backupNextHopIs(0x0a000003, eth0);
+    state_.rtable->entryIs(entry);
+
+    entry = RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+    entry->subnetIs(0xac100000, 0xfff00000);
+    entry->gatewayIs(0x0a000002);
+    entry->interfaceIs(eth0);
+    state_.rtable->entryIs(entry);
+
+    // A dynamic and a static ARP entry.
+    state_.arp_cache->entryIs(
+        ARPCache::Entry::New(0x0a000002, "00:11:22:33:44:55"));
+    ARPCache::Entry::Ptr arp_entry =
+        ARPCache::Entry::New(0x0a000003, "00:11:22:33:44:66");
+    arp_entry->typeIs(ARPCache::Entry::kStatic);
+    state_.arp_cache->entryIs(arp_entry);
+
+    // Routers 2 and 3 are linked; router 2 also has a passive link, and is
+    // linked to this router.
+    OSPFTopology::Ptr topology = state_.ospf_router->topology();
+    OSPFNode::Ptr node2 = OSPFNode::New(2);
+    OSPFNode::Ptr node3 = OSPFNode::New(3);
+    topology->nodeIs(node2);
+    topology->nodeIs(node3);
+
+    OSPFLink::Ptr link = OSPFLink::New(node3, 0x0b000000, 0xffffff00);
+    link->costIs(5);
+    node2->linkIs(link);
+    node2->linkIs(OSPFLink::NewPassive(0x0c000000, 0xffffff00));
+    topology->rootNode()->linkIs(OSPFLink::New(node2, 0x0a000000,
+                                               0xffffff00));
+
+    state_.ospf_router->lsuSeqnoIs(OSPF::kDefaultAreaID, 7);
+  }
+
+  void TearDown() {
+    unlink(path_.c_str());
+  }
+
+  string path_;
+  RouterState state_;
+};
+
+
+TEST_F(SnapshotTest, restore) {
+  ASSERT_TRUE(state_.snapshot(path_)->write());
+
+  RouterState restored;
+  size_t entries = restored.rtable->entries();
+  Snapshot::Ptr snapshot = restored.snapshot(path_);
+  ASSERT_TRUE(snapshot->load());
+  EXPECT_EQ(1u, snapshot->routesRestored());
+  EXPECT_EQ(1u, snapshot->arpEntriesRestored());
+  EXPECT_EQ(2u, snapshot->linksRestored());
+
+  // Only dynamic routes are restored, with all their next hops.
+  EXPECT_EQ(entries + 1, restored.rtable->entries());
+  RoutingTable::Entry::Ptr entry = restored.rtable->lpm(0xc0a80101);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_TRUE(entry->stale());
+  EXPECT_EQ(RoutingTable::Entry::kDynamic, entry->type());
+  EXPECT_EQ(IPv4Addr(0xffff0000), entry->subnetMask());
+  ASSERT_EQ(2u, entry->nextHops());
+  EXPECT_EQ(IPv4Addr(0x0a000002), entry->gateway());
+  EXPECT_EQ(Interface::PtrConst(restored.iface_map->interface("eth0")),
+            entry->interface());
+  EXPECT_EQ(Interface::PtrConst(restored.iface_map->interface("eth1")),
+            entry->nextHop(1).interface());
+  EXPECT_EQ(IPv4Addr(0x0a000003), entry->backupNextHop().gateway());
+
+  // So are dynamic ARP entries.
+  EXPECT_EQ(1u, restored.arp_cache->entries());
+  ARPCache::Entry::Ptr arp_entry = restored.arp_cache->entry(0x0a000002);
+  ASSERT_TRUE(arp_entry != NULL);
+  EXPECT_TRUE(arp_entry->stale());
+  EXPECT_EQ(EthernetAddr("00:11:22:33:44:55"), arp_entry->ethernetAddr());
+
+  // Links of other routers, but not those of this router.
+  OSPFTopology::Ptr topology = restored.ospf_router->topology();
+  OSPFNode::Ptr node2 = topology->node(2);
+  ASSERT_TRUE(node2 != NULL);
+  EXPECT_EQ(1u, node2->activeLinks());
+  EXPECT_EQ(1u, node2->passiveLinks());
+  ASSERT_TRUE(node2->activeLink(3) != NULL);
+  EXPECT_EQ(5, node2->activeLink(3)->cost());
+  EXPECT_TRUE(topology->node(3)->activeLink(2) != NULL);
+  EXPECT_EQ(7u, restored.ospf_router->lsuSeqno(OSPF::kDefaultAreaID));
+}
+
+
+TEST_F(SnapshotTest, freshStateWins) {
+  ASSERT_TRUE(state_.snapshot(path_)->write());
+
+  // A route learned before the snapshot is loaded is kept.
+  RouterState restored;
+  RoutingTable::Entry::Ptr fresh = RoutingTable::Entry::New();
+  fresh->subnetIs(0xc0a80000, 0xffff0000);
+  fresh->gatewayIs(0x0a000004);
+  fresh->interfaceIs(restored.iface_map->interface("eth0"));
+  restored.rtable->entryIs(fresh);
+  size_t entries = restored.rtable->entries();
+
+  Snapshot::Ptr snapshot = restored.snapshot(path_);
+  ASSERT_TRUE(snapshot->load());
+  EXPECT_EQ(0u, snapshot->routesRestored());
+  EXPECT_EQ(fresh, restored.rtable->lpm(0xc0a80101));
+
+  // Only stale routes are cleared.
+  RoutingTable::Entry::Ptr stale = RoutingTable::Entry::New();
+  stale->subnetIs(0xc0a90000, 0xffff0000);
+  stale->gatewayIs(0x0a000002);
+  stale->interfaceIs(restored.iface_map->interface("eth0"));
+  stale->staleIs(true);
+  restored.rtable->entryIs(stale);
+  EXPECT_EQ(entries + 1, restored.rtable->entries());
+
+  restored.rtable->clearStaleEntries();
+  EXPECT_EQ(entries, restored.rtable->entries());
+  EXPECT_EQ(fresh, restored.rtable->lpm(0xc0a80101));
+}
+
+
+TEST_F(SnapshotTest, invalid) {
+  // No snapshot.
+  RouterState restored;
+  size_t entries = restored.rtable->entries();
+  EXPECT_FALSE(restored.snapshot(path_ + ".missing")->load());
+
+  // Truncated snapshots restore nothing.
+  ASSERT_TRUE(state_.snapshot(path_)->write());
+  ASSERT_EQ(0, truncate(path_.c_str(), 60));
+  EXPECT_FALSE(restored.snapshot(path_)->load());
+  EXPECT_EQ(entries, restored.rtable->entries());
+  EXPECT_EQ(0u, restored.arp_cache->entries());
+
+  // Neither do snapshots of another version.
+  ASSERT_TRUE(state_.snapshot(path_)->write());
+  FILE* file = fopen(path_.c_str(), "r+b");
+  ASSERT_TRUE(file != NULL);
+  fseek(file, 4, SEEK_SET);
+  fputc(0xff, file);
+  fclose(file);
+  EXPECT_FALSE(restored.snapshot(path_)->load());
+  EXPECT_EQ(entries, restored.rtable->entries());
+}
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <ctime>
+#include <vector>
 
 #include "task.h"
 #include "time_types.h"
@@ -176,3 +177,169 @@ TEST_F(TaskManagerTest, timeIs) {
   ASSERT_EQ(2, task1_->value());
   ASSERT_EQ(1, task2_->value());
 }
+
+
+class CountingTimer : public Timer {
+ public:
+  typedef Fwk::Ptr<const CountingTimer> PtrConst;
+  typedef Fwk::Ptr<CountingTimer> Ptr;
+
+  static Ptr New(TimerWheel::Ptr wheel) { return new CountingTimer(wheel); }
+
+  int fired() const { return fired_; }
+  int64_t firedAt() const { return fired_at_; }
+
+  // If non-zero, the timer re-arms itself PERIOD ms after firing.
+  void periodIs(int64_t period) { period_ = period; }
+
+ protected:
+  CountingTimer(TimerWheel::Ptr wheel)
+      : wheel_(wheel.ptr()), fired_(0), fired_at_(-1), period_(0) { }
+
+  void onExpiry() {
+    ++fired_;
+    fired_at_ = wheel_->time().value();
+    if (period_ > 0)
+      wheel_->timerIs(this, fired_at_ + period_);
+  }
+
+  TimerWheel* wheel_;
+  int fired_;
+  int64_t fired_at_;
+  int64_t period_;
+};
+
+
+class TimerWheelTest : public ::testing::Test {
+ protected:
+  void SetUp() {
+    wheel_ = TimerWheel::New(1000);
+  }
+
+  // Advances the wheel in steps of STEP ms until time T.
+  void advance(int64_t t, int64_t step) {
+    for (int64_t now = wheel_->time().value(); now < t; ) {
+      now = (now + step < t) ? now + step : t;
+      wheel_->timeIs(now);
+    }
+  }
+
+  TimerWheel::Ptr wheel_;
+};
+
+
+TEST_F(TimerWheelTest, fire) {
+  CountingTimer::Ptr timer = CountingTimer::New(wheel_);
+  wheel_->timerIs(timer, 1010);
+  EXPECT_TRUE(timer->armed());
+  EXPECT_EQ((size_t)1, wheel_->timers());
+
+  wheel_->timeIs(1009);
+  EXPECT_EQ(0, timer->fired());
+
+  wheel_->timeIs(1010);
+  EXPECT_EQ(1, timer->fired());
+  EXPECT_FALSE(timer->armed());
+  EXPECT_EQ((size_t)0, wheel_->timers());
+
+  // Timers fire only once per arming.
+  wheel_->timeIs(5000);
+  EXPECT_EQ(1, timer->fired());
+}
+
+
+TEST_F(TimerWheelTest, cancel) {
+  CountingTimer::Ptr timer = CountingTimer::New(wheel_);
+  wheel_->timerIs(timer, 1500);
+  wheel_->timerDel(timer);
+  EXPECT_FALSE(timer->armed());
+  EXPECT_EQ((size_t)0, wheel_->timers());
+
+  wheel_->timeIs(2000);
+  EXPECT_EQ(0, timer->fired());
+
+  // Re-arming moves the expiry.
+  wheel_->timerIs(timer, 2100);
+  wheel_->timerIs(timer, 2300);
+  EXPECT_EQ((size_t)1, wheel_->timers());
+  wheel_->timeIs(2200);
+  EXPECT_EQ(0, timer->fired());
+  wheel_->timeIs(2300);
+  EXPECT_EQ(1, timer->fired());
+}
+
+
+TEST_F(TimerWheelTest, overdue) {
+  // Timers armed in the past fire on the next advance.
+  CountingTimer::Ptr timer = CountingTimer::New(wheel_);
+  wheel_->timerIs(timer, 10);
+  wheel_->timeIs(1001);
+  EXPECT_EQ(1, timer->fired());
+}
+
+
+// Timers on every level of the wheel fire at their expiry, whether the clock
+// advances by a millisecond or by a large step at a time.
+TEST_F(TimerWheelTest, levels) {
+  const int64_t delays[] = { 1, 255, 256, 257, 65535, 65536, 65537,
+                             1000000, 16777216, 20000000 };
+  const size_t count = sizeof(delays) / sizeof(delays[0]);
+  const int64_t steps[] = { 1, 7, 1000 };
+
+  for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); ++s) {
+    TimerWheel::Ptr wheel = TimerWheel::New(123456);
+    wheel_ = wheel;
+    std::vector<CountingTimer::Ptr> timers;
+    for (size_t i = 0; i < count; ++i) {
+      timers.push_back(CountingTimer::New(wheel));
+      wheel->timerIs(timers[i], 123456 + delays[i]);
+    }
+
+    advance(123456 + delays[count - 1], steps[s]);
+    for (size_t i = 0; i < count; ++i) {
+      ASSERT_EQ(1, timers[i]->fired());
+
+      // Timers fire at the first advance at or after their expiry.
+      int64_t due = 123456 + delays[i];
+      EXPECT_LE(due, timers[i]->firedAt());
+      EXPECT_GT(due + steps[s], timers[i]->firedAt());
+    }
+    EXPECT_EQ((size_t)0, wheel->timers());
+  }
+}
+
+
+TEST_F(TimerWheelTest, periodic) {
+  CountingTimer::Ptr timer = CountingTimer::New(wheel_);
+  timer->periodIs(100);
+  wheel_->timerIs(timer, 1100);
+
+  advance(2050, 10);
+  EXPECT_EQ(10, timer->fired());
+  EXPECT_EQ(2000, timer->firedAt());
+  EXPECT_TRUE(timer->armed());
+}
+
+
+TEST_F(TimerWheelTest, beyondRange) {
+  // Timers beyond the range of the wheel are held back until they come
+  // within range.
+  const int64_t delay = ((int64_t)1 << 33) + 5;
+  CountingTimer::Ptr timer = CountingTimer::New(wheel_);
+  wheel_->timerIs(timer, 1000 + delay);
+
+  wheel_->timeIs(1000 + delay - 1);
+  EXPECT_EQ(0, timer->fired());
+  wheel_->timeIs(1000 + delay);
+  EXPECT_EQ(1, timer->fired());
+}
+
+
+TEST_F(TaskManagerTest, timerWheel) {
+  TimerWheel::Ptr wheel = tm_->timerWheel();
+  CountingTimer::Ptr timer = CountingTimer::New(wheel);
+  wheel->timerIs(timer, wheel->time().value() + 50);
+
+  tm_->tickIs(wheel->time().value() + 50);
+  EXPECT_EQ(1, timer->fired());
+}
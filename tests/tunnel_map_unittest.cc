@@ -84,3 +84,46 @@ TEST_F(TunnelMapTest, Delete) {
   EXPECT_EQ(null, map_->tunnel(tun1_->name()));
   EXPECT_EQ(null, map_->tunnelRemoteAddr(tun1_->remote()));
 }
+
+
+TEST_F(TunnelMapTest, Keys) {
+  Tunnel::Ptr null(NULL);
+
+  // Three tunnels to the same remote: one without a key, two with.
+  Interface::Ptr eth2 = Interface::InterfaceNew("eth2");
+  Tunnel::Ptr tun2 = Tunnel::New(eth2);
+  tun2->remoteIs(tun0_->remote());
+  tun2->keyIs(0);
+  Interface::Ptr eth3 = Interface::InterfaceNew("eth3");
+  Tunnel::Ptr tun3 = Tunnel::New(eth3);
+  tun3->remoteIs(tun0_->remote());
+  tun3->keyIs(0xFFFFFFFF);
+
+  map_->tunnelIs(tun0_);
+  map_->tunnelIs(tun2);
+  map_->tunnelIs(tun3);
+  EXPECT_EQ((size_t)3, map_->tunnels());
+
+  // Packets without a key only match tunnels without one, and vice versa.
+  EXPECT_EQ(tun0_, map_->tunnelRemoteAddr(tun0_->remote()));
+  EXPECT_EQ(tun2, map_->tunnelRemoteAddr(tun0_->remote(), 0));
+  EXPECT_EQ(tun3, map_->tunnelRemoteAddr(tun0_->remote(), 0xFFFFFFFF));
+  EXPECT_EQ(null, map_->tunnelRemoteAddr(tun0_->remote(), 1));
+  EXPECT_EQ(null, map_->tunnelRemoteAddr(tun1_->remote(), 0));
+
+  // A second tunnel with the same endpoint is not found, and deleting it
+  // leaves the first one in place.
+  Interface::Ptr eth4 = Interface::InterfaceNew("eth4");
+  Tunnel::Ptr tun4 = Tunnel::New(eth4);
+  tun4->remoteIs(tun0_->remote());
+  tun4->keyIs(0);
+  map_->tunnelIs(tun4);
+  EXPECT_EQ(tun2, map_->tunnelRemoteAddr(tun0_->remote(), 0));
+  map_->tunnelDel(tun4);
+  EXPECT_EQ(tun2, map_->tunnelRemoteAddr(tun0_->remote(), 0));
+
+  map_->tunnelDel(tun2);
+  EXPECT_EQ(null, map_->tunnelRemoteAddr(tun0_->remote(), 0));
+  EXPECT_EQ(tun0_, map_->tunnelRemoteAddr(tun0_->remote()));
+  EXPECT_EQ(tun3, map_->tunnelRemoteAddr(tun0_->remote(), 0xFFFFFFFF));
+}
@@ -0,0 +1,367 @@
+/* Bulk TCP transfers through a GRE tunnel. A host on the LAN of the router
+   sends kTransferBytes to a host behind a tunnel whose packets cross a link
+   with an MTU of kLinkMTU bytes; with the 24 bytes of outer IP and GRE
+   headers, the tunnel's MTU is 24 bytes lower. Both hosts advertise an MSS
+   of kHostMSS, so full-sized segments do not fit, and segments carry Don't
+   Fragment.
+
+   The sender is a simple model of a TCP sender. Every transfer opens a
+   connection and starts with a window of kInitialWindow segments, sent
+   every round trip, which doubles while nothing is lost. A loss without an
+   ICMP Fragmentation Needed message is recovered after a retransmission
+   timeout, with the window back at one segment; after kBlackHoleTimeouts
+   timeouts in a row, the sender assumes a path MTU black hole and falls
+   back to segments of kFallbackMSS bytes. An ICMP message lowers the
+   segment size to fit the MTU it reports, and lost segments are sent again
+   on the next round trip; like hosts do, the sender keeps that MTU for the
+   connections that follow.
+
+   Three runs are compared:
+     no ICMP    the sender never learns the path MTU, as when the router
+                dropped oversized Don't Fragment packets silently;
+     PMTUD      the router answers them with ICMP Fragmentation Needed and
+                the tunnel's MTU;
+     MSS clamp  the tunnel also lowers the MSS of SYNs through it, so that
+                segments fit from the start.
+   Handshakes and segments go through the router's data and control planes;
+   time is simulated, kRTTMs per round trip.
+
+   Usage: tunnel_pmtu_benchmark [transfers]  (default: 10) */
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "fwk/log.h"
+
+#include "arp_cache.h"
+#include "control_plane.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "gre_packet.h"
+#include "interface.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "routing_table.h"
+#include "tunnel.h"
+#include "tunnel_map.h"
+
+static const int kDefaultTransfers = 10;
+static const size_t kTransferBytes = 4 << 20;
+static const size_t kLinkMTU = 1500;
+static const uint16_t kHostMSS = 1460;
+static const uint16_t kFallbackMSS = 536;
+static const int kRTTMs = 50;
+static const int kMinRTOMs = 200;
+static const int kBlackHoleTimeouts = 2;
+static const size_t kInitialWindow = 10;
+
+static const IPv4Addr kSender("192.168.1.2");
+static const IPv4Addr kReceiver("10.0.0.2");
+static const IPv4Addr kRemote("192.168.0.2");
+
+/* Hardware address of neighbor IP. */
+static EthernetAddr
+neighbor_mac(const IPv4Addr& ip) {
+  uint8_t addr[EthernetAddr::kAddrLen] = { 0x02, 0x00, 0x00, 0x00, 0x00 };
+  addr[4] = (ip.value() >> 8) & 0xff;
+  addr[5] = ip.value() & 0xff;
+  return EthernetAddr(addr);
+}
+
+/* Frame sent by the router. */
+struct Frame {
+  std::string iface;
+  std::vector<uint8_t> data;
+};
+
+/* Data plane that keeps the frames sent out of it. */
+class CaptureDataPlane : public DataPlane {
+ public:
+  typedef Fwk::Ptr<CaptureDataPlane> Ptr;
+
+  static Ptr New(ARPCache::Ptr cache) { return new CaptureDataPlane(cache); }
+
+  std::deque<Frame>& frames() { return frames_; }
+
+  void outputPacketNew(EthernetPacket::PtrConst pkt,
+                       Interface::PtrConst iface) {
+    Frame frame;
+    frame.iface = iface->name();
+    frame.data.assign(pkt->data(), pkt->data() + pkt->len());
+    frames_.push_back(frame);
+  }
+
+  void outputGatheredNew(const struct iovec* iov, int iovcnt,
+                         Interface::PtrConst iface) {
+    Frame frame;
+    frame.iface = iface->name();
+    for (int i = 0; i < iovcnt; ++i) {
+      const uint8_t* base = (const uint8_t*)iov[i].iov_base;
+      frame.data.insert(frame.data.end(), base, base + iov[i].iov_len);
+    }
+    frames_.push_back(frame);
+  }
+
+ protected:
+  CaptureDataPlane(ARPCache::Ptr cache)
+      : DataPlane("CaptureDataPlane", NULL, cache) { }
+
+ private:
+  std::deque<Frame> frames_;
+};
+
+static Interface::Ptr
+interface_new(const std::string& name, const IPv4Addr& ip,
+              const IPv4Addr& mask) {
+  Interface::Ptr iface = Interface::InterfaceNew(name);
+  iface->ipIs(ip);
+  iface->subnetMaskIs(mask);
+  iface->macIs(neighbor_mac(ip));
+  return iface;
+}
+
+/* Ethernet frame from neighbor SRC_IP to IFACE, with room for an IP packet
+   of LEN bytes; returns the IP packet. */
+static IPPacket::Ptr
+ip_frame(const IPv4Addr& src_ip, Interface::PtrConst iface, size_t len,
+         EthernetPacket::Ptr* eth_pkt) {
+  const size_t frame_len = EthernetPacket::kHeaderSize + len;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(frame_len);
+  memset(buffer->data() + buffer->size() - frame_len, 0, frame_len);
+  *eth_pkt = EthernetPacket::New(buffer, buffer->size() - frame_len);
+  (*eth_pkt)->srcIs(neighbor_mac(src_ip));
+  (*eth_pkt)->dstIs(iface->mac());
+  (*eth_pkt)->typeIs(EthernetPacket::kIP);
+  return IPPacket::New(buffer, buffer->size() - len);
+}
+
+/* Fills in the IP header of PKT. */
+static void
+ip_header(IPPacket::Ptr pkt, IPPacket::IPType protocol,
+          const IPv4Addr& src, const IPv4Addr& dst) {
+  pkt->versionIs(4);
+  pkt->headerLengthIs(IPPacket::kHeaderSize / 4);
+  pkt->packetLengthIs(pkt->len());
+  pkt->diffServicesAre(0);
+  pkt->identificationIs(0);
+  pkt->flagsAre(IPPacket::kIP_DF);
+  pkt->fragmentOffsetIs(0);
+  pkt->ttlIs(64);
+  pkt->protocolIs(protocol);
+  pkt->srcIs(src);
+  pkt->dstIs(dst);
+  pkt->checksumReset();
+}
+
+/* TCP header at TCP: SYN (with an MSS option of MSS) if MSS is not 0. */
+static void
+tcp_header(uint8_t* tcp, uint16_t mss) {
+  tcp[0] = 0x04;
+  tcp[1] = 0xd2;
+  tcp[2] = 0x00;
+  tcp[3] = 0x50;
+  if (mss) {
+    tcp[12] = 0x60;  // 24 bytes
+    tcp[13] = 0x12;  // SYN, ACK
+    tcp[20] = 2;
+    tcp[21] = 4;
+    tcp[22] = mss >> 8;
+    tcp[23] = mss & 0xff;
+  } else {
+    tcp[12] = 0x50;  // 20 bytes
+    tcp[13] = 0x10;  // ACK
+  }
+}
+
+/* Sends a segment from the sender with PAYLOAD bytes of data. Segments the
+   data plane cannot encapsulate are punted to the control plane. */
+static void
+segment_send(DataPlane::Ptr dp, Interface::PtrConst lan, size_t payload) {
+  EthernetPacket::Ptr eth_pkt;
+  IPPacket::Ptr pkt = ip_frame(kSender, lan, 40 + payload, &eth_pkt);
+  tcp_header(pkt->data() + IPPacket::kHeaderSize, 0);
+  ip_header(pkt, IPPacket::kTCP, kSender, kReceiver);
+  dp->packetNew(eth_pkt, lan);
+  dp->puntedPacketsDispatch(1);
+}
+
+/* Sends the SYN-ACK of the receiver, encapsulated by the remote end of the
+   tunnel. */
+static void
+syn_ack_send(DataPlane::Ptr dp, Interface::PtrConst wan) {
+  const size_t inner_len = IPPacket::kHeaderSize + 24;
+  const size_t outer_len = IPPacket::kHeaderSize +
+                           GREPacket::kHeaderSizeWithoutChecksum + inner_len;
+  EthernetPacket::Ptr eth_pkt;
+  IPPacket::Ptr outer = ip_frame(kRemote, wan, outer_len, &eth_pkt);
+  uint8_t* const gre = outer->data() + IPPacket::kHeaderSize;
+  gre[2] = EthernetPacket::kIP >> 8;
+  gre[3] = EthernetPacket::kIP & 0xff;
+
+  const size_t inner_offset =
+      IPPacket::kHeaderSize + GREPacket::kHeaderSizeWithoutChecksum;
+  IPPacket::Ptr inner =
+      IPPacket::New(outer->buffer(), outer->bufferOffset() + inner_offset);
+  tcp_header(inner->data() + IPPacket::kHeaderSize, kHostMSS);
+  ip_header(inner, IPPacket::kTCP, kReceiver, kSender);
+  ip_header(outer, IPPacket::kGRE, kRemote, wan->ip());
+  dp->packetNew(eth_pkt, wan);
+}
+
+/* What the sender learns from a round trip. */
+struct Feedback {
+  Feedback() : delivered(0), delivered_bytes(0), mtu(0), mss(0) { }
+
+  size_t delivered;        // segments through the tunnel
+  size_t delivered_bytes;  // their data
+  size_t mtu;              // from ICMP Fragmentation Needed, or 0
+  uint16_t mss;            // from a SYN-ACK, or 0
+};
+
+static Feedback
+frames_process(std::deque<Frame>& frames) {
+  Feedback feedback;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const uint8_t* const ip = &frames[i].data[EthernetPacket::kHeaderSize];
+    const uint8_t protocol = ip[9];
+    if (frames[i].iface == "eth1" && protocol == IPPacket::kGRE) {
+      const uint8_t* const inner =
+          ip + IPPacket::kHeaderSize + GREPacket::kHeaderSizeWithoutChecksum;
+      const size_t len = (inner[2] << 8) | inner[3];
+      ++feedback.delivered;
+      feedback.delivered_bytes += len - 40;
+    } else if (frames[i].iface == "eth0" && protocol == IPPacket::kICMP) {
+      const uint8_t* const icmp = ip + IPPacket::kHeaderSize;
+      if (icmp[0] == 3 && icmp[1] == 4)
+        feedback.mtu = (icmp[6] << 8) | icmp[7];
+    } else if (frames[i].iface == "eth0" && protocol == IPPacket::kTCP) {
+      const uint8_t* const tcp = ip + IPPacket::kHeaderSize;
+      if ((tcp[13] & 0x02) && tcp[20] == 2)
+        feedback.mss = (tcp[22] << 8) | tcp[23];
+    }
+  }
+  frames.clear();
+  return feedback;
+}
+
+enum Mode {
+  kNoICMP,
+  kPMTUD,
+  kMSSClamp
+};
+
+static void
+benchmark(int transfers, Mode mode) {
+  ControlPlane::Ptr cp = ControlPlane::ControlPlaneNew();
+  CaptureDataPlane::Ptr dp = CaptureDataPlane::New(cp->arpCache());
+  Interface::Ptr lan =
+      interface_new("eth0", "192.168.1.1", "255.255.255.0");
+  Interface::Ptr wan =
+      interface_new("eth1", "192.168.0.1", "255.255.255.0");
+  wan->mtuIs(kLinkMTU);
+  dp->interfaceMap()->interfaceIs(lan);
+  dp->interfaceMap()->interfaceIs(wan);
+  cp->dataPlaneIs(dp);
+  dp->controlPlaneIs(cp.ptr());
+  dp->routingTableIs(cp->routingTable());
+
+  Interface::Ptr tun =
+      interface_new("tun0", "10.255.255.1", "255.255.255.252");
+  tun->typeIs(Interface::kVirtual);
+  dp->interfaceMap()->interfaceIs(tun);
+  Tunnel::Ptr tunnel = Tunnel::New(tun);
+  tunnel->remoteIs(kRemote);
+  tunnel->mssClampIs(mode == kMSSClamp);
+  cp->tunnelMap()->tunnelIs(tunnel);
+
+  RoutingTable::Entry::Ptr entry =
+      RoutingTable::Entry::New(RoutingTable::Entry::kStatic);
+  entry->subnetIs("10.0.0.0", "255.0.0.0");
+  entry->interfaceIs(tun);
+  cp->routingTable()->entryIs(entry);
+
+  const IPv4Addr neighbors[] = { kSender, kRemote };
+  for (size_t i = 0; i < 2; ++i) {
+    ARPCache::Entry::Ptr arp_entry =
+        ARPCache::Entry::New(neighbors[i], neighbor_mac(neighbors[i]));
+    arp_entry->typeIs(ARPCache::Entry::kStatic);
+    cp->arpCache()->entryIs(arp_entry);
+  }
+
+  unsigned long elapsed_ms = 0;
+  unsigned long lost = 0;
+  unsigned long icmp = 0;
+  uint16_t mss = 0;
+  size_t segment = 0;
+  size_t path_mtu = kLinkMTU;
+  for (int transfer = 0; transfer < transfers; ++transfer) {
+    // Handshake: the receiver's MSS, as it reaches the sender.
+    syn_ack_send(dp, wan);
+    mss = std::min(kHostMSS, frames_process(dp->frames()).mss);
+    elapsed_ms += kRTTMs;
+
+    segment = std::min((size_t)mss, path_mtu - 40);
+    size_t window = kInitialWindow;
+    int timeouts = 0;
+    size_t left = kTransferBytes;
+    while (left > 0) {
+      const size_t segments =
+          std::min(window, (left + segment - 1) / segment);
+      for (size_t i = 0; i < segments; ++i)
+        segment_send(dp, lan, std::min(segment, left - i * segment));
+      elapsed_ms += kRTTMs;
+
+      Feedback feedback = frames_process(dp->frames());
+      left -= feedback.delivered_bytes;
+      lost += segments - feedback.delivered;
+      if (mode == kNoICMP)
+        feedback.mtu = 0;
+      else if (feedback.mtu)
+        ++icmp;
+
+      if (feedback.delivered == segments) {
+        window *= 2;
+        timeouts = 0;
+      } else if (feedback.mtu) {
+        path_mtu = feedback.mtu;
+        segment = std::min(segment, path_mtu - 40);
+      } else {
+        // Retransmission timeout, backed off exponentially.
+        elapsed_ms += kMinRTOMs << timeouts;
+        window = 1;
+        if (++timeouts >= kBlackHoleTimeouts)
+          segment = std::min(segment, (size_t)kFallbackMSS);
+      }
+    }
+  }
+
+  const char* const names[] = { "no ICMP", "PMTUD", "MSS clamp" };
+  printf("%-10s  MSS %4u  segment %4zu  %6lu ms/transfer  %7.2f Mbit/s  "
+         "%5lu lost  %4lu ICMP\n",
+         names[mode], mss, segment, elapsed_ms / transfers,
+         8.0 * kTransferBytes * transfers / elapsed_ms / 1e3, lost, icmp);
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  int transfers = (argc > 1) ? atoi(argv[1]) : kDefaultTransfers;
+
+  printf("%d transfers of %zu bytes, link MTU %zu, tunnel MTU %zu, "
+         "RTT %d ms\n",
+         transfers, kTransferBytes, kLinkMTU, kLinkMTU - 24, kRTTMs);
+  benchmark(transfers, kNoICMP);
+  benchmark(transfers, kPMTUD);
+  benchmark(transfers, kMSSClamp);
+
+  return 0;
+}
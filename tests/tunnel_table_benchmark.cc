@@ -0,0 +1,303 @@
+/* Decapsulation with many GRE tunnels. kTunnels tunnels are configured to
+   kRemotes remote endpoints, told apart by their GRE keys (RFC 2890). Every
+   packet decapsulated is matched to its tunnel by the remote and key of its
+   outer headers, so the lookup of a tunnel by endpoint is on the fast path.
+
+   Three things are measured:
+     lookup  tunnels looked up by endpoint, in random order, in the tunnel
+             map's hash table and in a std::map of the same endpoints, as the
+             tunnel map kept them before;
+     decap   UDP datagrams in GRE from the remotes, each in a fresh buffer,
+             through the data plane: decapsulated and forwarded to a host on
+             the LAN. The data plane counts the frames instead of writing
+             them to a device. Run with one tunnel and with all of them;
+     memory  heap bytes allocated per tunnel, for its virtual interface, the
+             tunnel and the entries of both maps, and for each index alone.
+
+   Usage: tunnel_table_benchmark [tunnels] [packets]
+          (default: 10000 tunnels, 1000000 packets) */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "fwk/log.h"
+#include "fwk/scoped_lock.h"
+
+#include "arp_cache.h"
+#include "benchmark_util.h"
+#include "control_plane.h"
+#include "data_plane.h"
+#include "ethernet_packet.h"
+#include "gre_packet.h"
+#include "interface.h"
+#include "interface_map.h"
+#include "ip_packet.h"
+#include "packet_buffer.h"
+#include "routing_table.h"
+#include "tunnel.h"
+#include "tunnel_map.h"
+
+static const int kDefaultTunnels = 10000;
+static const int kDefaultPackets = 1000000;
+static const int kRemotes = 100;
+static const int kLookups = 10000000;
+static const size_t kInnerLen = 64;
+
+static const IPv4Addr kRouter("192.168.0.1");
+static const IPv4Addr kHost("192.168.1.2");
+
+/* Heap bytes allocated with operator new and not yet freed. */
+static size_t heap_bytes = 0;
+
+/* Allocations carry their size in front of them. */
+static const size_t kAllocHeader = 16;
+
+void*
+operator new(size_t size) {
+  size_t* const block = (size_t*)malloc(size + kAllocHeader);
+  if (!block)
+    throw std::bad_alloc();
+  *block = size;
+  heap_bytes += size;
+  return (uint8_t*)block + kAllocHeader;
+}
+
+void
+operator delete(void* ptr) throw() {
+  if (!ptr)
+    return;
+  size_t* const block = (size_t*)((uint8_t*)ptr - kAllocHeader);
+  heap_bytes -= *block;
+  free(block);
+}
+
+static const IPv4Addr kFirstRemote("10.0.0.1");
+
+/* Remote endpoint and key of tunnel I. */
+static IPv4Addr
+remote(int i) {
+  return IPv4Addr(kFirstRemote.value() + i % kRemotes);
+}
+
+static uint32_t
+key(int i) {
+  return i / kRemotes;
+}
+
+static Interface::Ptr
+interface_new(const char* name, const IPv4Addr& ip, const char* mac) {
+  Interface::Ptr iface = Interface::InterfaceNew(name);
+  iface->ipIs(ip);
+  iface->subnetMaskIs("255.255.255.0");
+  iface->macIs(mac);
+  return iface;
+}
+
+/* Adds tunnels [0, TUNNELS) on virtual interfaces. */
+static void
+tunnels_add(DataPlane::Ptr dp, ControlPlane::Ptr cp, int tunnels) {
+  for (int i = 0; i < tunnels; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "tun%d", i);
+    Interface::Ptr iface = Interface::InterfaceNew(name);
+    iface->typeIs(Interface::kVirtual);
+    iface->enabledIs(true);
+    Tunnel::Ptr tunnel = Tunnel::New(iface);
+    tunnel->remoteIs(remote(i));
+    tunnel->keyIs(key(i));
+    dp->interfaceMap()->interfaceIs(iface);
+    cp->tunnelMap()->tunnelIs(tunnel);
+  }
+}
+
+/* Frame from the remote of tunnel I to the router, carrying a UDP datagram
+   of kInnerLen bytes for kHost in GRE with the tunnel's key. */
+static std::vector<uint8_t>
+frame(Interface::PtrConst wan, int i) {
+  const size_t gre_len = GREPacket::kHeaderSizeWithoutChecksum + 4;
+  const size_t outer_len = IPPacket::kHeaderSize + gre_len + kInnerLen;
+  const size_t frame_len = EthernetPacket::kHeaderSize + outer_len;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(frame_len);
+  const size_t offset = buffer->size() - frame_len;
+  memset(buffer->data() + offset, 0, frame_len);
+
+  EthernetPacket::Ptr eth_pkt = EthernetPacket::New(buffer, offset);
+  eth_pkt->srcIs("02:00:00:00:00:02");
+  eth_pkt->dstIs(wan->mac());
+  eth_pkt->typeIs(EthernetPacket::kIP);
+
+  IPPacket::Ptr pkt[2];
+  pkt[0] = IPPacket::New(buffer, offset + EthernetPacket::kHeaderSize);
+  GREPacket::Ptr gre_pkt =
+      GREPacket::GREPacketNew(buffer, pkt[0]->bufferOffset() +
+                                      IPPacket::kHeaderSize);
+  gre_pkt->keyPresentIs(true);
+  gre_pkt->keyIs(key(i));
+  gre_pkt->protocolIs(EthernetPacket::kIP);
+  pkt[1] = IPPacket::New(buffer, gre_pkt->bufferOffset() + gre_len);
+
+  const IPv4Addr src[2] = { remote(i), "172.16.0.2" };
+  const IPv4Addr dst[2] = { kRouter, kHost };
+  const IPPacket::IPType protocol[2] = { IPPacket::kGRE, IPPacket::kUDP };
+  for (int j = 0; j < 2; ++j) {
+    pkt[j]->versionIs(4);
+    pkt[j]->headerLengthIs(IPPacket::kHeaderSize / 4);
+    pkt[j]->packetLengthIs(pkt[j]->len());
+    pkt[j]->diffServicesAre(0);
+    pkt[j]->identificationIs(0);
+    pkt[j]->flagsAre(0);
+    pkt[j]->fragmentOffsetIs(0);
+    pkt[j]->ttlIs(64);
+    pkt[j]->protocolIs(protocol[j]);
+    pkt[j]->srcIs(src[j]);
+    pkt[j]->dstIs(dst[j]);
+    pkt[j]->checksumReset();
+  }
+
+  return std::vector<uint8_t>(eth_pkt->data(), eth_pkt->data() + frame_len);
+}
+
+/* Random order of [0, N). */
+static std::vector<int>
+shuffled(int n) {
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i)
+    order[i] = i;
+  uint32_t x = 2463534242u;
+  for (int i = n - 1; i > 0; --i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    std::swap(order[i], order[x % (i + 1)]);
+  }
+  return order;
+}
+
+typedef std::map<std::pair<IPv4Addr,uint32_t>, Tunnel::Ptr> EndpointMap;
+
+static void
+lookup_benchmark(TunnelMap::Ptr tun_map, int tunnels) {
+  // Index bytes: a std::map of the endpoints, and a new tunnel map less its
+  // name map, measured with a copy of it.
+  size_t before = heap_bytes;
+  EndpointMap endpoints;
+  for (TunnelMap::iterator it = tun_map->begin(); it != tun_map->end(); ++it) {
+    Tunnel::Ptr tunnel = it->second;
+    endpoints[std::make_pair(tunnel->remote(), tunnel->key())] = tunnel;
+  }
+  const size_t map_bytes = heap_bytes - before;
+
+  before = heap_bytes;
+  TunnelMap::Ptr copy = TunnelMap::New();
+  for (TunnelMap::iterator it = tun_map->begin(); it != tun_map->end(); ++it)
+    copy->tunnelIs(it->second);
+  const size_t copy_bytes = heap_bytes - before;
+
+  before = heap_bytes;
+  TunnelMap::NameTunnelMap names(tun_map->begin(), tun_map->end());
+  const size_t hash_bytes = copy_bytes - (heap_bytes - before);
+
+  // Endpoints looked up, in random order.
+  std::vector<int> order = shuffled(tunnels);
+  std::vector<IPv4Addr> remotes;
+  std::vector<uint32_t> keys;
+  for (int n = 0; n < tunnels; ++n) {
+    remotes.push_back(remote(order[n]));
+    keys.push_back(key(order[n]));
+  }
+
+  unsigned long found = 0;
+  double start = now();
+  {
+    Fwk::ScopedLock<TunnelMap> lock(tun_map);
+    for (int n = 0; n < kLookups; ++n) {
+      const int i = n % tunnels;
+      found += (tun_map->tunnelRemoteAddr(remotes[i], keys[i]) != NULL);
+    }
+  }
+  const double hash_ns = (now() - start) / kLookups * 1e9;
+
+  start = now();
+  for (int n = 0; n < kLookups; ++n) {
+    const int i = n % tunnels;
+    found += (endpoints.find(std::make_pair(remotes[i], keys[i])) !=
+              endpoints.end());
+  }
+  const double map_ns = (now() - start) / kLookups * 1e9;
+
+  printf("lookup  %6.1f ns hash table  %6.1f ns std::map  "
+         "(%lu of %d found)\n",
+         hash_ns, map_ns, found, 2 * kLookups);
+  printf("index   %6.0f bytes/tunnel hash table  %6.0f bytes/tunnel "
+         "std::map\n",
+         (double)hash_bytes / tunnels, (double)map_bytes / tunnels);
+}
+
+static void
+benchmark(int tunnels, int packets) {
+  ControlPlane::Ptr cp = ControlPlane::ControlPlaneNew();
+  CountingDataPlane::Ptr dp = CountingDataPlane::New(cp->arpCache());
+  Interface::Ptr wan = interface_new("eth0", kRouter, "02:00:00:00:00:01");
+  Interface::Ptr lan =
+      interface_new("eth1", "192.168.1.1", "02:00:00:00:01:01");
+  dp->interfaceMap()->interfaceIs(wan);
+  dp->interfaceMap()->interfaceIs(lan);
+  cp->dataPlaneIs(dp);
+  dp->controlPlaneIs(cp.ptr());
+  dp->routingTableIs(cp->routingTable());
+
+  ARPCache::Entry::Ptr arp_entry =
+      ARPCache::Entry::New(kHost, "02:00:00:00:01:02");
+  arp_entry->typeIs(ARPCache::Entry::kStatic);
+  cp->arpCache()->entryIs(arp_entry);
+
+  const size_t before = heap_bytes;
+  const double start_add = now();
+  tunnels_add(dp, cp, tunnels);
+  const double add_elapsed = now() - start_add;
+  const size_t tunnel_bytes = heap_bytes - before;
+
+  // Frames from every tunnel, sent in random order.
+  std::vector<std::vector<uint8_t> > frames(tunnels);
+  for (int i = 0; i < tunnels; ++i)
+    frames[i] = frame(wan, i);
+  std::vector<int> order = shuffled(tunnels);
+
+  const double start = now();
+  for (int n = 0; n < packets; ++n) {
+    const std::vector<uint8_t>& data = frames[order[n % tunnels]];
+    PacketBuffer::Ptr buffer = PacketBuffer::New(&data[0], data.size());
+    dp->packetNew(EthernetPacket::New(buffer, buffer->size() - data.size()),
+                  wan);
+  }
+  const double elapsed = now() - start;
+
+  printf("%5d tunnels  decap %6.1f ns/packet  %lu of %d forwarded  "
+         "added in %.3f s  %.0f bytes/tunnel\n",
+         tunnels, elapsed / packets * 1e9, dp->frames(), packets,
+         add_elapsed, (double)tunnel_bytes / tunnels);
+
+  if (tunnels > 1)
+    lookup_benchmark(cp->tunnelMap(), tunnels);
+}
+
+int
+main(int argc, char** argv) {
+  Fwk::Log::Ptr log = Fwk::Log::LogNew();
+  log->levelIs(log->warning());
+
+  const int tunnels = (argc > 1) ? atoi(argv[1]) : kDefaultTunnels;
+  const int packets = (argc > 2) ? atoi(argv[2]) : kDefaultPackets;
+
+  printf("%d packets of %zu bytes in GRE from %d remotes\n",
+         packets, kInnerLen, kRemotes);
+  benchmark(1, packets);
+  benchmark(tunnels, packets);
+
+  return 0;
+}
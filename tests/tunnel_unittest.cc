@@ -1,8 +1,13 @@
 #include "gtest/gtest.h"
 
+#include <cstring>
 #include <string>
+#include "ethernet_packet.h"
+#include "gre_packet.h"
 #include "interface.h"
+#include "ip_packet.h"
 #include "ipv4_addr.h"
+#include "packet_buffer.h"
 #include "tunnel.h"
 
 using std::string;
@@ -39,7 +44,128 @@ TEST_F(TunnelTest, remote) {
 }
 
 
+TEST_F(TunnelTest, key) {
+  // Tunnel is created without a key.
+  EXPECT_FALSE(tunnel_->keyed());
+
+  tunnel_->keyIs(0);
+  EXPECT_TRUE(tunnel_->keyed());
+  EXPECT_EQ((uint32_t)0, tunnel_->key());
+  tunnel_->keyIs(42);
+  EXPECT_EQ((uint32_t)42, tunnel_->key());
+
+  tunnel_->keyDel();
+  EXPECT_FALSE(tunnel_->keyed());
+}
+
+
 TEST_F(TunnelTest, mode) {
   // We only support GRE for now.
   EXPECT_EQ(Tunnel::kGRE, tunnel_->mode());
 }
+
+
+TEST_F(TunnelTest, mtu) {
+  Interface::Ptr phys_iface = Interface::InterfaceNew("eth1");
+  phys_iface->mtuIs(1500);
+  iface_->mtuIs(1500);
+
+  // The outer IP and GRE headers come out of the MTU of the interface the
+  // tunnel is carried over, unless the tunnel's own MTU is lower.
+  EXPECT_EQ((size_t)1476, tunnel_->mtu(phys_iface));
+  iface_->mtuIs(1400);
+  EXPECT_EQ((size_t)1400, tunnel_->mtu(phys_iface));
+
+  // A key takes 4 more bytes.
+  iface_->mtuIs(1500);
+  tunnel_->keyIs(1);
+  EXPECT_EQ((size_t)1472, tunnel_->mtu(phys_iface));
+}
+
+
+TEST_F(TunnelTest, encap) {
+  Interface::Ptr phys_iface = Interface::InterfaceNew("eth1");
+  phys_iface->macIs("00:11:22:33:44:55");
+  phys_iface->ipIs("10.0.0.1");
+  tunnel_->remoteIs("10.0.1.2");
+
+  Tunnel::Encap::PtrConst encap =
+      Tunnel::Encap::New(phys_iface, "10.0.0.254", "66:77:88:99:aa:bb",
+                         "10.0.0.1", tunnel_->remote(), false, 0, 3);
+  tunnel_->encapIs(encap);
+  EXPECT_EQ(encap.ptr(), tunnel_->encap().ptr());
+  EXPECT_EQ((uint32_t)3, encap->generation());
+  EXPECT_EQ(Tunnel::Encap::kMaxHeaderSize - 4, encap->headerSize());
+
+  // Inner packet of 100 bytes.
+  const size_t inner_len = 100;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(inner_len);
+  IPPacket::Ptr inner = IPPacket::New(buffer, buffer->size() - inner_len);
+  for (size_t i = 0; i < inner_len; ++i)
+    inner->data()[i] = i;
+
+  // Identifications with both low and high bytes, so that a checksum fix-up
+  // that drops carries shows.
+  const uint16_t ids[] = { 0, 1, 0x1234, 0xffff };
+  for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+    IPPacket::Ptr pkt = IPPacket::New(buffer, buffer->size() - inner_len);
+    EthernetPacket::Ptr eth_pkt = encap->encapsulated(pkt, ids[i]);
+    ASSERT_EQ(encap->headerSize() + inner_len, eth_pkt->len());
+    EXPECT_EQ(EthernetAddr("00:11:22:33:44:55"), eth_pkt->src());
+    EXPECT_EQ(EthernetAddr("66:77:88:99:aa:bb"), eth_pkt->dst());
+    EXPECT_EQ(EthernetPacket::kIP, eth_pkt->type());
+
+    IPPacket::Ptr outer = IPPacket::Ptr::st_cast<IPPacket>(eth_pkt->payload());
+    EXPECT_TRUE(outer->valid());
+    EXPECT_EQ(IPv4Addr("10.0.0.1"), outer->src());
+    EXPECT_EQ(IPv4Addr("10.0.1.2"), outer->dst());
+    EXPECT_EQ(IPPacket::kGRE, outer->protocol());
+    EXPECT_EQ(ids[i], outer->identification());
+    EXPECT_EQ(IPPacket::kHeaderSize + GREPacket::kHeaderSizeWithoutChecksum +
+              inner_len, (size_t)outer->packetLength());
+
+    GREPacket::Ptr gre =
+        GREPacket::Ptr::st_cast<GREPacket>(outer->payload());
+    EXPECT_FALSE(gre->checksumPresent());
+    EXPECT_EQ(EthernetPacket::kIP, gre->protocol());
+    EXPECT_EQ(0, memcmp(gre->data() + GREPacket::kHeaderSizeWithoutChecksum,
+                        inner->data(), inner_len));
+
+    // Headers of the next iteration are added in front of the same packet.
+    buffer = eth_pkt->buffer();
+  }
+
+  // Headers are rebuilt for a new remote, or a new key.
+  tunnel_->remoteIs("10.0.2.2");
+  EXPECT_FALSE(tunnel_->encap());
+  tunnel_->encapIs(encap);
+  tunnel_->keyIs(7);
+  EXPECT_FALSE(tunnel_->encap());
+}
+
+
+TEST_F(TunnelTest, encapKey) {
+  Interface::Ptr phys_iface = Interface::InterfaceNew("eth1");
+  phys_iface->macIs("00:11:22:33:44:55");
+  Tunnel::Encap::PtrConst encap =
+      Tunnel::Encap::New(phys_iface, "10.0.0.254", "66:77:88:99:aa:bb",
+                         "10.0.0.1", "10.0.1.2", true, 0xDEADBEEF, 0);
+  EXPECT_EQ(Tunnel::Encap::kMaxHeaderSize, encap->headerSize());
+
+  const size_t inner_len = 20;
+  PacketBuffer::Ptr buffer = PacketBuffer::New(inner_len);
+  IPPacket::Ptr pkt = IPPacket::New(buffer, buffer->size() - inner_len);
+  memset(pkt->data(), 0x45, inner_len);
+  EthernetPacket::Ptr eth_pkt = encap->encapsulated(pkt, 1);
+  ASSERT_EQ(Tunnel::Encap::kMaxHeaderSize + inner_len, eth_pkt->len());
+
+  IPPacket::Ptr outer = IPPacket::Ptr::st_cast<IPPacket>(eth_pkt->payload());
+  EXPECT_TRUE(outer->valid());
+  EXPECT_EQ(outer->len(), (size_t)outer->packetLength());
+
+  GREPacket::Ptr gre = GREPacket::Ptr::st_cast<GREPacket>(outer->payload());
+  EXPECT_TRUE(gre->valid());
+  EXPECT_TRUE(gre->keyPresent());
+  EXPECT_EQ((uint32_t)0xDEADBEEF, gre->key());
+  EXPECT_EQ(0x45, gre->payload()->data()[0]);
+}